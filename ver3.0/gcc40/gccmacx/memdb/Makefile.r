@@ -6,6 +6,7 @@ oDir	=	../../obj_gccmacx/release/memdb
 Bin	=	../../output_gccmacx/release
 incDirs	=	-I../../src/os/macos -I../../src/db -I../../src
 srcDirs	=	../../src/memdb
+toolsDirs	=	../../src/tools
 
 LD_FLAGS =	
 LIBS	=	
@@ -15,13 +16,17 @@ SRCS	=\
 	$(srcDirs)/memdb.cpp\
 	$(srcDirs)/memtable.cpp\
 	$(srcDirs)/memindex.cpp\
-	$(srcDirs)/memlookup.cpp
+	$(srcDirs)/memlookup.cpp\
+	$(srcDirs)/memscan.cpp\
+	$(toolsDirs)/mapfile.cpp
 
 EXOBJS	=\
 	$(oDir)/memdb.o\
 	$(oDir)/memtable.o\
 	$(oDir)/memindex.o\
-	$(oDir)/memlookup.o
+	$(oDir)/memlookup.o\
+	$(oDir)/memscan.o\
+	$(oDir)/mapfile.o
 
 ALLOBJS	=	$(EXOBJS)
 ALLBIN	=	$(Bin)/libmemdb.a
@@ -63,3 +68,9 @@ $(oDir)/memindex.o: $(srcDirs)/memindex.cpp
 
 $(oDir)/memlookup.o: $(srcDirs)/memlookup.cpp
 	$(CC) $(C_FLAGS) $(incDirs) -c -o $@ $<
+
+$(oDir)/memscan.o: $(srcDirs)/memscan.cpp
+	$(CC) $(C_FLAGS) $(incDirs) -c -o $@ $<
+
+$(oDir)/mapfile.o: $(toolsDirs)/mapfile.cpp
+	$(CC) $(C_FLAGS) $(incDirs) -c -o $@ $<
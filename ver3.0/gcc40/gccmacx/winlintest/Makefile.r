@@ -9,18 +9,24 @@ incDirs	=	-I../../src/os/macos -I../../src
 srcDirs	=	../../src/winlintest
 
 LD_FLAGS =	
-LIBS	=	-laiogate -laiosock -laiocomport -lthreadpool -laiofile -lcrypt -lxml -lbase -lpthread
+LIBS	=	-laiogate -laiosock -laiocomport -lmemdb -ldb -lthreadpool -laiofile -lcrypt -lxml -lbase -lpthread
 C_FLAGS	=	-O
 
 SRCS	=\
 	$(srcDirs)/main.cpp\
 	$(srcDirs)/socketport_ut.cpp\
-	$(srcDirs)/file_ut.cpp
+	$(srcDirs)/file_ut.cpp\
+	$(srcDirs)/xml_ut.cpp\
+	$(srcDirs)/memdb_ut.cpp\
+	$(srcDirs)/db_ut.cpp
 
 EXOBJS	=\
 	$(oDir)/main.o\
 	$(oDir)/socketport_ut.o\
-	$(oDir)/file_ut.o
+	$(oDir)/file_ut.o\
+	$(oDir)/xml_ut.o\
+	$(oDir)/memdb_ut.o\
+	$(oDir)/db_ut.o
 
 
 ALLOBJS	=	$(EXOBJS)
@@ -59,3 +65,11 @@ $(oDir)/socketport_ut.o: $(srcDirs)/socketport_ut.cpp
 $(oDir)/file_ut.o: $(srcDirs)/file_ut.cpp
 	$(CC) $(C_FLAGS) $(incDirs) -c -o $@ $<
 
+$(oDir)/xml_ut.o: $(srcDirs)/xml_ut.cpp
+	$(CC) $(C_FLAGS) $(incDirs) -c -o $@ $<
+
+$(oDir)/memdb_ut.o: $(srcDirs)/memdb_ut.cpp
+	$(CC) $(C_FLAGS) $(incDirs) -c -o $@ $<
+
+$(oDir)/db_ut.o: $(srcDirs)/db_ut.cpp
+	$(CC) $(C_FLAGS) $(incDirs) -c -o $@ $<
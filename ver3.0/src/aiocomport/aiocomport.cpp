@@ -52,11 +52,60 @@ BEGIN_TERIMBER_NAMESPACE
 const size_t us_timeout = 1000000;
 //! \brief returns working thread back to thread pool after 10 seconds inactivity
 const size_t cp_working_thread_alert = 10000;
+#ifdef USE_EPOLL
+//! \brief max ready events fetched by one epoll_wait call
+const int epoll_max_events = 256;
+//! \brief epoll_wait timeout in milliseconds, event thread checks exit flag
+const int epoll_timeout = 1000;
+#endif
 
 //! \brief creates singleton of completion port
 //! to expose C style functions API
 static aiocomport singleton;
 
+//! \brief sends buffer to TCP socket
+//! gathers all buffers in one sendmsg call if vector is specified
+static 
+int 
+send_gather(int fd, const void* buf, size_t len, const iovec* vec, size_t vec_count)
+{
+	if (!vec)
+		return ::send(fd, (const char*)buf, (int)len, MSG_NOSIGNAL);
+
+	msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = (iovec*)vec;
+	msg.msg_iovlen = vec_count;
+	return (int)::sendmsg(fd, &msg, MSG_NOSIGNAL);
+}
+
+//! \brief receives from UDP socket
+//! drains up to len datagrams by one recvmmsg call if message headers are specified
+static 
+int 
+recv_datagrams(int fd, void* buf, size_t len, sockaddr_in* name, mmsghdr* msgs)
+{
+#ifdef USE_MMSG
+	if (msgs)
+		return ::recvmmsg(fd, msgs, (unsigned int)len, MSG_DONTWAIT, 0);
+#endif
+	socklen_t alen = sizeof(sockaddr_in);
+	return ::recvfrom(fd, (char*)buf, len, 0, (sockaddr*)name, &alen);
+}
+
+//! \brief sends to UDP socket
+//! flushes up to len datagrams by one sendmmsg call if message headers are specified
+static 
+int 
+send_datagrams(int fd, const void* buf, size_t len, const sockaddr_in* name, mmsghdr* msgs)
+{
+#ifdef USE_MMSG
+	if (msgs)
+		return ::sendmmsg(fd, msgs, (unsigned int)len, MSG_NOSIGNAL);
+#endif
+	return ::sendto(fd, (const char*)buf, (int)len, 0, (const sockaddr*)name, sizeof(sockaddr_in));
+}
+
 //! \class handle_desc 
 //! \brief helps to keep the current activity read/write for socket handle
 class handle_desc
@@ -152,6 +201,44 @@ WSASend
 	return singleton.WSASend(sock_fd, buf, len, overlapped);
 }
 
+bool 
+WSASendv
+(
+	HANDLE sock_fd,
+	const struct iovec* vec,
+	size_t count,
+	LPOVERLAPPED overlapped
+)
+{
+	return singleton.WSASendv(sock_fd, vec, count, overlapped);
+}
+
+#ifdef USE_MMSG
+bool 
+WSARecvmFrom
+(
+	HANDLE sock_fd,
+	struct mmsghdr* msgs,
+	size_t count,
+	LPOVERLAPPED overlapped
+)
+{
+	return singleton.WSARecvmFrom(sock_fd, msgs, count, overlapped);
+}
+
+bool 
+WSASendmTo
+(
+	HANDLE sock_fd,
+	struct mmsghdr* msgs,
+	size_t count,
+	LPOVERLAPPED overlapped
+)
+{
+	return singleton.WSASendmTo(sock_fd, msgs, count, overlapped);
+}
+#endif
+
 bool 
 WSASendTo
 (
@@ -231,6 +318,23 @@ SetLog
 	singleton.SetLog(log);
 }
 
+#ifdef USE_EPOLL
+bool
+SetEpoll
+(
+	bool on
+)
+{
+	return singleton.SetEpoll(on);
+}
+#endif
+
+aiocomport&
+GetDefaultCompletionPort()
+{
+	return singleton;
+}
+
 //! \brief logging the internal state information
 void
 DoXRay()
@@ -248,8 +352,14 @@ DoXRay()
 #endif
 
 //! implementation
-aiocomport::aiocomport() : 
+aiocomport::aiocomport(bool files) : 
 _event_thread_id(0)
+#ifdef USE_EPOLL
+, _epoll_fd(-1)
+, _signal_fd(-1)
+, _use_epoll(false)
+, _files(files)
+#endif
 {
 	struct sigaction sa;
 	sa.sa_handler = SIG_DFL;
@@ -277,11 +387,47 @@ _event_thread_id(0)
 #else
 //	sigaction(SIGIO, &sa, 0);	
 #endif
+
+#ifdef USE_EPOLL
+	// creates reactor, sockets will be added on association with completion port
+	_epoll_fd = epoll_create(MAX_SOCKET);
+
+	if (!files)
+	{
+		// socket-only port does not read signals, they belong to the default port
+		_use_epoll = _epoll_fd != -1;
+		return;
+	}
+
+	// file aio completions are still delivered by signal, 
+	// it's blocked above so it can be read from the descriptor
+	sigset_t ss;
+	sigemptyset(&ss);
+	sigaddset(&ss, AIOFILESIGNAL);
+	_signal_fd = signalfd(-1, &ss, SFD_NONBLOCK);
+
+	if (_epoll_fd != -1 && _signal_fd != -1)
+	{
+		epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = _signal_fd;
+		_use_epoll = !epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _signal_fd, &ev);
+	}
+#endif
 }
 
 aiocomport::~aiocomport()
 {
 	_event_thread_id = 0;
+
+#ifdef USE_EPOLL
+	if (_signal_fd != -1)
+		::close(_signal_fd);
+
+	if (_epoll_fd != -1)
+		::close(_epoll_fd);
+#endif
 }
 
 HANDLE 
@@ -372,9 +518,16 @@ aiocomport::CreateIoCompletionPort
 		if (type != TYPE_FILE)
 		{
 #ifndef NO_NPTL 	
-			::fcntl(sock_fd, F_SETFL, oldflags | O_NONBLOCK | O_ASYNC);
-			// set signal
-			::fcntl(sock_fd, F_SETSIG, AIOSOCKSIGNAL);
+#ifdef USE_EPOLL
+			if (_use_epoll) // reactor reports readiness, no signals
+				::fcntl(sock_fd, F_SETFL, oldflags | O_NONBLOCK);
+			else
+#endif
+			{
+				::fcntl(sock_fd, F_SETFL, oldflags | O_NONBLOCK | O_ASYNC);
+				// set signal
+				::fcntl(sock_fd, F_SETSIG, AIOSOCKSIGNAL);
+			}
 #else
 			::fcntl(sock_fd, F_SETFL, oldflags | O_NONBLOCK);
 #endif
@@ -423,6 +576,27 @@ aiocomport::CreateIoCompletionPort
 			errno = -1; // sets error
 			return 0;
 		}
+
+#ifdef USE_EPOLL
+		if (_use_epoll && type != TYPE_FILE)
+		{
+			// registers socket once for both directions, 
+			// pending actions are tried in place first, so edges can not be lost
+			epoll_event ev;
+			memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+			ev.data.fd = sock_fd;
+
+			if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, sock_fd, &ev))
+			{
+				int err = errno;
+				_fd_port_map.erase(it_fd);
+				format_logging(0, __FILE__, __LINE__, en_log_error, "can not add socket %d to epoll, error %d", sock_fd, err);
+				errno = err;
+				return 0;
+			}
+		}
+#endif
 	}
 
 	if (sock_fd == INVALID_SOCKET)
@@ -510,6 +684,52 @@ aiocomport::WSASend
 	return initiate_action(ACTION_SEND, sock_fd, overlapped, buf, len, 0);
 }
 
+bool 
+aiocomport::WSASendv
+(
+	HANDLE sock_fd,
+	const struct iovec* vec,
+	size_t count,
+	LPOVERLAPPED overlapped
+)
+{
+	// calculates total length
+	size_t len = 0;
+	for (size_t index = 0; index < count; ++index)
+		len += vec[index].iov_len;
+
+	// calls common code
+	return initiate_action(ACTION_SEND, sock_fd, overlapped, count ? vec[0].iov_base : 0, len, 0, vec, count);
+}
+
+#ifdef USE_MMSG
+bool 
+aiocomport::WSARecvmFrom
+(
+	HANDLE sock_fd,
+	struct mmsghdr* msgs,
+	size_t count,
+	LPOVERLAPPED overlapped
+)
+{
+	// calls common code, message headers are passed as buffer
+	return initiate_action(ACTION_RECV, sock_fd, overlapped, msgs, count, 0, 0, count, msgs);
+}
+
+bool 
+aiocomport::WSASendmTo
+(
+	HANDLE sock_fd,
+	struct mmsghdr* msgs,
+	size_t count,
+	LPOVERLAPPED overlapped
+)
+{
+	// calls common code, message headers are passed as buffer
+	return initiate_action(ACTION_SEND, sock_fd, overlapped, msgs, count, 0, 0, count, msgs);
+}
+#endif
+
 bool 
 aiocomport::WSASendTo
 (
@@ -538,7 +758,7 @@ aiocomport::WriteFile
 }
 
 bool 
-aiocomport::initiate_action(en_action action, HANDLE sock_id, LPOVERLAPPED overlapped, const void* buf, size_t len, const sockaddr_in* name)
+aiocomport::initiate_action(en_action action, HANDLE sock_id, LPOVERLAPPED overlapped, const void* buf, size_t len, const sockaddr_in* name, const iovec* vec, size_t vec_count, mmsghdr* msgs)
 {
 	// checks overlapped pointer
 	if (!overlapped)
@@ -568,6 +788,9 @@ aiocomport::initiate_action(en_action action, HANDLE sock_id, LPOVERLAPPED overl
 	item._overlapped = overlapped;		// pointer to overlapped structure
 	item.aio_buf = (void*)buf;				// buffer
 	item.aio_nbytes = len;					// buffer length
+	item._vec = vec;						// gather buffers
+	item._vec_count = vec_count;			// number of gather buffers or datagrams
+	item._msgs = msgs;						// datagrams
 	item.aio_offset = overlapped->offset;	// offset for files
 	overlapped->hAccept = (SOCKET)INVALID_SOCKET; // assign invalid value
 	if (name)
@@ -609,7 +832,7 @@ aiocomport::initiate_action(en_action action, HANDLE sock_id, LPOVERLAPPED overl
 			break;
 		case ACTION_RECV:
 			// checks if the name is provided for UDP socket
-			if (it_fd->_type == TYPE_UDP && !name)
+			if (it_fd->_type == TYPE_UDP && !name && !msgs)
 			{
 				it_fd->_initial_container.erase(_queue_allocator, iter);
 				format_logging(0, __FILE__, __LINE__, en_log_error, "peer address for UDP socket %d is required", sock_id);
@@ -618,7 +841,7 @@ aiocomport::initiate_action(en_action action, HANDLE sock_id, LPOVERLAPPED overl
 			}
 
 			// checks buffer pointer
-			if (!buf || !len)
+			if (!buf || !len || (msgs && it_fd->_type != TYPE_UDP))
 			{
 				it_fd->_initial_container.erase(_queue_allocator, iter);
 				format_logging(0, __FILE__, __LINE__, en_log_error, "null or empty buffer for socket %d found", sock_id);
@@ -628,11 +851,11 @@ aiocomport::initiate_action(en_action action, HANDLE sock_id, LPOVERLAPPED overl
 
 			// tries to recv now
 			ret = (it_fd->_type == TYPE_TCP) ?	::recv(item.aio_fildes, (char*)item.aio_buf, item.aio_nbytes, 0) :
-										::recvfrom(item.aio_fildes, (char*)item.aio_buf, item.aio_nbytes, 0, (sockaddr*)&overlapped->remoteAddress, &alen);
+										recv_datagrams(item.aio_fildes, (void*)item.aio_buf, item.aio_nbytes, &overlapped->remoteAddress, item._msgs);
 			break;
 		case ACTION_SEND:
 			// checks if the name is provided for UDP socket
-			if (it_fd->_type == TYPE_UDP && !name)
+			if (it_fd->_type == TYPE_UDP && !name && !msgs)
 			{
 				it_fd->_initial_container.erase(_queue_allocator, iter);
 				format_logging(0, __FILE__, __LINE__, en_log_error, "peer address for UDP socket %d is required", sock_id);
@@ -641,7 +864,7 @@ aiocomport::initiate_action(en_action action, HANDLE sock_id, LPOVERLAPPED overl
 			}
 
 			// checks buffer pointer
-			if (!buf || !len)
+			if (!buf || !len || (vec && it_fd->_type != TYPE_TCP) || (msgs && it_fd->_type != TYPE_UDP))
 			{
 				it_fd->_initial_container.erase(_queue_allocator, iter);
 				format_logging(0, __FILE__, __LINE__, en_log_error, "null or empty buffer for socket %d found", sock_id);
@@ -650,8 +873,8 @@ aiocomport::initiate_action(en_action action, HANDLE sock_id, LPOVERLAPPED overl
 			}
 
 			// tries to send now
-			ret = (it_fd->_type == TYPE_TCP) ?	::send(item.aio_fildes, (const char*)item.aio_buf, (int)item.aio_nbytes, MSG_NOSIGNAL) :
-										::sendto(item.aio_fildes, (const char*)item.aio_buf, (int)item.aio_nbytes, 0, (const sockaddr*)&overlapped->remoteAddress, alen);
+			ret = (it_fd->_type == TYPE_TCP) ?	send_gather(item.aio_fildes, (const void*)item.aio_buf, item.aio_nbytes, item._vec, item._vec_count) :
+										send_datagrams(item.aio_fildes, (const void*)item.aio_buf, item.aio_nbytes, &overlapped->remoteAddress, item._msgs);
 			break;
 		case ACTION_READ:
 			{
@@ -956,6 +1179,10 @@ aiocomport::CloseHandle
 		{
 			if (it_fd->_port_iter.key() == hObject)
 			{
+#ifdef USE_EPOLL
+				if (_use_epoll && it_fd->_type != TYPE_FILE)
+					epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, it_fd.key(), 0);
+#endif
 				// returns all initial items to allocator
 				for (queue_container_t::iterator it_item = it_fd->_initial_container.begin(); it_item != it_fd->_initial_container.end();)
 				{
@@ -1046,6 +1273,10 @@ aiocomport::CancelIo
 	// removes socket
 	if (!overlapped)
 	{
+#ifdef USE_EPOLL
+		if (_use_epoll && it_fd->_type != TYPE_FILE)
+			epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, sock_fd, 0);
+#endif
 		_fd_port_map.erase(it_fd);
 		format_logging(0, __FILE__, __LINE__, en_log_info, "socket %d is removed from completion port", sock_fd);
 	}
@@ -1063,6 +1294,33 @@ aiocomport::SetLog
 	log_on(log);
 }
 
+#ifdef USE_EPOLL
+bool
+aiocomport::SetEpoll
+(
+	bool on
+)
+{
+	// locks mutex
+	mutexKeeper keeper(_port_mtx);
+	// sockets keep the notification they were associated with
+	// socket-only port can not wait for signals, the default port does it
+	if (!_port_attr_map.empty() || !_files || (on && (_epoll_fd == -1 || _signal_fd == -1)))
+		return false;
+
+	_use_epoll = on;
+	return true;
+}
+
+bool
+aiocomport::IsEpoll() const
+{
+	// locks mutex
+	mutexKeeper keeper(_port_mtx);
+	return _use_epoll;
+}
+#endif
+
 void
 aiocomport::DoXRay()
 {
@@ -1190,11 +1448,11 @@ aiocomport::func_sock_signal(int fd, int si_code)
 							break;
 						case ACTION_RECV:
 							{
-								socklen_t alen = sizeof(sockaddr_in), len = it_item->aio_nbytes;
+								size_t len = it_item->aio_nbytes;
 
 								// does real read
 								int ret = (it_fd->_type == TYPE_TCP) ?	::recv(it_item->aio_fildes, (char*)it_item->aio_buf, len, 0) :
-																::recvfrom(it_item->aio_fildes, (char*)it_item->aio_buf, len, 0, (sockaddr*)&it_item->_overlapped->remoteAddress, &alen);
+																recv_datagrams(it_item->aio_fildes, (void*)it_item->aio_buf, len, &it_item->_overlapped->remoteAddress, it_item->_msgs);
 
 								if (ret < 0)
 								{
@@ -1268,8 +1526,8 @@ aiocomport::func_sock_signal(int fd, int si_code)
 						case ACTION_SEND:
 							{
 								// does real read
-								int ret = (it_fd->_type == TYPE_TCP) ?	::send(it_item->aio_fildes, (const char*)it_item->aio_buf, (int)it_item->aio_nbytes, 0) :
-																::sendto(it_item->aio_fildes, (const char*)it_item->aio_buf, (int)it_item->aio_nbytes, 0, (const sockaddr*)&it_item->_overlapped->remoteAddress, sizeof(sockaddr_in));
+								int ret = (it_fd->_type == TYPE_TCP) ?	send_gather(it_item->aio_fildes, (const void*)it_item->aio_buf, it_item->aio_nbytes, it_item->_vec, it_item->_vec_count) :
+																send_datagrams(it_item->aio_fildes, (const void*)it_item->aio_buf, it_item->aio_nbytes, &it_item->_overlapped->remoteAddress, it_item->_msgs);
 
 								if (ret < 0)
 								{
@@ -1443,6 +1701,73 @@ aiocomport::func_file_signal(int fd, void* ptr)
 	}
 }
 
+#ifdef USE_EPOLL
+//! \brief dispatches epoll readiness event for socket
+void 
+aiocomport::func_epoll_event(int fd, unsigned int events)
+{
+	// error first, connect in progress reports EPOLLOUT together with EPOLLERR
+	if (events & EPOLLERR)
+	{
+		func_sock_signal(fd, POLL_ERR);
+		return;
+	}
+
+	if (events & EPOLLIN)
+		func_sock_signal(fd, POLL_IN);
+
+	if (events & EPOLLOUT)
+		func_sock_signal(fd, POLL_OUT);
+
+	// both directions are shut down, read/write above report what is left
+	if (events & EPOLLHUP)
+		func_sock_signal(fd, POLL_HUP);
+}
+
+//! \brief waits for ready sockets and file aio completions until event thread is stopped
+void 
+aiocomport::epoll_loop()
+{
+	epoll_event events[epoll_max_events];
+
+	while (_event_thread_id != 0)
+	{
+		int count = epoll_wait(_epoll_fd, events, epoll_max_events, epoll_timeout);
+		if (count < 0)
+		{
+			if (errno != EINTR)
+			{
+				format_logging(0, __FILE__, __LINE__, en_log_error, "epoll_loop: epoll_wait failed, error %d", errno);
+				return;
+			}
+
+			continue;
+		}
+
+		// only ready descriptors are visited
+		for (int i = 0; i < count; ++i)
+		{
+			int fd = events[i].data.fd;
+
+			if (fd == _signal_fd)
+			{
+				// drains file aio completion signals
+				signalfd_siginfo info;
+				while (::read(_signal_fd, &info, sizeof(info)) == sizeof(info))
+				{
+					// aio signal carries sigval only, descriptor comes from the control block
+					queue_item* qitem = (queue_item*)(size_t)info.ssi_ptr;
+					if (qitem)
+						func_file_signal(qitem->aio_fildes, qitem);
+				}
+			}
+			else
+				func_epoll_event(fd, events[i].events);
+		}
+	}
+}
+#endif
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // until function returns true - follow function will be called immediately
 // once it returns false, it won't be called until next loan_thread call - see below
@@ -1482,41 +1807,53 @@ aiocomport::v_do_job(size_t ident, void* data)
 
 	format_logging(0, __FILE__, __LINE__, en_log_info, "v_do_job: before while event_thread_id = %d", _event_thread_id);
 
+#ifdef USE_EPOLL
+	if (_use_epoll)
+		epoll_loop();
+	else
+#endif
 #ifndef NO_NPTL
-	int signo;
-	siginfo_t info;
+	{
+		int signo;
+		siginfo_t info;
 
-	// set timeout
-	timespec timeouts;
-	timeouts.tv_sec=1;
-	timeouts.tv_nsec=0;
+		// set timeout
+		timespec timeouts;
+		timeouts.tv_sec=1;
+		timeouts.tv_nsec=0;
 
-	// set signal set
-	sigset_t ss;
-	sigemptyset(&ss);
-	sigaddset(&ss, AIOFILESIGNAL);
-	sigaddset(&ss, SIGIO);
-	sigaddset(&ss, AIOSOCKSIGNAL);
+		// set signal set
+		sigset_t ss;
+		sigemptyset(&ss);
+		sigaddset(&ss, AIOFILESIGNAL);
+		sigaddset(&ss, SIGIO);
+		sigaddset(&ss, AIOSOCKSIGNAL);
 
 		
-	while (_event_thread_id != 0)
-	{
-		if ((signo = sigtimedwait(&ss, &info, &timeouts)) > 0)
+		while (_event_thread_id != 0)
 		{
-			if (signo == AIOSOCKSIGNAL)
-				func_sock_signal(info.si_fd, info.si_code);
-			else if (signo == AIOFILESIGNAL)
-				func_file_signal(info.si_fd, info.si_value.sival_ptr);				
-			else if (signo == SIGIO)
+			if ((signo = sigtimedwait(&ss, &info, &timeouts)) > 0)
 			{
-				// we have missed asynchronous socket event, let check if we have a valid socket handle
-				format_logging(0, __FILE__, __LINE__, en_log_info, "v_do_job: RT queue overflow event_thread_id = %d", _event_thread_id);
-
-				if (info.si_fd) // try invoke func_signal
-				{
+				if (signo == AIOSOCKSIGNAL)
 					func_sock_signal(info.si_fd, info.si_code);
+				else if (signo == AIOFILESIGNAL)
+				{
+					// aio signal carries sigval only, si_fd overlaps it
+					queue_item* qitem = static_cast< queue_item* >(info.si_value.sival_ptr);
+					if (qitem)
+						func_file_signal(qitem->aio_fildes, qitem);
 				}
-			}	
+				else if (signo == SIGIO)
+				{
+					// we have missed asynchronous socket event, let check if we have a valid socket handle
+					format_logging(0, __FILE__, __LINE__, en_log_info, "v_do_job: RT queue overflow event_thread_id = %d", _event_thread_id);
+
+					if (info.si_fd) // try invoke func_signal
+					{
+						func_sock_signal(info.si_fd, info.si_code);
+					}
+				}	
+			}
 		}
 	}
 #else
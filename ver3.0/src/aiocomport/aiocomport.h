@@ -50,6 +50,21 @@ typedef int SOCKET;
 #define INVALID_SOCKET ((SOCKET)~0)
 #endif
 
+//! Linux sockets are dispatched by edge-triggered epoll reactor
+//! SetEpoll switches to the real-time signals notification at run time,
+//! define NO_EPOLL to build without epoll
+#if OS_TYPE == OS_LINUX && !defined(NO_NPTL) && !defined(NO_EPOLL)
+#define USE_EPOLL
+#endif
+
+//! Linux UDP sockets move several datagrams by one recvmmsg/sendmmsg call
+//! define NO_MMSG to receive and send datagrams one by one
+#if OS_TYPE == OS_LINUX && !defined(NO_MMSG)
+#define USE_MMSG
+#endif
+
+struct mmsghdr;
+
 
 BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
@@ -133,6 +148,32 @@ WSARecvFrom
 	LPOVERLAPPED overlapped								//!< pointer to overlapped structure
 );
 
+#ifdef USE_MMSG
+//! \brief initiate asynchronous batched receive for UDP sockets
+//! drains up to count datagrams by one call, number of received datagrams is reported as transferred bytes
+//! message headers must stay valid until completion
+bool 
+WSARecvmFrom
+(
+	HANDLE sock_fd,											//!< valid socket handle
+	struct mmsghdr* msgs,									//!< message headers with buffers and address places
+	size_t count,											//!< number of message headers
+	LPOVERLAPPED overlapped									//!< pointer to overlapped structure
+);
+
+//! \brief initiate asynchronous batched send for UDP sockets
+//! number of sent datagrams is reported as transferred bytes
+//! message headers must stay valid until completion
+bool 
+WSASendmTo
+(
+	HANDLE sock_fd,											//!< valid socket handle
+	struct mmsghdr* msgs,									//!< message headers with buffers and peer addresses
+	size_t count,											//!< number of message headers
+	LPOVERLAPPED overlapped									//!< pointer to overlapped structure
+);
+#endif
+
 //! \brief initiate asynchronous recv
 //! name is optional for TCP, but required for UDP sockets
 bool 
@@ -155,6 +196,17 @@ WSASend
 	LPOVERLAPPED overlapped									//!< pointer to overlapped structure
 );
 
+//! \brief initiate asynchronous gather send for TCP sockets
+//! buffers are sent in one system call, the vector must stay valid until completion
+bool 
+WSASendv
+(
+	HANDLE sock_fd,											//!< valid socket handle
+	const struct iovec* vec,								//!< buffers to send bytes from
+	size_t count,											//!< number of buffers
+	LPOVERLAPPED overlapped									//!< pointer to overlapped structure
+);
+
 //! \brief initiate asynchronous send
 //! name is optional for TCP, but required for UDP sockets
 bool 
@@ -225,17 +277,36 @@ SetLog
 	terimber_log* log										//!< pointer to external log object, can be NULL if logging is off
 );
 
+#ifdef USE_EPOLL
+//! \brief selects socket notification of completion ports, epoll reactor or real-time signals
+//! can be called only while there are no completion ports, returns false otherwise
+bool
+SetEpoll
+(
+	bool on													//!< true - epoll reactor, false - real-time signals
+);
+#endif
+
 //! \brief logging the internal state information
 void
 DoXRay
 (
 );
 
+class aiocomport;
+
+//! \brief returns the static instance the C style functions are redirected to
+aiocomport&
+GetDefaultCompletionPort
+(
+);
+
 /////////////////////////////////////////////////////////////////////
 
 //! \class aiocomport
 //! \brief implements completion port functionality on Linux/Unix systems
-//! we we have only one static instance of this class
+//! the static instance serves C style functions and file aio,
+//! in epoll mode socket-only instances can be created, each one has own event thread and mutex
 
 class aiocomport :	public terimber_thread_employer,
 					public terimber_log_helper
@@ -273,6 +344,9 @@ private:
 		size_t			_processed;							//!< byte processed
 		size_t			_key;								//!< completion key
 		LPOVERLAPPED	_overlapped;						//!< pointer to overlapped structure
+		const iovec*	_vec;								//!< gather buffers, if any
+		size_t			_vec_count;							//!< number of gather buffers or datagrams
+		mmsghdr*		_msgs;								//!< datagrams for batched UDP actions, if any
 	};
 
 	//! \typedef queue_allocator_t
@@ -342,7 +416,9 @@ private:
 
 public:
 	//! constructor
-	aiocomport();
+	aiocomport(		bool files = true						//!< takes file aio completions, real-time signals need it too
+															//!< only one such instance can work in the process
+	);
 	//! destructor
 	~aiocomport();
 
@@ -398,6 +474,28 @@ public:
 	);
 
 
+#ifdef USE_MMSG
+	//! \brief initiate asynchronous batched receive for UDP sockets
+	bool 
+	WSARecvmFrom
+	(
+		HANDLE sock_fd,										//!< valid socket handle
+		struct mmsghdr* msgs,								//!< message headers with buffers and address places
+		size_t count,										//!< number of message headers
+		LPOVERLAPPED overlapped								//!< pointer to overlapped structure
+	);
+
+	//! \brief initiate asynchronous batched send for UDP sockets
+	bool 
+	WSASendmTo
+	(
+		HANDLE sock_fd,										//!< valid socket handle
+		struct mmsghdr* msgs,								//!< message headers with buffers and peer addresses
+		size_t count,										//!< number of message headers
+		LPOVERLAPPED overlapped								//!< pointer to overlapped structure
+	);
+#endif
+
 	//! \brief initiate asynchronous recv
 	bool 
 	ReadFile
@@ -419,6 +517,16 @@ public:
 		LPOVERLAPPED overlapped								//!< pointer to overlapped structure
 	);
 
+	//! \brief initiate asynchronous gather send for TCP sockets
+	bool 
+	WSASendv
+	(
+		HANDLE sock_fd,										//!< valid socket handle
+		const struct iovec* vec,							//!< buffers to send bytes from
+		size_t count,										//!< number of buffers
+		LPOVERLAPPED overlapped								//!< pointer to overlapped structure
+	);
+
 	//! \brief initiate asynchronous send
 	//! name is optional for TCP, but required for UDP sockets
 	bool 
@@ -488,6 +596,20 @@ public:
 		terimber_log* log									//!< pointer to external log object, can be NULL if logging is off
 	);
 
+#ifdef USE_EPOLL
+	//! \brief selects socket notification of completion ports, epoll reactor or real-time signals
+	bool
+	SetEpoll
+	(
+		bool on												//!< true - epoll reactor, false - real-time signals
+	);
+	//! \brief checks if sockets are dispatched by epoll reactor
+	bool
+	IsEpoll
+	(
+	) const;
+#endif
+
 	//! \brief logging the internal state information
 	void
 	DoXRay
@@ -503,6 +625,16 @@ public:
 	void 
 	func_file_signal(int fd, void* ptr);
 
+#ifdef USE_EPOLL
+	//! \brief dispatches epoll readiness event for socket
+	void 
+	func_epoll_event(int fd, unsigned int events);
+
+	//! \brief event thread loop of epoll reactor
+	void 
+	epoll_loop();
+#endif
+
 protected:
 	//! \brief until function returns true - follow function will be called immediately
 	//! once it returns false, it won't be called until next loan_thread call - see below
@@ -527,7 +659,10 @@ private:
 						LPOVERLAPPED overlapped,			//!< pointer to overlapped
 						const void* buf,					//!< pointer to buffer, can be null for accept or connect
 						size_t len,							//!< length of buffer, can be null for accept or connect
-						const sockaddr_in* name				//!< pointer to socket address can be null for TCP or accept
+						const sockaddr_in* name,			//!< pointer to socket address can be null for TCP or accept
+						const iovec* vec = 0,				//!< gather buffers for TCP send, if any
+						size_t vec_count = 0,				//!< number of gather buffers or datagrams
+						mmsghdr* msgs = 0					//!< datagrams for batched UDP send/recv, if any
 						);
 private:
 	mutex						_port_mtx;					//!< port mutex
@@ -546,6 +681,12 @@ private:
 #ifdef NO_NPTL
 	event						_ev_wakeup;					//!< wake up event
 #endif	
+#ifdef USE_EPOLL
+	int							_epoll_fd;					//!< epoll reactor descriptor, sockets are registered as edge-triggered
+	int							_signal_fd;					//!< signal descriptor for file aio completion signals
+	bool						_use_epoll;					//!< sockets are dispatched by epoll, otherwise by real-time signals
+	bool						_files;						//!< takes file aio completions and can switch to real-time signals
+#endif
 };
 
 #pragma pack()
@@ -55,7 +55,7 @@ terimber_aiofile_factory::~terimber_aiofile_factory()
 
 //! creates a new aiofile instance
 terimber_aiofile*
-terimber_aiofile_factory::get_aiofile(terimber_log* log, size_t capacity, size_t deactivate_time_msec)
+terimber_aiofile_factory::get_aiofile(terimber_log* log, size_t capacity, size_t deactivate_time_msec, aiofile_engine engine)
 {
 	// creates a new object
 	terimber::aiofile* obj = new terimber::aiofile(capacity, deactivate_time_msec);
@@ -64,7 +64,7 @@ terimber_aiofile_factory::get_aiofile(terimber_log* log, size_t capacity, size_t
 		// sets the logging pointer
 		obj->log_on(log);
 		// activates
-		obj->on();
+		obj->on(engine);
 	}
 
 	return obj;
@@ -87,6 +87,335 @@ const size_t aiofile_completion_io_port_thread_alert = INFINITE;
 const size_t aiofile_working_ident = 3;
 //! \brief returns back to pool in 1 minute
 const size_t aiofile_working_thread_alert = 60000; // working threads
+
+#ifdef USE_IO_URING
+//! \brief io_uring submission ring entries
+const size_t aiofile_uring_entries = 256;
+//! \brief io_uring completion ring entries, keeps many more actions in flight than one batch
+const size_t aiofile_uring_cq_entries = 4096;
+//! \brief io_uring fixed files table size, file idents above table use regular descriptors
+const size_t aiofile_uring_files = 1024;
+//! \brief user data of the cancel entries, completion is ignored
+const __u64 aiofile_uring_cancel_key = 1;
+
+//! \brief reads value written by kernel
+inline 
+unsigned 
+uring_load(const unsigned* p)
+{
+	unsigned v = *(const volatile unsigned*)p;
+	__sync_synchronize();
+	return v;
+}
+
+//! \brief publishes value to kernel
+inline 
+void 
+uring_store(unsigned* p, unsigned v)
+{
+	__sync_synchronize();
+	*(volatile unsigned*)p = v;
+}
+
+//! \brief io_uring_enter system call
+inline 
+int 
+uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+	return (int)::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, (void*)0, (size_t)0);
+}
+
+//! \brief io_uring_register system call
+inline 
+int 
+uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args)
+{
+	return (int)::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+////////////////////////////////////
+aiofile_uring::aiofile_uring() :
+_ring_fd(-1)
+,_sq_ptr(0)
+,_sq_size(0)
+,_cq_ptr(0)
+,_cq_size(0)
+,_sqes(0)
+,_sqes_size(0)
+,_sq_head(0)
+,_sq_tail(0)
+,_sq_mask(0)
+,_sq_array(0)
+,_sq_entries(0)
+,_sqe_tail(0)
+,_cq_head(0)
+,_cq_tail(0)
+,_cq_mask(0)
+,_cqes(0)
+,_files(0)
+,_buffers(0)
+,_buffer_count(0)
+{
+}
+
+aiofile_uring::~aiofile_uring()
+{
+	close();
+}
+
+bool 
+aiofile_uring::open(size_t entries, size_t files)
+{
+	if (_ring_fd != -1)
+		return false;
+
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	// asks for the larger completion ring first
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = (unsigned)aiofile_uring_cq_entries;
+	int fd = (int)::syscall(__NR_io_uring_setup, (unsigned)entries, &params);
+	if (fd < 0 && errno == EINVAL)
+	{
+		// old kernel, default completion ring size
+		memset(&params, 0, sizeof(params));
+		fd = (int)::syscall(__NR_io_uring_setup, (unsigned)entries, &params);
+	}
+
+	if (fd < 0)
+		return false;
+
+	_ring_fd = fd;
+	_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (single_mmap)
+		_sq_size = _cq_size = __max(_sq_size, _cq_size);
+
+	_sq_ptr = ::mmap(0, _sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (_sq_ptr == MAP_FAILED)
+	{
+		_sq_ptr = 0;
+		close();
+		return false;
+	}
+
+	if (single_mmap)
+		_cq_ptr = _sq_ptr;
+	else
+	{
+		_cq_ptr = ::mmap(0, _cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (_cq_ptr == MAP_FAILED)
+		{
+			_cq_ptr = 0;
+			close();
+			return false;
+		}
+	}
+
+	_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes = ::mmap(0, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	_sqes = (io_uring_sqe*)sqes;
+
+	char* sq = (char*)_sq_ptr;
+	_sq_head = (unsigned*)(sq + params.sq_off.head);
+	_sq_tail = (unsigned*)(sq + params.sq_off.tail);
+	_sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+	_sq_array = (unsigned*)(sq + params.sq_off.array);
+	_sq_entries = params.sq_entries;
+	_sqe_tail = *_sq_tail;
+
+	char* cq = (char*)_cq_ptr;
+	_cq_head = (unsigned*)(cq + params.cq_off.head);
+	_cq_tail = (unsigned*)(cq + params.cq_off.tail);
+	_cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+	_cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	if (files)
+	{
+		// registers sparse table, slots are updated when files are opened
+		int* fds = new int[files];
+		if (fds)
+		{
+			for (size_t i = 0; i < files; ++i)
+				fds[i] = -1;
+
+			if (uring_register(_ring_fd, IORING_REGISTER_FILES, fds, (unsigned)files) == 0)
+				_files = files;
+
+			delete [] fds;
+		}
+	}
+
+	return true;
+}
+
+void 
+aiofile_uring::close()
+{
+	if (_sqes)
+		::munmap(_sqes, _sqes_size);
+	if (_cq_ptr && _cq_ptr != _sq_ptr)
+		::munmap(_cq_ptr, _cq_size);
+	if (_sq_ptr)
+		::munmap(_sq_ptr, _sq_size);
+	// closing ring releases registered files and buffers
+	if (_ring_fd != -1)
+		::close(_ring_fd);
+	if (_buffers)
+		delete [] _buffers;
+
+	_ring_fd = -1;
+	_sq_ptr = _cq_ptr = 0;
+	_sq_size = _cq_size = _sqes_size = 0;
+	_sqes = 0;
+	_sq_head = _sq_tail = _sq_mask = _sq_array = 0;
+	_cq_head = _cq_tail = _cq_mask = 0;
+	_cqes = 0;
+	_sq_entries = _sqe_tail = 0;
+	_files = 0;
+	_buffers = 0;
+	_buffer_count = 0;
+}
+
+int 
+aiofile_uring::set_file(size_t slot, int fd)
+{
+	if (slot >= _files)
+		return -1;
+
+	io_uring_files_update update;
+	memset(&update, 0, sizeof(update));
+	update.offset = (__u32)slot;
+	update.fds = (__u64)(size_t)&fd;
+
+	return uring_register(_ring_fd, IORING_REGISTER_FILES_UPDATE, &update, 1) == 1 ? (int)slot : -1;
+}
+
+bool 
+aiofile_uring::register_buffers(void* const* bufs, const size_t* lens, size_t count)
+{
+	if (_ring_fd == -1)
+		return false;
+
+	if (_buffers)
+	{
+		uring_register(_ring_fd, IORING_UNREGISTER_BUFFERS, 0, 0);
+		delete [] _buffers;
+		_buffers = 0;
+		_buffer_count = 0;
+	}
+
+	if (!count)
+		return true;
+
+	iovec* buffers = new iovec[count];
+	if (!buffers)
+		return false;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		buffers[i].iov_base = bufs[i];
+		buffers[i].iov_len = lens[i];
+	}
+
+	// kernel pins pages once, fixed buffer actions skip per action page mapping
+	if (uring_register(_ring_fd, IORING_REGISTER_BUFFERS, buffers, (unsigned)count) != 0)
+	{
+		delete [] buffers;
+		return false;
+	}
+
+	_buffers = buffers;
+	_buffer_count = count;
+	return true;
+}
+
+int 
+aiofile_uring::find_buffer(const void* buf, size_t len) const
+{
+	const char* begin = (const char*)buf;
+	for (size_t i = 0; i < _buffer_count; ++i)
+	{
+		const char* base = (const char*)_buffers[i].iov_base;
+		if (begin >= base && begin + len <= base + _buffers[i].iov_len)
+			return (int)i;
+	}
+
+	return -1;
+}
+
+size_t 
+aiofile_uring::space() const
+{
+	return _ring_fd == -1 ? 0 : _sq_entries - (_sqe_tail - uring_load(_sq_head));
+}
+
+size_t 
+aiofile_uring::pending() const
+{
+	return _ring_fd == -1 ? 0 : _sqe_tail - uring_load(_sq_head);
+}
+
+io_uring_sqe* 
+aiofile_uring::get_sqe()
+{
+	if (!space())
+		return 0;
+
+	unsigned index = _sqe_tail & *_sq_mask;
+	io_uring_sqe* sqe = _sqes + index;
+	memset(sqe, 0, sizeof(io_uring_sqe));
+	_sq_array[index] = index;
+	++_sqe_tail;
+	return sqe;
+}
+
+int 
+aiofile_uring::submit()
+{
+	// publishes all prepared entries
+	uring_store(_sq_tail, _sqe_tail);
+
+	unsigned to_submit = _sqe_tail - uring_load(_sq_head);
+	if (!to_submit)
+		return 0;
+
+	int res;
+	while ((res = uring_enter(_ring_fd, to_submit, 0, 0)) < 0 && errno == EINTR);
+
+	return res < 0 ? -errno : res;
+}
+
+bool 
+aiofile_uring::wait_cqe(__u64& user_data, int& res)
+{
+	while (true)
+	{
+		unsigned head = *_cq_head;
+		if (head != uring_load(_cq_tail))
+		{
+			io_uring_cqe* cqe = _cqes + (head & *_cq_mask);
+			user_data = cqe->user_data;
+			res = cqe->res;
+			// frees entry for kernel
+			uring_store(_cq_head, head + 1);
+			return true;
+		}
+
+		if (uring_enter(_ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+			return false;
+	}
+}
+
+#endif // USE_IO_URING
  
 
 ////////////////////////////////////
@@ -152,6 +481,7 @@ _file_map(less< size_t >(), 64)
 ,_capacity(capacity)
 ,_on(false)
 ,_flag_io_port(false)
+,_engine(AIOFILE_ENGINE_PORT)
 {
 }
 
@@ -162,7 +492,7 @@ aiofile::~aiofile()
 }
 
 bool
-aiofile::on()
+aiofile::on(aiofile_engine engine)
 {
 	if (_on)
 	{
@@ -183,15 +513,28 @@ aiofile::on()
 		return false;
 	}
 
+#ifdef USE_IO_URING
+	if (engine == AIOFILE_ENGINE_URING)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_info, "init io_uring ring");
+		if (_ring.open(aiofile_uring_entries, aiofile_uring_files))
+			_engine = AIOFILE_ENGINE_URING;
+		else
+			format_logging(0, __FILE__, __LINE__, en_log_warning, "io_uring is not available, error %d, falls back to completion port", errno);
+	}
+
+	if (_engine != AIOFILE_ENGINE_URING)
+#endif
+	{
 		format_logging(0, __FILE__, __LINE__, en_log_info, "init completion port");
 #if OS_TYPE == OS_WIN32
 		_aiofile_io_handle = ::CreateIoCompletionPort((HANDLE)INVALID_SOCKET, 0, 0, 0);
 #else
 		_aiofile_io_handle = TERIMBER::CreateIoCompletionPort((HANDLE)INVALID_SOCKET, 0, 0, TYPE_UNKNOWN);
 #endif
+	}
 
-
-	if (!_aiofile_io_handle)
+	if (!_is_port_ready())
 	{
 #if OS_TYPE == OS_WIN32
 		::CloseHandle((HANDLE)_aiofile_io_handle);
@@ -218,7 +561,7 @@ aiofile::on()
 
 	format_logging(0, __FILE__, __LINE__, en_log_info, "aio file port is initialized");
 
-	return _aiofile_io_handle != 0;
+	return true;
 }
 
 
@@ -237,17 +580,45 @@ aiofile::off()
 	_in_thread.stop();
 
 
-	format_logging(0, __FILE__, __LINE__, en_log_info, "send stop message to completion port");
+#ifdef USE_IO_URING
+	if (_engine == AIOFILE_ENGINE_URING)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_info, "send stop message to io_uring ring");
+		mutexKeeper guard(_mtx);
+		io_uring_sqe* sqe = _ring.get_sqe();
+		if (!sqe)
+		{
+			// flushes full ring
+			_ring.submit();
+			sqe = _ring.get_sqe();
+		}
+
+		// zero user data is a signal to leave thread
+		if (sqe)
+			sqe->opcode = IORING_OP_NOP;
+
+		_ring.submit();
+	}
+	else
+#endif
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_info, "send stop message to completion port");
 #if OS_TYPE == OS_WIN32
-	::PostQueuedCompletionStatus((HANDLE)_aiofile_io_handle, 0, 0, 0);
+		::PostQueuedCompletionStatus((HANDLE)_aiofile_io_handle, 0, 0, 0);
 #else
-	TERIMBER::PostQueuedCompletionStatus(_aiofile_io_handle, 0, 0, 0);
+		TERIMBER::PostQueuedCompletionStatus(_aiofile_io_handle, 0, 0, 0);
 #endif
+	}
 
 	_stop_io_port.wait();
 	format_logging(0, __FILE__, __LINE__, en_log_info, "completion port stopped");
 
 
+#ifdef USE_IO_URING
+	if (_engine == AIOFILE_ENGINE_URING)
+		_ring.close();
+	else
+#endif
 #if OS_TYPE == OS_WIN32
 	// if I/O is running send quit message
 	::CloseHandle((HANDLE)_aiofile_io_handle);
@@ -294,8 +665,9 @@ aiofile::off()
 	TERIMBER::SetLog(0);
 #endif
 
-	// resets flag
+	// resets flags
 	_on = false;
+	_engine = AIOFILE_ENGINE_PORT;
 
 	format_logging(0, __FILE__, __LINE__, en_log_info, "aio file port is uninitialized");
 }
@@ -305,7 +677,7 @@ bool
 aiofile::v_has_job(size_t ident, void* data)
 {
 	// Completion port is closed leave return false
-	if (_aiofile_io_handle == 0)
+	if (!_is_port_ready())
 		return false;
 
 	switch (ident)
@@ -321,6 +693,12 @@ aiofile::v_has_job(size_t ident, void* data)
 				if (!_initial_list.empty())
 					return true;
 
+#ifdef USE_IO_URING
+				// entries prepared but not consumed by kernel yet
+				if (_ring.pending())
+					return true;
+#endif
+
 				// finally checks timeouts
 				date now;
 				sb8_t unow = (sb8_t)now;
@@ -360,6 +738,14 @@ aiofile::v_has_job(size_t ident, void* data)
 void 
 aiofile::wait_for_io_completion()
 {
+#ifdef USE_IO_URING
+	if (_engine == AIOFILE_ENGINE_URING)
+	{
+		wait_for_ring_completion();
+		return;
+	}
+#endif
+
 	// notifies main thread about starting this one
 	_start_io_port.set();
 
@@ -446,7 +832,7 @@ aiofile::complete_block(size_t file_key, aiofile_block* ov, int err, size_t proc
 
 	format_logging(0, __FILE__, __LINE__, en_log_info, "completed block not found for file %d, looking in abounded list", file_key); 
 
-#if OS_TYPE == OS_WIN32
+#if OS_TYPE == OS_WIN32 || defined(USE_IO_URING)
 
 	// loop for all abounded blocks - block could be timeouted but still inside Completion Port, 
 	// we can not destroy such a block, so we put it to the abounded blocks queue
@@ -483,6 +869,15 @@ aiofile::v_do_job(size_t ident, void* data)
 				//  locks mutex
 				mutexKeeper guard(_mtx);
 
+#ifdef USE_IO_URING
+				if (_engine == AIOFILE_ENGINE_URING)
+				{
+					// all initial blocks go in one batch
+					_submit_ring(guard);
+					return;
+				}
+#endif
+
 				if (_initial_list.empty())
 					return;
 
@@ -646,7 +1041,7 @@ aiofile::v_do_job(size_t ident, void* data)
 size_t 
 aiofile::open(const char* file_name, bool read_write, terimber_aiofile_callback* callback)
 {
-	if (!_aiofile_io_handle)
+	if (!_is_port_ready())
 	{
 		format_logging(0, __FILE__, __LINE__, en_log_error, "aio file port is not initialized");
 		return 0;
@@ -684,7 +1079,7 @@ aiofile::open(const char* file_name, bool read_write, terimber_aiofile_callback*
 void 
 aiofile::close(size_t handle)
 {
-	if (!_aiofile_io_handle)
+	if (!_is_port_ready())
 	{
 		format_logging(0, __FILE__, __LINE__, en_log_error, "aio file port is not initialized");
 		return;
@@ -716,6 +1111,12 @@ aiofile::close(size_t handle)
 			_delay_key_map.insert(handle, (int)iter->_callback_invoking);
 	}
 
+#ifdef USE_IO_URING
+	// releases fixed files slot, initiated actions keep their own file reference
+	if (iter->_fixed != -1)
+		_ring.set_file(iter->_fixed, -1);
+#endif
+
 	_reverse_map.erase(iter->_handle);
 	_file_map.erase(iter);
 
@@ -828,6 +1229,26 @@ aiofile::read(size_t handle, size_t offset, void* buf, size_t len, size_t timeou
 	return _activate_block(handle, block);
 }
 
+// virtual 
+bool 
+aiofile::register_buffers(void* const* bufs, const size_t* lens, size_t count)
+{
+#ifdef USE_IO_URING
+	mutexKeeper guard(_mtx);
+	if (_engine == AIOFILE_ENGINE_URING)
+		return _ring.register_buffers(bufs, lens, count);
+#endif
+	// completion port maps buffers for each action
+	return false;
+}
+
+// virtual 
+aiofile_engine 
+aiofile::engine() const
+{
+	return _engine;
+}
+
 // makes a snapshot of the internal state
 // virtual 
 void
@@ -840,7 +1261,7 @@ aiofile::doxray()
 		initiated_actions = _initial_list.size(),
 		completed_actions = _outgoing_list.size(),
 		abounded_actions = 
-#if OS_TYPE == OS_WIN32	
+#if OS_TYPE == OS_WIN32	|| defined(USE_IO_URING)
 		_abounded_list.size();
 #else
 		0;
@@ -848,8 +1269,8 @@ aiofile::doxray()
 
 	guard.unlock();
 
-	format_logging(0, __FILE__, __LINE__, en_log_xray, "<aiofile files=\"%d\" delayed=\"%d\" initiated=\"%d\" completed=\"%d\" abounded=\"%d\" />",
-		files, delay_actions, initiated_actions, completed_actions, abounded_actions);
+	format_logging(0, __FILE__, __LINE__, en_log_xray, "<aiofile engine=\"%s\" files=\"%d\" delayed=\"%d\" initiated=\"%d\" completed=\"%d\" abounded=\"%d\" />",
+		_engine == AIOFILE_ENGINE_URING ? "io_uring" : "port", files, delay_actions, initiated_actions, completed_actions, abounded_actions);
 
 #if OS_TYPE != OS_WIN32
 	TERIMBER::DoXRay();
@@ -887,6 +1308,16 @@ aiofile::_assign_file(aio_file_handle handle, terimber_aiofile_callback* callbac
 		return 0;
 	}
 
+#ifdef USE_IO_URING
+	if (_engine == AIOFILE_ENGINE_URING)
+	{
+		// ring needs no association, puts file into fixed files table if possible
+		iter_file->_fixed = _ring.set_file(ident, handle);
+		format_logging(0, __FILE__, __LINE__, en_log_info, "assign file handle %u, ident %u, fixed slot %d is open", handle, ident, iter_file->_fixed);
+		return ident;
+	}
+#endif
+
 #if OS_TYPE == OS_WIN32
 	// associates TCP file with Windows Completion Port
 	if (!::CreateIoCompletionPort((HANDLE)new_file._handle, 
@@ -932,6 +1363,12 @@ aiofile::_cancel_file(aio_file_handle handle)
 {
 	format_logging(0, __FILE__, __LINE__, en_log_info, "actions for file handle %d aborted", handle);
 
+#ifdef USE_IO_URING
+	// ring actions are completed by kernel, abounded blocks are not reused
+	if (_engine == AIOFILE_ENGINE_URING)
+		return;
+#endif
+
 	// clears all tickets
 #if OS_TYPE == OS_WIN32
 	::CancelIo(handle);
@@ -956,7 +1393,7 @@ aiofile::_cancel_aio(		aio_file_handle handle,				//!< file handle
 int 
 aiofile::_process_block(aiofile_block* block)
 {
-	if (!_aiofile_io_handle)
+	if (!_is_port_ready())
 	{
 		format_logging(0, __FILE__, __LINE__, en_log_error, "aiofile is not initialized");
 		return -1;
@@ -978,6 +1415,12 @@ aiofile::_process_block(aiofile_block* block)
 	//  assume that we took the top block for processing
 	// but didn't remove it
 	int res = 0;
+#ifdef USE_IO_URING
+	if (_engine == AIOFILE_ENGINE_URING)
+		// prepares entry only, initiation thread submits batch
+		res = _process_ring(handle, iter_file->_fixed, block);
+	else
+#endif
 	switch (block->_type)
 	{
 		case AIOFILE_WRITE:
@@ -1194,7 +1637,25 @@ aiofile::process_timeouted_blocks()
 				--iter_find->_callback_invoking;
 			}
 
-#if OS_TYPE == OS_WIN32
+#ifdef USE_IO_URING
+			if (_engine == AIOFILE_ENGINE_URING)
+			{
+				// kernel still owns the block, completion will find it in abounded list
+				_abounded_list.push_back(block);
+				if (io_uring_sqe* sqe = _ring.get_sqe())
+				{
+					sqe->opcode = IORING_OP_ASYNC_CANCEL;
+					sqe->addr = (__u64)(size_t)block;
+					sqe->user_data = aiofile_uring_cancel_key;
+					_ring.submit();
+				}
+			}
+			else
+			{
+				_cancel_aio(handle, block);
+				_put_block(block);
+			}
+#elif OS_TYPE == OS_WIN32
 			// puts block to abounded list
 			_abounded_list.push_back(block);
 #else
@@ -1207,5 +1668,113 @@ aiofile::process_timeouted_blocks()
 	} // for file
 }
 
+#ifdef USE_IO_URING
+
+int 
+aiofile::_process_ring(aio_file_handle handle, int fixed, aiofile_block* block)
+{
+	if (block->_type != AIOFILE_READ && block->_type != AIOFILE_WRITE)
+		return EINVAL;
+
+	io_uring_sqe* sqe = _ring.get_sqe();
+	if (!sqe)
+		return EAGAIN;
+
+	bool reading = block->_type == AIOFILE_READ;
+	int buf_index = _ring.find_buffer(block->_buf, block->_len);
+	if (buf_index != -1)
+	{
+		sqe->opcode = reading ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+		sqe->buf_index = (__u16)buf_index;
+	}
+	else
+		sqe->opcode = reading ? IORING_OP_READ : IORING_OP_WRITE;
+
+	if (fixed != -1)
+	{
+		sqe->fd = fixed;
+		sqe->flags |= IOSQE_FIXED_FILE;
+	}
+	else
+		sqe->fd = handle;
+
+	sqe->off = block->offset;
+	sqe->addr = (__u64)(size_t)block->_buf;
+	sqe->len = (__u32)block->_len;
+	sqe->user_data = (__u64)(size_t)block;
+
+	// pending until completion entry is reaped
+	return EWOULDBLOCK;
+}
+
+void 
+aiofile::_submit_ring(mutexKeeper& guard)
+{
+	bool wakeup = false;
+	// prepares entries while submission ring has free space
+	while (!_initial_list.empty() && _ring.space())
+	{
+		aiofile_block* block = _initial_list.front();
+		_initial_list.pop_front();
+
+		if (int err = _process_block(block))
+		{
+			// assigns error, block does NOT initiate asynchronous action
+			block->_err = err;
+			_outgoing_list.push_back(block);
+			wakeup = true;
+		}
+	}
+
+	// one system call for the whole batch
+	int res = _ring.submit();
+	if (res < 0)
+		// entries stay in the ring, initiation thread repeats submission
+		format_logging(0, __FILE__, __LINE__, en_log_error, "io_uring submission failed, error %d", -res);
+
+	guard.unlock();
+
+	// wakes up any working thread from range
+	if (wakeup && (!_capacity || !_thread_pool.borrow_from_range(aiofile_working_ident, aiofile_working_ident + _capacity, 0, this, aiofile_working_thread_alert)))
+		_thread_pool.borrow_thread(aiofile_working_ident, 0, this, aiofile_working_thread_alert);
+}
+
+void 
+aiofile::wait_for_ring_completion()
+{
+	// notifies main thread about starting this one
+	_start_io_port.set();
+
+	while (true) // infinite loop, until zero user data is reaped
+	{
+		__u64 user_data = 0;
+		int res = 0;
+		if (!_ring.wait_cqe(user_data, res))
+		{
+			format_logging(0, __FILE__, __LINE__, en_log_error, "io_uring wait failed, error %d", errno);
+			user_data = 0;
+		}
+
+		if (user_data == aiofile_uring_cancel_key)
+			continue;
+
+		if (!user_data)
+		{
+			// resets flag
+			_flag_io_port = false;
+			// sends signal to main thread that this thread is about to close
+			_stop_io_port.set();
+			// breaks while loop
+			break;
+		}
+
+		// negative result is -errno
+		aiofile_block* ov = (aiofile_block*)(size_t)user_data;
+		complete_block(ov->_file_ident, ov, res < 0 ? -res : 0, res < 0 ? 0 : (size_t)res);
+	} // while
+}
+
+#endif // USE_IO_URING
+
 #pragma pack()
 END_TERIMBER_NAMESPACE
@@ -37,6 +37,12 @@
 #include "aiofile/aiofilefactory.h"
 #include "aiocomport/aiocomport.h"
 
+//! Linux file actions can be submitted via io_uring ring, see aiofile::on
+//! define NO_IO_URING to build without io_uring support
+#if OS_TYPE == OS_LINUX && !defined(NO_IO_URING)
+#define USE_IO_URING
+#endif
+
 BEGIN_TERIMBER_NAMESPACE
 
 #pragma pack(4)
@@ -82,6 +88,99 @@ public:
 //! \brief defines handle type
 typedef HANDLE aio_file_handle;
 
+#ifdef USE_IO_URING
+
+//! \class aiofile_uring
+//! \brief io_uring submission and completion rings
+//! submission side is not thread-safe, caller must serialize it
+//! completion side must be used by one thread only
+class aiofile_uring
+{
+public:
+	//! \brief constructor
+	aiofile_uring();
+	//! \brief destructor
+	~aiofile_uring();
+
+	//! \brief creates ring and registers sparse fixed files table
+	bool 
+	open(			size_t entries,							//!< submission ring entries
+					size_t files							//!< fixed files table size, zero disables fixed files
+					);
+	//! \brief unmaps and closes ring
+	void 
+	close();
+	//! \brief checks if ring is open
+	inline 
+	bool 
+	is_open() const 
+	{ 
+		return _ring_fd != -1; 
+	}
+
+	//! \brief sets file descriptor into fixed files table slot
+	//! returns slot or -1 if file can not be registered
+	int 
+	set_file(		size_t slot,							//!< fixed table slot
+					int fd									//!< file descriptor, -1 clears slot
+					);
+	//! \brief registers buffers, zero count unregisters all buffers
+	bool 
+	register_buffers(void* const* bufs,						//!< array of buffers
+					const size_t* lens,						//!< array of buffer lengths
+					size_t count							//!< number of buffers
+					);
+	//! \brief finds registered buffer containing the range
+	//! returns index or -1 if not found
+	int 
+	find_buffer(	const void* buf,						//!< buffer
+					size_t len								//!< length of buffer
+					) const;
+
+	//! \brief returns free submission entries
+	size_t 
+	space() const;
+	//! \brief returns prepared submission entries not consumed by kernel yet
+	size_t 
+	pending() const;
+	//! \brief gets cleared submission entry, returns zero if ring is full
+	io_uring_sqe* 
+	get_sqe();
+	//! \brief submits all prepared entries in one system call
+	//! returns submitted entries or -errno
+	int 
+	submit();
+	//! \brief waits for the next completion entry
+	bool 
+	wait_cqe(		__u64& user_data,						//!< [out] user data of submission entry
+					int& res								//!< [out] result of action
+					);
+
+private:
+	int								_ring_fd;				//!< ring file descriptor
+	void*							_sq_ptr;				//!< mapped submission ring
+	size_t							_sq_size;				//!< mapped submission ring size
+	void*							_cq_ptr;				//!< mapped completion ring
+	size_t							_cq_size;				//!< mapped completion ring size
+	io_uring_sqe*					_sqes;					//!< mapped submission entries
+	size_t							_sqes_size;				//!< mapped submission entries size
+	unsigned*						_sq_head;				//!< submission head, kernel moves it
+	unsigned*						_sq_tail;				//!< submission tail, we move it
+	unsigned*						_sq_mask;				//!< submission ring mask
+	unsigned*						_sq_array;				//!< submission indexes
+	unsigned						_sq_entries;			//!< submission ring entries
+	unsigned						_sqe_tail;				//!< prepared but not published tail
+	unsigned*						_cq_head;				//!< completion head, we move it
+	unsigned*						_cq_tail;				//!< completion tail, kernel moves it
+	unsigned*						_cq_mask;				//!< completion ring mask
+	io_uring_cqe*					_cqes;					//!< completion entries
+	size_t							_files;					//!< registered fixed files table size
+	iovec*							_buffers;				//!< registered buffers
+	size_t							_buffer_count;			//!< registered buffers count
+};
+
+#endif // USE_IO_URING
+
 //! \class aiofile
 //! \brief  expands windows IO Completion Port idea to Linux
 class aiofile : public terimber_thread_employer, 
@@ -133,11 +232,11 @@ class aiofile : public terimber_thread_employer,
 		aiofile_file(	aio_file_handle handle,				//!< handle
 						terimber_aiofile_callback* callback //!< callback
 
-			) : _handle(handle), _client_obj(callback), _callback_invoking(0) 
+			) : _handle(handle), _client_obj(callback), _callback_invoking(0), _fixed(-1) 
 		{
 		}
 		//! \brief copies constructor
-		aiofile_file(const aiofile_file& x) : _handle(x._handle), _client_obj(x._client_obj), _callback_invoking(x._callback_invoking) {}
+		aiofile_file(const aiofile_file& x) : _handle(x._handle), _client_obj(x._client_obj), _callback_invoking(x._callback_invoking), _fixed(x._fixed) {}
 		//! \brief destructor
 		~aiofile_file()
 		{
@@ -150,6 +249,7 @@ class aiofile : public terimber_thread_employer,
 		terimber_aiofile_callback*	_client_obj;			//!< pointer to the object for callback notofication
 		aiofile_pblock_alloc_list_t	_incoming_list;			//!< keeps incoming asynchronous requests
 		size_t						_callback_invoking;		//!< counter of the callbacks invoking
+		int							_fixed;					//!< io_uring fixed files slot, -1 if not registered
 	};
 
 	//! \typedef aiofile_file_map_t
@@ -183,7 +283,7 @@ class aiofile : public terimber_thread_employer,
 			_outgoing_list.clear();
 		}
 
-#if OS_TYPE == OS_WIN32
+#if OS_TYPE == OS_WIN32 || defined(USE_IO_URING)
 		if (!_abounded_list.empty())
 		{
 			for (aiofile_pblock_list_t::iterator tm_iter = _abounded_list.begin(); tm_iter != _abounded_list.end(); ++tm_iter)
@@ -230,6 +330,18 @@ class aiofile : public terimber_thread_employer,
 		_block_allocator.deallocate(block);
 	}
 
+	//! \brief checks if completion port or io_uring ring is ready
+	inline 
+	bool 
+	_is_port_ready() const
+	{
+#ifdef USE_IO_URING
+		if (_ring.is_open())
+			return true;
+#endif
+		return _aiofile_io_handle != 0;
+	}
+
 
 public:
 	//! \brief constructor
@@ -240,8 +352,10 @@ public:
 	~aiofile();
 
 	//! \brief activates
+	//! AIOFILE_ENGINE_URING falls back to the completion port if io_uring is not available
 	bool 
-	on();
+	on(		aiofile_engine engine = AIOFILE_ENGINE_PORT		//!< preferable completion engine
+			);
 	//! \brief deactivates
 	void 
 	off();
@@ -279,6 +393,19 @@ public:
 			void* userdata						//!< user defined data
 			);	
 
+	//! \brief registers user buffers for fixed buffer actions
+	//! should be called before actions are initiated
+	virtual 
+	bool 
+	register_buffers(void* const* bufs,					//!< array of buffers
+			const size_t* lens,							//!< array of buffer lengths
+			size_t count								//!< number of buffers, zero unregisters all
+			);
+	//! \brief returns active completion engine
+	virtual 
+	aiofile_engine 
+	engine() const;
+
 	//! \brief makes the snapshot of internal state
 	virtual 
 	void 
@@ -376,6 +503,22 @@ private:
 	void 
 	wait_for_io_completion();
 
+#ifdef USE_IO_URING
+	//! \brief prepares io_uring submission entry for block
+	int 
+	_process_ring(	aio_file_handle handle,					//!< file handle
+					int fixed,								//!< fixed files slot or -1
+					aiofile_block* block					//!< block pointer
+					);
+	//! \brief submits initial blocks in one batch
+	void 
+	_submit_ring(	mutexKeeper& guard						//!< locked mutex keeper
+					);
+	//! \brief waits for completion actions in separate thread io_uring ring
+	void 
+	wait_for_ring_completion();
+#endif
+
 public:
 	 
 	mutex							_mtx;					//!< multithreaded access to file map
@@ -388,8 +531,8 @@ public:
 	aiofile_pblock_list_t			_initial_list;			//!< keeps initial processing reuqests
 	aiofile_pblock_list_t			_outgoing_list;			//!< keeps processed asynchronous requests
 
-#if OS_TYPE == OS_WIN32
-	aiofile_pblock_list_t			_abounded_list;			//!< keeps abounded asynchronous requests for Complition Port only
+#if OS_TYPE == OS_WIN32 || defined(USE_IO_URING)
+	aiofile_pblock_list_t			_abounded_list;			//!< keeps abounded asynchronous requests for Complition Port and io_uring only
 #endif
 
 private:
@@ -402,6 +545,10 @@ private:
 	bool							_flag_io_port;			//!< signals that the Terimber Completion Port is running
 	event							_start_io_port;			//!< signals that the thread is waiting for completion actions - Terimber Completion Port
 	event							_stop_io_port;			//!< signals that the thread stopped for completion actions - Terimber Completion Port
+	aiofile_engine					_engine;				//!< active completion engine
+#ifdef USE_IO_URING
+	aiofile_uring					_ring;					//!< io_uring rings
+#endif
 };
 
 
@@ -39,6 +39,14 @@ enum aiofile_type
 	AIOFILE_WRITE											//!< write action
 };
 
+//! \enum aiofile_engine
+//! \brief completion engines
+enum aiofile_engine
+{
+	AIOFILE_ENGINE_PORT = 0,								//!< Windows Completion Port or Terimber Completion Port
+	AIOFILE_ENGINE_URING									//!< Linux io_uring ring, falls back to the completion port if not available
+};
+
 //! \class terimber_file_callback
 //! \brief abstract interface for user of file port
 class terimber_aiofile_callback
@@ -108,6 +116,16 @@ public:
 						void* userdata						//!< user defined data
 						) = 0;	
 
+	//! \brief registers user buffers for fixed buffer actions
+	// read/write of the range inside registered buffer does not map user pages for each action
+	// returns false if the engine does not support registered buffers
+	virtual bool register_buffers(void* const* bufs,		//!< array of buffers
+						const size_t* lens,					//!< array of buffer lengths
+						size_t count						//!< number of buffers, zero unregisters all
+						) = 0;
+	//! \brief returns active completion engine
+	virtual aiofile_engine engine() const = 0;
+
 	//! \brief makes the snapshot of internal state
 	virtual void doxray() = 0;
 };
@@ -127,10 +145,12 @@ public:
 	// capacity means how many threads can be opened and used simultaniously
 	// deactivate_time_msec is the interval in milliseconds (minimum 100 msec) 
 	// after that all unused threads returned to the pool will be closed
+	// engine is a preferable completion engine, the completion port is used if engine is not available
 	terimber_aiofile* 
 	get_aiofile(	terimber_log* log = 0,					//!< pointer to log 
 					size_t capacity = 3,					//!< max additional working threads
-					size_t deactivate_time_msec = 60000		//!< timeout in milliseconds for deactivation of unused threads
+					size_t deactivate_time_msec = 60000,	//!< timeout in milliseconds for deactivation of unused threads
+					aiofile_engine engine = AIOFILE_ENGINE_PORT	//!< preferable completion engine
 					);
 };
 
@@ -177,6 +177,7 @@ aiogate::off()
 	// removes all clients from the pin list
 	for (pin_map_t::iterator iter = _pin_map.begin(); iter != _pin_map.end();)
 	{
+		release_chain(iter->_pin, iter->_shead);
 		iter->_factory->destroy(iter->_pin);
 		iter = _pin_map.erase(iter);
 	}	
@@ -185,12 +186,14 @@ aiogate::off()
 	while (!_pin_list.empty())
 	{
 		pin_info_extra& info = _pin_list.front();
+		release_chain(info._pin, info._shead);
 		info._factory->destroy(info._pin);
 		_pin_list.pop_front();
 	}
 
 	// clears pin allocator
 	_pin_allocator.clear_all();
+	_ref_allocator.clear_all();
 
 	// resets flag
 	_on = false;
@@ -269,19 +272,41 @@ aiogate::v_on_send(size_t handle, void* buf, size_t requested, size_t processed,
 	pin_info& r_info = *it_pin;
 
 	// we always send the top chunk
-	assert(r_info._shead->_ptr + r_info._shead->_begin == buf);
+	assert(r_info._shead->data() + r_info._shead->_begin == buf);
 
-	// adjusts fixed buffer offset
 	// for UDP - just ignore the chunked bytes
-	r_info._shead->_begin += (r_info._tcp_udp ? processed : requested);
+	if (!r_info._tcp_udp)
+	{
+		fixed_size_buffer* head = static_cast< fixed_size_buffer* >(r_info._shead);
+		// the header of the first datagram has been skipped on send
+		size_t sent = ((const udp_header*)(head->_ptr + head->_begin) - 1)->_payload;
+		head->_begin += sent;
+		// skips the next datagrams of batch, batch can be sent partially
+		for (size_t index = 1; index < r_info._send_datagrams && sent < processed; ++index)
+		{
+			const udp_header* uheader = (const udp_header*)(head->_ptr + head->_begin);
+			head->_begin += sizeof(udp_header) + uheader->_payload;
+			sent += uheader->_payload;
+		}
+
+		processed = 0;
+	}
 
-	// checks if we are done with current chunk
-	if (r_info._shead->_begin == r_info._shead->_end)
+	// adjusts chunk offsets, TCP send can gather several chunks
+	while (r_info._shead)
 	{
+		size_t clen = __min(processed, r_info._shead->_end - r_info._shead->_begin);
+		r_info._shead->_begin += clen;
+		processed -= clen;
+
+		// checks if we are done with current chunk
+		if (r_info._shead->_begin != r_info._shead->_end)
+			break;
+
 		// checks the next chunk in a linked list
-		fixed_size_buffer* next = r_info._shead->_next;
+		send_chunk* next = r_info._shead->_next;
 		// return current chunk back to allocator
-		_pin_allocator.deallocate(r_info._shead);
+		release_chunk(r_info._pin, r_info._shead);
 
 		// resets the top chunk
 		if (next)
@@ -293,23 +318,8 @@ aiogate::v_on_send(size_t handle, void* buf, size_t requested, size_t processed,
 	//  checks if we need to send more bytes
 	if (r_info._shead)
 	{
-		sockaddr_in toaddr;
-		size_t requested = 0;
 		// keeps mutex locked and mask is set
-		if (!r_info._tcp_udp) // UDP case - get correct address
-		{
-			udp_header* uheader= (udp_header*)(r_info._shead->_ptr + r_info._shead->_begin); // get UDP header
-			requested = uheader->_payload;
-			toaddr = uheader->_addr;
-			// skip UDP header in the memory page
-			r_info._shead->_begin += sizeof(udp_header);
-		}
-		else
-		{
-			requested = r_info._shead->_end - r_info._shead->_begin;
-		}
-
-		if (_pin_port.send(handle, r_info._shead->_ptr + r_info._shead->_begin, requested, r_info._send_timeout, r_info._tcp_udp ? 0 : &toaddr, (void*)(size_t)aiogate_send_mask))
+		if (start_send(handle, r_info, r_info._send_timeout))
 		{
 			format_logging(0, __FILE__, __LINE__, en_log_error, "can not initiate send for pin %d", handle);
 			
@@ -360,23 +370,8 @@ aiogate::v_on_send(size_t handle, void* buf, size_t requested, size_t processed,
 		{
 			it_pin->_in_progress_mask |= aiogate_send_mask;
 
-			sockaddr_in toaddr = peeraddr;
-			size_t requested = 0;
 			// keeps mutex locked and mask is set
-			if (!r_info._tcp_udp) // UDP case - get correct address
-			{
-				udp_header* uheader= (udp_header*)(r_info._shead->_ptr + r_info._shead->_begin); // get UDP header
-				requested = uheader->_payload;
-				toaddr = uheader->_addr;
-				// skip UDP header in the memory page
-				r_info._shead->_begin += sizeof(udp_header);
-			}
-			else
-			{
-				requested = r_info._shead->_end - r_info._shead->_begin;
-			}
-
-			if (_pin_port.send(handle, it_pin->_shead->_ptr + it_pin->_shead->_begin, requested, it_pin->_send_timeout, &toaddr, (void*)(size_t)aiogate_send_mask))
+			if (start_send(handle, *it_pin, it_pin->_send_timeout))
 			{
 				format_logging(0, __FILE__, __LINE__, en_log_error, "can not initiate send for pin %d", handle);
 	
@@ -455,6 +450,61 @@ aiogate::v_on_receive(size_t handle, void* buf, size_t requested, size_t process
 	format_logging(0, __FILE__, __LINE__, en_log_info, "receive processed pin %d", handle);
 }
 
+// port will call function after successfully receiving batch of datagrams
+// virtual 
+void 
+aiogate::v_on_receive_batch(size_t handle, terimber_aiosock_datagram* grams, size_t count, void* userdata)
+{
+	// locks mutex
+	mutexKeeper keeper(_pin_mtx);
+	// tries to find pin
+	pin_map_t::iterator it_pin = _pin_map.find(handle);
+	if (it_pin == _pin_map.end() // already removed from map
+		|| !it_pin->_still_alive) // already dead
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_warning, "pin %d not found", handle);
+		return;
+	}
+
+	pin_info& r_info = *it_pin;
+
+	// datagrams are always placed in the big recv buffer
+	assert(r_info._rbuf && (void*)r_info._rbuf->_ptr == grams);
+
+	// gets pin
+	terimber_aiogate_pin* pin = r_info._pin;
+
+	// invokes callback sandwich
+	lock_pin(keeper, r_info, aiogate_recv_mask);
+	bool expected_more = false;
+
+	bool recv_continue = true;
+	
+	// delivers datagrams in a burst, receive continues if all callbacks asked for it
+	for (size_t index = 0; index < count; ++index)
+	{
+		try
+		{
+			if (!pin->on_recv((const ub1_t*)grams[index].buf, grams[index].processed, grams[index].address, expected_more))
+				recv_continue = false;
+		}
+		catch (...)
+		{
+			format_logging(0, __FILE__, __LINE__, en_log_error, "on_recv callback exception, handle %d", handle);
+			assert(false);
+		}
+	}
+	
+	bool alive = unlock_pin(keeper, handle, aiogate_recv_mask, true);
+
+	keeper.unlock();
+
+	if (recv_continue && alive)
+		recv(handle, true, 0);
+
+	format_logging(0, __FILE__, __LINE__, en_log_info, "receive batch of %d datagrams processed pin %d", count, handle);
+}
+
 // port will call function after successfully accepting the new incoming connection
 // user can change the callback, by default it's an object which created a listener
 // virtual 
@@ -940,20 +990,22 @@ aiogate::send_bulk(	size_t ident, // unique identificator
 			}
 
 			if (it_pin->_tcp_udp
+				&& !it_pin->_stail->_ref // referenced buffer is never written
 				&& it_pin->_stail->_end < BUFFER_CHUNK // for TCP even one byte of space is good
 				|| !it_pin->_tcp_udp
 				&& (BUFFER_CHUNK - it_pin->_stail->_end) >= (len + sizeof(udp_header)) // for UDP - the whole chunk must fit to the page
 				)
 			{
 				// rooms are available
-				size_t clen = __min(BUFFER_CHUNK - it_pin->_stail->_end, len);
+				fixed_size_buffer* tail = static_cast< fixed_size_buffer* >(it_pin->_stail);
+				size_t clen = __min(BUFFER_CHUNK - tail->_end, len);
 
 				// TCP - copy bytes as it is
 				if (it_pin->_tcp_udp)
 				{
-					memcpy(it_pin->_stail->_ptr + it_pin->_stail->_end, (const ub1_t*)buf + offset, clen);
+					memcpy(tail->_ptr + tail->_end, (const ub1_t*)buf + offset, clen);
 					// adjust buffers
-					it_pin->_stail->_end += clen;
+					tail->_end += clen;
 				}
 				else // UDP
 				{
@@ -961,10 +1013,10 @@ aiogate::send_bulk(	size_t ident, // unique identificator
 					udp_header h;
 					h._addr = *toaddr;
 					h._payload = (ub4_t)len;
-					memcpy(it_pin->_stail->_ptr + it_pin->_stail->_end, &h, sizeof(h));
-					it_pin->_stail->_end += sizeof(h);
-					memcpy(it_pin->_stail->_ptr + it_pin->_stail->_end, (const ub1_t*)buf + offset, clen);
-					it_pin->_stail->_end += clen;
+					memcpy(tail->_ptr + tail->_end, &h, sizeof(h));
+					tail->_end += sizeof(h);
+					memcpy(tail->_ptr + tail->_end, (const ub1_t*)buf + offset, clen);
+					tail->_end += clen;
 				}
 
 				len -= clen;
@@ -994,23 +1046,83 @@ aiogate::send_bulk(	size_t ident, // unique identificator
 	{
 		it_pin->_in_progress_mask |= aiogate_send_mask;
 
-		sockaddr_in peeraddr;
-		size_t requested = 0;
 		// keeps mutex locked and mask is set
-		if (!it_pin->_tcp_udp) // UDP case - get correct address
+		if (start_send(ident, *it_pin, INFINITE))
 		{
-			udp_header* uheader= (udp_header*)(it_pin->_shead->_ptr + it_pin->_shead->_begin); // get UDP header
-			requested = uheader->_payload;
-			peeraddr = uheader->_addr;
-			// skip UDP header in the memory page
-			it_pin->_shead->_begin += sizeof(udp_header);
+			format_logging(0, __FILE__, __LINE__, en_log_error, "can not initiate send for pin %d", ident);
+			it_pin->_in_progress_mask &= ~aiogate_send_mask;
+			return false;
 		}
+	}
+
+	format_logging(0, __FILE__, __LINE__, en_log_paranoid, "send bulk initiated for pin %d", ident);
+	return true;
+}
+
+// virtual 
+bool 
+aiogate::send_ref(	size_t ident, // unique identificator
+					terimber_aiogate_ref_buffer* const* bufs, // buffers to send
+					size_t count // length of bufs
+					)
+{
+	if (!count || !bufs)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "buffer pointer is null or count is zero, ident %d", ident);
+		return false;
+	}
+
+	mutexKeeper keeper(_pin_mtx);
+	pin_map_t::iterator it_pin = _pin_map.find(ident);
+	if (it_pin == _pin_map.end())
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "pin %d not found", ident);
+		return false;
+	}
+
+	if (!it_pin->_tcp_udp) // UDP - datagrams are copied with headers
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "pin %d is UDP connection - referenced buffers are not supported", ident);
+		return false;
+	}
+
+	// - links referenced buffers to the send chain
+	for (size_t index = 0; index < count; ++index)
+	{
+		terimber_aiogate_ref_buffer* ref = bufs[index];
+
+		if (!ref || !ref->data() || !ref->size())
+			continue;
+
+		send_chunk* p = _ref_allocator.allocate();
+
+		if (!p)
+		{
+			format_logging(0, __FILE__, __LINE__, en_log_error, "no enough memory");
+			// not enough memory
+			return false;
+		}
+		else
+			p = new(p) send_chunk(ref);
+
+		// keeps buffer alive until it's sent
+		ref->add_ref();
+
+		if (!it_pin->_stail)
+			it_pin->_shead = it_pin->_stail = p;
 		else
 		{
-			requested = it_pin->_shead->_end - it_pin->_shead->_begin;
+			it_pin->_stail->_next = p;
+			it_pin->_stail = p;
 		}
+	} // for counts
 
-		if (_pin_port.send(ident, it_pin->_shead->_ptr + it_pin->_shead->_begin, requested, INFINITE, it_pin->_tcp_udp ? 0 : &peeraddr, (void*)(size_t)aiogate_send_mask))
+	if (it_pin->_shead && !(it_pin->_in_progress_mask & aiogate_send_mask))
+	{
+		it_pin->_in_progress_mask |= aiogate_send_mask;
+
+		// keeps mutex locked and mask is set
+		if (start_send(ident, *it_pin, INFINITE))
 		{
 			format_logging(0, __FILE__, __LINE__, en_log_error, "can not initiate send for pin %d", ident);
 			it_pin->_in_progress_mask &= ~aiogate_send_mask;
@@ -1018,7 +1130,7 @@ aiogate::send_bulk(	size_t ident, // unique identificator
 		}
 	}
 
-	format_logging(0, __FILE__, __LINE__, en_log_paranoid, "send bulk initiated for pin %d", ident);
+	format_logging(0, __FILE__, __LINE__, en_log_paranoid, "send ref initiated for pin %d", ident);
 	return true;
 }
 
@@ -1048,7 +1160,10 @@ aiogate::recv(	size_t ident,  // unique identificator
 		return true;
 	}
 
-	if (expect_delivery)
+	// batched UDP pin always receives to the big buffer
+	bool batch = !it_pin->_tcp_udp && it_pin->_batch > 1;
+
+	if (expect_delivery || batch)
 	{
 		if (!it_pin->_rbuf)
 		{
@@ -1074,6 +1189,30 @@ aiogate::recv(	size_t ident,  // unique identificator
 	// sets receive flag
 	it_pin->_in_progress_mask |= aiogate_recv_mask;
 
+	if (batch)
+	{
+		// splits the big buffer into datagram descriptors and equal slots
+		terimber_aiosock_datagram* grams = (terimber_aiosock_datagram*)it_pin->_rbuf->_ptr;
+		size_t offset = it_pin->_batch * sizeof(terimber_aiosock_datagram);
+		size_t slot = ((BUFFER_CHUNK - offset) / it_pin->_batch) & ~(size_t)7;
+		for (size_t index = 0; index < it_pin->_batch; ++index)
+		{
+			grams[index].buf = it_pin->_rbuf->_ptr + offset + index * slot;
+			grams[index].len = slot;
+			grams[index].processed = 0;
+		}
+
+		if (_pin_port.receive_batch(ident, grams, it_pin->_batch, it_pin->_recv_timeout, (void*)(size_t)aiogate_recv_mask))
+		{
+			format_logging(0, __FILE__, __LINE__, en_log_error, "can not initiate receive for pin %d", ident);
+			it_pin->_in_progress_mask &= ~aiogate_recv_mask;
+			return false;
+		}
+
+		format_logging(0, __FILE__, __LINE__, en_log_paranoid, "batched receive initiated for pin %d", ident);
+		return true;
+	}
+
 	// invokes socket port function
 	if (_pin_port.receive(ident, expect_delivery ? (void*)it_pin->_rbuf->_ptr : &it_pin->_leader, expect_delivery ? BUFFER_CHUNK : sizeof(it_pin->_leader), it_pin->_recv_timeout, fromaddr, (void*)(size_t)aiogate_recv_mask))
 	{
@@ -1124,6 +1263,32 @@ aiogate::set_recv_timeout(size_t ident,
 	return true;
 }
 
+// sets max datagrams per system call for UDP pin
+// virtual 
+bool 
+aiogate::set_udp_batch(size_t ident,
+					size_t datagrams
+					)
+{
+	mutexKeeper keeper(_pin_mtx);
+	pin_map_t::iterator it = _pin_map.find(ident);
+	if (it == _pin_map.end())
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "pin %d not found", ident);
+		return false;
+	}
+
+	if (it->_tcp_udp || datagrams > aiosock_max_vectors)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "pin %d is not UDP connection or batch %d is too big", ident, datagrams);
+		return false;
+	}
+
+	// takes effect with the next receive/send
+	it->_batch = datagrams;
+	return true;
+}
+
 // closes connection pin
 // virtual 
 bool 
@@ -1224,12 +1389,7 @@ aiogate::final_close(pin_info_extra& info)
 		_pin_allocator.deallocate(info._rbuf);
 
 	// releases all send buffers if any
-	while (info._shead)
-	{
-		fixed_size_buffer* buf = info._shead;
-		info._shead = info._shead->_next;
-		_pin_allocator.deallocate(buf);
-	}
+	release_chain(info._pin, info._shead);
 
 	keeper.unlock();
 
@@ -1237,6 +1397,81 @@ aiogate::final_close(pin_info_extra& info)
 	info._factory->destroy(info._pin);
 }
 
+int 
+aiogate::start_send(size_t ident, pin_info& info, size_t timeout)
+{
+	if (!info._tcp_udp) // UDP case - get correct address
+	{
+		fixed_size_buffer* head = static_cast< fixed_size_buffer* >(info._shead);
+		// batched pin flushes several datagrams of the head chunk by one call
+		terimber_aiosock_datagram grams[aiosock_max_vectors];
+		size_t count = 0;
+		for (size_t pos = head->_begin; pos < head->_end && count < __max(info._batch, (size_t)1); ++count)
+		{
+			const udp_header* uheader = (const udp_header*)(head->_ptr + pos); // get UDP header
+			grams[count].buf = head->_ptr + pos + sizeof(udp_header);
+			grams[count].len = uheader->_payload;
+			grams[count].address = uheader->_addr;
+			pos += sizeof(udp_header) + uheader->_payload;
+		}
+
+		// skip UDP header of the first datagram in the memory page
+		head->_begin += sizeof(udp_header);
+		info._send_datagrams = count;
+		return count == 1 ? 
+			_pin_port.send(ident, grams[0].buf, grams[0].len, timeout, &grams[0].address, (void*)(size_t)aiogate_send_mask) :
+			_pin_port.send_batch(ident, grams, count, timeout, (void*)(size_t)aiogate_send_mask);
+	}
+
+	// TCP case - gathers consecutive chunks, both copied and referenced
+	terimber_aiosock_buffer vec[aiosock_max_vectors];
+	size_t count = 0;
+	for (send_chunk* chunk = info._shead; chunk && count < aiosock_max_vectors; chunk = chunk->_next, ++count)
+	{
+		vec[count].buf = chunk->data() + chunk->_begin;
+		vec[count].len = chunk->_end - chunk->_begin;
+	}
+
+	return count == 1 ? 
+		_pin_port.send(ident, vec[0].buf, vec[0].len, timeout, 0, (void*)(size_t)aiogate_send_mask) :
+		_pin_port.send_vector(ident, vec, count, timeout, (void*)(size_t)aiogate_send_mask);
+}
+
+void 
+aiogate::release_chunk(terimber_aiogate_pin* pin, send_chunk* chunk)
+{
+	if (!chunk->_ref)
+	{
+		_pin_allocator.deallocate(static_cast< fixed_size_buffer* >(chunk));
+		return;
+	}
+
+	terimber_aiogate_ref_buffer* ref = chunk->_ref;
+	_ref_allocator.deallocate(chunk);
+
+	// gives the buffer back to the pin
+	try
+	{
+		pin->on_release(ref);
+	}
+	catch (...)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "on_release callback exception");
+		assert(false);
+	}
+}
+
+void 
+aiogate::release_chain(terimber_aiogate_pin* pin, send_chunk*& head)
+{
+	while (head)
+	{
+		send_chunk* chunk = head;
+		head = head->_next;
+		release_chunk(pin, chunk);
+	}
+}
+
 //! \brief makes the snapshot of internal state
 //virtual 
 void 
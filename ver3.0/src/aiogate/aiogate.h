@@ -41,26 +41,54 @@ BEGIN_TERIMBER_NAMESPACE
 //! \brief this is a default memory chunk
 enum aiogate_chunk { BUFFER_CHUNK = 1024*64 };
 
-//! \class fixed_size_buffer
-//! \brief high performance chunks linked list
-class fixed_size_buffer
+//! \class send_chunk
+//! \brief link of the send chain, 
+//! keeps either bytes copied to fixed_size_buffer or caller owned referenced buffer
+class send_chunk
 {
 public:
 	//! \brief constructor
-	fixed_size_buffer() : 
+	send_chunk(terimber_aiogate_ref_buffer* ref = 0) : 
 		_begin(0), 
-		_end(0), 
-		_next(0) 
+		_end(ref ? ref->size() : 0), 
+		_next(0),
+		_ref(ref)
 	{
 	}
 
-	ub1_t				_ptr[BUFFER_CHUNK];					//!< points to the chunk of BUFFER_CHUNK length
+	//! \brief returns pointer to the chunk bytes
+	inline 
+	ub1_t* 
+	data();
+
 	size_t				_begin;								//!< begining bytes offset
 	size_t				_end;								//!< ending bytes offset
 
-	fixed_size_buffer*	_next;								//!< next chunk in a chain 
+	send_chunk*			_next;								//!< next chunk in a chain 
+	terimber_aiogate_ref_buffer* _ref;						//!< referenced buffer, null for copied bytes
 };
 
+//! \class fixed_size_buffer
+//! \brief high performance chunks linked list
+class fixed_size_buffer : public send_chunk
+{
+public:
+	//! \brief constructor
+	fixed_size_buffer() : 
+		send_chunk() 
+	{
+	}
+
+	ub1_t				_ptr[BUFFER_CHUNK];					//!< points to the chunk of BUFFER_CHUNK length
+};
+
+inline 
+ub1_t* 
+send_chunk::data()
+{
+	return _ref ? (ub1_t*)_ref->data() : static_cast< fixed_size_buffer* >(this)->_ptr;
+}
+
 //! class aiogate
 //! \brief abstraction for callback
 class aiogate :	public terimber_aiogate,					//!< star gate abstract class interface
@@ -114,7 +142,7 @@ class aiogate :	public terimber_aiogate,					//!< star gate abstract class inter
 
 		terimber_aiogate_pin*			_pin;				//!< pointer to pin object
 		fixed_size_buffer*				_rbuf;				//!< pointer to the head of linked list of buffers for receiving 
-		fixed_size_buffer*				_shead;				//!< pointer to the head of linked loist of buffers for sending
+		send_chunk*						_shead;				//!< pointer to the head of linked loist of buffers for sending
 		terimber_aiogate_pin_factory*	_factory;			//!< pointer to factory, which knows how to create pin
 	};
 	
@@ -131,6 +159,8 @@ class aiogate :	public terimber_aiogate,					//!< star gate abstract class inter
 			_recv_timeout(INFINITE),
 			_in_progress_mask(0x0), 
 			_callback_invoking_mask(0x0), 
+			_batch(0),
+			_send_datagrams(0),
 			_still_alive(true),
 			_tcp_udp(true)
 		{}
@@ -143,17 +173,21 @@ class aiogate :	public terimber_aiogate,					//!< star gate abstract class inter
 			_recv_timeout(x._recv_timeout),
 			_in_progress_mask(x._in_progress_mask), 
 			_callback_invoking_mask(x._callback_invoking_mask), 
+			_batch(x._batch),
+			_send_datagrams(x._send_datagrams),
 			_still_alive(x._still_alive),
 			_tcp_udp(x._tcp_udp)
 		{
 		}
 
 		ub8_t					_leader;					//!< a small buffer for waiting for incoming bytes, optimization for huge number of pins
-		fixed_size_buffer*		_stail;						//!< pointer to the tail of linked list of buffers for sending
+		send_chunk*				_stail;						//!< pointer to the tail of linked list of buffers for sending
 		size_t					_send_timeout;				//!< sends timeout
 		size_t					_recv_timeout;				//!< receives timeout
 		ub4_t					_in_progress_mask;			//!< bit mask for currently activities
 		ub4_t					_callback_invoking_mask;	//!< bit mask for invoked callbacks
+		size_t					_batch;						//!< max datagrams per system call for UDP pin
+		size_t					_send_datagrams;			//!< datagrams of UDP send in progress
 		bool					_still_alive;				//!< flag if pin is still alive
 		bool					_tcp_udp;					//!< tpc or udp oriented pin
 	};
@@ -208,6 +242,9 @@ class aiogate :	public terimber_aiogate,					//!< star gate abstract class inter
 	//! \typedef chunk_allocator_t
 	//! \brief node allocator for linked list buffers
 	typedef node_allocator< fixed_size_buffer >	chunk_allocator_t;
+	//! \typedef ref_allocator_t
+	//! \brief node allocator for referenced buffers links
+	typedef node_allocator< send_chunk >		ref_allocator_t;
 	//! \typedef close_list_t
 	//! \brief lists pins prepeared for destruction
 	typedef list< pin_info_extra >				close_list_t;
@@ -257,6 +294,14 @@ public:
 				const sockaddr_in& toaddr,					//!< peer address
 				void* userdata								//!< user defined data
 				);
+	//! \brief port will call function after successfully receiving batch of datagrams
+	virtual 
+	void 
+	v_on_receive_batch(size_t handle,						//!< socket ident
+				terimber_aiosock_datagram* grams,			//!< received datagrams
+				size_t count,								//!< received datagrams count
+				void* userdata								//!< user defined data
+				);
 	//! \brief port will call function after successfully accepting the new incoming connection
 	//! user can change the callback, by default it's an object which created a listener
 	virtual 
@@ -331,6 +376,14 @@ public:
 				const sockaddr_in* toaddr					//!< peer address, optional - only for UDP
 				);
 
+	//! \brief sends referenced buffers asynchronously without copying
+	virtual 
+	bool 
+	send_ref(	size_t ident,								//!< unique pin identificator
+				terimber_aiogate_ref_buffer* const* bufs,	//!< buffers to send
+				size_t count								//!< length of bufs
+				);
+
 	//! \brief initiates receive process, 
 	//! either use big buffer or just a small one 
 	//! in order to save the memory usage for a unknown waiting time 
@@ -360,6 +413,13 @@ public:
 				size_t timeout								//!< timeout in milliseconds
 				); 
 
+	//! \brief sets max datagrams per system call for UDP pin
+	virtual 
+	bool 
+	set_udp_batch(size_t ident,								//!< unique pin identificator
+				size_t datagrams							//!< max datagrams per system call
+				);
+
 	//! \brief makes the snapshot of internal state
 	virtual 
 	void 
@@ -409,6 +469,23 @@ private:
 				size_t mask,								//!< reason why pin is about to close
 				bool invoke_callback						//!< flag should user callback be invoked upon pin closure
 				);
+	//! \brief initiates sending of the head of send chain
+	//! UDP sends one datagram or batch of datagrams, TCP gathers consecutive chunks in one call
+	int 
+	start_send(	size_t ident,								//!< pin ident
+				pin_info& info,								//!< pin info reference
+				size_t timeout								//!< timeout in milliseconds
+				);
+	//! \brief returns chunk back to allocator, referenced buffer goes back to pin
+	void 
+	release_chunk(terimber_aiogate_pin* pin,				//!< pin pointer
+				send_chunk* chunk							//!< chunk
+				);
+	//! \brief releases the whole send chain
+	void 
+	release_chain(terimber_aiogate_pin* pin,				//!< pin pointer
+				send_chunk*& head							//!< head of chain
+				);
 	//! \brief actual pin closure in a separate thread
 	void 
 	final_close(pin_info_extra& info						//!< pin info
@@ -420,6 +497,7 @@ private:
 	pin_map_t				_pin_map;						//!< pin map
 	aiosock					_pin_port;						//!< aiosock port
 	chunk_allocator_t		_pin_allocator;					//!< memory chunks allocator
+	ref_allocator_t			_ref_allocator;					//!< referenced buffers links allocator
 	close_list_t			_pin_list;						//!< list of pins prepared for final closure
 	thread					_pin_thread;					//!< housekeeping thread
 }; 
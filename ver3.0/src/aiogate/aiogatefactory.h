@@ -59,6 +59,34 @@ public:
 	size_t			len;									//!< buffer length
 };
 
+//! \class terimber_aiogate_ref_buffer
+//! \brief reference counted buffer owned by caller
+//! aiogate sends the bytes without copying, keeps one reference per send_ref call 
+//! and gives it back through terimber_aiogate_pin::on_release
+class terimber_aiogate_ref_buffer
+{
+public:
+	//! \brief destructor
+	virtual ~terimber_aiogate_ref_buffer() {}
+
+	//! \brief returns pointer to the bytes
+	virtual 
+	const void* 
+	data() const = 0;
+	//! \brief returns number of bytes
+	virtual 
+	size_t 
+	size() const = 0;
+	//! \brief adds reference
+	virtual 
+	void 
+	add_ref() = 0;
+	//! \brief releases reference
+	virtual 
+	void 
+	release() = 0;
+};
+
 //! \class terimber_aiogate_pin
 //! \brief class abstraction for pin object
 //! user has to implement the code
@@ -111,6 +139,16 @@ public:
 	on_send(	const sockaddr_in& peeraddr					//!< peer address
 				) = 0;
 	
+	//! \brief aiogate invokes this callback when the referenced buffer has been sent 
+	//! or dropped because of pin closure, the aiogate lock is held, so function must not block
+	virtual 
+	void 
+	on_release(	terimber_aiogate_ref_buffer* buf			//!< buffer passed to send_ref
+				)
+	{
+		buf->release();
+	}
+
 	//! \brief aiogate invokes this function when pin connection is deactivate
 	// only internal action can be taken - no aiogate calls anymore for this pin
 	virtual 
@@ -205,7 +243,7 @@ public:
 
 	//! \brief sends buf bytes asynchronously
 	//! caller does NOT need to keep a valid pointer to the buffer until the asynchronous operation is be completed
-	//! aiogate will make a copy of sending bytes.
+	//! aiogate will make a copy of sending bytes, see send_ref for zero-copy sending.
 	virtual 
 	bool 
 	send(		size_t ident,								//!< unique pin identificator
@@ -223,6 +261,18 @@ public:
 				const sockaddr_in* toaddr					//!< peer address, optional for UDP only
 				) = 0;
 
+	//! \brief sends referenced buffers asynchronously without copying, TCP only
+	//! aiogate adds reference to each buffer, keeps the bytes in the original order with 
+	//! other sends and gathers consecutive buffers in one system call
+	//! each buffer is given back by terimber_aiogate_pin::on_release
+	//! for payloads below a few kilobytes copying by send/send_bulk is cheaper
+	virtual 
+	bool 
+	send_ref(	size_t ident,								//!< unique pin identificator
+				terimber_aiogate_ref_buffer* const* bufs,	//!< buffers to send
+				size_t count								//!< length of bufs
+				) = 0;
+
 	//! \brief initiates receive process, 
 	//! either use the big buffer or just a small one
 	//! in order to save the memory usage for a unknown waiting time 
@@ -251,6 +301,15 @@ public:
 				size_t timeout								//!< timeout in milliseconds
 				) = 0;
 
+	//! \brief sets max datagrams received or sent by one system call for UDP pin, 0 or 1 turns batching off
+	//! received datagrams are delivered to on_recv in a burst, 
+	//! batched receive splits the receive buffer, so datagram is limited by 64KB / datagrams
+	virtual 
+	bool 
+	set_udp_batch(size_t ident,								//!< unique pin identificator
+				size_t datagrams							//!< max datagrams per system call, up to 16
+				) = 0;
+
 	//! \brief makes the snapshot of internal state
 	virtual 
 	void 
@@ -37,6 +37,187 @@
 BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
+//! \brief compares and swaps value, returns true if value was replaced
+inline 
+bool 
+msg_queue_cas(volatile ub4_t* p, ub4_t expected, ub4_t desired)
+{
+#if OS_TYPE == OS_WIN32
+	return (ub4_t)::InterlockedCompareExchange((LONG volatile*)p, (LONG)desired, (LONG)expected) == expected;
+#else
+	return __sync_bool_compare_and_swap(p, expected, desired);
+#endif
+}
+
+//! \brief full memory barrier
+inline 
+void 
+msg_queue_fence()
+{
+#if OS_TYPE == OS_WIN32
+	::MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+//! \brief atomically adds value, returns new value
+inline 
+ub4_t 
+msg_queue_add(volatile ub4_t* p, ub4_t v)
+{
+#if OS_TYPE == OS_WIN32
+	return (ub4_t)::InterlockedExchangeAdd((LONG volatile*)p, (LONG)v) + v;
+#else
+	return __sync_add_and_fetch(p, v);
+#endif
+}
+
+//! \brief gives up the rest of time slice
+inline 
+void 
+msg_queue_yield()
+{
+#if OS_TYPE == OS_WIN32
+	::Sleep(0);
+#else
+	sched_yield();
+#endif
+}
+
+//! \class msg_ring
+//! \brief bounded lock-free multi-producer multi-consumer ring of messages
+//! every cell keeps a sequence number, producers and consumers claim cells by moving tail and head
+//! no memory allocation on push
+//! 32 bits counters keep natural alignment inside the packed classes, the differences are wrap around safe
+template < size_t C >
+class msg_ring
+{
+	//! \brief capacity must be a power of two
+	typedef char capacity_is_power_of_two[(C & (C - 1)) == 0 ? 1 : -1];
+	//! \class msg_ring_cell
+	//! \brief ring cell
+	class msg_ring_cell
+	{
+	public:
+		volatile ub4_t		_sequence;						//!< cell sequence
+		msg_cpp*			_item;							//!< message pointer
+	};
+	//! \enum en_msg_ring
+	enum en_msg_ring
+	{
+		MASK = C - 1,										//!< position mask
+		PADDING = 64										//!< separates head and tail cache lines
+	};
+	//! \brief private copy constructor
+	msg_ring(const msg_ring& x);
+	//! \brief private assign operator
+	msg_ring& operator=(const msg_ring& x);
+public:
+	//! \brief constructor
+	msg_ring();
+	//! \brief adds message, returns false if ring is full
+	inline 
+	bool 
+	push(			msg_cpp* item							//!< input message
+					);
+	//! \brief removes message, returns false if ring is empty
+	inline 
+	bool 
+	pop(			msg_cpp*& item							//!< [out] pointer to message
+					);
+	//! \brief checks if there is a message in the ring
+	inline 
+	bool 
+	empty() const;
+private:
+	volatile ub4_t			_head;							//!< consumers position
+	uint8_t					_head_padding[PADDING];			//!< padding
+	volatile ub4_t			_tail;							//!< producers position
+	uint8_t					_tail_padding[PADDING];			//!< padding
+	msg_ring_cell			_cells[C];						//!< cells
+};
+
+template < size_t C >
+msg_ring< C >::msg_ring() :
+	_head(0), _tail(0)
+{
+	for (size_t index = 0; index < C; ++index)
+	{
+		_cells[index]._sequence = (ub4_t)index;
+		_cells[index]._item = 0;
+	}
+}
+
+template < size_t C >
+inline 
+bool
+msg_ring< C >::push(msg_cpp* item)
+{
+	ub4_t pos = _tail;
+	msg_ring_cell* cell;
+	for (;;)
+	{
+		cell = &_cells[pos & MASK];
+		sb4_t diff = (sb4_t)(cell->_sequence - pos);
+		if (!diff) // cell is free
+		{
+			if (msg_queue_cas(&_tail, pos, pos + 1))
+				break;
+			pos = _tail;
+		}
+		else if (diff < 0) // consumers have not released the cell yet
+			return false;
+		else // other producer took the cell
+			pos = _tail;
+	}
+
+	cell->_item = item;
+	// publishes item before sequence
+	msg_queue_fence();
+	cell->_sequence = pos + 1;
+	return true;
+}
+
+template < size_t C >
+inline 
+bool
+msg_ring< C >::pop(msg_cpp*& item)
+{
+	ub4_t pos = _head;
+	msg_ring_cell* cell;
+	for (;;)
+	{
+		cell = &_cells[pos & MASK];
+		sb4_t diff = (sb4_t)(cell->_sequence - (pos + 1));
+		if (!diff) // cell is filled
+		{
+			if (msg_queue_cas(&_head, pos, pos + 1))
+				break;
+			pos = _head;
+		}
+		else if (diff < 0) // ring is empty
+			return false;
+		else // other consumer took the cell
+			pos = _head;
+	}
+
+	item = cell->_item;
+	// reads item before releasing the cell to producers
+	msg_queue_fence();
+	cell->_sequence = pos + (ub4_t)C;
+	return true;
+}
+
+template < size_t C >
+inline 
+bool
+msg_ring< C >::empty() const
+{
+	ub4_t pos = _head;
+	return _cells[pos & MASK]._sequence != pos + 1;
+}
+
 //! \class msg_queue
 //! \brief priority message queue
 template < size_t P = 3, size_t C = 1024 >
@@ -221,13 +402,204 @@ msg_queue< P, C >::is_block()
 	return _blocked; 
 } 
 
+//! \class msg_ring_queue
+//! \brief priority message queue without mutex, the same interface as msg_queue has
+//! every priority level has own lock-free ring,
+//! rings keep all P * C cells in place, about 37KB for the default sizes on 64 bits,
+//! producers do not serialize on one mutex when many threads push to one queue
+template < size_t P = 3, size_t C = 1024 >
+class msg_ring_queue
+{
+	//! \enum en_msg_ring_queue
+	enum en_msg_ring_queue
+	{ 
+		PRIORITY = P,										//!< priority levels 
+		CAPACITY = C										//!< max capacity, power of two
+	};
+public:
+	//! \brief blocks queue
+	//! waits for pushes in progress, so no message comes after block returns
+	inline 
+	bool 
+	block();
+	//! \brief checks the blocking state
+	inline 
+	bool 
+	is_block();
+protected:
+	//! \brief constructor
+	msg_ring_queue();
+	//! \brief removes message from queue
+	inline 
+	bool 
+	pop(			msg_cpp*& item							//!< [out] pointer to message
+					);
+	//! \brief checks if there is a message in a queue
+	inline 
+	bool 
+	peek();
+	//! \brief checks the top priority message in a queue
+	inline 
+	bool 
+	touch(			size_t& top_priority					//!< [out] the top priority message in a queue
+					);
+	//! \brief we don't know how to wake up yet
+	virtual 
+	void 
+	wakeup() = 0;
+	//! \brief pushes incoming message to the queue
+	inline 
+	void 
+	push(			msg_cpp* item							//!< input message
+					);
+	//! \brief unblocks queue
+	inline 
+	bool 
+	unblock();
+
+private:
+	//! \brief returns the priority within the range
+	static 
+	inline 
+	ub1_t 
+	_check(			msg_cpp* item							//!< pointer to message
+					);
+private:
+	volatile ub4_t			_blocked;						//!< block flag
+	volatile ub4_t			_pushing;						//!< count of pushes in progress
+	msg_ring< C >			_queue[PRIORITY];				//!< priority queues
+};
+
+template < size_t P, size_t C >
+msg_ring_queue< P, C >::msg_ring_queue() : 
+	_blocked(0), _pushing(0)
+{
+} 
+// static
+template < size_t P, size_t C >
+inline 
+ub1_t
+msg_ring_queue< P, C >::_check(msg_cpp* item)
+{ 
+	return item->priority >= PRIORITY ? PRIORITY - 1 : (ub1_t)item->priority; 
+} 
+
+template < size_t P, size_t C >
+inline 
+void
+msg_ring_queue< P, C >::push(msg_cpp* item)
+{
+	// announces push, block waits for it
+	msg_queue_add(&_pushing, 1);
+	if (_blocked) // queue blocked 
+	{
+		msg_queue_add(&_pushing, (ub4_t)-1);
+		exception::_throw("Queue has been blocked");
+	}
+
+	// adds item to the correspondent queue
+	if (!_queue[_check(item)].push(item)) // out of space
+	{
+		msg_queue_add(&_pushing, (ub4_t)-1);
+		exception::_throw("Queue max capacity has been reached");
+	}
+
+	msg_queue_add(&_pushing, (ub4_t)-1);
+	// wakes up thread
+	wakeup();
+} 
+
+template < size_t P, size_t C >
+inline 
+bool
+msg_ring_queue< P, C >::pop(msg_cpp*& item)
+{
+	// loop for all queues
+	for (ub1_t index = 0; index < PRIORITY; ++index)
+	{
+		if (_queue[index].pop(item))
+			return true;
+	}
+	return false;
+} 
+
+template < size_t P, size_t C >
+inline 
+bool
+msg_ring_queue< P, C >::peek()
+{
+	// loop for all queues
+	for (ub1_t index = 0; index < PRIORITY; ++index)
+	{
+		if (!_queue[index].empty()) 
+			return true;
+	}
+	return false;
+} 
+
+template < size_t P, size_t C >
+inline 
+bool
+msg_ring_queue< P, C >::touch(size_t& top_priority)
+{
+	// loop for all queues
+	for (ub1_t index = 0; index < PRIORITY; ++index)
+	{
+		if (!_queue[index].empty()) 
+		{ 
+			top_priority = index; 
+			return true; 
+		}
+	}
+	return false;
+}
+
+template < size_t P, size_t C >
+inline 
+bool
+msg_ring_queue< P, C >::block()
+{ 
+	if (!msg_queue_cas(&_blocked, 0, 1))
+		return false;
+
+	// waits for pushes which did not see the block flag
+	while (_pushing)
+		msg_queue_yield();
+
+	return true;
+} 
+
+template < size_t P, size_t C >
+inline 
+bool 
+msg_ring_queue< P, C >::unblock()
+{ 
+	return msg_queue_cas(&_blocked, 1, 0);
+}
+
+template < size_t P, size_t C >
+inline 
+bool
+msg_ring_queue< P, C >::is_block()
+{ 
+	return _blocked != 0; 
+} 
+
+//! messages of connections and communicator go through the lock-free rings,
+//! define USE_MSG_MUTEX to use the mutex queue, it saves the ring cells memory
+#ifdef USE_MSG_MUTEX
+typedef msg_queue< 3 > msg_processor_queue_t;
+#else
+typedef msg_ring_queue< 3 > msg_processor_queue_t;
+#endif
+
 // forwards declaration
 class msg_communicator;
 //! \class msg_queue_processor
 //! \brief class inherits thread processor class
 // and msg_queue class
 class msg_queue_processor : public msg_base, 
-							public msg_queue< 3 >, 
+							public msg_processor_queue_t, 
 							public terimber_thread_employer
 {
 public:
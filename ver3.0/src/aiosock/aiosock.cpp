@@ -55,10 +55,25 @@ terimber_aiosock_factory::~terimber_aiosock_factory()
 
 //! creates a new aiosock instance
 terimber_aiosock*
-terimber_aiosock_factory::get_aiosock(terimber_log* log, size_t capacity, size_t deactivate_time_msec)
+terimber_aiosock_factory::get_aiosock(terimber_log* log, size_t capacity, size_t deactivate_time_msec, size_t shards, bool work_stealing)
 {
+	if (shards > 1)
+	{
+		// creates independent shards
+		terimber::aiosock_sharded* sharded = new terimber::aiosock_sharded(shards, capacity, deactivate_time_msec, work_stealing);
+		if (sharded)
+		{
+			// sets the logging pointer
+			sharded->log_on(log);
+			// activates
+			sharded->on();
+		}
+
+		return sharded;
+	}
+
 	// creates a new object
-	terimber::aiosock* obj = new terimber::aiosock(capacity, deactivate_time_msec);
+	terimber::aiosock* obj = new terimber::aiosock(capacity, deactivate_time_msec, 0, 0, 1, work_stealing);
 	if (obj)
 	{
 		// sets the logging pointer
@@ -275,6 +290,119 @@ aiosock_block::settimeout(size_t timeout)
 	}
 }
 
+////////////////////////////////////
+aiosock_timer_heap::aiosock_timer_heap() :
+_armed(0)
+,_fired(0)
+,_heap(0)
+,_count(0)
+,_capacity(0)
+{
+}
+
+aiosock_timer_heap::~aiosock_timer_heap()
+{
+	clear();
+}
+
+void 
+aiosock_timer_heap::arm(aiosock_block* block)
+{
+	// infinite timeout or already armed
+	if (!block->_expired || block->_timer_index)
+		return;
+
+	if (_count == _capacity)
+	{
+		// grows twice
+		size_t capacity = _capacity ? _capacity * 2 : 64;
+		aiosock_block** heap = new aiosock_block*[capacity];
+		if (!heap)
+			return;
+
+		if (_count)
+			memcpy(heap, _heap, _count * sizeof(aiosock_block*));
+
+		delete [] _heap;
+		_heap = heap;
+		_capacity = capacity;
+	}
+
+	place(_count, block);
+	sift_up(_count++);
+	++_armed;
+}
+
+void 
+aiosock_timer_heap::disarm(aiosock_block* block)
+{
+	if (!block->_timer_index)
+		return;
+
+	size_t index = block->_timer_index - 1;
+	block->_timer_index = 0;
+
+	// moves the last block to the released position
+	if (index != --_count)
+	{
+		place(index, _heap[_count]);
+		sift_up(index);
+		sift_down(_heap[index]->_timer_index - 1);
+	}
+}
+
+void 
+aiosock_timer_heap::clear()
+{
+	for (size_t index = 0; index < _count; ++index)
+		_heap[index]->_timer_index = 0;
+
+	delete [] _heap;
+	_heap = 0;
+	_count = _capacity = 0;
+}
+
+void 
+aiosock_timer_heap::sift_up(size_t index)
+{
+	aiosock_block* block = _heap[index];
+	while (index)
+	{
+		size_t parent = (index - 1) / 2;
+		if (_heap[parent]->_expired <= block->_expired)
+			break;
+
+		place(index, _heap[parent]);
+		index = parent;
+	}
+
+	place(index, block);
+}
+
+void 
+aiosock_timer_heap::sift_down(size_t index)
+{
+	aiosock_block* block = _heap[index];
+	while (true)
+	{
+		size_t child = 2 * index + 1;
+		if (child >= _count)
+			break;
+
+		// selects the earliest child
+		if (child + 1 < _count && _heap[child + 1]->_expired < _heap[child]->_expired)
+			++child;
+
+		if (block->_expired <= _heap[child]->_expired)
+			break;
+
+		place(index, _heap[child]);
+		index = child;
+	}
+
+	place(index, block);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 //static
 bool
@@ -298,23 +426,32 @@ aiosock::resolve_sock_error_code(int err, char* buf, size_t len)
 }
 
 
-aiosock::aiosock(size_t capacity, size_t deactivate_time_msec) : 
+aiosock::aiosock(size_t capacity, size_t deactivate_time_msec, aiosock* const* group, size_t shard, size_t shards, bool work_stealing) : 
 _socket_map(less< size_t >(), 64)
 ,_reverse_map(less< aio_sock_handle >(), 64)
 ,_socket_generator(64)
 ,_outgoing_list(64)
 ,_aiosock_io_handle(0)
+#if OS_TYPE != OS_WIN32
+,_port(0)
+#endif
 ,_thread_pool(capacity + 3, deactivate_time_msec) // 3 + (xp, completion, working) + additional working threads
+,_executor(work_stealing ? new executor(capacity + 3) : 0) // the same number of workers
 ,_capacity(capacity)
 ,_on(false)
 ,_flag_io_port(false)
+,_group(shards > 1 ? group : 0)
+,_shard(shards > 1 ? shard : 0)
+,_shards(shards > 1 ? shards : 1)
 {
+	_threads = _executor ? (terimber_threadpool*)_executor : (terimber_threadpool*)&_thread_pool;
 }
 
 aiosock::~aiosock()
 {
 	// just in case
 	off();
+	delete _executor;
 }
 
 bool
@@ -335,13 +472,30 @@ aiosock::on()
 	}
 
 #if OS_TYPE != OS_WIN32
-	TERIMBER::SetLog(this);
+	// each aiosock, a shard too, dispatches its sockets by own reactor, event thread and port mutex
+	// real-time signals are waited for by the default port only
+	_port = &GetDefaultCompletionPort();
+#ifdef USE_EPOLL
+	if (_port->IsEpoll())
+	{
+		aiocomport* port = new aiocomport(false);
+		if (port->IsEpoll())
+			_port = port;
+		else
+			delete port;
+	}
+#endif
+	_port->SetLog(this);
 #endif
-	_thread_pool.log_on(this);
+	_threads->log_on(this);
 
-	if (!_thread_pool.on())
+	if (_executor ? !_executor->on() : !_thread_pool.on())
 	{
 		format_logging(0, __FILE__, __LINE__, en_log_error, "can not start thread pool");
+		_threads->log_on(0);
+#if OS_TYPE != OS_WIN32
+		_close_port();
+#endif
 		return false;
 	}
 
@@ -349,7 +503,7 @@ aiosock::on()
 #if OS_TYPE == OS_WIN32
 		_aiosock_io_handle = ::CreateIoCompletionPort((HANDLE)INVALID_SOCKET, 0, 0, 0);
 #else
-		_aiosock_io_handle = TERIMBER::CreateIoCompletionPort((HANDLE)INVALID_SOCKET, 0, 0, TYPE_UNKNOWN);
+		_aiosock_io_handle = _port->CreateIoCompletionPort((HANDLE)INVALID_SOCKET, 0, 0, TYPE_UNKNOWN);
 #endif
 
 
@@ -358,18 +512,18 @@ aiosock::on()
 #if OS_TYPE == OS_WIN32
 		::CloseHandle((HANDLE)_aiosock_io_handle);
 #else
-		TERIMBER::CloseHandle(_aiosock_io_handle);
+		_close_port();
 #endif
 		format_logging(0, __FILE__, __LINE__, en_log_info, "can not initiate completion port");
 		return false;
 	}
 
 	_flag_io_port = true;
-	_thread_pool.borrow_thread(aiosock_completion_io_port_ident, 0, this, aiosock_completion_io_port_thread_alert);
+	_threads->borrow_thread(aiosock_completion_io_port_ident, 0, this, aiosock_completion_io_port_thread_alert);
 	_start_io_port.wait();
 
 	// starts working thread
-	_thread_pool.borrow_thread(aiosock_working_ident, 0, this, aiosock_working_thread_alert);
+	_threads->borrow_thread(aiosock_working_ident, 0, this, aiosock_working_thread_alert);
 
 	// starts ininitial thread
 	_in_thread.start();
@@ -403,7 +557,7 @@ aiosock::off()
 #if OS_TYPE == OS_WIN32
 	::PostQueuedCompletionStatus((HANDLE)_aiosock_io_handle, 0, 0, 0);
 #else
-	TERIMBER::PostQueuedCompletionStatus(_aiosock_io_handle, 0, 0, 0);
+	_port->PostQueuedCompletionStatus(_aiosock_io_handle, 0, 0, 0);
 #endif
 
 	_stop_io_port.wait();
@@ -414,16 +568,19 @@ aiosock::off()
 	// if I/O is running send quit message
 	::CloseHandle((HANDLE)_aiosock_io_handle);
 #else
-	TERIMBER::CloseHandle(_aiosock_io_handle);
+	_port->CloseHandle(_aiosock_io_handle);
 #endif
 
 
 	_aiosock_io_handle = 0;
 
 	format_logging(0, __FILE__, __LINE__, en_log_info, "Stoping thread pool");
-	_thread_pool.revoke_client(this);
-	_thread_pool.off();
-	_thread_pool.log_on(0);
+	_threads->revoke_client(this);
+	if (_executor)
+		_executor->off();
+	else
+		_thread_pool.off();
+	_threads->log_on(0);
 
 	format_logging(0, __FILE__, __LINE__, en_log_info, "Close all sockets");
 
@@ -445,6 +602,9 @@ aiosock::off()
 	_listeners_map.clear();
 	_delay_key_map.clear();
 
+	// disarms all timers
+	_timers.clear();
+
 	// clears outgoing, timeouted, and initial blocks
 	_clear_block_lists();
 
@@ -452,9 +612,9 @@ aiosock::off()
 	_incoming_list_allocator.clear_extra();
 	_block_allocator.clear_extra();
 
-	// turns off logging for Terimber Completion port
+	// turns off logging for Terimber Completion port and releases own port
 #if OS_TYPE != OS_WIN32
-	TERIMBER::SetLog(0);
+	_close_port();
 #endif
 
 	// uninit socket library
@@ -494,28 +654,9 @@ aiosock::v_has_job(size_t ident, void* data)
 						return true;
 				}
 
-				// finally checks timeouts
+				// finally checks the earliest timeout
 				date now;
-				sb8_t unow = (sb8_t)now;
-				// gets what user wants and does it
-				for (aiosock_socket_map_iterator_t iter_socket = _socket_map.begin(); iter_socket != _socket_map.end(); ++iter_socket)
-				{
-					for (aiosock_pblock_alloc_list_t::iterator iter_block = iter_socket->_incoming_list.begin(); 
-																	iter_block != iter_socket->_incoming_list.end(); ++iter_block)
-					{
-						// gets pointer to block
-						aiosock_block* block = *iter_block;
-
-						if (block->_expired != 0 // not infinite timeout
-							&& unow >= block->_expired) // already expired
-						{
-							return true;
-						}
-					}
-				}
-
-				// all blocks are up to date
-				return false;
+				return _timers.expired((sb8_t)now) != 0;
 			}
 		case aiosock_working_ident:
 		default:
@@ -555,7 +696,7 @@ aiosock::wait_for_io_completion()
 
 		int cRes = bRes ? 0 : ::GetLastError(); 
 #else
-		int cRes = TERIMBER::GetQueuedCompletionStatus(_aiosock_io_handle, 
+		int cRes = _port->GetQueuedCompletionStatus(_aiosock_io_handle, 
 														&num_bytes, 
 														&sock_key, 
 														(LPOVERLAPPED*)&ov, 
@@ -606,6 +747,8 @@ aiosock::complete_block(size_t sock_key, aiosock_block* ov, int err, size_t proc
 		aiosock_block* block = *iter_block;
 		// removes from incoming list 
 		iter_sock->_incoming_list.erase(_incoming_list_allocator, iter_block);
+		// disarms timer
+		_timers.disarm(block);
 		// assigns error code if any
 		block->_err = err;
 		// assigns processed bytes
@@ -615,8 +758,8 @@ aiosock::complete_block(size_t sock_key, aiosock_block* ov, int err, size_t proc
 		// unlocks mutex
 		guard.unlock();
 		// wakes up working thread any from range
-		if (!_capacity || !_thread_pool.borrow_from_range(aiosock_working_ident, aiosock_working_ident + _capacity, 0, this, aiosock_working_thread_alert))
-			_thread_pool.borrow_thread(aiosock_working_ident, 0, this, aiosock_working_thread_alert);
+		if (!_capacity || !_threads->borrow_from_range(aiosock_working_ident, aiosock_working_ident + _capacity, 0, this, aiosock_working_thread_alert))
+			_threads->borrow_thread(aiosock_working_ident, 0, this, aiosock_working_thread_alert);
 
 		return;
 	} // for
@@ -687,8 +830,8 @@ aiosock::v_do_job(size_t ident, void* data)
 					// unlocks mutex
 					guard.unlock();
 					// wakes up any working thread from range
-					if (!_capacity || !_thread_pool.borrow_from_range(aiosock_working_ident, aiosock_working_ident + _capacity, 0, this, aiosock_working_thread_alert))
-						_thread_pool.borrow_thread(aiosock_working_ident, 0, this, aiosock_working_thread_alert);
+					if (!_capacity || !_threads->borrow_from_range(aiosock_working_ident, aiosock_working_ident + _capacity, 0, this, aiosock_working_thread_alert))
+						_threads->borrow_thread(aiosock_working_ident, 0, this, aiosock_working_thread_alert);
 				}
 			}
 			break;
@@ -799,18 +942,46 @@ aiosock::v_do_job(size_t ident, void* data)
 							}
 							break;
 						case AIOSOCK_ACCEPT:
+						{
+							// accepted socket callback
+							terimber_aiosock_callback** p_accept_callback = 0;
+#if OS_TYPE != OS_WIN32
+							// the owner shard threads can use or close the accepted socket during the callback,
+							// so the callback is changed on the copy and written back under the owner lock
+							terimber_aiosock_callback* accept_callback = 0;
+#endif
 #if OS_TYPE == OS_WIN32
 							setsockopt(accept_handle, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT, (char *)&handle, sizeof(handle));
-#else
-							// associates new accepted socket with internal map
-							block->_accept_ident = _assign_socket(block->hAccept, client_obj, true);
-#endif
+
 							// finds correspondent socket
 							iter_sock = _socket_map.find(block->_accept_ident);
 							if (iter_sock != _socket_map.end())
+								p_accept_callback = &iter_sock->_client_obj;
+#else
+							// pins new accepted socket to the shard by handle hash
+							aiosock* owner = _owner_shard(block->hAccept);
+							// never holds two shard mutexes at once
+							guard.unlock();
+
+							{
+								mutexKeeper owner_guard(owner->_mtx);
+								// associates new accepted socket with internal map
+								block->_accept_ident = owner->_assign_socket(block->hAccept, client_obj, true);
+								// finds correspondent socket
+								iter_sock = owner->_socket_map.find(block->_accept_ident);
+								if (iter_sock != owner->_socket_map.end())
+								{
+									// keeps ident from reuse until the callback returns
+									++iter_sock->_callback_invoking;
+									accept_callback = iter_sock->_client_obj;
+									p_accept_callback = &accept_callback;
+								}
+							}
+#endif
+							if (p_accept_callback)
 							{
 								// assigns listener (default) callback
-								terimber_aiosock_callback*& r_accept_callback = iter_sock->_client_obj;
+								terimber_aiosock_callback*& r_accept_callback = *p_accept_callback;
 								// unlocks mutex
 								guard.unlock();
 								try
@@ -823,6 +994,27 @@ aiosock::v_do_job(size_t ident, void* data)
 									format_logging(0, __FILE__, __LINE__, en_log_error, "v_on_accept exception for socket %d", block->_socket_ident);
 									assert(false);
 								}
+#if OS_TYPE != OS_WIN32
+								mutexKeeper owner_guard(owner->_mtx);
+								// checks if accepted socket is still in the owner map
+								iter_sock = owner->_socket_map.find(block->_accept_ident);
+								if (iter_sock == owner->_socket_map.end())
+								{
+									// checks delay map - closed socket could be there
+									aiosock_delay_key_t::iterator iter_delay = owner->_delay_key_map.find(block->_accept_ident);
+									if (iter_delay != owner->_delay_key_map.end() && --*iter_delay <= 0)
+									{
+										owner->_delay_key_map.erase(iter_delay);
+										owner->_save_ident(block->_accept_ident);
+									}
+								}
+								else
+								{
+									// assigns callback chosen by user
+									iter_sock->_client_obj = accept_callback;
+									--iter_sock->_callback_invoking;
+								}
+#endif
 							}
 							else
 							{
@@ -833,11 +1025,22 @@ aiosock::v_do_job(size_t ident, void* data)
 
 							// wakes up thread
 							_in_thread.wakeup();
-							break;
+						}
+						break;
 						case AIOSOCK_SEND:
 							// unlocks mutex
 							guard.unlock();
 
+#ifdef USE_MMSG
+							// counts bytes of sent datagrams
+							if (block->_datagrams)
+							{
+								size_t sent = __min(block->_processed, block->_datagrams);
+								block->_processed = 0;
+								for (size_t index = 0; index < sent; ++index)
+									block->_processed += block->_vec[index].iov_len;
+							}
+#endif
 							try
 							{
 								// invokes user callback for send - user can change callback
@@ -855,8 +1058,24 @@ aiosock::v_do_job(size_t ident, void* data)
 
 							try
 							{
-								// invokes user callback for receive - user can change callback
-								client_obj->v_on_receive(block->_socket_ident, (void*)block->_buf, block->_len, block->_processed, block->_address, block->_userdata);
+								if (block->_grams)
+								{
+									size_t received = 1;
+#ifdef USE_MMSG
+									// gets length of each received datagram, addresses are already there
+									received = __min(block->_processed, block->_datagrams);
+									for (size_t index = 0; index < received; ++index)
+										block->_grams[index].processed = block->_msgs[index].msg_len;
+#else
+									block->_grams[0].processed = block->_processed;
+									block->_grams[0].address = block->_address;
+#endif
+									// invokes user callback for batch
+									client_obj->v_on_receive_batch(block->_socket_ident, block->_grams, received, block->_userdata);
+								}
+								else
+									// invokes user callback for receive - user can change callback
+									client_obj->v_on_receive(block->_socket_ident, (void*)block->_buf, block->_len, block->_processed, block->_address, block->_userdata);
 							}
 							catch (...)
 							{
@@ -890,7 +1109,7 @@ aiosock::v_do_job(size_t ident, void* data)
 							// if counter is zero - erases it from delay map
 							_delay_key_map.erase(iter_delay);
 							// saves socket ident back to generator
-							_socket_generator.save(block->_socket_ident);
+							_save_ident(block->_socket_ident);
 						}
 					}
 				}
@@ -959,7 +1178,10 @@ aiosock::close(size_t ident)
 	bool tcp_udp = iter->_tcp_udp;
 	bool delay_key = false;
 
-	// erases all incoming blocks
+	// disarms timers and erases all incoming blocks
+	for (aiosock_pblock_alloc_list_t::iterator iter_timer = iter->_incoming_list.begin(); iter_timer != iter->_incoming_list.end(); ++iter_timer)
+		_timers.disarm(*iter_timer);
+
 	iter->_incoming_list.erase(_incoming_list_allocator, iter->_incoming_list.begin(), iter->_incoming_list.end());
 	// checks if callbacks are not invoking for this socket
 	if (iter->_callback_invoking)
@@ -1033,7 +1255,7 @@ aiosock::close(size_t ident)
 
 	if (!delay_key)
 		// returns handle back to generator
-		_socket_generator.save(ident);
+		_save_ident(ident);
 
 	format_logging(0, __FILE__, __LINE__, en_log_info, "socket handle %u is closed", handle);
 }
@@ -1073,9 +1295,7 @@ aiosock::bind(size_t ident, const char* address, unsigned short port)
 int 
 aiosock::send(size_t ident, const void* buf, size_t len, size_t timeout, const sockaddr_in* toaddr, void* userdata)
 {
-	// locks mutex
-	mutexKeeper guard(_mtx);
-	// creates block
+	// creates block, block allocator is thread safe
 	aiosock_block* block = _get_block();
 	// sets timeout
 	block->settimeout(timeout);
@@ -1087,19 +1307,159 @@ aiosock::send(size_t ident, const void* buf, size_t len, size_t timeout, const s
 	block->_buf = (char*)buf;
 	// assigns buffer length
 	block->_len = len;
+	// locks mutex
+	mutexKeeper guard(_mtx);
 	// activates block
 	return _activate_block(ident, block, toaddr);
 }
 
+// sends gathered buffers to specified TCP socket asynchronously
+// virtual 
+int 
+aiosock::send_vector(size_t ident, const terimber_aiosock_buffer* bufs, size_t count, size_t timeout, void* userdata)
+{
+	if (!bufs || !count || count > aiosock_max_vectors)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "invalid buffers count %d for socket %d", count, ident);
+		return -1;
+	}
+
+	// creates block, block allocator is thread safe
+	aiosock_block* block = _get_block();
+	// sets timeout
+	block->settimeout(timeout);
+	// assigns type
+	block->_type = AIOSOCK_SEND;
+	// assigns user data
+	block->_userdata = userdata;
+	// assigns the first buffer, callback gets it back
+	block->_buf = (char*)bufs[0].buf;
+	// assigns native buffers and total length
+	block->_vec_count = count;
+	for (size_t index = 0; index < count; ++index)
+	{
+#if OS_TYPE == OS_WIN32
+		block->_vec[index].buf = (char*)bufs[index].buf;
+		block->_vec[index].len = (u_long)bufs[index].len;
+#else
+		block->_vec[index].iov_base = (void*)bufs[index].buf;
+		block->_vec[index].iov_len = bufs[index].len;
+#endif
+		block->_len += bufs[index].len;
+	}
 
-// receives buffer of bytes from specified socket asynchronously
+	// locks mutex
+	mutexKeeper guard(_mtx);
+	// checks socket type, UDP datagrams are sent one by one
+	aiosock_socket_map_iterator_t iter_sock = _socket_map.find(ident);
+	if (iter_sock != _socket_map.end() && !iter_sock->_tcp_udp)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "gather send is not supported for UDP socket %d", ident);
+		_put_block(block);
+		return -1;
+	}
+
+	// activates block
+	return _activate_block(ident, block, 0);
+}
+
+// receives batch of datagrams from specified UDP socket asynchronously
 // virtual 
 int 
-aiosock::receive(size_t ident, void* buf, size_t len, size_t timeout, const sockaddr_in* fromaddr, void* userdata)
+aiosock::receive_batch(size_t ident, terimber_aiosock_datagram* grams, size_t count, size_t timeout, void* userdata)
 {
+	if (!grams || !count || count > aiosock_max_vectors)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "invalid datagrams count %d for socket %d", count, ident);
+		return -1;
+	}
+
+	// creates block, block allocator is thread safe
+	aiosock_block* block = _get_block();
+	// sets timeout
+	block->settimeout(timeout);
+	// assigns type
+	block->_type = AIOSOCK_RECV;
+	// assigns user data
+	block->_userdata = userdata;
+	// assigns the first buffer, it's used if batch is not supported
+	block->_buf = (char*)grams[0].buf;
+	block->_len = grams[0].len;
+	// keeps caller datagrams
+	block->_grams = grams;
+#ifdef USE_MMSG
+	block->_datagrams = count;
+	for (size_t index = 0; index < count; ++index)
+	{
+		block->_vec[index].iov_base = grams[index].buf;
+		block->_vec[index].iov_len = grams[index].len;
+		block->_msgs[index].msg_hdr.msg_iov = &block->_vec[index];
+		block->_msgs[index].msg_hdr.msg_iovlen = 1;
+		block->_msgs[index].msg_hdr.msg_name = &grams[index].address;
+		block->_msgs[index].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+#else
+	block->_datagrams = 1;
+#endif
+
 	// locks mutex
 	mutexKeeper guard(_mtx);
-	// creates block
+	// activates block
+	return _activate_block(ident, block, &grams[0].address);
+}
+
+// sends batch of datagrams to specified UDP socket asynchronously
+// virtual 
+int 
+aiosock::send_batch(size_t ident, const terimber_aiosock_datagram* grams, size_t count, size_t timeout, void* userdata)
+{
+	if (!grams || !count || count > aiosock_max_vectors)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "invalid datagrams count %d for socket %d", count, ident);
+		return -1;
+	}
+
+#ifndef USE_MMSG
+	// sends the first datagram only
+	return send(ident, grams[0].buf, grams[0].len, timeout, &grams[0].address, userdata);
+#else
+	// creates block, block allocator is thread safe
+	aiosock_block* block = _get_block();
+	// sets timeout
+	block->settimeout(timeout);
+	// assigns type
+	block->_type = AIOSOCK_SEND;
+	// assigns user data
+	block->_userdata = userdata;
+	// assigns the first buffer, callback gets it back
+	block->_buf = (char*)grams[0].buf;
+	// assigns message headers and total length
+	block->_datagrams = count;
+	for (size_t index = 0; index < count; ++index)
+	{
+		block->_vec[index].iov_base = grams[index].buf;
+		block->_vec[index].iov_len = grams[index].len;
+		block->_addresses[index] = grams[index].address;
+		block->_msgs[index].msg_hdr.msg_iov = &block->_vec[index];
+		block->_msgs[index].msg_hdr.msg_iovlen = 1;
+		block->_msgs[index].msg_hdr.msg_name = &block->_addresses[index];
+		block->_msgs[index].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		block->_len += grams[index].len;
+	}
+
+	// locks mutex
+	mutexKeeper guard(_mtx);
+	// activates block
+	return _activate_block(ident, block, &grams[0].address);
+#endif
+}
+
+// receives buffer of bytes from specified socket asynchronously
+// virtual 
+int 
+aiosock::receive(size_t ident, void* buf, size_t len, size_t timeout, const sockaddr_in* fromaddr, void* userdata)
+{
+	// creates block, block allocator is thread safe
 	aiosock_block* block = _get_block();
 	// sets timeout
 	block->settimeout(timeout);
@@ -1111,6 +1471,8 @@ aiosock::receive(size_t ident, void* buf, size_t len, size_t timeout, const sock
 	block->_buf = (char*)buf;
 	// assigns buffer length
 	block->_len = len;
+	// locks mutex
+	mutexKeeper guard(_mtx);
 	// activates block
 	return _activate_block(ident, block, fromaddr);
 }
@@ -1127,9 +1489,7 @@ aiosock::connect(size_t ident, const char* address, unsigned short port, size_t
 		return -1;
 	}
     
-	// creates block
-	mutexKeeper guard(_mtx);
-	// creates block
+	// creates block, block allocator is thread safe
 	aiosock_block* block = _get_block();
 	// sets timeout
 	block->settimeout(timeout);
@@ -1139,6 +1499,8 @@ aiosock::connect(size_t ident, const char* address, unsigned short port, size_t
 	block->_type = AIOSOCK_CONNECT;
 	// assigns user data
 	block->_userdata = userdata;
+	// locks mutex
+	mutexKeeper guard(_mtx);
 	// activates block
 	return _activate_block(ident, block, 0);
 }
@@ -1260,20 +1622,35 @@ aiosock::doxray()
 		completed_actions = _outgoing_list.size(),
 		abounded_actions = 
 #if OS_TYPE == OS_WIN32
-		_abounded_list.size();
+		_abounded_list.size(),
 #else
-		0;
+		0,
 #endif
+		timers = _timers.size(),
+		armed_timers = _timers._armed,
+		fired_timers = _timers._fired;
 
 	guard.unlock();
 
-	format_logging(0, __FILE__, __LINE__, en_log_xray, "<aiosock socks=\"%d\" listeners = \"%d\" delayed=\"%d\" initiated=\"%d\" completed=\"%d\" abounded=\"%d\" />",
-		socks, listeners, delay_actions, initiated_actions, completed_actions, abounded_actions);
+	format_logging(0, __FILE__, __LINE__, en_log_xray, "<aiosock socks=\"%d\" listeners = \"%d\" delayed=\"%d\" initiated=\"%d\" completed=\"%d\" abounded=\"%d\" timers=\"%d\" armed=\"%d\" fired=\"%d\" />",
+		socks, listeners, delay_actions, initiated_actions, completed_actions, abounded_actions, timers, armed_timers, fired_timers);
 
 #if OS_TYPE != OS_WIN32
-	TERIMBER::DoXRay();
+	_port->DoXRay();
 #endif
-	_thread_pool.doxray();
+	_threads->doxray();
+}
+
+size_t 
+aiosock::_generate_ident()
+{
+	return _socket_generator.generate() * _shards + _shard;
+}
+
+void 
+aiosock::_save_ident(size_t ident)
+{
+	_socket_generator.save((ident - _shard) / _shards);
 }
 
 size_t 
@@ -1283,7 +1660,7 @@ aiosock::_assign_socket(aio_sock_handle handle, terimber_aiosock_callback* callb
 	aiosock_socket new_socket(tcp_udp, handle, callback);
 
 	// generates a new ident
-	size_t ident = _socket_generator.generate();
+	size_t ident = _generate_ident();
 
 	// inserts into map
 	aiosock_socket_map_iterator_t iter_sock = _socket_map.insert(ident, new_socket).first;
@@ -1291,7 +1668,7 @@ aiosock::_assign_socket(aio_sock_handle handle, terimber_aiosock_callback* callb
 	{
 		format_logging(0, __FILE__, __LINE__, en_log_error, "not enough memory");
 		_close_socket(new_socket._handle, tcp_udp);
-		_socket_generator.save(ident);
+		_save_ident(ident);
 		return 0;
 	}
 
@@ -1302,7 +1679,7 @@ aiosock::_assign_socket(aio_sock_handle handle, terimber_aiosock_callback* callb
 		format_logging(0, __FILE__, __LINE__, en_log_error, "not enough memory");
 		_close_socket(new_socket._handle, tcp_udp);
 		_socket_map.erase(iter_sock);
-		_socket_generator.save(ident);
+		_save_ident(ident);
 		return 0;
 	}
 
@@ -1334,7 +1711,7 @@ aiosock::_assign_socket(aio_sock_handle handle, terimber_aiosock_callback* callb
 								3))
 #else
 	// associates socket with Terimber completion port, if it's not TCP and not Windows XP
-	if (!TERIMBER::CreateIoCompletionPort(new_socket._handle, 
+	if (!_port->CreateIoCompletionPort(new_socket._handle, 
 								_aiosock_io_handle, 
 								ident, 
 								tcp_udp ? TYPE_TCP : TYPE_UDP))
@@ -1345,7 +1722,7 @@ aiosock::_assign_socket(aio_sock_handle handle, terimber_aiosock_callback* callb
 		_close_socket(new_socket._handle, true);
 		_reverse_map.erase(iter_reverse);
 		_socket_map.erase(iter_sock);
-		_socket_generator.save(ident);
+		_save_ident(ident);
 		return 0;
 	}
 
@@ -1375,6 +1752,7 @@ aiosock::_close_socket(aio_sock_handle handle, bool tcp_udp)
 
 		do
 		{
+#if OS_TYPE == OS_WIN32
 		  fd_set recv_set;
 		  FD_ZERO(&recv_set); 
 		  FD_SET(handle, &recv_set);
@@ -1382,6 +1760,15 @@ aiosock::_close_socket(aio_sock_handle handle, bool tcp_udp)
 		  struct timeval timeout_val = {0, 1000};
 			
       res = ::select((int)handle + 1, &recv_set, 0, 0, &timeout_val);
+#else
+			// fd_set can not hold handles beyond FD_SETSIZE
+			pollfd recv_fd;
+			recv_fd.fd = handle;
+			recv_fd.events = POLLIN;
+			recv_fd.revents = 0;
+
+			res = ::poll(&recv_fd, 1, 1);
+#endif
 		
 			if (res)
 			{
@@ -1416,19 +1803,32 @@ aiosock::_cancel_socket(aio_sock_handle handle)
 #if OS_TYPE == OS_WIN32
 	::CancelIo((HANDLE)handle);
 #else
-	TERIMBER::CancelIo(handle, 0);
+	_port->CancelIo(handle, 0);
 #endif
 }
 
 #if OS_TYPE != OS_WIN32
 
+void 
+aiosock::_close_port()
+{
+	if (!_port)
+		return;
+
+	_port->SetLog(0);
+	if (_port != &GetDefaultCompletionPort())
+		delete _port;
+
+	_port = 0;
+}
+
 //! \brief cancels asynchronous operation
 void 
 aiosock::_cancel_aio(		aio_sock_handle handle,				//!< file handle
 					LPOVERLAPPED overlapped				//!< overlapped block
 					)
 {
-	TERIMBER::CancelIo(handle, overlapped);
+	_port->CancelIo(handle, overlapped);
 }
 
 #endif
@@ -1563,8 +1963,8 @@ aiosock::_process_block(aiosock_block* block)
 			_outgoing_list.push_back(block);
 
 			// wakes up any working thread from range
-			if (!_capacity || !_thread_pool.borrow_from_range(aiosock_working_ident, aiosock_working_ident + _capacity, 0, this, aiosock_working_thread_alert))
-				_thread_pool.borrow_thread(aiosock_working_ident, 0, this, aiosock_working_thread_alert);
+			if (!_capacity || !_threads->borrow_from_range(aiosock_working_ident, aiosock_working_ident + _capacity, 0, this, aiosock_working_thread_alert))
+				_threads->borrow_thread(aiosock_working_ident, 0, this, aiosock_working_thread_alert);
 
 			return 0;
 		}
@@ -1578,6 +1978,8 @@ aiosock::_process_block(aiosock_block* block)
 	{
 		block->_err = 0;
 		block->_processed = 0;
+		// arms timer for finite timeout
+		_timers.arm(block);
 		return 0;
 	}
 }
@@ -1656,7 +2058,7 @@ aiosock::_process_connect(aio_sock_handle handle, aiosock_block* block)
 	}
 
 #else
-	return TERIMBER::ConnectEx(handle, 
+	return _port->ConnectEx(handle, 
 					&block->_address,
 					block) ?
 		EWOULDBLOCK : 
@@ -1711,7 +2113,7 @@ aiosock::_process_accept(aio_sock_handle handle, terimber_aiosock_callback* clie
 		}
 	}
 #else
-	return TERIMBER::AcceptEx(handle,
+	return _port->AcceptEx(handle,
 						block) ?
 		EWOULDBLOCK : 
 		(block->_err = errno);
@@ -1723,7 +2125,14 @@ aiosock::_process_send(aio_sock_handle handle, aiosock_block* block, bool tcp_ud
 {
 	// sends data as non-blocking 
 #if OS_TYPE == OS_WIN32
-	if (tcp_udp)
+	if (block->_vec_count)
+	{
+		// gathers all buffers in one call
+		return ::WSASend(handle, block->_vec, (DWORD)block->_vec_count, (LPDWORD)&block->_processed, 0, block, 0) ?
+			(block->_err = ::WSAGetLastError()) == WSA_IO_PENDING ? ERROR_IO_PENDING : block->_err :
+			ERROR_IO_PENDING;
+	}
+	else if (tcp_udp)
 	{
 		// even operation will complete without pending
 		// WriteFile will notify IO Complition Port
@@ -1745,8 +2154,13 @@ aiosock::_process_send(aio_sock_handle handle, aiosock_block* block, bool tcp_ud
 			(block->_err = ::GetLastError());
 	}
 #else
-	return ((tcp_udp) ? TERIMBER::WSASend(handle, block->_buf, block->_len, block)
-			: TERIMBER::WSASendTo(handle, block->_buf, block->_len, &block->_address, block)) ?
+#ifdef USE_MMSG
+	if (block->_datagrams)
+		return _port->WSASendmTo(handle, block->_msgs, block->_datagrams, block) ? EWOULDBLOCK : (block->_err = errno);
+#endif
+	return ((block->_vec_count) ? _port->WSASendv(handle, block->_vec, block->_vec_count, block)
+			: (tcp_udp) ? _port->WSASend(handle, block->_buf, block->_len, block)
+			: _port->WSASendTo(handle, block->_buf, block->_len, &block->_address, block)) ?
 		EWOULDBLOCK : 
 		(block->_err = errno);
 #endif
@@ -1781,8 +2195,12 @@ aiosock::_process_recv(aio_sock_handle handle, aiosock_block* block, bool tcp_ud
 			(block->_err = ::GetLastError());
 	}
 #else
-	return ((tcp_udp) ? TERIMBER::WSARecv(handle, block->_buf, block->_len, block) 
-			: TERIMBER::WSARecvFrom(handle, block->_buf, block->_len, &block->_address, block)) ?
+#ifdef USE_MMSG
+	if (block->_datagrams)
+		return _port->WSARecvmFrom(handle, block->_msgs, block->_datagrams, block) ? EWOULDBLOCK : (block->_err = errno);
+#endif
+	return ((tcp_udp) ? _port->WSARecv(handle, block->_buf, block->_len, block) 
+			: _port->WSARecvFrom(handle, block->_buf, block->_len, &block->_address, block)) ?
 			EWOULDBLOCK : 
 			(block->_err = errno);
 
@@ -1798,100 +2216,116 @@ aiosock::process_timeouted_blocks()
 
 	// locks mutex
 	mutexKeeper guard(_mtx);
-	// gets what user wants and does it
-	for (aiosock_socket_map_iterator_t iter_socket = _socket_map.begin(); iter_socket != _socket_map.end(); ++iter_socket)
+	// takes the earliest expired block, if any
+	aiosock_block* block = _timers.expired(unow);
+	if (!block)
+		return;
+
+	// disarms timer
+	_timers.disarm(block);
+	++_timers._fired;
+
+	// every path removing block from the incoming list disarms its timer,
+	// so the armed block belongs to nobody else and is released if the invariant is broken
+	// finds socket
+	aiosock_socket_map_iterator_t iter_socket = _socket_map.find(block->_socket_ident);
+	if (iter_socket == _socket_map.end())
 	{
-		size_t socket_key = iter_socket.key();
-		for (aiosock_pblock_alloc_list_t::iterator iter_block = iter_socket->_incoming_list.begin(); 
-														iter_block != iter_socket->_incoming_list.end();)
-		{
-			// gest pointer to block
-			aiosock_block* block = *iter_block;
+		format_logging(0, __FILE__, __LINE__, en_log_error, "socket %d not found for timeouted block", block->_socket_ident);
+		assert(false);
+		_put_block(block);
+		return;
+	}
 
-			if (block->_expired == 0	// infinite timeout
-				|| unow > block->_expired) // not expired yet
-			{
-				++iter_block;
-				continue;
-			}
+	// finds block in the socket incoming list
+	aiosock_pblock_alloc_list_t::iterator iter_block = iter_socket->_incoming_list.begin();
+	while (iter_block != iter_socket->_incoming_list.end() && *iter_block != block)
+		++iter_block;
+
+	if (iter_block == iter_socket->_incoming_list.end())
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "timeouted block not found for socket %d", block->_socket_ident);
+		assert(false);
+		_put_block(block);
+		return;
+	}
 
-			// gets socket information
-			aio_sock_handle handle = iter_socket->_handle;
-			terimber_aiosock_callback* client_obj = iter_socket->_client_obj;
+	size_t socket_key = iter_socket.key();
 
-			// erases block from list
-			iter_block = iter_socket->_incoming_list.erase(_incoming_list_allocator, iter_block);
+	// gets socket information
+	aio_sock_handle handle = iter_socket->_handle;
+	terimber_aiosock_callback* client_obj = iter_socket->_client_obj;
 
-			// sets callback counter
-			++iter_socket->_callback_invoking;
-			// unlocks mutex
-			guard.unlock();
+	// erases block from list
+	iter_socket->_incoming_list.erase(_incoming_list_allocator, iter_block);
 
-			format_logging(0, __FILE__, __LINE__, en_log_error, "timeouted %s action for socket %d", 
-				block->_type == AIOSOCK_CONNECT ? "connect" : 
-					(block->_type == AIOSOCK_ACCEPT ? "accept" : 
-						(block->_type == AIOSOCK_RECV ? "recv" : "send")),
-				socket_key);
+	// sets callback counter
+	++iter_socket->_callback_invoking;
+	// unlocks mutex
+	guard.unlock();
 
-			// calls error callback
-			try
-			{
-				client_obj->v_on_error(block->_socket_ident, 
+	format_logging(0, __FILE__, __LINE__, en_log_error, "timeouted %s action for socket %d", 
+		block->_type == AIOSOCK_CONNECT ? "connect" : 
+			(block->_type == AIOSOCK_ACCEPT ? "accept" : 
+				(block->_type == AIOSOCK_RECV ? "recv" : "send")),
+		socket_key);
+
+	// calls error callback
+	try
+	{
+		client_obj->v_on_error(block->_socket_ident, 
 #if OS_TYPE == OS_WIN32
-					WSAETIMEDOUT
+			WSAETIMEDOUT
 #else							
-					ETIMEDOUT
+			ETIMEDOUT
 #endif
-					, block->_type
-					, block->_userdata);
-			}
-			catch (...)
-			{
-				assert(false);
-			}
+			, block->_type
+			, block->_userdata);
+	}
+	catch (...)
+	{
+		assert(false);
+	}
 
-			// resets callback counter
-			guard.lock();
-			
-			// finds correspondent socket
-			aiosock_socket_map_t::iterator iter_find = _socket_map.find(block->_socket_ident);
-			
-			if (iter_find == _socket_map.end())
-			{
-				// checks delay map
-				aiosock_delay_key_t::iterator iter_delay = _delay_key_map.find(block->_socket_ident);
+	// resets callback counter
+	guard.lock();
+	
+	// finds correspondent socket
+	aiosock_socket_map_t::iterator iter_find = _socket_map.find(block->_socket_ident);
+	
+	if (iter_find == _socket_map.end())
+	{
+		// checks delay map
+		aiosock_delay_key_t::iterator iter_delay = _delay_key_map.find(block->_socket_ident);
 
-				if (iter_delay != _delay_key_map.end())
-				{
-					assert(*iter_delay > 0);
+		if (iter_delay != _delay_key_map.end())
+		{
+			assert(*iter_delay > 0);
 
-					if (--*iter_delay <= 0)
-					{
-						_delay_key_map.erase(iter_delay);
-						_socket_generator.save(block->_socket_ident);
-					}
-				}
-				// else - socket port is about to close - nothing to do
-			}
-			else
+			if (--*iter_delay <= 0)
 			{
-				// decrement callback counter
-				assert(iter_find->_callback_invoking > 0);
-				--iter_find->_callback_invoking;
+				_delay_key_map.erase(iter_delay);
+				_save_ident(block->_socket_ident);
 			}
+		}
+		// else - socket port is about to close - nothing to do
+	}
+	else
+	{
+		// decrement callback counter
+		assert(iter_find->_callback_invoking > 0);
+		--iter_find->_callback_invoking;
+	}
 
 
 #if OS_TYPE == OS_WIN32
-			// puts block to abounded list
-			_abounded_list.push_back(block);
+	// puts block to abounded list
+	_abounded_list.push_back(block);
 #else
-			_cancel_aio(handle, block);
-			_put_block(block);
+	_cancel_aio(handle, block);
+	_put_block(block);
 #endif
-			// one at the time 
-			return;
-		} // for block
-	} // for socket
+	// one at the time 
 }
 
 bool 
@@ -1927,5 +2361,157 @@ aiosock::process_accept_blocks()
 	return false;
 }
 
+//////////////////////////////////////////////
+aiosock_sharded::aiosock_sharded(size_t shards, size_t capacity, size_t deactivate_time_msec, bool work_stealing) :
+_shards(0)
+,_count(shards ? shards : 1)
+,_next(0)
+{
+	_shards = new aiosock*[_count];
+	// shards know each other to pin accepted sockets
+	for (size_t i = 0; i < _count; ++i)
+		_shards[i] = new aiosock(capacity, deactivate_time_msec, _shards, i, _count, work_stealing);
+}
+
+aiosock_sharded::~aiosock_sharded()
+{
+	off();
+
+	for (size_t i = 0; i < _count; ++i)
+		delete _shards[i];
+
+	delete [] _shards;
+}
+
+bool
+aiosock_sharded::on()
+{
+	for (size_t i = 0; i < _count; ++i)
+	{
+		// shards log through this object
+		_shards[i]->log_on(this);
+		if (!_shards[i]->on())
+		{
+			format_logging(0, __FILE__, __LINE__, en_log_error, "can not start aiosock shard %d", i);
+			// stops started shards
+			while (i--)
+				_shards[i]->off();
+
+			return false;
+		}
+	}
+
+	format_logging(0, __FILE__, __LINE__, en_log_info, "%d aiosock shards are started", _count);
+	return true;
+}
+
+void
+aiosock_sharded::off()
+{
+	for (size_t i = 0; i < _count; ++i)
+	{
+		_shards[i]->off();
+		_shards[i]->log_on(0);
+	}
+}
+
+// virtual 
+size_t 
+aiosock_sharded::create(terimber_aiosock_callback* callback, bool tcp_udp)
+{
+	mutexKeeper guard(_mtx);
+	size_t shard = _next++ % _count;
+	guard.unlock();
+
+	return _shards[shard]->create(callback, tcp_udp);
+}
+
+// virtual 
+void 
+aiosock_sharded::close(size_t ident)
+{
+	_route(ident)->close(ident);
+}
+
+// virtual 
+int 
+aiosock_sharded::send(size_t ident, const void* buf, size_t len, size_t timeout, const sockaddr_in* toaddr, void* userdata)
+{
+	return _route(ident)->send(ident, buf, len, timeout, toaddr, userdata);
+}
+
+// virtual 
+int 
+aiosock_sharded::send_vector(size_t ident, const terimber_aiosock_buffer* bufs, size_t count, size_t timeout, void* userdata)
+{
+	return _route(ident)->send_vector(ident, bufs, count, timeout, userdata);
+}
+
+// virtual 
+int 
+aiosock_sharded::receive_batch(size_t ident, terimber_aiosock_datagram* grams, size_t count, size_t timeout, void* userdata)
+{
+	return _route(ident)->receive_batch(ident, grams, count, timeout, userdata);
+}
+
+// virtual 
+int 
+aiosock_sharded::send_batch(size_t ident, const terimber_aiosock_datagram* grams, size_t count, size_t timeout, void* userdata)
+{
+	return _route(ident)->send_batch(ident, grams, count, timeout, userdata);
+}
+
+// virtual 
+int 
+aiosock_sharded::receive(size_t ident, void* buf, size_t len, size_t timeout, const sockaddr_in* fromaddr, void* userdata)
+{
+	return _route(ident)->receive(ident, buf, len, timeout, fromaddr, userdata);
+}
+
+// virtual 
+int 
+aiosock_sharded::connect(size_t ident, const char* address, unsigned short port, size_t timeout, void* userdata)
+{
+	return _route(ident)->connect(ident, address, port, timeout, userdata);
+}
+
+// virtual 
+int 
+aiosock_sharded::listen(size_t ident, unsigned short port, size_t max_connection, const char* address, unsigned short accept_pool, void* userdata)
+{
+	return _route(ident)->listen(ident, port, max_connection, address, accept_pool, userdata);
+}
+
+// virtual 
+int 
+aiosock_sharded::bind(size_t ident, const char* address, unsigned short port)
+{
+	return _route(ident)->bind(ident, address, port);
+}
+
+// virtual 
+int 
+aiosock_sharded::getpeeraddr(size_t ident, sockaddr_in& addr)
+{
+	return _route(ident)->getpeeraddr(ident, addr);
+}
+
+// virtual 
+int 
+aiosock_sharded::getsockaddr(size_t ident, sockaddr_in& addr)
+{
+	return _route(ident)->getsockaddr(ident, addr);
+}
+
+// virtual 
+void 
+aiosock_sharded::doxray()
+{
+	format_logging(0, __FILE__, __LINE__, en_log_xray, "<aiosock_sharded shards=\"%d\" />", _count);
+
+	for (size_t i = 0; i < _count; ++i)
+		_shards[i]->doxray();
+}
+
 #pragma pack()
 END_TERIMBER_NAMESPACE
@@ -41,6 +41,14 @@ BEGIN_TERIMBER_NAMESPACE
 
 #pragma pack(4)
 
+//! \typedef aiosock_vector
+//! \brief native gather buffer descriptor
+#if OS_TYPE == OS_WIN32
+typedef WSABUF aiosock_vector;
+#else
+typedef iovec aiosock_vector;
+#endif
+
 //! \class aiosock_block
 //! \brief defines the asynchronous control block for WIN platform
 class aiosock_block : public OVERLAPPED
@@ -80,6 +88,83 @@ public:
 #endif
 					_timeout;								//!< timeout in milliseconds
 	sb8_t			_expired;								//!< expiration date
+	size_t			_timer_index;							//!< position in timer heap + 1, zero if not armed
+	size_t			_vec_count;								//!< gather buffers count, zero for plain send
+	aiosock_vector	_vec[aiosock_max_vectors];				//!< gather buffers
+	size_t			_datagrams;								//!< datagrams count of UDP batch, zero for single datagram
+	terimber_aiosock_datagram* _grams;						//!< caller datagrams of batched receive
+#ifdef USE_MMSG
+	mmsghdr			_msgs[aiosock_max_vectors];				//!< message headers of UDP batch
+	sockaddr_in		_addresses[aiosock_max_vectors];		//!< destination addresses of batched send
+#endif
+};
+
+//! \class aiosock_timer_heap
+//! \brief min-heap of pending blocks with finite timeout ordered by expiration date
+//! each block keeps own heap position, so the block can be disarmed in O(log n) on completion
+class aiosock_timer_heap
+{
+public:
+	//! \brief constructor
+	aiosock_timer_heap();
+	//! \brief destructor
+	~aiosock_timer_heap();
+
+	//! \brief arms timer for block with finite timeout
+	void 
+	arm(			aiosock_block* block					//!< pending block
+					);
+	//! \brief disarms timer, if any
+	void 
+	disarm(			aiosock_block* block					//!< block
+					);
+	//! \brief returns the earliest expired block or zero
+	inline 
+	aiosock_block* 
+	expired(		sb8_t now								//!< current date
+					) const
+	{
+		return _count && _heap[0]->_expired <= now ? _heap[0] : 0;
+	}
+	//! \brief returns armed timers count
+	inline 
+	size_t 
+	size() const
+	{
+		return _count;
+	}
+	//! \brief disarms all timers and releases memory
+	void 
+	clear();
+
+private:
+	//! \brief puts block into heap position
+	inline 
+	void 
+	place(			size_t index,							//!< heap position
+					aiosock_block* block					//!< block
+					)
+	{
+		_heap[index] = block;
+		block->_timer_index = index + 1;
+	}
+	//! \brief moves block up to the root
+	void 
+	sift_up(		size_t index							//!< heap position
+					);
+	//! \brief moves block down to the leaves
+	void 
+	sift_down(		size_t index							//!< heap position
+					);
+
+public:
+	size_t							_armed;					//!< counter of armed timers
+	size_t							_fired;					//!< counter of fired timers
+
+private:
+	aiosock_block**					_heap;					//!< heap array
+	size_t							_count;					//!< armed timers
+	size_t							_capacity;				//!< heap array capacity
 };
 
 //! \typedef aio_sock_handle
@@ -102,7 +187,7 @@ class aiosock : public terimber_thread_employer,
 	typedef list< aiosock_block* >										aiosock_pblock_list_t;
 	//! \typedef aiosock_block_allocator_t
 	//! \brief node allocator - block factory
-	typedef node_allocator< aiosock_block >								aiosock_block_allocator_t;
+	typedef concurrent_node_allocator< aiosock_block >					aiosock_block_allocator_t;
 
 	//! \class listener_info
 	//! \brief listener information
@@ -234,15 +319,37 @@ class aiosock : public terimber_thread_employer,
 	void 
 	_put_block(aiosock_block* block)
 	{
+		_timers.disarm(block);
 		block->~aiosock_block();
 		_block_allocator.deallocate(block);
 	}
 
+	//! \brief generates a new socket ident, ident modulo shards is this shard
+	size_t 
+	_generate_ident();
+
+	//! \brief returns socket ident back to generator
+	void 
+	_save_ident(		size_t ident						//!< socket ident
+					);
+
+	//! \brief finds shard for accepted socket by socket handle hash
+	inline 
+	aiosock* 
+	_owner_shard(aio_sock_handle handle) const
+	{
+		return _group ? _group[(size_t)handle % _shards] : const_cast< aiosock* >(this);
+	}
+
 
 public:
 	//! \brief constructor
 	aiosock(size_t capacity,								//!< additional threads for processing asynchronous completion callbacks
-			size_t deactivate_time_msec						//!< timeout in milliseconds to despose unused threads
+			size_t deactivate_time_msec,					//!< timeout in milliseconds to despose unused threads
+			aiosock* const* group = 0,						//!< all shards, if any
+			size_t shard = 0,								//!< shard index
+			size_t shards = 1,								//!< shards count
+			bool work_stealing = false						//!< threads come from work stealing executor
 			);
 	//! \brief destructor
 	~aiosock();
@@ -275,6 +382,33 @@ public:
 			const sockaddr_in* toaddr,						//!< peer address, optional for TCP sockets
 			void* userdata									//!< user defined data
 			);
+	//! \brief sends gathered buffers to specified TCP socket asynchronously
+	virtual 
+	int 
+	send_vector(size_t ident,								//!< socket ident
+			const terimber_aiosock_buffer* bufs,			//!< buffers to send
+			size_t count,									//!< buffers count
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			);
+	//! \brief receives batch of datagrams from specified UDP socket asynchronously
+	virtual 
+	int 
+	receive_batch(size_t ident,								//!< socket ident
+			terimber_aiosock_datagram* grams,				//!< datagrams to receive
+			size_t count,									//!< datagrams count
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			);
+	//! \brief sends batch of datagrams to specified UDP socket asynchronously
+	virtual 
+	int 
+	send_batch(size_t ident,								//!< socket ident
+			const terimber_aiosock_datagram* grams,			//!< datagrams to send
+			size_t count,									//!< datagrams count
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			);
 	//! \brief receives buffer of bytes from specified socket asynchronously
 	virtual 
 	int 
@@ -413,6 +547,9 @@ private:
 	_cancel_aio(		aio_sock_handle handle,				//!< socket handle
 					OVERLAPPED* overlapped				//!< overlapped block
 					);
+	//! \brief turns off port logging and destroys own port
+	void 
+	_close_port();
 #endif
 
 	//! \brief associates socket handle with internal structures
@@ -475,6 +612,7 @@ public:
 	aiosock_block_allocator_t		_block_allocator;		//!< block allocator
 	aiosock_pblock_list_t			_initial_list;			//!< keeps initial processing reuqests
 	aiosock_pblock_list_t			_outgoing_list;			//!< keeps processed asynchronous requests
+	aiosock_timer_heap				_timers;				//!< pending blocks with finite timeouts
 
 #if OS_TYPE == OS_WIN32
 	aiosock_pblock_list_t			_abounded_list;			//!< keeps abounded asynchronous requests for Complition Port only
@@ -482,7 +620,12 @@ public:
 
 private:
 	HANDLE							_aiosock_io_handle; 	//!< this Terimber port handle
+#if OS_TYPE != OS_WIN32
+	aiocomport*						_port;					//!< own socket-only port in epoll mode, otherwise the default one
+#endif
 	threadpool						_thread_pool;			//!< thread pool
+	executor*						_executor;				//!< work stealing executor used instead of thread pool, if any
+	terimber_threadpool*			_threads;				//!< thread pool or executor
 	size_t							_capacity;				//!< max thread pool capacity
 	thread							_in_thread;				//!< housekeeping thread - process initatial and timeouted blocks
 	static bool						_port_init;				//!< initialize once
@@ -490,6 +633,160 @@ private:
 	bool							_flag_io_port;			//!< signals that the Terimber Completion Port is running
 	event							_start_io_port;			//!< signals that the thread is waiting for completion actions - Terimber Completion Port
 	event							_stop_io_port;			//!< signals that the thread stopped for completion actions - Terimber Completion Port
+	aiosock* const*					_group;					//!< all shards, zero if not sharded
+	size_t							_shard;					//!< shard index
+	size_t							_shards;				//!< shards count
+};
+
+//! \class aiosock_sharded
+//! \brief runs independent aiosock shards, each with own maps, allocators, mutex and threads
+//! socket ident modulo shards count is the owning shard
+//! new sockets are spread round robin, on Linux accepted sockets are pinned by socket handle hash
+class aiosock_sharded : public terimber_aiosock
+{
+public:
+	//! \brief constructor
+	aiosock_sharded(size_t shards,							//!< shards count
+			size_t capacity,								//!< additional threads for processing asynchronous completion callbacks per shard
+			size_t deactivate_time_msec,					//!< timeout in milliseconds to despose unused threads
+			bool work_stealing = false						//!< threads come from work stealing executor
+			);
+	//! \brief destructor
+	~aiosock_sharded();
+
+	//! \brief activates all shards
+	bool 
+	on();
+	//! \brief deactivates all shards
+	void 
+	off();
+
+	//! \brief creates socket in the next shard
+	virtual 
+	size_t 
+	create(	terimber_aiosock_callback* callback,			//!< callback function
+			bool tcp_udp									//!< socket type TCP/UDP
+			);
+	//! \brief closes socket
+	virtual 
+	void 
+	close(	size_t ident									//!< socket ident
+			);
+	//! \brief sends buffer to specified socket asynchronously
+	virtual 
+	int 
+	send(	size_t ident,									//!< socket ident
+			const void* buf,								//!< buffer to send
+			size_t len,										//!< buffer length
+			size_t timeout,									//!< timeout in milliseconds
+			const sockaddr_in* toaddr,						//!< peer address, optional for TCP sockets
+			void* userdata									//!< user defined data
+			);
+	//! \brief sends gathered buffers to specified TCP socket asynchronously
+	virtual 
+	int 
+	send_vector(size_t ident,								//!< socket ident
+			const terimber_aiosock_buffer* bufs,			//!< buffers to send
+			size_t count,									//!< buffers count
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			);
+	//! \brief receives batch of datagrams from specified UDP socket asynchronously
+	virtual 
+	int 
+	receive_batch(size_t ident,								//!< socket ident
+			terimber_aiosock_datagram* grams,				//!< datagrams to receive
+			size_t count,									//!< datagrams count
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			);
+	//! \brief sends batch of datagrams to specified UDP socket asynchronously
+	virtual 
+	int 
+	send_batch(size_t ident,								//!< socket ident
+			const terimber_aiosock_datagram* grams,			//!< datagrams to send
+			size_t count,									//!< datagrams count
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			);
+	//! \brief receives buffer of bytes from specified socket asynchronously
+	virtual 
+	int 
+	receive(size_t ident,									//!< socket ident
+			void* buf,										//!< buffer to receive
+			size_t len,										//!< buffer length
+			size_t timeout,									//!< timeout in milliseconds
+			const sockaddr_in* fromaddr,					//!< peer address, optional for TCP sockets
+			void* userdata									//!< user defined data
+			);
+	//! \brief connects to the specified socket synchronously
+	virtual 
+	int 
+	connect(size_t ident,									//!< socket ident
+			const char* address,							//!< peer address: IP, DNS name, localhost
+			unsigned short port,							//!< peer port
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			);
+	//! \brief turns the specified socket to listening state
+	virtual 
+	int 
+	listen(	size_t ident,									//!< socket ident
+			unsigned short port,							//!< listener port
+			size_t max_connection,							//!< max waiting connections to accept
+			const char* address,							//!< listener address: IP, DNS name, localhost
+			unsigned short accept_pool,						//!< max initiated acceptors
+			void* userdata									//!< user defined data
+			);
+	//! \brief binds UDP socket to address
+	virtual 
+	int 
+	bind(	size_t ident,									//!< socket ident
+			const char* address,							//!< address: IP, DNS name, localhost
+			unsigned short port								//!< port
+			);
+	//! \brief gets the peer address
+	virtual 
+	int 
+	getpeeraddr(size_t ident,								//!< socket ident
+				sockaddr_in& addr							//!< peer address
+				);		
+	//! \brief gets the sock address
+	virtual 
+	int 
+	getsockaddr(size_t ident,								//!< socket ident 
+				sockaddr_in& addr							//!< this socket address
+				);
+	//! \brief gets error string by code
+	virtual 
+	bool
+	get_error_description(
+					int err,								//!< error code
+					char* buf,								//!< [in, out] buffer
+					size_t	len								//!< buffer length
+				) const
+	{
+		return aiosock::resolve_sock_error_code(err, buf, len);
+	}
+	//! \brief makes the snapshot of internal state for all shards
+	virtual 
+	void 
+	doxray();
+
+private:
+	//! \brief finds the owning shard
+	inline 
+	aiosock* 
+	_route(size_t ident) const
+	{
+		return _shards[ident % _count];
+	}
+
+private:
+	aiosock**						_shards;				//!< shards
+	size_t							_count;					//!< shards count
+	mutex							_mtx;					//!< protects round robin counter
+	size_t							_next;					//!< next shard for created socket
 };
 
 
@@ -40,6 +40,29 @@ enum aiosock_type
 	AIOSOCK_RECV,											//!< receive
 };
 
+//! \brief max buffers gathered by one send_vector call
+const size_t aiosock_max_vectors = 16;
+
+//! \class terimber_aiosock_buffer
+//! \brief describes one buffer of gather send
+class terimber_aiosock_buffer
+{
+public:
+	const void*		buf;									//!< buffer pointer
+	size_t			len;									//!< buffer length
+};
+
+//! \class terimber_aiosock_datagram
+//! \brief describes one datagram of batched UDP receive/send
+class terimber_aiosock_datagram
+{
+public:
+	void*			buf;									//!< buffer pointer
+	size_t			len;									//!< buffer length
+	size_t			processed;								//!< received bytes, assigned on completion
+	sockaddr_in		address;								//!< source address for receive, destination address for send
+};
+
 //! \class terimber_aiosock_callback
 //! \brief abstract interface aiosock callbacks
 class terimber_aiosock_callback
@@ -84,6 +107,19 @@ public:
 					const sockaddr_in& peeraddr,			//!< peer address
 					void* userdata							//!< user defined data
 					) = 0;
+	//! \brief port will call function after successfully receiving the batch of datagrams from UDP socket
+	//! by default passes datagrams to v_on_receive one by one
+	virtual 
+	void 
+	v_on_receive_batch(	size_t handle,						//!< socket handle
+					terimber_aiosock_datagram* grams,		//!< datagrams passed to receive_batch
+					size_t count,							//!< received datagrams count
+					void* userdata							//!< user defined data
+					)
+	{
+		for (size_t index = 0; index < count; ++index)
+			v_on_receive(handle, grams[index].buf, grams[index].len, grams[index].processed, grams[index].address, userdata);
+	}
 	//! \brief port will call function after successfully accepting the new incoming connection
 	//! user can change the callback, by default it's an object which created a listener
 	virtual 
@@ -136,6 +172,17 @@ public:
 			) = 0;
 
 	// TCP only methods
+	//! \brief sends up to aiosock_max_vectors buffers to specified socket asynchronously in one system call
+	//! buffers are not copied and must be valid until v_on_send callback, 
+	//! which gets the first buffer and total length of all buffers
+	virtual 
+	int 
+	send_vector(size_t handle,								//!< socket handle
+			const terimber_aiosock_buffer* bufs,			//!< buffers to send
+			size_t count,									//!< buffers count
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			) = 0;
 	//! \brief connects to the specified socket synchronously
 	virtual 
 	int 
@@ -172,6 +219,28 @@ public:
 			const char* address,							//!< address: IP address, DSN name, localhost
 			unsigned short port								//!< port
 			) = 0;
+	//! \brief receives up to aiosock_max_vectors datagrams from UDP socket by one system call where supported, 
+	//! otherwise receives one datagram to the first buffer, 
+	//! datagram descriptors must be valid until v_on_receive_batch callback
+	virtual 
+	int 
+	receive_batch(size_t handle,							//!< socket handle
+			terimber_aiosock_datagram* grams,				//!< datagrams to receive
+			size_t count,									//!< datagrams count
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			) = 0;
+	//! \brief sends up to aiosock_max_vectors datagrams to UDP socket by one system call where supported, 
+	//! otherwise sends the first datagram only, buffers must be valid until v_on_send callback, 
+	//! which gets the first buffer, total length and bytes of datagrams actually sent
+	virtual 
+	int 
+	send_batch(size_t handle,								//!< socket handle
+			const terimber_aiosock_datagram* grams,			//!< datagrams to send
+			size_t count,									//!< datagrams count
+			size_t timeout,									//!< timeout in milliseconds
+			void* userdata									//!< user defined data
+			) = 0;
 	// UDP
 
 	//! \brief gets the sock address
@@ -208,10 +277,14 @@ public:
 
 	//! \brief creates terimber socket port object
 	//! caller is responsible for destroying it
+	//! more than one shard runs independent socket ports, each socket is pinned to one of them
+	//! work stealing executor can run the socket port threads instead of thread pool
 	terimber_aiosock* 
 	get_aiosock(	terimber_log* log,							//!< logging pointer
 					size_t capacity = 3,						//!< amount of additional threads can be opened and used simultaniously to process callbacks
-					size_t deactivate_time_msec = 60000			//!< interval in milliseconds to close unused threads
+					size_t deactivate_time_msec = 60000,		//!< interval in milliseconds to close unused threads
+					size_t shards = 1,							//!< number of shards, each has own mutex and completion thread
+					bool work_stealing = false					//!< threads come from work stealing executor, deactivate time is not used
 				);
 };
 
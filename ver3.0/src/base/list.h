@@ -523,7 +523,8 @@ class list : public base_list< T >
 {
 public:
 	//! \brief constructor
-	list< T >(	size_t size = os_def_size					//!< default element count - memory optimization for allocator pages
+	list< T >(	size_t size = os_def_size,					//!< default element count - memory optimization for allocator pages
+				chunk_provider* provider = 0				//!< chunk provider for allocator, 0 - general heap
 				);
 	//! \brief destructor
 	~list< T >();
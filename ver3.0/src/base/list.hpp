@@ -493,8 +493,8 @@ _list< T, A >::_freenode(node_allocator< TYPENAME base_list< T >::_node >& alloc
 // forward and backward iterators are supported
 template < class T >
 inline
-list< T >::list(size_t size) : 
-	base_list< T >(), _length(0), _allocator(size) 
+list< T >::list(size_t size, chunk_provider* provider) : 
+	base_list< T >(), _length(0), _allocator(size, provider) 
 {
 }
 
@@ -510,7 +510,7 @@ list< T >::~list()
 template < class T >
 inline
 list< T >::list(const list< T >& x) : 
-	base_list< T >(), _length(0), _allocator(x._allocator.capacity()) 
+	base_list< T >(), _length(0), _allocator(x._allocator.capacity(), x._allocator.provider()) 
 { 
 	*this = x; 
 }
@@ -770,7 +770,8 @@ public:
 	//! \brief constructor
 	explicit 
 	map< K, T, Pr, M >(	const Pr& pr = Pr(),				//!< predicate
-					size_t size = os_def_size				//!< number of element on one page of allocator
+					size_t size = os_def_size,				//!< number of element on one page of allocator
+					chunk_provider* provider = 0			//!< chunk provider for allocator, 0 - general heap
 					);
 	//! \brief copy constructor
     map< K, T, Pr, M >(const map< K, T, Pr, M >& x);
@@ -805,8 +806,33 @@ public:
 	inline 
 	void 
 	clear();
+	//! \brief replaces the content by sorted elements
+	//! builds the balanced tree bottom up in O(n) without any comparisons
+	//! keys must be sorted by predicate, equal keys of multimap keep their order
+	template < class KI, class VI >
+	inline
+	bool
+	assign_sorted(	KI keys,								//!< random access iterator to sorted keys
+					VI values,								//!< random access iterator to values
+					size_t count							//!< number of elements
+					);
 
 protected:
+	//! \brief links the subtree of sorted elements [first, last)
+	//! nodes at red_depth are red, all the others are black
+	template < class KI, class VI >
+	inline
+	TYPENAME
+	map< K, T, Pr, M >::_node*
+	_link_sorted(	KI keys,								//!< keys
+					VI values,								//!< values
+					size_t first,							//!< first element
+					size_t last,							//!< last element
+					TYPENAME map< K, T, Pr, M >::_node* p,	//!< parent node
+					size_t depth,							//!< depth of subtree root
+					size_t red_depth,						//!< depth of red nodes
+					bool& ok								//!< [out] false if no memory
+					);
 	//! \brief the range of ierators
 	inline 
 	TYPENAME map< K, T, Pr, M >::iterator 
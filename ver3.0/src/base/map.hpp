@@ -882,8 +882,8 @@ _map< K, T, A, Pr, M >::_freenode(node_allocator< TYPENAME base_map< K, T, Pr, M
 
 /////////////////////
 template < class K, class T, class Pr, bool M >
-map< K, T, Pr, M >::map(const Pr& pr, size_t size) : 
-	base_map<K, T, Pr, M>(pr), _allocator(size) 
+map< K, T, Pr, M >::map(const Pr& pr, size_t size, chunk_provider* provider) : 
+	base_map<K, T, Pr, M>(pr), _allocator(size, provider) 
 {
 }
 
@@ -894,7 +894,7 @@ map< K, T, Pr, M >::~map()
 
 template < class K, class T, class Pr, bool M >
 map< K, T, Pr, M >::map(const map< K, T, Pr, M >& x) : 
-	base_map<K, T, Pr, M>(x), _allocator(x._allocator.capacity()) 
+	base_map<K, T, Pr, M>(x), _allocator(x._allocator.capacity(), x._allocator.provider()) 
 { 
 	*this = x; 
 }
@@ -1078,6 +1078,63 @@ map< K, T, Pr, M >::_insert(bool left, TYPENAME map< K, T, Pr, M >::_node* w, co
 	return base_map<K, T, Pr, M>::_insert(left, w, n, k, v);
 }
     
+template < class K, class T, class Pr, bool M >
+template < class KI, class VI >
+inline
+bool
+map< K, T, Pr, M >::assign_sorted(KI keys, VI values, size_t count)
+{
+	clear();
+	if (!count)
+		return true;
+
+	// the deepest level is red, so all paths have the same number of black nodes
+	size_t red_depth = 0;
+	for (size_t n = count; n > 1; n >>= 1)
+		++red_depth;
+
+	bool ok = true;
+	TYPENAME map< K, T, Pr, M >::_node* root = _link_sorted(keys, values, 0, count, this->head(), 0, red_depth, ok);
+	
+	this->_head._parent = root;
+	this->_head._left = map< K, T, Pr, M >::_node::_min(root);
+	this->_head._right = map< K, T, Pr, M >::_node::_max(root);
+
+	if (!ok)
+	{
+		clear();
+		return false;
+	}
+
+	return true;
+}
+
+template < class K, class T, class Pr, bool M >
+template < class KI, class VI >
+inline
+TYPENAME map< K, T, Pr, M >::_node*
+map< K, T, Pr, M >::_link_sorted(KI keys, VI values, size_t first, size_t last, TYPENAME map< K, T, Pr, M >::_node* p, size_t depth, size_t red_depth, bool& ok)
+{
+	if (first == last || !ok)
+		return this->head();
+
+	size_t middle = first + (last - first) / 2;
+	TYPENAME map< K, T, Pr, M >::_node* n = _buynode(p, depth && depth == red_depth ? c_red : c_black, t_leaf);
+	if (!n)
+	{
+		ok = false;
+		return this->head();
+	}
+
+	this->_consval(&n->_value, values[middle]);
+	this->_conskey(&n->_key, keys[middle]);
+	++this->_size;
+
+	n->_left = _link_sorted(keys, values, first, middle, n, depth + 1, red_depth, ok);
+	n->_right = _link_sorted(keys, values, middle + 1, last, n, depth + 1, red_depth, ok);
+	return n;
+}
+
 template < class K, class T, class Pr, bool M >
 inline
 TYPENAME map< K, T, Pr, M >::_node*
@@ -31,8 +31,8 @@ BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
 ////////////////////////////
-byte_allocator::byte_allocator(size_t capacity) :
-	_capacity(capacity > os_def_size ? capacity : os_def_size), _count(0), _free_pos(0), _start_chunk(0), _using_chunk(0)
+byte_allocator::byte_allocator(size_t capacity, chunk_provider* provider) :
+	_capacity(capacity > os_def_size ? capacity : os_def_size), _count(0), _free_pos(0), _start_chunk(0), _using_chunk(0), _provider(provider)
 {
 }
    
@@ -48,15 +48,15 @@ byte_allocator::new_chunk(size_t size)
 
 	// we are here - it means we didn't find an available chunk, 
 	// need to allocate a new one
-	mem_chunk* chunk = (mem_chunk*)::malloc(sizeof(mem_chunk) - 
-                                          mem_chunk::MMC_ALIGN * sizeof(uint8_t) + 
-                                          new_size);
+	const size_t header_size = sizeof(mem_chunk) - mem_chunk::MMC_ALIGN * sizeof(uint8_t);
+	size_t chunk_size = header_size + new_size;
+	mem_chunk* chunk = (mem_chunk*)(_provider ? _provider->allocate_chunk(chunk_size) : ::malloc(chunk_size));
 
 	if (!chunk) // problems with system memory allocation
 		return 0;
 				
-	// sets new chunk properties
-	chunk->_chunk_size = new_size;
+	// sets new chunk properties, provider can give more memory than requested
+	chunk->_chunk_size = chunk_size - header_size;
 	chunk->_next_chunk = 0;
 	
 	if (_start_chunk) // there was previous allocation
@@ -97,6 +97,15 @@ byte_allocator::next_chunk(size_t size)
 	return new_chunk(size);
 }
 
+void 
+byte_allocator::free_chunk(mem_chunk* chunk)
+{
+	if (_provider)
+		_provider->release_chunk(chunk, sizeof(mem_chunk) - mem_chunk::MMC_ALIGN * sizeof(uint8_t) + chunk->_chunk_size);
+	else
+		::free(chunk);
+}
+
 void 
 byte_allocator::clear_extra(bool secure)
 { 
@@ -114,7 +123,7 @@ byte_allocator::clear_extra(bool secure)
 		if (secure)
 			memset(_using_chunk->_mem, 0, _using_chunk->_chunk_size);
 
-		::free(_using_chunk);
+		free_chunk(_using_chunk);
 		--_count;
 	}
 
@@ -132,7 +141,7 @@ byte_allocator::clear_all(bool secure)
 		if (secure)
 			memset(_using_chunk->_mem, 0, _using_chunk->_chunk_size);
 
-		::free(_using_chunk);
+		free_chunk(_using_chunk);
 	}
 
 	_count = 0;
@@ -140,8 +149,8 @@ byte_allocator::clear_all(bool secure)
 }
 
 /////////////////////////////////////////////////////////////////
-rep_allocator::rep_allocator(size_t capacity) : 
-	byte_allocator(capacity)
+rep_allocator::rep_allocator(size_t capacity, chunk_provider* provider) : 
+	byte_allocator(capacity, provider)
 {
 }
 
@@ -184,6 +193,249 @@ byte_allocator_creator::deactivate(byte_allocator* obj, size_t)
 }
 
 
+/////////////////////////////////////////////////////////////////
+huge_page_provider::huge_page_provider(size_t page_size, bool bind_node) :
+	_page_size(page_size ? page_size : huge_page_default_size), _bind_node(bind_node), _explicit_chunks(0), _transparent_chunks(0)
+{
+}
+
+void* 
+huge_page_provider::allocate_chunk(size_t& size)
+{
+	// small chunks do not deserve the huge page
+	if (size < _page_size / 2)
+		return ::malloc(size);
+
+	// rounds up to the huge page size
+	size = (size + _page_size - 1) / _page_size * _page_size;
+
+	bool huge = false;
+	void* mem = map_pages(size, huge);
+	if (!mem)
+		return 0;
+
+	// binds before the first touch
+	if (_bind_node)
+		bind_pages(mem, size);
+
+#if OS_TYPE == OS_WIN32
+	::InterlockedIncrement(huge ? &_explicit_chunks : &_transparent_chunks);
+#else
+	__sync_add_and_fetch(huge ? &_explicit_chunks : &_transparent_chunks, 1);
+#endif
+	return mem;
+}
+
+void 
+huge_page_provider::release_chunk(void* chunk, size_t size)
+{
+	// the same size as allocate_chunk returned gives the same decision
+	if (size < _page_size / 2)
+		::free(chunk);
+	else
+#if OS_TYPE == OS_WIN32
+		::VirtualFree(chunk, 0, MEM_RELEASE);
+#elif OS_TYPE == OS_LINUX
+		::munmap(chunk, size);
+#else
+		::free(chunk);
+#endif
+}
+
+size_t 
+huge_page_provider::granularity() const
+{
+	return _page_size;
+}
+
+size_t 
+huge_page_provider::explicit_chunks() const
+{
+	return (size_t)_explicit_chunks;
+}
+
+size_t 
+huge_page_provider::transparent_chunks() const
+{
+	return (size_t)_transparent_chunks;
+}
+
+void* 
+huge_page_provider::map_pages(size_t size, bool& huge)
+{
+#if OS_TYPE == OS_WIN32
+#if defined(MEM_LARGE_PAGES)
+	// requires SeLockMemoryPrivilege
+	SIZE_T large_page = ::GetLargePageMinimum();
+	if (large_page && size % large_page == 0)
+	{
+		void* mem = ::VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (mem)
+		{
+			huge = true;
+			return mem;
+		}
+	}
+#endif
+	return ::VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif OS_TYPE == OS_LINUX
+#if defined(MAP_HUGETLB)
+	// explicit huge pages from the pool, if the administrator reserved them
+	void* mem = ::mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (mem != MAP_FAILED)
+	{
+		huge = true;
+		return mem;
+	}
+#endif
+	// maps more to cut the aligned region, so the kernel can use transparent huge pages
+	uint8_t* area = (uint8_t*)::mmap(0, size + _page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (area == (uint8_t*)MAP_FAILED)
+		return 0;
+
+	uint8_t* aligned = (uint8_t*)(((size_t)area + _page_size - 1) / _page_size * _page_size);
+	if (aligned > area)
+		::munmap(area, aligned - area);
+	if (area + _page_size > aligned)
+		::munmap(aligned + size, area + _page_size - aligned);
+
+#if defined(MADV_HUGEPAGE)
+	::madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+	return aligned;
+#else
+	return ::malloc(size);
+#endif
+}
+
+void 
+huge_page_provider::bind_pages(void* mem, size_t size)
+{
+#if OS_TYPE == OS_WIN32
+	// memory is committed by VirtualAlloc, first touch from the current thread places it on the local node
+#elif OS_TYPE == OS_LINUX && defined(SYS_getcpu) && defined(SYS_mbind)
+	unsigned cpu = 0, node = 0;
+	if (::syscall(SYS_getcpu, &cpu, &node, 0) || node >= sizeof(unsigned long) * 8)
+		return;
+
+	// MPOL_PREFERRED, falls back to other nodes if the local one is exhausted
+	unsigned long mask = 1UL << node;
+	::syscall(SYS_mbind, mem, size, 1, &mask, sizeof(mask) * 8, 0);
+#endif
+}
+
+/////////////////////////////////////////////////////////////////
+//! \brief slot index of the current thread plus one, zero means not assigned yet
+#if OS_TYPE == OS_WIN32
+static __declspec(thread) size_t concurrent_slot = 0;
+static volatile LONG concurrent_slot_counter = 0;
+#else
+static __thread size_t concurrent_slot = 0;
+static volatile size_t concurrent_slot_counter = 0;
+#endif
+
+size_t 
+concurrent_thread_slot()
+{
+	if (!concurrent_slot)
+#if OS_TYPE == OS_WIN32
+		concurrent_slot = (size_t)::InterlockedIncrement(&concurrent_slot_counter);
+#else
+		concurrent_slot = __sync_add_and_fetch(&concurrent_slot_counter, 1);
+#endif
+
+	return (concurrent_slot - 1) % concurrent_allocator_slots;
+}
+
+/////////////////////////////////////////////////////////////////
+concurrent_allocator::concurrent_allocator(size_t size, size_t capacity) :
+	_size(ALIGNED_SIZEOF(size > sizeof(size_t) ? size : sizeof(size_t))),
+	_arena(capacity)
+{
+}
+
+concurrent_allocator::~concurrent_allocator()
+{
+	drop();
+}
+
+void* 
+concurrent_allocator::refill(mem_slot& slot)
+{
+	mutexKeeper guard(_mtx);
+
+	if (!_depot.size())
+	{
+		// carves a batch of new objects from the chunk
+		size_t batch = _arena.capacity() / _size;
+		if (batch > concurrent_magazine_size)
+			batch = concurrent_magazine_size;
+		else if (!batch)
+			batch = 1;
+
+		uint8_t* mem = (uint8_t*)_arena.allocate(batch * _size);
+		if (!mem)
+			return 0;
+
+		guard.unlock();
+
+		for (size_t index = 0; index < batch; ++index)
+			slot._loaded.push((size_t*)(mem + index * _size));
+	}
+	else
+	{
+		// takes the full magazine
+		slot._loaded.take(_depot, concurrent_magazine_size);
+		guard.unlock();
+	}
+
+	return slot._loaded.pop();
+}
+
+void 
+concurrent_allocator::flush(mem_slot& slot, size_t* obj)
+{
+	// both magazines are full, gives the previous one to the depot
+	mutexKeeper guard(_mtx);
+	_depot.splice(slot._previous);
+	guard.unlock();
+
+	slot._previous.swap(slot._loaded);
+	slot._loaded.push(obj);
+}
+
+void 
+concurrent_allocator::drop()
+{
+	for (size_t index = 0; index < concurrent_allocator_slots; ++index)
+	{
+		_slots[index]._loaded.clear();
+		_slots[index]._previous.clear();
+	}
+
+	_depot.clear();
+}
+
+void 
+concurrent_allocator::clear_all(bool secure)
+{
+	drop();
+	_arena.clear_all(secure);
+}
+
+void 
+concurrent_allocator::clear_extra(bool secure)
+{
+	drop();
+	_arena.clear_extra(secure);
+}
+
+void 
+concurrent_allocator::reset(bool secure)
+{
+	drop();
+	_arena.reset(secure);
+}
 
 #pragma pack()
 END_TERIMBER_NAMESPACE
@@ -30,6 +30,7 @@
 
 #include "allinc.h"
 #include "base/proto.h"
+#include "base/primitives.h"
 #include <stdint.h>
 
 BEGIN_TERIMBER_NAMESPACE
@@ -60,6 +61,97 @@ public:
 	uint8_t	      _mem[MMC_ALIGN];	      //!< pointer to allocated memory
 };
 
+//! \class chunk_provider
+//! \brief abstract source of memory chunks for byte_allocator
+//! byte_allocator takes chunks from the general heap unless provider is specified
+//! provider must outlive all allocators using it
+class chunk_provider
+{
+public:
+	//! \brief destructor
+	virtual 
+	~chunk_provider() 
+	{
+	}
+	//! \brief allocates chunk
+	//! provider can round up the size, the size is updated then
+	virtual 
+	void* 
+	allocate_chunk(	size_t& size							//!< [in, out] chunk size in bytes
+					) = 0;
+	//! \brief releases chunk
+	virtual 
+	void 
+	release_chunk(	void* chunk,							//!< chunk pointer
+					size_t size								//!< chunk size returned by allocate_chunk
+					) = 0;
+	//! \brief returns the preferred chunk size
+	//! allocators should use capacity not less than this value to get benefits from provider
+	virtual 
+	size_t 
+	granularity() const = 0;
+};
+
+//! \brief default huge page size
+const size_t huge_page_default_size = 2 * 1024 * 1024;
+
+//! \class huge_page_provider
+//! \brief provides chunks on huge pages, bound to the NUMA node of the allocating thread
+//! explicit huge pages are tried first, then transparent huge pages on the aligned mapping
+//! chunks smaller than half of huge page and all chunks on platforms
+//! without huge pages support come from the general heap
+//! class is thread safe
+class huge_page_provider : public chunk_provider
+{
+public:
+	//! \brief constructor
+	huge_page_provider(size_t page_size = huge_page_default_size, //!< huge page size
+					bool bind_node = true					//!< binds memory to the NUMA node of the allocating thread
+					);
+	//! \brief allocates chunk, rounds size up to the huge page size
+	virtual 
+	void* 
+	allocate_chunk(	size_t& size							//!< [in, out] chunk size in bytes
+					);
+	//! \brief releases chunk
+	virtual 
+	void 
+	release_chunk(	void* chunk,							//!< chunk pointer
+					size_t size								//!< chunk size returned by allocate_chunk
+					);
+	//! \brief returns the huge page size
+	virtual 
+	size_t 
+	granularity() const;
+	//! \brief returns the count of chunks allocated on explicit huge pages
+	size_t 
+	explicit_chunks() const;
+	//! \brief returns the count of chunks allocated on the pages aligned for transparent huge pages
+	size_t 
+	transparent_chunks() const;
+private:
+	//! \brief maps memory aligned to the huge page size
+	void* 
+	map_pages(		size_t size,							//!< size in bytes, multiple of page size
+					bool& huge								//!< [out] explicit huge pages
+					);
+	//! \brief binds memory to the node of the current thread
+	void 
+	bind_pages(		void* mem,								//!< memory pointer
+					size_t size								//!< size in bytes
+					);
+private:
+	const size_t	_page_size;								//!< huge page size
+	const bool		_bind_node;								//!< binds memory to NUMA node
+#if OS_TYPE == OS_WIN32
+	volatile LONG	_explicit_chunks;						//!< count of chunks on explicit huge pages
+	volatile LONG	_transparent_chunks;					//!< count of chunks on aligned pages
+#else
+	volatile size_t	_explicit_chunks;						//!< count of chunks on explicit huge pages
+	volatile size_t	_transparent_chunks;					//!< count of chunks on aligned pages
+#endif
+};
+
 //! \class byte_allocator
 //! \brief high performance class for allocation
 class byte_allocator
@@ -70,7 +162,8 @@ class byte_allocator
 	byte_allocator& operator=(const byte_allocator& x);
 public:
 	//! \brief constructor
-	byte_allocator(	size_t capacity = os_def_size			//!< chunk capacity
+	byte_allocator(	size_t capacity = os_def_size,			//!< chunk capacity
+					chunk_provider* provider = 0			//!< chunk provider, 0 - general heap
 					);
 	//! \brief destructor
 	~byte_allocator();
@@ -108,11 +201,19 @@ public:
 	inline 
 	size_t 
 	count() const;
+	//! \brief returns the chunk provider
+	inline 
+	chunk_provider* 
+	provider() const;
 private:
 	//! \brief allocates new chunk of requested size
 	void* 
 	new_chunk(		size_t size								//!< size in bytes
 					);
+	//! \brief returns chunk memory to the provider or to the general heap
+	void 
+	free_chunk(		mem_chunk* chunk						//!< chunk pointer
+					);
 	//! \brief tries to find the next chunk in a linked list with requested size
 	void* 
 	next_chunk(		size_t size								//!< size in bytes
@@ -123,6 +224,7 @@ protected:
   uint8_t*       _free_pos;								//!< start position of available memory in current chunk
 	mem_chunk*		 _start_chunk;						//!< start chunk
 	mem_chunk*		 _using_chunk;						//!< current chunk
+	chunk_provider*	 _provider;							//!< chunk provider
 };
 
 //! \class chunk_stack
@@ -169,7 +271,8 @@ class rep_allocator : public byte_allocator
 	rep_allocator operator=(const rep_allocator& x);
 protected:
 	//! \brief constructor
-	rep_allocator(	size_t capacity = os_def_size			//!< default capacity
+	rep_allocator(	size_t capacity = os_def_size,			//!< default capacity
+					chunk_provider* provider = 0			//!< chunk provider, 0 - general heap
 					);
 	//! \brief destructor
 	~rep_allocator();
@@ -207,7 +310,8 @@ class node_allocator : public rep_allocator
 {
 public:
 	//! \brief constructor
-	node_allocator< T >(size_t capacity = os_def_size		//!< default capacity
+	node_allocator< T >(size_t capacity = os_def_size,		//!< default capacity
+						chunk_provider* provider = 0		//!< chunk provider, 0 - general heap
 						);
 	//! \brief allocates one object
 	inline 
@@ -224,7 +328,8 @@ class array_allocator : public rep_allocator
 {
 public:
 	//! \brief constructor
-	array_allocator< T >(size_t capacity = os_def_size		//!< default capacity
+	array_allocator< T >(size_t capacity = os_def_size,		//!< default capacity
+					chunk_provider* provider = 0			//!< chunk provider, 0 - general heap
 					);
 	//! \brief destructor
 	~array_allocator< T >();
@@ -334,6 +439,227 @@ public:
 					);
 };
 
+//! \brief number of thread slots in concurrent allocators
+const size_t concurrent_allocator_slots = 32;
+//! \brief number of objects in one magazine
+const size_t concurrent_magazine_size = 64;
+//! \brief number of power of two size classes in concurrent array allocator
+const size_t concurrent_array_classes = 16;
+
+//! \brief returns the slot index of the calling thread
+//! threads get the sequential indexes on the first call
+size_t 
+concurrent_thread_slot();
+
+//! \class mem_magazine
+//! \brief stack of free objects with known tail and count
+//! objects are linked through the first pointer size bytes like in chunk_stack
+class mem_magazine
+{
+public:
+	//! \brief constructor
+	inline 
+	mem_magazine();
+	//! \brief clears magazine
+	inline 
+	void 
+	clear();
+	//! \brief pushes object
+	inline 
+	void 
+	push(			size_t* obj								//!< pointer to object
+					);
+	//! \brief pops object
+	inline 
+	size_t* 
+	pop();
+	//! \brief moves all objects of x to this magazine
+	inline 
+	void 
+	splice(			mem_magazine& x							//!< source magazine
+					);
+	//! \brief moves up to n objects from x to this magazine
+	inline 
+	void 
+	take(			mem_magazine& x,						//!< source magazine
+					size_t n								//!< number of objects
+					);
+	//! \brief swaps magazines
+	inline 
+	void 
+	swap(			mem_magazine& x							//!< other magazine
+					);
+	//! \brief returns number of objects
+	inline 
+	size_t 
+	size() const;
+
+private:
+	size_t*		_head;										//!< the first object
+	size_t*		_tail;										//!< the last object
+	size_t		_count;										//!< number of objects
+};
+
+//! \class concurrent_allocator
+//! \brief thread safe allocator of fixed size objects
+//! each thread works with own slot of two magazines (loaded and previous) under the slot spin lock,
+//! full and empty magazines are exchanged with the depot, which keeps free objects and the memory chunks
+//! threads are mapped to slots by concurrent_thread_slot, more threads than slots share the slots
+class concurrent_allocator
+{
+	//! \brief private copy constructor
+	concurrent_allocator(const concurrent_allocator& x);
+	//! \brief private assign operator
+	concurrent_allocator& operator=(const concurrent_allocator& x);
+
+	//! \class mem_slot
+	//! \brief per thread cache
+	class mem_slot
+	{
+	public:
+		spinlock		_lock;								//!< slot lock
+		mem_magazine	_loaded;							//!< allocates from and deallocates to loaded magazine
+		mem_magazine	_previous;							//!< full or empty magazine
+		uint8_t			_padding[64];						//!< keeps slots of different threads on different cache lines
+	};
+
+public:
+	//! \brief constructor
+	concurrent_allocator(size_t size,						//!< object size in bytes
+					size_t capacity = os_def_size			//!< chunk capacity in bytes
+					);
+	//! \brief destructor
+	~concurrent_allocator();
+	//! \brief allocates one object
+	inline 
+	void* 
+	allocate();
+	//! \brief returns object back for reusing
+	inline 
+	void 
+	deallocate(		void* p									//!< pointer to object
+					);
+	//! \brief clears all memory
+	//! there must be no concurrent calls
+	void 
+	clear_all(		bool secure = false						//!< rewrite memory before release
+					);
+	//! \brief clears extra chunks
+	//! there must be no concurrent calls
+	void 
+	clear_extra(	bool secure = false						//!< rewrite memory before release
+					);
+	//! \brief resets allocator for reusing the memory again
+	//! there must be no concurrent calls
+	void 
+	reset(			bool secure = false						//!< rewrite memory before release
+					);
+	//! \brief returns the capacity of chunk
+	inline 
+	size_t 
+	capacity() const;
+	//! \brief returns the count of chunks
+	inline 
+	size_t 
+	count() const;
+private:
+	//! \brief refills loaded magazine from depot and allocates
+	void* 
+	refill(			mem_slot& slot							//!< thread slot
+					);
+	//! \brief moves full magazine to depot and deallocates
+	void 
+	flush(			mem_slot& slot,							//!< thread slot
+					size_t* obj								//!< pointer to object
+					);
+	//! \brief drops all magazines
+	void 
+	drop();
+private:
+	const size_t	_size;									//!< aligned object size
+	mem_slot		_slots[concurrent_allocator_slots];		//!< thread slots
+	mutex			_mtx;									//!< depot mutex
+	mem_magazine	_depot;									//!< free objects
+	byte_allocator	_arena;									//!< memory chunks
+};
+
+//! \class concurrent_node_allocator
+//! \brief thread safe version of node_allocator
+//! one object at one time
+template < class T >
+class concurrent_node_allocator : public concurrent_allocator
+{
+public:
+	//! \brief constructor
+	concurrent_node_allocator< T >(size_t capacity = os_def_size	//!< default capacity
+						);
+	//! \brief allocates one object
+	inline 
+	T* 
+	allocate();
+};
+
+//! \class concurrent_array_allocator
+//! \brief thread safe version of array_allocator
+//! arrays are rounded up to the power of two size classes, each class has own concurrent_allocator
+//! the array length is kept before the array like in array_allocator
+//! longer arrays go to array_allocator under mutex
+template < class T >
+class concurrent_array_allocator
+{
+	//! \brief private copy constructor
+	concurrent_array_allocator(const concurrent_array_allocator< T >& x);
+	//! \brief private assign operator
+	concurrent_array_allocator< T >& operator=(const concurrent_array_allocator< T >& x);
+public:
+	//! \brief constructor
+	concurrent_array_allocator< T >(size_t capacity = os_def_size	//!< default capacity
+					);
+	//! \brief destructor
+	~concurrent_array_allocator< T >();
+	//! \brief allocates array of n elements
+	inline 
+	T* 
+	allocate(		size_t n								//!< number of elements
+					);
+	//! \brief returns array back for reusing
+	inline 
+	void 
+	deallocate(		void* p									//!< pointer to array
+					);
+	//! \brief clears all memory
+	//! there must be no concurrent calls
+	inline 
+	void 
+	clear_all(		bool secure = false						//!< rewrite memory before release
+					);
+	//! \brief clears extra chunks
+	//! there must be no concurrent calls
+	inline 
+	void 
+	clear_extra(	bool secure = false						//!< rewrite memory before release
+					);
+	//! \brief resets allocator for reusing the memory again
+	//! there must be no concurrent calls
+	inline 
+	void 
+	reset(			bool secure = false						//!< rewrite memory before release
+					);
+	//! \brief returns the capacity of chunk
+	inline 
+	size_t 
+	capacity() const;
+	//! \brief returns the count of chunks
+	inline 
+	size_t 
+	count() const;
+
+private:
+	concurrent_allocator*	_classes[concurrent_array_classes];	//!< size class allocators
+	mutex					_mtx;							//!< mutex for long arrays
+	array_allocator< T >	_large;							//!< long arrays
+};
+
 #pragma pack()
 END_TERIMBER_NAMESPACE
 
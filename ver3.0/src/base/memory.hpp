@@ -147,6 +147,14 @@ byte_allocator::count() const
 	return _count; 
 }
 
+// returns the chunk provider
+inline 
+chunk_provider* 
+byte_allocator::provider() const 
+{ 
+	return _provider; 
+}
+
 /////////////////////////////////////////////////////
 inline 
 void
@@ -185,8 +193,8 @@ rep_allocator::deallocate(void* p)
 // one object at a time
 // constructor
 template < class T >
-node_allocator< T >::node_allocator(size_t capacity) : 
-	rep_allocator((capacity ? capacity : os_def_size) * ALIGNED_SIZEOF(sizeof(T))) 
+node_allocator< T >::node_allocator(size_t capacity, chunk_provider* provider) : 
+	rep_allocator((capacity ? capacity : os_def_size) * ALIGNED_SIZEOF(sizeof(T)), provider) 
 {
 }
 
@@ -204,8 +212,8 @@ node_allocator< T >::allocate()
 // but the previous class (node_allocator) has better performance
 // constructor
 template < class T >
-array_allocator< T >::array_allocator(size_t capacity) : 
-	rep_allocator((capacity ? capacity : os_def_size) * ALIGNED_SIZEOF(sizeof(T))) 
+array_allocator< T >::array_allocator(size_t capacity, chunk_provider* provider) : 
+	rep_allocator((capacity ? capacity : os_def_size) * ALIGNED_SIZEOF(sizeof(T)), provider) 
 {
 }
 
@@ -333,6 +341,278 @@ array_allocator_creator< T >::deactivate(array_allocator< T >* obj, size_t)
 	obj->clear(); 
 }
 
+////////////////////////////////////////////////////////////
+inline 
+mem_magazine::mem_magazine() :
+	_head(0), _tail(0), _count(0)
+{
+}
+
+inline 
+void 
+mem_magazine::clear()
+{
+	_head = _tail = 0;
+	_count = 0;
+}
+
+inline 
+void 
+mem_magazine::push(size_t* obj)
+{
+	*obj = reinterpret_cast< size_t >(_head);
+	if (!_head)
+		_tail = obj;
+	_head = obj;
+	++_count;
+}
+
+inline 
+size_t* 
+mem_magazine::pop()
+{
+	size_t* obj = _head;
+	if (obj)
+	{
+		_head = reinterpret_cast< size_t* >(*obj);
+		if (!--_count)
+			_tail = 0;
+	}
+
+	return obj;
+}
+
+inline 
+void 
+mem_magazine::splice(mem_magazine& x)
+{
+	if (!x._head)
+		return;
+
+	*x._tail = reinterpret_cast< size_t >(_head);
+	if (!_head)
+		_tail = x._tail;
+	_head = x._head;
+	_count += x._count;
+	x.clear();
+}
+
+inline 
+void 
+mem_magazine::take(mem_magazine& x, size_t n)
+{
+	while (n-- && x._head)
+		push(x.pop());
+}
+
+inline 
+void 
+mem_magazine::swap(mem_magazine& x)
+{
+	mem_magazine tmp(x);
+	x = *this;
+	*this = tmp;
+}
+
+inline 
+size_t 
+mem_magazine::size() const
+{
+	return _count;
+}
+
+////////////////////////////////////////////////////////////
+inline 
+void* 
+concurrent_allocator::allocate()
+{
+	mem_slot& slot = _slots[concurrent_thread_slot()];
+	spinlockKeeper keeper(slot._lock);
+
+	size_t* obj = slot._loaded.pop();
+	if (obj)
+		return obj;
+
+	// previous magazine is full, it becomes loaded one
+	if (slot._previous.size())
+	{
+		slot._loaded.swap(slot._previous);
+		return slot._loaded.pop();
+	}
+
+	return refill(slot);
+}
+
+inline 
+void 
+concurrent_allocator::deallocate(void* p)
+{
+	if (!p)
+		return;
+
+	mem_slot& slot = _slots[concurrent_thread_slot()];
+	spinlockKeeper keeper(slot._lock);
+
+	if (slot._loaded.size() < concurrent_magazine_size)
+	{
+		slot._loaded.push((size_t*)p);
+		return;
+	}
+
+	// previous magazine is empty, it becomes loaded one
+	if (!slot._previous.size())
+	{
+		slot._loaded.swap(slot._previous);
+		slot._loaded.push((size_t*)p);
+		return;
+	}
+
+	flush(slot, (size_t*)p);
+}
+
+inline 
+size_t 
+concurrent_allocator::capacity() const
+{
+	return _arena.capacity();
+}
+
+inline 
+size_t 
+concurrent_allocator::count() const
+{
+	return _arena.count();
+}
+
+////////////////////////////////////////////////////////////
+template < class T >
+concurrent_node_allocator< T >::concurrent_node_allocator(size_t capacity) : 
+	concurrent_allocator(ALIGNED_SIZEOF(sizeof(T)), (capacity ? capacity : os_def_size) * ALIGNED_SIZEOF(sizeof(T)))
+{
+}
+
+template < class T >
+inline
+T*
+concurrent_node_allocator< T >::allocate()
+{
+	return (T*)concurrent_allocator::allocate();
+}
+
+////////////////////////////////////////////////////////////
+template < class T >
+concurrent_array_allocator< T >::concurrent_array_allocator(size_t capacity) : 
+	_large(capacity)
+{
+	for (size_t index = 0; index < concurrent_array_classes; ++index)
+		_classes[index] = new concurrent_allocator(sizeof(size_t) + ((size_t)1 << index) * ALIGNED_SIZEOF(sizeof(T)), 
+									(capacity ? capacity : os_def_size) * ALIGNED_SIZEOF(sizeof(T)));
+}
+
+template < class T >
+concurrent_array_allocator< T >::~concurrent_array_allocator()
+{
+	for (size_t index = 0; index < concurrent_array_classes; ++index)
+		delete _classes[index];
+}
+
+template < class T >
+inline
+T*
+concurrent_array_allocator< T >::allocate(size_t n)
+{
+	if (!n) 
+		return 0; // nothing to do
+
+	if (n > ((size_t)1 << (concurrent_array_classes - 1)))
+	{
+		mutexKeeper guard(_mtx);
+		return _large.allocate(n);
+	}
+
+	// finds size class
+	size_t index = 0;
+	while (((size_t)1 << index) < n)
+		++index;
+
+	size_t* ob = (size_t*)_classes[index]->allocate();
+	if (!ob) return 0;
+	*ob = (size_t)1 << index;
+	return (T*)(ob + 1);
+}
+
+template < class T >
+inline
+void
+concurrent_array_allocator< T >::deallocate(void* p)
+{
+	if (!p)
+		return;
+
+	size_t n = *((size_t*)p - 1);
+	if (n > ((size_t)1 << (concurrent_array_classes - 1)))
+	{
+		mutexKeeper guard(_mtx);
+		_large.deallocate(p);
+		return;
+	}
+
+	size_t index = 0;
+	while (((size_t)1 << index) < n)
+		++index;
+
+	_classes[index]->deallocate((size_t*)p - 1);
+}
+
+template < class T >
+inline
+void
+concurrent_array_allocator< T >::clear_all(bool secure)
+{
+	for (size_t index = 0; index < concurrent_array_classes; ++index)
+		_classes[index]->clear_all(secure);
+	_large.clear_all(secure);
+}
+
+template < class T >
+inline
+void
+concurrent_array_allocator< T >::clear_extra(bool secure)
+{
+	for (size_t index = 0; index < concurrent_array_classes; ++index)
+		_classes[index]->clear_extra(secure);
+	_large.clear_extra(secure);
+}
+
+template < class T >
+inline
+void
+concurrent_array_allocator< T >::reset(bool secure)
+{
+	for (size_t index = 0; index < concurrent_array_classes; ++index)
+		_classes[index]->reset(secure);
+	_large.reset(secure);
+}
+
+template < class T >
+inline
+size_t
+concurrent_array_allocator< T >::capacity() const
+{
+	return _large.capacity();
+}
+
+template < class T >
+inline
+size_t
+concurrent_array_allocator< T >::count() const
+{
+	size_t chunks = _large.count();
+	for (size_t index = 0; index < concurrent_array_classes; ++index)
+		chunks += _classes[index]->count();
+	return chunks;
+}
+
 #pragma pack()
 END_TERIMBER_NAMESPACE
 
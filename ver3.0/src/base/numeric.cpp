@@ -171,7 +171,7 @@ numeric::format(char* buf, char delimeter) const
 	if (_sign)
 		*buf++ = '-';
 
-	for (size_t index = _precision - 1; index >= 0; --index)
+	for (size_t index = _precision; index-- > 0;)
 	{
 		if (_scale != 0 && _scale == index + 1)
 		{
@@ -101,25 +101,14 @@ bool mutex::trylock() const {
 ///////////////////////////////////////////////////////////
 static const int kSpinCount = 1000;
 
-//! \brief does atomic swap
 #if OS_TYPE != OS_WIN32
-bool swap(int64_t compare, int64_t value, volatile int64_t* lock) {
-  int64_t prev;
-  __asm__ __volatile__ (
-"1: ldarx   %0,0,%2\n\
-    cmpw    0,%0,%3\n\
-    bne-    2f\n\
-    stdcx.  %4,0,%2\n\
-    bne-    1b\n\
-    2:"
-            : "=&r" (prev), "+m" (*lock)
-            : "r" (lock), "r" (compare), "r", (value)
-            : "cc");
-  return compare == prev;
+//! \brief does atomic compare and swap
+static inline bool swap(int64_t compare, int64_t value, volatile int64_t* lock) {
+  return __sync_bool_compare_and_swap(lock, compare, value);
 }
 
 //! \brief spin one round
-bool spin(volatile int64_t* lock) const {
+static inline bool spin(volatile int64_t* lock) {
   size_t count = kSpinCount;
   while (count > 0 && *lock != 0) {
     --count;
@@ -127,8 +116,8 @@ bool spin(volatile int64_t* lock) const {
   return *lock == 0;
 }
 
-//! \brief spin one round
-void nap() const {
+//! \brief sleeps a bit after unsuccessful spin
+static inline void nap() {
   const size_t kSleepTimeNs = 1000;
   struct timespec tm;
   tm.tv_sec = 0;
@@ -161,9 +150,9 @@ bool spinlock::lock() const {
 #if OS_TYPE == OS_WIN32
   EnterCriticalSection(&_handle);
 #else
-  while (!swap(0, 1, &_lock)) {
+  while (!swap(0, 1, &_handle)) {
     // spin CPU here
-    if (!spin()) {
+    if (!spin(&_handle)) {
       nap(); // long timeout
     }
   }
@@ -177,7 +166,7 @@ void spinlock::unlock() const {
 #if OS_TYPE == OS_WIN32
 	LeaveCriticalSection(&_handle); 
 #else
-  swap(1, 0, &_lock);
+  swap(1, 0, &_handle);
 #endif
 }
 
@@ -187,7 +176,7 @@ bool spinlock::trylock() const {
 #if OS_TYPE == OS_WIN32
 	return TRUE == TryEnterCriticalSection(&_handle);
 #else
-  return swap(0, 1, &_lock);
+  return swap(0, 1, &_handle);
 #endif
 }
 
@@ -282,7 +271,7 @@ size_t event::wait(size_t timeoutMs) const {
 	// adjusts signaled member
 	switch (ret) {
 		case 0: // success
-			if (!_handle._manual_reset) {
+			if (!_handle._manualReset) {
 				_handle._signaled = false;
       }
 			return WAIT_OBJECT_0;
@@ -307,8 +296,8 @@ semaphore::semaphore(size_t initialCount, size_t maxCount) {
 	_handle._cond = (pthread_cond_t*)malloc(sizeof(pthread_cond_t));
 	// creates condition thread
 	pthread_cond_init(_handle._cond, 0);
-	_handle._max_count = maxCount;
-	_handle._init_count = initialCount;
+	_handle._maxCount = maxCount;
+	_handle._initialCount = initialCount;
 #endif
 }
 
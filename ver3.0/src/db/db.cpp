@@ -411,6 +411,12 @@ dbserver_impl::dbserver_impl(size_t ident) :
 	_fetched_rows(0),
 	_forward(true),
 	_bulk_rows(100),
+	_fetch_rows(0),
+	_batch_bound(false),
+	_batch_end(false),
+	_batch_rows(0),
+	_batch_pos(0),
+	_statement_cache(0),
 	// query
 	_state(STATE_OK),
 	_action(ACTION_NONE),
@@ -1569,6 +1575,7 @@ dbserver_impl::fetch_data(bool async, size_t start_row, size_t num_rows, bool fo
 
 	_set_action(async ? ACTION_FETCH_ASYNC : ACTION_FETCH); // set action
 	_bind_columns(); 	// binds columns
+	_batch_bound = false;
 	_start_row = start_row; // stores starting row
 	_fetched_rows = 0;
 	_requested_rows = num_rows;
@@ -1584,6 +1591,122 @@ dbserver_impl::fetch_data(bool async, size_t start_row, size_t num_rows, bool fo
 	DB_CATCH // error processing
 }
 
+//
+// sets the number of rows per fetch round trip
+//
+bool 
+dbserver_impl::set_fetch_rows(size_t rows)
+{
+	mutexKeeper keeper(_mtx);
+	_fetch_rows = rows;
+	return true;
+}
+
+//
+// fetches rows straight into the column vectors
+//
+bool 
+dbserver_impl::fetch_batch(size_t max_rows, terimber_db_column* columns, size_t& rows)
+{
+	rows = 0;
+	DB_TRY // try block
+	_check_state(); 	// state must be OK
+	_check_open(); 	// if closed already - throws exception
+
+	size_t count_columns = _cols.size();
+	if (!columns && count_columns)
+		exception::_throw("Invalid batch columns");
+
+	// checks the caller vectors
+	for (size_t index = 0; index < count_columns; ++index)
+	{
+		terimber_db_column& column = columns[index];
+		if (!column.nulls
+			|| (_batch_value_size(_cols[index]._type) ? !column.values : (!column.offsets || !column.heap)))
+			exception::_throw("Invalid batch columns");
+
+		if (column.offsets)
+			column.offsets[0] = 0;
+	}
+
+	if (!_batch_bound)
+	{
+		// cleans up dataset
+		_data.clear();
+		_iter = get_iter_end();
+		_temp_allocator->reset();
+
+		_set_action(ACTION_FETCH); // set action
+		_bind_columns(); 	// binds columns once for all batches
+		_batch_bound = true;
+		_batch_end = false;
+		_batch_rows = 0;
+		_batch_pos = 0;
+	}
+
+	// values converted by the previous batch are copied already
+	_data_allocator->reset();
+
+	while (rows < max_rows)
+	{
+		if (STATE_INTERRUPTED == get_state()) // check interrupt
+			exception::_throw("Fetching process is interrupted");
+
+		if (_batch_pos == _batch_rows)
+		{
+			if (_batch_end)
+				break;
+
+			_batch_pos = 0;
+			if (!(_batch_rows = v_fetch_block()))
+			{
+				_batch_end = true;
+				break;
+			}
+		}
+
+		size_t count = __min(max_rows - rows, _batch_rows - _batch_pos);
+		size_t converted = count;
+
+		// converts column by column, heap can limit rows
+		for (size_t index = 0; index < count_columns && converted; ++index)
+			converted = v_convert_column(index, _batch_pos, converted, columns[index], rows);
+
+		if (!converted)
+		{
+			if (!rows)
+				exception::_throw("Batch heap is too small for the row");
+			break;
+		}
+
+		_batch_pos += converted;
+		rows += converted;
+
+		if (converted < count) // heap is full
+			break;
+	}
+	DB_CATCH // error processing
+}
+
+//
+// sets the number of cached prepared statements
+//
+bool 
+dbserver_impl::set_statement_cache(size_t size)
+{
+	DB_TRY // try block
+	_check_action(); // action must be NONE
+	_statement_cache = size;
+
+	// evicts the least recently used statements
+	while (_statements.size() > _statement_cache)
+	{
+		v_release_statement(_statements.back()._handle);
+		_statements.pop_back();
+	}
+	DB_CATCH
+}
+
 //
 // closes sql - frees allocated resources
 //
@@ -1604,6 +1727,7 @@ dbserver_impl::close_sql()
 	_fetched_rows = 0;
 	_forward = true;
 	_bulk_rows = 100;
+	_batch_bound = false;
 	_iter = get_iter_end();
 	
 	_sql_allocator.reset();
@@ -1702,6 +1826,205 @@ dbserver_impl::_rebind_params()
 	}
 }
 
+void*
+dbserver_impl::_take_statement()
+{
+	for (statement_cache_t::iterator iter = _statements.begin(); iter != _statements.end(); ++iter)
+	{
+		if (iter->_sql == _sql)
+		{
+			void* handle = iter->_handle;
+			// statement is in use until it is kept again
+			_statements.erase(iter);
+			return handle;
+		}
+	}
+
+	return 0;
+}
+
+bool
+dbserver_impl::_keep_statement(void* handle)
+{
+	if (!_statement_cache || !_sql.length())
+		return false;
+
+	prepared_statement item(_sql, handle);
+	if (_statements.push_front(item) == _statements.end())
+		return false;
+
+	// evicts the least recently used statement
+	if (_statements.size() > _statement_cache)
+	{
+		v_release_statement(_statements.back()._handle);
+		_statements.pop_back();
+	}
+
+	return true;
+}
+
+void
+dbserver_impl::_clear_statements()
+{
+	for (statement_cache_t::iterator iter = _statements.begin(); iter != _statements.end(); ++iter)
+		v_release_statement(iter->_handle);
+
+	_statements.clear();
+}
+
+// converts values one by one
+size_t
+dbserver_impl::v_convert_column(size_t index, size_t first_row, size_t rows, terimber_db_column& column, size_t offset)
+{
+	for (size_t row = 0; row < rows; ++row)
+	{
+		terimber_db_value val;
+		v_convert_one_value(first_row + row, index, val);
+		if (!_batch_put_value(column, index, offset + row, val))
+			return row;
+	}
+
+	return rows;
+}
+
+// static
+size_t
+dbserver_impl::_batch_value_size(dbtypes type)
+{
+	switch (type)
+	{
+		case db_bool:
+			return sizeof(bool);
+		case db_sb1:
+		case db_ub1:
+			return sizeof(ub1_t);
+		case db_sb2:
+		case db_ub2:
+			return sizeof(ub2_t);
+		case db_sb4:
+		case db_ub4:
+			return sizeof(ub4_t);
+		case db_float:
+			return sizeof(float);
+		case db_double:
+			return sizeof(double);
+		case db_sb8:
+		case db_ub8:
+		case db_date:
+			return sizeof(sb8_t);
+		case db_guid:
+			return sizeof(guid_t);
+		default:
+			return 0;
+	}
+}
+
+void
+dbserver_impl::_batch_put_null(terimber_db_column& column, size_t index, size_t row) const
+{
+	column.nulls[row] = true;
+
+	size_t size = _batch_value_size(_cols[index]._type);
+	if (size)
+		memset((ub1_t*)column.values + row * size, 0, size);
+	else
+		column.offsets[row + 1] = column.offsets[row];
+}
+
+void
+dbserver_impl::_batch_put_fixed(terimber_db_column& column, size_t index, size_t row, const void* value) const
+{
+	size_t size = _batch_value_size(_cols[index]._type);
+	column.nulls[row] = false;
+	memcpy((ub1_t*)column.values + row * size, value, size);
+}
+
+bool
+dbserver_impl::_batch_put_var(terimber_db_column& column, size_t row, const void* value, size_t len) const
+{
+	size_t start = column.offsets[row];
+	if (start + len > column.heap_size)
+		return false;
+
+	column.nulls[row] = false;
+	memcpy(column.heap + start, value, len);
+	column.offsets[row + 1] = start + len;
+	return true;
+}
+
+bool
+dbserver_impl::_batch_put_value(terimber_db_column& column, size_t index, size_t row, const terimber_db_value& val) const
+{
+	if (val.nullVal)
+	{
+		_batch_put_null(column, index, row);
+		return true;
+	}
+
+	switch (_cols[index]._type)
+	{
+		case db_bool:
+			_batch_put_fixed(column, index, row, &val.val.boolVal);
+			break;
+		case db_sb1:
+		case db_ub1:
+			_batch_put_fixed(column, index, row, &val.val.bVal);
+			break;
+		case db_sb2:
+		case db_ub2:
+			_batch_put_fixed(column, index, row, &val.val.uiVal);
+			break;
+		case db_sb4:
+		case db_ub4:
+			_batch_put_fixed(column, index, row, &val.val.ulVal);
+			break;
+		case db_float:
+			_batch_put_fixed(column, index, row, &val.val.fltVal);
+			break;
+		case db_double:
+#ifdef OS_64BIT
+			_batch_put_fixed(column, index, row, &val.val.dblVal);
+#else
+			_batch_put_fixed(column, index, row, val.val.dblVal);
+#endif
+			break;
+		case db_sb8:
+		case db_ub8:
+		case db_date:
+#ifdef OS_64BIT
+			_batch_put_fixed(column, index, row, &val.val.intVal);
+#else
+			_batch_put_fixed(column, index, row, val.val.intVal);
+#endif
+			break;
+		case db_guid:
+			_batch_put_fixed(column, index, row, val.val.guidVal);
+			break;
+		case db_string:
+			return _batch_put_var(column, row, val.val.strVal, strlen(val.val.strVal));
+		case db_wstring:
+			return _batch_put_var(column, row, val.val.wstrVal, wcslen(val.val.wstrVal) * sizeof(wchar_t));
+		case db_binary:
+			return _batch_put_var(column, row, val.val.bufVal + sizeof(size_t), *(const size_t*)val.val.bufVal);
+		case db_decimal:
+		case db_numeric:
+			{
+				numeric num(_data_allocator);
+				if (!num.parse_orcl(val.val.bufVal))
+					exception::_throw("Out of range");
+
+				size_t len = num.is_zero() ? 2 : num.precision() + (num.sign() ? 1 : 0) + (num.scale() ? 1 : 0) + (num.precision() == num.scale()) + 1;
+				char* text = (char*)check_pointer(_data_allocator->allocate(len));
+				num.format(text, '.');
+				return _batch_put_var(column, row, text, strlen(text));
+			}
+		default:
+			exception::_throw("Unsupported batch column type");
+	}
+
+	return true;
+}
+
 void
 dbserver_impl::_bind_columns()
 {
@@ -1722,7 +2045,8 @@ dbserver_impl::_bind_columns()
 
 	// estimates how many rows we can afford
 	// max memory ~ 1M, but < 1K rows
-	_bulk_rows = __max((size_t)1, __min((size_t)1024*1024 / total_memory_per_row, (size_t)1024));
+	// unless the caller has defined the batch size explicitly
+	_bulk_rows = _fetch_rows ? _fetch_rows : __max((size_t)1, __min((size_t)1024*1024 / total_memory_per_row, (size_t)1024));
 
 
 	// does some db specific before bind columns
@@ -1982,6 +2306,13 @@ dbserver_impl::param_bulk_remove_all()
 }
 
 
+//////////////////////////////////////////////////////////////
+prepared_statement::prepared_statement(const char* sql, void* handle) :
+	_sql(sql),
+	_handle(handle)
+{
+}
+
 //////////////////////////////////////////////////////////////
 // pool support
 //! \brief login constructor
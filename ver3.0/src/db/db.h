@@ -313,6 +313,24 @@ typedef _vector< binder > binders_t;
 //! \typedef bulk_params_t
 //! \brief list of binders
 typedef list< binders_t > bulk_params_t;
+//! \class prepared_statement
+//! \brief native statement handle prepared for sql text
+class prepared_statement
+{
+public:
+	//! \brief constructor
+	prepared_statement(const char* sql = 0,					//!< native sql text
+					void* handle = 0						//!< native statement handle
+					);
+
+public:
+	string_t				_sql;							//!< sql text
+	void*					_handle;						//!< native statement handle
+};
+
+//! \typedef statement_cache_t
+//! \brief prepared statements, the most recently used goes first
+typedef list< prepared_statement > statement_cache_t;
 //! \typedef recordset_list_t
 //! \brief list of rows with external allocator
 //! where row is a vector of db values
@@ -1007,6 +1025,23 @@ public:
 					size_t num_rows,						//!< rows to fetch
 					bool forward							//!< direction
 					);
+	//! \brief sets the number of rows per fetch round trip, 0 - default estimate
+	virtual
+	bool
+	set_fetch_rows(	size_t rows								//!< rows per round trip
+					);
+	//! \brief fetches the next rows straight into the column vectors
+	virtual
+	bool
+	fetch_batch(	size_t max_rows,						//!< max rows to fetch
+					terimber_db_column* columns,			//!< column vectors
+					size_t& rows							//!< [out] fetched rows
+					);
+	//! \brief sets the number of cached prepared statements, 0 - no cache
+	virtual
+	bool
+	set_statement_cache(size_t size							//!< max cached statements
+					);
 	//! \brief close sql - free allocated resources
 	virtual 
 	bool 
@@ -1293,6 +1328,27 @@ protected:
 	dbtypes 
 	v_native_type_to_client_type(size_t native_type			//!< SQL native type
 					) = 0;
+	//! \brief releases the native statement evicted from the statement cache
+	virtual 
+	void 
+	v_release_statement(void* handle						//!< native statement handle
+					) = 0;
+	//! \brief fetches the next block of rows into the bound column buffers
+	//! returns the number of rows in block, 0 - end of recordset
+	virtual 
+	size_t 
+	v_fetch_block() = 0;
+	//! \brief converts the column values of the fetched block to the batch column
+	//! returns the number of converted rows, less than rows if heap is full
+	//! the default implementation converts values one by one with v_convert_one_value
+	virtual 
+	size_t 
+	v_convert_column(size_t index,							//!< column index
+					size_t first_row,						//!< first row in fetched block
+					size_t rows,							//!< number of rows
+					terimber_db_column& column,				//!< batch column
+					size_t offset							//!< first row in batch column
+					);
 
 protected:
 	//! overrides function for employer class
@@ -1330,6 +1386,61 @@ protected:
 		mutexKeeper keeper(_mtx); 
 		return _state; 
 	}
+	//! \brief checks if the sql statement is executed for the stored bulk parameters
+	inline
+	bool
+	is_bulk_exec() const
+	{
+		action action_ = get_action();
+		return !_bulk_params.empty() && (action_ == ACTION_EXEC_SQL || action_ == ACTION_EXEC_SQL_ASYNC);
+	}
+	//! \brief takes the statement prepared for the current sql out of the statement cache
+	//! returns 0 if there is no such statement
+	void*
+	_take_statement();
+	//! \brief puts the statement prepared for the current sql to the statement cache
+	//! evicts the least recently used statement if the cache is full
+	//! returns false if cache is off, the caller must release the statement then
+	bool
+	_keep_statement(void* handle							//!< native statement handle
+					);
+	//! \brief releases all cached statements, must be called before disconnecting
+	void
+	_clear_statements();
+	//! \brief returns the size of fixed width batch value, 0 for variable width types
+	static
+	size_t
+	_batch_value_size(dbtypes type							//!< column type
+					);
+	//! \brief puts null to the batch column
+	void
+	_batch_put_null(terimber_db_column& column,				//!< batch column
+					size_t index,							//!< column index
+					size_t row								//!< row in batch column
+					) const;
+	//! \brief puts fixed width value to the batch column
+	void
+	_batch_put_fixed(terimber_db_column& column,			//!< batch column
+					size_t index,							//!< column index
+					size_t row,								//!< row in batch column
+					const void* value						//!< value of column type
+					) const;
+	//! \brief appends variable width value to the batch column heap
+	//! returns false if heap is full
+	bool
+	_batch_put_var(	terimber_db_column& column,				//!< batch column
+					size_t row,								//!< row in batch column
+					const void* value,						//!< value bytes
+					size_t len								//!< value length in bytes
+					) const;
+	//! \brief puts converted value to the batch column
+	//! returns false if heap is full
+	bool
+	_batch_put_value(terimber_db_column& column,			//!< batch column
+					size_t index,							//!< column index
+					size_t row,								//!< row in batch column
+					const terimber_db_value& val			//!< converted value
+					) const;
 
 private:
 	//! \brief makes sure the connection is established
@@ -1435,6 +1546,13 @@ protected:
 	size_t								_fetched_rows;		//!< actually fetched rows
 	bool								_forward;			//!< fetching direction
 	size_t								_bulk_rows;			//!< bulk rows for select
+	size_t								_fetch_rows;		//!< user defined bulk rows, 0 - estimate
+	statement_cache_t					_statements;		//!< prepared statements
+	bool								_batch_bound;		//!< columns are bound for batch fetch
+	bool								_batch_end;			//!< batch fetch reached the end of recordset
+	size_t								_batch_rows;		//!< rows in the fetched block
+	size_t								_batch_pos;			//!< next row in the fetched block
+	size_t								_statement_cache;	//!< max prepared statements, 0 - no cache
 private:
 	volatile module_state				_state;				//!< server state
 	volatile action						_action;			//!< server action
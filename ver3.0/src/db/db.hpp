@@ -25,6 +25,9 @@
  * ================================================================================
 */
 
+#ifndef _terimber_db_hpp_
+#define _terimber_db_hpp_
+
 #include "db/db.h"
 #include "base/numeric.h"
 
@@ -694,3 +697,6 @@ db_creator< T >::deactivate(db_entry* obj,							//!< object pointer
 
 #pragma pack()
 END_TERIMBER_NAMESPACE
+
+#endif // _terimber_db_hpp_
+
@@ -49,6 +49,24 @@ public:
 					) = 0;
 };
 
+//! \class terimber_db_column
+//! \brief caller provided column vector filled by the batch fetch
+//! fixed width columns are written to the values array, the element type follows get_column_type
+//! bool, sb1_t, ub1_t, sb2_t, ub2_t, sb4_t, ub4_t, float, double, sb8_t, ub8_t, 
+//! sb8_t milliseconds for db_date and guid_t for db_guid
+//! variable width columns are appended to the heap, row i takes heap bytes from offsets[i] to offsets[i + 1]
+//! strings are not zero terminated, wide strings are stored as wchar_t, 
+//! decimal and numeric values are stored as text with '.' delimeter
+class terimber_db_column
+{
+public:
+	void*					values;							//!< fixed width values, one per row
+	bool*					nulls;							//!< null flags, one per row
+	size_t*					offsets;						//!< heap offsets for variable width columns, one per row plus one
+	ub1_t*					heap;							//!< heap for variable width columns
+	size_t					heap_size;						//!< heap capacity in bytes
+};
+
 //! \class dbserver
 //! \brief class implements the access to database in the general way
 class dbserver : public terimber_log_helper
@@ -712,6 +730,31 @@ public:
 					size_t num_rows,						//!< number of rows to fetch
 					bool forward							//!< direction
 					) = 0;
+	//! \brief sets the number of rows transferred from the database per fetch round trip
+	//! 0 restores the default, estimated from the row size on every fetch
+	//! the setting survives close_sql and applies to the next fetch_data call
+	virtual
+	bool
+	set_fetch_rows(	size_t rows								//!< rows per round trip, 0 - default
+					) = 0;
+	//! \brief fetches the next rows of the opened recordset straight into the caller column vectors
+	//! columns array must have get_column_count() items, rows are always put from the first position
+	//! the recordset is read forward only, rows fetched by fetch_data are not returned again
+	//! fetches less than max_rows at the end of recordset or if any heap is full,
+	//! the rest rows are returned by the next call, 0 rows means the end of recordset
+	virtual
+	bool
+	fetch_batch(	size_t max_rows,						//!< max rows to fetch
+					terimber_db_column* columns,			//!< column vectors
+					size_t& rows							//!< [out] fetched rows
+					) = 0;
+	//! \brief sets the number of prepared statements kept by the connection
+	//! statements are found by sql text and reused instead of being prepared again
+	//! 0 turns the cache off, it is the default
+	virtual
+	bool
+	set_statement_cache(size_t size							//!< max cached statements
+					) = 0;
 	//! \brief closes sql - free allocated resources
 	virtual 
 	bool 
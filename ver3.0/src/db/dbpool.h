@@ -0,0 +1,162 @@
+/*
+ * The Software License
+ * =================================================================================
+ * Copyright (c) 2003-2010 The Terimber Corporation. All rights reserved.
+ * =================================================================================
+ * Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * The end-user documentation included with the redistribution, if any, 
+ * must include the following acknowledgment:
+ * "This product includes software developed by the Terimber Corporation."
+ * =================================================================================
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, 
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  
+ * IN NO EVENT SHALL THE TERIMBER CORPORATION OR ITS CONTRIBUTORS BE LIABLE FOR 
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON 
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ================================================================================
+*/
+
+#ifndef _terimber_dbpool_h_
+#define _terimber_dbpool_h_
+
+#include "db/db.h"
+#include "base/keymaker.h"
+#include "threadpool/timer.h"
+
+BEGIN_TERIMBER_NAMESPACE
+#pragma pack(4)
+
+//! \class dbserver_pool
+//! \brief shared pool of connected db servers
+//! keeps at least min connections open, never loans more than max connections,
+//! checks idle connections and closes the ones idle for too long
+//! creator C must be db_creator based, for instance mysql_db_creator
+template < class C >
+class dbserver_pool : public timer_callback
+{
+public:
+	//! \typedef TYPE
+	//! \brief type of pool entry
+	typedef TYPENAME C::TYPE TYPE;
+	//! \typedef ARG
+	//! \brief login argument
+	typedef TYPENAME C::ARG ARG;
+private:
+	//! \class dbserver_pool_entry
+	//! \brief pool entry with usage times
+	//! we can't remove internal class into hpp file
+	//! Microsoft specific
+	class dbserver_pool_entry
+	{
+		//! \friend dbserver_pool< C >
+		//! \brief gives pool full access
+		friend class dbserver_pool< C >;
+	public:
+		//! \brief constructor 
+		dbserver_pool_entry(TYPE* obj						//!< pointer to entry
+					) : 
+			_obj(obj), 
+			_rest(0),
+			_checked(0)
+		{
+		}
+
+	private:
+		TYPE*			_obj;								//!< db server entry
+		sb8_t			_rest;								//!< when entry was given back last time
+		sb8_t			_checked;							//!< when connection was checked last time
+	};
+
+	//! \typedef list_entry_t
+	//! \brief keeps the pool entries as a list
+	typedef list< dbserver_pool_entry > list_entry_t;
+
+public:
+	//! \brief constructor
+	//! opens min connections at once
+	dbserver_pool< C >(const ARG& arg,						//!< login argument
+					size_t min_connections,					//!< connections kept open
+					size_t max_connections,					//!< max connections loaned at the same time
+					size_t max_idle,						//!< max time in milliseconds connection above min can be idle
+					size_t check_interval,					//!< interval in milliseconds to check idle connections
+					size_t statement_cache					//!< prepared statements cached per connection, 0 - no cache
+					);
+	//! \brief destructor
+	~dbserver_pool< C >();
+	//! \brief loans the connected server within specified timeout
+	//! returns 0 if timeout is expired or connection failed
+	dbserver* 
+	loan(			size_t timeout							//!< timeout in milliseconds
+					);
+	//! \brief returns server back to pool
+	//! rolls back the transaction and closes sql if any
+	void 
+	give_back(		dbserver* obj							//!< server loaned from pool
+					);
+	//! \brief closes all connections
+	void 
+	clear();
+	//! \brief gets statistics
+	void 
+	get_stats(		size_t& free_connections,				//!< idle connections
+					size_t& busy_connections				//!< loaned connections
+					) const;
+
+protected:
+	//! timer_callback
+	//! \brief checks idle connections periodically
+	virtual 
+	void 
+	notify(			size_t ident,							//!< timer ident
+					size_t interval,						//!< repeatition interval in milliseconds
+					size_t multiplier						//!< multiplier coefficient for repeatition interval 
+					);
+
+private:
+	//! \brief creates the new connected entry
+	//! returns 0 if connection failed
+	TYPE* 
+	create_entry();
+	//! \brief checks connection, reconnects if it's broken
+	//! returns false if connection can't be restored
+	bool 
+	check_entry(	TYPE* obj								//!< pool entry
+					);
+	//! \brief closes connections idle for too long above min
+	void 
+	reap_idle();
+	//! \brief checks connections idle longer than check interval
+	void 
+	check_idle();
+	//! \brief opens connections up to min
+	void 
+	fill_min();
+
+private:
+	ARG						_arg;							//!< login argument
+	size_t					_min_connections;				//!< connections kept open
+	size_t					_max_idle;						//!< max idle time in milliseconds
+	size_t					_check_interval;				//!< check interval in milliseconds
+	size_t					_statement_cache;				//!< prepared statements per connection
+	keylocker				_locker;						//!< limits loaned connections
+	mutex					_mtx;							//!< controls multithreaded access to pool
+	list_entry_t			_busy_objects;					//!< loaned connections
+	list_entry_t			_free_objects;					//!< idle connections, the most recent goes first
+	size_t					_pending;						//!< connections being opened or checked by maintenance
+	timer					_timer;							//!< maintenance timer
+};
+
+#pragma pack()
+END_TERIMBER_NAMESPACE
+
+#endif // _terimber_dbpool_h_
+
@@ -0,0 +1,372 @@
+/*
+ * The Software License
+ * =================================================================================
+ * Copyright (c) 2003-2010 The Terimber Corporation. All rights reserved.
+ * =================================================================================
+ * Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * The end-user documentation included with the redistribution, if any, 
+ * must include the following acknowledgment:
+ * "This product includes software developed by the Terimber Corporation."
+ * =================================================================================
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, 
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  
+ * IN NO EVENT SHALL THE TERIMBER CORPORATION OR ITS CONTRIBUTORS BE LIABLE FOR 
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON 
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ================================================================================
+*/
+
+#ifndef _terimber_dbpool_hpp_
+#define _terimber_dbpool_hpp_
+
+#include "db/dbpool.h"
+#include "db/db.hpp"
+#include "base/list.hpp"
+#include "base/memory.hpp"
+
+BEGIN_TERIMBER_NAMESPACE
+#pragma pack(4)
+
+// constructor
+template < class C >
+dbserver_pool< C >::dbserver_pool(const ARG& arg, size_t min_connections, size_t max_connections, size_t max_idle, size_t check_interval, size_t statement_cache) :
+	_arg(arg),
+	_min_connections(__min(min_connections, max_connections)),
+	_max_idle(max_idle),
+	_check_interval(check_interval),
+	_statement_cache(statement_cache),
+	_locker(max_connections ? max_connections : 1),
+	_busy_objects(64),
+	_free_objects(64),
+	_pending(0)
+{
+	// opens min connections
+	fill_min();
+
+	if (_check_interval)
+		_timer.activate(this, 0, _check_interval);
+}
+
+// destructor
+template < class C >
+dbserver_pool< C >::~dbserver_pool()
+{
+	// stops maintenance first
+	_timer.deactivate();
+	clear();
+}
+
+template < class C >
+dbserver* 
+dbserver_pool< C >::loan(size_t timeout)
+{
+	// waits for availability
+	if (!_locker.enter(timeout))
+		return 0;
+
+	TYPE* obj = 0;
+	// locks mutex
+	mutexKeeper guard(_mtx);
+
+	if (!_free_objects.empty()) // has idle connection
+	{
+		date now;
+		sb8_t deadline = now;
+		deadline -= _check_interval;
+
+		// gets the most recent connection
+		dbserver_pool_entry entry = _free_objects.front();
+		_free_objects.pop_front();
+		obj = entry._obj;
+
+		// connection idle for too long must be checked before loaning
+		bool check = entry._checked <= deadline;
+		if (check)
+			entry._checked = now;
+
+		_busy_objects.push_back(entry);
+		guard.unlock();
+
+		if (check && !check_entry(obj))
+		{
+			guard.lock();
+			for (TYPENAME list_entry_t::iterator it_busy = _busy_objects.begin(); it_busy != _busy_objects.end(); ++it_busy)
+			{
+				if (it_busy->_obj == obj)
+				{
+					_busy_objects.erase(it_busy);
+					break;
+				}
+			}
+			guard.unlock();
+
+			C::destroy(obj, _arg);
+			obj = 0;
+		}
+	}
+	else // opens a new connection
+	{
+		guard.unlock();
+
+		if ((obj = create_entry()))
+		{
+			dbserver_pool_entry entry(obj);
+			date now;
+			entry._checked = now;
+			guard.lock();
+			_busy_objects.push_back(entry);
+			guard.unlock();
+		}
+	}
+
+	if (!obj)
+	{
+		_locker.leave(); // leaves gate
+		return 0;
+	}
+
+	return obj->_obj;
+}
+
+template < class C >
+void 
+dbserver_pool< C >::give_back(dbserver* obj)
+{
+	if (!obj)
+		return;
+
+	// locks mutex
+	mutexKeeper guard(_mtx);
+
+	for (TYPENAME list_entry_t::iterator it_busy = _busy_objects.begin(); it_busy != _busy_objects.end(); ++it_busy)
+	{
+		if (it_busy->_obj->_obj == obj) // found
+		{
+			dbserver_pool_entry entry = *it_busy;
+			_busy_objects.erase(it_busy);
+			++_pending;
+			guard.unlock();
+
+			// rolls back transaction and closes sql out of lock
+			C::back(entry._obj, _arg);
+
+			date now;
+			entry._rest = now;
+			guard.lock();
+			--_pending;
+			_free_objects.push_front(entry);
+			guard.unlock();
+			_locker.leave(); // releases locker
+			return;
+		}
+	}
+
+	assert(false); // tries to return connection that is not in pool
+}
+
+template < class C >
+void 
+dbserver_pool< C >::clear()
+{
+	// locks mutex
+	mutexKeeper guard(_mtx);
+
+	while (!_busy_objects.empty())
+	{
+		C::destroy(_busy_objects.front()._obj, _arg);
+		_busy_objects.pop_front();
+	}
+
+	while (!_free_objects.empty())
+	{
+		C::destroy(_free_objects.front()._obj, _arg);
+		_free_objects.pop_front();
+	}
+}
+
+template < class C >
+void 
+dbserver_pool< C >::get_stats(size_t& free_connections, size_t& busy_connections) const
+{
+	// locks mutex
+	mutexKeeper guard(_mtx);
+	free_connections = _free_objects.size();
+	busy_connections = _busy_objects.size();
+}
+
+// virtual 
+template < class C >
+void 
+dbserver_pool< C >::notify(size_t ident, size_t interval, size_t multiplier)
+{
+	reap_idle();
+	check_idle();
+	fill_min();
+}
+
+template < class C >
+TYPENAME dbserver_pool< C >::TYPE* 
+dbserver_pool< C >::create_entry()
+{
+	TYPE* obj = C::create(_arg);
+	if (!obj)
+		return 0;
+
+	C::activate(obj, _arg);
+	if (!obj->_obj->is_connect())
+	{
+		C::destroy(obj, _arg);
+		return 0;
+	}
+
+	if (_statement_cache)
+		obj->_obj->set_statement_cache(_statement_cache);
+
+	return obj;
+}
+
+template < class C >
+bool 
+dbserver_pool< C >::check_entry(TYPE* obj)
+{
+	if (obj->_obj->is_connect_alive())
+		return true;
+
+	// reconnects broken connection
+	C::deactivate(obj, _arg);
+	C::activate(obj, _arg);
+	return obj->_obj->is_connect();
+}
+
+template < class C >
+void 
+dbserver_pool< C >::reap_idle()
+{
+	if (!_max_idle)
+		return;
+
+	list_entry_t reaped;
+	// locks mutex
+	mutexKeeper guard(_mtx);
+
+	date now;
+	sb8_t deadline = now;
+	deadline -= _max_idle;
+	size_t total = _free_objects.size() + _busy_objects.size() + _pending;
+
+	for (TYPENAME list_entry_t::iterator it_free = _free_objects.begin(); it_free != _free_objects.end() && total > _min_connections;)
+	{
+		if (it_free->_rest > deadline)
+			++it_free;
+		else
+		{
+			reaped.push_back(*it_free);
+			it_free = _free_objects.erase(it_free);
+			--total;
+		}
+	}
+
+	guard.unlock();
+
+	// disconnects out of lock
+	for (TYPENAME list_entry_t::iterator it_reaped = reaped.begin(); it_reaped != reaped.end(); ++it_reaped)
+		C::destroy(it_reaped->_obj, _arg);
+}
+
+template < class C >
+void 
+dbserver_pool< C >::check_idle()
+{
+	date now;
+	sb8_t deadline = now;
+	deadline -= _check_interval;
+
+	// checked connection is counted as loaned one
+	// skips checking if all connections are loaned, keylocker doesn't try with zero timeout
+	while (_locker.enter(1))
+	{
+		// locks mutex
+		mutexKeeper guard(_mtx);
+
+		TYPENAME list_entry_t::iterator it_free = _free_objects.begin();
+		for (; it_free != _free_objects.end(); ++it_free)
+			if (it_free->_checked <= deadline)
+				break;
+
+		if (it_free == _free_objects.end())
+		{
+			guard.unlock();
+			_locker.leave();
+			break;
+		}
+
+		dbserver_pool_entry entry = *it_free;
+		_free_objects.erase(it_free);
+		++_pending;
+		guard.unlock();
+
+		bool alive = check_entry(entry._obj);
+
+		guard.lock();
+		--_pending;
+		if (alive)
+		{
+			entry._checked = now;
+			_free_objects.push_back(entry);
+			guard.unlock();
+		}
+		else
+		{
+			guard.unlock();
+			C::destroy(entry._obj, _arg);
+		}
+
+		_locker.leave();
+	}
+}
+
+template < class C >
+void 
+dbserver_pool< C >::fill_min()
+{
+	while (true)
+	{
+		// locks mutex
+		mutexKeeper guard(_mtx);
+		if (_free_objects.size() + _busy_objects.size() + _pending >= _min_connections)
+			break;
+
+		++_pending;
+		guard.unlock();
+
+		// connects out of lock
+		TYPE* obj = create_entry();
+
+		guard.lock();
+		--_pending;
+
+		if (!obj)
+			break;
+
+		dbserver_pool_entry entry(obj);
+		date now;
+		entry._rest = now;
+		entry._checked = now;
+		_free_objects.push_back(entry);
+	}
+}
+
+#pragma pack()
+END_TERIMBER_NAMESPACE
+
+#endif // _terimber_dbpool_hpp_
+
@@ -52,7 +52,8 @@ static const char* valid_delimeters = " ,)}";
 static const size_t defaultBlobSize = 1024 * 64;
 
 mysql_dbserver::mysql_dbserver(size_t ident) : dbserver_impl(ident),
-	_desc(0), _stmt(0)
+	_desc(0), _stmt(0), _bulk_stmt_rows(0), _bulk_sql(&_sql_allocator), _bulk_values_begin(0), _bulk_values_end(0),
+	_block(0), _block_rows(0), _block_row_size(0)
 {
 }
 
@@ -106,6 +107,7 @@ mysql_dbserver::v_disconnect()
 	_temp_allocator->clear_extra();
 
 	v_close();
+	_clear_statements();
 
 	if (_desc)
 	{
@@ -143,14 +145,18 @@ mysql_dbserver::v_is_connect_alive()
 	if (!_is_connect())
 		return false;
 
-	return true;
+	// round trip to server
+	return mysql_ping(_desc) == 0;
 }
 
 ///////////////////////////
 void
 mysql_dbserver::v_before_execute()
 {
-	check_retcode_db((_stmt = mysql_stmt_init(_desc)) != 0)
+	// bulk statements are rewritten, so they are never shared
+	bool prepared = !is_bulk_exec() && (_stmt = (MYSQL_STMT*)_take_statement()) != 0;
+	if (!prepared)
+		check_retcode_db((_stmt = mysql_stmt_init(_desc)) != 0)
 
 	switch (get_action())
 	{
@@ -158,6 +164,12 @@ mysql_dbserver::v_before_execute()
 		case ACTION_EXEC_SQL_ASYNC:
 		case ACTION_EXEC_PROC:
 		case ACTION_EXEC_PROC_ASYNC:
+			if (prepared)
+			{
+				// cached statement could be opened with cursor before
+				const unsigned long type = CURSOR_TYPE_NO_CURSOR;
+				check_retcode(mysql_stmt_attr_set(_stmt, STMT_ATTR_CURSOR_TYPE, &type) == 0);
+			}
 			break;
 		case ACTION_OPEN_SQL:
 		case ACTION_OPEN_SQL_ASYNC:
@@ -172,7 +184,32 @@ mysql_dbserver::v_before_execute()
 			break;
 	} // switch
 
-	check_retcode(mysql_stmt_prepare(_stmt, (const char*)_sql, (unsigned long)_sql.length()) == 0)
+	// bulk parameters are executed by blocks
+	_bulk_stmt_rows = 0;
+	if (is_bulk_exec())
+	{
+		size_t count_params = _params.size();
+		if (find_bulk_values(_bulk_values_begin, _bulk_values_end))
+		{
+			// rewrites insert to the multi-row values
+			// prepared statement can't have more than 65535 placeholders
+			_bulk_sql = _sql;
+			_bulk_stmt_rows = __max((size_t)1, __min(_bulk_params.size(), (size_t)65535 / count_params));
+			form_bulk_sql(_bulk_stmt_rows);
+			_param_binders.resize(*_columns_allocator, _bulk_stmt_rows * count_params);
+		}
+		else // executes statement for each bulk row
+			_bulk_stmt_rows = 1;
+	}
+
+	if (!prepared && mysql_stmt_prepare(_stmt, (const char*)_sql, (unsigned long)_sql.length()) != 0)
+	{
+		// statement that failed to prepare must not go to the cache
+		exception x(mysql_stmt_errno(_stmt), mysql_stmt_error(_stmt));
+		mysql_stmt_close(_stmt);
+		_stmt = 0;
+		throw x;
+	}
 }
 
 void
@@ -215,7 +252,46 @@ mysql_dbserver::v_execute()
 			break;
 	}
 
-	check_retcode(mysql_stmt_execute(_stmt) == 0)
+	if (_bulk_stmt_rows)
+		execute_bulk();
+	else
+		check_retcode(mysql_stmt_execute(_stmt) == 0)
+}
+
+// executes the statement for all bulk parameters
+void
+mysql_dbserver::execute_bulk()
+{
+	size_t count_params = _params.size();
+	size_t bound_rows = _bulk_stmt_rows;
+	size_t rest = _bulk_params.size();
+	bulk_params_t::iterator iter = _bulk_params.begin();
+
+	while (rest)
+	{
+		if (STATE_INTERRUPTED == get_state()) // check interrupt
+			exception::_throw("Executing process is interrupted");
+
+		size_t rows = __min(bound_rows, rest);
+
+		// the last incomplete block requires the shorter statement
+		if (rows != bound_rows)
+		{
+			form_bulk_sql(rows);
+			check_retcode(mysql_stmt_prepare(_stmt, (const char*)_sql, (unsigned long)_sql.length()) == 0)
+			bound_rows = rows;
+		}
+
+		// binds the block of rows one by one
+		for (size_t row = 0; row < rows; ++row, ++iter)
+			for (size_t index = 0; index < count_params; ++index)
+				bind_one_value((*iter)[index], _param_binders[row * count_params + index]);
+
+		check_retcode(mysql_stmt_bind_param(_stmt, &_param_binders[0]) == 0)
+		check_retcode(mysql_stmt_execute(_stmt) == 0)
+
+		rest -= rows;
+	}
 }
 
 // closes opened query
@@ -225,7 +301,12 @@ mysql_dbserver::v_close()
 	if (_stmt)
 	{
 		mysql_stmt_free_result(_stmt);
-		mysql_stmt_close(_stmt);
+		// keeps the prepared statement for the next execution of the same sql
+		if (_bulk_stmt_rows 
+			|| !_statement_cache
+			|| mysql_stmt_reset(_stmt) != 0
+			|| !_keep_statement(_stmt))
+			mysql_stmt_close(_stmt);
 		_stmt = 0;
 	}
 
@@ -233,6 +314,20 @@ mysql_dbserver::v_close()
 	// destroys binders
 	_param_binders.clear();
 	_column_binders.clear();
+
+	_bulk_stmt_rows = 0;
+	_bulk_sql = 0;
+
+	_block = 0;
+	_block_rows = 0;
+	_block_offsets.clear();
+}
+
+// releases the cached statement
+void
+mysql_dbserver::v_release_statement(void* handle)
+{
+	mysql_stmt_close((MYSQL_STMT*)handle);
 }
 
 // Fetches block rows
@@ -244,7 +339,7 @@ mysql_dbserver::v_fetch()
 	{
 		v_execute();
 		size_t skip_rows = 0;
-		while (skip_rows++ < _start_row && mysql_stmt_fetch(_stmt));
+		while (skip_rows++ < _start_row && !mysql_stmt_fetch(_stmt));
 	}
 
 	// defines the column count
@@ -284,6 +379,169 @@ mysql_dbserver::v_fetch()
 	_fetched_rows = select_row;
 }
 
+// fetches the next block of rows
+// mysql binds one row, so the rows are copied from the bound buffers to the block one by one
+// the prefetch attribute controls the network round trips
+size_t
+mysql_dbserver::v_fetch_block()
+{
+	if (!_block_rows)
+		prepare_block();
+
+	size_t col_count = _cols.size();
+	size_t rows = 0;
+	for (; rows < _block_rows; ++rows)
+	{
+		int x = mysql_stmt_fetch(_stmt);
+		if (x == MYSQL_NO_DATA)
+			break;
+
+		check_retcode(x == 0)
+
+		if (!_block) // one row is bound
+		{
+			++rows;
+			break;
+		}
+
+		ub1_t* slot_row = _block + rows * _block_row_size;
+		for (size_t index = 0; index < col_count; ++index)
+		{
+			const binder& cur = _cols[index];
+			ub1_t* slot = slot_row + _block_offsets[index];
+			size_t length = os_minus_one; // null
+			if (!cur._value.nullVal && cur._real_length)
+			{
+				switch (cur._native_type)
+				{
+					case MYSQL_TYPE_DECIMAL: // decimal is bound as text
+						length = strlen((const char*)cur._bind_buffer);
+						break;
+					case MYSQL_TYPE_ENUM:
+					case MYSQL_TYPE_SET:
+					case MYSQL_TYPE_VAR_STRING:
+					case MYSQL_TYPE_STRING:
+					case MYSQL_TYPE_GEOMETRY:
+						length = __min(cur._real_length, cur._max_length);
+						break;
+					default:
+						length = cur._max_length;
+						break;
+				}
+
+				memcpy(slot + sizeof(size_t), cur._bind_buffer, length);
+			}
+
+			*(size_t*)slot = length;
+		}
+	}
+
+	return rows;
+}
+
+// copies the column value straight from the block
+size_t
+mysql_dbserver::v_convert_column(size_t index, size_t first_row, size_t rows, terimber_db_column& column, size_t offset)
+{
+	const binder& cur = _cols[index];
+	switch (cur._native_type)
+	{
+		case MYSQL_TYPE_TINY_BLOB:
+		case MYSQL_TYPE_MEDIUM_BLOB:
+		case MYSQL_TYPE_LONG_BLOB:
+		case MYSQL_TYPE_BLOB: // blobs are converted one by one
+			return dbserver_impl::v_convert_column(index, first_row, rows, column, offset);
+	}
+
+	for (size_t row = 0; row < rows; ++row)
+	{
+		size_t length = 0;
+		const ub1_t* value = block_value(index, first_row + row, length);
+		if (!value)
+		{
+			_batch_put_null(column, index, offset + row);
+			continue;
+		}
+
+		switch (cur._native_type)
+		{
+			case MYSQL_TYPE_TIMESTAMP: 
+			case MYSQL_TYPE_DATE: 
+			case MYSQL_TYPE_DATETIME: 
+			case MYSQL_TYPE_TIME: 
+			case MYSQL_TYPE_YEAR: 
+			case MYSQL_TYPE_NEWDATE:
+				{
+					const MYSQL_TIME* ptds = (const MYSQL_TIME*)value;
+					sb8_t dummy64;
+					date::convert_to(ptds->year, (ub1_t)ptds->month, (ub1_t)ptds->day, (ub1_t)ptds->hour, (ub1_t)ptds->minute, (ub1_t)ptds->second, (ub2_t)ptds->second_part, dummy64);
+					_batch_put_fixed(column, index, offset + row, &dummy64);
+				}
+				break;
+			default:
+				if (_batch_value_size(cur._type))
+					_batch_put_fixed(column, index, offset + row, value);
+				else if (!_batch_put_var(column, offset + row, value, length))
+					return row;
+				break;
+		}
+	}
+
+	return rows;
+}
+
+void
+mysql_dbserver::prepare_block()
+{
+	size_t col_count = _cols.size();
+	size_t row_size = 0;
+
+	if (col_count)
+		_block_offsets.resize(*_columns_allocator, col_count);
+
+	for (size_t index = 0; index < col_count; ++index)
+	{
+		const binder& cur = _cols[index];
+		switch (cur._native_type)
+		{
+			case MYSQL_TYPE_TINY_BLOB:
+			case MYSQL_TYPE_MEDIUM_BLOB:
+			case MYSQL_TYPE_LONG_BLOB:
+			case MYSQL_TYPE_BLOB:
+				_block = 0;
+				_block_rows = 1;
+				return;
+		}
+
+		// length is followed by value, aligned by size_t
+		_block_offsets[index] = row_size;
+		row_size += sizeof(size_t) + (cur._max_length + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t);
+	}
+
+	// keeps the block below 1M as _bind_columns does for the bound buffers
+	_block_row_size = __max(row_size, (size_t)1);
+	_block_rows = __max((size_t)1, __min(_bulk_rows, (size_t)1024*1024 / _block_row_size));
+	_block = (ub1_t*)check_pointer(_temp_allocator->allocate(_block_rows * _block_row_size));
+}
+
+const ub1_t*
+mysql_dbserver::block_value(size_t index, size_t row, size_t& length) const
+{
+	if (!_block) // one row is bound
+	{
+		const binder& cur = _cols[index];
+		if (cur._value.nullVal || !cur._real_length)
+			return 0;
+
+		length = cur._native_type == MYSQL_TYPE_DECIMAL ? strlen((const char*)cur._bind_buffer) : cur._real_length;
+		return (const ub1_t*)cur._bind_buffer;
+	}
+
+	const ub1_t* slot = _block + row * _block_row_size + _block_offsets[index];
+	length = *(const size_t*)slot;
+	return length == os_minus_one ? 0 : slot + sizeof(size_t);
+}
+
 // replaces quote to available sign for native drive
 void
 mysql_dbserver::v_replace_quote()
@@ -342,9 +600,24 @@ mysql_dbserver::v_replace_quote()
 void
 mysql_dbserver::v_bind_one_param(size_t index)
 {
-	binder& cur = _params[index];
+	// bulk parameters are bound by blocks during execution
+	if (_bulk_stmt_rows)
+		return;
+
+	bind_one_value(_params[index], _param_binders[index]);
 
-	MYSQL_BIND& mysql_binder = _param_binders[index];
+	// is it the last one?
+	if (_params.size() == index + 1)
+	{
+		check_retcode(mysql_stmt_bind_param(_stmt, &_param_binders[0]) == 0)
+	}
+}
+
+// fills mysql binder for the parameter value
+void
+mysql_dbserver::bind_one_value(binder& cur, MYSQL_BIND& mysql_binder)
+{
+	memset(&mysql_binder, 0, sizeof(MYSQL_BIND));
 	mysql_binder.is_unsigned = 1;
 
 	mysql_binder.is_null = (char*)&cur._value.nullVal;
@@ -371,7 +644,7 @@ mysql_dbserver::v_bind_one_param(size_t index)
 		case db_ub2:
 			cur._max_length = sizeof(ub2_t);
 			mysql_binder.buffer_length = (unsigned long)(cur._real_length = cur._value.nullVal ? 0 : cur._max_length);	
-			cur._bind_buffer = cur._type == db_sb2 ? (void*)&(cur._value.val.iVal) : (void*)&(cur._value.val.uiVal); // set value
+			mysql_binder.buffer = cur._bind_buffer = cur._type == db_sb2 ? (void*)&(cur._value.val.iVal) : (void*)&(cur._value.val.uiVal); // set value
 			cur._native_type = mysql_binder.buffer_type = MYSQL_TYPE_SHORT;
 			break;	
 		case db_sb4: 
@@ -556,12 +829,112 @@ mysql_dbserver::v_bind_one_param(size_t index)
 			exception::_throw("Unsupported parameter type");
 			assert(false);
 	}
+}
 
-	// is it the last one?
-	if (_params.size() == index + 1)
+// finds the values tuple of the insert statement
+bool
+mysql_dbserver::find_bulk_values(size_t& begin, size_t& end) const
+{
+	const char* sql = _sql;
+	const char* ptr = sql;
+
+	// skips leading spaces
+	while (*ptr && isspace((unsigned char)*ptr))
+		++ptr;
+
+	if (str_template::strnocasecmp(ptr, "insert", 6))
+		return false;
+
+	// looks for the values keyword outside of the quoted names and strings
+	const char* values = 0;
+	char quote = 0;
+	for (; *ptr && !values; ++ptr)
 	{
-		check_retcode(mysql_stmt_bind_param(_stmt, &_param_binders[0]) == 0)
+		if (quote)
+		{
+			if (*ptr == quote)
+				quote = 0;
+		}
+		else if (*ptr == '\'' || *ptr == '"' || *ptr == '`')
+			quote = *ptr;
+		else if (*ptr == '?') // insert ... select
+			return false;
+		else if ((ptr == sql || (!isalnum((unsigned char)ptr[-1]) && ptr[-1] != '_'))
+			&& !str_template::strnocasecmp(ptr, "values", 6)
+			&& !isalnum((unsigned char)ptr[6]) && ptr[6] != '_')
+			values = ptr + 6;
+	}
+
+	if (!values)
+		return false;
+
+	while (*values && isspace((unsigned char)*values))
+		++values;
+
+	if (*values != '(')
+		return false;
+
+	// finds the closing bracket and counts parameters
+	size_t depth = 0;
+	size_t count_params = 0;
+	for (ptr = values; *ptr; ++ptr)
+	{
+		if (quote)
+		{
+			if (*ptr == quote)
+				quote = 0;
+		}
+		else if (*ptr == '\'' || *ptr == '"' || *ptr == '`')
+			quote = *ptr;
+		else if (*ptr == '?')
+			++count_params;
+		else if (*ptr == '(')
+			++depth;
+		else if (*ptr == ')' && --depth == 0)
+			break;
 	}
+
+	// the tuple must have all parameters, on duplicate key update with parameters can't be repeated
+	if (!*ptr || count_params != _params.size() || strchr(ptr, '?'))
+		return false;
+
+	begin = values - sql;
+	end = ptr + 1 - sql;
+	return true;
+}
+
+// rewrites the insert statement for the specified number of tuples
+void
+mysql_dbserver::form_bulk_sql(size_t rows)
+{
+	const char* source = _bulk_sql;
+	size_t tuple = _bulk_values_end - _bulk_values_begin;
+	size_t tail = _bulk_sql.length() - _bulk_values_end;
+
+	char* buf = (char*)check_pointer(_temp_allocator->allocate(_bulk_values_begin + rows * (tuple + 1) + tail + 1));
+	char* ptr = buf;
+
+	// copies statement head
+	memcpy(ptr, source, _bulk_values_begin);
+	ptr += _bulk_values_begin;
+
+	// repeats tuples separated by comma
+	for (size_t row = 0; row < rows; ++row)
+	{
+		if (row)
+			*ptr++ = ',';
+
+		memcpy(ptr, source + _bulk_values_begin, tuple);
+		ptr += tuple;
+	}
+
+	// copies the rest of statement
+	memcpy(ptr, source + _bulk_values_end, tail);
+	ptr += tail;
+	*ptr = 0;
+
+	// resets sql
+	_sql = buf;
 }
 
 void
@@ -569,6 +942,15 @@ mysql_dbserver::v_before_bind_columns()
 {
 	if (_cols.size())
 		_column_binders.resize(*_columns_allocator, _cols.size());
+
+	// the block is defined again by the first batch fetch
+	_block = 0;
+	_block_rows = 0;
+
+	// read only cursor brings one row per round trip by default
+	// so lets the client buffer the rows by blocks, mysql_stmt_fetch reads them from the buffer
+	const unsigned long prefetch = (unsigned long)_bulk_rows;
+	check_retcode(mysql_stmt_attr_set(_stmt, STMT_ATTR_PREFETCH_ROWS, &prefetch) == 0)
 }
 
 // Binds one column with the number index
@@ -70,6 +70,9 @@ protected:
 	virtual void v_rebind_one_param(size_t index);
 	virtual void v_interrupt_async();
 	virtual dbtypes v_native_type_to_client_type(size_t native_type);
+	virtual void v_release_statement(void* handle);
+	virtual size_t v_fetch_block();
+	virtual size_t v_convert_column(size_t index, size_t first_row, size_t rows, terimber_db_column& column, size_t offset);
 
 
 private:
@@ -82,11 +85,47 @@ private:
 					unsigned short& port,					//!< [out] port
 					string_t& database						//!< [out] database
 					);
+	//! \brief fills mysql binder for the parameter value
+	void
+	bind_one_value(	binder& cur,							//!< parameter
+					MYSQL_BIND& mysql_binder				//!< [out] mysql binder
+					);
+	//! \brief finds the values tuple of the insert statement
+	//! the tuple must contain all parameters of the statement
+	bool
+	find_bulk_values(size_t& begin,							//!< [out] offset of tuple begin
+					size_t& end								//!< [out] offset after tuple end
+					) const;
+	//! \brief rewrites the insert statement for the specified number of tuples
+	void
+	form_bulk_sql(	size_t rows								//!< number of tuples
+					);
+	//! \brief executes the statement for all bulk parameters
+	void
+	execute_bulk();
+	//! \brief defines the block layout for the batch fetch
+	//! recordsets with blobs are fetched by one row, blob can be fetched again by column
+	void
+	prepare_block();
+	//! \brief returns the column value of the fetched block, 0 for null
+	const ub1_t*
+	block_value(	size_t index,							//!< column index
+					size_t row,								//!< row in block
+					size_t& length							//!< [out] value length in bytes
+					) const;
 private:
 	MYSQL*					_desc;							//!< descriptor pointer
 	MYSQL_STMT*				_stmt;							//!< statement pointer
 	_vector< MYSQL_BIND >	_param_binders;					//!< parameter binders
 	_vector< MYSQL_BIND >	_column_binders;				//!< column binders
+	size_t					_bulk_stmt_rows;				//!< bulk rows per statement execution, 0 - no bulk
+	string_t				_bulk_sql;						//!< single row insert statement
+	size_t					_bulk_values_begin;				//!< values tuple begin offset
+	size_t					_bulk_values_end;				//!< values tuple end offset
+	ub1_t*					_block;							//!< rows copied from bound buffers, 0 - one row is bound
+	size_t					_block_rows;					//!< max rows in block, 0 - layout is not defined
+	size_t					_block_row_size;				//!< row size in block
+	_vector< size_t >		_block_offsets;					//!< column offsets in block row
 };
 
 
@@ -351,6 +351,14 @@ odbc_dbserver::v_close()
 	}
 }
 
+// releases the cached statement
+// statements are executed directly and never cached
+void
+odbc_dbserver::v_release_statement(void* handle)
+{
+	::SQLFreeHandle(SQL_HANDLE_STMT, (SQLHSTMT)handle);
+}
+
 // Fetches block rows
 void
 odbc_dbserver::v_fetch()
@@ -417,6 +425,127 @@ odbc_dbserver::v_fetch()
 	_fetched_rows = select_row;
 }
 
+// fetches the block of rows into the bound arrays
+size_t
+odbc_dbserver::v_fetch_block()
+{
+	SQLUINTEGER row_count = 0;
+
+	// sets the attributes
+	RETCODE retCode = ::SQLSetStmtAttr(_hstmt, SQL_ATTR_ROW_ARRAY_SIZE, (void*)(SQLUINTEGER)_bulk_rows, 0);
+	check_retcode(retCode)
+	retCode = ::SQLSetStmtAttr(_hstmt, SQL_ATTR_ROWS_FETCHED_PTR, &row_count, 0);
+	check_retcode(retCode)
+
+	retCode = ::SQLFetchScroll(_hstmt, SQL_FETCH_NEXT, 0);
+	if (retCode == SQL_NO_DATA_FOUND)
+		return 0;
+
+	check_retcode(retCode)
+	return row_count;
+}
+
+// copies the column values straight from the bound arrays
+size_t
+odbc_dbserver::v_convert_column(size_t index, size_t first_row, size_t rows, terimber_db_column& column, size_t offset)
+{
+	binder& cur = _cols[index];
+	switch (_bind_cols ? cur._native_type : SQL_UNKNOWN_TYPE)
+	{
+		case SQL_BIT:
+		case SQL_TINYINT:
+		case SQL_SMALLINT:
+		case SQL_INTEGER:
+		case SQL_REAL:
+		case SQL_FLOAT:
+		case SQL_DOUBLE:
+		case SQL_GUID:
+		case SQL_TIMESTAMP:
+		case SQL_TYPE_TIMESTAMP:
+		case SQL_TIME:
+		case SQL_TYPE_TIME:
+		case SQL_DATE:
+		case SQL_TYPE_DATE:
+		case SQL_DECIMAL:
+		case SQL_NUMERIC:
+		case SQL_CHAR:
+		case SQL_VARCHAR:
+		case SQL_BINARY: 
+		case SQL_VARBINARY: 
+			break;
+		default:
+			{
+				// long values are requested by SQLGetData and can't be read twice
+				size_t converted = dbserver_impl::v_convert_column(index, first_row, rows, column, offset);
+				if (!_bind_cols && converted < rows)
+					exception::_throw("Batch heap is too small for the long value");
+
+				return converted;
+			}
+	}
+
+	for (size_t row = 0; row < rows; ++row)
+	{
+		unsigned char* buffer = (unsigned char*)cur._bind_buffer + (first_row + row) * cur._max_length;
+		size_t rlen = *((SQLINTEGER*)cur._real_length + first_row + row);
+
+		if (rlen == SQL_NULL_DATA)
+		{
+			_batch_put_null(column, index, offset + row);
+			continue;
+		}
+
+		switch (cur._native_type)
+		{
+			case SQL_TIMESTAMP:
+			case SQL_TYPE_TIMESTAMP:
+				{
+					TIMESTAMP_STRUCT* ptds = (TIMESTAMP_STRUCT*)buffer;
+					sb8_t dummy64;
+					date::convert_to(ptds->year, (ub1_t)ptds->month, (ub1_t)ptds->day, (ub1_t)ptds->hour, (ub1_t)ptds->minute, (ub1_t)ptds->second, (ub2_t)(ptds->fraction / 1000000), dummy64);
+					_batch_put_fixed(column, index, offset + row, &dummy64);
+				}
+				break;
+			case SQL_TIME:
+			case SQL_TYPE_TIME:
+				{
+					TIME_STRUCT* ptds = (TIME_STRUCT*)buffer;
+					sb8_t dummy64;
+					date::convert_to(0, 0, 0, (ub1_t)ptds->hour, (ub1_t)ptds->minute, (ub1_t)ptds->second, 0, dummy64);
+					_batch_put_fixed(column, index, offset + row, &dummy64);
+				}
+				break;
+			case SQL_DATE:
+			case SQL_TYPE_DATE:
+				{
+					DATE_STRUCT* ptds = (DATE_STRUCT*)buffer;
+					sb8_t dummy64;
+					date::convert_to(ptds->year, (ub1_t)ptds->month, (ub1_t)ptds->day, 0, 0, 0, 0, dummy64);
+					_batch_put_fixed(column, index, offset + row, &dummy64);
+				}
+				break;
+			case SQL_DECIMAL:
+			case SQL_NUMERIC:
+				// decimal is bound as text
+				if (!_batch_put_var(column, offset + row, buffer, strlen((const char*)buffer)))
+					return row;
+				break;
+			case SQL_CHAR:
+			case SQL_VARCHAR:
+			case SQL_BINARY: 
+			case SQL_VARBINARY: 
+				if (!_batch_put_var(column, offset + row, buffer, rlen))
+					return row;
+				break;
+			default:
+				_batch_put_fixed(column, index, offset + row, buffer);
+				break;
+		}
+	}
+
+	return rows;
+}
+
 // Formed SQL expression depends on the type of the select and native driver
 void
 odbc_dbserver::v_form_sql_string()
@@ -113,6 +113,7 @@ orcl_dbserver::v_disconnect()
 	_temp_allocator->clear_extra();
 
 	v_close();
+	_clear_statements();
 
 	if (_svchp)
 	{
@@ -163,18 +164,28 @@ orcl_dbserver::v_is_connect_alive()
 	if (!_is_connect())
 		return false;
 
-// can't find the analog in orcle
-//	SQLINTEGER value = SQL_CD_TRUE;
-//	::SQLGetConnectAttr(_hdbc, SQL_COPT_SS_CONNECTION_DEAD, &value, SQL_IS_INTEGER, 0);
-	return true;
+	// round trip to server
+	return OCIPing(_svchp, _errhp, OCI_DEFAULT) == OCI_SUCCESS;
 }
 
 ///////////////////////////
 void
 orcl_dbserver::v_before_execute()
 {
-	check_retcode(OCIHandleAlloc(_envhp, (void**)&_stmthp, OCI_HTYPE_STMT, 0, 0),  _envhp, OCI_HTYPE_ENV)
-	check_retcode(OCIStmtPrepare(_stmthp, _errhp, (const text*)(const char*)_sql, (ub4)_sql.length(), OCI_NTV_SYNTAX, OCI_DEFAULT), _errhp, OCI_HTYPE_ERROR)
+	// reuses the statement prepared for the same sql before
+	if ((_stmthp = (OCIStmt*)_take_statement()) != 0)
+		return;
+
+	OCIStmt* stmthp = 0;
+	check_retcode(OCIHandleAlloc(_envhp, (void**)&stmthp, OCI_HTYPE_STMT, 0, 0),  _envhp, OCI_HTYPE_ENV)
+	sword status = OCIStmtPrepare(stmthp, _errhp, (const text*)(const char*)_sql, (ub4)_sql.length(), OCI_NTV_SYNTAX, OCI_DEFAULT);
+	// statement that failed to prepare must not go to the cache
+	if (status != OCI_SUCCESS)
+		OCIHandleFree(stmthp, OCI_HTYPE_STMT);
+	else
+		_stmthp = stmthp;
+
+	check_retcode(status, _errhp, OCI_HTYPE_ERROR)
 }
 
 void
@@ -193,9 +204,12 @@ orcl_dbserver::v_execute()
 	{
 		case ACTION_EXEC_PROC:
 		case ACTION_EXEC_PROC_ASYNC:
+			iters = 1;
+			break;
 		case ACTION_EXEC_SQL:
 		case ACTION_EXEC_SQL_ASYNC:
-			iters = 1;
+			// executes all bulk parameters at once
+			iters = is_bulk_exec() ? (ub4_t)_bulk_params.size() : 1;
 			break;
 		default:
 			break;
@@ -212,7 +226,16 @@ orcl_dbserver::v_close()
 {
 	if (_stmthp)
 	{
-		OCIHandleFree(_stmthp, OCI_HTYPE_STMT);
+		if (_keep_statement(_stmthp))
+		{
+			// cancels the opened cursor of the cached statement
+			ub2 type = 0;
+			if (OCIAttrGet(_stmthp, OCI_HTYPE_STMT, &type, 0, OCI_ATTR_STMT_TYPE, _errhp) == OCI_SUCCESS
+				&& type == OCI_STMT_SELECT)
+				OCIStmtFetch(_stmthp, _errhp, 0, OCI_FETCH_NEXT, OCI_DEFAULT);
+		}
+		else
+			OCIHandleFree(_stmthp, OCI_HTYPE_STMT);
 		_stmthp = 0;
 	}
 
@@ -233,6 +256,13 @@ orcl_dbserver::v_close()
 		}
 }
 
+// releases the cached statement
+void
+orcl_dbserver::v_release_statement(void* handle)
+{
+	OCIHandleFree(handle, OCI_HTYPE_STMT);
+}
+
 // Fetches block rows
 void
 orcl_dbserver::v_fetch()
@@ -242,9 +272,19 @@ orcl_dbserver::v_fetch()
 	{
 		// re-executes
 		v_execute();
+		// skips rows by blocks
 		size_t skip_rows = 0;
-		while (skip_rows++ < _start_row
-			&& !OCIStmtFetch(_stmthp, _errhp, 1, OCI_FETCH_NEXT, OCI_DEFAULT));
+		while (skip_rows < _start_row)
+		{
+			ub4 row_fetch = (ub4)__min(_bulk_rows, _start_row - skip_rows);
+			ub4 row_count = 0;
+			if (OCIStmtFetch(_stmthp, _errhp, row_fetch, OCI_FETCH_NEXT, OCI_DEFAULT) != OCI_SUCCESS
+				|| OCIAttrGet(_stmthp, OCI_HTYPE_STMT, &row_count, 0, OCI_ATTR_ROWS_FETCHED, _errhp) != OCI_SUCCESS
+				|| row_count < row_fetch)
+				break;
+
+			skip_rows += row_count;
+		}
 	}
 
 	// defines the column count
@@ -252,32 +292,45 @@ orcl_dbserver::v_fetch()
 	sword x = OCI_SUCCESS;
 	size_t select_row = 0;
 
-	while (_requested_rows
-		&& ((x = OCIStmtFetch(_stmthp, _errhp, 1, OCI_FETCH_NEXT, OCI_DEFAULT)) == OCI_SUCCESS 
-				|| x == OCI_SUCCESS_WITH_INFO)
-			)
+	while (_requested_rows)
 	{
-		if (STATE_INTERRUPTED == get_state()) // check interrupt
-			exception::_throw("Fetching process is interrupted");
+		// fetches the block of rows into the bound arrays
+		ub4 row_fetch = (ub4)__min(_bulk_rows, _requested_rows);
+		x = OCIStmtFetch(_stmthp, _errhp, row_fetch, OCI_FETCH_NEXT, OCI_DEFAULT);
+		if (x != OCI_SUCCESS && x != OCI_SUCCESS_WITH_INFO && x != OCI_NO_DATA)
+			break;
 
 		check_retcode(x, _errhp, OCI_HTYPE_ERROR)
 
-		// adds empty row to recordset
-		_vector< terimber_db_value > val;
-		recordset_list_t::iterator iter_val = _data.push_back(*_data_allocator, val);
-		if (iter_val == _data.end())
-			exception::_throw("Not enough memory");
-
-		// resizes row to the column count
-		if (!iter_val->resize(*_data_allocator, col_count))
-			exception::_throw("Not enough memory");
-		// copies/converts data from the buffer to the row
-		for (size_t index = 0; index < col_count; ++index)
-			v_convert_one_value(0, index, (*iter_val)[index]);
-
-		++select_row;	
-		// increment/decrement _requested_rows
-		--_requested_rows;
+		// the last block can be partially filled
+		ub4 row_count = 0;
+		check_retcode(OCIAttrGet(_stmthp, OCI_HTYPE_STMT, &row_count, 0, OCI_ATTR_ROWS_FETCHED, _errhp), _errhp, OCI_HTYPE_ERROR)
+
+		for (ub4 row = 0; row < row_count; ++row)
+		{
+			if (STATE_INTERRUPTED == get_state()) // check interrupt
+				exception::_throw("Fetching process is interrupted");
+
+			// adds empty row to recordset
+			_vector< terimber_db_value > val;
+			recordset_list_t::iterator iter_val = _data.push_back(*_data_allocator, val);
+			if (iter_val == _data.end())
+				exception::_throw("Not enough memory");
+
+			// resizes row to the column count
+			if (!iter_val->resize(*_data_allocator, col_count))
+				exception::_throw("Not enough memory");
+			// copies/converts data from the buffer to the row
+			for (size_t index = 0; index < col_count; ++index)
+				v_convert_one_value(row, index, (*iter_val)[index]);
+
+			++select_row;	
+			// increment/decrement _requested_rows
+			--_requested_rows;
+		}
+
+		if (x == OCI_NO_DATA || row_count < row_fetch)
+			break;
 	}
 
 	if (x != OCI_NO_DATA)
@@ -287,6 +340,94 @@ orcl_dbserver::v_fetch()
 	_fetched_rows = select_row;
 }
 
+// fetches the block of rows into the bound arrays
+size_t
+orcl_dbserver::v_fetch_block()
+{
+	sword x = OCIStmtFetch(_stmthp, _errhp, (ub4)_bulk_rows, OCI_FETCH_NEXT, OCI_DEFAULT);
+	check_retcode(x, _errhp, OCI_HTYPE_ERROR)
+
+	// the last block can be partially filled
+	ub4 row_count = 0;
+	check_retcode(OCIAttrGet(_stmthp, OCI_HTYPE_STMT, &row_count, 0, OCI_ATTR_ROWS_FETCHED, _errhp), _errhp, OCI_HTYPE_ERROR)
+	return row_count;
+}
+
+// copies the column values straight from the bound arrays
+size_t
+orcl_dbserver::v_convert_column(size_t index, size_t first_row, size_t rows, terimber_db_column& column, size_t offset)
+{
+	binder& cur = _cols[index];
+	switch (cur._native_type)
+	{
+		case SQLT_INT:
+		case SQLT_UIN:
+		case SQLT_FLT:
+		case SQLT_DAT:
+		case SQLT_NUM:
+		case SQLT_VNU:
+		case SQLT_VCS:
+		case SQLT_CHR:
+		case SQLT_STR:
+		case SQLT_RID:
+		case SQLT_AFC:
+		case SQLT_AVC:
+			break;
+		default: // long and binary values are read piece by piece
+			return dbserver_impl::v_convert_column(index, first_row, rows, column, offset);
+	}
+
+	for (size_t row = 0; row < rows; ++row)
+	{
+		ub1_t* buffer = (ub1_t*)cur._bind_buffer + (first_row + row) * cur._max_length;
+		sb2 indicator = *((sb2*)cur._bind_type + first_row + row);
+		size_t rlen = *((ub2*)cur._real_length + first_row + row);
+
+		if (indicator == -1 || rlen == 0)
+		{
+			_batch_put_null(column, index, offset + row);
+			continue;
+		}
+
+		switch (cur._native_type)
+		{
+			case SQLT_INT:
+			case SQLT_UIN:
+			case SQLT_FLT:
+				_batch_put_fixed(column, index, offset + row, buffer);
+				break;
+			case SQLT_DAT:
+				{
+					sb8_t dummy64;
+					date::convert_to((buffer[0] - 100) * 100 + (buffer[1] - 100), buffer[2], buffer[3], buffer[4] - 1, buffer[5] - 1, buffer[6] - 1, 0, dummy64);
+					_batch_put_fixed(column, index, offset + row, &dummy64);
+				}
+				break;
+			case SQLT_VNU:
+			case SQLT_NUM:
+				{
+					buffer[rlen] = 0;
+					numeric conv(_data_allocator);
+					if (!conv.parse_orcl(cur._native_type == SQLT_VNU ? buffer + 1 : buffer))
+						exception::_throw("Out of range");
+
+					size_t len = conv.is_zero() ? 2 : conv.precision() + (conv.sign() ? 1 : 0) + (conv.scale() ? 1 : 0) + (conv.precision() == conv.scale()) + 1;
+					char* text = (char*)check_pointer(_data_allocator->allocate(len));
+					conv.format(text, '.');
+					if (!_batch_put_var(column, offset + row, text, strlen(text)))
+						return row;
+				}
+				break;
+			default: // strings
+				if (!_batch_put_var(column, offset + row, buffer, rlen))
+					return row;
+				break;
+		}
+	}
+
+	return rows;
+}
+
 // replaces the quote to the available sign for native drive
 void
 orcl_dbserver::v_replace_quote()
@@ -334,6 +475,12 @@ orcl_dbserver::v_replace_quote()
 void
 orcl_dbserver::v_bind_one_param(size_t index)
 {
+	if (is_bulk_exec())
+	{
+		bind_bulk_param(index);
+		return;
+	}
+
 	binder& cur = _params[index];
 
 	cur._bind_type = cur._value.nullVal ? os_minus_one : 0;
@@ -546,9 +693,259 @@ orcl_dbserver::v_bind_one_param(size_t index)
 
 }
 
+// Binds one param as the array of the stored bulk values
+void
+orcl_dbserver::bind_bulk_param(size_t index)
+{
+	binder& cur = _params[index];
+	size_t num = _bulk_params.size();
+	bulk_params_t::const_iterator iter(_bulk_params.end());
+
+	// defines the external type and the width of array element
+	switch (cur._type)
+	{
+		case db_bool:
+		case db_sb1:
+		case db_sb2:
+		case db_sb4:
+			cur._max_length = sizeof(sb4_t);
+			cur._native_type = SQLT_INT;
+			break;
+		case db_ub1:
+		case db_ub2:
+		case db_ub4:
+			cur._max_length = sizeof(ub4_t);
+			cur._native_type = SQLT_UIN;
+			break;
+		case db_float:
+		case db_double:
+			cur._max_length = sizeof(double);
+			cur._native_type = SQLT_FLT;
+			break;
+		case db_sb8:
+		case db_ub8:
+		case db_decimal:
+		case db_numeric:
+			cur._max_length = 22;
+			cur._native_type = SQLT_NUM;
+			break;
+		case db_date:
+			cur._max_length = 7;
+			cur._native_type = SQLT_DAT;
+			break;
+		case db_string:
+			cur._max_length = 1;
+			for (iter = _bulk_params.begin(); iter != _bulk_params.end(); ++iter)
+				if (!(*iter)[index]._value.nullVal && (*iter)[index]._value.val.strVal)
+					cur._max_length = __max(cur._max_length, strlen((*iter)[index]._value.val.strVal) + 1);
+
+			cur._native_type = cur._max_length > 4000 ? SQLT_LNG : SQLT_STR;
+			break;
+		case db_wstring:
+			cur._max_length = 2;
+			for (iter = _bulk_params.begin(); iter != _bulk_params.end(); ++iter)
+				if (!(*iter)[index]._value.nullVal && (*iter)[index]._value.val.wstrVal)
+					cur._max_length = __max(cur._max_length, 2 * (wcslen((*iter)[index]._value.val.wstrVal) + 1));
+
+			cur._native_type = cur._max_length > 4000 ? SQLT_LNG : SQLT_STR;
+			break;
+		case db_binary:
+			cur._max_length = 1;
+			for (iter = _bulk_params.begin(); iter != _bulk_params.end(); ++iter)
+				if (!(*iter)[index]._value.nullVal && (*iter)[index]._value.val.bufVal)
+					cur._max_length = __max(cur._max_length, *(size_t*)(*iter)[index]._value.val.bufVal);
+
+			cur._native_type = cur._max_length > 4000 ? SQLT_LBI : SQLT_BIN;
+			break;
+		default:
+			exception::_throw("Unsupported parameter type");
+			assert(false);
+	}
+
+	// array lengths are two bytes long
+	if (cur._max_length > 0xffff)
+		exception::_throw("Bulk parameter value is too long");
+
+	// allocates value, indicator and length arrays
+	ub1_t* buffer = (ub1_t*)check_pointer(_temp_allocator->allocate(cur._max_length * num));
+	sb2* indicators = (sb2*)check_pointer(_temp_allocator->allocate(sizeof(sb2) * num));
+	ub2* lengths = (ub2*)check_pointer(_temp_allocator->allocate(sizeof(ub2) * num));
+	cur._bind_buffer = buffer;
+
+	size_t row = 0;
+	for (iter = _bulk_params.begin(); iter != _bulk_params.end(); ++iter, ++row)
+	{
+		const binder& item = (*iter)[index];
+		ub1_t* slot = buffer + row * cur._max_length;
+		indicators[row] = item._value.nullVal ? -1 : 0;
+		lengths[row] = item._value.nullVal ? 0 : (ub2)cur._max_length;
+
+		if (item._value.nullVal)
+			continue;
+
+		switch (cur._type)
+		{
+			case db_bool:
+				*(sb4_t*)slot = item._value.val.boolVal ? 1 : 0;
+				break;
+			case db_sb1:
+				*(sb4_t*)slot = item._value.val.cVal;
+				break;
+			case db_sb2:
+				*(sb4_t*)slot = item._value.val.iVal;
+				break;
+			case db_sb4:
+				*(sb4_t*)slot = item._value.val.lVal;
+				break;
+			case db_ub1:
+				*(ub4_t*)slot = item._value.val.bVal;
+				break;
+			case db_ub2:
+				*(ub4_t*)slot = item._value.val.uiVal;
+				break;
+			case db_ub4:
+				*(ub4_t*)slot = item._value.val.ulVal;
+				break;
+			case db_float:
+				*(double*)slot = item._value.val.fltVal;
+				break;
+			case db_double:
+#ifdef OS_64BIT
+				*(double*)slot = item._value.val.dblVal;
+#else
+				*(double*)slot = item._value.val.dblVal ? *item._value.val.dblVal : 0.0;
+#endif
+				break;
+			case db_sb8:
+			case db_ub8:
+				{
+#ifdef OS_64BIT
+					numeric conv(item._value.val.intVal, _temp_allocator);
+#else
+					numeric conv(item._value.val.intVal ? *item._value.val.intVal : (sb8_t)0, _temp_allocator);
+#endif
+					if (!conv.persist_orcl(slot))
+						exception::_throw("Out of range");
+
+					// the last persisted byte is a terminator
+					lengths[row] = (ub2)(conv.orcl_len() - 1);
+				}
+				break;
+			case db_decimal:
+			case db_numeric:
+				if (item._value.val.bufVal)
+				{
+					numeric conv(_temp_allocator);
+					if (!conv.parse_orcl(item._value.val.bufVal) || !conv.persist_orcl(slot))
+						exception::_throw("Out of range");
+
+					lengths[row] = (ub2)(conv.orcl_len() - 1);
+				}
+				else
+					indicators[row] = -1;
+				break;
+			case db_date:
+				{
+					ub4_t year32;
+					ub1_t month8, day8, hour8, minute8, second8, wday8;
+					ub2_t millisec16, yday16;
+					date::convert_from(
+#ifdef OS_64BIT
+						item._value.val.intVal,
+#else
+						item._value.val.intVal ? *item._value.val.intVal : 0, 
+#endif
+										year32,
+										month8,
+										day8,
+										hour8,
+										minute8,
+										second8,
+										millisec16,
+										wday8,
+										yday16);
+
+					slot[0] = year32 / 100 + 100;
+					slot[1] = year32 % 100 + 100;
+					slot[2] = month8;
+					slot[3] = day8;
+					slot[4] = hour8 + 1;
+					slot[5] = minute8 + 1;
+					slot[6] = second8 + 1;
+				}
+				break;
+			case db_string:
+				if (item._value.val.strVal)
+				{
+					size_t len = strlen(item._value.val.strVal) + 1;
+					memcpy(slot, item._value.val.strVal, len);
+					lengths[row] = (ub2)len;
+				}
+				else
+					indicators[row] = -1;
+				break;
+			case db_wstring:
+				if (item._value.val.wstrVal)
+				{
+					size_t len = 2 * (wcslen(item._value.val.wstrVal) + 1);
+					memcpy(slot, item._value.val.wstrVal, len);
+					lengths[row] = (ub2)len;
+				}
+				else
+					indicators[row] = -1;
+				break;
+			case db_binary:
+				if (item._value.val.bufVal)
+				{
+					size_t len = *(size_t*)item._value.val.bufVal;
+					memcpy(slot, item._value.val.bufVal + sizeof(size_t), len);
+					lengths[row] = (ub2)len;
+				}
+				else
+					indicators[row] = -1;
+				break;
+			default:
+				assert(false);
+		}
+	}
+
+	OCIBind* bindp = 0;
+	check_retcode(OCIBindByPos(_stmthp, &bindp, _errhp,
+		   (ub4)index + 1, buffer, (sb4)cur._max_length,
+		   (ub2)cur._native_type, indicators,
+		   lengths, 0, 0, 0,
+		   OCI_DEFAULT), _errhp, OCI_HTYPE_ERROR)
+
+	// sets the skips between elements, OCIStmtExecute takes the bulk size as iterations
+	check_retcode(OCIBindArrayOfStruct(bindp, _errhp, (ub4)cur._max_length, sizeof(sb2), sizeof(ub2), 0), _errhp, OCI_HTYPE_ERROR)
+}
+
 void 
 orcl_dbserver::v_before_bind_columns()
 {
+	// lets OCI client bring the rows from server by blocks
+	ub4 prefetch = (ub4)_bulk_rows;
+	check_retcode(OCIAttrSet(_stmthp, OCI_HTYPE_STMT, &prefetch, 0, OCI_ATTR_PREFETCH_ROWS, _errhp), _errhp, OCI_HTYPE_ERROR)
+
+	// LOB locator is allocated per column, not per row
+	// so such recordsets are fetched row by row
+	size_t cols = _cols.size();
+	for (size_t col_ind = 0; col_ind < cols; ++col_ind)
+	{
+		switch (_cols[col_ind]._native_type)
+		{
+			case SQLT_LNG:
+			case SQLT_LBI:
+			case SQLT_LVC:
+			case SQLT_LVB:
+			case SQLT_BLOB:
+			case SQLT_CLOB:
+				_bulk_rows = 1;
+				break;
+			default:
+				break;
+		} // switch
+	} // for
 }
 
 // Binds one column with the number index
@@ -561,27 +958,21 @@ orcl_dbserver::v_bind_one_column(size_t index)
 		case SQLT_INT:
 			//cur._bind_type = SQL_C_LONG;
 			cur._max_length = sizeof(sb4_t);
-			cur._bind_buffer = &(cur._value.val.lVal);
 			break;
 		case SQLT_UIN:
 			cur._max_length = sizeof(ub4_t);
-			cur._bind_buffer = &(cur._value.val.ulVal);
 			break;
 		case SQLT_FLT:
 			cur._max_length = sizeof(double);
-			cur._bind_buffer = check_pointer(_temp_allocator->allocate(cur._max_length));
 			break;
 		case SQLT_DAT:
 			cur._max_length = 7;
-			cur._bind_buffer = check_pointer(_temp_allocator->allocate(cur._max_length));
 			break;
 		case SQLT_VNU:
 			cur._max_length = 23;
-			cur._bind_buffer = check_pointer(_temp_allocator->allocate(cur._max_length));
 			break;
 		case SQLT_NUM:
 			cur._max_length = 22;
-			cur._bind_buffer = check_pointer(_temp_allocator->allocate(cur._max_length));
 			break;
 		case SQLT_VCS:
 		case SQLT_CHR:
@@ -592,7 +983,6 @@ orcl_dbserver::v_bind_one_column(size_t index)
 		case SQLT_AFC:
 		case SQLT_AVC:
 			cur._max_length = 4000;
-			cur._bind_buffer = check_pointer(_temp_allocator->allocate(cur._max_length));
 			break;
 		case SQLT_LNG:
 		case SQLT_LBI:
@@ -615,15 +1005,25 @@ orcl_dbserver::v_bind_one_column(size_t index)
 			assert(false);
 	}
 
-	// uses bind_type for nullability
+	// allocates the value array for block fetching, LOBs use the locator instead
+	if (cur._max_length)
+		cur._bind_buffer = check_pointer(_temp_allocator->allocate(cur._max_length * _bulk_rows));
+
+	// uses bind_type for the indicator array and real_length for the length array
+	cur._bind_type = (size_t)check_pointer(_temp_allocator->allocate(sizeof(sb2) * _bulk_rows));
+	cur._real_length = (size_t)check_pointer(_temp_allocator->allocate(sizeof(ub2) * _bulk_rows));
+
 	OCIDefine* defnp = 0;
 
 	check_retcode(OCIDefineByPos(_stmthp, &defnp, _errhp, (ub4)index + 1,
               cur._bind_buffer, (ub4)cur._max_length,
-              (ub2)cur._native_type, (ub2*)&cur._bind_type,
-              (ub2*)&cur._real_length,
+              (ub2)cur._native_type, (sb2*)cur._bind_type,
+              (ub2*)cur._real_length,
 			  0,
 			  OCI_DEFAULT), _errhp, OCI_HTYPE_ERROR)
+
+	// sets the skips between rows in the arrays
+	check_retcode(OCIDefineArrayOfStruct(defnp, _errhp, (ub4)cur._max_length, sizeof(sb2), sizeof(ub2), 0), _errhp, OCI_HTYPE_ERROR)
 }
 
 // Gets number columns in query
@@ -642,8 +1042,12 @@ void
 orcl_dbserver::v_convert_one_value(size_t row, size_t index, terimber_db_value& val)
 {
 	binder& cur = _cols[index];
+	// adjusts buffer
+	ub1_t* buffer = (cur._max_length ? (ub1_t*)cur._bind_buffer + row * cur._max_length : (ub1_t*)cur._bind_buffer);
+	sb2 indicator = *((sb2*)cur._bind_type + row);
+	size_t rlen = *((ub2*)cur._real_length + row);
 
-	if ((ub4)cur._bind_type == 0xffffffff || cur._real_length == 0)
+	if (indicator == -1 || rlen == 0)
 	{
 		memset(&val, 0, sizeof(terimber_db_value));
 		val.nullVal = true;
@@ -656,19 +1060,22 @@ orcl_dbserver::v_convert_one_value(size_t row, size_t index, terimber_db_value&
 	switch (cur._native_type)
 	{
 		case SQLT_INT:
-			val.val.boolVal = cur._value.val.boolVal;
+			val.val.lVal = *(sb4_t*)buffer;
+			break;
+		case SQLT_UIN:
+			val.val.ulVal = *(ub4_t*)buffer;
 			break;
 		case SQLT_FLT:
 #ifdef OS_64BIT
-			val.val.dblVal = cur._value.val.dblVal;
+			val.val.dblVal = *(double*)buffer;
 #else
 			val.val.dblVal = (double*)check_pointer(_data_allocator->allocate(cur._max_length));
-			memcpy((void*)val.val.dblVal, cur._bind_buffer, cur._max_length);
+			memcpy((void*)val.val.dblVal, buffer, cur._max_length);
 #endif
 			break;
 		case SQLT_DAT:
 			{
-				const ub1_t* ptds = (const ub1_t*)cur._bind_buffer;
+				const ub1_t* ptds = (const ub1_t*)buffer;
 				sb8_t dummy64;
 				date::convert_to((ptds[0] - 100) * 100 + (ptds[1] - 100), ptds[2], ptds[3], ptds[4] - 1, ptds[5] - 1, ptds[6] - 1, 0, dummy64);
 #ifdef OS_64BIT
@@ -684,15 +1091,15 @@ orcl_dbserver::v_convert_one_value(size_t row, size_t index, terimber_db_value&
 		case SQLT_LVC:
 			if (*(unsigned short*)&cur._user_code == 1406) // truncate
 			{
-				char* sz = (char*)check_pointer(_data_allocator->allocate(cur._real_length + 1));
-				sz[cur._real_length] = 0;
+				char* sz = (char*)check_pointer(_data_allocator->allocate(rlen + 1));
+				sz[rlen] = 0;
 
 				size_t shift = 0;
 				ub4 gotLen = 0;
-				while (shift < cur._real_length)
+				while (shift < rlen)
 				{
 					check_retcode(OCILobRead(_svchp, _errhp, (OCILobLocator*)cur._user_code,
-						&gotLen, (ub4)shift + 1, (sz + shift), (ub4)(cur._real_length - shift), 
+						&gotLen, (ub4)shift + 1, (sz + shift), (ub4)(rlen - shift), 
 						OCI_ONE_PIECE, 0, 0, SQLCS_IMPLICIT), _errhp, OCI_HTYPE_ERROR)
 
 					shift += gotLen;
@@ -701,17 +1108,17 @@ orcl_dbserver::v_convert_one_value(size_t row, size_t index, terimber_db_value&
 			}
 			else
 			{
-				char* sz = (char*)check_pointer(_data_allocator->allocate(cur._real_length + 1));
-				sz[cur._real_length] = 0;
-				memcpy(sz, cur._bind_buffer, cur._real_length);
+				char* sz = (char*)check_pointer(_data_allocator->allocate(rlen + 1));
+				sz[rlen] = 0;
+				memcpy(sz, buffer, rlen);
 				val.val.strVal = sz;
 			}
 			break;			
 		case SQLT_VNU:
 			{
-				((ub1_t*)cur._bind_buffer)[cur._real_length] = 0;
+				((ub1_t*)buffer)[rlen] = 0;
 				numeric conv(_temp_allocator);
-				if (!conv.parse_orcl((const ub1_t*)cur._bind_buffer + 1))
+				if (!conv.parse_orcl((const ub1_t*)buffer + 1))
 					exception::_throw("Out of range");
 
 				ub1_t* buf = (ub1_t*)check_pointer(_data_allocator->allocate(conv.orcl_len()));
@@ -721,9 +1128,9 @@ orcl_dbserver::v_convert_one_value(size_t row, size_t index, terimber_db_value&
 			break;
 		case SQLT_NUM:
 			{
-				((ub1_t*)cur._bind_buffer)[cur._real_length] = 0;
+				((ub1_t*)buffer)[rlen] = 0;
 				numeric conv(_temp_allocator);
-				if (!conv.parse_orcl((const ub1_t*)cur._bind_buffer))
+				if (!conv.parse_orcl((const ub1_t*)buffer))
 					exception::_throw("Out of range");
 
 				ub1_t* buf = (ub1_t*)check_pointer(_data_allocator->allocate(conv.orcl_len()));
@@ -738,9 +1145,9 @@ orcl_dbserver::v_convert_one_value(size_t row, size_t index, terimber_db_value&
 		case SQLT_AFC:
 		case SQLT_AVC:
 			{
-				char* sz = (char*)check_pointer(_data_allocator->allocate(cur._real_length + 1));
-				sz[cur._real_length] = 0;
-				memcpy(sz, cur._bind_buffer, cur._real_length);
+				char* sz = (char*)check_pointer(_data_allocator->allocate(rlen + 1));
+				sz[rlen] = 0;
+				memcpy(sz, buffer, rlen);
 				val.val.strVal = sz;
 			}
 			break;
@@ -748,16 +1155,16 @@ orcl_dbserver::v_convert_one_value(size_t row, size_t index, terimber_db_value&
 		case SQLT_LVB:
 			if (*(unsigned short*)&cur._user_code == 1406)
 			{
-				ub1_t* buf = (ub1_t*)check_pointer(_data_allocator->allocate(cur._real_length + sizeof(size_t)));
-				*(size_t*)buf = cur._real_length;
+				ub1_t* buf = (ub1_t*)check_pointer(_data_allocator->allocate(rlen + sizeof(size_t)));
+				*(size_t*)buf = rlen;
 
 				size_t shift = 0;
 				ub1_t* start_buf = buf + sizeof(size_t);
 				ub4 gotLen = 0;
-				while (shift < cur._real_length)
+				while (shift < rlen)
 				{
 					check_retcode(OCILobRead(_svchp, _errhp, (OCILobLocator*)cur._user_code,
-						&gotLen, (ub4)shift + 1, (start_buf + shift), (ub4)(cur._real_length - shift), 
+						&gotLen, (ub4)shift + 1, (start_buf + shift), (ub4)(rlen - shift), 
 						OCI_ONE_PIECE, 0, 0, SQLCS_IMPLICIT), _errhp, OCI_HTYPE_ERROR)
 
 					shift += gotLen;
@@ -766,24 +1173,24 @@ orcl_dbserver::v_convert_one_value(size_t row, size_t index, terimber_db_value&
 			}
 			else
 			{
-				val.val.bufVal = (ub1_t*)check_pointer(_data_allocator->allocate(cur._real_length + sizeof(size_t)));
-				*(size_t*)val.val.bufVal = cur._real_length;
-				memcpy((char*)val.val.bufVal + sizeof(size_t), cur._bind_buffer, cur._real_length);				
+				val.val.bufVal = (ub1_t*)check_pointer(_data_allocator->allocate(rlen + sizeof(size_t)));
+				*(size_t*)val.val.bufVal = rlen;
+				memcpy((char*)val.val.bufVal + sizeof(size_t), buffer, rlen);				
 			}
 			break;
 		case SQLT_VBI:
 		case SQLT_BIN:
 			{
-				ub1_t* buf = (ub1_t*)check_pointer(_data_allocator->allocate(cur._real_length + sizeof(ub4_t)));
-				*(ub4_t*)buf = (ub4_t)cur._real_length;
+				ub1_t* buf = (ub1_t*)check_pointer(_data_allocator->allocate(rlen + sizeof(ub4_t)));
+				*(ub4_t*)buf = (ub4_t)rlen;
 
 				size_t shift = 0;
 				ub1_t* start_buf = buf + sizeof(ub4_t);
 				ub4 gotLen = 0;
-				while (shift < cur._real_length)
+				while (shift < rlen)
 				{
 					check_retcode(OCILobRead(_svchp, _errhp, (OCILobLocator*)cur._user_code,
-						&gotLen, (ub4)shift + 1, (start_buf + shift), (ub4)(cur._real_length - shift), 
+						&gotLen, (ub4)shift + 1, (start_buf + shift), (ub4)(rlen - shift), 
 						OCI_ONE_PIECE, 0, 0, SQLCS_IMPLICIT), _errhp, OCI_HTYPE_ERROR)
 
 					shift += gotLen;
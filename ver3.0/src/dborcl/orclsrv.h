@@ -70,7 +70,15 @@ protected:
 	virtual void v_rebind_one_param(size_t index);
 	virtual void v_interrupt_async();
 	virtual dbtypes v_native_type_to_client_type(size_t native_type);
+	virtual void v_release_statement(void* handle);
+	virtual size_t v_fetch_block();
+	virtual size_t v_convert_column(size_t index, size_t first_row, size_t rows, terimber_db_column& column, size_t offset);
 
+private:
+	//! \brief binds one parameter as the array of the stored bulk values
+	void
+	bind_bulk_param(size_t index							//!< parameter index
+					);
 private:
 	OCIEnv*			_envhp;									//!< oracle environment handle
 	OCISvcCtx*		_svchp;									//!< oracle server context handle
@@ -30,9 +30,12 @@
 #include "base/list.hpp"
 #include "base/vector.hpp"
 
+//! \brief huge page provider shared by all tables
+static TERIMBER::huge_page_provider memdb_huge_page_provider;
+
 terimber_memtable*
-terimber_memtable_factory::get_memtable()
+terimber_memtable_factory::get_memtable(bool huge_pages, bool columnar)
 {
-	return new TERIMBER::memtable();
+	return new TERIMBER::memtable(huge_pages ? &memdb_huge_page_provider : 0, columnar);
 }
 
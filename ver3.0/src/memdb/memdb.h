@@ -35,17 +35,163 @@
 #include "base/list.h"
 #include "base/map.h"
 #include "base/common.h"
+#include "tools/mapfile.h"
 
 
 BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
+//! \brief full memory barrier
+inline
+void
+memdb_fence()
+{
+#if OS_TYPE == OS_WIN32
+	::MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+//! \brief atomically adds value, returns new value
+inline
+ub4_t
+memdb_add(volatile ub4_t* p, ub4_t v)
+{
+#if OS_TYPE == OS_WIN32
+	return (ub4_t)::InterlockedExchangeAdd((LONG volatile*)p, (LONG)v) + v;
+#else
+	return __sync_add_and_fetch(p, v);
+#endif
+}
+
+//! \brief gives up the rest of time slice
+inline
+void
+memdb_yield()
+{
+#if OS_TYPE == OS_WIN32
+	::Sleep(0);
+#else
+	sched_yield();
+#endif
+}
+
+//! \brief epoch of row version which has not been replaced or deleted yet
+const size_t memdb_epoch_infinite = ~(size_t)0;
+
+//! \class memdb_latch
+//! \brief short reader/writer latch of table structures
+//! readers hold it for one lookup step only, so the writer waits at most for one step,
+//! readers never wait for the writer's copying of values which is done before the latch is taken
+//! writers are serialized by the table mutex
+class memdb_latch
+{
+public:
+	//! \brief constructor
+	memdb_latch() :
+		_readers(0),
+		_writer(0)
+	{
+	}
+
+	//! \brief enters shared mode
+	inline
+	void
+	enter_read()
+	{
+		for (;;)
+		{
+			memdb_add(&_readers, 1);
+			if (!_writer)
+				return;
+
+			// backs off while writer changes structures
+			memdb_add(&_readers, (ub4_t)-1);
+			while (_writer)
+				memdb_yield();
+		}
+	}
+	//! \brief leaves shared mode
+	inline
+	void
+	leave_read()
+	{
+		memdb_add(&_readers, (ub4_t)-1);
+	}
+	//! \brief enters exclusive mode
+	inline
+	void
+	enter_write()
+	{
+		_writer = 1;
+		memdb_fence();
+		while (_readers)
+			memdb_yield();
+	}
+	//! \brief leaves exclusive mode
+	inline
+	void
+	leave_write()
+	{
+		memdb_fence();
+		_writer = 0;
+	}
+
+private:
+	volatile ub4_t		_readers;							//!< number of readers inside
+	volatile ub4_t		_writer;							//!< writer is inside or waiting
+};
+
+//! \class memdb_reader_keeper
+//! \brief keeps latch in shared mode in the scope
+class memdb_reader_keeper
+{
+public:
+	//! \brief constructor
+	memdb_reader_keeper(memdb_latch& latch					//!< latch
+					) :
+		_latch(latch)
+	{
+		_latch.enter_read();
+	}
+	//! \brief destructor
+	~memdb_reader_keeper()
+	{
+		_latch.leave_read();
+	}
+private:
+	memdb_latch&		_latch;								//!< latch
+};
+
+//! \class memdb_writer_keeper
+//! \brief keeps latch in exclusive mode in the scope
+class memdb_writer_keeper
+{
+public:
+	//! \brief constructor
+	memdb_writer_keeper(memdb_latch& latch					//!< latch
+					) :
+		_latch(latch)
+	{
+		_latch.enter_write();
+	}
+	//! \brief destructor
+	~memdb_writer_keeper()
+	{
+		_latch.leave_write();
+	}
+private:
+	memdb_latch&		_latch;								//!< latch
+};
+
 //! \class terimber_index_column_info_ex
 //! \brief types for internal data structure
 class terimber_index_column_info_ex : public terimber_index_column_info
 {
 public:
 	dbtypes	_type;
+	bool	_dictionary;									//!< column values of table rows are in dictionary
 };
 
 //! \class terimber_db_value_vector_impl
@@ -389,13 +535,408 @@ public:
 	vector< binder >		_value;							//!< vector of binders
 };
 
+//! \brief max digits of decimal scale
+const size_t memdb_decimal_max_scale = 96;
+//! \brief size of buffer for formatted decimal, sign, digits, delimeter and terminator
+const size_t memdb_decimal_chars = memdb_decimal_max_scale + 48;
+
+//! \class memdb_decimal
+//! \brief fixed width decimal for numeric and decimal columns
+//! value is 128 bits two's complement mantissa divided by 10 in power of scale,
+//! trailing zeros of fraction are removed, so equal values have the same bytes
+class memdb_decimal
+{
+public:
+	//! \brief parses decimal string like -123.45 or 1.2E+5
+	//! returns false if format is invalid or mantissa exceeds 127 bits
+	bool
+	parse(			const char* str,						//!< input string
+					char delimeter							//!< delimeter '.', ',', etc
+					);
+	//! \brief formats value, buffer must have memdb_decimal_chars bytes
+	void
+	format(			char* buf,								//!< [out] buffer
+					char delimeter							//!< delimeter '.', ',', etc
+					) const;
+	//! \brief compares values
+	static
+	inline
+	int
+	compare(		const memdb_decimal& first,				//!< first value
+					const memdb_decimal& second				//!< second value
+					);
+
+private:
+	//! \brief compares values with different scales
+	static
+	int
+	compare_scaled(	const memdb_decimal& first,				//!< first value
+					const memdb_decimal& second				//!< second value
+					);
+
+public:
+	ub8_t				_low;								//!< lower 64 bits of mantissa
+	sb8_t				_high;								//!< upper 64 bits of mantissa
+	sb4_t				_scale;								//!< digits after delimeter
+};
+
+//! \class memdb_dictionary_entry
+//! \brief header of dictionary value, value bytes follow it
+class memdb_dictionary_entry
+{
+public:
+	//! \brief returns header of dictionary value
+	static
+	inline
+	const memdb_dictionary_entry*
+	get(			const void* value						//!< value of dictionary column
+					)
+	{
+		return (const memdb_dictionary_entry*)value - 1;
+	}
+	//! \brief returns value
+	inline
+	const void*
+	value() const
+	{
+		return this + 1;
+	}
+
+public:
+	size_t				_hash;								//!< hash of value bytes
+	size_t				_length;							//!< length of value in bytes with terminator
+	size_t				_rank;								//!< position in sorted dictionary, 0 - added after sorting
+};
+
+//! \class memdb_dictionary
+//! \brief distinct values of string column
+//! rows of dictionary column point to the shared values instead of own copies,
+//! so equal values of table rows have the same pointer and ranked values compare by ranks
+//! values are kept by the table allocator until the table is cleared
+class memdb_dictionary
+{
+public:
+	//! \brief constructor
+	memdb_dictionary();
+	//! \brief destructor
+	~memdb_dictionary();
+
+	//! \brief starts empty dictionary for string or wide string column, db_unknown stops encoding
+	void
+	create(			dbtypes type							//!< column type
+					);
+	//! \brief checks if column is encoded
+	inline
+	bool
+	is_active() const
+	{
+		return _type != db_unknown;
+	}
+	//! \brief returns the number of distinct values
+	inline
+	size_t
+	size() const
+	{
+		return _count;
+	}
+	//! \brief returns the number of slots
+	inline
+	size_t
+	get_capacity() const
+	{
+		return _capacity;
+	}
+	//! \brief returns entry in slot, 0 for empty slot
+	inline
+	const memdb_dictionary_entry*
+	get_slot(		size_t slot								//!< slot
+					) const
+	{
+		return _slots[slot];
+	}
+	//! \brief returns the shared value, adds new one for the first time
+	//! returns 0 if no memory
+	const void*
+	intern(			const void* value,						//!< string or wide string
+					byte_allocator& all						//!< table allocator
+					);
+	//! \brief adds entry kept outside of table allocator, like restored snapshot
+	bool
+	attach(			memdb_dictionary_entry* entry			//!< entry
+					);
+	//! \brief sorts values and assigns ranks
+	//! must not run while lookups compare rows
+	bool
+	rank();
+
+private:
+	//! \brief doubles slots
+	bool
+	grow();
+	//! \brief puts entry to the free slot, there must be room for it
+	void
+	put(			memdb_dictionary_entry* entry			//!< entry
+					);
+
+private:
+	dbtypes				_type;								//!< column type
+	memdb_dictionary_entry** _slots;						//!< open addressing slots
+	size_t				_capacity;							//!< number of slots, power of two
+	size_t				_count;								//!< number of values
+	size_t				_ranked;							//!< number of ranked values
+};
+
 //! \class memdb_row
 //! \brief db row
+//! row of columnar table keeps values and status in memdb_columns at position _pos,
+//! lookup rows and rows of row based table keep them in the row itself
+//! every update makes the new version of row, lookup sees the version
+//! if it has been committed before the lookup started and has not been replaced before that
 class memdb_row
 {
 public:
+	//! \brief constructor
+	memdb_row() :
+		_status(status_lookup),
+		_pos(os_minus_one),
+		_begin(0),
+		_end(memdb_epoch_infinite)
+	{
+	}
+
+	//! \brief checks if version is seen by snapshot
+	inline
+	bool
+	is_visible(		size_t snapshot							//!< epoch of snapshot
+					) const
+	{
+		return _begin <= snapshot && snapshot < _end;
+	}
+
 	_vector< terimber_db_value >		_row;				//!< DB row
 	terimber_db_row_status				_status;			//!< row status
+	size_t								_pos;				//!< position in column store, os_minus_one - values are in _row
+	size_t								_begin;				//!< epoch the version has been committed at
+	size_t								_end;				//!< epoch the version has been replaced or deleted at
+};
+
+//! \class memdb_column
+//! \brief one column of columnar table
+//! values of fixed size types and numerics are stored in the contiguous typed array,
+//! strings, binaries and guids are stored as pointers to the table allocator
+class memdb_column
+{
+public:
+	//! \brief constructor
+	memdb_column();
+
+	//! \brief checks if the value is null
+	inline
+	bool
+	is_null(		size_t pos								//!< row position
+					) const
+	{
+		return (_nulls[pos >> 5] & (1 << (pos & 31))) != 0;
+	}
+	//! \brief returns the typed array
+	//! the array is valid until the next row has been added to the table
+	inline
+	const void*
+	get_data() const
+	{
+		return _data;
+	}
+	//! \brief returns the null bitmap, one bit per row
+	inline
+	const ub4_t*
+	get_nulls() const
+	{
+		return _nulls;
+	}
+	//! \brief returns the size of value in bytes
+	inline
+	size_t
+	get_width() const
+	{
+		return _width;
+	}
+	//! \brief returns the value of string, binary or guid column
+	//! restored snapshot keeps heap offsets with the lowest bit set instead of pointers,
+	//! allocator pointers are aligned, so the bit is always clear for them
+	inline
+	const ub1_t*
+	get_pointer(	size_t pos								//!< row position
+					) const
+	{
+		size_t value = *(const size_t*)(_data + pos * _width);
+		return value & 1 ? _heap + (value >> 1) : (const ub1_t*)value;
+	}
+
+public:
+	dbtypes				_type;								//!< column type
+	size_t				_width;								//!< size of value in bytes
+	ub1_t*				_data;								//!< typed array
+	size_t				_data_size;							//!< allocated size of typed array
+	ub4_t*				_nulls;								//!< null bitmap
+	size_t				_nulls_size;						//!< allocated size of null bitmap
+	const ub1_t*		_heap;								//!< value heap of restored snapshot
+};
+
+//! \class memdb_retired_array
+//! \brief array replaced by growth, lookups can still read it
+class memdb_retired_array
+{
+public:
+	void*				_ptr;								//!< array
+	size_t				_size;								//!< allocated size
+};
+
+//! \class memdb_columns
+//! \brief column store of columnar table
+//! keeps one typed array per column, null bitmaps and the row status array
+//! arrays grow twice on demand, positions of rows never change
+//! positions of unlinked row versions are reused by the next rows
+class memdb_columns
+{
+public:
+	//! \brief constructor
+	memdb_columns(	chunk_provider* provider = 0			//!< chunk provider for arrays, 0 - general heap
+					);
+	//! \brief destructor
+	~memdb_columns();
+
+	//! \brief creates columns
+	bool
+	create(			const binders_t& cols					//!< table columns
+					);
+	//! \brief releases arrays and columns
+	void
+	clear();
+	//! \brief adds the row with all nulls and status
+	//! returns the position or os_minus_one if no memory
+	size_t
+	add_row(		terimber_db_row_status status			//!< row status
+					);
+	//! \brief returns position of unlinked row version for reuse
+	//! row must not be seen by any lookup
+	void
+	free_row(		size_t pos								//!< row position
+					);
+	//! \brief releases arrays replaced by growth
+	//! must be called when no lookup can read the old arrays
+	void
+	release_retired();
+	//! \brief checks if there are arrays replaced by growth
+	inline
+	bool
+	has_retired() const
+	{
+		return !_retired.empty();
+	}
+	//! \brief stores value to the typed array element
+	static
+	void
+	store_value(	dbtypes type,							//!< column type
+					const terimber_db_value& value,			//!< not null value
+					ub1_t* ptr								//!< [out] array element
+					);
+	//! \brief copies values to the row
+	void
+	set_values(		size_t pos,								//!< row position
+					const terimber_db_value* values			//!< values, one per column
+					);
+	//! \brief points row status array to the mapped memory
+	//! mapped arrays are never released, they are copied on the first growth
+	void
+	attach_rows(	size_t rows,							//!< number of rows
+					ub1_t* status							//!< row status array
+					);
+	//! \brief points column arrays to the mapped memory
+	void
+	attach_column(	size_t index,							//!< column index
+					ub1_t* data,							//!< typed array
+					ub4_t* nulls,							//!< null bitmap
+					const ub1_t* heap						//!< value heap
+					);
+
+	//! \brief returns the number of row positions including the deleted new rows
+	inline
+	size_t
+	get_row_count() const
+	{
+		return _rows;
+	}
+	//! \brief returns the number of columns
+	inline
+	size_t
+	get_column_count() const
+	{
+		return _count;
+	}
+	//! \brief returns column
+	inline
+	const memdb_column&
+	get_column(		size_t index							//!< column index
+					) const
+	{
+		return _columns[index];
+	}
+	//! \brief returns the row status array
+	inline
+	const ub1_t*
+	get_statuses() const
+	{
+		return _status;
+	}
+
+	//! \brief returns the status of row
+	inline
+	terimber_db_row_status
+	get_status(		const memdb_row& row					//!< row
+					) const;
+	//! \brief sets the status of row
+	inline
+	void
+	set_status(		memdb_row& row,							//!< row
+					terimber_db_row_status status			//!< new status
+					);
+	//! \brief checks if the row value is null
+	inline
+	bool
+	is_null(		const memdb_row& row,					//!< row
+					size_t index							//!< column index
+					) const;
+	//! \brief returns the row value
+	//! for 32 bit platforms 8 bytes values point to the typed array
+	inline
+	terimber_db_value
+	get_value(		const memdb_row& row,					//!< row
+					size_t index							//!< column index
+					) const;
+
+private:
+	//! \brief grows all arrays
+	//! old arrays are retired, lookups can still read them
+	bool
+	grow(			size_t capacity							//!< new capacity in rows
+					);
+	//! \brief retires array allocated by memdb_allocate
+	void
+	retire(			void* ptr,								//!< array
+					size_t size								//!< allocated size
+					);
+
+private:
+	chunk_provider*		_provider;							//!< chunk provider
+	memdb_column*		_columns;							//!< columns
+	size_t				_count;								//!< number of columns
+	ub1_t*				_status;							//!< row status array
+	size_t				_status_size;						//!< allocated size of row status array
+	size_t				_rows;								//!< number of rows
+	size_t				_capacity;							//!< capacity in rows
+	bool				_mapped;							//!< arrays are in the mapped memory
+	list< size_t >		_free;								//!< positions of unlinked rows
+	list< memdb_retired_array > _retired;					//!< arrays replaced by growth
 };
 
 //! \typedef memdb_rowset_t
@@ -428,9 +969,11 @@ class memdb_rowset_less
 {
 public:
 	//! \brief constructor
-	memdb_rowset_less(const terimber_index_column_array_t& info //!< index columns array
-					) : 
-		_info(info) 
+	memdb_rowset_less(const terimber_index_column_array_t& info, //!< index columns array
+					const memdb_columns* columns			//!< column store of the table
+					) :
+		_info(info),
+		_columns(columns)
 	{
 	}
 	//! \brief operator ()
@@ -444,8 +987,20 @@ public:
 	{ 
 		return _info; 
 	}
+	//! \brief produces hash of index columns values
+	inline
+	size_t
+	hash(			const memdb_rowset_citerator_t& row		//!< row or lookup row
+					) const;
+	//! \brief checks if index columns values are equal, deleted rows are not equal to anything
+	inline
+	bool
+	equal(			const memdb_rowset_citerator_t& first,	//!< first row
+					const memdb_rowset_citerator_t& second	//!< second row
+					) const;
 private:
 	terimber_index_column_array_t	_info;					//!< index column information
+	const memdb_columns*			_columns;				//!< column store
 };
 
 //! \typedef memdb_index_t
@@ -455,23 +1010,147 @@ typedef map< memdb_rowset_citerator_t, memdb_rowset_citerator_t, memdb_rowset_le
 //! \brief const iterator of memdb_index_t
 typedef memdb_index_t::const_iterator memdb_index_citer_t; 
 
+//! \typedef memdb_rownode_t
+//! \brief node of rowset
+typedef memdb_rowset_t::_node memdb_rownode_t;
+
+//! \class memdb_hash_entry
+//! \brief slot of hash index
+class memdb_hash_entry
+{
+public:
+	size_t				_hash;								//!< precomputed hash of index columns
+	memdb_rownode_t*	_row;								//!< row node, 0 - free slot
+	bool				_removed;							//!< slot has been freed, probing goes on
+};
+
+//! \class memdb_hash_index
+//! \brief open addressing hash table with linear probing
+//! rows with the same key stay in one probe sequence
+class memdb_hash_index
+{
+public:
+	//! \brief constructor
+	memdb_hash_index(const memdb_rowset_less& pred,		//!< predicate for hash and equality
+					chunk_provider* provider				//!< chunk provider for the table, 0 - general heap
+					);
+	//! \brief destructor
+	~memdb_hash_index();
+
+	//! \brief makes room for rows
+	bool
+	reserve(		size_t rows								//!< expected number of rows
+					);
+	//! \brief inserts row
+	//! goes on with the current table if it can't grow, fails only if there is no room left
+	bool
+	insert(			memdb_rowset_citerator_t row			//!< row iterator
+					);
+	//! \brief erases row
+	bool
+	erase(			memdb_rowset_citerator_t row			//!< row iterator
+					);
+	//! \brief finds the next slot with the row equal to key
+	//! returns os_minus_one if there are no more rows
+	size_t
+	find(			memdb_rowset_citerator_t key,			//!< lookup row
+					size_t hash,							//!< hash of key
+					size_t slot								//!< previous slot, os_minus_one - from the beginning
+					) const;
+	//! \brief finds the slot of row
+	size_t
+	find_row(		memdb_rowset_citerator_t row			//!< row iterator
+					) const;
+	//! \brief returns the row node at the slot, 0 for a free slot
+	inline
+	memdb_rownode_t*
+	get_node(		size_t slot								//!< slot
+					) const
+	{
+		return slot < _capacity ? _table[slot]._row : 0;
+	}
+	//! \brief returns predicate
+	inline
+	const memdb_rowset_less&
+	comp() const
+	{
+		return _pred;
+	}
+	//! \brief removes all rows, keeps slots allocated
+	void
+	clear();
+
+private:
+	//! \brief rebuilds table with the new capacity, removed slots are dropped
+	bool
+	rehash(			size_t capacity							//!< new capacity, power of 2
+					);
+
+private:
+	memdb_rowset_less	_pred;								//!< predicate
+	chunk_provider*		_provider;							//!< chunk provider
+	memdb_hash_entry*	_table;								//!< slots
+	size_t				_table_size;						//!< allocated size of slots
+	size_t				_capacity;							//!< number of slots
+	size_t				_used;								//!< number of rows
+	size_t				_removed;							//!< number of removed slots
+};
+
+//! \brief allocates array on chunk provider or general heap
+void*
+memdb_allocate(		chunk_provider* provider,				//!< chunk provider, can be null
+					size_t& size							//!< [in, out] size in bytes
+					);
+//! \brief releases array allocated by memdb_allocate
+void
+memdb_release(		chunk_provider* provider,				//!< chunk provider, can be null
+					void* ptr,								//!< array
+					size_t size								//!< size returned by memdb_allocate
+					);
+
 // forward declaration
 class memindex;
 class memlookup;
+class memscan;
+class memdb_populator;
+
+//! \class memdb_retired_row
+//! \brief row version replaced or deleted, lookups started before that can still see it
+class memdb_retired_row
+{
+public:
+	memdb_rownode_t*	_row;								//!< row node
+	bool				_unlink;							//!< removes version from rowset, otherwise marks it as deleted
+};
 
 //! \class memtable 
 //! \brief interface to memory table
 class memtable : public terimber_memtable
 {
+	//! pipelined population
+	friend class memdb_populator;
+	//! scan reads rows under table mutex
+	friend class memscan;
 	//! \typedef list_indexes_t
 	//! \brief list of memindex pointers
 	typedef list< memindex* > list_indexes_t;
+	//! \typedef list_scans_t
+	//! \brief list of memscan pointers
+	typedef list< memscan* > list_scans_t;
 	//! \typedef list_values_t
 	//! \brief list of value vector pointers
 	typedef list< terimber_db_value_vector_impl* > list_values_t;
+	//! \typedef list_retired_t
+	//! \brief list of row versions waiting for reclamation
+	typedef list< memdb_retired_row > list_retired_t;
+	//! \typedef list_spare_t
+	//! \brief list of value vectors of reclaimed versions
+	typedef list< _vector< terimber_db_value > > list_spare_t;
 public:
 	//! \brief constructor
-	memtable();
+	memtable(		chunk_provider* provider = 0,			//!< chunk provider for rows and indexes, 0 - general heap
+					bool columnar = false					//!< keeps values in column store instead of rows
+					);
 	//! \brief destructor
 	//! user is responsible for destoying memtable object
 	virtual 
@@ -515,6 +1194,14 @@ public:
 	virtual 
 	void 
 	refresh();
+	//! \brief applies changed rows fetched by server
+	virtual 
+	bool 
+	populate_delta(	dbserver* server,						//!< dbserver instance
+					size_t key_count,						//!< number of key columns
+					const size_t keys[],					//!< key column indexes
+					size_t deleted_column					//!< recordset column of delete flag, -1 - no deletions
+					);
 	//! \brief after population and any time after that you can request the number of rows in table
 	virtual 
 	size_t
@@ -570,7 +1257,8 @@ public:
 	virtual 
 	terimber_memindex* 
 	add_index(		size_t columns,							//!< columns in index
-					const terimber_index_column_info info[]	//!< array of index columns' descriptions
+					const terimber_index_column_info info[],//!< array of index columns' descriptions
+					terimber_index_kind kind = index_ordered//!< kind of index
 					);
 
 	//! \brief destroy index
@@ -594,6 +1282,43 @@ public:
 	destroy_db_values(terimber_db_value_vector* obj			//!< value array pointer
 					);
 
+	//! \brief saves columns, rows and indexes to the snapshot file
+	virtual
+	bool
+	save_snapshot(	const char* file_name					//!< file name
+					);
+	//! \brief replaces table with the snapshot mapped from file
+	virtual
+	bool
+	restore_snapshot(const char* file_name					//!< file name
+					);
+	//! \brief returns the number of indexes
+	virtual
+	size_t
+	get_index_count();
+	//! \brief returns index
+	virtual
+	terimber_memindex*
+	get_index(		size_t index							//!< index number
+					);
+
+	//! \brief creates scan
+	virtual 
+	terimber_memscan* 
+	add_scan();
+	//! \brief destroys scan
+	virtual 
+	bool 
+	remove_scan(	terimber_memscan* obj					//!< scan pointer
+					);
+
+	//! \brief switches dictionary encoding of string column
+	virtual
+	bool
+	set_column_dictionary(size_t index,						//!< column index
+					bool dictionary							//!< true - values are kept in dictionary
+					);
+
 public:
 	//! \brief returns rowset
 	inline 
@@ -609,6 +1334,57 @@ public:
 	{ 
 		return _cols; 
 	}
+	//! \brief returns chunk provider
+	inline 
+	chunk_provider* 
+	get_provider() const 
+	{ 
+		return _allocator.provider(); 
+	}
+	//! \brief returns true for columnar table
+	inline
+	bool
+	is_columnar() const
+	{
+		return _columnar;
+	}
+	//! \brief returns column store, empty for row based table
+	inline
+	const memdb_columns&
+	get_columns() const
+	{
+		return _columns;
+	}
+	//! \brief returns column dictionary, 0 if column is not encoded
+	inline
+	const memdb_dictionary*
+	get_dictionary(	size_t index							//!< column index
+					) const
+	{
+		return _dictionaries && _dictionaries[index].is_active() ? _dictionaries + index : 0;
+	}
+	//! \brief returns the size of table allocator chunks, values of rows and strings are there
+	inline
+	size_t
+	get_allocated() const
+	{
+		return _allocator.capacity() * _allocator.count();
+	}
+	//! \brief returns latch, lookups take it for one step
+	inline
+	memdb_latch&
+	get_latch() const
+	{
+		return _latch;
+	}
+	//! \brief returns the epoch of the last committed change, lookups take it as snapshot
+	//! must be called under latch
+	inline
+	size_t
+	get_epoch() const
+	{
+		return _epoch;
+	}
 	//! \brief inserts new row
 	//! if row is modified it will still have a status = new
 	//! if row is removed it's just deleted from recordset
@@ -617,6 +1393,8 @@ public:
 	insert_row(		const terimber_db_value_vector* info	//!< value vector
 					);
 	//! \brief updates row
+	//! the new version of row is made, the old one is seen by lookups started before
+	//! fails if the row version has been replaced or deleted already
 	bool 
 	update_row(		memdb_rowset_citerator_t iter,			//!< row iterator for update
 					const terimber_db_value_vector* info	//!< value vector
@@ -624,6 +1402,7 @@ public:
 	//! \brief deletes existing row
 	//! if row was in original recordset (modified or not), it will have a status = delete, and will not be accessible anymore
 	//! deleting of new row will just remove row from recordset
+	//! both happen when lookups started before deletion have finished
 	bool 
 	delete_row(		memdb_rowset_citerator_t iter			//!< row iterator for deletion
 					);
@@ -632,14 +1411,102 @@ private:
 	//! \brief uninit
 	void 
 	uninit();
+	//! \brief clears rows and columns, keeps indexes and value vectors
+	void
+	clear_rows();
+	//! \brief checks if recordset has the same columns as the table
+	bool
+	same_columns(	const dbserver* server					//!< dbserver instance after fetching
+					) const;
+	//! \brief prepares column store after columns have been defined
+	bool
+	init_columns();
+	//! \brief inserts new row with values from source, notifies indexes
+	//! source is dbserver or value vector
+	template < class S >
+	bool
+	insert_source(	const S* source							//!< values source
+					);
+	//! \brief makes new version of row with values from source, notifies indexes
+	template < class S >
+	bool
+	update_source(	memdb_rowset_citerator_t iter,			//!< row iterator for update
+					const S* source							//!< values source
+					);
+	//! \brief finds hash index on key columns in the given order, creates it if there is none
+	memindex*
+	find_key_index(	size_t key_count,						//!< number of key columns
+					const size_t keys[]						//!< key column indexes
+					);
+	//! \brief adds new row to rowset and copies values from source
+	//! source is dbserver or value vector
+	template < class S >
+	bool
+	add_row(		const S* source,						//!< values source
+					terimber_db_row_status status			//!< row status
+					);
+	//! \brief copies values from source without touching rowset and column store
+	//! row based table keeps values in the row, columnar table in the values array
+	//! only internal allocator is used, so rows can be copied by one thread
+	//! while the other links the rows copied before
+	template < class S >
+	bool
+	copy_row(		const S* source,						//!< values source
+					terimber_db_row_status status,			//!< row status
+					memdb_row& row,							//!< [out] row
+					terimber_db_value* values				//!< [out] values for column store
+					);
+	//! \brief inserts row copied by copy_row to rowset
+	bool
+	link_row(		const memdb_row& row,					//!< row
+					const terimber_db_value* values,		//!< values for column store
+					memdb_rowset_iterator_t where			//!< row is inserted before
+					);
+	//! \brief gives value vector of reclaimed version to row based table row
+	void
+	reuse_row(		memdb_row& row							//!< [out] row
+					);
+	//! \brief publishes change made under latch, lookups started after see it
+	void
+	publish(			size_t epoch							//!< epoch of change
+					);
+	//! \brief removes row versions which can't be seen by lookups anymore
+	//! must be called under latch
+	void
+	reclaim();
+	//! \brief assigns ranks to the values added to dictionaries after the last sorting
+	//! must not run while lookups compare rows
+	bool
+	rank_dictionaries();
+	//! \brief creates index, rows sorted in index order can be provided
+	memindex*
+	create_index(	size_t columns,							//!< columns in index
+					const terimber_index_column_info info[],//!< array of index columns' descriptions
+					terimber_index_kind kind,				//!< kind of index
+					memdb_rownode_t* const* sorted,			//!< rows in index order, 0 - sorts rows
+					size_t count							//!< number of sorted rows
+					);
 private:
 	byte_allocator		_allocator;							//!< internal allocator
 	binders_t			_cols;								//!< columns binders
 	memdb_rowset_t		_rowset;							//!< rowset
+	bool				_columnar;							//!< columnar layout
+	memdb_columns		_columns;							//!< column store for columnar layout
+	_vector< terimber_db_value > _row_values;				//!< values of row being copied to column store
 	string_t			_error;								//!< last error
 	mutex				_mtx;								//!< mutex 
 	list_indexes_t		_indexes;							//!< list of indexes
 	list_values_t		_values;							//!< list of value vectors
+	list_scans_t		_scans;								//!< list of scans
+	memdb_dictionary*	_dictionaries;						//!< column dictionaries, 0 - no encoded columns
+	vector< bool >		_dictionary_columns;				//!< dictionary flags by column index, kept by populate and create
+	filememmapper		_mapper;							//!< mapped snapshot
+	mutable memdb_latch	_latch;								//!< latch of lookup steps
+	volatile size_t		_epoch;								//!< epoch of the last committed change
+	list_retired_t		_retired;							//!< row versions waiting for reclamation
+	size_t				_unlinked;							//!< retired versions to be removed from rowset
+	list_spare_t		_spare;								//!< value vectors of reclaimed versions
+	size_t				_arrays_epoch;						//!< epoch column arrays have been retired at
 };
 
 //! \class memindex
@@ -649,13 +1516,16 @@ class memindex :	public terimber_memindex,
 {
 	//! memtable
 	friend class memtable;
+	//! pipelined population
+	friend class memdb_populator;
 	//! \typedef list_lookups_t
 	//! \brief list of lookups
 	typedef list< memlookup* > list_lookups_t;
 protected:
 	//! \brief constructor
 	memindex(		memtable& parent,						//!< parent memtable
-					const memdb_rowset_less& pred			//!< predicate for row copmparision
+					const memdb_rowset_less& pred,			//!< predicate for row copmparision
+					bool hashed								//!< hash index
 					);
 	//! \brief destructor
 	//! users can't call destructor, memtable will take case about cleanup
@@ -707,20 +1577,58 @@ public:
 	{ 
 		return _index; 
 	}
+	//! \brief returns true for hash index
+	inline
+	bool
+	is_hashed() const
+	{
+		return _hashed;
+	}
+	//! \brief returns hash table
+	inline
+	const memdb_hash_index&
+	get_hash() const
+	{
+		return _hash;
+	}
+	//! \brief returns false if hash table missed a row, index is not used until it is constructed again
+	inline
+	bool
+	is_usable() const
+	{
+		return _usable;
+	}
 
 private:
 	//! \brief constructs index
 	bool
 	construct();
-	//! \brief notifies all lookup about changes
+	//! \brief inserts row to or erases row from index
+	//! lookups in scan move their bounds from the erased row
 	void 
 	notify(			memdb_rowset_citerator_t iter,			//!< affected row iterator
 					bool insert_or_delete					//!< deleted or not 
 					);
+	//! \brief builds ordered index from rows already sorted
+	bool
+	construct(		memdb_rownode_t* const* sorted,			//!< rows in index order
+					size_t count							//!< number of rows
+					);
+	//! \brief removes all rows from index before table is populated again
+	//! lookups are kept and must be reset after population
+	void
+	clear();
+	//! \brief returns the oldest snapshot of lookups in scan
+	size_t
+	get_min_snapshot(size_t snapshot						//!< the oldest snapshot so far
+					);
 
 private:
 	memtable&		_parent;								//!< parent memtable
 	memdb_index_t	_index;									//!< index table
+	bool			_hashed;								//!< hash index
+	memdb_hash_index _hash;									//!< hash table
+	bool			_usable;								//!< hash table has all rows
 	mutex			_mtx;									//!< mutex
 	list_lookups_t	_lookups;								//!< list of lookups
 };
@@ -914,8 +1822,8 @@ public:
 	//! the current row can be changed
 	//! there are possible scenarios
 	//! 1. inserts the new row - it will become the current one
-	//! 2. updates the current row - it will be the same current row, only index columns are affected
-	//! 3. deletes the current row - the current row will be next to the current one or current will point to the out of row sequence
+	//! 2. updates the current row - lookup will be outside the row sequence, the next scan sees the new version
+	//! 3. deletes the current row - lookup will be outside the row sequence
 
 	//! \brief inserts new row
 	//! if the row is modified it will still have a status = new
@@ -957,11 +1865,36 @@ public:
 	get_row_status();
 
 private:
-	//! \brief make changes according to the action 
+	//! \brief moves bounds from the row being erased
 	void 
-	notify(			memdb_index_citer_t iter,				//!< affected row iterator
-					bool insert_or_delete					//!< remove row or not
+	notify(			memdb_index_citer_t iter				//!< row iterator being erased
 					);
+	//! \brief finds the current row again after hash table has been changed
+	void
+	notify_hash();
+	//! \brief moves lookup outside the row sequence after index has been cleared
+	void
+	notify_clear();
+	//! \brief returns the current row
+	//! returns false if lookup is outside the row sequence
+	inline
+	bool
+	get_current(	memdb_rowset_citerator_t& iter			//!< [out] current row
+					) const;
+	//! \brief takes snapshot and sets bounds, must be called under latch
+	void
+	start_scan() const;
+	//! \brief moves lookup outside the row sequence and releases snapshot
+	inline
+	void
+	stop_scan() const;
+	//! \brief returns the snapshot of scan, 0 - lookup is outside the row sequence
+	inline
+	size_t
+	get_snapshot() const
+	{
+		return _snapshot;
+	}
 	//! \brief converts value to the different type
 	terimber_xml_value 
 	get_value_as_value(size_t index,						//!< index
@@ -971,11 +1904,306 @@ private:
 private:
 	mutable byte_allocator			_tmp_allocator;			//!< temporary allocator
 	memindex&						_parent;				//!< parent memory index
-	memdb_index_citer_t				_low_bounder;			//!< lower bound iterator
-	memdb_index_citer_t				_upper_bounder;			//!< upper bound iterator
+	mutable memdb_index_citer_t		_low_bounder;			//!< lower bound iterator
+	mutable memdb_index_citer_t		_upper_bounder;			//!< upper bound iterator
 	mutable memdb_index_citer_t		_current_iter;			//!< current iterator
 	byte_allocator					_condition_allocator;	//!< consition allocator
 	memdb_rowset_t					_condition_rowset;		//!< condition rowset
+	bool							_keyed;					//!< lookup has conditions
+	size_t							_key_hash;				//!< hash of conditions
+	mutable size_t					_slot;					//!< current slot of keyed hash lookup
+	mutable memdb_rownode_t*		_current_row;			//!< current row, 0 - outside the row sequence
+	mutable volatile size_t			_snapshot;				//!< epoch the scan sees, 0 - no scan
+};
+
+//! \brief rows in one batch of scan, multiple of 32
+const size_t memdb_scan_batch = 1024;
+
+//! \class memdb_scan_range
+//! \brief range of predicate values in column type
+//! integer bounds are inclusive, equality has the same bounds
+class memdb_scan_range
+{
+public:
+	sb8_t				_llow;								//!< lower bound of integer, boolean or date column
+	sb8_t				_lhigh;								//!< upper bound of integer, boolean or date column
+	double				_dlow;								//!< lower bound of floating point column
+	double				_dhigh;								//!< upper bound of floating point column
+	const void*			_slow;								//!< lower bound of string column, 0 - no bound
+	const void*			_shigh;								//!< upper bound of string column, 0 - no bound
+	bool				_low_strict;						//!< lower bound is excluded, floating point and string columns
+	bool				_high_strict;						//!< upper bound is excluded, floating point and string columns
+};
+
+//! \class memdb_scan_predicate
+//! \brief predicate of scan, column matches one of ranges
+class memdb_scan_predicate
+{
+public:
+	size_t				_index;								//!< column index
+	dbtypes				_type;								//!< column type
+	_vector< memdb_scan_range > _ranges;					//!< ranges on scan allocator
+};
+
+//! \class memdb_scan_aggregate
+//! \brief aggregate of scan
+class memdb_scan_aggregate
+{
+public:
+	size_t				_index;								//!< column index, os_minus_one - count of rows
+	dbtypes				_type;								//!< column type
+	terimber_scan_function _function;						//!< aggregate function
+};
+
+//! \class memdb_scan_group
+//! \brief group column of scan
+class memdb_scan_group
+{
+public:
+	size_t				_index;								//!< column index
+	dbtypes				_type;								//!< column type
+};
+
+//! \class memdb_scan_accumulator
+//! \brief aggregate value of group
+//! integer columns are accumulated as int64, floating point columns as double
+class memdb_scan_accumulator
+{
+public:
+	ub8_t				_count;								//!< number of values
+	sb8_t				_lsum;								//!< sum of integer values
+	sb8_t				_lmin;								//!< minimum of integer values
+	sb8_t				_lmax;								//!< maximum of integer values
+	double				_dsum;								//!< sum of floating point values
+	double				_dmin;								//!< minimum of floating point values
+	double				_dmax;								//!< maximum of floating point values
+};
+
+//! \class memdb_scan_key
+//! \brief value of group column
+class memdb_scan_key
+{
+public:
+	bool				_null;								//!< null value
+	sb8_t				_long;								//!< value of boolean, integer or date column
+	const char*			_string;							//!< value of string column
+};
+
+//! \class memdb_scan_column
+//! \brief values of column in the current batch
+class memdb_scan_column
+{
+public:
+	const ub1_t*		_data;								//!< typed array from the batch beginning
+	size_t				_width;								//!< size of value in bytes
+	const ub4_t*		_nulls;								//!< null bitmap from the batch beginning
+	const ub1_t*		_heap;								//!< value heap of restored snapshot
+};
+
+//! \class memscan
+//! \brief implementation of terimber_memscan interface
+//! columnar table is scanned in place, 
+//! rows of row based table are gathered batch by batch to the typed arrays of the scan
+class memscan :		public terimber_memscan,
+					public terimber_log_helper
+{
+	//! memtable
+	friend class memtable;
+	//! \typedef list_predicates_t
+	//! \brief list of predicates
+	typedef list< memdb_scan_predicate > list_predicates_t;
+	//! \typedef list_aggregates_t
+	//! \brief list of aggregates
+	typedef list< memdb_scan_aggregate > list_aggregates_t;
+	//! \typedef list_groups_t
+	//! \brief list of group columns
+	typedef list< memdb_scan_group > list_groups_t;
+protected:
+	//! \brief constructor
+	memscan(		memtable& parent						//!< parent memtable
+					);
+	//! \brief destructor
+	virtual 
+	~memscan();
+
+public:
+	//! \brief returns the last occured error
+	virtual 
+	const char* 
+	get_last_error();
+	//! \brief adds predicate on column
+	virtual 
+	bool 
+	add_predicate(	size_t index,							//!< column index
+					terimber_scan_operator op,				//!< operator
+					const terimber_db_value_vector* values	//!< values
+					);
+	//! \brief adds aggregate
+	virtual 
+	bool 
+	add_aggregate(	size_t index,							//!< column index
+					terimber_scan_function function			//!< aggregate function
+					);
+	//! \brief adds group column
+	virtual 
+	bool 
+	add_group(		size_t index							//!< column index
+					);
+	//! \brief removes predicates, aggregates, group columns and results
+	virtual 
+	void 
+	clear();
+	//! \brief selects rows, computes aggregates and groups
+	virtual 
+	bool 
+	execute();
+
+	//! \brief returns the number of selected rows
+	virtual 
+	size_t 
+	get_selected_count() const;
+	//! \brief returns the selection vector
+	virtual 
+	const size_t* 
+	get_selection() const;
+	//! \brief checks if value of selected row is null
+	virtual 
+	bool 
+	get_value_is_null(size_t row,							//!< selected row
+					size_t index							//!< column index
+					) const;
+	//! \brief gets value of selected row as a int64
+	virtual 
+	sb8_t 
+	get_value_as_long64(size_t row,							//!< selected row
+					size_t index							//!< column index
+					) const;
+	//! \brief gets value of selected row as a double
+	virtual 
+	double 
+	get_value_as_double(size_t row,							//!< selected row
+					size_t index							//!< column index
+					) const;
+	//! \brief gets value of selected row as a string
+	virtual 
+	const char* 
+	get_value_as_string(size_t row,							//!< selected row
+					size_t index							//!< column index
+					) const;
+
+	//! \brief returns the number of groups
+	virtual 
+	size_t 
+	get_group_count() const;
+	//! \brief checks if value of group column is null
+	virtual 
+	bool 
+	get_group_value_is_null(size_t group,					//!< group
+					size_t index							//!< group column number
+					) const;
+	//! \brief gets value of boolean, integer or date group column
+	virtual 
+	sb8_t 
+	get_group_value_as_long64(size_t group,					//!< group
+					size_t index							//!< group column number
+					) const;
+	//! \brief gets value of string group column
+	virtual 
+	const char* 
+	get_group_value_as_string(size_t group,					//!< group
+					size_t index							//!< group column number
+					) const;
+	//! \brief checks if aggregate has no values
+	virtual 
+	bool 
+	get_aggregate_is_null(size_t group,						//!< group
+					size_t index							//!< aggregate number
+					) const;
+	//! \brief gets aggregate as a int64
+	virtual 
+	sb8_t 
+	get_aggregate_as_long64(size_t group,					//!< group
+					size_t index							//!< aggregate number
+					) const;
+	//! \brief gets aggregate as a double
+	virtual 
+	double 
+	get_aggregate_as_double(size_t group,					//!< group
+					size_t index							//!< aggregate number
+					) const;
+
+private:
+	//! \brief releases results and arrays
+	void
+	reset_results();
+	//! \brief scans column store in place
+	bool
+	scan_columns();
+	//! \brief gathers rows of row based table to batches and scans them
+	bool
+	scan_rows();
+	//! \brief evaluates predicates and aggregates over the batch
+	//! _selected_bits must keep live rows of batch
+	bool
+	process_batch(	size_t count,							//!< rows in batch
+					size_t first,							//!< selection value of the first row in batch
+					memdb_rownode_t* const* nodes			//!< rows of row based table, 0 - columnar table
+					);
+	//! \brief evaluates predicate over 32 rows
+	//! fixed size values are compared all at once, strings of candidate rows only
+	static
+	ub4_t
+	match(			const memdb_scan_predicate& pred,		//!< predicate
+					const memdb_scan_column& col,			//!< column of batch
+					size_t word,							//!< word of batch
+					size_t count,							//!< rows in word
+					ub4_t candidates						//!< selected rows with not null values
+					);
+	//! \brief finds or adds group of row
+	//! returns os_minus_one if no memory
+	size_t
+	find_group(		size_t row								//!< row in batch
+					);
+	//! \brief initializes accumulators of the new group
+	bool
+	add_group_accumulators();
+	//! \brief converts value of selected row
+	terimber_xml_value 
+	get_value_as_value(size_t row,							//!< selected row
+					size_t index,							//!< column index
+					vt_types type							//!< output type
+					) const;
+
+private:
+	memtable&						_parent;				//!< parent memory table
+	string_t						_error;					//!< last error
+	byte_allocator					_allocator;				//!< predicate values
+	byte_allocator					_group_allocator;		//!< strings of group keys
+	mutable byte_allocator			_tmp_allocator;			//!< temporary allocator
+	list_predicates_t				_predicates;			//!< predicates
+	list_aggregates_t				_aggregates;			//!< aggregates
+	list_groups_t					_groups;				//!< group columns
+	memdb_scan_column*				_batch;					//!< columns of the current batch
+	ub1_t*							_buffers;				//!< typed arrays of gathered rows
+	ub4_t*							_buffer_nulls;			//!< null bitmaps of gathered rows
+	bool*							_used;					//!< columns used by scan
+	size_t							_column_count;			//!< number of columns in arrays above
+	ub4_t							_selected_bits[memdb_scan_batch / 32]; //!< selection bitmap of batch
+	memdb_rownode_t*				_batch_nodes[memdb_scan_batch]; //!< rows of the current batch of row based table
+	size_t*							_selection;				//!< selection vector
+	size_t							_selected;				//!< number of selected rows
+	size_t							_selection_size;		//!< allocated size of selection vector
+	memdb_rownode_t**				_nodes;					//!< selected rows of row based table
+	size_t							_nodes_size;			//!< allocated size of selected rows
+	size_t							_group_count;			//!< number of groups
+	memdb_scan_key*					_keys;					//!< group keys, one row per group and one for probe
+	size_t							_keys_size;				//!< allocated size of group keys
+	size_t*							_hashes;				//!< hashes of group keys
+	size_t							_hashes_size;			//!< allocated size of hashes
+	memdb_scan_accumulator*			_accumulators;			//!< accumulators, one row per group
+	size_t							_accumulators_size;		//!< allocated size of accumulators
+	size_t*							_slots;					//!< hash table of groups, group number + 1, 0 - free slot
+	size_t							_slots_size;			//!< number of slots, power of 2
 };
 
 
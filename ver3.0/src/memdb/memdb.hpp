@@ -35,6 +35,20 @@
 BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
+//static
+inline
+int
+memdb_decimal::compare(const memdb_decimal& first, const memdb_decimal& second)
+{
+	if (first._scale != second._scale)
+		return compare_scaled(first, second);
+
+	if (first._high != second._high)
+		return first._high < second._high ? -1 : 1;
+
+	return first._low == second._low ? 0 : (first._low < second._low ? -1 : 1);
+}
+
 static 
 inline 
 int 
@@ -45,7 +59,302 @@ compare_db_value(dbtypes type, const terimber_db_value& first, const terimber_db
 	else if (second.nullVal)
 		return 1;
 
-	return compare_value(dbserver_impl::convert_types(type), first.val, second.val, false, case_insensitive);
+	switch (type)
+	{
+		case db_decimal:
+		case db_numeric:
+			return memdb_decimal::compare(*(const memdb_decimal*)first.val.bufVal, *(const memdb_decimal*)second.val.bufVal);
+		default:
+			return compare_value(dbserver_impl::convert_types(type), first.val, second.val, false, case_insensitive);
+	}
+}
+
+//! \brief compares values of dictionary column of two table rows
+//! equal values share the entry, ranked entries compare by ranks without touching characters
+static
+inline
+int
+compare_dictionary_value(dbtypes type, const terimber_db_value& first, const terimber_db_value& second, bool case_insensitive)
+{
+	if (first.nullVal || second.nullVal)
+		return compare_db_value(type, first, second, case_insensitive);
+
+	if (first.val.bufVal == second.val.bufVal)
+		return 0;
+
+	// ranks keep case sensitive order
+	if (!case_insensitive)
+	{
+		size_t first_rank = memdb_dictionary_entry::get(first.val.bufVal)->_rank;
+		size_t second_rank = memdb_dictionary_entry::get(second.val.bufVal)->_rank;
+		if (first_rank && second_rank)
+			return first_rank < second_rank ? -1 : 1;
+	}
+
+	return compare_db_value(type, first, second, case_insensitive);
+}
+
+inline
+terimber_db_row_status
+memdb_columns::get_status(const memdb_row& row) const
+{
+	return row._pos == os_minus_one ? row._status : (terimber_db_row_status)_status[row._pos];
+}
+
+inline
+void
+memdb_columns::set_status(memdb_row& row, terimber_db_row_status status)
+{
+	if (row._pos == os_minus_one)
+		row._status = status;
+	else
+		_status[row._pos] = (ub1_t)status;
+}
+
+inline
+bool
+memdb_columns::is_null(const memdb_row& row, size_t index) const
+{
+	return row._pos == os_minus_one ? row._row[index].nullVal : _columns[index].is_null(row._pos);
+}
+
+inline
+terimber_db_value
+memdb_columns::get_value(const memdb_row& row, size_t index) const
+{
+	if (row._pos == os_minus_one)
+		return row._row[index];
+
+	const memdb_column& col = _columns[index];
+	const ub1_t* ptr = col._data + row._pos * col._width;
+	terimber_db_value val;
+	val.nullVal = col.is_null(row._pos);
+
+	switch (col._type)
+	{
+		case db_bool:
+			val.val.boolVal = *ptr != 0;
+			break;
+		case db_sb1:
+			val.val.cVal = *(const sb1_t*)ptr;
+			break;
+		case db_ub1:
+			val.val.bVal = *ptr;
+			break;
+		case db_sb2:
+			val.val.iVal = *(const sb2_t*)ptr;
+			break;
+		case db_ub2:
+			val.val.uiVal = *(const ub2_t*)ptr;
+			break;
+		case db_sb4:
+			val.val.lVal = *(const sb4_t*)ptr;
+			break;
+		case db_ub4:
+			val.val.ulVal = *(const ub4_t*)ptr;
+			break;
+		case db_float:
+			val.val.fltVal = *(const float*)ptr;
+			break;
+#ifdef OS_64BIT
+		case db_double:
+			val.val.dblVal = *(const double*)ptr;
+			break;
+		case db_sb8:
+		case db_date:
+			val.val.intVal = *(const sb8_t*)ptr;
+			break;
+		case db_ub8:
+			val.val.uintVal = *(const ub8_t*)ptr;
+			break;
+#else
+		case db_double:
+			val.val.dblVal = (const double*)ptr;
+			break;
+		case db_sb8:
+		case db_date:
+			val.val.intVal = (const sb8_t*)ptr;
+			break;
+		case db_ub8:
+			val.val.uintVal = (const ub8_t*)ptr;
+			break;
+#endif
+		case db_decimal:
+		case db_numeric:
+			val.val.bufVal = ptr;
+			break;
+		default:
+			// pointers to the table allocator or to the snapshot heap
+			val.val.bufVal = col.get_pointer(row._pos);
+			break;
+	}
+
+	return val;
+}
+
+//! \brief returns the size of typed array element
+static
+inline
+size_t
+memdb_type_width(dbtypes type)
+{
+	switch (type)
+	{
+		case db_bool:
+		case db_sb1:
+		case db_ub1:
+			return 1;
+		case db_sb2:
+		case db_ub2:
+			return 2;
+		case db_sb4:
+		case db_ub4:
+		case db_float:
+			return 4;
+		case db_double:
+		case db_sb8:
+		case db_ub8:
+		case db_date:
+			return 8;
+		case db_decimal:
+		case db_numeric:
+			return sizeof(memdb_decimal);
+		default:
+			// strings, binaries and guids
+			return sizeof(void*);
+	}
+}
+
+//! \brief hash seed for index columns
+const size_t memdb_hash_seed = 2166136261UL;
+//! \brief hash multiplier for index columns
+const size_t memdb_hash_prime = 16777619UL;
+
+//! \brief adds bytes to hash
+static
+inline
+size_t
+hash_db_bytes(size_t hash, const void* buf, size_t len)
+{
+	const ub1_t* ptr = (const ub1_t*)buf;
+	for (size_t index = 0; index < len; ++index)
+		hash = (hash ^ ptr[index]) * memdb_hash_prime;
+
+	return hash;
+}
+
+//! \brief adds db value to hash
+//! values equal for compare_db_value produce the same hash
+static
+inline
+size_t
+hash_db_value(size_t hash, dbtypes type, const terimber_db_value& value, bool case_insensitive)
+{
+	if (value.nullVal)
+		return (hash ^ 0xff) * memdb_hash_prime;
+
+	switch (type)
+	{
+		case db_bool:
+			return (hash ^ (value.val.boolVal ? 1 : 0)) * memdb_hash_prime;
+		case db_sb1:
+		case db_ub1:
+			return (hash ^ value.val.bVal) * memdb_hash_prime;
+		case db_sb2:
+		case db_ub2:
+			return hash_db_bytes(hash, &value.val.uiVal, sizeof(ub2_t));
+		case db_sb4:
+		case db_ub4:
+			return hash_db_bytes(hash, &value.val.ulVal, sizeof(ub4_t));
+		case db_float:
+			{
+				// -0 equals to 0
+				float val = value.val.fltVal == 0 ? 0 : value.val.fltVal;
+				return hash_db_bytes(hash, &val, sizeof(float));
+			}
+		case db_double:
+			{
+#ifdef OS_64BIT
+				double val = value.val.dblVal;
+#else
+				double val = *value.val.dblVal;
+#endif
+				if (val == 0)
+					val = 0;
+				return hash_db_bytes(hash, &val, sizeof(double));
+			}
+		case db_sb8:
+		case db_ub8:
+		case db_date:
+#ifdef OS_64BIT
+			return hash_db_bytes(hash, &value.val.intVal, sizeof(sb8_t));
+#else
+			return hash_db_bytes(hash, value.val.intVal, sizeof(sb8_t));
+#endif
+		case db_guid:
+			return hash_db_bytes(hash, value.val.guidVal, sizeof(guid_t));
+		case db_decimal:
+		case db_numeric:
+			// equal decimals have the same bytes
+			return hash_db_bytes(hash, value.val.bufVal, sizeof(memdb_decimal));
+		case db_binary:
+			return hash_db_bytes(hash, value.val.bufVal, sizeof(size_t) + *(const size_t*)value.val.bufVal);
+		case db_string:
+			if (!case_insensitive)
+				return hash_db_bytes(hash, value.val.strVal, str_template::strlen(value.val.strVal));
+
+			for (const char* ptr = value.val.strVal; *ptr; ++ptr)
+				hash = (hash ^ (ub1_t)tolower(*ptr)) * memdb_hash_prime;
+			return hash;
+		case db_wstring:
+			if (!case_insensitive)
+				return hash_db_bytes(hash, value.val.wstrVal, str_template::strlen(value.val.wstrVal) * sizeof(wchar_t));
+
+			for (const wchar_t* ptr = value.val.wstrVal; *ptr; ++ptr)
+			{
+				wchar_t ch = (wchar_t)towlower(*ptr);
+				hash = hash_db_bytes(hash, &ch, sizeof(wchar_t));
+			}
+			return hash;
+		default:
+			return hash;
+	}
+}
+
+//! \brief converts value of table column to the requested type
+//! numerics are memdb_decimal on both sides of conversion, throws exception on error
+static
+inline
+terimber_xml_value
+convert_db_value(dbtypes type, const terimber_db_value& value, vt_types to, byte_allocator& all)
+{
+	vt_types from = dbserver_impl::convert_types(type);
+	bool from_decimal = from == vt_decimal || from == vt_numeric;
+	bool to_decimal = to == vt_decimal || to == vt_numeric;
+	if (from == to || (from_decimal && to_decimal))
+		return value.val;
+
+	const char* str = 0;
+	if (from_decimal)
+	{
+		char* buf = (char*)check_pointer(all.allocate(memdb_decimal_chars));
+		((const memdb_decimal*)check_pointer((void*)value.val.bufVal))->format(buf, '.');
+		str = buf;
+	}
+	else
+		str = persist_value(from, value.val, &all);
+
+	if (!to_decimal)
+		return parse_value(to, str, 0xffffffff, &all);
+
+	memdb_decimal* dummy = (memdb_decimal*)check_pointer(all.allocate(sizeof(memdb_decimal)));
+	if (!str || !dummy->parse(str, '.'))
+		exception::_throw("invalid numeric format");
+
+	terimber_xml_value val;
+	memset(&val, 0, sizeof(terimber_xml_value));
+	val.bufVal = (const ub1_t*)dummy;
+	return val;
 }
 
 inline 
@@ -56,74 +365,126 @@ memdb_rowset_less::operator()(const memdb_rowset_citerator_t& first, const memdb
 	size_t length = _info.size();
 	bool first_lookup = false;
 	bool second_lookup = false;
+	terimber_db_row_status first_status = _columns->get_status(*first);
+	terimber_db_row_status second_status = _columns->get_status(*second);
 
-	if (first->_status == status_lookup)
+	if (first_status == status_lookup)
 	{
 		first_lookup = true;
 		length = first->_row.size();
 	}
-	else if (second->_status == status_lookup) // we just inside lookup, adjust length
+	else if (second_status == status_lookup) // we just inside lookup, adjust length
 	{
 		second_lookup = true;
 		length = second->_row.size();
 	}
 
-	if (first->_status == status_deleted
-		|| second->_status == status_deleted)
-		return first->_status < status_deleted;
+	if (first_status == status_deleted
+		|| second_status == status_deleted)
+		return first_status < status_deleted;
 
 	// look through all index columns
+	bool dictionary = !first_lookup && !second_lookup;
 	for (size_t index = 0; index < length; ++index)
 	{
-		int res = compare_db_value(_info[index]._type, first->_row[first_lookup ? index : _info[index]._index], second->_row[second_lookup ? index : _info[index]._index], _info[index]._case_insensitive);
+		const terimber_index_column_info_ex& info = _info[index];
+		terimber_db_value first_value = _columns->get_value(*first, first_lookup ? index : info._index);
+		terimber_db_value second_value = _columns->get_value(*second, second_lookup ? index : info._index);
+		int res = dictionary && info._dictionary ?
+			compare_dictionary_value(info._type, first_value, second_value, info._case_insensitive) :
+			compare_db_value(info._type, first_value, second_value, info._case_insensitive);
 		if (res == 0)
 			continue;
 		else
-			return _info[index]._asc_sort ? res < 0 : res > 0;
+			return info._asc_sort ? res < 0 : res > 0;
 	}
 	
 	return false;
 }
 
+inline
+size_t
+memdb_rowset_less::hash(const memdb_rowset_citerator_t& row) const
+{
+	bool lookup = _columns->get_status(*row) == status_lookup;
+	size_t res = memdb_hash_seed;
+
+	for (size_t index = 0; index < _info.size(); ++index)
+		res = hash_db_value(res, _info[index]._type, _columns->get_value(*row, lookup ? index : _info[index]._index), _info[index]._case_insensitive);
+
+	return res;
+}
+
+inline
+bool
+memdb_rowset_less::equal(const memdb_rowset_citerator_t& first, const memdb_rowset_citerator_t& second) const
+{
+	terimber_db_row_status first_status = _columns->get_status(*first);
+	terimber_db_row_status second_status = _columns->get_status(*second);
+
+	if (first_status == status_deleted
+		|| second_status == status_deleted)
+		return false;
+
+	bool first_lookup = first_status == status_lookup;
+	bool second_lookup = second_status == status_lookup;
+	bool dictionary = !first_lookup && !second_lookup;
+
+	for (size_t index = 0; index < _info.size(); ++index)
+	{
+		const terimber_index_column_info_ex& info = _info[index];
+		terimber_db_value first_value = _columns->get_value(*first, first_lookup ? index : info._index);
+		terimber_db_value second_value = _columns->get_value(*second, second_lookup ? index : info._index);
+		if (dictionary && info._dictionary ?
+			compare_dictionary_value(info._type, first_value, second_value, info._case_insensitive) :
+			compare_db_value(info._type, first_value, second_value, info._case_insensitive))
+			return false;
+	}
+
+	return true;
+}
+
+//! \brief copies values from source to row
+//! strings of encoded columns are taken from dictionaries, numerics are converted to memdb_decimal
 template < class S, class C >
 bool 
-copy_db_row(const S* source, memdb_row& row, C& cols, size_t col_count, byte_allocator& all, string_t& err)
+copy_db_row(const S* source, terimber_db_value* row, C& cols, size_t col_count, byte_allocator& all, string_t& err, memdb_dictionary* dictionaries = 0)
 {
 	// copy values
 	for (size_t icol = 0; icol < col_count; ++icol)
 	{
-		row._row[icol].nullVal = source->get_value_is_null(icol);
-		if (!row._row[icol].nullVal)
+		row[icol].nullVal = source->get_value_is_null(icol);
+		if (!row[icol].nullVal)
 		{
 			switch (cols[icol]._type)
 			{
 				case db_bool:
-					row._row[icol].val.boolVal = source->get_value_as_bool(icol);
+					row[icol].val.boolVal = source->get_value_as_bool(icol);
 					break;
 				case db_sb1:
-					row._row[icol].val.cVal = source->get_value_as_char(icol);
+					row[icol].val.cVal = source->get_value_as_char(icol);
 					break;
 				case db_ub1:
-					row._row[icol].val.bVal = source->get_value_as_byte(icol);
+					row[icol].val.bVal = source->get_value_as_byte(icol);
 					break;
 				case db_sb2:
-					row._row[icol].val.iVal = source->get_value_as_short(icol);
+					row[icol].val.iVal = source->get_value_as_short(icol);
 					break;
 				case db_ub2:
-					row._row[icol].val.uiVal = source->get_value_as_word(icol);
+					row[icol].val.uiVal = source->get_value_as_word(icol);
 					break;
 				case db_sb4:
-					row._row[icol].val.lVal = source->get_value_as_long(icol);
+					row[icol].val.lVal = source->get_value_as_long(icol);
 					break;
 				case db_ub4:
-					row._row[icol].val.ulVal = source->get_value_as_dword(icol);
+					row[icol].val.ulVal = source->get_value_as_dword(icol);
 					break;
 				case db_float:
-					row._row[icol].val.fltVal = source->get_value_as_float(icol);
+					row[icol].val.fltVal = source->get_value_as_float(icol);
 					break;
 				case db_double:
 	#ifdef OS_64BIT
-					row._row[icol].val.dblVal = source->get_value_as_double(icol);
+					row[icol].val.dblVal = source->get_value_as_double(icol);
 	#else
 					{
 						double* dummy = 0;
@@ -135,14 +496,14 @@ copy_db_row(const S* source, memdb_row& row, C& cols, size_t col_count, byte_all
 						}
 
 						*dummy = source->get_value_as_double(icol);
-						row._row[icol].val.dblVal = dummy;
+						row[icol].val.dblVal = dummy;
 					}
 	#endif
 					break;
 				case db_sb8:
 				case db_date:
 	#ifdef OS_64BIT
-					row._row[icol].val.intVal = source->get_value_as_long64(icol);
+					row[icol].val.intVal = source->get_value_as_long64(icol);
 	#else
 					{
 						sb8_t* dummy = 0;
@@ -153,13 +514,13 @@ copy_db_row(const S* source, memdb_row& row, C& cols, size_t col_count, byte_all
 							return false;
 						}
 						*dummy = source->get_value_as_long64(icol);
-						row._row[icol].val.intVal = dummy;
+						row[icol].val.intVal = dummy;
 					}
 	#endif
 					break;
 				case db_ub8:
 	#ifdef OS_64BIT
-					row._row[icol].val.uintVal = source->get_value_as_dword64(icol);
+					row[icol].val.uintVal = source->get_value_as_dword64(icol);
 	#else
 					{
 						ub8_t* dummy = 0;
@@ -170,7 +531,7 @@ copy_db_row(const S* source, memdb_row& row, C& cols, size_t col_count, byte_all
 							return false;
 						}
 						*dummy = source->get_value_as_dword64(icol);
-						row._row[icol].val.uintVal = dummy;
+						row[icol].val.uintVal = dummy;
 					}
 	#endif
 					break;
@@ -178,29 +539,38 @@ copy_db_row(const S* source, memdb_row& row, C& cols, size_t col_count, byte_all
 				case db_numeric:
 					{
 						const char* buf = source->get_value_as_numeric(icol, '.');
-						size_t len = (buf) ? strlen(buf) : 0;
-						numeric conv(buf, len, '.', &all);
-						ub1_t* buff = (ub1_t*)all.allocate(conv.orcl_len());
-						if (!buff)
+						memdb_decimal* dummy = (memdb_decimal*)all.allocate(sizeof(memdb_decimal));
+						if (!dummy)
 						{
 							err = "no enough memory";
 							return false;
 						}
 
-						if (!conv.persist_orcl(buff))
+						if (!buf || !dummy->parse(buf, '.'))
 						{
 							err = "invalid numeric format";
 							return false;
 						}
 
-						row._row[icol].val.bufVal = buff;
+						row[icol].val.bufVal = (const ub1_t*)dummy;
 					}
 					break;
 				case db_string:
-					row._row[icol].val.strVal = copy_string(source->get_value_as_string(icol), all, os_minus_one);
-					break;
 				case db_wstring:
-					row._row[icol].val.wstrVal = copy_string(source->get_value_as_wstring(icol), all, os_minus_one);
+					if (dictionaries && dictionaries[icol].is_active())
+					{
+						const void* value = cols[icol]._type == db_string ? (const void*)source->get_value_as_string(icol) : (const void*)source->get_value_as_wstring(icol);
+						row[icol].val.bufVal = (const ub1_t*)(value ? dictionaries[icol].intern(value, all) : 0);
+						if (!row[icol].val.bufVal)
+						{
+							err = value ? "no enough memory" : "invalid string value";
+							return false;
+						}
+					}
+					else if (cols[icol]._type == db_string)
+						row[icol].val.strVal = copy_string(source->get_value_as_string(icol), all, os_minus_one);
+					else
+						row[icol].val.wstrVal = copy_string(source->get_value_as_wstring(icol), all, os_minus_one);
 					break;
 				case db_binary:
 					{
@@ -217,7 +587,7 @@ copy_db_row(const S* source, memdb_row& row, C& cols, size_t col_count, byte_all
 						if (len) // copy data
 							memcpy(dummy + sizeof(size_t), buf + sizeof(size_t), len);
 
-						row._row[icol].val.bufVal = dummy;
+						row[icol].val.bufVal = dummy;
 					}
 					break;
 				case db_guid:
@@ -229,7 +599,7 @@ copy_db_row(const S* source, memdb_row& row, C& cols, size_t col_count, byte_all
 							return false;
 						}
 						source->get_value_as_guid(icol, *dummy);
-						row._row[icol].val.guidVal = dummy;
+						row[icol].val.guidVal = dummy;
 					}
 					break;
 			} // switch
@@ -54,6 +54,14 @@ public:
 	bool	_case_insensitive;								//!< for string only
 };
 
+//! \enum terimber_index_kind
+//! \brief kind of memtable index
+enum terimber_index_kind
+{
+	index_ordered = 0,										//!< sorted index, supports range lookups
+	index_hash												//!< hash index, supports equality lookups by all index columns only
+};
+
 //! \class terimber_table_column_desc
 //! \brief class helps to create empty table in memory explicitly 
 class terimber_table_column_desc
@@ -67,6 +75,27 @@ public:
 	bool			_nullable;								//!< can column has null values
 };
 
+//! \enum terimber_scan_operator
+//! \brief operator of scan predicate
+enum terimber_scan_operator
+{
+	scan_equal = 0,											//!< column equals to the value
+	scan_less,												//!< column is less than the value
+	scan_greater,											//!< column is greater than the value
+	scan_between,											//!< column is between two values inclusive
+	scan_in													//!< column equals to one of the values
+};
+
+//! \enum terimber_scan_function
+//! \brief aggregate function of scan
+enum terimber_scan_function
+{
+	scan_count = 0,											//!< number of rows or not null values
+	scan_sum,												//!< sum of values
+	scan_min,												//!< minimum value
+	scan_max												//!< maximum value
+};
+
 //! \class terimber_db_value_vector
 // abstract class to set conditions for lookup or update row
 class terimber_db_value_vector
@@ -400,6 +429,7 @@ public:
 // forward declaration
 class terimber_memindex;
 class terimber_memlookup;
+class terimber_memscan;
 
 //! \class terimber_memtable
 //! \brief abstract interface to memory table
@@ -449,9 +479,26 @@ public:
 
 	//! \brief resets all new, updates rows status to original, removes deleted rows
 	//! updates all indexes
+	//! unlike row changes, refresh, population and index management must not run while lookups are scanning
 	virtual 
 	void 
 	refresh() = 0;
+	//! \brief applies changed rows to the table instead of populating it again
+	//! db_server has to be after executing change-tracking query and ready to fetch data,
+	//! for instance, the rows with version column greater than the last version seen,
+	//! recordset has the table columns in the same order and types, the delete flag column can follow them
+	//! rows are matched by key columns, found rows are updated, others are inserted,
+	//! rows with non null nonzero delete flag are deleted, unknown ones are skipped
+	//! changes have statuses as insert_row and update_row give, indexes and lookups see them at once
+	//! hash index on key columns is taken from the table or created by the first call and kept,
+	//! so the time is proportional to the number of changed rows, not to the table size
+	virtual 
+	bool 
+	populate_delta(	dbserver* server,						//!< dbserver instance, connected to database and opened the recordset
+					size_t key_count,						//!< number of key columns
+					const size_t keys[],					//!< key column indexes
+					size_t deleted_column					//!< recordset column of delete flag, -1 - no deletions
+					) = 0;
 	//! \brief after populating and at any time after that you can request the number of rows in table
 	virtual 
 	size_t
@@ -504,10 +551,13 @@ public:
 	//! user must not to use object after returning it back
 	//! or after memtable will be destoyed
 	//! this is an expensive operation in order to consume memory and CPU time
+	//! hash index supports lookups by values of all index columns only,
+	//! rows come in no particular order, sort flags are ignored
 	virtual 
 	terimber_memindex* 
 	add_index(		size_t columns,							//!< columns in index
-					const terimber_index_column_info info[]	//!< array of index columns' descriptions
+					const terimber_index_column_info info[],//!< array of index columns' descriptions
+					terimber_index_kind kind = index_ordered//!< kind of index
 					) = 0;
 
 	//! \brief destroys index
@@ -530,6 +580,65 @@ public:
 	void 
 	destroy_db_values(terimber_db_value_vector* obj			//!< value array pointer
 					) = 0;
+
+	//! dictionary encoding
+	//! dictionary column keeps each distinct value once and rows refer to it,
+	//! it saves memory on low cardinality columns like countries, currencies or statuses
+	//! and indexes compare the values of table rows by codes instead of characters
+
+	//! \brief switches dictionary encoding of string or wide string column
+	//! the table must have no rows and no indexes,
+	//! the flag is kept for the column with the same index created by next populate or create,
+	//! columns of other types ignore it there
+	virtual
+	bool
+	set_column_dictionary(size_t index,						//!< column index
+					bool dictionary							//!< true - values are kept in dictionary
+					) = 0;
+
+	//! snapshot support
+	//! snapshot keeps column descriptions, fixed width column arrays, null bitmaps, 
+	//! the heap of strings, binaries and guids, dictionaries and the row order of each index
+	//! the file can be restored only on the platform with the same pointer size and byte order
+
+	//! \brief saves columns, rows and indexes to the snapshot file
+	virtual 
+	bool 
+	save_snapshot(	const char* file_name					//!< file name
+					) = 0;
+	//! \brief replaces the table content with the snapshot mapped from file
+	//! column arrays and heap are used in place, changes are copied on write and never reach the file
+	//! the table becomes columnar, indexes from the snapshot are accessible by get_index
+	//! the previous indexes, lookups, scans and value vectors of the table are destroyed
+	//! the file must not be changed while table is using it
+	virtual 
+	bool 
+	restore_snapshot(const char* file_name					//!< file name
+					) = 0;
+	//! \brief returns the number of indexes
+	virtual 
+	size_t 
+	get_index_count() = 0;
+	//! \brief returns index by number in the order of creation
+	virtual 
+	terimber_memindex* 
+	get_index(		size_t index							//!< index number
+					) = 0;
+
+	//! scan support
+	//! scan evaluates predicates and aggregates over column batches without lookups
+
+	//! \brief creates scan
+	//! user must not to use object after returning it back
+	//! or after memtable will be destoyed
+	virtual 
+	terimber_memscan* 
+	add_scan() = 0;
+	//! \brief destroys scan
+	virtual 
+	bool 
+	remove_scan(	terimber_memscan* obj					//!< scan pointer
+					) = 0;
 };
 
 //! \class terimber_memindex
@@ -598,6 +707,10 @@ public:
 
 	//! \brief tries to find the next row
 	//! according to lookup values
+	//! the first call after the lookup has been outside the row sequence takes the snapshot,
+	//! until the scan reaches the end rows are seen as they were at that moment,
+	//! so other threads can insert, update and delete rows while lookups are scanning
+	//! long scans keep the replaced row versions in memory
 	virtual 
 	bool 
 	next() const = 0;
@@ -750,8 +863,8 @@ public:
 	//! the current row can be changed
 	//! there are possible scenarios
 	//! 1. insert the new row - it will become the current one
-	//! 2. update the current row - it will be the same current row, even index columns are affected
-	//! 3. delete the current row - the current row will the next to the current one or current will point to the out of row sequence
+	//! 2. update the current row - lookup will be outside the row sequence, the next scan sees the new version
+	//! 3. delete the current row - lookup will be outside the row sequence
 
 	//! \brief insert new row
 	//! if the row is modified it will still have a status = new
@@ -793,6 +906,138 @@ public:
 	get_row_status() = 0;
 };
 
+//! \class terimber_memscan
+//! \brief abstract interface to memory table scan
+//! the scan selects rows matching all predicates, computes aggregates over them
+//! and groups them by the values of group columns
+//! predicates and aggregates are supported for boolean, integer, floating point and date columns,
+//! predicates also for string and wide string columns, group columns are boolean, integer, date or string
+//! execution takes the last committed rows, writers wait for it, lookups don't
+class terimber_memscan
+{
+protected:
+	//! \brief destructor
+	//! users can't call destructor, memtable will take case about cleanup
+	virtual 
+	~terimber_memscan() 
+	{
+	}
+public:
+	//! \brief returns the last occured error
+	virtual 
+	const char* 
+	get_last_error() = 0;
+
+	//! \brief adds predicate on column, row is selected if all predicates are true
+	//! values are converted to the column type, null values and null column values never match
+	//! scan_between takes two values, scan_in takes all values of the vector, the others take the first one
+	virtual 
+	bool 
+	add_predicate(	size_t index,							//!< column index
+					terimber_scan_operator op,				//!< operator
+					const terimber_db_value_vector* values	//!< values
+					) = 0;
+	//! \brief adds aggregate, null values are skipped
+	//! index -1 with scan_count counts selected rows
+	virtual 
+	bool 
+	add_aggregate(	size_t index,							//!< column index
+					terimber_scan_function function			//!< aggregate function
+					) = 0;
+	//! \brief adds group column
+	virtual 
+	bool 
+	add_group(		size_t index							//!< column index
+					) = 0;
+	//! \brief removes predicates, aggregates, group columns and results
+	virtual 
+	void 
+	clear() = 0;
+	//! \brief selects rows, computes aggregates and groups
+	virtual 
+	bool 
+	execute() = 0;
+
+	//! results are valid until the next execution or the next change of the table
+
+	//! \brief returns the number of selected rows
+	virtual 
+	size_t 
+	get_selected_count() const = 0;
+	//! \brief returns the selection vector
+	//! holds positions in column store for columnar table
+	//! and numbers of rows in table order for row based table
+	virtual 
+	const size_t* 
+	get_selection() const = 0;
+	//! \brief checks if value of selected row is null
+	virtual 
+	bool 
+	get_value_is_null(size_t row,							//!< selected row
+					size_t index							//!< column index
+					) const = 0;
+	//! \brief gets value of selected row as a int64
+	virtual 
+	sb8_t 
+	get_value_as_long64(size_t row,							//!< selected row
+					size_t index							//!< column index
+					) const = 0;
+	//! \brief gets value of selected row as a double
+	virtual 
+	double 
+	get_value_as_double(size_t row,							//!< selected row
+					size_t index							//!< column index
+					) const = 0;
+	//! \brief gets value of selected row as a string
+	//! the returned pointer is valid until next call
+	virtual 
+	const char* 
+	get_value_as_string(size_t row,							//!< selected row
+					size_t index							//!< column index
+					) const = 0;
+
+	//! \brief returns the number of groups, one group without group columns
+	virtual 
+	size_t 
+	get_group_count() const = 0;
+	//! \brief checks if value of group column is null
+	virtual 
+	bool 
+	get_group_value_is_null(size_t group,					//!< group
+					size_t index							//!< group column number
+					) const = 0;
+	//! \brief gets value of boolean, integer or date group column
+	virtual 
+	sb8_t 
+	get_group_value_as_long64(size_t group,					//!< group
+					size_t index							//!< group column number
+					) const = 0;
+	//! \brief gets value of string group column
+	virtual 
+	const char* 
+	get_group_value_as_string(size_t group,					//!< group
+					size_t index							//!< group column number
+					) const = 0;
+	//! \brief checks if aggregate has no values, count is never null
+	virtual 
+	bool 
+	get_aggregate_is_null(size_t group,						//!< group
+					size_t index							//!< aggregate number
+					) const = 0;
+	//! \brief gets aggregate as a int64
+	virtual 
+	sb8_t 
+	get_aggregate_as_long64(size_t group,					//!< group
+					size_t index							//!< aggregate number
+					) const = 0;
+	//! \brief gets aggregate as a double
+	virtual 
+	double 
+	get_aggregate_as_double(size_t group,					//!< group
+					size_t index							//!< aggregate number
+					) const = 0;
+};
+
 //! \class terimber_memtable_factory
 // creator
 //
@@ -801,8 +1046,14 @@ class terimber_memtable_factory
 public:
 	//! \brief creates table in memory object
 	//! caller is responsible for destroying it
+	//! huge pages reduce TLB misses on the big tables,
+	//! table falls back to regular pages if huge pages are not available
+	//! columnar table keeps one contiguous array per column instead of the list of rows,
+	//! scans over a few columns touch only their arrays
 	terimber_memtable* 
-	get_memtable();
+	get_memtable(	bool huge_pages = false,				//!< allocates rows and indexes on huge pages
+					bool columnar = false					//!< columnar layout
+					);
 };
 
 #pragma pack()
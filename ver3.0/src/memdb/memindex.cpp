@@ -30,14 +30,353 @@
 #include "base/map.hpp"
 #include "base/vector.hpp"
 #include "base/memory.hpp"
+#include "threadpool/thread.h"
 
 BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
 ///////////////////////////////////
-memindex::memindex(memtable& parent, const memdb_rowset_less& pred) : 
+//! \brief rows in one part of parallel sort at least
+const size_t memdb_sort_part_min = 64 * 1024;
+//! \brief max number of sorting threads
+const size_t memdb_sort_max_parts = 8;
+
+//! \class memdb_rownode_less
+//! \brief adapts rowset predicate to the row nodes
+class memdb_rownode_less
+{
+public:
+	//! \brief constructor
+	memdb_rownode_less(const memdb_rowset_less& pred	//!< rowset predicate
+					) :
+		_pred(pred)
+	{
+	}
+	//! \brief operator()
+	inline
+	bool
+	operator()(memdb_rownode_t* first, memdb_rownode_t* second) const
+	{
+		return _pred(memdb_rowset_citerator_t(first), memdb_rowset_citerator_t(second));
+	}
+private:
+	const memdb_rowset_less&	_pred;						//!< rowset predicate
+};
+
+//! \class memdb_index_sorter
+//! \brief stable parallel merge sort of row nodes
+//! parts are sorted by threads, then merged pairwise by threads level by level
+class memdb_index_sorter : public terimber_thread_employer
+{
+public:
+	//! \brief constructor
+	memdb_index_sorter(const memdb_rowset_less& pred,		//!< rowset predicate
+					memdb_rownode_t** rows,					//!< rows to sort
+					memdb_rownode_t** tmp,					//!< buffer of the same size
+					size_t count,							//!< number of rows
+					size_t parts							//!< number of parts, power of 2
+					) :
+		_less(pred),
+		_src(rows),
+		_dst(tmp),
+		_count(count),
+		_parts(parts),
+		_width(0),
+		_pending(0)
+	{
+		memset(_jobs, 0, sizeof(_jobs));
+		for (size_t index = 1; index < _parts; ++index)
+			_threads[index].start();
+	}
+	//! \brief destructor
+	~memdb_index_sorter()
+	{
+		for (size_t index = 1; index < _parts; ++index)
+		{
+			_threads[index].cancel_job();
+			_threads[index].stop();
+		}
+	}
+
+	//! \brief sorts rows, returns the array with sorted rows
+	memdb_rownode_t**
+	sort()
+	{
+		// sorts parts
+		run_pass(_parts);
+
+		// merges pairs of parts from source to destination
+		for (_width = 1; _width < _parts; _width <<= 1)
+		{
+			run_pass(_parts / (_width * 2));
+			memdb_rownode_t** tmp = _src;
+			_src = _dst;
+			_dst = tmp;
+		}
+
+		return _src;
+	}
+
+	//! \brief checks job
+	virtual
+	bool
+	v_has_job(size_t ident, void* user_data)
+	{
+		mutexKeeper guard(_mtx);
+		return _jobs[ident];
+	}
+	//! \brief does job
+	virtual
+	void
+	v_do_job(size_t ident, void* user_data)
+	{
+		do_job(ident);
+
+		mutexKeeper guard(_mtx);
+		_jobs[ident] = false;
+		if (!--_pending)
+			_done.set();
+	}
+
+private:
+	//! \brief runs jobs of one pass, the first one on the caller thread
+	void
+	run_pass(size_t jobs)
+	{
+		mutexKeeper guard(_mtx);
+		for (size_t index = 1; index < jobs; ++index)
+			_jobs[index] = true;
+		_pending = jobs - 1;
+		guard.unlock();
+
+		for (size_t index = 1; index < jobs; ++index)
+		{
+			job_task task(this, index, INFINITE, 0);
+			if (!_threads[index].assign_job(task))
+				v_do_job(index, 0);
+		}
+
+		do_job(0);
+
+		// waits for the other threads
+		for (;;)
+		{
+			guard.lock();
+			if (!_pending)
+				break;
+			guard.unlock();
+			_done.wait();
+		}
+	}
+
+	//! \brief sorts part or merges two parts
+	void
+	do_job(size_t ident)
+	{
+		if (!_width)
+			std::stable_sort(_src + bound(ident), _src + bound(ident + 1), _less);
+		else
+		{
+			size_t first = ident * _width * 2;
+			std::merge(_src + bound(first), _src + bound(first + _width),
+				_src + bound(first + _width), _src + bound(first + _width * 2),
+				_dst + bound(first), _less);
+		}
+	}
+
+	//! \brief returns the first row of part
+	inline
+	size_t
+	bound(size_t part) const
+	{
+		return part * _count / _parts;
+	}
+
+private:
+	memdb_rownode_less	_less;								//!< predicate
+	memdb_rownode_t**	_src;								//!< source rows
+	memdb_rownode_t**	_dst;								//!< destination rows
+	size_t				_count;								//!< number of rows
+	size_t				_parts;								//!< number of parts
+	size_t				_width;								//!< parts in merged run, 0 - sorting pass
+	bool				_jobs[memdb_sort_max_parts];		//!< job flags
+	size_t				_pending;							//!< jobs in progress on threads
+	mutex				_mtx;								//!< mutex
+	event				_done;								//!< all jobs of pass are done
+	thread				_threads[memdb_sort_max_parts];		//!< threads, the first one is not used
+};
+
+///////////////////////////////////
+memdb_hash_index::memdb_hash_index(const memdb_rowset_less& pred, chunk_provider* provider) :
+	_pred(pred),
+	_provider(provider),
+	_table(0),
+	_table_size(0),
+	_capacity(0),
+	_used(0),
+	_removed(0)
+{
+}
+
+memdb_hash_index::~memdb_hash_index()
+{
+	memdb_release(_provider, _table, _table_size);
+}
+
+bool
+memdb_hash_index::reserve(size_t rows)
+{
+	size_t capacity = 16;
+	while (capacity < rows * 2)
+		capacity <<= 1;
+
+	return capacity <= _capacity || rehash(capacity);
+}
+
+bool
+memdb_hash_index::insert(memdb_rowset_citerator_t row)
+{
+	// keeps load factor below 3/4, so there is always a free slot to stop probing
+	// every update leaves the removed slot, the table is rebuilt without them when it grows enough
+	if ((_used + _removed + 1) * 4 > _capacity * 3)
+	{
+		size_t capacity = 16;
+		while (capacity < (_used + 1) * 2)
+			capacity <<= 1;
+
+		// out of memory, the current table still works while it has a free slot to stop probing
+		if (!rehash(__max(capacity, _capacity)) && _used + _removed + 2 > _capacity)
+			return false;
+	}
+
+	size_t hash = _pred.hash(row);
+	size_t mask = _capacity - 1;
+	size_t slot = hash & mask;
+
+	while (_table[slot]._row)
+		slot = (slot + 1) & mask;
+
+	if (_table[slot]._removed)
+		--_removed;
+
+	_table[slot]._hash = hash;
+	_table[slot]._row = row.node();
+	_table[slot]._removed = false;
+	++_used;
+	return true;
+}
+
+bool
+memdb_hash_index::erase(memdb_rowset_citerator_t row)
+{
+	size_t slot = find_row(row);
+	if (slot == os_minus_one)
+		return false;
+
+	// leaves the mark, the rows after it in the same probe sequence must be found
+	_table[slot]._row = 0;
+	_table[slot]._removed = true;
+	--_used;
+	++_removed;
+	return true;
+}
+
+size_t
+memdb_hash_index::find(memdb_rowset_citerator_t key, size_t hash, size_t slot) const
+{
+	if (!_capacity)
+		return os_minus_one;
+
+	size_t mask = _capacity - 1;
+
+	for (slot = (slot == os_minus_one ? hash : slot + 1) & mask;; slot = (slot + 1) & mask)
+	{
+		const memdb_hash_entry& entry = _table[slot];
+		if (!entry._row)
+		{
+			if (!entry._removed)
+				return os_minus_one;
+		}
+		else if (entry._hash == hash
+			&& _pred.equal(key, memdb_rowset_citerator_t(entry._row)))
+			return slot;
+	}
+}
+
+size_t
+memdb_hash_index::find_row(memdb_rowset_citerator_t row) const
+{
+	if (!_capacity)
+		return os_minus_one;
+
+	size_t mask = _capacity - 1;
+
+	for (size_t slot = _pred.hash(row) & mask;; slot = (slot + 1) & mask)
+	{
+		const memdb_hash_entry& entry = _table[slot];
+		if (entry._row == row.node())
+			return slot;
+		else if (!entry._row && !entry._removed)
+			return os_minus_one;
+	}
+}
+
+void
+memdb_hash_index::clear()
+{
+	if (_table)
+		memset(_table, 0, _capacity * sizeof(memdb_hash_entry));
+
+	_used = 0;
+	_removed = 0;
+}
+
+bool
+memdb_hash_index::rehash(size_t capacity)
+{
+	size_t table_size = capacity * sizeof(memdb_hash_entry);
+	memdb_hash_entry* table = (memdb_hash_entry*)memdb_allocate(_provider, table_size);
+	if (!table)
+		return false;
+
+	memset(table, 0, capacity * sizeof(memdb_hash_entry));
+
+	// moves rows with precomputed hashes
+	// starts after the free slot, so rows of the same key keep their order in probe sequence
+	// and lookups go on from the current row
+	size_t start = 0;
+	while (start < _capacity && (_table[start]._row || _table[start]._removed))
+		++start;
+
+	size_t mask = capacity - 1;
+	for (size_t counter = 0; counter < _capacity; ++counter)
+	{
+		size_t index = (start + counter) & (_capacity - 1);
+		if (!_table[index]._row)
+			continue;
+
+		size_t slot = _table[index]._hash & mask;
+		while (table[slot]._row)
+			slot = (slot + 1) & mask;
+
+		table[slot] = _table[index];
+	}
+
+	memdb_release(_provider, _table, _table_size);
+	_table = table;
+	_table_size = table_size;
+	_capacity = capacity;
+	_removed = 0;
+	return true;
+}
+
+///////////////////////////////////
+memindex::memindex(memtable& parent, const memdb_rowset_less& pred, bool hashed) : 
 	_parent(parent),
-	_index(pred)
+	_index(pred, parent.get_provider() ? parent.get_provider()->granularity() / (2 * sizeof(memdb_rowset_citerator_t)) : os_def_size, parent.get_provider()),
+	_hashed(hashed),
+	_hash(pred, parent.get_provider()),
+	_usable(true)
 {
 }
 
@@ -53,16 +392,68 @@ memindex::~memindex()
 bool 
 memindex::construct()
 {
-	// looks up thought the rowset and constructs index
+	if (_hashed)
+	{
+		_usable = false;
+		if (!_hash.reserve(_parent.get_rowset().size()))
+			return false;
+
+		for (memdb_rowset_citerator_t iter = _parent.get_rowset().begin(); iter != _parent.get_rowset().end(); ++iter)
+			if (!_hash.insert(iter))
+				return false;
+
+		_usable = true;
+		return true;
+	}
+
+	// collects rows, sorts them and builds the tree bottom up
+	size_t count = _parent.get_rowset().size();
+	if (!count)
+		return true;
+
+	memdb_rownode_t** rows = new memdb_rownode_t*[count * 2];
+	if (!rows)
+		return false;
+
+	size_t index = 0;
 	for (memdb_rowset_citerator_t iter = _parent.get_rowset().begin(); iter != _parent.get_rowset().end(); ++iter)
-		_index.insert(iter, iter);
+		rows[index++] = iter.node();
 
-	return true;
+#if OS_TYPE == OS_WIN32
+	SYSTEM_INFO sys_info;
+	GetSystemInfo(&sys_info);
+	size_t cpus = sys_info.dwNumberOfProcessors;
+#else
+	long cpus_ = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t cpus = cpus_ > 0 ? (size_t)cpus_ : 1;
+#endif
+
+	size_t parts = 1;
+	while (parts * 2 <= __min(cpus, memdb_sort_max_parts)
+		&& count / (parts * 2) >= memdb_sort_part_min)
+		parts *= 2;
+
+	memdb_rownode_t** sorted = rows;
+	if (parts == 1)
+		std::stable_sort(rows, rows + count, memdb_rownode_less(_index.comp()));
+	else
+	{
+		memdb_index_sorter sorter(_index.comp(), rows, rows + count, count, parts);
+		sorted = sorter.sort();
+	}
+
+	bool res = _index.assign_sorted(sorted, sorted, count);
+	delete [] rows;
+	return res;
 }
 
 terimber_memlookup*
 memindex::add_lookup(const terimber_db_value_vector* info)
 {
+	// lookup would miss rows
+	if (!_usable)
+		return 0;
+
 	memlookup* obj = new memlookup(*this);
 
 	if (obj)
@@ -103,21 +494,34 @@ memindex::remove_lookup(terimber_memlookup* obj)
 
 //
 // parent table send notification
+// table holds latch, so lookups are between steps
 //
 void 
 memindex::notify(memdb_rowset_citerator_t iter, bool insert_or_delete)
 {
-	if (insert_or_delete)
+	if (_hashed)
 	{
-		// notifies all lookups
-		memdb_index_citer_t index_iter = _index.insert(iter, iter).first;
+		if (insert_or_delete)
+		{
+			// row is not found by the hash, stops using the index
+			if (!_hash.insert(iter))
+				_usable = false;
+		}
+		else
+			_hash.erase(iter);
+
+		// slots can be moved by rehash
 		mutexKeeper guard(_mtx);
 		for (list_lookups_t::iterator liter = _lookups.begin(); liter != _lookups.end(); ++liter)
-			(*liter)->notify(index_iter, true);
+			(*liter)->notify_hash();
+	}
+	else if (insert_or_delete)
+	{
+		// new version is not seen by scans in progress, bounds stay valid
+		_index.insert(iter, iter);
 	}
 	else
 	{
-		// notify all lookups
 		memdb_index_t::pairii_t range = _index.equal_range(iter);
 		if (range.first != _index.end())
 		{
@@ -125,9 +529,10 @@ memindex::notify(memdb_rowset_citerator_t iter, bool insert_or_delete)
 			{
 				if (range.first.key() == iter)
 				{
+					// moves bounds of scans from the erased row
 					mutexKeeper guard(_mtx);
 					for (list_lookups_t::iterator liter = _lookups.begin(); liter != _lookups.end(); ++liter)
-						(*liter)->notify(range.first, false);
+						(*liter)->notify(range.first);
 
 					// erases
 					_index.erase(range.first);
@@ -140,5 +545,47 @@ memindex::notify(memdb_rowset_citerator_t iter, bool insert_or_delete)
 	}
 }
 
+size_t
+memindex::get_min_snapshot(size_t snapshot)
+{
+	mutexKeeper guard(_mtx);
+	for (list_lookups_t::iterator liter = _lookups.begin(); liter != _lookups.end(); ++liter)
+	{
+		size_t lookup_snapshot = (*liter)->get_snapshot();
+		if (lookup_snapshot && lookup_snapshot < snapshot)
+			snapshot = lookup_snapshot;
+	}
+
+	return snapshot;
+}
+
+bool
+memindex::construct(memdb_rownode_t* const* sorted, size_t count)
+{
+	if (_hashed)
+		return construct();
+
+	return _index.assign_sorted(sorted, sorted, count);
+}
+
+//
+// table is going to be populated again
+//
+void
+memindex::clear()
+{
+	if (_hashed)
+	{
+		_hash.clear();
+		_usable = true;
+	}
+	else
+		_index.clear();
+
+	mutexKeeper guard(_mtx);
+	for (list_lookups_t::iterator liter = _lookups.begin(); liter != _lookups.end(); ++liter)
+		(*liter)->notify_clear();
+}
+
 #pragma pack()
 END_TERIMBER_NAMESPACE
@@ -177,22 +177,37 @@ terimber_db_value_vector_impl::set_value_as_guid(size_t index, const guid_t& val
 	return _value[index].set_as_guid(db_param_in, val);
 }
 
+// numerics are kept in memdb format, as table columns keep them
 bool 
 terimber_db_value_vector_impl::set_value_as_numeric(size_t index, const char* val, char delimeter)
 {
-	if (index >= _value.size())
+	memdb_decimal num;
+	if (index >= _value.size()
+		|| !val
+		|| !num.parse(val, delimeter))
+		return false;
+
+	binder& value = _value[index];
+	try
+	{
+		value.deallocate_value();
+		value._type = db_numeric;
+		*(memdb_decimal*)value.allocate_value(sizeof(memdb_decimal)) = num;
+	}
+	catch (exception&)
+	{
 		return false;
+	}
 
-	return _value[index].set_as_numeric(db_param_in, val, delimeter);
+	value._in_out = db_param_in;
+	value._value.nullVal = false;
+	return true;
 }
 
 bool 
 terimber_db_value_vector_impl::set_value_as_decimal(size_t index, const char* val, char delimeter)
 {
-	if (index >= _value.size())
-		return false;
-
-	return _value[index].set_as_decimal(db_param_in, val, delimeter);
+	return set_value_as_numeric(index, val, delimeter);
 }
 
 bool 
@@ -366,7 +381,7 @@ terimber_db_value_vector_impl::get_value_as_guid(size_t index, guid_t& val) cons
 const char*
 terimber_db_value_vector_impl::get_value_as_numeric(size_t index, char delimeter) const
 {
-	const ub1_t* retVal = get_value_as_value(index, vt_numeric).bufVal;
+	const memdb_decimal* retVal = (const memdb_decimal*)get_value_as_value(index, vt_numeric).bufVal;
 
 	if(!retVal)
 	{
@@ -374,16 +389,11 @@ terimber_db_value_vector_impl::get_value_as_numeric(size_t index, char delimeter
 		return 0;
 	}
 
-	numeric num;
-	if (!num.parse_orcl(retVal))
-	{
-		assert(false);
+	char* retStr = (char*)_tmp_allocator.allocate(memdb_decimal_chars);
+	if (!retStr)
 		return 0;
-	}
 
-	size_t len = num.is_zero() ? 2 : num.precision() + (num.sign() ? 1 : 0) + (num.scale() ? 1 : 0) + (num.precision() == num.scale()) + 1;
-	char* retStr = (char*)_tmp_allocator.allocate(len);
-	num.format(retStr, delimeter);
+	retVal->format(retStr, delimeter);
 	return retStr;
 }
 
@@ -455,12 +465,8 @@ terimber_db_value_vector_impl::get_value_as_value(size_t index, vt_types type) c
 			|| _value[index]._value.nullVal)
 			exception::_throw("Out of range");
 
-		vt_types type_ = dbserver_impl::convert_types(_value[index]._type);
 		_tmp_allocator.reset();
-		return type_ != type ? parse_value(type, 
-										persist_value(type_, _value[index]._value.val, &_tmp_allocator), 
-										0xffffffff, 
-										&_tmp_allocator) : _value[index]._value.val;
+		return convert_db_value(_value[index]._type, _value[index]._value, type, _tmp_allocator);
 	}
 	catch (...)
 	{
@@ -475,7 +481,12 @@ memlookup::memlookup(memindex& parent) :
 	_parent(parent),
 	_low_bounder(parent.get_index().end()),
 	_upper_bounder(parent.get_index().end()),
-	_current_iter(parent.get_index().end())
+	_current_iter(parent.get_index().end()),
+	_keyed(false),
+	_key_hash(0),
+	_slot(os_minus_one),
+	_current_row(0),
+	_snapshot(0)
 {
 	memdb_row dummy_row;
 	_condition_rowset.push_back(dummy_row);
@@ -495,38 +506,92 @@ memlookup::~memlookup()
 {
 }
 
+inline
+bool
+memlookup::get_current(memdb_rowset_citerator_t& iter) const
+{
+	if (!_current_row)
+		return false;
+
+	iter = memdb_rowset_citerator_t(_current_row);
+	return true;
+}
+
+void
+memlookup::start_scan() const
+{
+	// rows committed later are not seen
+	_snapshot = _parent.get_table().get_epoch();
+	_slot = os_minus_one;
+
+	if (_parent.is_hashed())
+		return;
+
+	if (_keyed)
+	{
+		memdb_index_t::paircc_t bounders = _parent.get_index().equal_range(_condition_rowset.begin());
+		_low_bounder = bounders.first;
+		_upper_bounder = bounders.second;
+	}
+	else
+	{
+		// no conditions
+		_low_bounder = _parent.get_index().begin();
+		_upper_bounder = _parent.get_index().end();
+	}
+}
+
+inline
+void
+memlookup::stop_scan() const
+{
+	_low_bounder = _upper_bounder = _current_iter = _parent.get_index().end();
+	_slot = os_minus_one;
+	_current_row = 0;
+	_snapshot = 0;
+}
+
 bool 
 memlookup::construct(const terimber_db_value_vector_impl* info)
 {
 	// checks sizes
 	const memdb_rowset_less& pred = _parent.get_index().comp();
+	size_t length = pred.get_info().size();
 	size_t size = info ? info->get_size() : 0;
 
-	if (size > pred.get_info().size())
+	if (size > length)
+		return false;
+
+	// hash index looks up the values of all columns
+	if (_parent.is_hashed() && size && size != length)
 		return false;
 
+	// writers move bounds of scans under latch
+	memdb_reader_keeper latch(_parent.get_table().get_latch());
+	stop_scan();
+
 	if (size)
 	{
-		// creates temporary map
-		_tmp_allocator.reset();
+		// conditions live on their own allocator,
+		// the temporary one is reset by value accessors
+		_condition_allocator.reset();
 		
 		memdb_rowset_t::iterator iter = _condition_rowset.begin();
+		iter->_row.clear();
+		iter->_row.resize(_condition_allocator, length);
+		for (size_t i = 0; i < length; ++i)
+			iter->_row[i].nullVal = true;
 		
 		string_t error;
 
-		if (!copy_db_row(info, *iter, pred.get_info(), size, _tmp_allocator, error))
+		if (!copy_db_row(info, iter->_row.begin(), pred.get_info(), size, _condition_allocator, error))
 			return false;
 
-		memdb_index_t::paircc_t bounders = _parent.get_index().equal_range(iter);
-		_low_bounder = bounders.first;
-		_current_iter = _upper_bounder = bounders.second;
+		_keyed = true;
+		_key_hash = _parent.is_hashed() ? pred.hash(iter) : 0;
 	}
 	else
-	{
-		// no conditions
-		_low_bounder = _parent.get_index().begin();
-		_current_iter = _upper_bounder = _parent.get_index().end();
-	}
+		_keyed = false;
 
 	return true;
 }
@@ -543,9 +608,46 @@ memlookup::assign(const terimber_memlookup& x)
 	if (&_parent != &that._parent)
 		return false;
 
+	// scans restart with the same conditions
+	const memdb_rowset_less& pred = _parent.get_index().comp();
+	const memdb_row& from = that._condition_rowset.front();
+	memdb_row& to = _condition_rowset.front();
+
+	memdb_reader_keeper latch(_parent.get_table().get_latch());
+	_condition_allocator.reset();
+	to._row.clear();
+	to._row.resize(_condition_allocator, from._row.size());
+	for (size_t i = 0; i < from._row.size(); ++i)
+	{
+		to._row[i].nullVal = from._row[i].nullVal;
+		if (from._row[i].nullVal)
+			continue;
+
+		dbtypes type = pred.get_info()[i]._type;
+		if (type == db_decimal || type == db_numeric)
+		{
+			memdb_decimal* dummy = (memdb_decimal*)_condition_allocator.allocate(sizeof(memdb_decimal));
+			if (!dummy)
+				return false;
+
+			*dummy = *(const memdb_decimal*)from._row[i].val.bufVal;
+			to._row[i].val.bufVal = (const ub1_t*)dummy;
+		}
+		else
+			to._row[i].val = copy_value(dbserver_impl::convert_types(type), from._row[i].val, _condition_allocator);
+	}
+
+	_keyed = that._keyed;
+	_key_hash = that._key_hash;
+
+	// the scan goes on from the same row of the same snapshot
 	_low_bounder = that._low_bounder;
 	_upper_bounder = that._upper_bounder;
 	_current_iter = that._current_iter;
+	_slot = that._slot;
+	_current_row = that._current_row;
+	_snapshot = that._snapshot;
+
 	return true;
 }
 
@@ -562,19 +664,67 @@ memlookup::reset(const terimber_db_value_vector* info)
 // 
 // tries to find the next row
 // according to lookup values
+// the first call takes the snapshot, the rows changed later are seen as they were
 //
 bool 
 memlookup::next() const
 {
-	// tries to find next
-	// first search
-	if (_current_iter == _upper_bounder)
-		_current_iter = _low_bounder; // resets to the beginning
-	else
+	memdb_reader_keeper latch(_parent.get_table().get_latch());
+
+	if (!_snapshot)
+	{
+		start_scan();
+		_current_iter = _low_bounder;
+	}
+	else if (!_parent.is_hashed())
 		++_current_iter; // moves to the next position
 
-	// returns result
-	return _current_iter != _upper_bounder;
+	if (_parent.is_hashed() && _keyed)
+	{
+		const memdb_hash_index& hash = _parent.get_hash();
+		do
+			_slot = hash.find(_condition_rowset.begin(), _key_hash, _slot);
+		while (_slot != os_minus_one && !hash.get_node(_slot)->_value.is_visible(_snapshot));
+
+		if (_slot == os_minus_one)
+		{
+			stop_scan();
+			return false;
+		}
+
+		_current_row = hash.get_node(_slot);
+		return true;
+	}
+	else if (_parent.is_hashed())
+	{
+		// all rows in the table order, rehash moves slots
+		const memdb_rowset_t& rowset = _parent.get_table().get_rowset();
+		memdb_rowset_citerator_t iter = _current_row ? ++memdb_rowset_citerator_t(_current_row) : rowset.begin();
+		while (iter != rowset.end() && !iter->is_visible(_snapshot))
+			++iter;
+
+		if (iter == rowset.end())
+		{
+			stop_scan();
+			return false;
+		}
+
+		_current_row = iter.node();
+		return true;
+	}
+
+	// skips versions of the other snapshots
+	while (_current_iter != _upper_bounder && !_current_iter.key()->is_visible(_snapshot))
+		++_current_iter;
+
+	if (_current_iter == _upper_bounder)
+	{
+		stop_scan();
+		return false;
+	}
+
+	_current_row = _current_iter.key().node();
+	return true;
 }
 
 // 
@@ -584,15 +734,68 @@ memlookup::next() const
 bool 
 memlookup::prev() const
 {
-		// tries to find next
-	// first search
-	if (_current_iter == _low_bounder)
-		_current_iter = _upper_bounder; // resets to the beginning
-	else
-		--_current_iter; // moves to the next position
+	memdb_reader_keeper latch(_parent.get_table().get_latch());
+
+	if (!_snapshot)
+	{
+		start_scan();
+		_current_iter = _upper_bounder;
+	}
 
-	// returns result
-	return _current_iter != _upper_bounder;
+	if (_parent.is_hashed() && _keyed)
+	{
+		// probe sequence goes forward only, finds the match before the current one
+		const memdb_hash_index& hash = _parent.get_hash();
+		size_t prev = os_minus_one;
+		for (size_t slot = hash.find(_condition_rowset.begin(), _key_hash, os_minus_one); slot != os_minus_one && slot != _slot; slot = hash.find(_condition_rowset.begin(), _key_hash, slot))
+			if (hash.get_node(slot)->_value.is_visible(_snapshot))
+				prev = slot;
+
+		if (prev == os_minus_one)
+		{
+			stop_scan();
+			return false;
+		}
+
+		_slot = prev;
+		_current_row = hash.get_node(_slot);
+		return true;
+	}
+	else if (_parent.is_hashed())
+	{
+		const memdb_rowset_t& rowset = _parent.get_table().get_rowset();
+		memdb_rowset_citerator_t iter = _current_row ? memdb_rowset_citerator_t(_current_row) : rowset.end();
+		do
+		{
+			if (iter == rowset.begin())
+			{
+				stop_scan();
+				return false;
+			}
+
+			--iter;
+		}
+		while (!iter->is_visible(_snapshot));
+
+		_current_row = iter.node();
+		return true;
+	}
+
+	// skips versions of the other snapshots
+	do
+	{
+		if (_current_iter == _low_bounder)
+		{
+			stop_scan();
+			return false;
+		}
+
+		--_current_iter; // moves to the previous position
+	}
+	while (!_current_iter.key()->is_visible(_snapshot));
+
+	_current_row = _current_iter.key().node();
+	return true;
 }
 
 //
@@ -613,11 +816,12 @@ memlookup::prev() const
 bool 
 memlookup::get_value_is_null(size_t index) const
 {
-	if (_current_iter == _upper_bounder
+	memdb_rowset_citerator_t iter(0);
+	if (!get_current(iter)
 		|| index >= _parent.get_table().get_column_count())
 		return false;
 
-	return (*_current_iter)->_row[index].nullVal;
+	return _parent.get_table().get_columns().is_null(*iter, index);
 }
 
 bool 
@@ -717,7 +921,7 @@ memlookup::get_value_as_guid(size_t index, guid_t& val) const
 const char*
 memlookup::get_value_as_numeric(size_t index, char delimeter) const
 {
-	const ub1_t* retVal = get_value_as_value(index, vt_numeric).bufVal;
+	const memdb_decimal* retVal = (const memdb_decimal*)get_value_as_value(index, vt_numeric).bufVal;
 
 	if(!retVal)
 	{
@@ -725,16 +929,11 @@ memlookup::get_value_as_numeric(size_t index, char delimeter) const
 		return 0;
 	}
 
-	numeric num;
-	if (!num.parse_orcl(retVal))
-	{
-		assert(false);
+	char* retStr = (char*)_tmp_allocator.allocate(memdb_decimal_chars);
+	if (!retStr)
 		return 0;
-	}
 
-	size_t len = num.is_zero() ? 2 : num.precision() + (num.sign() ? 1 : 0) + (num.scale() ? 1 : 0) + (num.precision() == num.scale()) + 1;
-	char* retStr = (char*)_tmp_allocator.allocate(len);
-	num.format(retStr, delimeter);
+	retVal->format(retStr, delimeter);
 	return retStr;
 }
 
@@ -801,16 +1000,14 @@ memlookup::get_value_as_value(size_t index, vt_types type) const
 {
 	try
 	{
-		if (_current_iter == _upper_bounder
+		memdb_rowset_citerator_t iter(0);
+		if (!get_current(iter)
 			|| index >= _parent.get_table().get_column_count())
 			exception::_throw("Out of range");
 
-		vt_types type_ = dbserver_impl::convert_types(_parent.get_table().get_column_type(index));
+		terimber_db_value value = _parent.get_table().get_columns().get_value(*iter, index);
 		_tmp_allocator.reset();
-		return type_ != type ? parse_value(type, 
-										persist_value(type_,(*_current_iter)->_row[index].val, &_tmp_allocator), 
-										0xffffffff, 
-										&_tmp_allocator) : (*_current_iter)->_row[index].val;
+		return convert_db_value(_parent.get_table().get_column_type(index), value, type, _tmp_allocator);
 	}
 	catch (...) 
 	{
@@ -825,8 +1022,8 @@ memlookup::get_value_as_value(size_t index, vt_types type) const
 // the current row can be changed
 // there are possible scenarios
 // 1. inserts the new row - it will become the current one
-// 2. updates the current row - it will be the same current row, even index columns are affected
-// 3. deletes the current row - the current row will the next to the current one or current will point to the out of row sequence
+// 2. updates the current row - lookup will be outside the row sequence, the next scan sees the new version
+// 3. deletes the current row - lookup will be outside the row sequence
 //
 
 //
@@ -857,10 +1054,16 @@ memlookup::delete_row()
 	// 1. marks row as deleted
 	// 2. notifies all indexes
 	// 3. notifies all lookups
-	if (_current_iter == _upper_bounder)
+	memdb_rowset_citerator_t iter(0);
+	if (!get_current(iter))
 		return false;
 
-	return _parent.get_table().delete_row(*_current_iter);
+	// the scan keeps the version until the table has it,
+	// then lookup starts again and does not see the deleted row
+	bool res = _parent.get_table().delete_row(iter);
+	memdb_reader_keeper latch(_parent.get_table().get_latch());
+	stop_scan();
+	return res;
 }
 
 //
@@ -875,10 +1078,15 @@ memlookup::update_row(const terimber_db_value_vector* info)
 	// 1. marks row as deleted
 	// 2. notifies all indexes
 	// 3. notifies all lookups
-	if (_current_iter == _upper_bounder)
+	memdb_rowset_citerator_t iter(0);
+	if (!get_current(iter))
 		return false;
 
-	return _parent.get_table().update_row(*_current_iter, info);
+	// lookup starts again and sees the new version
+	bool res = _parent.get_table().update_row(iter, info);
+	memdb_reader_keeper latch(_parent.get_table().get_latch());
+	stop_scan();
+	return res;
 }
 
 
@@ -891,32 +1099,43 @@ memlookup::update_row(const terimber_db_value_vector* info)
 terimber_db_row_status
 memlookup::get_row_status()
 {
-	if (_current_iter == _upper_bounder)
+	memdb_rowset_citerator_t iter(0);
+	if (!get_current(iter))
 		return status_deleted;
 
-	return (*_current_iter)->_status;
+	return _parent.get_table().get_columns().get_status(*iter);
 }
 
 void 
-memlookup::notify(memdb_index_citer_t iter, bool insert_or_delete)
+memlookup::notify(memdb_index_citer_t iter)
 {
-	memdb_rowset_t::const_iterator conditer = _condition_rowset.begin();
-	memdb_index_t::paircc_t bounders = _parent.get_index().equal_range(conditer);
-	memdb_index_citer_t curr = _low_bounder = bounders.first;
-	_upper_bounder = bounders.second;
+	// the current row is seen by the scan, so it is never erased
+	if (!_snapshot)
+		return;
 
+	if (_low_bounder == iter)
+		++_low_bounder;
 
-	// tries to find the old current
-	if (curr != _parent.get_index().end())
-	{
-		while (curr != _upper_bounder)
-			if (_current_iter == curr)
-				return;
-			else
-				++curr;
-	}
+	if (_upper_bounder == iter)
+		++_upper_bounder;
+}
+
+void
+memlookup::notify_hash()
+{
+	if (_slot == os_minus_one)
+		return;
 
-	_current_iter = _upper_bounder;
+	const memdb_hash_index& hash = _parent.get_hash();
+	// the current row has been moved by rehash
+	if (hash.get_node(_slot) != _current_row)
+		_slot = hash.find_row(memdb_rowset_citerator_t(_current_row));
+}
+
+void
+memlookup::notify_clear()
+{
+	stop_scan();
 }
 
 
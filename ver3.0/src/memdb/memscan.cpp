@@ -0,0 +1,1568 @@
+/*
+ * The Software License
+ * =================================================================================
+ * Copyright (c) 2003-2010 The Terimber Corporation. All rights reserved.
+ * =================================================================================
+ * Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * The end-user documentation included with the redistribution, if any, 
+ * must include the following acknowledgment:
+ * "This product includes software developed by the Terimber Corporation."
+ * =================================================================================
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESSED OR IMPLIED WARRANTIES, 
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+ * AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  
+ * IN NO EVENT SHALL THE TERIMBER CORPORATION OR ITS CONTRIBUTORS BE LIABLE FOR 
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES 
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; 
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON 
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ================================================================================
+*/
+
+#include "memdb/memdb.hpp"
+#include "base/list.hpp"
+#include "base/memory.hpp"
+#include "base/string.hpp"
+#include "base/common.hpp"
+#include "base/vector.hpp"
+
+#include <math.h>
+#include <algorithm>
+
+// SSE2 is the baseline of x64 and can be enabled for x86
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MEMDB_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+BEGIN_TERIMBER_NAMESPACE
+#pragma pack(4)
+
+//////////////////////////////////////////////////////////////
+// bit helpers
+
+//! \brief returns the number of bits set
+static
+inline
+size_t
+memdb_scan_popcount(ub4_t bits)
+{
+	bits = bits - ((bits >> 1) & 0x55555555);
+	bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+	return (((bits + (bits >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+}
+
+//! \brief returns the number of the lowest bit set, bits must not be 0
+static
+inline
+size_t
+memdb_scan_lowest(ub4_t bits)
+{
+	static const ub1_t positions[32] =
+	{
+		0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+		31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+	};
+
+	return positions[((bits & (0 - bits)) * 0x077cb531) >> 27];
+}
+
+//! \brief returns the mask of the first count bits
+static
+inline
+ub4_t
+memdb_scan_mask(size_t count)
+{
+	return count >= 32 ? 0xffffffff : ((ub4_t)1 << count) - 1;
+}
+
+//! \brief grows array, keeps used elements
+template < class T >
+static
+bool
+memdb_scan_reserve(T*& array, size_t& size, size_t used, size_t needed)
+{
+	if (needed <= size)
+		return true;
+
+	size_t capacity = size ? size : 64;
+	while (capacity < needed)
+		capacity *= 2;
+
+	T* dummy = new T[capacity];
+	if (!dummy)
+		return false;
+
+	if (used)
+		memcpy(dummy, array, used * sizeof(T));
+
+	delete [] array;
+	array = dummy;
+	size = capacity;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////
+// values
+
+//! \brief returns the value of string column
+//! restored snapshot keeps heap offsets with the lowest bit set
+static
+inline
+const void*
+memdb_scan_pointer(const memdb_scan_column& col, const ub1_t* ptr)
+{
+	size_t value = *(const size_t*)ptr;
+	return value & 1 ? col._heap + (value >> 1) : (const void*)value;
+}
+
+//! \brief returns the value of boolean, integer or date column
+static
+inline
+sb8_t
+memdb_scan_long(dbtypes type, const ub1_t* ptr)
+{
+	switch (type)
+	{
+		case db_bool:
+		case db_ub1:
+			return *ptr;
+		case db_sb1:
+			return *(const sb1_t*)ptr;
+		case db_sb2:
+			return *(const sb2_t*)ptr;
+		case db_ub2:
+			return *(const ub2_t*)ptr;
+		case db_sb4:
+			return *(const sb4_t*)ptr;
+		case db_ub4:
+			return *(const ub4_t*)ptr;
+		default:
+			return *(const sb8_t*)ptr;
+	}
+}
+
+//! \brief checks if column type is floating point
+static
+inline
+bool
+memdb_scan_floating(dbtypes type)
+{
+	return type == db_float || type == db_double;
+}
+
+//! \brief checks if column type can be used in predicates
+static
+inline
+bool
+memdb_scan_predicate_type(dbtypes type)
+{
+	switch (type)
+	{
+		case db_bool:
+		case db_sb1:
+		case db_ub1:
+		case db_sb2:
+		case db_ub2:
+		case db_sb4:
+		case db_ub4:
+		case db_sb8:
+		case db_ub8:
+		case db_date:
+		case db_float:
+		case db_double:
+		case db_string:
+		case db_wstring:
+			return true;
+		default:
+			return false;
+	}
+}
+
+//////////////////////////////////////////////////////////////
+// predicate kernels
+
+//! \brief converts bounds of integer column to the inclusive range
+//! returns false if no value can match
+template < class T >
+static
+bool
+memdb_scan_integer_bounds(memdb_scan_range& range, const ub1_t* low, const ub1_t* high, bool low_strict, bool high_strict, T min_value, T max_value)
+{
+	T lo = low ? *(const T*)low : min_value;
+	T hi = high ? *(const T*)high : max_value;
+
+	if (low && low_strict)
+	{
+		if (lo == max_value)
+			return false;
+		++lo;
+	}
+
+	if (high && high_strict)
+	{
+		if (hi == min_value)
+			return false;
+		--hi;
+	}
+
+	if (hi < lo)
+		return false;
+
+	range._llow = (sb8_t)lo;
+	range._lhigh = (sb8_t)hi;
+	return true;
+}
+
+//! \brief evaluates inclusive range over integer values, returns one bit per value
+template < class T >
+static
+inline
+ub4_t
+memdb_scan_integer(const T* values, size_t count, T low, T high)
+{
+	ub4_t bits = 0;
+	for (size_t index = 0; index < count; ++index)
+		bits |= (ub4_t)(low <= values[index] && values[index] <= high) << index;
+
+	return bits;
+}
+
+//! \brief evaluates range over floating point values, returns one bit per value
+template < class T >
+static
+inline
+ub4_t
+memdb_scan_real(const T* values, size_t count, T low, T high, bool low_strict, bool high_strict)
+{
+	ub4_t bits = 0;
+	for (size_t index = 0; index < count; ++index)
+	{
+		T value = values[index];
+		bool match = (low_strict ? low < value : low <= value)
+			&& (high_strict ? value < high : value <= high);
+		bits |= (ub4_t)match << index;
+	}
+
+	return bits;
+}
+
+#ifdef MEMDB_SCAN_SSE2
+// 32 values at once, unsigned values are compared as signed after flipping the sign bit
+
+//! \brief evaluates inclusive range over 32 bytes
+static
+inline
+ub4_t
+memdb_scan_sse2_8(const ub1_t* values, ub1_t low, ub1_t high, ub1_t flip)
+{
+	const __m128i sign = _mm_set1_epi8((char)flip);
+	const __m128i lo = _mm_set1_epi8((char)(low ^ flip));
+	const __m128i hi = _mm_set1_epi8((char)(high ^ flip));
+	ub4_t bits = 0;
+
+	for (size_t index = 0; index < 32; index += 16)
+	{
+		__m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(values + index)), sign);
+		__m128i out = _mm_or_si128(_mm_cmplt_epi8(value, lo), _mm_cmpgt_epi8(value, hi));
+		bits |= (ub4_t)(~_mm_movemask_epi8(out) & 0xffff) << index;
+	}
+
+	return bits;
+}
+
+//! \brief evaluates inclusive range over 32 words
+static
+inline
+ub4_t
+memdb_scan_sse2_16(const ub2_t* values, ub2_t low, ub2_t high, ub2_t flip)
+{
+	const __m128i sign = _mm_set1_epi16((short)flip);
+	const __m128i lo = _mm_set1_epi16((short)(low ^ flip));
+	const __m128i hi = _mm_set1_epi16((short)(high ^ flip));
+	ub4_t bits = 0;
+
+	for (size_t index = 0; index < 32; index += 16)
+	{
+		__m128i first = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(values + index)), sign);
+		__m128i second = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(values + index + 8)), sign);
+		__m128i out_first = _mm_or_si128(_mm_cmplt_epi16(first, lo), _mm_cmpgt_epi16(first, hi));
+		__m128i out_second = _mm_or_si128(_mm_cmplt_epi16(second, lo), _mm_cmpgt_epi16(second, hi));
+		// packs masks to bytes, one bit per value
+		bits |= (ub4_t)(~_mm_movemask_epi8(_mm_packs_epi16(out_first, out_second)) & 0xffff) << index;
+	}
+
+	return bits;
+}
+
+//! \brief evaluates inclusive range over 32 double words
+static
+inline
+ub4_t
+memdb_scan_sse2_32(const ub4_t* values, ub4_t low, ub4_t high, ub4_t flip)
+{
+	const __m128i sign = _mm_set1_epi32((int)flip);
+	const __m128i lo = _mm_set1_epi32((int)(low ^ flip));
+	const __m128i hi = _mm_set1_epi32((int)(high ^ flip));
+	ub4_t bits = 0;
+
+	for (size_t index = 0; index < 32; index += 4)
+	{
+		__m128i value = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(values + index)), sign);
+		__m128i out = _mm_or_si128(_mm_cmplt_epi32(value, lo), _mm_cmpgt_epi32(value, hi));
+		bits |= (ub4_t)(~_mm_movemask_ps(_mm_castsi128_ps(out)) & 0xf) << index;
+	}
+
+	return bits;
+}
+
+// overloads for types compared by SSE2, partial words are evaluated by templates
+
+static
+inline
+ub4_t
+memdb_scan_integer(const ub1_t* values, size_t count, ub1_t low, ub1_t high)
+{
+	return count == 32 ? memdb_scan_sse2_8(values, low, high, 0x80) : memdb_scan_integer< ub1_t >(values, count, low, high);
+}
+
+static
+inline
+ub4_t
+memdb_scan_integer(const sb1_t* values, size_t count, sb1_t low, sb1_t high)
+{
+	return count == 32 ? memdb_scan_sse2_8((const ub1_t*)values, (ub1_t)low, (ub1_t)high, 0) : memdb_scan_integer< sb1_t >(values, count, low, high);
+}
+
+static
+inline
+ub4_t
+memdb_scan_integer(const ub2_t* values, size_t count, ub2_t low, ub2_t high)
+{
+	return count == 32 ? memdb_scan_sse2_16(values, low, high, 0x8000) : memdb_scan_integer< ub2_t >(values, count, low, high);
+}
+
+static
+inline
+ub4_t
+memdb_scan_integer(const sb2_t* values, size_t count, sb2_t low, sb2_t high)
+{
+	return count == 32 ? memdb_scan_sse2_16((const ub2_t*)values, (ub2_t)low, (ub2_t)high, 0) : memdb_scan_integer< sb2_t >(values, count, low, high);
+}
+
+static
+inline
+ub4_t
+memdb_scan_integer(const ub4_t* values, size_t count, ub4_t low, ub4_t high)
+{
+	return count == 32 ? memdb_scan_sse2_32(values, low, high, 0x80000000) : memdb_scan_integer< ub4_t >(values, count, low, high);
+}
+
+static
+inline
+ub4_t
+memdb_scan_integer(const sb4_t* values, size_t count, sb4_t low, sb4_t high)
+{
+	return count == 32 ? memdb_scan_sse2_32((const ub4_t*)values, (ub4_t)low, (ub4_t)high, 0) : memdb_scan_integer< sb4_t >(values, count, low, high);
+}
+
+static
+inline
+ub4_t
+memdb_scan_real(const float* values, size_t count, float low, float high, bool low_strict, bool high_strict)
+{
+	if (count != 32)
+		return memdb_scan_real< float >(values, count, low, high, low_strict, high_strict);
+
+	const __m128 lo = _mm_set1_ps(low);
+	const __m128 hi = _mm_set1_ps(high);
+	ub4_t bits = 0;
+
+	for (size_t index = 0; index < 32; index += 4)
+	{
+		__m128 value = _mm_loadu_ps(values + index);
+		__m128 above = low_strict ? _mm_cmpgt_ps(value, lo) : _mm_cmpge_ps(value, lo);
+		__m128 below = high_strict ? _mm_cmplt_ps(value, hi) : _mm_cmple_ps(value, hi);
+		bits |= (ub4_t)_mm_movemask_ps(_mm_and_ps(above, below)) << index;
+	}
+
+	return bits;
+}
+
+static
+inline
+ub4_t
+memdb_scan_real(const double* values, size_t count, double low, double high, bool low_strict, bool high_strict)
+{
+	if (count != 32)
+		return memdb_scan_real< double >(values, count, low, high, low_strict, high_strict);
+
+	const __m128d lo = _mm_set1_pd(low);
+	const __m128d hi = _mm_set1_pd(high);
+	ub4_t bits = 0;
+
+	for (size_t index = 0; index < 32; index += 2)
+	{
+		__m128d value = _mm_loadu_pd(values + index);
+		__m128d above = low_strict ? _mm_cmpgt_pd(value, lo) : _mm_cmpge_pd(value, lo);
+		__m128d below = high_strict ? _mm_cmplt_pd(value, hi) : _mm_cmple_pd(value, hi);
+		bits |= (ub4_t)_mm_movemask_pd(_mm_and_pd(above, below)) << index;
+	}
+
+	return bits;
+}
+#endif // MEMDB_SCAN_SSE2
+
+//! \brief evaluates range over string values of candidate rows
+template < class C >
+static
+ub4_t
+memdb_scan_string(const memdb_scan_column& col, const ub1_t* data, ub4_t candidates, const memdb_scan_range& range)
+{
+	ub4_t bits = 0;
+	for (; candidates; candidates &= candidates - 1)
+	{
+		size_t index = memdb_scan_lowest(candidates);
+		const C* value = (const C*)memdb_scan_pointer(col, data + index * sizeof(void*));
+		if (range._slow)
+		{
+			int res = str_template::strcmp(value, (const C*)range._slow);
+			if (res < 0 || (res == 0 && range._low_strict))
+				continue;
+		}
+
+		if (range._shigh)
+		{
+			int res = str_template::strcmp(value, (const C*)range._shigh);
+			if (res > 0 || (res == 0 && range._high_strict))
+				continue;
+		}
+
+		bits |= (ub4_t)1 << index;
+	}
+
+	return bits;
+}
+
+//////////////////////////////////////////////////////////////
+// aggregate kernels
+
+//! \brief adds selected integer values to accumulator
+//! fully selected words are processed by dense loops
+template < class T >
+static
+void
+memdb_scan_integer_accumulate(const T* values, ub4_t bits, terimber_scan_function function, memdb_scan_accumulator& acc)
+{
+	acc._count += memdb_scan_popcount(bits);
+
+	switch (function)
+	{
+		case scan_sum:
+			{
+				sb8_t sum = 0;
+				if (bits == 0xffffffff)
+					for (size_t index = 0; index < 32; ++index)
+						sum += values[index];
+				else
+					for (; bits; bits &= bits - 1)
+						sum += values[memdb_scan_lowest(bits)];
+
+				acc._lsum += sum;
+			}
+			break;
+		case scan_min:
+			{
+				T value = values[memdb_scan_lowest(bits)];
+				if (bits == 0xffffffff)
+					for (size_t index = 1; index < 32; ++index)
+						value = values[index] < value ? values[index] : value;
+				else
+					for (; bits; bits &= bits - 1)
+						value = values[memdb_scan_lowest(bits)] < value ? values[memdb_scan_lowest(bits)] : value;
+
+				if ((sb8_t)value < acc._lmin)
+					acc._lmin = (sb8_t)value;
+			}
+			break;
+		case scan_max:
+			{
+				T value = values[memdb_scan_lowest(bits)];
+				if (bits == 0xffffffff)
+					for (size_t index = 1; index < 32; ++index)
+						value = values[index] > value ? values[index] : value;
+				else
+					for (; bits; bits &= bits - 1)
+						value = values[memdb_scan_lowest(bits)] > value ? values[memdb_scan_lowest(bits)] : value;
+
+				if ((sb8_t)value > acc._lmax)
+					acc._lmax = (sb8_t)value;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+//! \brief adds selected floating point values to accumulator
+template < class T >
+static
+void
+memdb_scan_real_accumulate(const T* values, ub4_t bits, terimber_scan_function function, memdb_scan_accumulator& acc)
+{
+	acc._count += memdb_scan_popcount(bits);
+
+	switch (function)
+	{
+		case scan_sum:
+			{
+				double sum = 0;
+				if (bits == 0xffffffff)
+					for (size_t index = 0; index < 32; ++index)
+						sum += values[index];
+				else
+					for (; bits; bits &= bits - 1)
+						sum += values[memdb_scan_lowest(bits)];
+
+				acc._dsum += sum;
+			}
+			break;
+		case scan_min:
+			for (; bits; bits &= bits - 1)
+			{
+				double value = values[memdb_scan_lowest(bits)];
+				if (value < acc._dmin)
+					acc._dmin = value;
+			}
+			break;
+		case scan_max:
+			for (; bits; bits &= bits - 1)
+			{
+				double value = values[memdb_scan_lowest(bits)];
+				if (value > acc._dmax)
+					acc._dmax = value;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+//! \brief adds selected values of 32 rows to accumulator
+static
+void
+memdb_scan_accumulate(const memdb_scan_aggregate& agg, const memdb_scan_column& col, size_t word, ub4_t bits, memdb_scan_accumulator& acc)
+{
+	const ub1_t* data = col._data + (word << 5) * col._width;
+
+	switch (agg._type)
+	{
+		case db_bool:
+		case db_ub1:
+			memdb_scan_integer_accumulate((const ub1_t*)data, bits, agg._function, acc);
+			break;
+		case db_sb1:
+			memdb_scan_integer_accumulate((const sb1_t*)data, bits, agg._function, acc);
+			break;
+		case db_sb2:
+			memdb_scan_integer_accumulate((const sb2_t*)data, bits, agg._function, acc);
+			break;
+		case db_ub2:
+			memdb_scan_integer_accumulate((const ub2_t*)data, bits, agg._function, acc);
+			break;
+		case db_sb4:
+			memdb_scan_integer_accumulate((const sb4_t*)data, bits, agg._function, acc);
+			break;
+		case db_ub4:
+			memdb_scan_integer_accumulate((const ub4_t*)data, bits, agg._function, acc);
+			break;
+		case db_sb8:
+		case db_ub8:
+		case db_date:
+			memdb_scan_integer_accumulate((const sb8_t*)data, bits, agg._function, acc);
+			break;
+		case db_float:
+			memdb_scan_real_accumulate((const float*)data, bits, agg._function, acc);
+			break;
+		case db_double:
+			memdb_scan_real_accumulate((const double*)data, bits, agg._function, acc);
+			break;
+		default:
+			// count of values
+			acc._count += memdb_scan_popcount(bits);
+			break;
+	}
+}
+
+//////////////////////////////////////////////////////////////
+memscan::memscan(memtable& parent) :
+	_parent(parent),
+	_batch(0),
+	_buffers(0),
+	_buffer_nulls(0),
+	_used(0),
+	_column_count(0),
+	_selection(0),
+	_selected(0),
+	_selection_size(0),
+	_nodes(0),
+	_nodes_size(0),
+	_group_count(0),
+	_keys(0),
+	_keys_size(0),
+	_hashes(0),
+	_hashes_size(0),
+	_accumulators(0),
+	_accumulators_size(0),
+	_slots(0),
+	_slots_size(0)
+{
+}
+
+memscan::~memscan()
+{
+	delete [] _batch;
+	delete [] _buffers;
+	delete [] _buffer_nulls;
+	delete [] _used;
+	delete [] _selection;
+	delete [] _nodes;
+	delete [] _keys;
+	delete [] _hashes;
+	delete [] _accumulators;
+	delete [] _slots;
+}
+
+const char*
+memscan::get_last_error()
+{
+	return _error;
+}
+
+bool
+memscan::add_predicate(size_t index, terimber_scan_operator op, const terimber_db_value_vector* values)
+{
+	if (index >= _parent.get_column_count())
+	{
+		_error = "column index is out of range";
+		return false;
+	}
+
+	dbtypes type = _parent.get_column_type(index);
+	if (!memdb_scan_predicate_type(type))
+	{
+		_error = "column type is not supported by scan";
+		return false;
+	}
+
+	size_t count = values ? values->get_size() : 0;
+	size_t needed = op == scan_between ? 2 : 1;
+	if (count < needed)
+	{
+		_error = "not enough values for predicate";
+		return false;
+	}
+
+	if (op != scan_in)
+		count = needed;
+
+	// converts values to the column type
+	terimber_index_column_array_t types;
+	types.resize(count);
+	for (size_t ival = 0; ival < count; ++ival)
+		types[ival]._type = type;
+
+	_vector< terimber_db_value > converted;
+	if (!converted.resize(_allocator, count)
+		|| !copy_db_row(values, converted.begin(), types, count, _allocator, _error))
+	{
+		if (!_error.length())
+			_error = "not enough memory";
+		return false;
+	}
+
+	memdb_scan_predicate pred;
+	pred._index = index;
+	pred._type = type;
+	if (!pred._ranges.resize(_allocator, count))
+	{
+		_error = "not enough memory";
+		return false;
+	}
+
+	size_t ranges = 0;
+	for (size_t irange = 0; irange < count; irange += (op == scan_between ? 2 : 1))
+	{
+		// typed bounds, 0 - no bound
+		sb8_t low_value[2] = {0}, high_value[2] = {0};
+		const ub1_t* low = (const ub1_t*)low_value;
+		const ub1_t* high = (const ub1_t*)high_value;
+		bool low_strict = false, high_strict = false;
+
+		const terimber_db_value& first = converted[irange];
+		const terimber_db_value& second = converted[op == scan_between ? irange + 1 : irange];
+
+		// null values never match
+		if (first.nullVal || second.nullVal)
+			continue;
+
+		memdb_columns::store_value(type, first, (ub1_t*)low_value);
+		memdb_columns::store_value(type, second, (ub1_t*)high_value);
+
+		switch (op)
+		{
+			case scan_less:
+				low = 0;
+				high_strict = true;
+				break;
+			case scan_greater:
+				high = 0;
+				low_strict = true;
+				break;
+			default:
+				break;
+		}
+
+		memdb_scan_range& range = pred._ranges[ranges];
+		memset(&range, 0, sizeof(memdb_scan_range));
+		bool valid = true;
+
+		switch (type)
+		{
+			case db_bool:
+				valid = memdb_scan_integer_bounds< ub1_t >(range, low, high, low_strict, high_strict, 0, 1);
+				break;
+			case db_ub1:
+				valid = memdb_scan_integer_bounds< ub1_t >(range, low, high, low_strict, high_strict, 0, 0xff);
+				break;
+			case db_sb1:
+				valid = memdb_scan_integer_bounds< sb1_t >(range, low, high, low_strict, high_strict, -0x7f - 1, 0x7f);
+				break;
+			case db_ub2:
+				valid = memdb_scan_integer_bounds< ub2_t >(range, low, high, low_strict, high_strict, 0, 0xffff);
+				break;
+			case db_sb2:
+				valid = memdb_scan_integer_bounds< sb2_t >(range, low, high, low_strict, high_strict, -0x7fff - 1, 0x7fff);
+				break;
+			case db_ub4:
+				valid = memdb_scan_integer_bounds< ub4_t >(range, low, high, low_strict, high_strict, 0, 0xffffffff);
+				break;
+			case db_sb4:
+				valid = memdb_scan_integer_bounds< sb4_t >(range, low, high, low_strict, high_strict, -0x7fffffff - 1, 0x7fffffff);
+				break;
+			case db_ub8:
+				valid = memdb_scan_integer_bounds< ub8_t >(range, low, high, low_strict, high_strict, 0, ~(ub8_t)0);
+				break;
+			case db_sb8:
+			case db_date:
+				valid = memdb_scan_integer_bounds< sb8_t >(range, low, high, low_strict, high_strict, (sb8_t)((ub8_t)1 << 63), (sb8_t)(~(ub8_t)0 >> 1));
+				break;
+			case db_float:
+				range._dlow = low ? *(const float*)low : -HUGE_VAL;
+				range._dhigh = high ? *(const float*)high : HUGE_VAL;
+				break;
+			case db_double:
+				range._dlow = low ? *(const double*)low : -HUGE_VAL;
+				range._dhigh = high ? *(const double*)high : HUGE_VAL;
+				break;
+			default:
+				// strings stay on the scan allocator
+				range._slow = low ? *(const void* const*)low : 0;
+				range._shigh = high ? *(const void* const*)high : 0;
+				break;
+		}
+
+		if (!valid)
+			continue;
+
+		range._low_strict = low_strict;
+		range._high_strict = high_strict;
+		++ranges;
+	}
+
+	// predicate without ranges matches nothing
+	pred._ranges.reduce(ranges);
+	_predicates.push_back(pred);
+	return true;
+}
+
+bool
+memscan::add_aggregate(size_t index, terimber_scan_function function)
+{
+	memdb_scan_aggregate agg;
+	agg._index = index;
+	agg._function = function;
+	agg._type = db_unknown;
+
+	if (index == os_minus_one)
+	{
+		if (function != scan_count)
+		{
+			_error = "only count can be computed without column";
+			return false;
+		}
+	}
+	else if (index >= _parent.get_column_count())
+	{
+		_error = "column index is out of range";
+		return false;
+	}
+	else
+	{
+		agg._type = _parent.get_column_type(index);
+
+		if (function != scan_count
+			&& (!memdb_scan_predicate_type(agg._type)
+				|| agg._type == db_string
+				|| agg._type == db_wstring
+				|| (function == scan_sum && agg._type == db_date)))
+		{
+			_error = "column type is not supported by aggregate";
+			return false;
+		}
+	}
+
+	_aggregates.push_back(agg);
+	return true;
+}
+
+bool
+memscan::add_group(size_t index)
+{
+	if (index >= _parent.get_column_count())
+	{
+		_error = "column index is out of range";
+		return false;
+	}
+
+	memdb_scan_group group;
+	group._index = index;
+	group._type = _parent.get_column_type(index);
+
+	if (!memdb_scan_predicate_type(group._type)
+		|| memdb_scan_floating(group._type)
+		|| group._type == db_wstring)
+	{
+		_error = "column type is not supported by group";
+		return false;
+	}
+
+	_groups.push_back(group);
+	return true;
+}
+
+void
+memscan::clear()
+{
+	reset_results();
+	_predicates.clear();
+	_aggregates.clear();
+	_groups.clear();
+	_allocator.reset();
+}
+
+void
+memscan::reset_results()
+{
+	_selected = 0;
+	_group_count = 0;
+	_group_allocator.reset();
+	if (_slots)
+		memset(_slots, 0, _slots_size * sizeof(size_t));
+}
+
+bool
+memscan::execute()
+{
+	reset_results();
+
+	// writers wait for scan, lookups don't
+	mutexKeeper guard(_parent._mtx);
+
+	size_t col_count = _parent._cols.size();
+
+	// table can be created again after scan has been set up
+	bool valid = true;
+	for (list_predicates_t::const_iterator piter = _predicates.begin(); piter != _predicates.end(); ++piter)
+		valid = valid && piter->_index < col_count && _parent._cols[piter->_index]._type == piter->_type;
+	for (list_aggregates_t::const_iterator aiter = _aggregates.begin(); aiter != _aggregates.end(); ++aiter)
+		valid = valid && (aiter->_index == os_minus_one || (aiter->_index < col_count && _parent._cols[aiter->_index]._type == aiter->_type));
+	for (list_groups_t::const_iterator giter = _groups.begin(); giter != _groups.end(); ++giter)
+		valid = valid && giter->_index < col_count && _parent._cols[giter->_index]._type == giter->_type;
+
+	if (!valid)
+	{
+		_error = "table columns have been changed";
+		return false;
+	}
+
+	if (_column_count != col_count)
+	{
+		delete [] _batch;
+		delete [] _buffers;
+		delete [] _buffer_nulls;
+		delete [] _used;
+		_batch = 0;
+		_buffers = 0;
+		_buffer_nulls = 0;
+		_used = 0;
+		_column_count = 0;
+
+		_batch = new memdb_scan_column[col_count + 1];
+		_used = new bool[col_count + 1];
+		if (!_batch || !_used)
+		{
+			_error = "not enough memory";
+			return false;
+		}
+
+		_column_count = col_count;
+	}
+
+	// marks columns to be read
+	for (size_t icol = 0; icol < col_count; ++icol)
+	{
+		_used[icol] = false;
+		_batch[icol]._width = memdb_type_width(_parent._cols[icol]._type);
+	}
+
+	for (list_predicates_t::const_iterator piter = _predicates.begin(); piter != _predicates.end(); ++piter)
+		_used[piter->_index] = true;
+	for (list_aggregates_t::const_iterator aiter = _aggregates.begin(); aiter != _aggregates.end(); ++aiter)
+		if (aiter->_index != os_minus_one)
+			_used[aiter->_index] = true;
+	for (list_groups_t::const_iterator giter = _groups.begin(); giter != _groups.end(); ++giter)
+		_used[giter->_index] = true;
+
+	if (_groups.empty())
+	{
+		// one group for all rows
+		if (!add_group_accumulators())
+		{
+			_error = "not enough memory";
+			return false;
+		}
+	}
+	else if (!_slots)
+	{
+		_slots = new size_t[os_def_size];
+		if (!_slots)
+		{
+			_error = "not enough memory";
+			return false;
+		}
+
+		_slots_size = os_def_size;
+		memset(_slots, 0, _slots_size * sizeof(size_t));
+	}
+
+	return _parent._columnar ? scan_columns() : scan_rows();
+}
+
+bool
+memscan::scan_columns()
+{
+	const memdb_columns& columns = _parent._columns;
+	size_t rows = columns.get_row_count();
+	const ub1_t* statuses = columns.get_statuses();
+
+	// replaced and deleted versions waiting for reclamation are in column store yet
+	size_t excluded_count = _parent._retired.size();
+	size_t* excluded = new size_t[excluded_count + 1];
+	if (!excluded)
+	{
+		_error = "not enough memory";
+		return false;
+	}
+
+	size_t iexcluded = 0;
+	for (memtable::list_retired_t::const_iterator riter = _parent._retired.begin(); riter != _parent._retired.end(); ++riter)
+		excluded[iexcluded++] = riter->_row->_value._pos;
+
+	std::sort(excluded, excluded + excluded_count);
+	iexcluded = 0;
+
+	for (size_t first = 0; first < rows; first += memdb_scan_batch)
+	{
+		size_t count = __min(memdb_scan_batch, rows - first);
+		size_t words = (count + 31) >> 5;
+
+		// live rows, unlinked positions are marked as deleted
+		for (size_t word = 0; word < words; ++word)
+		{
+			const ub1_t* status = statuses + first + (word << 5);
+			size_t values = __min((size_t)32, count - (word << 5));
+			ub4_t bits = 0;
+			for (size_t index = 0; index < values; ++index)
+				bits |= (ub4_t)(status[index] != status_deleted) << index;
+
+			_selected_bits[word] = bits;
+		}
+
+		for (; iexcluded < excluded_count && excluded[iexcluded] < first + count; ++iexcluded)
+		{
+			size_t pos = excluded[iexcluded] - first;
+			_selected_bits[pos >> 5] &= ~((ub4_t)1 << (pos & 31));
+		}
+
+		for (size_t icol = 0; icol < _column_count; ++icol)
+		{
+			if (!_used[icol])
+				continue;
+
+			const memdb_column& col = columns.get_column(icol);
+			_batch[icol]._data = col._data + first * col._width;
+			_batch[icol]._nulls = col._nulls + (first >> 5);
+			_batch[icol]._heap = col._heap;
+		}
+
+		if (!process_batch(count, first, 0))
+		{
+			delete [] excluded;
+			return false;
+		}
+	}
+
+	delete [] excluded;
+	return true;
+}
+
+bool
+memscan::scan_rows()
+{
+	if (!_buffers)
+	{
+		// typed arrays of the widest type
+		_buffers = new ub1_t[_column_count * memdb_scan_batch * sizeof(sb8_t) + 1];
+		_buffer_nulls = new ub4_t[_column_count * (memdb_scan_batch >> 5) + 1];
+		if (!_buffers || !_buffer_nulls)
+		{
+			_error = "not enough memory";
+			return false;
+		}
+	}
+
+	const memdb_rowset_t& rowset = _parent._rowset;
+	memdb_rowset_citerator_t iter = rowset.begin();
+	size_t first = 0;
+
+	while (iter != rowset.end())
+	{
+		// the last versions of live rows
+		size_t count = 0;
+		for (; iter != rowset.end() && count < memdb_scan_batch; ++iter)
+			if (iter->_end == memdb_epoch_infinite && iter->_status != status_deleted)
+				_batch_nodes[count++] = iter.node();
+
+		if (!count)
+			break;
+
+		size_t words = (count + 31) >> 5;
+		for (size_t word = 0; word < words; ++word)
+			_selected_bits[word] = memdb_scan_mask(count - (word << 5));
+
+		// gathers values of used columns
+		for (size_t icol = 0; icol < _column_count; ++icol)
+		{
+			if (!_used[icol])
+				continue;
+
+			dbtypes type = _parent._cols[icol]._type;
+			size_t width = _batch[icol]._width;
+			ub1_t* data = _buffers + icol * memdb_scan_batch * sizeof(sb8_t);
+			ub4_t* nulls = _buffer_nulls + icol * (memdb_scan_batch >> 5);
+			memset(nulls, 0, words * sizeof(ub4_t));
+
+			for (size_t index = 0; index < count; ++index)
+			{
+				const terimber_db_value& value = _batch_nodes[index]->_value._row[icol];
+				if (value.nullVal)
+					nulls[index >> 5] |= (ub4_t)1 << (index & 31);
+				else
+					memdb_columns::store_value(type, value, data + index * width);
+			}
+
+			_batch[icol]._data = data;
+			_batch[icol]._nulls = nulls;
+			_batch[icol]._heap = 0;
+		}
+
+		if (!process_batch(count, first, _batch_nodes))
+			return false;
+
+		first += count;
+	}
+
+	return true;
+}
+
+bool
+memscan::process_batch(size_t count, size_t first, memdb_rownode_t* const* nodes)
+{
+	size_t words = (count + 31) >> 5;
+
+	// predicates narrow the selection word by word
+	for (list_predicates_t::const_iterator piter = _predicates.begin(); piter != _predicates.end(); ++piter)
+	{
+		const memdb_scan_column& col = _batch[piter->_index];
+		for (size_t word = 0; word < words; ++word)
+		{
+			ub4_t bits = _selected_bits[word] & ~col._nulls[word];
+			if (bits)
+				bits &= match(*piter, col, word, __min((size_t)32, count - (word << 5)), bits);
+
+			_selected_bits[word] = bits;
+		}
+	}
+
+	// selection vector
+	size_t selected = 0;
+	for (size_t word = 0; word < words; ++word)
+		selected += memdb_scan_popcount(_selected_bits[word]);
+
+	if (!selected)
+		return true;
+
+	if (!memdb_scan_reserve(_selection, _selection_size, _selected, _selected + selected)
+		|| (nodes && !memdb_scan_reserve(_nodes, _nodes_size, _selected, _selected + selected)))
+	{
+		_error = "not enough memory";
+		return false;
+	}
+
+	size_t selected_first = _selected;
+	for (size_t word = 0; word < words; ++word)
+		for (ub4_t bits = _selected_bits[word]; bits; bits &= bits - 1)
+		{
+			size_t row = (word << 5) + memdb_scan_lowest(bits);
+			_selection[_selected] = first + row;
+			if (nodes)
+				_nodes[_selected] = nodes[row];
+			++_selected;
+		}
+
+	if (_aggregates.empty() && _groups.empty())
+		return true;
+
+	if (_groups.empty())
+	{
+		// column by column over the whole batch
+		size_t iagg = 0;
+		for (list_aggregates_t::const_iterator aiter = _aggregates.begin(); aiter != _aggregates.end(); ++aiter, ++iagg)
+		{
+			memdb_scan_accumulator& acc = _accumulators[iagg];
+			if (aiter->_index == os_minus_one)
+			{
+				acc._count += selected;
+				continue;
+			}
+
+			const memdb_scan_column& col = _batch[aiter->_index];
+			for (size_t word = 0; word < words; ++word)
+			{
+				ub4_t bits = _selected_bits[word] & ~col._nulls[word];
+				if (bits)
+					memdb_scan_accumulate(*aiter, col, word, bits, acc);
+			}
+		}
+
+		return true;
+	}
+
+	// row by row for groups
+	size_t agg_count = _aggregates.size();
+	for (size_t irow = selected_first; irow < _selected; ++irow)
+	{
+		size_t row = _selection[irow] - first;
+		size_t group = find_group(row);
+		if (group == os_minus_one)
+		{
+			_error = "not enough memory";
+			return false;
+		}
+
+		memdb_scan_accumulator* accs = _accumulators + group * agg_count;
+		for (list_aggregates_t::const_iterator aiter = _aggregates.begin(); aiter != _aggregates.end(); ++aiter, ++accs)
+		{
+			if (aiter->_index == os_minus_one)
+			{
+				++accs->_count;
+				continue;
+			}
+
+			const memdb_scan_column& col = _batch[aiter->_index];
+			ub4_t bit = (ub4_t)1 << (row & 31);
+			if (!(col._nulls[row >> 5] & bit))
+				memdb_scan_accumulate(*aiter, col, row >> 5, bit, *accs);
+		}
+	}
+
+	return true;
+}
+
+ub4_t
+memscan::match(const memdb_scan_predicate& pred, const memdb_scan_column& col, size_t word, size_t count, ub4_t candidates)
+{
+	const ub1_t* data = col._data + (word << 5) * col._width;
+	ub4_t bits = 0;
+
+	// ranges of scan_in are joined
+	for (size_t irange = 0; irange < pred._ranges.size(); ++irange)
+	{
+		const memdb_scan_range& range = pred._ranges[irange];
+
+		switch (pred._type)
+		{
+			case db_bool:
+			case db_ub1:
+				bits |= memdb_scan_integer((const ub1_t*)data, count, (ub1_t)range._llow, (ub1_t)range._lhigh);
+				break;
+			case db_sb1:
+				bits |= memdb_scan_integer((const sb1_t*)data, count, (sb1_t)range._llow, (sb1_t)range._lhigh);
+				break;
+			case db_ub2:
+				bits |= memdb_scan_integer((const ub2_t*)data, count, (ub2_t)range._llow, (ub2_t)range._lhigh);
+				break;
+			case db_sb2:
+				bits |= memdb_scan_integer((const sb2_t*)data, count, (sb2_t)range._llow, (sb2_t)range._lhigh);
+				break;
+			case db_ub4:
+				bits |= memdb_scan_integer((const ub4_t*)data, count, (ub4_t)range._llow, (ub4_t)range._lhigh);
+				break;
+			case db_sb4:
+				bits |= memdb_scan_integer((const sb4_t*)data, count, (sb4_t)range._llow, (sb4_t)range._lhigh);
+				break;
+			case db_ub8:
+				bits |= memdb_scan_integer((const ub8_t*)data, count, (ub8_t)range._llow, (ub8_t)range._lhigh);
+				break;
+			case db_sb8:
+			case db_date:
+				bits |= memdb_scan_integer((const sb8_t*)data, count, range._llow, range._lhigh);
+				break;
+			case db_float:
+				bits |= memdb_scan_real((const float*)data, count, (float)range._dlow, (float)range._dhigh, range._low_strict, range._high_strict);
+				break;
+			case db_double:
+				bits |= memdb_scan_real((const double*)data, count, range._dlow, range._dhigh, range._low_strict, range._high_strict);
+				break;
+			case db_string:
+				bits |= memdb_scan_string< char >(col, data, candidates & ~bits, range);
+				break;
+			case db_wstring:
+				bits |= memdb_scan_string< wchar_t >(col, data, candidates & ~bits, range);
+				break;
+			default:
+				break;
+		}
+	}
+
+	return bits;
+}
+
+size_t
+memscan::find_group(size_t row)
+{
+	size_t group_columns = _groups.size();
+	if (!memdb_scan_reserve(_keys, _keys_size, _group_count * group_columns, (_group_count + 1) * group_columns))
+		return os_minus_one;
+
+	// the key of row is made in place of the next group
+	memdb_scan_key* probe = _keys + _group_count * group_columns;
+	size_t hash = memdb_hash_seed;
+	ub4_t bit = (ub4_t)1 << (row & 31);
+
+	memdb_scan_key* key = probe;
+	for (list_groups_t::const_iterator giter = _groups.begin(); giter != _groups.end(); ++giter, ++key)
+	{
+		const memdb_scan_column& col = _batch[giter->_index];
+		key->_null = (col._nulls[row >> 5] & bit) != 0;
+		key->_long = 0;
+		key->_string = 0;
+
+		if (key->_null)
+			hash = (hash ^ 0xff) * memdb_hash_prime;
+		else if (giter->_type == db_string)
+		{
+			key->_string = (const char*)memdb_scan_pointer(col, col._data + row * col._width);
+			hash = hash_db_bytes(hash, key->_string, strlen(key->_string));
+		}
+		else
+		{
+			key->_long = memdb_scan_long(giter->_type, col._data + row * col._width);
+			hash = hash_db_bytes(hash, &key->_long, sizeof(sb8_t));
+		}
+	}
+
+	size_t mask = _slots_size - 1;
+	size_t slot = hash & mask;
+	for (; _slots[slot]; slot = (slot + 1) & mask)
+	{
+		size_t group = _slots[slot] - 1;
+		if (_hashes[group] != hash)
+			continue;
+
+		const memdb_scan_key* keys = _keys + group * group_columns;
+		size_t icol = 0;
+		for (; icol < group_columns; ++icol)
+			if (keys[icol]._null != probe[icol]._null
+				|| keys[icol]._long != probe[icol]._long
+				|| (keys[icol]._string && str_template::strcmp(keys[icol]._string, probe[icol]._string)))
+				break;
+
+		if (icol == group_columns)
+			return group;
+	}
+
+	// new group keeps its own copy of strings
+	for (size_t icol = 0; icol < group_columns; ++icol)
+		if (probe[icol]._string
+			&& !(probe[icol]._string = copy_string(probe[icol]._string, _group_allocator, os_minus_one)))
+			return os_minus_one;
+
+	size_t group = _group_count;
+	if (!memdb_scan_reserve(_hashes, _hashes_size, group, group + 1)
+		|| !add_group_accumulators())
+		return os_minus_one;
+
+	_hashes[group] = hash;
+	_slots[slot] = group + 1;
+
+	// keeps load under half
+	if (_group_count * 2 > _slots_size)
+	{
+		size_t* slots = new size_t[_slots_size * 2];
+		if (!slots)
+			return os_minus_one;
+
+		delete [] _slots;
+		_slots = slots;
+		_slots_size *= 2;
+		memset(_slots, 0, _slots_size * sizeof(size_t));
+
+		mask = _slots_size - 1;
+		for (size_t igroup = 0; igroup < _group_count; ++igroup)
+		{
+			for (slot = _hashes[igroup] & mask; _slots[slot]; slot = (slot + 1) & mask);
+			_slots[slot] = igroup + 1;
+		}
+	}
+
+	return group;
+}
+
+bool
+memscan::add_group_accumulators()
+{
+	size_t agg_count = _aggregates.size();
+	if (!memdb_scan_reserve(_accumulators, _accumulators_size, _group_count * agg_count, (_group_count + 1) * agg_count))
+		return false;
+
+	memdb_scan_accumulator* acc = _accumulators + _group_count * agg_count;
+	for (size_t iagg = 0; iagg < agg_count; ++iagg, ++acc)
+	{
+		acc->_count = 0;
+		acc->_lsum = 0;
+		acc->_lmin = (sb8_t)(~(ub8_t)0 >> 1);
+		acc->_lmax = (sb8_t)((ub8_t)1 << 63);
+		acc->_dsum = 0;
+		acc->_dmin = HUGE_VAL;
+		acc->_dmax = -HUGE_VAL;
+	}
+
+	++_group_count;
+	return true;
+}
+
+size_t
+memscan::get_selected_count() const
+{
+	return _selected;
+}
+
+const size_t*
+memscan::get_selection() const
+{
+	return _selection;
+}
+
+bool
+memscan::get_value_is_null(size_t row, size_t index) const
+{
+	if (row >= _selected || index >= _parent.get_column_count())
+		return true;
+
+	if (!_parent.is_columnar())
+		return _nodes[row]->_value._row[index].nullVal;
+
+	memdb_row dummy;
+	dummy._pos = _selection[row];
+	return _parent.get_columns().is_null(dummy, index);
+}
+
+sb8_t
+memscan::get_value_as_long64(size_t row, size_t index) const
+{
+#ifdef OS_64BIT
+	return get_value_as_value(row, index, vt_sb8).intVal;
+#else
+	const sb8_t* ret = get_value_as_value(row, index, vt_sb8).intVal;
+	return ret ? *ret : 0;
+#endif
+}
+
+double
+memscan::get_value_as_double(size_t row, size_t index) const
+{
+#ifdef OS_64BIT
+	return get_value_as_value(row, index, vt_double).dblVal;
+#else
+	const double* ret = get_value_as_value(row, index, vt_double).dblVal;
+	return ret ? *ret : 0.0;
+#endif
+}
+
+const char*
+memscan::get_value_as_string(size_t row, size_t index) const
+{
+	return get_value_as_value(row, index, vt_string).strVal;
+}
+
+terimber_xml_value
+memscan::get_value_as_value(size_t row, size_t index, vt_types type) const
+{
+	try
+	{
+		if (row >= _selected || index >= _parent.get_column_count())
+			exception::_throw("Out of range");
+
+		terimber_db_value value;
+		if (_parent.is_columnar())
+		{
+			memdb_row dummy;
+			dummy._pos = _selection[row];
+			value = _parent.get_columns().get_value(dummy, index);
+		}
+		else
+			value = _nodes[row]->_value._row[index];
+
+		if (value.nullVal)
+			exception::_throw("Null value");
+
+		_tmp_allocator.reset();
+		return convert_db_value(_parent.get_column_type(index), value, type, _tmp_allocator);
+	}
+	catch (...)
+	{
+		terimber_xml_value val;
+		memset(&val, 0, sizeof(terimber_xml_value));
+		return val;
+	}
+}
+
+size_t
+memscan::get_group_count() const
+{
+	return _group_count;
+}
+
+bool
+memscan::get_group_value_is_null(size_t group, size_t index) const
+{
+	size_t group_columns = _groups.size();
+	return group >= _group_count || index >= group_columns || _keys[group * group_columns + index]._null;
+}
+
+sb8_t
+memscan::get_group_value_as_long64(size_t group, size_t index) const
+{
+	size_t group_columns = _groups.size();
+	return group < _group_count && index < group_columns ? _keys[group * group_columns + index]._long : 0;
+}
+
+const char*
+memscan::get_group_value_as_string(size_t group, size_t index) const
+{
+	size_t group_columns = _groups.size();
+	return group < _group_count && index < group_columns ? _keys[group * group_columns + index]._string : 0;
+}
+
+bool
+memscan::get_aggregate_is_null(size_t group, size_t index) const
+{
+	size_t agg_count = _aggregates.size();
+	if (group >= _group_count || index >= agg_count)
+		return true;
+
+	list_aggregates_t::const_iterator aiter = _aggregates.begin();
+	for (size_t iagg = 0; iagg < index; ++iagg)
+		++aiter;
+
+	return aiter->_function != scan_count && !_accumulators[group * agg_count + index]._count;
+}
+
+sb8_t
+memscan::get_aggregate_as_long64(size_t group, size_t index) const
+{
+	size_t agg_count = _aggregates.size();
+	if (group >= _group_count || index >= agg_count)
+		return 0;
+
+	list_aggregates_t::const_iterator aiter = _aggregates.begin();
+	for (size_t iagg = 0; iagg < index; ++iagg)
+		++aiter;
+
+	const memdb_scan_accumulator& acc = _accumulators[group * agg_count + index];
+	bool floating = memdb_scan_floating(aiter->_type);
+
+	switch (aiter->_function)
+	{
+		case scan_count:
+			return (sb8_t)acc._count;
+		case scan_sum:
+			return floating ? (sb8_t)acc._dsum : acc._lsum;
+		case scan_min:
+			return !acc._count ? 0 : (floating ? (sb8_t)acc._dmin : acc._lmin);
+		case scan_max:
+			return !acc._count ? 0 : (floating ? (sb8_t)acc._dmax : acc._lmax);
+		default:
+			return 0;
+	}
+}
+
+double
+memscan::get_aggregate_as_double(size_t group, size_t index) const
+{
+	size_t agg_count = _aggregates.size();
+	if (group >= _group_count || index >= agg_count)
+		return 0.0;
+
+	list_aggregates_t::const_iterator aiter = _aggregates.begin();
+	for (size_t iagg = 0; iagg < index; ++iagg)
+		++aiter;
+
+	const memdb_scan_accumulator& acc = _accumulators[group * agg_count + index];
+	bool floating = memdb_scan_floating(aiter->_type);
+
+	switch (aiter->_function)
+	{
+		case scan_count:
+			return (double)acc._count;
+		case scan_sum:
+			return floating ? acc._dsum : (double)acc._lsum;
+		case scan_min:
+			return !acc._count ? 0.0 : (floating ? acc._dmin : (double)acc._lmin);
+		case scan_max:
+			return !acc._count ? 0.0 : (floating ? acc._dmax : (double)acc._lmax);
+		default:
+			return 0.0;
+	}
+}
+
+#pragma pack()
+END_TERIMBER_NAMESPACE
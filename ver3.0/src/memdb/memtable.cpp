@@ -27,6 +27,7 @@
 
 #include "memdb/memdb.hpp"
 #include "base/list.hpp"
+#include "base/map.hpp"
 #include "base/memory.hpp"
 #include "base/vector.hpp"
 
@@ -34,334 +35,2671 @@ BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
 ////////////////////////////////////////////////////////////////
-
-memtable::memtable()
+void*
+memdb_allocate(chunk_provider* provider, size_t& size)
 {
+	return provider ? provider->allocate_chunk(size) : ::malloc(size);
 }
 
-//
-// destructor
-// user is responsible for destoying memtable object
-//
-memtable::~memtable()
+void
+memdb_release(chunk_provider* provider, void* ptr, size_t size)
 {
-	uninit();
+	if (!ptr)
+		return;
+
+	if (provider)
+		provider->release_chunk(ptr, size);
+	else
+		::free(ptr);
 }
 
-void 
-memtable::uninit()
+////////////////////////////////////////////////////////////////
+//! \brief multiplies 128 bits magnitude by mul and adds add
+//! returns false if result exceeds 127 bits
+static
+bool
+memdb_decimal_mul_add(ub8_t& high, ub8_t& low, ub4_t mul, ub4_t add)
 {
-	mutexKeeper guard(_mtx);
-	for (list_indexes_t::iterator iiter = _indexes.begin(); iiter != _indexes.end(); ++iiter)
-		delete *iiter;
+	ub4_t limbs[4] = { (ub4_t)low, (ub4_t)(low >> 32), (ub4_t)high, (ub4_t)(high >> 32) };
+	ub8_t carry = add;
+	for (size_t index = 0; index < 4; ++index)
+	{
+		carry += (ub8_t)limbs[index] * mul;
+		limbs[index] = (ub4_t)carry;
+		carry >>= 32;
+	}
 
-	_indexes.clear();
+	if (carry || (limbs[3] & 0x80000000))
+		return false;
 
-	for (list_values_t::iterator viter = _values.begin(); viter != _values.end(); ++viter)
-		delete *viter;
+	low = ((ub8_t)limbs[1] << 32) | limbs[0];
+	high = ((ub8_t)limbs[3] << 32) | limbs[2];
+	return true;
+}
 
-	_values.clear();
+//! \brief divides 128 bits magnitude by div, returns remainder
+static
+ub4_t
+memdb_decimal_div(ub8_t& high, ub8_t& low, ub4_t div)
+{
+	ub4_t limbs[4] = { (ub4_t)low, (ub4_t)(low >> 32), (ub4_t)high, (ub4_t)(high >> 32) };
+	ub8_t rem = 0;
+	for (size_t index = 4; index-- > 0;)
+	{
+		ub8_t cur = (rem << 32) | limbs[index];
+		limbs[index] = (ub4_t)(cur / div);
+		rem = cur % div;
+	}
 
-	_cols.clear();
-	_rowset.clear();
-	_allocator.clear_all();
+	low = ((ub8_t)limbs[1] << 32) | limbs[0];
+	high = ((ub8_t)limbs[3] << 32) | limbs[2];
+	return (ub4_t)rem;
 }
 
-//
-// returns the last occured error
-//
-const char*
-memtable::get_last_error()
+//! \brief negates 128 bits two's complement value
+static
+inline
+void
+memdb_decimal_negate(ub8_t& high, ub8_t& low)
 {
-	return _error;
+	low = ~low + 1;
+	high = ~high + (low ? 0 : 1);
 }
 
-// 
-// creates an internal table structure from @server object
-// db_server has to be after executing query or stored procedure
-// and ready to fetch data
-// memtable automatically detects the list of columns in recordset
-// and creates table in memory with the same columns' order and types.
-// @max_rows sets a restriction on max rows to be retrived, -1 - all of them
-// @start_row means absolute number of row to start with
-// unless you specify 0, then the memtable starts with the current row
-
 bool
-memtable::populate(dbserver* server, size_t start_row, size_t max_rows)
+memdb_decimal::parse(const char* str, char delimeter)
 {
-	uninit();
+	ub8_t high = 0, low = 0;
+	sb4_t scale = 0;
+	bool negative = false, digits = false, fraction = false;
+
+	while (*str == ' ')
+		++str;
+
+	if (*str == '-' || *str == '+')
+		negative = *str++ == '-';
 
-	// fetches here rows
-	if (!server->fetch_data(false, start_row, max_rows, true))
+	for (;; ++str)
 	{
-		_error = server->get_error();
-		return false;
+		if (*str >= '0' && *str <= '9')
+		{
+			if (!memdb_decimal_mul_add(high, low, 10, *str - '0'))
+				return false;
+
+			digits = true;
+			if (fraction)
+				++scale;
+		}
+		else if (*str == delimeter && !fraction)
+			fraction = true;
+		else
+			break;
 	}
 
-	// extracts columns here
-	size_t col_count = server->get_column_count();
-	if (!col_count)
-	{
-		_error = "no columns found";
+	if (!digits)
 		return false;
+
+	if (*str == 'e' || *str == 'E')
+	{
+		++str;
+		bool negative_exponent = false;
+		if (*str == '-' || *str == '+')
+			negative_exponent = *str++ == '-';
+
+		if (*str < '0' || *str > '9')
+			return false;
+
+		sb4_t exponent = 0;
+		for (; *str >= '0' && *str <= '9'; ++str)
+			if ((exponent = exponent * 10 + (*str - '0')) > (sb4_t)memdb_decimal_max_scale * 2)
+				return false;
+
+		scale += negative_exponent ? exponent : -exponent;
 	}
 
-	binder dummy;
-	_cols.resize(_allocator, col_count, dummy);
-	if (_cols.size() != col_count)
+	while (*str == ' ')
+		++str;
+
+	if (*str)
 		return false;
 
-	for (size_t icol = 0; icol < col_count; ++icol)
+	// negative scale is multiplied out
+	for (; scale < 0; ++scale)
+		if (!memdb_decimal_mul_add(high, low, 10, 0))
+			return false;
+
+	// trailing zeros of fraction, zero gets scale 0
+	while (scale > 0)
 	{
-		_cols[icol]._type = server->get_column_type(icol);
-		_cols[icol]._max_length = server->get_column_max_length(icol);
-		_cols[icol]._value.nullVal = server->get_column_nullable(icol);
-		_cols[icol]._precision = server->get_column_precision(icol);
-		_cols[icol]._scale = server->get_column_scale(icol);
-		_cols[icol].set_name(&_allocator, server->get_column_name(icol));
+		ub8_t quotient_high = high, quotient_low = low;
+		if (memdb_decimal_div(quotient_high, quotient_low, 10))
+			break;
+
+		high = quotient_high;
+		low = quotient_low;
+		--scale;
 	}
 
-	while (server->next())
-	{
-		// inserts new row
-		memdb_row dummy_row;
-		_rowset.push_back(dummy_row);
-		memdb_row& row = _rowset.back();
-		// resizes row, room for columns
-		row._row.resize(_allocator, col_count);
-		row._status = status_original;
-
-		if (!copy_db_row(server, row, _cols, _cols.size(), _allocator, _error))
-			return false;
+	if (scale > (sb4_t)memdb_decimal_max_scale)
+		return false;
 
-	} // while
+	if (negative)
+		memdb_decimal_negate(high, low);
 
+	_low = low;
+	_high = (sb8_t)high;
+	_scale = scale;
 	return true;
 }
 
-bool 
-memtable::create(size_t columns, const terimber_table_column_desc desc[])
+void
+memdb_decimal::format(char* buf, char delimeter) const
 {
-	uninit();
-	
-	binder dummy;
-	_cols.resize(_allocator, columns, dummy);
-	if (_cols.size() != columns)
-		return false;
+	ub8_t high = (ub8_t)_high, low = _low;
+	bool negative = _high < 0;
+	if (negative)
+		memdb_decimal_negate(high, low);
 
-	for (size_t icol = 0; icol < columns; ++icol)
+	// digits in reverse order, at least one before delimeter
+	char digits[memdb_decimal_chars];
+	size_t count = 0;
+	do
+		digits[count++] = (char)('0' + memdb_decimal_div(high, low, 10));
+	while (high || low);
+
+	while (count <= (size_t)_scale)
+		digits[count++] = '0';
+
+	if (negative)
+		*buf++ = '-';
+
+	while (count)
 	{
-		_cols[icol]._type = desc[icol]._type;
-		_cols[icol]._max_length = desc[icol]._max_length;
-		_cols[icol]._value.nullVal = desc[icol]._nullable;
-		_cols[icol]._precision = desc[icol]._precision;
-		_cols[icol]._scale = desc[icol]._scale;
-		_cols[icol].set_name(&_allocator, desc[icol]._name);
+		if (count == (size_t)_scale)
+			*buf++ = delimeter;
+		*buf++ = digits[--count];
 	}
 
-	return true;
+	*buf = 0;
 }
 
-// resets all new, updates rows status to original, removes deleted rows
-// updates all indexes
-void 
-memtable::refresh()
+//static
+int
+memdb_decimal::compare_scaled(const memdb_decimal& first, const memdb_decimal& second)
 {
-	// updates status
-	for (memdb_rowset_t::iterator it = _rowset.begin(); it != _rowset.end(); ++it)
+	int first_sign = first._high < 0 ? -1 : (first._high || first._low ? 1 : 0);
+	int second_sign = second._high < 0 ? -1 : (second._high || second._low ? 1 : 0);
+	if (first_sign != second_sign)
+		return first_sign < second_sign ? -1 : 1;
+
+	// magnitudes at the bigger scale, the one exceeding 127 bits is bigger
+	ub8_t first_high = (ub8_t)first._high, first_low = first._low;
+	ub8_t second_high = (ub8_t)second._high, second_low = second._low;
+	if (first_sign < 0)
 	{
-		it->_status = status_original;
+		memdb_decimal_negate(first_high, first_low);
+		memdb_decimal_negate(second_high, second_low);
 	}
+
+	int res = 0;
+	for (sb4_t scale = first._scale; !res && scale < second._scale; ++scale)
+		if (!memdb_decimal_mul_add(first_high, first_low, 10, 0))
+			res = 1;
+
+	for (sb4_t scale = second._scale; !res && scale < first._scale; ++scale)
+		if (!memdb_decimal_mul_add(second_high, second_low, 10, 0))
+			res = -1;
+
+	if (!res && (first_high != second_high || first_low != second_low))
+		res = first_high != second_high ? (first_high < second_high ? -1 : 1) : (first_low < second_low ? -1 : 1);
+
+	return first_sign < 0 ? -res : res;
 }
 
-//
-// after populating and any time after that you can request the number of rows in the table
-//
-size_t 
-memtable::get_row_count()
+////////////////////////////////////////////////////////////////
+//! \class memdb_dictionary_less
+//! \brief orders dictionary entries like compare_value does
+class memdb_dictionary_less
+{
+public:
+	//! \brief constructor
+	memdb_dictionary_less(dbtypes type) :
+		_type(type)
+	{
+	}
+	//! \brief operator()
+	inline
+	bool
+	operator()(const memdb_dictionary_entry* first, const memdb_dictionary_entry* second) const
+	{
+		return _type == db_string ?
+			str_template::strcmp((const char*)first->value(), (const char*)second->value(), os_minus_one) < 0 :
+			str_template::strcmp((const wchar_t*)first->value(), (const wchar_t*)second->value(), os_minus_one) < 0;
+	}
+
+private:
+	dbtypes				_type;								//!< column type
+};
+
+memdb_dictionary::memdb_dictionary() :
+	_type(db_unknown),
+	_slots(0),
+	_capacity(0),
+	_count(0),
+	_ranked(0)
 {
-	return _rowset.size();
 }
 
-//
-// column's description is pretty much the same as db_server provides
-//
+memdb_dictionary::~memdb_dictionary()
+{
+	delete [] _slots;
+}
 
-//
-// gets column count
-//
-size_t 
-memtable::get_column_count() const
+void
+memdb_dictionary::create(dbtypes type)
 {
-	return _cols.size();
+	delete [] _slots;
+	_slots = 0;
+	_capacity = _count = _ranked = 0;
+	_type = type;
 }
 
-//
-// returns the virtual terimber dbtype like db_bool, ...
-//
-dbtypes
-memtable::get_column_type(size_t index) const
+const void*
+memdb_dictionary::intern(const void* value, byte_allocator& all)
 {
-	return index >= _cols.size() ? db_unknown : _cols[index]._type;
+	size_t length = _type == db_string ? strlen((const char*)value) + 1 : (wcslen((const wchar_t*)value) + 1) * sizeof(wchar_t);
+	size_t hash = hash_db_bytes(memdb_hash_seed, value, length);
+
+	// keeps slots half empty
+	if (_count * 2 >= _capacity && !grow())
+		return 0;
+
+	size_t mask = _capacity - 1;
+	size_t slot = hash & mask;
+	for (; _slots[slot]; slot = (slot + 1) & mask)
+	{
+		const memdb_dictionary_entry* entry = _slots[slot];
+		if (entry->_hash == hash
+			&& entry->_length == length
+			&& !memcmp(entry->value(), value, length))
+			return entry->value();
+	}
+
+	memdb_dictionary_entry* entry = (memdb_dictionary_entry*)all.allocate(sizeof(memdb_dictionary_entry) + length);
+	if (!entry)
+		return 0;
+
+	entry->_hash = hash;
+	entry->_length = length;
+	entry->_rank = 0;
+	memcpy(entry + 1, value, length);
+
+	_slots[slot] = entry;
+	++_count;
+	return entry->value();
 }
 
-//
-// returns the name of the column
-//
-const char*
-memtable::get_column_name(size_t index) const
+bool
+memdb_dictionary::attach(memdb_dictionary_entry* entry)
 {
-	return index >= _cols.size() ? 0 : _cols[index]._name;
+	if (_count * 2 >= _capacity && !grow())
+		return false;
+
+	put(entry);
+	++_count;
+	if (entry->_rank)
+		++_ranked;
+
+	return true;
 }
 
-//
-// returns the nullable - database specific
-//
-bool 
-memtable::get_column_nullable(size_t index) const
+bool
+memdb_dictionary::rank()
 {
-	return index >= _cols.size() ? false : _cols[index]._value.nullVal;
+	if (_ranked == _count)
+		return true;
+
+	memdb_dictionary_entry** sorted = new memdb_dictionary_entry*[_count + 1];
+	if (!sorted)
+		return false;
+
+	size_t count = 0;
+	for (size_t slot = 0; slot < _capacity; ++slot)
+		if (_slots[slot])
+			sorted[count++] = _slots[slot];
+
+	std::sort(sorted, sorted + count, memdb_dictionary_less(_type));
+
+	for (size_t index = 0; index < count; ++index)
+		sorted[index]->_rank = index + 1;
+
+	_ranked = count;
+	delete [] sorted;
+	return true;
 }
 
-//
-// returns the scale
-//
-size_t 
-memtable::get_column_scale(size_t index) const
+bool
+memdb_dictionary::grow()
 {
-	return index >= _cols.size() ? 0 : _cols[index]._scale;
+	size_t capacity = _capacity ? _capacity * 2 : 64;
+	memdb_dictionary_entry** slots = new memdb_dictionary_entry*[capacity];
+	if (!slots)
+		return false;
+
+	memset(slots, 0, capacity * sizeof(memdb_dictionary_entry*));
+
+	memdb_dictionary_entry** old_slots = _slots;
+	size_t old_capacity = _capacity;
+	_slots = slots;
+	_capacity = capacity;
+
+	for (size_t slot = 0; slot < old_capacity; ++slot)
+		if (old_slots[slot])
+			put(old_slots[slot]);
+
+	delete [] old_slots;
+	return true;
 }
-//
-// returns the precision
-//
-size_t 
-memtable::get_column_precision(size_t index) const
+
+void
+memdb_dictionary::put(memdb_dictionary_entry* entry)
 {
-	return index >= _cols.size() ? 0 : _cols[index]._precision;
+	size_t mask = _capacity - 1;
+	size_t slot = entry->_hash & mask;
+	while (_slots[slot])
+		slot = (slot + 1) & mask;
+
+	_slots[slot] = entry;
+}
+
+////////////////////////////////////////////////////////////////
+memdb_column::memdb_column() :
+	_type(db_unknown),
+	_width(0),
+	_data(0),
+	_data_size(0),
+	_nulls(0),
+	_nulls_size(0),
+	_heap(0)
+{
+}
+
+////////////////////////////////////////////////////////////////
+memdb_columns::memdb_columns(chunk_provider* provider) :
+	_provider(provider),
+	_columns(0),
+	_count(0),
+	_status(0),
+	_status_size(0),
+	_rows(0),
+	_capacity(0),
+	_mapped(false)
+{
+}
+
+memdb_columns::~memdb_columns()
+{
+	clear();
+}
+
+bool
+memdb_columns::create(const binders_t& cols)
+{
+	clear();
+
+	_columns = new memdb_column[cols.size()];
+	if (!_columns)
+		return false;
+
+	_count = cols.size();
+
+	for (size_t icol = 0; icol < _count; ++icol)
+	{
+		memdb_column& col = _columns[icol];
+		col._type = cols[icol]._type;
+		col._width = memdb_type_width(col._type);
+	}
+
+	return true;
+}
+
+void
+memdb_columns::clear()
+{
+	if (!_mapped)
+	{
+		for (size_t icol = 0; icol < _count; ++icol)
+		{
+			memdb_release(_provider, _columns[icol]._data, _columns[icol]._data_size);
+			memdb_release(_provider, _columns[icol]._nulls, _columns[icol]._nulls_size);
+		}
+
+		memdb_release(_provider, _status, _status_size);
+	}
+
+	release_retired();
+	_free.clear();
+
+	delete [] _columns;
+	_columns = 0;
+	_count = 0;
+
+	_status = 0;
+	_status_size = 0;
+	_rows = _capacity = 0;
+	_mapped = false;
 }
 
-//
-// returns the length of the column (only for fixed length columns)
-//
-size_t 
-memtable::get_column_max_length(size_t index) const
-{
-	return index >= _cols.size() ? 0 : _cols[index]._max_length;
-}
+size_t
+memdb_columns::add_row(terimber_db_row_status status)
+{
+	size_t pos;
+	if (!_free.empty())
+	{
+		pos = _free.front();
+		_free.pop_front();
+	}
+	else
+	{
+		if (_rows == _capacity
+			&& !grow(_capacity ? _capacity * 2 : os_def_size * 32))
+			return os_minus_one;
+
+		pos = _rows++;
+	}
+
+	_status[pos] = (ub1_t)status;
+
+	// new row has all nulls
+	for (size_t icol = 0; icol < _count; ++icol)
+		_columns[icol]._nulls[pos >> 5] |= 1 << (pos & 31);
+
+	return pos;
+}
+
+void
+memdb_columns::free_row(size_t pos)
+{
+	// scans of column store skip it until it is reused
+	_status[pos] = (ub1_t)status_deleted;
+	_free.push_back(pos);
+}
+
+void
+memdb_columns::release_retired()
+{
+	for (list< memdb_retired_array >::iterator iter = _retired.begin(); iter != _retired.end(); ++iter)
+		memdb_release(_provider, iter->_ptr, iter->_size);
+
+	_retired.clear();
+}
+
+void
+memdb_columns::retire(void* ptr, size_t size)
+{
+	if (!ptr)
+		return;
+
+	memdb_retired_array array;
+	array._ptr = ptr;
+	array._size = size;
+	_retired.push_back(array);
+}
+
+void
+memdb_columns::store_value(dbtypes type, const terimber_db_value& value, ub1_t* ptr)
+{
+	switch (type)
+	{
+		case db_bool:
+			*ptr = value.val.boolVal ? 1 : 0;
+			break;
+		case db_sb1:
+		case db_ub1:
+			*ptr = value.val.bVal;
+			break;
+		case db_sb2:
+		case db_ub2:
+			*(ub2_t*)ptr = value.val.uiVal;
+			break;
+		case db_sb4:
+		case db_ub4:
+			*(ub4_t*)ptr = value.val.ulVal;
+			break;
+		case db_float:
+			*(float*)ptr = value.val.fltVal;
+			break;
+#ifdef OS_64BIT
+		case db_double:
+			*(double*)ptr = value.val.dblVal;
+			break;
+		case db_sb8:
+		case db_ub8:
+		case db_date:
+			*(sb8_t*)ptr = value.val.intVal;
+			break;
+#else
+		case db_double:
+			*(double*)ptr = *value.val.dblVal;
+			break;
+		case db_sb8:
+		case db_ub8:
+		case db_date:
+			*(sb8_t*)ptr = *value.val.intVal;
+			break;
+#endif
+		case db_decimal:
+		case db_numeric:
+			memcpy(ptr, value.val.bufVal, sizeof(memdb_decimal));
+			break;
+		default:
+			*(const ub1_t**)ptr = value.val.bufVal;
+			break;
+	}
+}
+
+void
+memdb_columns::set_values(size_t pos, const terimber_db_value* values)
+{
+	for (size_t icol = 0; icol < _count; ++icol)
+	{
+		memdb_column& col = _columns[icol];
+		const terimber_db_value& value = values[icol];
+
+		if (value.nullVal)
+		{
+			col._nulls[pos >> 5] |= 1 << (pos & 31);
+			continue;
+		}
+
+		col._nulls[pos >> 5] &= ~(1 << (pos & 31));
+		store_value(col._type, value, col._data + pos * col._width);
+	}
+}
+
+void
+memdb_columns::attach_rows(size_t rows, ub1_t* status)
+{
+	_status = status;
+	_status_size = 0;
+	_rows = _capacity = rows;
+	_mapped = true;
+}
+
+void
+memdb_columns::attach_column(size_t index, ub1_t* data, ub4_t* nulls, const ub1_t* heap)
+{
+	memdb_column& col = _columns[index];
+	col._data = data;
+	col._data_size = 0;
+	col._nulls = nulls;
+	col._nulls_size = 0;
+	col._heap = heap;
+}
+
+bool
+memdb_columns::grow(size_t capacity)
+{
+	// status array
+	size_t status_size = capacity;
+	ub1_t* status = (ub1_t*)memdb_allocate(_provider, status_size);
+	if (!status)
+		return false;
+
+	if (_rows)
+		memcpy(status, _status, _rows);
+
+	// lookups can read the old arrays until their scans have finished,
+	// mapped arrays are copied, but stay in the mapping
+	if (!_mapped)
+		retire(_status, _status_size);
+	memdb_fence();
+	_status = status;
+	_status_size = status_size;
+
+	for (size_t icol = 0; icol < _count; ++icol)
+	{
+		memdb_column& col = _columns[icol];
+
+		size_t data_size = capacity * col._width;
+		ub1_t* data = (ub1_t*)memdb_allocate(_provider, data_size);
+		size_t nulls_size = ((capacity + 31) >> 5) * sizeof(ub4_t);
+		ub4_t* nulls = (ub4_t*)memdb_allocate(_provider, nulls_size);
+
+		if (!data || !nulls)
+		{
+			memdb_release(_provider, data, data_size);
+			memdb_release(_provider, nulls, nulls_size);
+			return false;
+		}
+
+		memset(nulls, 0, nulls_size);
+		if (_rows)
+		{
+			memcpy(data, col._data, _rows * col._width);
+			memcpy(nulls, col._nulls, ((_rows + 31) >> 5) * sizeof(ub4_t));
+		}
+
+		if (!_mapped)
+		{
+			retire(col._data, col._data_size);
+			retire(col._nulls, col._nulls_size);
+		}
+
+		memdb_fence();
+		col._data = data;
+		col._data_size = data_size;
+		col._nulls = nulls;
+		col._nulls_size = nulls_size;
+	}
+
+	_capacity = capacity;
+	_mapped = false;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////
+//! \class memdb_key_source
+//! \brief gives key columns of the current recordset row to copy_db_row as the columns in the key order
+class memdb_key_source
+{
+public:
+	//! \brief constructor
+	memdb_key_source(const dbserver* server, const size_t* keys) :
+		_server(server),
+		_keys(keys)
+	{
+	}
+
+	//! \brief returns null flag
+	inline
+	bool
+	get_value_is_null(size_t index) const
+	{
+		return _server->get_value_is_null(_keys[index]);
+	}
+	//! \brief returns value as bool
+	inline
+	bool
+	get_value_as_bool(size_t index) const
+	{
+		return _server->get_value_as_bool(_keys[index]);
+	}
+	//! \brief returns value as char
+	inline
+	sb1_t
+	get_value_as_char(size_t index) const
+	{
+		return _server->get_value_as_char(_keys[index]);
+	}
+	//! \brief returns value as byte
+	inline
+	ub1_t
+	get_value_as_byte(size_t index) const
+	{
+		return _server->get_value_as_byte(_keys[index]);
+	}
+	//! \brief returns value as short
+	inline
+	sb2_t
+	get_value_as_short(size_t index) const
+	{
+		return _server->get_value_as_short(_keys[index]);
+	}
+	//! \brief returns value as word
+	inline
+	ub2_t
+	get_value_as_word(size_t index) const
+	{
+		return _server->get_value_as_word(_keys[index]);
+	}
+	//! \brief returns value as long
+	inline
+	sb4_t
+	get_value_as_long(size_t index) const
+	{
+		return _server->get_value_as_long(_keys[index]);
+	}
+	//! \brief returns value as dword
+	inline
+	ub4_t
+	get_value_as_dword(size_t index) const
+	{
+		return _server->get_value_as_dword(_keys[index]);
+	}
+	//! \brief returns value as float
+	inline
+	float
+	get_value_as_float(size_t index) const
+	{
+		return _server->get_value_as_float(_keys[index]);
+	}
+	//! \brief returns value as double
+	inline
+	double
+	get_value_as_double(size_t index) const
+	{
+		return _server->get_value_as_double(_keys[index]);
+	}
+	//! \brief returns value as long64
+	inline
+	sb8_t
+	get_value_as_long64(size_t index) const
+	{
+		return _server->get_value_as_long64(_keys[index]);
+	}
+	//! \brief returns value as dword64
+	inline
+	ub8_t
+	get_value_as_dword64(size_t index) const
+	{
+		return _server->get_value_as_dword64(_keys[index]);
+	}
+	//! \brief returns value as guid
+	inline
+	bool
+	get_value_as_guid(size_t index, guid_t& val) const
+	{
+		return _server->get_value_as_guid(_keys[index], val);
+	}
+	//! \brief returns value as numeric
+	inline
+	const char*
+	get_value_as_numeric(size_t index, char delimeter) const
+	{
+		return _server->get_value_as_numeric(_keys[index], delimeter);
+	}
+	//! \brief returns value as string
+	inline
+	const char*
+	get_value_as_string(size_t index) const
+	{
+		return _server->get_value_as_string(_keys[index]);
+	}
+	//! \brief returns value as wstring
+	inline
+	const wchar_t*
+	get_value_as_wstring(size_t index) const
+	{
+		return _server->get_value_as_wstring(_keys[index]);
+	}
+	//! \brief returns value as binary pointer
+	inline
+	const ub1_t*
+	get_value_as_binary_ptr(size_t index) const
+	{
+		return _server->get_value_as_binary_ptr(_keys[index]);
+	}
+
+private:
+	const dbserver*		_server;							//!< recordset
+	const size_t*		_keys;								//!< recordset columns of key
+};
+
+memtable::memtable(chunk_provider* provider, bool columnar) :
+	_allocator(provider ? provider->granularity() : os_def_size, provider),
+	_rowset(provider ? provider->granularity() / sizeof(memdb_row) : os_def_size, provider),
+	_columnar(columnar),
+	_columns(provider),
+	_dictionaries(0),
+	_epoch(1),
+	_unlinked(0),
+	_arrays_epoch(0)
+{
+}
+
+//
+// destructor
+// user is responsible for destoying memtable object
+//
+memtable::~memtable()
+{
+	uninit();
+}
+
+void 
+memtable::uninit()
+{
+	mutexKeeper guard(_mtx);
+	for (list_indexes_t::iterator iiter = _indexes.begin(); iiter != _indexes.end(); ++iiter)
+		delete *iiter;
+
+	_indexes.clear();
+
+	for (list_values_t::iterator viter = _values.begin(); viter != _values.end(); ++viter)
+		delete *viter;
+
+	_values.clear();
+
+	for (list_scans_t::iterator siter = _scans.begin(); siter != _scans.end(); ++siter)
+		delete *siter;
+
+	_scans.clear();
+
+	clear_rows();
+}
+
+void
+memtable::clear_rows()
+{
+	_cols.clear();
+	_retired.clear();
+	_unlinked = 0;
+	_spare.clear();
+	_rowset.clear();
+	_columns.clear();
+	_row_values.clear();
+	delete [] _dictionaries;
+	_dictionaries = 0;
+	_allocator.clear_all();
+	_mapper.memunmapfile();
+}
+
+bool
+memtable::same_columns(const dbserver* server) const
+{
+	size_t col_count = server->get_column_count();
+	if (col_count != _cols.size())
+		return false;
+
+	for (size_t icol = 0; icol < col_count; ++icol)
+		if (_cols[icol]._type != server->get_column_type(icol))
+			return false;
+
+	return true;
+}
+
+//
+// returns the last occured error
+//
+const char*
+memtable::get_last_error()
+{
+	return _error;
+}
+
+//! \brief rows in one batch of population
+const size_t memdb_populate_batch = 4096;
+
+//! \class memdb_populate_buffer
+//! \brief batch of rows copied from dbserver, but not linked to the table yet
+class memdb_populate_buffer
+{
+public:
+	//! \brief constructor
+	memdb_populate_buffer() :
+		_rows(0),
+		_values(0),
+		_count(0),
+		_ready(false)
+	{
+	}
+
+	memdb_row*			_rows;								//!< rows
+	terimber_db_value*	_values;							//!< values of columnar table, columns by rows
+	size_t				_count;								//!< number of rows
+	bool				_ready;								//!< rows are waiting for linking
+};
+
+//! \class memdb_populator
+//! \brief pipelined population of memtable
+//! the fetcher thread copies the current batch from dbserver and fetches the next one,
+//! the caller thread links the copied batch to rowset and column store,
+//! one thread per index inserts the linked batch while the next batch is being fetched
+class memdb_populator : public terimber_thread_employer
+{
+public:
+	//! \brief constructor
+	memdb_populator(memtable& table,						//!< table
+					dbserver* server,						//!< dbserver with the first batch fetched
+					size_t remaining						//!< rows to fetch after the first batch
+					) :
+		_table(table),
+		_server(server),
+		_remaining(remaining),
+		_requested(memdb_populate_batch),
+		_threads(0),
+		_indexes(0),
+		_jobs(0),
+		_index_count(0),
+		_index_pending(0),
+		_first(table._rowset.end()),
+		_batch_count(0),
+		_finished(false),
+		_stop(false),
+		_failed(false)
+	{
+	}
+	//! \brief destructor
+	~memdb_populator()
+	{
+		if (_threads)
+		{
+			for (size_t index = 0; index <= _index_count; ++index)
+			{
+				_threads[index].cancel_job();
+				_threads[index].stop();
+			}
+
+			delete [] _threads;
+		}
+
+		delete [] _indexes;
+		delete [] _jobs;
+
+		for (size_t index = 0; index < 2; ++index)
+		{
+			delete [] _buffers[index]._rows;
+			delete [] _buffers[index]._values;
+		}
+	}
+
+	//! \brief runs population, returns false on error, table keeps the error then
+	bool
+	run()
+	{
+		if (!init())
+		{
+			_table._error = "no enough memory";
+			return false;
+		}
+
+		_jobs[0] = true;
+		job_task task(this, 0, INFINITE, 0);
+		if (!_threads[0].assign_job(task))
+		{
+			_table._error = "can not start fetching thread";
+			return false;
+		}
+
+		for (size_t consume = 0;; consume ^= 1)
+		{
+			memdb_populate_buffer& buffer = _buffers[consume];
+
+			// waits for the copied batch
+			mutexKeeper guard(_mtx);
+			while (!buffer._ready && !_finished)
+			{
+				guard.unlock();
+				_ready.wait();
+				guard.lock();
+			}
+
+			if (!buffer._ready)
+				break;
+
+			guard.unlock();
+
+			// index threads must not see column store growing
+			wait_indexes();
+
+			memdb_rowset_citerator_t first = _table._rowset.end();
+			for (size_t row = 0; row < buffer._count; ++row)
+			{
+				if (!_table.link_row(buffer._rows[row], buffer._values + row * _table._cols.size(), _table._rowset.end()))
+				{
+					stop();
+					return false;
+				}
+
+				if (!row)
+					first = --_table._rowset.end();
+			}
+
+			// gives the buffer back to the fetcher
+			size_t count = buffer._count;
+			guard.lock();
+			buffer._count = 0;
+			buffer._ready = false;
+			guard.unlock();
+			_free.set();
+
+			start_indexes(first, count);
+		}
+
+		wait_indexes();
+
+		if (_failed)
+		{
+			_table._error = _error;
+			return false;
+		}
+
+		return true;
+	}
+
+	//! \brief checks job
+	virtual
+	bool
+	v_has_job(size_t ident, void* user_data)
+	{
+		mutexKeeper guard(_mtx);
+		return _jobs[ident];
+	}
+	//! \brief does job
+	virtual
+	void
+	v_do_job(size_t ident, void* user_data)
+	{
+		if (!ident)
+		{
+			fetch();
+
+			mutexKeeper guard(_mtx);
+			_jobs[0] = false;
+			_finished = true;
+			guard.unlock();
+			_ready.set();
+			return;
+		}
+
+		// inserts the linked batch to the index
+		memindex* obj = _indexes[ident - 1];
+		memdb_rowset_citerator_t iter = _first;
+		for (size_t row = 0; row < _batch_count; ++row, ++iter)
+			obj->notify(iter, true);
+
+		mutexKeeper guard(_mtx);
+		_jobs[ident] = false;
+		if (!--_index_pending)
+			_indexed.set();
+	}
+
+private:
+	//! \brief allocates buffers and starts threads
+	bool
+	init()
+	{
+		size_t col_count = _table._cols.size();
+		for (size_t index = 0; index < 2; ++index)
+		{
+			_buffers[index]._rows = new memdb_row[memdb_populate_batch];
+			if (!_buffers[index]._rows)
+				return false;
+
+			if (_table._columnar)
+			{
+				_buffers[index]._values = new terimber_db_value[memdb_populate_batch * col_count];
+				if (!_buffers[index]._values)
+					return false;
+			}
+		}
+
+		mutexKeeper guard(_table._mtx);
+		_index_count = _table._indexes.size();
+		_indexes = new memindex*[_index_count + 1];
+		if (!_indexes)
+			return false;
+
+		size_t index = 0;
+		for (memtable::list_indexes_t::iterator iiter = _table._indexes.begin(); iiter != _table._indexes.end(); ++iiter)
+			_indexes[index++] = *iiter;
+
+		guard.unlock();
+
+		_jobs = new bool[_index_count + 1];
+		_threads = new thread[_index_count + 1];
+		if (!_jobs || !_threads)
+			return false;
+
+		memset(_jobs, 0, sizeof(bool) * (_index_count + 1));
+		for (index = 0; index <= _index_count; ++index)
+			_threads[index].start();
+
+		return true;
+	}
+
+	//! \brief copies batches from dbserver and fetches the next ones
+	void
+	fetch()
+	{
+		for (size_t fill = 0;; fill ^= 1)
+		{
+			memdb_populate_buffer& buffer = _buffers[fill];
+
+			// waits for the linked batch
+			mutexKeeper guard(_mtx);
+			while (buffer._ready && !_stop)
+			{
+				guard.unlock();
+				_free.wait();
+				guard.lock();
+			}
+
+			if (_stop)
+				return;
+
+			guard.unlock();
+
+			// dbserver keeps the values until the next fetch
+			size_t col_count = _table._cols.size();
+			while (buffer._count < memdb_populate_batch && _server->next())
+			{
+				if (!_table.copy_row(_server, status_original, buffer._rows[buffer._count] = memdb_row(), buffer._values + buffer._count * col_count))
+				{
+					fail(_table._error);
+					return;
+				}
+
+				++buffer._count;
+			}
+
+			bool last = _server->get_row_count() < _requested || !_remaining;
+
+			guard.lock();
+			buffer._ready = buffer._count != 0;
+			guard.unlock();
+			_ready.set();
+
+			if (last)
+				return;
+
+			// fetches the next batch while the copied one is being linked
+			_requested = __min(_remaining, memdb_populate_batch);
+			_remaining -= _requested;
+			if (!_server->fetch_data(false, 0, _requested, true))
+			{
+				fail(_server->get_error());
+				return;
+			}
+		}
+	}
+
+	//! \brief keeps the first error
+	void
+	fail(const char* error)
+	{
+		mutexKeeper guard(_mtx);
+		if (!_failed)
+		{
+			_failed = true;
+			_error = error;
+		}
+	}
+
+	//! \brief stops fetcher after linking error
+	void
+	stop()
+	{
+		mutexKeeper guard(_mtx);
+		_stop = true;
+		guard.unlock();
+		_free.set();
+
+		// waits for fetcher
+		for (;;)
+		{
+			guard.lock();
+			if (_finished)
+				break;
+			guard.unlock();
+			_ready.wait();
+		}
+
+		guard.unlock();
+		wait_indexes();
+	}
+
+	//! \brief assigns the linked batch to index threads
+	void
+	start_indexes(memdb_rowset_citerator_t first, size_t count)
+	{
+		if (!_index_count || !count)
+			return;
+
+		mutexKeeper guard(_mtx);
+		_first = first;
+		_batch_count = count;
+		for (size_t index = 1; index <= _index_count; ++index)
+			_jobs[index] = true;
+		_index_pending = _index_count;
+		guard.unlock();
+
+		for (size_t index = 1; index <= _index_count; ++index)
+		{
+			job_task task(this, index, INFINITE, 0);
+			if (!_threads[index].assign_job(task))
+				v_do_job(index, 0);
+		}
+	}
+
+	//! \brief waits for index threads
+	void
+	wait_indexes()
+	{
+		for (;;)
+		{
+			mutexKeeper guard(_mtx);
+			if (!_index_pending)
+				break;
+			guard.unlock();
+			_indexed.wait();
+		}
+	}
+
+private:
+	memtable&			_table;								//!< table
+	dbserver*			_server;							//!< dbserver
+	size_t				_remaining;							//!< rows to fetch
+	size_t				_requested;							//!< rows requested by the last fetch
+	memdb_populate_buffer _buffers[2];						//!< double buffer
+	thread*				_threads;							//!< fetcher and index threads
+	memindex**			_indexes;							//!< indexes
+	bool*				_jobs;								//!< job flags
+	size_t				_index_count;						//!< number of indexes
+	size_t				_index_pending;						//!< index jobs in progress
+	memdb_rowset_citerator_t _first;						//!< the first row of the linked batch
+	size_t				_batch_count;						//!< rows in the linked batch
+	bool				_finished;							//!< fetcher finished
+	bool				_stop;								//!< stop request to fetcher
+	bool				_failed;							//!< error occurred
+	string_t			_error;								//!< error
+	mutex				_mtx;								//!< mutex
+	event				_ready;								//!< batch is copied
+	event				_free;								//!< batch is linked
+	event				_indexed;							//!< indexes have inserted batch
+};
+
+// 
+// creates an internal table structure from @server object
+// db_server has to be after executing query or stored procedure
+// and ready to fetch data
+// memtable automatically detects the list of columns in recordset
+// and creates table in memory with the same columns' order and types.
+// @max_rows sets a restriction on max rows to be retrived, -1 - all of them
+// @start_row means absolute number of row to start with
+// unless you specify 0, then the memtable starts with the current row
+
+bool
+memtable::populate(dbserver* server, size_t start_row, size_t max_rows)
+{
+	// fetches here the first batch of rows
+	size_t requested = __min(max_rows, memdb_populate_batch);
+	if (!server->fetch_data(false, start_row, requested, true))
+	{
+		_error = server->get_error();
+		return false;
+	}
+
+	// keeps indexes on the same columns, they are built again while rows are coming
+	if (!_indexes.empty() && same_columns(server))
+	{
+		mutexKeeper guard(_mtx);
+		for (list_indexes_t::iterator iiter = _indexes.begin(); iiter != _indexes.end(); ++iiter)
+			(*iiter)->clear();
+
+		guard.unlock();
+		clear_rows();
+	}
+	else
+		uninit();
+
+	// extracts columns here
+	size_t col_count = server->get_column_count();
+	if (!col_count)
+	{
+		_error = "no columns found";
+		return false;
+	}
+
+	binder dummy;
+	_cols.resize(_allocator, col_count, dummy);
+	if (_cols.size() != col_count)
+		return false;
+
+	for (size_t icol = 0; icol < col_count; ++icol)
+	{
+		_cols[icol]._type = server->get_column_type(icol);
+		_cols[icol]._max_length = server->get_column_max_length(icol);
+		_cols[icol]._value.nullVal = server->get_column_nullable(icol);
+		_cols[icol]._precision = server->get_column_precision(icol);
+		_cols[icol]._scale = server->get_column_scale(icol);
+		_cols[icol].set_name(&_allocator, server->get_column_name(icol));
+	}
+
+	if (!init_columns())
+		return false;
+
+	// the whole recordset fits the first batch
+	if (server->get_row_count() < requested || requested == max_rows)
+	{
+		while (server->next())
+		{
+			if (!add_row(server, status_original))
+				return false;
+		} // while
+
+		if (!rank_dictionaries())
+			return false;
+
+		// builds kept indexes at once
+		mutexKeeper guard(_mtx);
+		for (list_indexes_t::iterator iiter = _indexes.begin(); iiter != _indexes.end(); ++iiter)
+			if (!(*iiter)->construct())
+			{
+				_error = "no enough memory";
+				return false;
+			}
+
+		return true;
+	}
+
+	memdb_populator populator(*this, server, max_rows - requested);
+	return populator.run() && rank_dictionaries();
+}
+
+bool 
+memtable::create(size_t columns, const terimber_table_column_desc desc[])
+{
+	uninit();
+	
+	binder dummy;
+	_cols.resize(_allocator, columns, dummy);
+	if (_cols.size() != columns)
+		return false;
+
+	for (size_t icol = 0; icol < columns; ++icol)
+	{
+		_cols[icol]._type = desc[icol]._type;
+		_cols[icol]._max_length = desc[icol]._max_length;
+		_cols[icol]._value.nullVal = desc[icol]._nullable;
+		_cols[icol]._precision = desc[icol]._precision;
+		_cols[icol]._scale = desc[icol]._scale;
+		_cols[icol].set_name(&_allocator, desc[icol]._name);
+	}
+
+	return init_columns();
+}
+
+// resets all new, updates rows status to original, removes deleted rows
+// updates all indexes
+void 
+memtable::refresh()
+{
+	// updates status
+	for (memdb_rowset_t::iterator it = _rowset.begin(); it != _rowset.end(); ++it)
+	{
+		_columns.set_status(*it, status_original);
+	}
+}
+
+//
+// applies changed rows, rows are found by hash index on key columns
+//
+bool
+memtable::populate_delta(dbserver* server, size_t key_count, const size_t keys[], size_t deleted_column)
+{
+	memindex* index = find_key_index(key_count, keys);
+	if (!index)
+		return false;
+
+	// key row is compared with table rows as lookup conditions are
+	const memdb_rowset_less& pred = index->get_index().comp();
+	const memdb_hash_index& hash = index->get_hash();
+	byte_allocator key_allocator;
+	memdb_rowset_t key_rowset;
+	memdb_row key_row;
+	key_rowset.push_back(key_row);
+	memdb_rowset_iterator_t key_iter = key_rowset.begin();
+	key_iter->_row.resize(key_allocator, key_count);
+	memdb_key_source key_source(server, keys);
+
+	size_t col_count = _cols.size();
+	bool checked = false, last = false;
+	while (!last)
+	{
+		if (!server->fetch_data(false, 0, memdb_populate_batch, true))
+		{
+			_error = server->get_error();
+			return false;
+		}
+
+		// recordset columns are known after fetching
+		size_t server_count = server->get_column_count();
+		if (!checked
+			&& (server_count < col_count
+				|| server_count > col_count + 1
+				|| (server_count > col_count && deleted_column != col_count)
+				|| (deleted_column != os_minus_one && deleted_column >= server_count)))
+		{
+			_error = "recordset columns do not match table columns";
+			return false;
+		}
+
+		for (size_t icol = 0; !checked && icol < col_count; ++icol)
+			if (_cols[icol]._type != server->get_column_type(icol))
+			{
+				_error = "recordset columns do not match table columns";
+				return false;
+			}
+
+		checked = true;
+		last = server->get_row_count() < memdb_populate_batch;
+		bool flag_bool = deleted_column != os_minus_one && server->get_column_type(deleted_column) == db_bool;
+
+		while (server->next())
+		{
+			key_allocator.reset();
+			if (!copy_db_row(&key_source, key_iter->_row.begin(), pred.get_info(), key_count, key_allocator, _error))
+				return false;
+
+			// the latest version of row with the same key
+			mutexKeeper guard(_mtx);
+			size_t key_hash = pred.hash(key_iter);
+			memdb_rownode_t* found = 0;
+			for (size_t slot = hash.find(key_iter, key_hash, os_minus_one); !found && slot != os_minus_one; slot = hash.find(key_iter, key_hash, slot))
+				if (hash.get_node(slot)->_value._end == memdb_epoch_infinite)
+					found = hash.get_node(slot);
+
+			guard.unlock();
+
+			bool deleted = deleted_column != os_minus_one
+				&& !server->get_value_is_null(deleted_column)
+				&& (flag_bool ? server->get_value_as_bool(deleted_column) : server->get_value_as_long(deleted_column) != 0);
+
+			bool res = true;
+			if (deleted)
+				res = !found || delete_row(memdb_rowset_citerator_t(found));
+			else if (found)
+				res = update_source(memdb_rowset_citerator_t(found), server);
+			else
+				res = insert_source(server);
+
+			if (!res)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+//
+// after populating and any time after that you can request the number of rows in the table
+//
+size_t 
+memtable::get_row_count()
+{
+	// replaced versions are not counted
+	return _rowset.size() - _unlinked;
+}
+
+//
+// column's description is pretty much the same as db_server provides
+//
+
+//
+// gets column count
+//
+size_t 
+memtable::get_column_count() const
+{
+	return _cols.size();
+}
+
+//
+// returns the virtual terimber dbtype like db_bool, ...
+//
+dbtypes
+memtable::get_column_type(size_t index) const
+{
+	return index >= _cols.size() ? db_unknown : _cols[index]._type;
+}
+
+//
+// returns the name of the column
+//
+const char*
+memtable::get_column_name(size_t index) const
+{
+	return index >= _cols.size() ? 0 : _cols[index]._name;
+}
+
+//
+// returns the nullable - database specific
+//
+bool 
+memtable::get_column_nullable(size_t index) const
+{
+	return index >= _cols.size() ? false : _cols[index]._value.nullVal;
+}
+
+//
+// returns the scale
+//
+size_t 
+memtable::get_column_scale(size_t index) const
+{
+	return index >= _cols.size() ? 0 : _cols[index]._scale;
+}
+//
+// returns the precision
+//
+size_t 
+memtable::get_column_precision(size_t index) const
+{
+	return index >= _cols.size() ? 0 : _cols[index]._precision;
+}
+
+//
+// returns the length of the column (only for fixed length columns)
+//
+size_t 
+memtable::get_column_max_length(size_t index) const
+{
+	return index >= _cols.size() ? 0 : _cols[index]._max_length;
+}
+
+//
+// index management
+// there are no connections between the indexes in the memory and the indexes in the database
+//
+
+//
+// creates an index to perform the quick search
+// @columns the size of index, can be 0 for empty index
+// @info - array of index column descriptions
+// @kind - ordered or hash index
+// returns the new created memindex object
+// user mustn't to use object after returning it back
+// or after memtable will be destoyed
+// this is an expensive operation in order to consume memory and CPU time
+//
+terimber_memindex* 
+memtable::add_index(size_t columns, const terimber_index_column_info info[], terimber_index_kind kind)
+{
+	return create_index(columns, info, kind, 0, 0);
+}
+
+memindex*
+memtable::create_index(size_t columns, const terimber_index_column_info info[], terimber_index_kind kind, memdb_rownode_t* const* sorted, size_t count)
+{
+	terimber_index_column_array_t vec_info;
+	vec_info.resize(columns);
+
+	// checks column's count
+	if (columns > _cols.size())
+	{
+		_error = "info size exceeds the number of available columns";
+		return 0;
+	}
+
+	for (size_t icol = 0; icol < columns; ++icol)
+	{
+		vec_info[icol]._asc_sort = info[icol]._asc_sort;
+		vec_info[icol]._case_insensitive = info[icol]._case_insensitive;
+		vec_info[icol]._index = info[icol]._index;
+
+		if (vec_info[icol]._index >= _cols.size())
+		{
+			char buf[128];
+			str_template::strprint(buf, 128, "specified index %d is out of range", vec_info[icol]._index);
+			_error = buf;
+			return 0;
+		}
+
+		vec_info[icol]._type = _cols[vec_info[icol]._index]._type;
+		vec_info[icol]._dictionary = get_dictionary(vec_info[icol]._index) != 0;
+	}
+
+	// values added after the last sorting get ranks, so index compares them by codes
+	if (!rank_dictionaries())
+		return 0;
+
+	memdb_rowset_less pred(vec_info, &_columns);
+
+	memindex* obj = new memindex(*this, pred, columns && kind == index_hash);
+	if (obj)
+	{
+		// constructs index
+		if (!(sorted ? obj->construct(sorted, count) : obj->construct()))
+		{
+			delete obj;
+			return 0;
+		}
+
+		// adds to the list of indexes
+		mutexKeeper guard(_mtx);
+		_indexes.push_back(obj);
+	}
+
+	obj->log_on(this);
+
+	return obj;
+}
+
+
+//
+// destroys index
+// memtable data is still valid
+// all memlookups on the current index will be destroyed! 
+//
+bool 
+memtable::remove_index(terimber_memindex* obj)
+{
+	mutexKeeper guard(_mtx);
+	for (list_indexes_t::iterator iter = _indexes.begin(); iter != _indexes.end(); ++iter)
+		if (*iter == obj)
+		{
+			(*iter)->log_on(0);
+			delete *iter;
+			_indexes.erase(iter);
+			return true;
+		}
+
+	return false;
+}
+
+terimber_db_value_vector*
+memtable::allocate_db_values(size_t count)
+{
+	// adds to the list of values
+	terimber_db_value_vector_impl* obj = new terimber_db_value_vector_impl(count);
+	if (obj)
+	{
+		mutexKeeper guard(_mtx);
+		_values.push_back(obj);
+	}
+
+	return obj;
+}
+
+void
+memtable::destroy_db_values(terimber_db_value_vector* obj)
+{
+	mutexKeeper guard(_mtx);
+	for (list_values_t::iterator iter = _values.begin(); iter != _values.end(); ++iter)
+		if (*iter == obj)
+		{
+			delete *iter;
+			_values.erase(iter);
+			return;
+		}
+}
+
+//! \brief snapshot file signature "MDBS"
+const ub4_t memdb_snapshot_magic = 0x5342444d;
+//! \brief snapshot format version
+const ub4_t memdb_snapshot_version = 2;
+//! \brief alignment of snapshot sections
+const size_t memdb_snapshot_align = 64;
+//! \brief alignment of heap values
+const size_t memdb_snapshot_heap_align = 8;
+//! \brief rows in one chunk of column array being written
+const size_t memdb_snapshot_chunk = 4096;
+
+//! \class memdb_snapshot_header
+//! \brief snapshot file header, all offsets are from the beginning of file
+class memdb_snapshot_header
+{
+public:
+	ub4_t				_magic;								//!< signature
+	ub4_t				_version;							//!< format version
+	ub4_t				_pointer_size;						//!< pointer size of the writer
+	ub4_t				_column_count;						//!< number of columns
+	ub8_t				_row_count;							//!< number of rows
+	ub8_t				_index_count;						//!< number of indexes
+	ub8_t				_columns;							//!< offset of column descriptors
+	ub8_t				_indexes;							//!< offset of index descriptors
+	ub8_t				_statuses;							//!< offset of row status array
+	ub8_t				_heap;								//!< offset of value heap
+	ub8_t				_heap_size;							//!< size of value heap
+	ub8_t				_file_size;							//!< size of file
+};
+
+//! \class memdb_snapshot_column
+//! \brief column descriptor
+//! strings, binaries and guids keep heap offsets shifted left with the lowest bit set
+//! dictionary columns point to the values of their entries, numerics are kept in the typed array
+class memdb_snapshot_column
+{
+public:
+	ub4_t				_type;								//!< column type
+	ub4_t				_nullable;							//!< nullable flag
+	ub4_t				_precision;							//!< precision
+	ub4_t				_scale;								//!< scale
+	ub8_t				_max_length;						//!< max length
+	ub8_t				_name;								//!< heap offset of column name
+	ub8_t				_data;								//!< offset of typed array
+	ub8_t				_nulls;								//!< offset of null bitmap
+	ub8_t				_dictionary;						//!< heap offset of dictionary entries, 0 - column is not encoded
+	ub8_t				_entries;							//!< number of dictionary entries
+};
+
+//! \class memdb_snapshot_index
+//! \brief index descriptor
+class memdb_snapshot_index
+{
+public:
+	ub4_t				_column_count;						//!< number of index columns
+	ub4_t				_hash;								//!< hash index
+	ub8_t				_columns;							//!< offset of index columns
+	ub8_t				_row_count;							//!< number of rows in index, deleted rows are not there
+	ub8_t				_order;								//!< offset of row positions in index order, 0 for hash index
+};
+
+//! \class memdb_snapshot_index_column
+//! \brief index column descriptor
+class memdb_snapshot_index_column
+{
+public:
+	ub4_t				_index;								//!< table column
+	ub4_t				_asc_sort;							//!< ascending order
+	ub4_t				_case_insensitive;					//!< case insensitive
+};
+
+//! \class memdb_snapshot_rowpos
+//! \brief maps row node to the row position in snapshot
+class memdb_snapshot_rowpos
+{
+public:
+	//! \brief operator<
+	inline
+	bool
+	operator<(const memdb_snapshot_rowpos& x) const
+	{
+		return _node < x._node;
+	}
+
+	memdb_rownode_t*	_node;								//!< row node
+	ub4_t				_pos;								//!< row position
+	ub1_t				_status;							//!< row status
+};
+
+//! \class memdb_snapshot_entry
+//! \brief maps dictionary entry to its heap offset in snapshot
+class memdb_snapshot_entry
+{
+public:
+	//! \brief operator<
+	inline
+	bool
+	operator<(const memdb_snapshot_entry& x) const
+	{
+		return _entry < x._entry;
+	}
+
+	const memdb_dictionary_entry* _entry;					//!< dictionary entry
+	size_t				_offset;							//!< heap offset of entry value
+};
+
+//! \brief collects the latest row versions in table order
+//! versions replaced for the older scans are skipped, deleted rows waiting for them are saved as deleted
+//! returns the number of rows
+static
+size_t
+memdb_snapshot_rows(const memdb_rowset_t& rowset, const memdb_columns& columns, memdb_rownode_t* const* deleted, size_t deleted_count, memdb_snapshot_rowpos* rows)
+{
+	size_t irow = 0;
+	for (memdb_rowset_citerator_t iter = rowset.begin(); iter != rowset.end(); ++iter)
+	{
+		terimber_db_row_status status = columns.get_status(*iter);
+		if (iter->_end != memdb_epoch_infinite && status != status_deleted)
+		{
+			if (!std::binary_search(deleted, deleted + deleted_count, iter.node()))
+				continue;
+
+			status = status_deleted;
+		}
+
+		rows[irow]._node = iter.node();
+		rows[irow]._pos = (ub4_t)irow;
+		rows[irow]._status = (ub1_t)status;
+		++irow;
+	}
+
+	return irow;
+}
+
+//! \brief aligns offset
+static
+inline
+size_t
+memdb_snapshot_round(size_t offset, size_t align)
+{
+	return (offset + align - 1) / align * align;
+}
+
+//! \brief checks that array is inside the file
+static
+inline
+bool
+memdb_snapshot_fits(ub8_t offset, ub8_t length, size_t size)
+{
+	return offset <= size && length <= size - offset;
+}
+
+//! \brief checks that dictionary value ends with terminator
+static
+inline
+bool
+memdb_snapshot_terminated(dbtypes type, const void* value, ub8_t length)
+{
+	return type == db_string ?
+		length && !((const char*)value)[length - 1] :
+		length >= sizeof(wchar_t) && !(length % sizeof(wchar_t)) && !((const wchar_t*)value)[length / sizeof(wchar_t) - 1];
+}
+
+//! \brief returns the size of string, binary or guid value
+static
+size_t
+memdb_heap_value_size(dbtypes type, const ub1_t* ptr)
+{
+	switch (type)
+	{
+		case db_string:
+			return strlen((const char*)ptr) + 1;
+		case db_wstring:
+			return (wcslen((const wchar_t*)ptr) + 1) * sizeof(wchar_t);
+		case db_binary:
+			return *(const size_t*)ptr + sizeof(size_t);
+		case db_guid:
+			return sizeof(guid_t);
+		default:
+			return 0;
+	}
+}
+
+//! \class memdb_snapshot_file
+//! \brief sequential writer of snapshot file
+class memdb_snapshot_file
+{
+public:
+	//! \brief constructor
+	memdb_snapshot_file() :
+		_desc(0),
+		_pos(0)
+	{
+	}
+	//! \brief destructor
+	~memdb_snapshot_file()
+	{
+		if (_desc)
+			::fclose(_desc);
+	}
+	//! \brief opens file
+	bool
+	open(const char* file_name)
+	{
+		return 0 != (_desc = ::fopen(file_name, "wb"));
+	}
+	//! \brief closes file, returns false if data has not been flushed
+	bool
+	close()
+	{
+		FILE* desc = _desc;
+		_desc = 0;
+		return !::fclose(desc);
+	}
+	//! \brief writes bytes
+	bool
+	write(const void* buf, size_t len)
+	{
+		_pos += len;
+		return !len || 1 == ::fwrite(buf, len, 1, _desc);
+	}
+	//! \brief writes zeros up to offset
+	bool
+	pad(size_t offset)
+	{
+		static const ub1_t zeros[memdb_snapshot_align] = {0};
+		while (_pos < offset)
+			if (!write(zeros, __min(offset - _pos, memdb_snapshot_align)))
+				return false;
+
+		return true;
+	}
+	//! \brief writes from the beginning of file
+	bool
+	rewind()
+	{
+		_pos = 0;
+		return !::fseek(_desc, 0, SEEK_SET);
+	}
+	//! \brief returns the current offset
+	inline
+	size_t
+	pos() const
+	{
+		return _pos;
+	}
+
+private:
+	FILE*				_desc;								//!< file descriptor
+	size_t				_pos;								//!< current offset
+};
+
+//
+// saves columns, rows and indexes to the snapshot file
+//
+bool
+memtable::save_snapshot(const char* file_name)
+{
+	mutexKeeper guard(_mtx);
+	size_t col_count = _cols.size();
+	size_t index_count = _indexes.size();
+
+	if (_rowset.size() > 0xffffffff)
+	{
+		_error = "too many rows for snapshot";
+		return false;
+	}
+
+	// rows in table order, deleted rows waiting for scans are found by nodes
+	memdb_snapshot_rowpos* rows = new memdb_snapshot_rowpos[_rowset.size() + 1];
+	memdb_rownode_t** deleted = new memdb_rownode_t*[_retired.size() + 1];
+	if (!rows || !deleted)
+	{
+		delete [] rows;
+		delete [] deleted;
+		_error = "no enough memory";
+		return false;
+	}
+
+	size_t deleted_count = 0;
+	for (list_retired_t::const_iterator riter = _retired.begin(); riter != _retired.end(); ++riter)
+		if (!riter->_unlink)
+			deleted[deleted_count++] = riter->_row;
+
+	std::sort(deleted, deleted + deleted_count);
+	size_t row_count = memdb_snapshot_rows(_rowset, _columns, deleted, deleted_count, rows);
+
+	// lays out the file
+	memdb_snapshot_header header;
+	memset(&header, 0, sizeof(header));
+	header._magic = memdb_snapshot_magic;
+	header._version = memdb_snapshot_version;
+	header._pointer_size = sizeof(void*);
+	header._column_count = (ub4_t)col_count;
+	header._row_count = row_count;
+	header._index_count = index_count;
+
+	size_t offset = memdb_snapshot_round(sizeof(header), memdb_snapshot_align);
+	header._columns = offset;
+	offset += col_count * sizeof(memdb_snapshot_column);
+	header._indexes = offset;
+	offset += index_count * sizeof(memdb_snapshot_index);
+
+	_vector< memdb_snapshot_index > index_desc;
+	byte_allocator all;
+	if (!index_desc.resize(all, index_count))
+	{
+		delete [] rows;
+		delete [] deleted;
+		_error = "no enough memory";
+		return false;
+	}
+
+	size_t iindex = 0;
+	for (list_indexes_t::const_iterator iiter = _indexes.begin(); iiter != _indexes.end(); ++iiter, ++iindex)
+	{
+		index_desc[iindex]._column_count = (ub4_t)(*iiter)->get_index().comp().get_info().size();
+		index_desc[iindex]._hash = (*iiter)->is_hashed();
+		index_desc[iindex]._columns = offset;
+		index_desc[iindex]._row_count = 0;
+		if (!(*iiter)->is_hashed())
+		{
+			// the latest versions only
+			const memdb_index_t& index = (*iiter)->get_index();
+			for (memdb_index_citer_t iter = index.begin(); iter != index.end(); ++iter)
+				if (iter.key()->_end == memdb_epoch_infinite)
+					++index_desc[iindex]._row_count;
+		}
+		offset += index_desc[iindex]._column_count * sizeof(memdb_snapshot_index_column);
+	}
+
+	offset = memdb_snapshot_round(offset, memdb_snapshot_align);
+	header._statuses = offset;
+	offset += row_count;
+
+	_vector< memdb_snapshot_column > col_desc;
+	if (!col_desc.resize(all, col_count))
+	{
+		delete [] rows;
+		delete [] deleted;
+		_error = "no enough memory";
+		return false;
+	}
+
+	size_t nulls_size = ((row_count + 31) >> 5) * sizeof(ub4_t);
+	for (size_t icol = 0; icol < col_count; ++icol)
+	{
+		const binder& col = _cols[icol];
+		col_desc[icol]._type = col._type;
+		col_desc[icol]._nullable = col._value.nullVal;
+		col_desc[icol]._precision = (ub4_t)col._precision;
+		col_desc[icol]._scale = (ub4_t)col._scale;
+		col_desc[icol]._max_length = col._max_length;
+
+		offset = memdb_snapshot_round(offset, memdb_snapshot_align);
+		col_desc[icol]._data = offset;
+		offset += row_count * memdb_type_width(col._type);
+		offset = memdb_snapshot_round(offset, memdb_snapshot_align);
+		col_desc[icol]._nulls = offset;
+		offset += nulls_size;
+	}
+
+	for (iindex = 0; iindex < index_count; ++iindex)
+	{
+		if (index_desc[iindex]._hash)
+			continue;
+
+		offset = memdb_snapshot_round(offset, memdb_snapshot_align);
+		index_desc[iindex]._order = offset;
+		offset += (size_t)index_desc[iindex]._row_count * sizeof(ub4_t);
+	}
+
+	header._heap = memdb_snapshot_round(offset, memdb_snapshot_align);
+
+	// column names go first to the heap
+	size_t heap_pos = 0;
+	for (size_t icol = 0; icol < col_count; ++icol)
+	{
+		col_desc[icol]._name = heap_pos;
+		heap_pos += memdb_snapshot_round(strlen(_cols[icol]._name) + 1, memdb_snapshot_heap_align);
+	}
+
+	// dictionaries follow, row values refer to their entries
+	size_t entry_count = 0;
+	for (size_t icol = 0; icol < col_count; ++icol)
+		if (get_dictionary(icol))
+			entry_count += get_dictionary(icol)->size();
+
+	memdb_snapshot_entry* entries = new memdb_snapshot_entry[entry_count + 1];
+	ub1_t* chunk = new ub1_t[memdb_snapshot_chunk * __max(sizeof(memdb_decimal), sizeof(ub8_t))];
+	if (!entries || !chunk)
+	{
+		delete [] rows;
+		delete [] deleted;
+		delete [] entries;
+		delete [] chunk;
+		_error = "no enough memory";
+		return false;
+	}
+
+	entry_count = 0;
+	for (size_t icol = 0; icol < col_count; ++icol)
+	{
+		const memdb_dictionary* dictionary = get_dictionary(icol);
+		if (!dictionary)
+			continue;
+
+		col_desc[icol]._dictionary = heap_pos;
+		col_desc[icol]._entries = dictionary->size();
+		for (size_t slot = 0; slot < dictionary->get_capacity(); ++slot)
+		{
+			const memdb_dictionary_entry* entry = dictionary->get_slot(slot);
+			if (!entry)
+				continue;
+
+			entries[entry_count]._entry = entry;
+			entries[entry_count]._offset = heap_pos + sizeof(memdb_dictionary_entry);
+			++entry_count;
+			heap_pos += memdb_snapshot_round(sizeof(memdb_dictionary_entry) + entry->_length, memdb_snapshot_heap_align);
+		}
+	}
+
+	std::sort(entries, entries + entry_count);
+
+	size_t irow = 0;
+	memdb_snapshot_file file;
+	bool res = file.open(file_name)
+		&& file.write(&header, sizeof(header))
+		&& file.pad(header._columns)
+		&& file.write(col_desc.begin(), col_count * sizeof(memdb_snapshot_column))
+		&& file.write(index_desc.begin(), index_count * sizeof(memdb_snapshot_index));
+
+	// index columns
+	for (list_indexes_t::const_iterator iiter = _indexes.begin(); res && iiter != _indexes.end(); ++iiter)
+	{
+		const terimber_index_column_array_t& info = (*iiter)->get_index().comp().get_info();
+		for (size_t icol = 0; res && icol < info.size(); ++icol)
+		{
+			memdb_snapshot_index_column desc;
+			desc._index = (ub4_t)info[icol]._index;
+			desc._asc_sort = info[icol]._asc_sort;
+			desc._case_insensitive = info[icol]._case_insensitive;
+			res = file.write(&desc, sizeof(desc));
+		}
+	}
+
+	// statuses
+	res = res && file.pad(header._statuses);
+	for (irow = 0; res && irow < row_count; irow += memdb_snapshot_chunk)
+	{
+		size_t count = __min(row_count - irow, memdb_snapshot_chunk);
+		for (size_t index = 0; index < count; ++index)
+			chunk[index] = rows[irow + index]._status;
+
+		res = file.write(chunk, count);
+	}
+
+	// columns
+	for (size_t icol = 0; res && icol < col_count; ++icol)
+	{
+		dbtypes type = _cols[icol]._type;
+		size_t width = memdb_type_width(type);
+		bool dictionary = get_dictionary(icol) != 0;
+
+		res = file.pad(col_desc[icol]._data);
+		for (irow = 0; res && irow < row_count; irow += memdb_snapshot_chunk)
+		{
+			size_t count = __min(row_count - irow, memdb_snapshot_chunk);
+			memset(chunk, 0, count * width);
+			for (size_t index = 0; index < count; ++index)
+			{
+				terimber_db_value value = _columns.get_value(rows[irow + index]._node->_value, icol);
+				if (value.nullVal)
+					continue;
+
+				ub1_t* ptr = chunk + index * width;
+				switch (type)
+				{
+					case db_bool:
+						*ptr = value.val.boolVal ? 1 : 0;
+						break;
+					case db_sb1:
+					case db_ub1:
+						*ptr = value.val.bVal;
+						break;
+					case db_sb2:
+					case db_ub2:
+						*(ub2_t*)ptr = value.val.uiVal;
+						break;
+					case db_sb4:
+					case db_ub4:
+						*(ub4_t*)ptr = value.val.ulVal;
+						break;
+					case db_float:
+						*(float*)ptr = value.val.fltVal;
+						break;
+#ifdef OS_64BIT
+					case db_double:
+						*(double*)ptr = value.val.dblVal;
+						break;
+					case db_sb8:
+					case db_ub8:
+					case db_date:
+						*(sb8_t*)ptr = value.val.intVal;
+						break;
+#else
+					case db_double:
+						*(double*)ptr = *value.val.dblVal;
+						break;
+					case db_sb8:
+					case db_ub8:
+					case db_date:
+						*(sb8_t*)ptr = *value.val.intVal;
+						break;
+#endif
+					case db_decimal:
+					case db_numeric:
+						memcpy(ptr, value.val.bufVal, sizeof(memdb_decimal));
+						break;
+					default:
+						if (dictionary)
+						{
+							// tagged heap offset of entry value
+							memdb_snapshot_entry key;
+							key._entry = memdb_dictionary_entry::get(value.val.bufVal);
+							*(size_t*)ptr = (std::lower_bound(entries, entries + entry_count, key)->_offset << 1) | 1;
+							break;
+						}
+
+						// tagged heap offset
+						*(size_t*)ptr = (heap_pos << 1) | 1;
+						heap_pos += memdb_snapshot_round(memdb_heap_value_size(type, value.val.bufVal), memdb_snapshot_heap_align);
+						break;
+				}
+			}
+
+			res = file.write(chunk, count * width);
+		}
+
+		// null bitmap
+		res = res && file.pad(col_desc[icol]._nulls);
+		for (irow = 0; res && irow < row_count; irow += memdb_snapshot_chunk)
+		{
+			size_t count = __min(row_count - irow, memdb_snapshot_chunk);
+			ub4_t* nulls = (ub4_t*)chunk;
+			memset(nulls, 0, ((count + 31) >> 5) * sizeof(ub4_t));
+			for (size_t index = 0; index < count; ++index)
+				if (_columns.is_null(rows[irow + index]._node->_value, icol))
+					nulls[index >> 5] |= 1 << (index & 31);
+
+			res = file.write(nulls, ((count + 31) >> 5) * sizeof(ub4_t));
+		}
+	}
+
+	// index orders, positions are found by row nodes
+	if (res && index_count)
+		std::sort(rows, rows + row_count);
+
+	iindex = 0;
+	for (list_indexes_t::const_iterator oiter = _indexes.begin(); res && oiter != _indexes.end(); ++oiter, ++iindex)
+	{
+		if (index_desc[iindex]._hash)
+			continue;
+
+		res = file.pad(index_desc[iindex]._order);
+		ub4_t* order = (ub4_t*)chunk;
+		size_t count = 0;
+		const memdb_index_t& index = (*oiter)->get_index();
+		for (memdb_index_citer_t iter = index.begin(); res && iter != index.end(); ++iter)
+		{
+			if (iter.key()->_end != memdb_epoch_infinite)
+				continue;
+
+			memdb_snapshot_rowpos key;
+			key._node = iter.key().node();
+			order[count++] = std::lower_bound(rows, rows + row_count, key)->_pos;
+			if (count == memdb_snapshot_chunk)
+			{
+				res = file.write(order, count * sizeof(ub4_t));
+				count = 0;
+			}
+		}
+
+		res = res && file.write(order, count * sizeof(ub4_t));
+	}
+
+	// heap in the same order as offsets have been assigned
+	res = res && file.pad(header._heap);
+	for (size_t icol = 0; res && icol < col_count; ++icol)
+		res = file.write(_cols[icol]._name, strlen(_cols[icol]._name) + 1)
+			&& file.pad(memdb_snapshot_round(file.pos(), memdb_snapshot_heap_align));
+
+	for (size_t icol = 0; res && icol < col_count; ++icol)
+	{
+		const memdb_dictionary* dictionary = get_dictionary(icol);
+		for (size_t slot = 0; res && dictionary && slot < dictionary->get_capacity(); ++slot)
+		{
+			const memdb_dictionary_entry* entry = dictionary->get_slot(slot);
+			res = !entry
+				|| (file.write(entry, sizeof(memdb_dictionary_entry) + entry->_length)
+					&& file.pad(memdb_snapshot_round(file.pos(), memdb_snapshot_heap_align)));
+		}
+	}
+
+	// rows are in table order again
+	memdb_snapshot_rows(_rowset, _columns, deleted, deleted_count, rows);
+
+	for (size_t icol = 0; res && icol < col_count; ++icol)
+	{
+		dbtypes type = _cols[icol]._type;
+		if (type < db_string || type == db_decimal || type == db_numeric || get_dictionary(icol))
+			continue;
+
+		for (irow = 0; res && irow < row_count; ++irow)
+		{
+			terimber_db_value value = _columns.get_value(rows[irow]._node->_value, icol);
+			if (value.nullVal)
+				continue;
+
+			res = file.write(value.val.bufVal, memdb_heap_value_size(type, value.val.bufVal))
+				&& file.pad(memdb_snapshot_round(file.pos(), memdb_snapshot_heap_align));
+		}
+	}
+
+	header._heap_size = heap_pos;
+	header._file_size = file.pos();
+	res = res && file.pos() == header._heap + heap_pos
+		&& file.rewind()
+		&& file.write(&header, sizeof(header))
+		&& file.close();
+
+	delete [] rows;
+	delete [] deleted;
+	delete [] entries;
+	delete [] chunk;
+
+	if (!res)
+		_error = "can not write snapshot file";
+
+	return res;
+}
+
+//
+// replaces table with snapshot mapped from file
+//
+bool
+memtable::restore_snapshot(const char* file_name)
+{
+	uninit();
+
+	if (!_mapper.memmapfile(file_name, true))
+	{
+		_error = "can not map snapshot file";
+		return false;
+	}
+
+	ub1_t* base = (ub1_t*)_mapper.getaddress();
+	size_t size = _mapper.getfilesize();
+	const memdb_snapshot_header* header = (const memdb_snapshot_header*)base;
+
+	if (size < sizeof(memdb_snapshot_header)
+		|| header->_magic != memdb_snapshot_magic
+		|| header->_version != memdb_snapshot_version
+		|| header->_pointer_size != sizeof(void*)
+		|| header->_file_size != size
+		|| !memdb_snapshot_fits(header->_heap, header->_heap_size, size)
+		|| !memdb_snapshot_fits(header->_statuses, header->_row_count, size)
+		|| !memdb_snapshot_fits(header->_columns, header->_column_count * sizeof(memdb_snapshot_column), size)
+		|| !memdb_snapshot_fits(header->_indexes, header->_index_count * sizeof(memdb_snapshot_index), size))
+	{
+		uninit();
+		_error = "invalid snapshot file";
+		return false;
+	}
+
+	size_t row_count = (size_t)header->_row_count;
+	size_t col_count = header->_column_count;
+	const memdb_snapshot_column* col_desc = (const memdb_snapshot_column*)(base + header->_columns);
+	const ub1_t* heap = base + header->_heap;
+
+	binder dummy;
+	_cols.resize(_allocator, col_count, dummy);
+	if (_cols.size() != col_count)
+	{
+		uninit();
+		_error = "no enough memory";
+		return false;
+	}
+
+	for (size_t icol = 0; icol < col_count; ++icol)
+	{
+		if (col_desc[icol]._name >= header->_heap_size)
+		{
+			uninit();
+			_error = "invalid snapshot file";
+			return false;
+		}
+
+		_cols[icol]._type = (dbtypes)col_desc[icol]._type;
+		_cols[icol]._max_length = (size_t)col_desc[icol]._max_length;
+		_cols[icol]._value.nullVal = col_desc[icol]._nullable != 0;
+		_cols[icol]._precision = col_desc[icol]._precision;
+		_cols[icol]._scale = col_desc[icol]._scale;
+		_cols[icol].set_name(&_allocator, (const char*)heap + col_desc[icol]._name);
+	}
+
+	// dictionary flags come from the snapshot
+	_dictionary_columns.clear();
+	if (!_dictionary_columns.resize(col_count, false))
+	{
+		uninit();
+		_error = "no enough memory";
+		return false;
+	}
+
+	for (size_t icol = 0; icol < col_count; ++icol)
+		_dictionary_columns[icol] = col_desc[icol]._dictionary != 0;
+
+	// column arrays stay in the mapping
+	_columnar = true;
+	if (!init_columns())
+	{
+		uninit();
+		return false;
+	}
+
+	// dictionary entries stay in the mapping as well
+	for (size_t icol = 0; icol < col_count; ++icol)
+	{
+		if (!col_desc[icol]._dictionary)
+			continue;
+
+		memdb_dictionary* dictionary = get_dictionary(icol) ? _dictionaries + icol : 0;
+		ub8_t pos = col_desc[icol]._dictionary;
+		bool valid = dictionary != 0;
+		for (ub8_t ientry = 0; valid && ientry < col_desc[icol]._entries; ++ientry)
+		{
+			memdb_dictionary_entry* entry = (memdb_dictionary_entry*)(base + header->_heap + pos);
+			valid = memdb_snapshot_fits(pos, sizeof(memdb_dictionary_entry), (size_t)header->_heap_size)
+				&& memdb_snapshot_fits(pos + sizeof(memdb_dictionary_entry), entry->_length, (size_t)header->_heap_size)
+				&& memdb_snapshot_terminated(_cols[icol]._type, entry->value(), entry->_length);
+
+			if (!valid)
+				break;
+
+			if (!dictionary->attach(entry))
+			{
+				uninit();
+				_error = "no enough memory";
+				return false;
+			}
+
+			pos += memdb_snapshot_round(sizeof(memdb_dictionary_entry) + entry->_length, memdb_snapshot_heap_align);
+		}
+
+		if (!valid)
+		{
+			uninit();
+			_error = "invalid snapshot file";
+			return false;
+		}
+	}
+
+	size_t nulls_size = ((row_count + 31) >> 5) * sizeof(ub4_t);
+	for (size_t icol = 0; icol < col_count; ++icol)
+	{
+		if (!memdb_snapshot_fits(col_desc[icol]._data, row_count * _columns.get_column(icol).get_width(), size)
+			|| !memdb_snapshot_fits(col_desc[icol]._nulls, nulls_size, size))
+		{
+			uninit();
+			_error = "invalid snapshot file";
+			return false;
+		}
+
+		_columns.attach_column(icol, base + col_desc[icol]._data, (ub4_t*)(base + col_desc[icol]._nulls), heap);
+	}
 
-//
-// index management
-// there are no connections between the indexes in the memory and the indexes in the database
-//
+	_columns.attach_rows(row_count, base + header->_statuses);
 
-//
-// creates an index to perform the quick search
-// @columns the size of index, can be 0 for empty index
-// @info - array of index column descriptions
-// returns the new created memindex object
-// user mustn't to use object after returning it back
-// or after memtable will be destoyed
-// this is an expensive operation in order to consume memory and CPU time
-//
-terimber_memindex* 
-memtable::add_index(size_t columns, const terimber_index_column_info info[])
-{
-	terimber_index_column_array_t vec_info;
-	vec_info.resize(columns);
+	// rowset refers to the column positions
+	memdb_rownode_t** nodes = new memdb_rownode_t*[2 * row_count + 1];
+	if (!nodes)
+	{
+		uninit();
+		_error = "no enough memory";
+		return false;
+	}
 
-	// checks column's count
-	if (columns > _cols.size())
+	memdb_row row;
+	for (size_t irow = 0; irow < row_count; ++irow)
 	{
-		_error = "info size exceeds the number of available columns";
-		return 0;
+		row._pos = irow;
+		_rowset.push_back(row);
+		nodes[irow] = (--_rowset.end()).node();
 	}
 
-	for (size_t icol = 0; icol < columns; ++icol)
+	// indexes, ordered ones are linked in saved order without sorting
+	const memdb_snapshot_index* index_desc = (const memdb_snapshot_index*)(base + header->_indexes);
+	terimber_index_column_info* info = new terimber_index_column_info[col_count + 1];
+	bool res = info != 0;
+	for (size_t iindex = 0; res && iindex < header->_index_count; ++iindex)
 	{
-		vec_info[icol]._asc_sort = info[icol]._asc_sort;
-		vec_info[icol]._case_insensitive = info[icol]._case_insensitive;
-		vec_info[icol]._index = info[icol]._index;
+		const memdb_snapshot_index& desc = index_desc[iindex];
+		res = desc._column_count <= col_count
+			&& memdb_snapshot_fits(desc._columns, desc._column_count * sizeof(memdb_snapshot_index_column), size)
+			&& (desc._hash || (desc._row_count <= row_count && memdb_snapshot_fits(desc._order, desc._row_count * sizeof(ub4_t), size)));
 
-		if (vec_info[icol]._index >= _cols.size())
+		if (!res)
+			break;
+
+		const memdb_snapshot_index_column* cols = (const memdb_snapshot_index_column*)(base + desc._columns);
+		for (size_t icol = 0; icol < desc._column_count; ++icol)
 		{
-			char buf[128];
-			str_template::strprint(buf, 128, "specified index %d is out of range", vec_info[icol]._index);
-			_error = buf;
-			return 0;
+			info[icol]._index = cols[icol]._index;
+			info[icol]._asc_sort = cols[icol]._asc_sort != 0;
+			info[icol]._case_insensitive = cols[icol]._case_insensitive != 0;
 		}
 
-		vec_info[icol]._type = _cols[vec_info[icol]._index]._type;
+		memdb_rownode_t** sorted = 0;
+		if (!desc._hash)
+		{
+			const ub4_t* order = (const ub4_t*)(base + desc._order);
+			sorted = nodes + row_count;
+			for (size_t irow = 0; res && irow < desc._row_count; ++irow)
+			{
+				res = order[irow] < row_count;
+				sorted[irow] = res ? nodes[order[irow]] : 0;
+			}
+		}
+
+		res = res && create_index(desc._column_count, info, desc._hash ? index_hash : index_ordered, sorted, (size_t)desc._row_count);
 	}
 
-	memdb_rowset_less pred(vec_info);
+	delete [] info;
+	delete [] nodes;
 
-	memindex* obj = new memindex(*this, pred);
-	if (obj)
+	if (!res)
 	{
-		// constructs index
-		if (!obj->construct())
-		{
-			delete obj;
-			return 0;
-		}
+		string_t error = _error;
+		uninit();
+		_error = error.length() ? error : "invalid snapshot file";
+		return false;
+	}
 
-		// adds to the list of indexes
+	return true;
+}
+
+size_t
+memtable::get_index_count()
+{
+	mutexKeeper guard(_mtx);
+	return _indexes.size();
+}
+
+terimber_memindex*
+memtable::get_index(size_t index)
+{
+	mutexKeeper guard(_mtx);
+	for (list_indexes_t::iterator iter = _indexes.begin(); iter != _indexes.end(); ++iter, --index)
+		if (!index)
+			return *iter;
+
+	return 0;
+}
+
+terimber_memscan*
+memtable::add_scan()
+{
+	memscan* obj = new memscan(*this);
+	if (obj)
+	{
 		mutexKeeper guard(_mtx);
-		_indexes.push_back(obj);
+		_scans.push_back(obj);
+		obj->log_on(this);
 	}
 
-	obj->log_on(this);
-
 	return obj;
 }
 
-
-//
-// destroys index
-// memtable data is still valid
-// all memlookups on the current index will be destroyed! 
-//
-bool 
-memtable::remove_index(terimber_memindex* obj)
+bool
+memtable::remove_scan(terimber_memscan* obj)
 {
 	mutexKeeper guard(_mtx);
-	for (list_indexes_t::iterator iter = _indexes.begin(); iter != _indexes.end(); ++iter)
+	for (list_scans_t::iterator iter = _scans.begin(); iter != _scans.end(); ++iter)
 		if (*iter == obj)
 		{
 			(*iter)->log_on(0);
 			delete *iter;
-			_indexes.erase(iter);
+			_scans.erase(iter);
 			return true;
 		}
 
 	return false;
 }
 
-terimber_db_value_vector*
-memtable::allocate_db_values(size_t count)
+bool
+memtable::set_column_dictionary(size_t index, bool dictionary)
 {
-	// adds to the list of values
-	terimber_db_value_vector_impl* obj = new terimber_db_value_vector_impl(count);
-	if (obj)
+	mutexKeeper guard(_mtx);
+	if (!_rowset.empty() || !_indexes.empty())
 	{
-		mutexKeeper guard(_mtx);
-		_values.push_back(obj);
+		_error = "table must have no rows and no indexes";
+		return false;
 	}
 
-	return obj;
+	bool exists = index < _cols.size();
+	if (dictionary && exists && _cols[index]._type != db_string && _cols[index]._type != db_wstring)
+	{
+		_error = "dictionary is supported for string columns only";
+		return false;
+	}
+
+	if ((index >= _dictionary_columns.size() && !_dictionary_columns.resize(index + 1, false))
+		|| (dictionary && exists && !_dictionaries && !(_dictionaries = new memdb_dictionary[_cols.size()])))
+	{
+		_error = "no enough memory";
+		return false;
+	}
+
+	_dictionary_columns[index] = dictionary;
+
+	// applies to the existing column at once
+	if (exists && _dictionaries)
+		_dictionaries[index].create(dictionary ? _cols[index]._type : db_unknown);
+
+	return true;
 }
 
-void
-memtable::destroy_db_values(terimber_db_value_vector* obj)
+bool
+memtable::rank_dictionaries()
 {
-	mutexKeeper guard(_mtx);
-	for (list_values_t::iterator iter = _values.begin(); iter != _values.end(); ++iter)
-		if (*iter == obj)
+	for (size_t icol = 0; _dictionaries && icol < _cols.size(); ++icol)
+		if (_dictionaries[icol].is_active() && !_dictionaries[icol].rank())
 		{
-			delete *iter;
-			_values.erase(iter);
-			return;
+			_error = "no enough memory";
+			return false;
 		}
+
+	return true;
+}
+
+memindex*
+memtable::find_key_index(size_t key_count, const size_t keys[])
+{
+	if (!key_count || key_count > _cols.size())
+	{
+		_error = "invalid number of key columns";
+		return 0;
+	}
+
+	mutexKeeper guard(_mtx);
+	for (list_indexes_t::iterator iter = _indexes.begin(); iter != _indexes.end(); ++iter)
+	{
+		const terimber_index_column_array_t& info = (*iter)->get_index().comp().get_info();
+		if (!(*iter)->is_hashed() || !(*iter)->is_usable() || info.size() != key_count)
+			continue;
+
+		size_t icol = 0;
+		while (icol < key_count && info[icol]._index == keys[icol] && !info[icol]._case_insensitive)
+			++icol;
+
+		if (icol == key_count)
+			return *iter;
+	}
+
+	guard.unlock();
+
+	terimber_index_column_info* info = new terimber_index_column_info[key_count];
+	if (!info)
+	{
+		_error = "no enough memory";
+		return 0;
+	}
+
+	for (size_t icol = 0; icol < key_count; ++icol)
+	{
+		info[icol]._index = keys[icol];
+		info[icol]._asc_sort = true;
+		info[icol]._case_insensitive = false;
+	}
+
+	memindex* index = create_index(key_count, info, index_hash, 0, 0);
+	delete [] info;
+	return index;
 }
 
 ////////////////////////////////////////
@@ -376,92 +2714,269 @@ memtable::insert_row(const terimber_db_value_vector* info)
 		return false;
 	}
 
-	// inserts new row
-	memdb_row dummy_row;
-	_rowset.push_back(dummy_row);
-	memdb_row& row = _rowset.back();
-	// resizes row, room for columns
-	row._row.resize(_allocator, col_count);
-	row._status = status_new;
+	return insert_source(info);
+}
 
-	if (!copy_db_row(info, row, _cols,  _cols.size(), _allocator, _error))
+bool 
+memtable::update_row(memdb_rowset_citerator_t iter, const terimber_db_value_vector* info)
+{
+	return update_source(iter, info);
+}
+
+template < class S >
+bool
+memtable::insert_source(const S* source)
+{
+	// values are copied before lookups are stopped
+	mutexKeeper guard(_mtx);
+	memdb_row row;
+	reuse_row(row);
+	if (!copy_row(source, status_new, row, _row_values.begin()))
+		return false;
+
+	memdb_writer_keeper latch(_latch);
+	row._begin = _epoch + 1;
+	if (!link_row(row, _row_values.begin(), _rowset.end()))
 		return false;
 
 	memdb_rowset_citerator_t new_iter = --_rowset.end();
 
 	// notify all indexes
-	mutexKeeper guard(_mtx);
 	for (list_indexes_t::iterator iter = _indexes.begin(); iter != _indexes.end(); ++iter)
 		(*iter)->notify(new_iter, true);
 
+	publish(row._begin);
 	return true;
 }
 
-bool 
-memtable::update_row(memdb_rowset_citerator_t iter, const terimber_db_value_vector* info)
+template < class S >
+bool
+memtable::update_source(memdb_rowset_citerator_t iter, const S* source)
 {
-	// notifies all indexes
 	mutexKeeper guard(_mtx);
-	
-	for (list_indexes_t::iterator diter = _indexes.begin(); diter != _indexes.end(); ++diter)
-		(*diter)->notify(iter, false);
-
-	// updates row
 	memdb_rowset_iterator_t uiter(iter.node());
 
-	uiter->_status = status_new;
+	// the version has been replaced after lookup found it
+	if (uiter->_end != memdb_epoch_infinite)
+	{
+		_error = "row has been changed";
+		return false;
+	}
 
-	if (!copy_db_row(info, *uiter, _cols,  _cols.size(), _allocator, _error))
+	// new version, the old one stays for lookups started before
+	memdb_row row;
+	reuse_row(row);
+	if (!copy_row(source, _columns.get_status(*uiter) == status_new ? status_new : status_updated, row, _row_values.begin()))
 		return false;
 
-	switch (uiter->_status)
-	{
-		case status_new:
-			break;
-		case status_updated:
-			break;
-		case status_original:
-			uiter->_status = status_updated;
-			break;
-		case status_deleted:
-			assert(false);
-	}
+	memdb_writer_keeper latch(_latch);
+	row._begin = _epoch + 1;
+	memdb_rowset_iterator_t where = uiter;
+	if (!link_row(row, _row_values.begin(), ++where))
+		return false;
+
+	memdb_rowset_citerator_t new_iter = --where;
+	uiter->_end = row._begin;
+
+	memdb_retired_row retired;
+	retired._row = uiter.node();
+	retired._unlink = true;
+	_retired.push_back(retired);
+	++_unlinked;
 
 	// notifies all indexes
 	for (list_indexes_t::iterator niter = _indexes.begin(); niter != _indexes.end(); ++niter)
-		(*niter)->notify(uiter, true);
+		(*niter)->notify(new_iter, true);
 
+	publish(row._begin);
 	return true;
 }
 
 bool 
 memtable::delete_row(memdb_rowset_citerator_t iter)
 {
-	// notifies all indexes
 	mutexKeeper guard(_mtx);
-	for (list_indexes_t::iterator diter = _indexes.begin(); diter != _indexes.end(); ++diter)
-		(*diter)->notify(iter, false);
-
-	// remove
 	memdb_rowset_iterator_t uiter(iter.node());
 
-	switch (uiter->_status)
+	if (uiter->_end != memdb_epoch_infinite)
+	{
+		_error = "row has been changed";
+		return false;
+	}
+
+	memdb_retired_row retired;
+	retired._row = uiter.node();
+
+	switch (_columns.get_status(*uiter))
 	{
 		case status_new:
-			_rowset.erase(uiter);
+			// removed from recordset
+			retired._unlink = true;
+			++_unlinked;
 			break;
 		case status_updated:
-			break;
 		case status_original:
-			uiter->_status = status_deleted;
+			// marked as deleted
+			retired._unlink = false;
 			break;
-		case status_deleted:
+		default:
 			assert(false);
+			return false;
+	}
+
+	memdb_writer_keeper latch(_latch);
+	size_t epoch = _epoch + 1;
+	uiter->_end = epoch;
+	_retired.push_back(retired);
+	publish(epoch);
+	return true;
+}
+
+void
+memtable::publish(size_t epoch)
+{
+	// arrays replaced by this change are released after older scans
+	if (_columns.has_retired())
+		_arrays_epoch = epoch;
+
+	memdb_fence();
+	_epoch = epoch;
+	reclaim();
+}
+
+void
+memtable::reclaim()
+{
+	if (_retired.empty() && !_columns.has_retired())
+		return;
+
+	// versions replaced before the oldest scan started are not seen by anybody
+	size_t oldest = _epoch;
+	for (list_indexes_t::iterator iiter = _indexes.begin(); iiter != _indexes.end(); ++iiter)
+		oldest = (*iiter)->get_min_snapshot(oldest);
+
+	if (_columns.has_retired() && _arrays_epoch <= oldest)
+		_columns.release_retired();
+
+	// versions are retired in the epoch order
+	while (!_retired.empty())
+	{
+		const memdb_retired_row& retired = _retired.front();
+		memdb_rowset_iterator_t uiter(retired._row);
+		if (uiter->_end > oldest)
+			break;
+
+		// comparision treats deleted rows differently, so status is changed after erasing
+		for (list_indexes_t::iterator iiter = _indexes.begin(); iiter != _indexes.end(); ++iiter)
+			(*iiter)->notify(uiter, false);
+
+		if (retired._unlink)
+		{
+			if (uiter->_pos != os_minus_one)
+				_columns.free_row(uiter->_pos);
+			else
+				_spare.push_back(uiter->_row);
+
+			_rowset.erase(uiter);
+			--_unlinked;
+		}
+		else
+			_columns.set_status(*uiter, status_deleted);
+
+		_retired.pop_front();
+	}
+}
+
+void
+memtable::reuse_row(memdb_row& row)
+{
+	if (_columnar || _spare.empty())
+		return;
+
+	row._row = _spare.front();
+	_spare.pop_front();
+}
+
+bool
+memtable::init_columns()
+{
+	// dictionaries of string columns flagged by set_column_dictionary
+	size_t col_count = _cols.size();
+	for (size_t icol = 0; icol < col_count && icol < _dictionary_columns.size(); ++icol)
+	{
+		if (!_dictionary_columns[icol]
+			|| (_cols[icol]._type != db_string && _cols[icol]._type != db_wstring))
+			continue;
+
+		if (!_dictionaries && !(_dictionaries = new memdb_dictionary[col_count]))
+		{
+			_error = "no enough memory";
+			return false;
+		}
+
+		_dictionaries[icol].create(_cols[icol]._type);
+	}
+
+	if (!_columnar)
+		return true;
+
+	if (!_row_values.resize(_allocator, _cols.size())
+		|| !_columns.create(_cols))
+	{
+		_error = "no enough memory";
+		return false;
 	}
 
 	return true;
 }
 
+template < class S >
+bool
+memtable::add_row(const S* source, terimber_db_row_status status)
+{
+	memdb_row row;
+	return copy_row(source, status, row, _row_values.begin())
+		&& link_row(row, _row_values.begin(), _rowset.end());
+}
+
+template < class S >
+bool
+memtable::copy_row(const S* source, terimber_db_row_status status, memdb_row& row, terimber_db_value* values)
+{
+	row._status = status;
+
+	if (_columnar)
+		return copy_db_row(source, values, _cols, _cols.size(), _allocator, _error, _dictionaries);
+
+	// resizes row, room for columns, reused row has it already
+	if (row._row.size() != _cols.size())
+		row._row.resize(_allocator, _cols.size());
+	return copy_db_row(source, row._row.begin(), _cols, _cols.size(), _allocator, _error, _dictionaries);
+}
+
+bool
+memtable::link_row(const memdb_row& row, const terimber_db_value* values, memdb_rowset_iterator_t where)
+{
+	if (!_columnar)
+	{
+		// inserts new row
+		_rowset.insert(where, row);
+		return true;
+	}
+
+	memdb_row dummy_row;
+	dummy_row._begin = row._begin;
+	dummy_row._pos = _columns.add_row(row._status);
+	if (dummy_row._pos == os_minus_one)
+	{
+		_error = "no enough memory";
+		return false;
+	}
+
+	_columns.set_values(dummy_row._pos, values);
+	_rowset.insert(where, dummy_row);
+	return true;
+}
 
 #pragma pack()
 END_TERIMBER_NAMESPACE
@@ -40,6 +40,15 @@
 #include <sys/socket.h>
 #include <pthread.h>
 #include <aio.h>
+#include <sys/epoll.h>
+#include <sys/poll.h>
+#include <sys/signalfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if !defined(NO_IO_URING)
+#include <linux/io_uring.h>
+#endif
 #include <signal.h>
 #include <errno.h>
 
@@ -49,6 +58,7 @@
 #include <math.h>
 #include <time.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdarg.h>
 #include <memory.h>
 #include <string.h>
@@ -40,6 +40,7 @@
 #include <sys/socket.h>
 #include <pthread.h>
 #include <aio.h>
+#include <poll.h>
 #include <signal.h>
 #include <errno.h>
 
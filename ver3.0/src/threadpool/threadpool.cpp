@@ -26,6 +26,7 @@
 */
 
 #include "threadpool/threadpool.h"
+#include "base/date.h"
 #include "base/map.hpp"
 #include "base/list.hpp"
 #include "base/template.hpp"
@@ -33,6 +34,9 @@
 #include "base/memory.hpp"
 
 static const size_t housekeeper_timeout = 10000; // 10 seconds
+static const size_t executor_housekeeper_timeout = 100; // alert and disposal checks
+static const size_t executor_slot_quantum = 64; // client jobs in a row before adapter yields the worker
+static const size_t executor_batch = 32; // tasks moved from shared queue to the worker deque at once
 
 terimber_threadpool_factory::terimber_threadpool_factory()
 {
@@ -56,10 +60,41 @@ terimber_threadpool_factory::get_thread_pool(terimber_log* log, size_t capacity,
 	return obj;
 }
 
+terimber_executor* 
+terimber_threadpool_factory::get_executor(terimber_log* log, size_t workers)
+{
+	if (!workers)
+	{
+#if OS_TYPE == OS_WIN32
+		SYSTEM_INFO sys_info;
+		GetSystemInfo(&sys_info);
+		workers = sys_info.dwNumberOfProcessors;
+#else
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		workers = cpus > 0 ? (size_t)cpus : 1;
+#endif
+	}
+
+	TERIMBER::executor* obj = new TERIMBER::executor(workers);
+	if (obj)
+	{
+		obj->log_on(log);
+		obj->on();
+	}
+
+	return obj;
+}
 
 BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
+//! \brief current executor worker, zero for other threads
+#if OS_TYPE == OS_WIN32
+static __declspec(thread) executor_worker* executor_current_worker = 0;
+#else
+static __thread executor_worker* executor_current_worker = 0;
+#endif
+
 /////////////////////////////////////////////////
 threadpool::threadpool(size_t capacity, size_t deactivate_time_msec) :
 	_on(false),
@@ -576,6 +611,658 @@ threadpool::doxray()
 		threads, capacity, clients, disposal);
 }
 
+/////////////////////////////////////////////////
+executor_deque::executor_deque() :
+	_top(0),
+	_bottom(0)
+{
+}
+
+bool 
+executor_deque::push(terimber_task* task)
+{
+	size_t b = _bottom;
+	if (b - _top >= executor_deque_size)
+		return false;
+
+	_tasks[b & (executor_deque_size - 1)] = task;
+	// publishes task before bottom
+	executor_fence();
+	_bottom = b + 1;
+	return true;
+}
+
+terimber_task* 
+executor_deque::pop()
+{
+	size_t b = _bottom - 1;
+	_bottom = b;
+	// thieves must see the new bottom before top is read
+	executor_fence();
+	size_t t = _top;
+
+	if ((ptrdiff_t)(b - t) < 0) // empty
+	{
+		_bottom = t;
+		return 0;
+	}
+
+	terimber_task* task = _tasks[b & (executor_deque_size - 1)];
+	if (b != t)
+		return task;
+
+	// the last task, races with thieves
+	if (!executor_cas(&_top, t, t + 1))
+		task = 0;
+
+	_bottom = t + 1;
+	return task;
+}
+
+terimber_task* 
+executor_deque::steal()
+{
+	size_t t = _top;
+	executor_fence();
+	size_t b = _bottom;
+
+	if ((ptrdiff_t)(b - t) <= 0) // empty
+		return 0;
+
+	terimber_task* task = _tasks[t & (executor_deque_size - 1)];
+	return executor_cas(&_top, t, t + 1) ? task : 0;
+}
+
+/////////////////////////////////////////////////
+// virtual 
+void 
+executor_slot::v_execute()
+{
+	_owner->_run_slot(this);
+}
+
+/////////////////////////////////////////////////
+executor::executor(size_t workers) :
+	_queued(0),
+	_idle(0),
+	_next(0),
+	_on(false),
+	_count(workers ? workers : 1),
+	_workers(0),
+	_threads(0),
+	_submitted(0),
+	_wakeups(0)
+{
+}
+
+executor::~executor()
+{
+	off();
+}
+
+bool 
+executor::on()
+{
+	if (_on)
+		return false;
+
+	format_logging(0, __FILE__, __LINE__, en_log_info, "starting executor with %d workers...", _count);
+
+	_workers = new executor_worker[_count];
+	_threads = new thread[_count];
+
+	if (!_workers || !_threads)
+	{
+		delete [] _workers, _workers = 0;
+		delete [] _threads, _threads = 0;
+		format_logging(0, __FILE__, __LINE__, en_log_error, "not enough memory");
+		return false;
+	}
+
+	_on = true;
+
+	for (size_t index = 0; index < _count; ++index)
+	{
+		_workers[index]._owner = this;
+		_workers[index]._index = index;
+		_workers[index]._seed = index + 1;
+
+		// worker sleeps until the task is submitted
+		job_task job(this, index, INFINITE, &_workers[index]);
+		_threads[index].start();
+		_threads[index].assign_job(job);
+	}
+
+	// starts housekeeping thread
+	job_task job(this, 0, executor_housekeeper_timeout, 0);
+	_housekeeper.start();
+	_housekeeper.assign_job(job);
+
+	format_logging(0, __FILE__, __LINE__, en_log_info, "executor started");
+	return true;
+}
+
+void 
+executor::off()
+{
+	if (!_on)
+		return;
+
+	format_logging(0, __FILE__, __LINE__, en_log_info, "stopping executor...");
+
+	// locks mutex
+	mutexKeeper guard(_slots_mtx);
+	_on = false;
+	guard.unlock();
+
+	// stops housekeeping thread
+	_housekeeper.cancel_job();
+	_housekeeper.stop();
+
+	// stops workers, the tasks in progress are completed
+	for (size_t index = 0; index < _count; ++index)
+	{
+		_threads[index].cancel_job();
+		_threads[index].stop();
+	}
+
+	// discards not started tasks
+	mutexKeeper queue_guard(_queue_mtx);
+	_queue.clear();
+	_queued = 0;
+	queue_guard.unlock();
+
+	guard.lock();
+	_clean_up_slots();
+	guard.unlock();
+
+	delete [] _threads, _threads = 0;
+	delete [] _workers, _workers = 0;
+	_idle = 0;
+
+	format_logging(0, __FILE__, __LINE__, en_log_info, "executor stopped");
+}
+
+// virtual 
+bool 
+executor::submit(terimber_task* task)
+{
+	if (!task || !_on)
+		return false;
+
+	executor_worker* worker = executor_current_worker;
+
+	// worker thread pushes into own deque without locks
+	if (!worker 
+		|| worker->_owner != this 
+		|| !worker->_deque.push(task)
+		)
+		_inject(task);
+
+	++_submitted;
+	_wakeup_worker();
+	return true;
+}
+
+// virtual 
+size_t 
+executor::workers() const
+{
+	return _count;
+}
+
+// virtual 
+bool 
+executor::v_has_job(size_t ident, void* user_data)
+{
+	// is this houskeeping thread?
+	if (user_data == 0)
+	{
+		mutexKeeper guard(_slots_mtx);
+
+		if (!_on)
+			return false;
+
+		for (slot_list_t::iterator it_revoked = _revoked.begin(); it_revoked != _revoked.end(); ++it_revoked)
+			if ((*it_revoked)->_state != EXECUTOR_SLOT_SCHEDULED)
+				return true;
+
+		date now;
+		for (slot_map_t::iterator it_slot = _slots.begin(); it_slot != _slots.end(); ++it_slot)
+			if ((*it_slot)->_state == EXECUTOR_SLOT_ALERT && (*it_slot)->_expired <= (sb8_t)now)
+				return true;
+
+		return false;
+	}
+
+	executor_worker* worker = (executor_worker*)user_data;
+	executor_current_worker = worker;
+
+	// woken up by timeout or found the task in the last look
+	if (worker->_parked && executor_cas(&worker->_parked, 1, 0))
+		executor_add(&_idle, (size_t)-1);
+
+	if (!_on)
+		return false;
+
+	if ((worker->_current = _find_task(worker)) != 0)
+		return true;
+
+	// announces the parking before the last look, pairs with the fence in _wakeup_worker
+	// either submit sees the parked worker or the worker sees the submitted task
+	worker->_parked = 1;
+	executor_add(&_idle, 1);
+	executor_fence();
+
+	if ((worker->_current = _find_task(worker)) != 0)
+	{
+		if (executor_cas(&worker->_parked, 1, 0))
+			executor_add(&_idle, (size_t)-1);
+		return true;
+	}
+
+	return false;
+}
+
+// virtual 
+void 
+executor::v_do_job(size_t ident, void* user_data)
+{
+	// is this the houskeeping thread?
+	if (user_data == 0)
+	{
+		mutexKeeper guard(_slots_mtx);
+
+		if (!_on)
+			return;
+
+		// deletes revoked adapters, which are not in any queue anymore
+		slot_list_t::iterator it_revoked = _revoked.begin();
+		while (it_revoked != _revoked.end())
+		{
+			if ((*it_revoked)->_state != EXECUTOR_SLOT_SCHEDULED)
+			{
+				delete *it_revoked;
+				it_revoked = _revoked.erase(it_revoked);
+			}
+			else
+				++it_revoked;
+		}
+
+		// polls clients again after stay on alert time
+		date now;
+		for (slot_map_t::iterator it_slot = _slots.begin(); it_slot != _slots.end(); ++it_slot)
+			if ((*it_slot)->_state == EXECUTOR_SLOT_ALERT && (*it_slot)->_expired <= (sb8_t)now)
+				_schedule_slot(*it_slot);
+
+		return;
+	}
+
+	executor_worker* worker = (executor_worker*)user_data;
+	terimber_task* task = worker->_current;
+	worker->_current = 0;
+
+	if (task)
+	{
+		++worker->_executed;
+		task->v_execute();
+	}
+}
+
+terimber_task* 
+executor::_find_task(executor_worker* worker)
+{
+	// own tasks first
+	terimber_task* task = worker->_deque.pop();
+	if (task)
+		return task;
+
+	// shared queue
+	if (_queued)
+	{
+		mutexKeeper guard(_queue_mtx);
+		if (_queued)
+		{
+			task = _queue.front();
+			_queue.pop_front();
+			--_queued;
+
+			// moves a batch into own deque, so idle workers can steal it
+			size_t moved = 0;
+			while (moved + 1 < executor_batch 
+				&& _queued 
+				&& worker->_deque.push(_queue.front())
+				)
+			{
+				_queue.pop_front();
+				--_queued;
+				++moved;
+			}
+
+			guard.unlock();
+
+			if (moved)
+				_wakeup_worker();
+
+			return task;
+		}
+	}
+
+	// steals from other workers starting with the random victim
+	if (_count > 1)
+	{
+		worker->_seed = worker->_seed * 1103515245 + 12345;
+		size_t start = (worker->_seed >> 16) % _count;
+
+		for (size_t index = 0; index < _count; ++index)
+		{
+			executor_worker& victim = _workers[(start + index) % _count];
+			if (&victim == worker)
+				continue;
+
+			// steal fails on race with owner or other thieves, retries while victim has tasks
+			while ((ptrdiff_t)victim._deque.size() > 0)
+			{
+				if ((task = victim._deque.steal()) != 0)
+				{
+					++worker->_stolen;
+					return task;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+void 
+executor::_inject(terimber_task* task)
+{
+	mutexKeeper guard(_queue_mtx);
+	_queue.push_back(task);
+	++_queued;
+}
+
+void 
+executor::_wakeup_worker()
+{
+	// pairs with the fence in v_has_job
+	executor_fence();
+
+	if (!_idle)
+		return;
+
+	size_t start = _next;
+	for (size_t index = 0; index < _count; ++index)
+	{
+		executor_worker& worker = _workers[(start + index) % _count];
+		if (worker._parked && executor_cas(&worker._parked, 1, 0))
+		{
+			executor_add(&_idle, (size_t)-1);
+			_next = (start + index + 1) % _count;
+			++_wakeups;
+			_threads[worker._index].wakeup();
+			return;
+		}
+	}
+}
+
+void 
+executor::_schedule_slot(executor_slot* slot)
+{
+	if (slot->_state == EXECUTOR_SLOT_SCHEDULED)
+	{
+		// polls client again before yielding the worker
+		slot->_again = true;
+		return;
+	}
+
+	slot->_state = EXECUTOR_SLOT_SCHEDULED;
+	slot->_again = false;
+	submit(slot);
+}
+
+void 
+executor::_run_slot(executor_slot* slot)
+{
+	for (size_t quantum = 0; quantum < executor_slot_quantum; ++quantum)
+	{
+		// locks mutex
+		mutexKeeper guard(_slots_mtx);
+
+		if (!_on || slot->_revoked)
+		{
+			slot->_state = EXECUTOR_SLOT_DORMANT;
+			return;
+		}
+
+		// client has had a job on the previous round
+		if (quantum)
+			slot->_wasted_calls = 0;
+
+		slot->_again = false;
+
+		// makes a copy
+		terimber_thread_employer* client = slot->_client;
+		size_t ident = slot->_ident;
+		void* data = slot->_data;
+
+		// unlocks mutex
+		guard.unlock();
+
+		// requests jobs
+		if (client->v_has_job(ident, data))
+		{
+			client->v_do_job(ident, data);
+			continue;
+		}
+
+		// no jobs to do
+		guard.lock();
+
+		if (slot->_revoked)
+		{
+			slot->_state = EXECUTOR_SLOT_DORMANT;
+			return;
+		}
+
+		// borrow_thread has been called while polling
+		if (slot->_again)
+			continue;
+
+		// polls once again after stay on alert time, like the thread waiting for wakeup
+		if (!slot->_wasted_calls++ && slot->_alert != INFINITE)
+		{
+			date now;
+			slot->_expired = (sb8_t)now + slot->_alert;
+			slot->_state = EXECUTOR_SLOT_ALERT;
+		}
+		else
+			slot->_state = EXECUTOR_SLOT_DORMANT;
+
+		return;
+	}
+
+	// yields the worker to the other tasks, the shared queue is fifo
+	_inject(slot);
+	_wakeup_worker();
+}
+
+void 
+executor::_clean_up_slots()
+{
+	for (slot_map_t::iterator it_slot = _slots.begin(); it_slot != _slots.end(); ++it_slot)
+		delete *it_slot;
+
+	_slots.clear();
+
+	for (slot_list_t::iterator it_revoked = _revoked.begin(); it_revoked != _revoked.end(); ++it_revoked)
+		delete *it_revoked;
+
+	_revoked.clear();
+}
+
+// virtual 
+bool 
+executor::borrow_thread(size_t ident, void* data, terimber_thread_employer* client, size_t stay_on_alert_time_msec)
+{
+	if (!client) // checks pointer
+	{
+		assert(false);
+		format_logging(0, __FILE__, __LINE__, en_log_error, "null pointer for user callback");
+		return false;
+	}
+
+	// locks mutex
+	mutexKeeper guard(_slots_mtx);
+
+	if (!_on)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "executor is not activated");
+		return false;
+	}
+
+	executor_slot_key key(client, ident);
+	slot_map_t::iterator it_slot = _slots.find(key);
+	executor_slot* slot = 0;
+
+	if (it_slot == _slots.end())
+	{
+		slot = new executor_slot(this, client, ident, data, stay_on_alert_time_msec);
+		if (!slot || _slots.insert(key, slot).first == _slots.end())
+		{
+			delete slot;
+			format_logging(0, __FILE__, __LINE__, en_log_error, "not enough memory");
+			return false;
+		}
+
+		format_logging(0, __FILE__, __LINE__, en_log_paranoid, "new task %d for client %d", ident, client);
+	}
+	else
+		slot = *it_slot;
+
+	// resets wasted
+	slot->_wasted_calls = 0;
+	_schedule_slot(slot);
+	return true;
+}
+
+// virtual 
+bool 
+executor::borrow_from_range(size_t from, size_t to, void* data, terimber_thread_employer* client, size_t stay_on_alert_time_msec)
+{
+	if (!client || from > to) // checks pointer
+	{
+		assert(false);
+		format_logging(0, __FILE__, __LINE__, en_log_error, "null pointer for user callback or invalid range");
+		return false;
+	}
+
+	// locks mutex
+	mutexKeeper guard(_slots_mtx);
+
+	if (!_on)
+	{
+		format_logging(0, __FILE__, __LINE__, en_log_error, "executor is not activated");
+		return false;
+	}
+
+	slot_map_t::iterator it_slot = _slots.lower_bound(executor_slot_key(client, from));
+
+	for (size_t ident = from; ident <= to; ++ident)
+	{
+		if (it_slot == _slots.end() 
+			|| it_slot.key()._client != client 
+			|| it_slot.key()._ident != ident
+			) // found a hole
+		{
+			executor_slot_key key(client, ident);
+			executor_slot* slot = new executor_slot(this, client, ident, data, stay_on_alert_time_msec);
+			if (!slot || _slots.insert(key, slot).first == _slots.end())
+			{
+				delete slot;
+				format_logging(0, __FILE__, __LINE__, en_log_error, "not enough memory");
+				return false;
+			}
+
+			format_logging(0, __FILE__, __LINE__, en_log_paranoid, "new task %d for client %d", ident, client);
+			_schedule_slot(slot);
+			return true;
+		}
+
+		if ((*it_slot)->_state != EXECUTOR_SLOT_SCHEDULED)
+		{
+			(*it_slot)->_wasted_calls = 0;
+			_schedule_slot(*it_slot);
+			return true;
+		}
+
+		if (ident == to)
+			break;
+
+		++it_slot;
+	}
+
+	format_logging(0, __FILE__, __LINE__, en_log_info, "no idents are available within the range [%d, %d] for client %d", from, to, client);
+	return false;
+}
+
+// virtual 
+void 
+executor::revoke_client(terimber_thread_employer* client)
+{
+	if (!client)
+		return;
+
+	// locks mutex
+	mutexKeeper guard(_slots_mtx);
+
+	slot_map_t::iterator it_slot = _slots.lower_bound(executor_slot_key(client, 0));
+	while (it_slot != _slots.end() && it_slot.key()._client == client)
+	{
+		executor_slot* slot = *it_slot;
+		it_slot = _slots.erase(it_slot);
+
+		// queued or running adapter is deleted by housekeeper
+		if (slot->_state == EXECUTOR_SLOT_SCHEDULED)
+		{
+			slot->_revoked = true;
+			_revoked.push_back(slot);
+		}
+		else
+			delete slot;
+	}
+
+	format_logging(0, __FILE__, __LINE__, en_log_info, "revoke client %d", client);
+}
+
+// virtual 
+void 
+executor::doxray()
+{
+	// locks mutex 
+	mutexKeeper guard(_slots_mtx);
+
+	size_t clients = _slots.size(),
+		revoked = _revoked.size(),
+		executed = 0,
+		stolen = 0;
+
+	if (_workers)
+	{
+		for (size_t index = 0; index < _count; ++index)
+		{
+			executed += _workers[index]._executed;
+			stolen += _workers[index]._stolen;
+		}
+	}
+
+	guard.unlock();
+
+	format_logging(0, __FILE__, __LINE__, en_log_xray, "<executor workers=\"%d\" idle=\"%d\" queued=\"%d\" submitted=\"%d\" executed=\"%d\" stolen=\"%d\" wakeups=\"%d\" clients=\"%d\" revoked=\"%d\" />",
+		_count, _idle, _queued, _submitted, executed, stolen, _wakeups, clients, revoked);
+}
+
 #pragma pack()
 END_TERIMBER_NAMESPACE
 
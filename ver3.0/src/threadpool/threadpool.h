@@ -162,6 +162,292 @@ private:
 	size_t					_deactivate_time_msec;			//!< deactivation time in milliseconds
 };
 
+//! \brief executor worker deque size, must be power of two
+const size_t executor_deque_size = 4096;
+
+//! \brief compares and swaps value, returns true if value was replaced
+inline 
+bool 
+executor_cas(volatile size_t* p, size_t expected, size_t desired)
+{
+#if OS_TYPE == OS_WIN32
+	return ::InterlockedCompareExchangePointer((PVOID volatile*)p, (PVOID)desired, (PVOID)expected) == (PVOID)expected;
+#else
+	return __sync_bool_compare_and_swap(p, expected, desired);
+#endif
+}
+
+//! \brief full memory barrier
+inline 
+void 
+executor_fence()
+{
+#if OS_TYPE == OS_WIN32
+	::MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+//! \brief atomically adds value, returns new value
+inline 
+size_t 
+executor_add(volatile size_t* p, size_t v)
+{
+#if OS_TYPE == OS_WIN32
+	size_t old;
+	do
+	{
+		old = *p;
+	}
+	while (!executor_cas(p, old, old + v));
+	return old + v;
+#else
+	return __sync_add_and_fetch(p, v);
+#endif
+}
+
+//! \class executor_deque
+//! \brief fixed size Chase-Lev work stealing deque
+//! the owner thread pushes and pops at the bottom, any thread steals from the top
+class executor_deque
+{
+public:
+	//! \brief constructor
+	executor_deque();
+	//! \brief pushes task, owner thread only, returns false if deque is full
+	bool 
+	push(			terimber_task* task						//!< task
+					);
+	//! \brief pops the last pushed task, owner thread only
+	terimber_task* 
+	pop();
+	//! \brief steals the first pushed task, any thread
+	terimber_task* 
+	steal();
+	//! \brief returns approximate number of tasks
+	inline 
+	size_t 
+	size() const
+	{
+		return _bottom - _top;
+	}
+
+private:
+	volatile size_t			_top;							//!< steal index
+	volatile size_t			_bottom;						//!< owner index
+	terimber_task* volatile	_tasks[executor_deque_size];	//!< circular buffer
+};
+
+class executor;
+
+//! \class executor_worker
+//! \brief worker thread info
+class executor_worker
+{
+public:
+	//! \brief constructor
+	executor_worker() :
+		_owner(0), _index(0), _current(0), _parked(0), _seed(0), _executed(0), _stolen(0)
+	{
+	}
+
+	executor*				_owner;							//!< executor
+	size_t					_index;							//!< worker index
+	terimber_task*			_current;						//!< task found by v_has_job
+	volatile size_t			_parked;						//!< 1 if worker is going to sleep
+	size_t					_seed;							//!< random seed to choose the victim
+	size_t					_executed;						//!< executed task counter
+	size_t					_stolen;						//!< stolen task counter
+	executor_deque			_deque;							//!< own tasks
+};
+
+//! \class executor_slot_key
+//! \brief key of client thread ident
+class executor_slot_key
+{
+public:
+	//! \brief constructor
+	executor_slot_key(terimber_thread_employer* client,		//!< user callback
+					size_t ident							//!< thread ident
+					) :
+		_client(client), _ident(ident)
+	{
+	}
+	//! \brief operator<
+	inline 
+	bool 
+	operator<(		const executor_slot_key& x				//!< key to compare
+					) const
+	{
+		return _client < x._client || (_client == x._client && _ident < x._ident);
+	}
+
+	terimber_thread_employer*	_client;					//!< user callback
+	size_t						_ident;						//!< thread ident
+};
+
+//! \enum executor_slot_state
+//! \brief employer adapter states
+enum executor_slot_state
+{
+	EXECUTOR_SLOT_DORMANT,									//!< waits for borrow_thread call
+	EXECUTOR_SLOT_SCHEDULED,								//!< queued or running
+	EXECUTOR_SLOT_ALERT										//!< waits for stay_on_alert time to expire, then polls again
+};
+
+//! \class executor_slot
+//! \brief adapter running thread employer client as executor task
+class executor_slot : public terimber_task
+{
+public:
+	//! \brief constructor
+	executor_slot(	executor* owner,						//!< executor
+					terimber_thread_employer* client,		//!< user callback
+					size_t ident,							//!< thread ident
+					void* data,								//!< user defined data
+					size_t alert							//!< stay on alert time in milliseconds
+					) :
+		_owner(owner), _client(client), _ident(ident), _data(data), _alert(alert), _state(EXECUTOR_SLOT_DORMANT), _again(false), _revoked(false), _wasted_calls(0), _expired(0)
+	{
+	}
+	//! \brief polls client
+	virtual 
+	void 
+	v_execute();
+
+	executor*					_owner;						//!< executor
+	terimber_thread_employer*	_client;					//!< user callback
+	size_t						_ident;						//!< thread ident
+	void*						_data;						//!< user defined data
+	size_t						_alert;						//!< stay on alert time in milliseconds
+	executor_slot_state			_state;						//!< state
+	bool						_again;						//!< borrow_thread has been called while scheduled
+	bool						_revoked;					//!< client has been revoked
+	size_t						_wasted_calls;				//!< wasted calls, when v_has_job returned false
+	sb8_t						_expired;					//!< time to poll again in alert state
+};
+
+//! \class executor
+//! \brief work stealing executor
+//! each worker owns the deque, idle workers take tasks from the shared queue and steal from the others
+//! the sleeping workers are waked up only when a new task is submitted
+class executor : public terimber_executor, 
+					public terimber_thread_employer
+{
+	//! \typedef slot_map_t
+	//! \brief maps client thread ident to adapter
+	typedef map< executor_slot_key, executor_slot* >	slot_map_t;
+	//! \typedef slot_list_t
+	//! \brief list of revoked adapters
+	typedef list< executor_slot* >						slot_list_t;
+	//! \typedef task_list_t
+	//! \brief list of tasks
+	typedef list< terimber_task* >						task_list_t;
+
+	friend class executor_slot;
+public:
+	//! \brief constructor
+	executor(		size_t workers							//!< number of worker threads
+					);
+	//! \brief destructor
+	~executor();
+	//! \brief schedules the task
+	virtual 
+	bool 
+	submit(			terimber_task* task						//!< task
+					);
+	//! \brief returns the number of worker threads
+	virtual 
+	size_t 
+	workers() const;
+	//! \brief schedules client ident as the task
+	virtual 
+	bool 
+	borrow_thread(	size_t ident,							//!< thread ident will be used as input parameter for client thread functions
+					void* data,								//!< user defined data will be used as input parameter for client thread functions
+					terimber_thread_employer* client,		//!< user callback
+					size_t stay_on_alert_time_msec			//!< time in milliseconds to poll client again after v_has_job returned false
+					);
+	//! \brief schedules the first not scheduled client ident in the range
+	virtual 
+	bool 
+	borrow_from_range(size_t from,							//!< from ident
+					size_t to,								//!< to ident
+					void* data,								//!< user defined data will be used as input parameter for client thread functions
+					terimber_thread_employer* client,		//!< user callback
+					size_t stay_on_alert_time_msec			//!< time in milliseconds to poll client again after v_has_job returned false
+					);
+	//! \brief stops scheduling client functions
+	//! however the client function calls already in progress should be completed
+	virtual 
+	void 
+	revoke_client(	terimber_thread_employer* client		//!< user callback
+					);
+	//! \brief does xray
+	virtual 
+	void 
+	doxray();
+	//! \brief turns on
+	bool on();
+	//! \brief turns off
+	//! tasks not started yet are discarded
+	void off();
+
+protected:
+	//! \brief looks for the task
+	virtual 
+	bool 
+	v_has_job(		size_t ident,							//!< thread ident
+					void* user_data							//!< user defined data
+					);
+	//! \brief executes the task
+	virtual 
+	void 
+	v_do_job(		size_t ident,							//!< thread ident
+					void* user_data							//!< user defined data
+					);
+private:
+	//! \brief finds the task in own deque, in shared queue or steals from other workers
+	terimber_task* 
+	_find_task(		executor_worker* worker					//!< worker
+					);
+	//! \brief puts the task into shared queue
+	void 
+	_inject(		terimber_task* task						//!< task
+					);
+	//! \brief wakes up one parked worker if any
+	void 
+	_wakeup_worker();
+	//! \brief schedules the adapter, mutex must be locked
+	void 
+	_schedule_slot(	executor_slot* slot						//!< adapter
+					);
+	//! \brief polls the client, called by adapter
+	void 
+	_run_slot(		executor_slot* slot						//!< adapter
+					);
+	//! \brief deletes all adapters
+	void 
+	_clean_up_slots();
+private:
+	volatile size_t			_queued;						//!< shared queue size
+	volatile size_t			_idle;							//!< parked workers counter
+	volatile size_t			_next;							//!< next worker to wakeup
+	bool					_on;							//!< flag on/off
+	size_t					_count;							//!< number of workers
+	executor_worker*		_workers;						//!< workers info
+	thread*					_threads;						//!< worker threads
+	thread					_housekeeper;					//!< alert and disposal thread
+	mutex					_queue_mtx;						//!< shared queue mutex
+	task_list_t				_queue;							//!< shared queue
+	mutex					_slots_mtx;						//!< adapters mutex
+	slot_map_t				_slots;							//!< adapters
+	slot_list_t				_revoked;						//!< revoked adapters waiting for completion
+	size_t					_submitted;						//!< submitted tasks counter, approximate
+	size_t					_wakeups;						//!< worker wakeups counter, approximate
+};
+
 #pragma pack()
 END_TERIMBER_NAMESPACE
 
@@ -96,6 +96,49 @@ public:
 	doxray() = 0;
 };
 
+//! \class terimber_task
+//! \brief abstract unit of work for the executor
+//! task object is owned by the caller and must stay alive until executed
+class terimber_task
+{
+public:
+	//! \brief destructor
+	virtual ~terimber_task() 
+	{
+	}
+	//! \brief executes task
+	//! called once per submit in one of the executor worker threads
+	virtual 
+	void 
+	v_execute() = 0;
+};
+
+//! \class terimber_executor
+//! \brief abstract interface for the work stealing executor
+//! tasks are spread across the fixed number of worker threads
+//! borrow_thread and borrow_from_range are adapters for the existing thread employers,
+//! each client ident is scheduled as a task polling v_has_job/v_do_job 
+//! and yielding the worker when v_has_job returns false
+class terimber_executor : public terimber_threadpool
+{
+public:
+	//! \brief destructor
+	virtual ~terimber_executor() 
+	{
+	}
+	//! \brief schedules the task
+	//! task submitted from inside of worker thread goes to the worker own queue
+	//! returns false if executor is not activated
+	virtual 
+	bool 
+	submit(			terimber_task* task						//!< task
+					) = 0;
+	//! \brief returns the number of worker threads
+	virtual 
+	size_t 
+	workers() const = 0;
+};
+
 //! \class terimber_threadpool_factory
 //! \brief thread pool factory
 //! creates thread pools
@@ -117,6 +160,12 @@ public:
 					size_t deactivate_time_msec				//!< deactivate_time_msec is interval in milliseconds (minimum 100 msec) 
 															//!< after that all unused threads returned to the pool will be closed
 					);
+	//! \brief creates terimber executor object
+	//! caller is responsible for destroying it
+	terimber_executor* 
+	get_executor(	terimber_log* log,						//!< logging pointer
+					size_t workers							//!< number of worker threads, zero means number of processors
+					);
 };
 
 
@@ -19,7 +19,7 @@ filememmapper::~filememmapper()
 }
 
 bool 
-filememmapper::memmapfile(const char* name)
+filememmapper::memmapfile(const char* name, bool copy_on_write)
 {
 	memunmapfile();
 
@@ -28,8 +28,8 @@ filememmapper::memmapfile(const char* name)
 
 #if OS_TYPE == OS_WIN32
 	if (INVALID_HANDLE_VALUE == (_fdesc = ::CreateFile(name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, 0, 0))
-		|| !(_mapinfo = ::CreateFileMapping(_fdesc, 0, PAGE_READONLY, 0, 0, 0))
-		|| !(_addr = ::MapViewOfFile(_mapinfo, FILE_MAP_READ, 0, 0, 0))
+		|| !(_mapinfo = ::CreateFileMapping(_fdesc, 0, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, 0))
+		|| !(_addr = ::MapViewOfFile(_mapinfo, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0))
 		) 
 	{
 		memunmapfile();
@@ -44,9 +44,13 @@ filememmapper::memmapfile(const char* name)
 
 	if (-1 == (_fdesc = open (name, O_RDONLY, 0))
 		|| -1 == (ret = fstat(_fdesc, &sb))
-		|| !(_addr = mmap(0, (int)(_mapinfo = (void*)sb.st_size), PROT_READ, MAP_SHARED, _fdesc, 0))
+		|| MAP_FAILED == (_addr = mmap(0, (size_t)(_mapinfo = (void*)(size_t)sb.st_size), 
+								copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ, 
+								copy_on_write ? MAP_PRIVATE : MAP_SHARED, _fdesc, 0))
 		) 
 	{
+		if (MAP_FAILED == _addr)
+			_addr = 0;
 		memunmapfile();
 		return false;
 	}
@@ -69,7 +73,7 @@ filememmapper::memunmapfile()
 		::CloseHandle(_fdesc), _fdesc = 0;
 #else
 	if (_addr)
-		munmap(_addr, (int)_mapinfo), _addr = 0, _mapinfo = 0;
+		munmap(_addr, (size_t)_mapinfo), _addr = 0, _mapinfo = 0;
 	if (_fdesc)
 		close(_fdesc), _fdesc = 0;
 #endif
@@ -111,6 +115,7 @@ filememmapper::touch()
 			// sure that the compiler does not optimize this line out.
 
 			volatile unsigned char dummy = *(((unsigned char*)_addr) + n * page);
+			(void)dummy;
 		}
 	}
 }
@@ -9,7 +9,8 @@ public:
 	filememmapper();
 	~filememmapper();
 
-	bool memmapfile(const char* name);
+	// copy_on_write maps private writable pages, changes never reach the file
+	bool memmapfile(const char* name, bool copy_on_write = false);
 	void memunmapfile();
 	void touch();
 	void* getaddress() const;
@@ -9,6 +9,8 @@
 #include "allinc.h"
 #include "aiomsg/aiomsgfactory.h"
 #include "aiomsg/msg_comm.h"
+#include "threadpool/thread.h"
+#include "base/date.h"
 
 #include "base/list.hpp"
 #include "base/string.hpp"
@@ -309,3 +311,206 @@ const guid_t gclient2 = {0x757b8924, 0xe6e4, 0x4f53, {0xbd, 0x68, 0x29, 0xd0, 0x
 
 	return 0;
 }
+
+const size_t QUEUE_BENCH_MAX_PAIRS = 8;
+const size_t QUEUE_BENCH_MSGS = 256;
+const size_t QUEUE_BENCH_OPS = 1024 * 1024;
+
+static sb8_t queue_bench_msec()
+{
+	TERIMBER::date now;
+	return (sb8_t)now;
+}
+
+// exposes protected methods of msg_queue and msg_ring_queue
+template < class Q >
+class bench_queue : public Q
+{
+public:
+	bool push(TERIMBER::msg_cpp* item)
+	{
+		try
+		{
+			Q::push(item);
+			return true;
+		}
+		catch (TERIMBER::exception&)
+		{
+			return false;
+		}
+	}
+	bool pop(TERIMBER::msg_cpp*& item) { return Q::pop(item); }
+protected:
+	virtual void wakeup() {}
+};
+
+// default queue, one mutex over the priority lists
+class locked_bench_queue : public bench_queue< TERIMBER::msg_queue< 3 > >
+{
+public:
+	static const char* name() { return "mutex + lists"; }
+};
+
+// lock-free rings, the default, USE_MSG_MUTEX switches to the mutex queue
+class ring_bench_queue : public bench_queue< TERIMBER::msg_ring_queue< 3 > >
+{
+public:
+	static const char* name() { return "lock-free rings"; }
+};
+
+// even idents are producers, odd idents are consumers
+template < class Q >
+class queue_bench_client : public terimber_thread_employer
+{
+public:
+	queue_bench_client(size_t pairs) : _pairs(pairs), _popped(0), _full(0), _errors(0)
+	{
+		for (size_t index = 0; index < pairs * 2; ++index)
+			_done[index] = false;
+
+		for (size_t index = 0; index < pairs * QUEUE_BENCH_MSGS; ++index)
+		{
+			_msgs[index] = TERIMBER::msg_cpp::construct(&_allocator, 0);
+			_msgs[index]->msgid = (ub4_t)(index / QUEUE_BENCH_MSGS);
+			_msgs[index]->priority = (ub4_t)(index % 3);
+		}
+	}
+
+	virtual bool v_has_job(size_t ident, void* data)
+	{
+		return !_done[ident];
+	}
+
+	virtual void v_do_job(size_t ident, void* data)
+	{
+		size_t pair = ident / 2, full = 0, popped = 0, errors = 0;
+		if (ident % 2 == 0)
+		{
+			TERIMBER::msg_cpp** msgs = _msgs + pair * QUEUE_BENCH_MSGS;
+			for (size_t op = 0; op < QUEUE_BENCH_OPS; ++op)
+			{
+				while (!_queue.push(msgs[op % QUEUE_BENCH_MSGS]))
+				{
+					++full;
+					sched_yield_bench();
+				}
+			}
+		}
+		else
+		{
+			TERIMBER::msg_cpp* item = 0;
+			for (;;)
+			{
+				if (_queue.pop(item))
+				{
+					if (item->msgid >= _pairs)
+						++errors;
+					++popped;
+				}
+				else if (producers_done())
+				{
+					// drains the rest
+					while (_queue.pop(item))
+						++popped;
+					break;
+				}
+				else
+					sched_yield_bench();
+			}
+		}
+
+		TERIMBER::mutexKeeper keeper(_mtx);
+		_popped += popped;
+		_full += full;
+		_errors += errors;
+		_done[ident] = true;
+	}
+
+	bool done()
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		for (size_t index = 0; index < _pairs * 2; ++index)
+			if (!_done[index])
+				return false;
+		return true;
+	}
+
+	size_t popped() { TERIMBER::mutexKeeper keeper(_mtx); return _popped; }
+	size_t full() { TERIMBER::mutexKeeper keeper(_mtx); return _full; }
+	size_t errors() { TERIMBER::mutexKeeper keeper(_mtx); return _errors; }
+
+private:
+	bool producers_done()
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		for (size_t index = 0; index < _pairs * 2; index += 2)
+			if (!_done[index])
+				return false;
+		return true;
+	}
+
+	static void sched_yield_bench()
+	{
+#if OS_TYPE == OS_WIN32
+		::Sleep(0);
+#else
+		sched_yield();
+#endif
+	}
+
+private:
+	Q						_queue;
+	size_t					_pairs;
+	size_t					_popped;
+	size_t					_full;
+	size_t					_errors;
+	volatile bool			_done[QUEUE_BENCH_MAX_PAIRS * 2];
+	TERIMBER::msg_cpp*		_msgs[QUEUE_BENCH_MAX_PAIRS * QUEUE_BENCH_MSGS];
+	TERIMBER::byte_allocator	_allocator;
+	TERIMBER::mutex			_mtx;
+};
+
+template < class Q >
+static void msgqueue_benchmark_run(size_t wait, size_t pairs)
+{
+	queue_bench_client< Q >* client = new queue_bench_client< Q >(pairs);
+	TERIMBER::thread workers[QUEUE_BENCH_MAX_PAIRS * 2];
+
+	sb8_t start = queue_bench_msec();
+	for (size_t index = 0; index < pairs * 2; ++index)
+	{
+		TERIMBER::job_task task(client, index, INFINITE, 0);
+		workers[index].start();
+		workers[index].assign_job(task);
+	}
+
+	TERIMBER::event ev;
+	sb8_t deadline = start + wait * 1000;
+	while (!client->done() && queue_bench_msec() < deadline)
+		ev.wait(1);
+
+	sb8_t elapsed = __max(queue_bench_msec() - start, (sb8_t)1);
+	size_t popped = client->popped();
+	printf("msg queue benchmark (%s) threads %d: %d msgs/msec, popped %d of %d, full %d, errors %d\n", 
+		Q::name(), (int)(pairs * 2), (int)((sb8_t)popped / elapsed), (int)popped, (int)(pairs * QUEUE_BENCH_OPS), 
+		(int)client->full(), (int)(client->errors() + pairs * QUEUE_BENCH_OPS - popped));
+
+	for (size_t index = 0; index < pairs * 2; ++index)
+	{
+		workers[index].cancel_job();
+		workers[index].stop();
+	}
+
+	delete client;
+}
+
+int msgqueue_benchmark(size_t wait, terimber_log* log)
+{
+	for (size_t pairs = 1; pairs <= QUEUE_BENCH_MAX_PAIRS; pairs *= 2)
+	{
+		msgqueue_benchmark_run< locked_bench_queue >(wait, pairs);
+		msgqueue_benchmark_run< ring_bench_queue >(wait, pairs);
+	}
+
+	return 0;
+}
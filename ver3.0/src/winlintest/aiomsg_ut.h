@@ -2,6 +2,7 @@
 #define _terimber_aiomsg_ut_h_
 
 int aiomsg_unittest(size_t wait, terimber_log* log);
+int msgqueue_benchmark(size_t wait, terimber_log* log);
 
 #endif
 
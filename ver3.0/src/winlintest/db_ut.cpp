@@ -0,0 +1,364 @@
+#include "allinc.h"
+#include "db/db.h"
+#include "base/date.h"
+#include "dbstub_ut.h"
+#include <string>
+#include <vector>
+
+const size_t DB_TEST_ROWS = 100;
+const size_t DB_BENCH_ROWS = 256 * 1024;
+const size_t DB_BENCH_BATCH = 1024;
+
+static sb8_t db_bench_msec()
+{
+	TERIMBER::date now;
+	return (sb8_t)now;
+}
+
+static int db_test_error(const char* test, const char* what)
+{
+	printf("db test (%s) failed: %s\n", test, what);
+	return -1;
+}
+
+static const db_stub_column db_test_columns[4] =
+{
+	{ db_sb4, "id", 0, false },
+	{ db_string, "name", 32, true },
+	{ db_double, "amount", 0, true },
+	{ db_bool, "flag", 0, true }
+};
+
+// expected name of row, every fourth is null, the length goes from 0 to 16
+static bool db_test_name(size_t index, std::string& name)
+{
+	if (index % 4 == 3)
+		return false;
+
+	name.assign(index % 17, (char)('a' + index % 26));
+	return true;
+}
+
+// rows with ids from 0, nulls in name, amount and flag
+static void db_test_source(db_stub_server& server, size_t rows)
+{
+	char id[32], amount[32];
+	std::string name;
+	const char* values[4] = { id, 0, amount, 0 };
+	server.clear_rows();
+	for (size_t index = 0; index < rows; ++index)
+	{
+		sprintf(id, "%d", (int)index);
+		sprintf(amount, "%.2f", index * 0.25);
+		values[1] = db_test_name(index, name) ? name.c_str() : 0;
+		values[2] = index % 5 == 4 ? 0 : amount;
+		values[3] = index % 7 == 6 ? 0 : (index % 2 ? "1" : "0");
+		server.add_row(values);
+	}
+}
+
+// caller column vectors of the batch fetch
+class db_test_batch
+{
+public:
+	db_test_batch(size_t rows, size_t heap_size) :
+		_ids(rows), _amounts(rows), _offsets(rows + 1), _heap(heap_size + 1)
+	{
+		_flags = new bool[rows];
+		_nulls = new bool[rows * 4];
+		memset(_columns, 0, sizeof(_columns));
+		_columns[0].values = &_ids[0];
+		_columns[1].offsets = &_offsets[0];
+		_columns[1].heap = &_heap[0];
+		_columns[1].heap_size = heap_size;
+		_columns[2].values = &_amounts[0];
+		_columns[3].values = _flags;
+		for (size_t index = 0; index < 4; ++index)
+			_columns[index].nulls = _nulls + index * rows;
+	}
+
+	~db_test_batch()
+	{
+		delete [] _flags;
+		delete [] _nulls;
+	}
+
+	// checks the batch row against the source row
+	bool check(size_t row, size_t index) const
+	{
+		std::string name;
+		bool has_name = db_test_name(index, name);
+		if (_columns[0].nulls[row] || _ids[row] != (sb4_t)index
+			|| _columns[1].nulls[row] == has_name
+			|| _offsets[row + 1] - _offsets[row] != (has_name ? name.size() : 0)
+			|| (has_name && memcmp(&_heap[_offsets[row]], name.c_str(), name.size())))
+			return false;
+
+		if (index % 5 == 4 ? !_columns[2].nulls[row] : (_columns[2].nulls[row] || _amounts[row] != index * 0.25))
+			return false;
+
+		return index % 7 == 6 ? _columns[3].nulls[row] : (!_columns[3].nulls[row] && _flags[row] == (index % 2 != 0));
+	}
+
+	terimber_db_column		_columns[4];
+	std::vector< sb4_t >	_ids;
+	std::vector< double >	_amounts;
+	std::vector< size_t >	_offsets;
+	std::vector< ub1_t >	_heap;
+	bool*					_flags;
+	bool*					_nulls;
+};
+
+// the name heap bytes of rows from first
+static size_t db_test_heap(size_t first, size_t rows)
+{
+	size_t bytes = 0;
+	std::string name;
+	for (size_t index = first; index < first + rows; ++index)
+		if (db_test_name(index, name))
+			bytes += name.size();
+
+	return bytes;
+}
+
+// reads recordset by batches of max_rows with the name heap of heap_size bytes
+// the stub block is fixed or follows the fetch rows if block is 0
+static int db_test_batches(size_t block, size_t fetch_rows, size_t max_rows, size_t heap_size)
+{
+	char test[128];
+	sprintf(test, "batch, block %d, fetch rows %d, max rows %d, heap %d", (int)block, (int)fetch_rows, (int)max_rows, (int)heap_size);
+
+	db_stub_server server(4, db_test_columns, block);
+	db_test_source(server, DB_TEST_ROWS);
+	if (!server.connect(false, "stub") || !server.set_fetch_rows(fetch_rows) || !server.open_sql(false, "select"))
+		return db_test_error(test, server.get_error());
+
+	db_test_batch batch(max_rows, heap_size);
+	size_t total = 0, rows = 0;
+	do
+	{
+		// fills the vectors with garbage, offsets must start from 0 anyway
+		batch._offsets[0] = 12345;
+		if (!server.fetch_batch(max_rows, batch._columns, rows))
+			return db_test_error(test, server.get_error());
+
+		if (rows > max_rows || batch._offsets[0] != 0)
+			return db_test_error(test, "wrong batch size");
+
+		for (size_t row = 0; row < rows; ++row)
+			if (!batch.check(row, total + row))
+				return db_test_error(test, "wrong batch row");
+
+		// the batch stops only at the end, at max rows or if the next name does not fit
+		if (rows && rows < max_rows && total + rows < DB_TEST_ROWS
+			&& db_test_heap(total, rows + 1) <= heap_size)
+			return db_test_error(test, "batch stopped early");
+
+		total += rows;
+	}
+	while (rows);
+
+	if (total != DB_TEST_ROWS)
+		return db_test_error(test, "wrong row count");
+
+	// the end is kept until the query is closed
+	if (!server.fetch_batch(max_rows, batch._columns, rows) || rows)
+		return db_test_error(test, "rows after the end");
+
+	// blocks of the stub are the array fetch round trips
+	size_t block_rows = block ? block : fetch_rows;
+	if (block_rows && server.get_blocks() != (DB_TEST_ROWS + block_rows - 1) / block_rows)
+		return db_test_error(test, "wrong block count");
+
+	server.close_sql();
+	return 0;
+}
+
+// the row that does not fit into the empty heap is an error, the rows before are returned
+static int db_test_small_heap()
+{
+	const char* test = "small heap";
+	db_stub_server server(4, db_test_columns, 8);
+	db_test_source(server, DB_TEST_ROWS);
+	if (!server.connect(false, "stub") || !server.open_sql(false, "select"))
+		return db_test_error(test, server.get_error());
+
+	// names of rows 0..9 take 0..9 bytes, row 10 takes 10 bytes
+	db_test_batch batch(32, 9);
+	size_t total = 0, rows = 0;
+	while (server.fetch_batch(32, batch._columns, rows) && rows)
+	{
+		for (size_t row = 0; row < rows; ++row)
+			if (!batch.check(row, total + row))
+				return db_test_error(test, "wrong batch row");
+
+		total += rows;
+	}
+
+	if (rows || total != 10 || !server.get_error() || !strstr(server.get_error(), "Batch heap is too small"))
+		return db_test_error(test, "heap overflow is not reported");
+
+	server.close_sql();
+	return 0;
+}
+
+// rows fetched by fetch_data are not returned by fetch_batch
+static int db_test_after_fetch()
+{
+	const char* test = "fetch data, then batch";
+	db_stub_server server(4, db_test_columns, 16);
+	db_test_source(server, DB_TEST_ROWS);
+	if (!server.connect(false, "stub") || !server.open_sql(false, "select")
+		|| !server.fetch_data(false, 0, 5, true))
+		return db_test_error(test, server.get_error());
+
+	size_t count = 0;
+	for (server.reset(); server.next(); ++count)
+		if (server.get_value_as_long(0) != (sb4_t)count)
+			return db_test_error(test, "wrong fetched row");
+
+	if (count != 5)
+		return db_test_error(test, "wrong fetched row count");
+
+	db_test_batch batch(DB_TEST_ROWS, 1024);
+	size_t rows = 0;
+	if (!server.fetch_batch(DB_TEST_ROWS, batch._columns, rows))
+		return db_test_error(test, server.get_error());
+
+	if (rows != DB_TEST_ROWS - count)
+		return db_test_error(test, "wrong batch row count");
+
+	for (size_t row = 0; row < rows; ++row)
+		if (!batch.check(row, count + row))
+			return db_test_error(test, "wrong batch row");
+
+	server.close_sql();
+	return 0;
+}
+
+// invalid vectors and empty recordset
+static int db_test_batch_args()
+{
+	const char* test = "batch arguments";
+	db_stub_server server(4, db_test_columns, 16);
+	db_test_source(server, 0);
+	if (!server.connect(false, "stub") || !server.open_sql(false, "select"))
+		return db_test_error(test, server.get_error());
+
+	db_test_batch batch(8, 64);
+	size_t rows = 1;
+	if (!server.fetch_batch(8, batch._columns, rows) || rows)
+		return db_test_error(test, "rows in empty recordset");
+
+	server.close_sql();
+	if (!server.open_sql(false, "select"))
+		return db_test_error(test, server.get_error());
+
+	// the name column has no heap
+	batch._columns[1].heap = 0;
+	if (server.fetch_batch(8, batch._columns, rows) || !server.get_error())
+		return db_test_error(test, "column without heap is accepted");
+
+	// fixed width column has no values
+	batch._columns[1].heap = &batch._heap[0];
+	batch._columns[0].values = 0;
+	if (server.fetch_batch(8, batch._columns, rows))
+		return db_test_error(test, "column without values is accepted");
+
+	server.close_sql();
+
+	// the batch fetch does not open query
+	if (server.fetch_batch(8, batch._columns, rows))
+		return db_test_error(test, "closed query is fetched");
+
+	return 0;
+}
+
+int db_unittest(size_t wait, terimber_log* log)
+{
+	int res = 0;
+
+	// block boundaries inside, at and across the batches
+	res |= db_test_batches(7, 0, 10, 1024);
+	res |= db_test_batches(10, 0, 10, 1024);
+	res |= db_test_batches(1, 0, 3, 1024);
+	res |= db_test_batches(64, 0, 5, 1024);
+	res |= db_test_batches(200, 0, DB_TEST_ROWS * 2, 1024);
+
+	// the block follows the rows per round trip
+	res |= db_test_batches(0, 9, 20, 1024);
+	res |= db_test_batches(0, 1, 20, 1024);
+
+	// variable width column fills the heap before max rows
+	res |= db_test_batches(7, 0, 10, 40);
+	res |= db_test_batches(0, 13, 50, 16);
+
+	res |= db_test_small_heap();
+	res |= db_test_after_fetch();
+	res |= db_test_batch_args();
+	return res;
+}
+
+// fetch_data with values read one by one against fetch_batch into the column vectors
+int db_benchmark(size_t wait, terimber_log* log)
+{
+	db_stub_server server(4, db_test_columns, 0);
+	db_test_source(server, DB_BENCH_ROWS);
+	if (!server.connect(false, "stub"))
+	{
+		printf("db benchmark: can not connect: %s\n", server.get_error());
+		return -1;
+	}
+
+	double checksum = 0;
+	sb8_t start = db_bench_msec();
+	if (!server.open_sql(false, "select"))
+	{
+		printf("db benchmark: can not open query: %s\n", server.get_error());
+		return -1;
+	}
+
+	size_t rows = 0;
+	while (server.fetch_data(false, 0, DB_BENCH_BATCH, true) && server.get_row_count())
+	{
+		for (server.reset(); server.next(); ++rows)
+		{
+			checksum += server.get_value_as_long(0);
+			if (!server.get_value_is_null(1))
+				checksum += strlen(server.get_value_as_string(1));
+			if (!server.get_value_is_null(2))
+				checksum += server.get_value_as_double(2);
+		}
+	}
+
+	server.close_sql();
+	sb8_t fetched = db_bench_msec();
+
+	if (!server.open_sql(false, "select"))
+	{
+		printf("db benchmark: can not open query: %s\n", server.get_error());
+		return -1;
+	}
+
+	db_test_batch batch(DB_BENCH_BATCH, DB_BENCH_BATCH * 32);
+	size_t batch_rows = 0, count = 0;
+	while (server.fetch_batch(DB_BENCH_BATCH, batch._columns, count) && count)
+	{
+		for (size_t row = 0; row < count; ++row)
+		{
+			checksum -= batch._ids[row];
+			checksum -= batch._offsets[row + 1] - batch._offsets[row];
+			if (!batch._columns[2].nulls[row])
+				checksum -= batch._amounts[row];
+		}
+
+		batch_rows += count;
+	}
+
+	server.close_sql();
+	sb8_t batched = db_bench_msec();
+
+	printf("db benchmark rows %d: fetch data %d msec, fetch batch %d msec (%d rows), checksum %.0f\n",
+		(int)rows, (int)(fetched - start), (int)(batched - fetched), (int)batch_rows, checksum);
+	return rows == DB_BENCH_ROWS && batch_rows == DB_BENCH_ROWS && checksum == 0 ? 0 : -1;
+}
@@ -0,0 +1,7 @@
+#ifndef _terimber_db_ut_h_
+#define _terimber_db_ut_h_
+
+int db_unittest(size_t wait, terimber_log* log);
+int db_benchmark(size_t wait, terimber_log* log);
+
+#endif
@@ -1,7 +1,32 @@
 #include "allinc.h"
 #include "dbmysql/termysql.h"
+#include "dbmysql/mysqlsrv.h"
+#include "db/dbpool.hpp"
+#include "base/date.h"
 #include <stdio.h>
 
+const size_t DBMYSQL_BENCH_ROWS = 1000000;
+const size_t DBMYSQL_BENCH_BULK = 1000; // param_bulk_store keeps up to 1024 rows
+const size_t DBMYSQL_BENCH_SINGLE_ROWS = 20000; // row by row is measured on a smaller set
+const size_t DBMYSQL_BENCH_REQUESTS = 2000;
+
+static sb8_t dbmysql_bench_msec()
+{
+	TERIMBER::date now;
+	return (sb8_t)now;
+}
+
+static const char* dbmysql_bench_insert = "insert into terimber_bulk_bench (id, amount, name) values (:id, :amount, :name)";
+
+static bool dbmysql_bench_params(dbserver* server, size_t row)
+{
+	char name[32];
+	int len = sprintf(name, "name %d", (int)row);
+	return server->set_param_as_long(0, db_param_in, (sb4_t)row)
+		&& server->set_param_as_double(1, db_param_in, row * 0.01)
+		&& server->set_param_as_string(2, db_param_in, name, len);
+}
+
 int dbmysql_unittest(const char* login, size_t wait, terimber_log* log)
 {
 	mysql_factory factory;
@@ -27,3 +52,153 @@ int dbmysql_unittest(const char* login, size_t wait, terimber_log* log)
 
 	return 0;
 }
+
+// compares row by row inserts with bulk inserts
+// the bulk insert is sent as the multi-row values statement
+int dbmysql_benchmark(const char* login, size_t wait, terimber_log* log)
+{
+	mysql_factory factory;
+	dbserver* server = factory.get_dbserver(0);
+
+	//	UID=;PWD=;HOST=;PORT=;DB=;
+	if (!server->connect(false, login ? login : "UID=root;PWD=;HOST=localhost;DB=test"))
+	{
+		printf("mysql benchmark: can not connect: %s\n", server->get_error());
+		delete server;
+		return -1;
+	}
+
+	server->exec_sql(false, "drop table if exists terimber_bulk_bench");
+	server->close_sql();
+
+	if (!server->exec_sql(false, "create table terimber_bulk_bench (id int not null primary key, amount double, name varchar(32)) engine=InnoDB"))
+	{
+		printf("mysql benchmark: can not create table: %s\n", server->get_error());
+		server->disconnect();
+		delete server;
+		return -1;
+	}
+
+	server->close_sql();
+	server->resize_params(3);
+
+	size_t errors = 0;
+
+	// one round trip per row
+	sb8_t start = dbmysql_bench_msec();
+	server->start_transaction();
+	for (size_t row = 0; row < DBMYSQL_BENCH_SINGLE_ROWS; ++row)
+	{
+		if (!dbmysql_bench_params(server, row)
+			|| !server->exec_sql(false, dbmysql_bench_insert))
+			++errors;
+
+		server->close_sql();
+	}
+	server->commit();
+	sb8_t single = dbmysql_bench_msec() - start;
+
+	// bulk rows per round trip
+	start = dbmysql_bench_msec();
+	server->start_transaction();
+	for (size_t row = DBMYSQL_BENCH_SINGLE_ROWS; row < DBMYSQL_BENCH_SINGLE_ROWS + DBMYSQL_BENCH_ROWS;)
+	{
+		for (size_t index = 0; index < DBMYSQL_BENCH_BULK; ++index, ++row)
+		{
+			if (!dbmysql_bench_params(server, row) || !server->param_bulk_store())
+				++errors;
+		}
+
+		if (!server->exec_sql(false, dbmysql_bench_insert))
+			++errors;
+
+		server->close_sql();
+		server->param_bulk_remove_all();
+	}
+	server->commit();
+	sb8_t bulk = dbmysql_bench_msec() - start;
+
+	printf("mysql benchmark: row by row %d rows %d msec (%d rows/msec), bulk %d rows %d msec (%d rows/msec), %d round trips, errors %d\n",
+		(int)DBMYSQL_BENCH_SINGLE_ROWS, (int)single, (int)(DBMYSQL_BENCH_SINGLE_ROWS / (single ? single : 1)),
+		(int)DBMYSQL_BENCH_ROWS, (int)bulk, (int)(DBMYSQL_BENCH_ROWS / (bulk ? bulk : 1)),
+		(int)(DBMYSQL_BENCH_ROWS / DBMYSQL_BENCH_BULK), (int)errors);
+
+	server->exec_sql(false, "drop table terimber_bulk_bench");
+	server->close_sql();
+	server->disconnect();
+
+	delete server;
+
+	return errors ? -1 : 0;
+}
+
+// runs one short request on the connected server
+static bool dbmysql_bench_request(dbserver* server, size_t request)
+{
+	bool res = server->set_param_as_long(0, db_param_in, (sb4_t)request)
+		&& server->open_sql(false, "select :id + 1")
+		&& server->fetch_data(false, 0, 1, true)
+		&& server->next();
+
+	server->close_sql();
+	return res;
+}
+
+// compares connect and prepare per request with pooled connections
+// pooled connections keep the prepared statement between requests
+int dbmysql_pool_benchmark(const char* login, size_t wait, terimber_log* log)
+{
+	const char* login_string = login ? login : "UID=root;PWD=;HOST=localhost;DB=test";
+	mysql_factory factory;
+	size_t errors = 0;
+
+	// connects for each request
+	sb8_t start = dbmysql_bench_msec();
+	for (size_t request = 0; request < DBMYSQL_BENCH_REQUESTS; ++request)
+	{
+		dbserver* server = factory.get_dbserver(0);
+		if (!server->connect(false, login_string))
+		{
+			printf("mysql pool benchmark: can not connect: %s\n", server->get_error());
+			delete server;
+			return -1;
+		}
+
+		server->resize_params(1);
+		if (!dbmysql_bench_request(server, request))
+			++errors;
+
+		server->disconnect();
+		delete server;
+	}
+	sb8_t single = dbmysql_bench_msec() - start;
+
+	// loans connections from pool
+	start = dbmysql_bench_msec();
+	{
+		TERIMBER::db_arg arg(0, false, login_string);
+		TERIMBER::dbserver_pool< TERIMBER::mysql_db_creator > pool(arg, 2, 8, 60000, 5000, 16);
+
+		for (size_t request = 0; request < DBMYSQL_BENCH_REQUESTS; ++request)
+		{
+			dbserver* server = pool.loan(1000);
+			if (!server)
+			{
+				++errors;
+				continue;
+			}
+
+			server->resize_params(1);
+			if (!dbmysql_bench_request(server, request))
+				++errors;
+
+			pool.give_back(server);
+		}
+	}
+	sb8_t pooled = dbmysql_bench_msec() - start;
+
+	printf("mysql pool benchmark: %d requests, connect per request %d msec, pooled %d msec, errors %d\n",
+		(int)DBMYSQL_BENCH_REQUESTS, (int)single, (int)pooled, (int)errors);
+
+	return errors ? -1 : 0;
+}
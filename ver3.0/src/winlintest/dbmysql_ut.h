@@ -2,6 +2,8 @@
 #define _terimber_dbmysql_ut_h_
 
 int dbmysql_unittest(const char* login, size_t wait, terimber_log* log);
+int dbmysql_benchmark(const char* login, size_t wait, terimber_log* log);
+int dbmysql_pool_benchmark(const char* login, size_t wait, terimber_log* log);
 
 #endif
 
@@ -0,0 +1,183 @@
+#ifndef _terimber_dbstub_ut_h_
+#define _terimber_dbstub_ut_h_
+
+#include "db/db.h"
+#include "base/vector.hpp"
+#include "base/list.hpp"
+#include "base/string.hpp"
+#include "base/memory.hpp"
+#include "base/common.hpp"
+#include <string>
+#include <vector>
+
+// column of stub recordset, native type is the terimber type
+struct db_stub_column
+{
+	dbtypes			_type;
+	const char*		_name;
+	size_t			_max_length;
+	bool			_nullable;
+};
+
+// dbserver over rows kept in memory, no database client is needed
+// values are stored as text and converted on fetch, 0 - null
+// fetch_batch gets rows by blocks of the fixed size like array fetch of real clients
+// block 0 takes the rows per round trip defined by set_fetch_rows or estimated by dbserver
+class db_stub_server : public TERIMBER::dbserver_impl
+{
+public:
+	db_stub_server(size_t columns, const db_stub_column* desc, size_t block) :
+		TERIMBER::dbserver_impl(0), _desc(desc, desc + columns), _block(block), _pos(0), _first(0), _blocks(0)
+	{
+	}
+
+	virtual ~db_stub_server()
+	{
+		if (_is_open_sql())
+			close_sql();
+
+		if (_is_connect())
+			disconnect();
+	}
+
+	// appends row, values are in column order
+	void add_row(const char* const* values)
+	{
+		std::vector< std::string > row(_desc.size());
+		std::vector< bool > nulls(_desc.size());
+		for (size_t index = 0; index < _desc.size(); ++index)
+			if (!(nulls[index] = !values[index]))
+				row[index] = values[index];
+
+		_rows.push_back(row);
+		_nulls.push_back(nulls);
+	}
+
+	// removes all rows, the next query sees the new ones
+	void clear_rows()
+	{
+		_rows.clear();
+		_nulls.clear();
+	}
+
+	// number of blocks fetched by fetch_batch
+	size_t get_blocks() const { return _blocks; }
+
+protected:
+	virtual void v_connect(bool trusted_connection, const char* connection_string) {}
+	virtual void v_disconnect() {}
+	virtual void v_start_transaction() {}
+	virtual void v_commit() {}
+	virtual void v_rollback() {}
+	virtual bool v_is_connect_alive() { return true; }
+
+	virtual void v_before_execute() {}
+	virtual void v_after_execute() {}
+	virtual void v_execute() { _pos = 0; _first = 0; _blocks = 0; }
+	virtual void v_close() {}
+
+	virtual void v_fetch()
+	{
+		if (_start_row != 0)
+			_pos = __min(_start_row, _rows.size());
+
+		size_t col_count = _cols.size();
+		size_t select_row = 0;
+		for (; _requested_rows && _pos < _rows.size(); ++select_row, --_requested_rows)
+		{
+			TERIMBER::_vector< terimber_db_value > val;
+			TERIMBER::recordset_list_t::iterator iter_val = _data.push_back(*_data_allocator, val);
+			if (iter_val == _data.end() || !iter_val->resize(*_data_allocator, col_count))
+				TERIMBER::exception::_throw("Not enough memory");
+
+			_first = _pos++;
+			for (size_t index = 0; index < col_count; ++index)
+				v_convert_one_value(0, index, (*iter_val)[index]);
+		}
+
+		_fetched_rows = select_row;
+	}
+
+	virtual void v_replace_quote() {}
+	virtual void v_bind_one_param(size_t index) {}
+	virtual void v_before_bind_columns() {}
+	virtual void v_bind_one_column(size_t index) {}
+	virtual size_t v_get_number_columns() { return _desc.size(); }
+
+	virtual void v_convert_one_value(size_t row, size_t col, terimber_db_value& val)
+	{
+		size_t pos = _first + row;
+		memset(&val, 0, sizeof(terimber_db_value));
+		if ((val.nullVal = _nulls[pos][col]))
+			return;
+
+		const std::string& text = _rows[pos][col];
+		switch (_desc[col]._type)
+		{
+			case db_bool:
+				val.val.boolVal = text == "1";
+				break;
+			case db_sb4:
+				val.val.lVal = atoi(text.c_str());
+				break;
+			case db_double:
+#ifdef OS_64BIT
+				val.val.dblVal = atof(text.c_str());
+#else
+				{
+					double* dummy = (double*)TERIMBER::check_pointer(_data_allocator->allocate(sizeof(double)));
+					*dummy = atof(text.c_str());
+					val.val.dblVal = dummy;
+				}
+#endif
+				break;
+			case db_string:
+				{
+					char* str = (char*)TERIMBER::check_pointer(_data_allocator->allocate(text.size() + 1));
+					memcpy(str, text.c_str(), text.size() + 1);
+					val.val.strVal = str;
+				}
+				break;
+			default:
+				TERIMBER::exception::_throw("Unsupported stub column type");
+		}
+	}
+
+	virtual void v_get_one_column_info(size_t index)
+	{
+		TERIMBER::binder& cur = _cols[index];
+		cur.set_name(_columns_allocator, _desc[index]._name);
+		cur._native_type = _desc[index]._type;
+		cur._max_length = _desc[index]._max_length;
+		cur._value.nullVal = _desc[index]._nullable;
+		cur._scale = 0;
+		cur._precision = 0;
+	}
+
+	virtual void v_form_sql_string() {}
+	virtual void v_rebind_one_param(size_t index) {}
+	virtual void v_interrupt_async() {}
+	virtual dbtypes v_native_type_to_client_type(size_t native_type) { return (dbtypes)native_type; }
+	virtual void v_release_statement(void* handle) {}
+
+	virtual size_t v_fetch_block()
+	{
+		size_t rows = __min(_block ? _block : _bulk_rows, _rows.size() - _pos);
+		_first = _pos;
+		_pos += rows;
+		if (rows)
+			++_blocks;
+		return rows;
+	}
+
+private:
+	std::vector< db_stub_column >				_desc;
+	std::vector< std::vector< std::string > >	_rows;
+	std::vector< std::vector< bool > >			_nulls;
+	size_t										_block;
+	size_t										_pos;
+	size_t										_first;
+	size_t										_blocks;
+};
+
+#endif
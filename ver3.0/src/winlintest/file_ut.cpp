@@ -170,3 +170,197 @@ int file_unittest(const char* name, size_t wait, terimber_log* log)
 	printf("reading is done with error code: %d\n", reader.err());
 	return 0;
 }
+
+const size_t BENCH_BLOCK_SIZE = 4096;
+const size_t BENCH_QUEUE_DEPTH = 32;
+const size_t BENCH_FILE_BLOCKS = 4096; // 16 MB
+const size_t BENCH_READ_OPS = 65536;
+
+// microseconds for per action latency
+static sb8_t bench_usec()
+{
+#if OS_TYPE == OS_WIN32
+	LARGE_INTEGER freq, counter;
+	::QueryPerformanceFrequency(&freq);
+	::QueryPerformanceCounter(&counter);
+	return (sb8_t)(counter.QuadPart * 1000000 / freq.QuadPart);
+#else
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return (sb8_t)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+// keeps BENCH_QUEUE_DEPTH actions in flight, each slot has own buffer
+class file_bench_callback : public terimber_aiofile_callback
+{
+public:
+	file_bench_callback(terimber_aiofile* port, size_t ops, bool readwrite) : 
+		_port(port), _handle(0), _ops(ops), _readwrite(readwrite), _issued(0), _completed(0), _errors(0), _start(0), _finish(0), _latency(0), _max_latency(0)
+	{
+		memset(_buf, 'x', sizeof(_buf));
+	}
+
+	virtual void v_on_error(size_t handle, int err, aiofile_type type, void* userdata)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		++_errors;
+		if (++_completed >= _ops)
+			_finish = bench_usec();
+	}
+
+	virtual void v_on_write(size_t handle, void* buf, size_t requested, size_t processed, void* userdata)
+	{
+		complete((size_t)userdata);
+	}
+
+	virtual void v_on_read(size_t handle, void* buf, size_t requested, size_t processed, void* userdata)
+	{
+		complete((size_t)userdata);
+	}
+
+	void begin(size_t handle)
+	{
+		_handle = handle;
+		_start = bench_usec();
+		for (size_t slot = 0; slot < BENCH_QUEUE_DEPTH; ++slot)
+		{
+			TERIMBER::mutexKeeper keeper(_mtx);
+			if (_issued >= _ops)
+				break;
+			size_t offset = next_offset();
+			keeper.unlock();
+			issue(slot, offset);
+		}
+	}
+
+	bool done()
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		return _completed >= _ops;
+	}
+
+	void report(const char* engine, const char* action)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		sb8_t elapsed = __max((_finish ? _finish : bench_usec()) - _start, (sb8_t)1);
+		printf("file benchmark (%s) %s: ops %d, errors %d, %d IOPS, latency avg %d usec, max %d usec\n",
+			engine, action, (int)_completed, (int)_errors, 
+			(int)((sb8_t)_completed * 1000000 / elapsed), 
+			(int)(_completed ? _latency / (sb8_t)_completed : 0), (int)_max_latency);
+	}
+
+	void* buffer() { return _buf; }
+	size_t buffer_size() const { return sizeof(_buf); }
+
+private:
+	// sequential writes, random reads
+	size_t next_offset()
+	{
+		size_t block = _readwrite ? (size_t)rand() % BENCH_FILE_BLOCKS : _issued;
+		++_issued;
+		return block * BENCH_BLOCK_SIZE;
+	}
+
+	void issue(size_t slot, size_t offset)
+	{
+		_started[slot] = bench_usec();
+		char* buf = _buf + slot * BENCH_BLOCK_SIZE;
+		if (_readwrite)
+			_port->read(_handle, offset, buf, BENCH_BLOCK_SIZE, INFINITE, (void*)slot);
+		else
+			_port->write(_handle, offset, buf, BENCH_BLOCK_SIZE, INFINITE, (void*)slot);
+	}
+
+	void complete(size_t slot)
+	{
+		sb8_t latency = bench_usec() - _started[slot];
+		TERIMBER::mutexKeeper keeper(_mtx);
+		if (++_completed >= _ops)
+			_finish = bench_usec();
+		_latency += latency;
+		if (latency > _max_latency)
+			_max_latency = latency;
+
+		if (_issued >= _ops)
+			return;
+
+		size_t offset = next_offset();
+		keeper.unlock();
+		issue(slot, offset);
+	}
+
+private:
+	terimber_aiofile*	_port;
+	size_t				_handle;
+	size_t				_ops;
+	bool				_readwrite;
+	size_t				_issued;
+	size_t				_completed;
+	size_t				_errors;
+	sb8_t				_start;
+	sb8_t				_finish;
+	sb8_t				_latency;
+	sb8_t				_max_latency;
+	sb8_t				_started[BENCH_QUEUE_DEPTH];
+	char				_buf[BENCH_BLOCK_SIZE * BENCH_QUEUE_DEPTH];
+	TERIMBER::mutex		_mtx;
+};
+
+static int file_benchmark_run(const char* name, size_t wait, terimber_log* log, bool readwrite, const char* engine, terimber_aiofile* afile)
+{
+	// callback keeps the slot buffers, allocates it from heap
+	file_bench_callback* bench = new file_bench_callback(afile, readwrite ? BENCH_READ_OPS : BENCH_FILE_BLOCKS, readwrite);
+	size_t handle = afile->open(name, readwrite, bench);
+	if (!handle)
+	{
+		printf("can not open file %s\n", name);
+		delete bench;
+		return -1;
+	}
+
+	// io_uring pins the slot buffers once
+	void* buf = bench->buffer();
+	size_t len = bench->buffer_size();
+	bool registered = afile->register_buffers(&buf, &len, 1);
+
+	bench->begin(handle);
+
+	TERIMBER::event ev;
+	size_t loops = wait * 10;
+	while (loops-- && !bench->done())
+		ev.wait(100);
+
+	bench->report(engine, readwrite ? (registered ? "random read, fixed buffers" : "random read") : (registered ? "write, fixed buffers" : "write"));
+	afile->close(handle);
+	afile->register_buffers(0, 0, 0);
+	delete bench;
+	return 0;
+}
+
+int file_benchmark(const char* name, size_t wait, terimber_log* log)
+{
+	terimber_aiofile_factory acc;
+	aiofile_engine engines[] = { AIOFILE_ENGINE_PORT, AIOFILE_ENGINE_URING };
+
+	for (size_t i = 0; i < sizeof(engines) / sizeof(engines[0]); ++i)
+	{
+		terimber_aiofile* afile = acc.get_aiofile(log, 3, 60000, engines[i]);
+		if (!afile)
+			return -1;
+
+		const char* engine = afile->engine() == AIOFILE_ENGINE_URING ? "io_uring" : "port";
+		if (engines[i] != afile->engine())
+		{
+			printf("file benchmark: engine %d is not available\n", (int)engines[i]);
+			delete afile;
+			continue;
+		}
+
+		file_benchmark_run(name, wait, log, false, engine, afile);
+		file_benchmark_run(name, wait, log, true, engine, afile);
+		delete afile;
+	}
+
+	return 0;
+}
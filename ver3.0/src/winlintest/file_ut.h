@@ -2,6 +2,7 @@
 #define _terimber_file_ut_h_
 
 int file_unittest(const char* name, size_t wait, terimber_log* log);
+int file_benchmark(const char* name, size_t wait, terimber_log* log);
 
 #endif
 
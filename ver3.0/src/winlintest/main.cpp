@@ -9,8 +9,11 @@
 #include "crypt_ut.h"
 #include "dbmysql_ut.h"
 #include "dborcl_ut.h"
-//#include "aiomsg_ut.h"
+#include "aiomsg_ut.h"
 #include "voice_ut.h"
+#include "memdb_ut.h"
+#include "db_ut.h"
+#include "xml_ut.h"
 #include "base/date.h"
 #include "base/primitives.h"
 #include "db/dbaccess.h"
@@ -122,8 +125,34 @@ int main()
 
 	printf("thread pool test started\n");
 	threadpool_unittest(wait, plog);
+	threadpool_benchmark(wait, plog);
+	allocator_benchmark(wait, plog);
 	printf("thread pool test completed\n");
 
+	printf("msg queue benchmark started\n");
+	msgqueue_benchmark(wait, plog);
+	printf("msg queue benchmark completed\n");
+
+	printf("db test started\n");
+	db_unittest(wait, plog);
+	printf("db test completed\n");
+
+	printf("db benchmark started\n");
+	db_benchmark(wait, plog);
+	printf("db benchmark completed\n");
+
+	printf("memdb test started\n");
+	memdb_unittest(wait, plog);
+	printf("memdb test completed\n");
+
+	printf("memdb benchmark started\n");
+	memdb_benchmark(wait, plog);
+	printf("memdb benchmark completed\n");
+
+	printf("xml test started\n");
+	xml_unittest(wait, plog);
+	printf("xml test completed\n");
+
 	printf("crypt test started\n");
 	crypt_unittest(wait, plog);
 	printf("crypt test completed\n");
@@ -141,11 +170,23 @@ int main()
 	printf("mysql test started\n");
 	dbmysql_unittest(0, wait, &log);
 	printf("mysql test completed\n");
+
+	printf("mysql benchmark started\n");
+	dbmysql_benchmark(0, wait, &log);
+	printf("mysql benchmark completed\n");
+
+	printf("mysql pool benchmark started\n");
+	dbmysql_pool_benchmark(0, wait, &log);
+	printf("mysql pool benchmark completed\n");
 */
 	printf("file test started\n");
 	file_unittest("./unittest.dat", wait, plog);
 	printf("file test completed\n");
 
+	printf("file benchmark started\n");
+	file_benchmark("./benchmark.dat", wait, plog);
+	printf("file benchmark completed\n");
+
    
 	printf("socket port test started\n");
 	socketport_unittest(wait, 0);
@@ -159,15 +200,27 @@ int main()
   printf("stargate test started\n");
 	stargate_unittest(wait, 0);
 	printf("stargate test completed\n");
+	printf("stargate benchmark started\n");
+	stargate_benchmark(wait, 0);
+	printf("stargate benchmark completed\n");
 	printf("socket port test started\n");
 	socketport_unittest(wait, 0);
 	printf("socket port test completed\n");
 
 
+	printf("socket echo benchmark started\n");
+	socketecho_benchmark(wait, 10000, 1, 0);
+	socketecho_benchmark(wait, 10000, 4, 0);
+	printf("socket echo benchmark completed\n");
+
 	printf("socket udp test started\n");
 	socketudp_unittest(wait, 0);
 	printf("socket udp test completed\n");
 
+	printf("socket udp benchmark started\n");
+	socketudp_benchmark(wait, 0);
+	printf("socket udp benchmark completed\n");
+
 	printf("thread keymaker test started\n");
 	keymaker_unittest(wait, plog);
 	printf("thread keymaker test completed\n");
@@ -0,0 +1,1538 @@
+#include "allinc.h"
+#include "memdb/memdb.h"
+#include "threadpool/thread.h"
+#include "base/date.h"
+#include "base/memory.hpp"
+#include "dbstub_ut.h"
+#include <string>
+
+const size_t MEMDB_BENCH_ROWS = 1024 * 1024;
+const size_t MEMDB_BENCH_LOOKUPS = 1024 * 1024;
+const size_t MEMDB_BENCH_SCANS = 8;
+const size_t MEMDB_BENCH_UPDATES = 50; // updates per msec of background writer
+
+static sb8_t memdb_bench_msec()
+{
+	TERIMBER::date now;
+	return (sb8_t)now;
+}
+
+// shuffled keys, so the index and rows are visited in random order
+static void memdb_bench_keys(sb4_t* keys, size_t count)
+{
+	for (size_t index = 0; index < count; ++index)
+		keys[index] = (sb4_t)index;
+
+	for (size_t index = count - 1; index > 0; --index)
+	{
+		size_t other = ((size_t)rand() * ((size_t)RAND_MAX + 1) + rand()) % (index + 1);
+		sb4_t tmp = keys[index];
+		keys[index] = keys[other];
+		keys[other] = tmp;
+	}
+}
+
+// random point lookups
+static size_t memdb_bench_lookups(terimber_memindex* idx, terimber_db_value_vector* key, const sb4_t* keys, sb8_t deadline, size_t& found, size_t& errors, double& sum)
+{
+	key->set_value_as_long(0, 0);
+	terimber_memlookup* lookup = idx->add_lookup(key);
+	size_t lookups = 0;
+	for (; lookups < MEMDB_BENCH_LOOKUPS; ++lookups)
+	{
+		sb4_t value = keys[(lookups * 7919) % MEMDB_BENCH_ROWS];
+		key->set_value_as_long(0, value);
+		if (!lookup->reset(key) || !lookup->next())
+		{
+			++errors;
+			continue;
+		}
+
+		if (lookup->get_value_as_long(0) != value)
+			++errors;
+
+		sum += lookup->get_value_as_double(2);
+		++found;
+
+		if ((lookups & 0xffff) == 0 && memdb_bench_msec() > deadline)
+			break;
+	}
+
+	idx->remove_lookup(lookup);
+	return lookups;
+}
+
+// background writer updates rows at the fixed rate while lookups go on
+class memdb_bench_writer : public terimber_thread_employer
+{
+public:
+	memdb_bench_writer(terimber_memindex* idx, terimber_db_value_vector* key, terimber_db_value_vector* row, const sb4_t* keys) :
+		_idx(idx), _key(key), _row(row), _keys(keys), _stop(false), _done(false), _updates(0), _errors(0)
+	{
+	}
+
+	virtual bool v_has_job(size_t ident, void* data)
+	{
+		return !_done;
+	}
+
+	virtual void v_do_job(size_t ident, void* data)
+	{
+		_key->set_value_as_long(0, 0);
+		terimber_memlookup* lookup = _idx->add_lookup(_key);
+		TERIMBER::event ev;
+		char name[32];
+		sb8_t start = memdb_bench_msec();
+		while (!_stop)
+		{
+			if (_updates >= (size_t)(memdb_bench_msec() - start) * MEMDB_BENCH_UPDATES)
+			{
+				ev.wait(1);
+				continue;
+			}
+
+			// the same values, so checksums of lookups stay the same
+			sb4_t value = _keys[(_updates * 104729) % MEMDB_BENCH_ROWS];
+			int len = sprintf(name, "name %d", (int)value);
+			_key->set_value_as_long(0, value);
+			_row->set_value_as_long(0, value);
+			_row->set_value_as_string(1, name, len);
+			_row->set_value_as_double(2, value * 0.5);
+			if (!lookup->reset(_key) || !lookup->next() || !lookup->update_row(_row))
+				++_errors;
+
+			++_updates;
+		}
+
+		_idx->remove_lookup(lookup);
+		_done = true;
+	}
+
+	void stop() { _stop = true; }
+	bool done() const { return _done; }
+	size_t updates() const { return _updates; }
+	size_t errors() const { return _errors; }
+
+private:
+	terimber_memindex*			_idx;
+	terimber_db_value_vector*	_key;
+	terimber_db_value_vector*	_row;
+	const sb4_t*				_keys;
+	volatile bool				_stop;
+	volatile bool				_done;
+	size_t						_updates;
+	size_t						_errors;
+};
+
+static int memdb_benchmark_run(size_t wait, terimber_log* log, TERIMBER::huge_page_provider* provider, bool columnar, const sb4_t* keys)
+{
+	TERIMBER::memtable table(provider, columnar);
+	table.log_on(log);
+
+	terimber_table_column_desc desc[3] =
+	{
+		{ db_sb4, "id", 0, 0, 0, false },
+		{ db_string, "name", 0, 0, 32, true },
+		{ db_double, "amount", 0, 0, 0, true }
+	};
+
+	if (!table.create(3, desc))
+	{
+		printf("memdb benchmark: can not create table: %s\n", table.get_last_error());
+		return -1;
+	}
+
+	// fills table
+	sb8_t start = memdb_bench_msec();
+	terimber_db_value_vector* row = table.allocate_db_values(3);
+	char name[32];
+	for (size_t index = 0; index < MEMDB_BENCH_ROWS; ++index)
+	{
+		int len = sprintf(name, "name %d", (int)keys[index]);
+		row->set_value_as_long(0, keys[index]);
+		row->set_value_as_string(1, name, len);
+		row->set_value_as_double(2, keys[index] * 0.5);
+		if (!table.insert_row(row))
+		{
+			printf("memdb benchmark: can not insert row: %s\n", table.get_last_error());
+			return -1;
+		}
+	}
+
+	sb8_t filled = memdb_bench_msec();
+	terimber_index_column_info info = { 0, true, false };
+	terimber_memindex* idx = table.add_index(1, &info);
+	if (!idx)
+	{
+		printf("memdb benchmark: can not create index: %s\n", table.get_last_error());
+		return -1;
+	}
+
+	sb8_t loaded = memdb_bench_msec();
+
+	terimber_db_value_vector* key = table.allocate_db_values(1);
+	size_t found = 0, errors = 0;
+	double sum = 0;
+	size_t lookups = memdb_bench_lookups(idx, key, keys, loaded + wait * 1000, found, errors, sum);
+
+	sb8_t finish = memdb_bench_msec();
+	printf("memdb benchmark (%s, %s) rows %d: load %d msec, index build %d msec, %d lookups/msec, found %d, errors %d, checksum %.0f\n",
+		provider ? "huge pages" : "heap", columnar ? "columns" : "rows", (int)MEMDB_BENCH_ROWS, (int)(filled - start), (int)(loaded - filled),
+		(int)((sb8_t)lookups / __max(finish - loaded, (sb8_t)1)), (int)found, (int)errors, sum);
+
+	// the same lookups on hash index
+	sb8_t hash_start = memdb_bench_msec();
+	terimber_memindex* hash_idx = table.add_index(1, &info, index_hash);
+	if (!hash_idx)
+	{
+		printf("memdb benchmark: can not create hash index: %s\n", table.get_last_error());
+		return -1;
+	}
+
+	sb8_t hash_loaded = memdb_bench_msec();
+	found = 0;
+	sum = 0;
+	lookups = memdb_bench_lookups(hash_idx, key, keys, hash_loaded + wait * 1000, found, errors, sum);
+	finish = memdb_bench_msec();
+	printf("memdb benchmark (%s, %s) hash index: build %d msec, %d lookups/msec, found %d, errors %d, checksum %.0f\n",
+		provider ? "huge pages" : "heap", columnar ? "columns" : "rows", (int)(hash_loaded - hash_start),
+		(int)((sb8_t)lookups / __max(finish - hash_loaded, (sb8_t)1)), (int)found, (int)errors, sum);
+	table.remove_index(hash_idx);
+
+	// full scans of one column in the table order
+	terimber_memindex* all = table.add_index(0, 0);
+	if (!all)
+	{
+		printf("memdb benchmark: can not create index: %s\n", table.get_last_error());
+		return -1;
+	}
+
+	terimber_memlookup* scan = all->add_lookup(0);
+	double total = 0;
+	size_t scanned = 0;
+	sb8_t scan_start = memdb_bench_msec();
+	for (size_t pass = 0; pass < MEMDB_BENCH_SCANS; ++pass)
+	{
+		while (scan->next())
+		{
+			total += scan->get_value_as_double(2);
+			++scanned;
+		}
+	}
+
+	sb8_t scan_finish = memdb_bench_msec();
+	if (scanned != MEMDB_BENCH_SCANS * MEMDB_BENCH_ROWS)
+		++errors;
+
+	printf("memdb benchmark (%s, %s) scan: %d rows/msec, checksum %.0f\n",
+		provider ? "huge pages" : "heap", columnar ? "columns" : "rows",
+		(int)((sb8_t)scanned / __max(scan_finish - scan_start, (sb8_t)1)), total);
+
+	all->remove_lookup(scan);
+	table.remove_index(all);
+
+	// the same scan straight over the column store arrays
+	if (columnar)
+	{
+		const TERIMBER::memdb_columns& columns = table.get_columns();
+		const TERIMBER::memdb_column& amount = columns.get_column(2);
+		const double* values = (const double*)amount.get_data();
+		const ub1_t* statuses = columns.get_statuses();
+		size_t rows = columns.get_row_count();
+		total = 0;
+		scanned = 0;
+		scan_start = memdb_bench_msec();
+		for (size_t pass = 0; pass < MEMDB_BENCH_SCANS; ++pass)
+		{
+			for (size_t pos = 0; pos < rows; ++pos)
+			{
+				if (statuses[pos] == status_deleted || amount.is_null(pos))
+					continue;
+
+				total += values[pos];
+				++scanned;
+			}
+		}
+
+		scan_finish = memdb_bench_msec();
+		if (scanned != MEMDB_BENCH_SCANS * MEMDB_BENCH_ROWS)
+			++errors;
+
+		printf("memdb benchmark (%s, columns) array scan: %d rows/msec, checksum %.0f\n",
+			provider ? "huge pages" : "heap",
+			(int)((sb8_t)scanned / __max(scan_finish - scan_start, (sb8_t)1)), total);
+	}
+
+	// a quarter of rows by id range with the sum of amounts,
+	// lookup loop pays virtual calls per row, scan compares column batches
+	sb4_t low = (sb4_t)(MEMDB_BENCH_ROWS / 4), high = (sb4_t)(MEMDB_BENCH_ROWS / 2 - 1);
+	all = table.add_index(0, 0);
+	if (!all)
+	{
+		printf("memdb benchmark: can not create index: %s\n", table.get_last_error());
+		return -1;
+	}
+
+	scan = all->add_lookup(0);
+	double filtered_total = 0;
+	size_t filtered = 0;
+	sb8_t filter_start = memdb_bench_msec();
+	for (size_t pass = 0; pass < MEMDB_BENCH_SCANS; ++pass)
+	{
+		while (scan->next())
+		{
+			sb4_t id = scan->get_value_as_long(0);
+			if (id < low || id > high)
+				continue;
+
+			filtered_total += scan->get_value_as_double(2);
+			++filtered;
+		}
+	}
+
+	sb8_t filter_finish = memdb_bench_msec();
+	all->remove_lookup(scan);
+	table.remove_index(all);
+
+	terimber_memscan* filter = table.add_scan();
+	terimber_db_value_vector* bounds = table.allocate_db_values(2);
+	bounds->set_value_as_long(0, low);
+	bounds->set_value_as_long(1, high);
+	if (!filter->add_predicate(0, scan_between, bounds)
+		|| !filter->add_aggregate(2, scan_sum))
+	{
+		printf("memdb benchmark: can not create scan: %s\n", filter->get_last_error());
+		return -1;
+	}
+
+	sb8_t vector_start = memdb_bench_msec();
+	for (size_t pass = 0; pass < MEMDB_BENCH_SCANS; ++pass)
+		if (!filter->execute())
+			++errors;
+
+	sb8_t vector_finish = memdb_bench_msec();
+	if (filter->get_selected_count() * MEMDB_BENCH_SCANS != filtered
+		|| filter->get_aggregate_as_double(0, 0) * MEMDB_BENCH_SCANS != filtered_total)
+		++errors;
+
+	printf("memdb benchmark (%s, %s) filtered sum: lookup loop %d rows/msec, scan %d rows/msec, selected %d, checksum %.0f\n",
+		provider ? "huge pages" : "heap", columnar ? "columns" : "rows",
+		(int)((sb8_t)(MEMDB_BENCH_SCANS * MEMDB_BENCH_ROWS) / __max(filter_finish - filter_start, (sb8_t)1)),
+		(int)((sb8_t)(MEMDB_BENCH_SCANS * MEMDB_BENCH_ROWS) / __max(vector_finish - vector_start, (sb8_t)1)),
+		(int)filter->get_selected_count(), filter->get_aggregate_as_double(0, 0));
+
+	table.destroy_db_values(bounds);
+	table.remove_scan(filter);
+
+	// snapshot of table with ordered index, restored table is ready for lookups without reload
+	if (!provider)
+	{
+		const char* snapshot = "memdb_bench.snapshot";
+		sb8_t save_start = memdb_bench_msec();
+		if (!table.save_snapshot(snapshot))
+		{
+			printf("memdb benchmark: can not save snapshot: %s\n", table.get_last_error());
+			return -1;
+		}
+
+		sb8_t saved = memdb_bench_msec();
+		TERIMBER::memtable* restored = new TERIMBER::memtable(0, false);
+		if (!restored->restore_snapshot(snapshot) || restored->get_index_count() != 1)
+		{
+			printf("memdb benchmark: can not restore snapshot: %s\n", restored->get_last_error());
+			delete restored;
+			remove(snapshot);
+			return -1;
+		}
+
+		sb8_t restore_finish = memdb_bench_msec();
+		terimber_db_value_vector* restored_key = restored->allocate_db_values(1);
+		found = 0;
+		sum = 0;
+		lookups = memdb_bench_lookups(restored->get_index(0), restored_key, keys, restore_finish + wait * 1000, found, errors, sum);
+		finish = memdb_bench_msec();
+		printf("memdb benchmark (heap, %s) snapshot: save %d msec, restore %d msec, %d lookups/msec, found %d, errors %d, checksum %.0f\n",
+			columnar ? "columns" : "rows", (int)(saved - save_start), (int)(restore_finish - saved),
+			(int)((sb8_t)lookups / __max(finish - restore_finish, (sb8_t)1)), (int)found, (int)errors, sum);
+
+		restored->destroy_db_values(restored_key);
+		// unmaps snapshot file before removing
+		delete restored;
+		remove(snapshot);
+	}
+
+	// lookups see their snapshots while the writer replaces rows
+	if (!provider)
+	{
+		terimber_db_value_vector* writer_key = table.allocate_db_values(1);
+		terimber_db_value_vector* writer_row = table.allocate_db_values(3);
+		memdb_bench_writer* writer = new memdb_bench_writer(idx, writer_key, writer_row, keys);
+		TERIMBER::thread worker;
+		TERIMBER::job_task task(writer, 0, INFINITE, 0);
+		worker.start();
+		worker.assign_job(task);
+
+		sb8_t concurrent_start = memdb_bench_msec();
+		found = 0;
+		sum = 0;
+		lookups = memdb_bench_lookups(idx, key, keys, concurrent_start + wait * 1000, found, errors, sum);
+		finish = memdb_bench_msec();
+
+		writer->stop();
+		TERIMBER::event ev;
+		while (!writer->done())
+			ev.wait(1);
+
+		sb8_t elapsed = __max(finish - concurrent_start, (sb8_t)1);
+		printf("memdb benchmark (heap, %s) with writer: %d lookups/msec, %d updates/sec, found %d, errors %d, checksum %.0f\n",
+			columnar ? "columns" : "rows", (int)((sb8_t)lookups / elapsed), (int)((sb8_t)writer->updates() * 1000 / elapsed),
+			(int)found, (int)(errors + writer->errors()), sum);
+
+		errors += writer->errors();
+		worker.cancel_job();
+		worker.stop();
+		delete writer;
+		table.destroy_db_values(writer_key);
+		table.destroy_db_values(writer_row);
+	}
+
+	if (provider)
+		printf("memdb benchmark: chunks on explicit huge pages %d, on transparent huge pages %d\n",
+			(int)provider->explicit_chunks(), (int)provider->transparent_chunks());
+
+	table.destroy_db_values(key);
+	table.destroy_db_values(row);
+	table.remove_index(idx);
+	return errors ? -1 : 0;
+}
+
+// low cardinality strings and prices, the same rows with and without dictionary columns
+static int memdb_benchmark_dictionary(bool dictionary, const sb4_t* keys)
+{
+	static const char* countries[] = { "Brazil", "Canada", "France", "Germany", "India", "Japan", "Mexico", "Spain" };
+	static const char* currencies[] = { "BRL", "CAD", "EUR", "EUR", "INR", "JPY", "MXN", "EUR" };
+	static const char* statuses[] = { "cancelled", "delivered", "pending", "shipped" };
+
+	TERIMBER::memtable table(0, true);
+	terimber_table_column_desc desc[5] =
+	{
+		{ db_sb4, "id", 0, 0, 0, false },
+		{ db_string, "country", 0, 0, 32, false },
+		{ db_string, "currency", 0, 0, 8, false },
+		{ db_string, "status", 0, 0, 16, false },
+		{ db_numeric, "price", 18, 2, 0, false }
+	};
+
+	if (!table.create(5, desc)
+		|| (dictionary && (!table.set_column_dictionary(1, true)
+			|| !table.set_column_dictionary(2, true)
+			|| !table.set_column_dictionary(3, true))))
+	{
+		printf("memdb benchmark: can not create table: %s\n", table.get_last_error());
+		return -1;
+	}
+
+	sb8_t start = memdb_bench_msec();
+	terimber_db_value_vector* row = table.allocate_db_values(5);
+	char price[32];
+	for (size_t index = 0; index < MEMDB_BENCH_ROWS; ++index)
+	{
+		sb4_t value = keys[index];
+		sprintf(price, "%d.%02d", (int)(value % 100000), (int)(value % 100));
+		row->set_value_as_long(0, value);
+		row->set_value_as_string(1, countries[value & 7], -1);
+		row->set_value_as_string(2, currencies[value & 7], -1);
+		row->set_value_as_string(3, statuses[(value >> 3) & 3], -1);
+		row->set_value_as_numeric(4, price, '.');
+		if (!table.insert_row(row))
+		{
+			printf("memdb benchmark: can not insert row: %s\n", table.get_last_error());
+			return -1;
+		}
+	}
+
+	sb8_t filled = memdb_bench_msec();
+	terimber_index_column_info info[3] = { { 1, true, false }, { 3, true, false }, { 4, true, false } };
+	terimber_memindex* idx = table.add_index(3, info);
+	if (!idx)
+	{
+		printf("memdb benchmark: can not create index: %s\n", table.get_last_error());
+		return -1;
+	}
+
+	sb8_t loaded = memdb_bench_msec();
+
+	// each country and status pair of the first price, rows must match the key
+	terimber_db_value_vector* key = table.allocate_db_values(3);
+	size_t found = 0, errors = 0;
+	for (size_t index = 0; index < 32; ++index)
+	{
+		key->set_value_as_string(0, countries[index & 7], -1);
+		key->set_value_as_string(1, statuses[index >> 3], -1);
+		key->set_value_as_numeric(2, "8.08", '.');
+		terimber_memlookup* lookup = idx->add_lookup(key);
+		for (; lookup && lookup->next(); ++found)
+			if (strcmp(lookup->get_value_as_string(1), countries[index & 7])
+				|| strcmp(lookup->get_value_as_string(3), statuses[index >> 3])
+				|| strcmp(lookup->get_value_as_numeric(4, '.'), "8.08"))
+				++errors;
+
+		if (lookup)
+			idx->remove_lookup(lookup);
+		else
+			++errors;
+	}
+
+	printf("memdb benchmark (%s) rows %d: allocated %d KB, load %d msec, index build %d msec, found %d, errors %d\n",
+		dictionary ? "dictionary" : "plain strings", (int)MEMDB_BENCH_ROWS, (int)(table.get_allocated() / 1024),
+		(int)(filled - start), (int)(loaded - filled), (int)found, (int)errors);
+
+	table.destroy_db_values(key);
+	table.destroy_db_values(row);
+	table.remove_index(idx);
+	return errors ? -1 : 0;
+}
+
+int memdb_benchmark(size_t wait, terimber_log* log)
+{
+	sb4_t* keys = new sb4_t[MEMDB_BENCH_ROWS];
+	memdb_bench_keys(keys, MEMDB_BENCH_ROWS);
+
+	TERIMBER::huge_page_provider provider;
+	int res = memdb_benchmark_run(wait, log, 0, false, keys);
+	if (!res)
+		res = memdb_benchmark_run(wait, log, 0, true, keys);
+	if (!res)
+		res = memdb_benchmark_run(wait, log, &provider, false, keys);
+	if (!res)
+		res = memdb_benchmark_run(wait, log, &provider, true, keys);
+	if (!res)
+		res = memdb_benchmark_dictionary(false, keys);
+	if (!res)
+		res = memdb_benchmark_dictionary(true, keys);
+
+	delete [] keys;
+	return res;
+}
+
+//////////////////////////////////////////////////////////
+// unit tests check results, one function per feature
+
+static int memdb_test_error(const char* test, const char* what)
+{
+	printf("memdb test (%s) failed: %s\n", test, what);
+	return -1;
+}
+
+// table of MEMDB_TEST_ROWS rows: id, name, amount, every tenth name is null
+const size_t MEMDB_TEST_ROWS = 1000;
+
+static bool memdb_test_create(TERIMBER::memtable& table)
+{
+	terimber_table_column_desc desc[3] =
+	{
+		{ db_sb4, "id", 0, 0, 0, false },
+		{ db_string, "name", 0, 0, 32, true },
+		{ db_double, "amount", 0, 0, 0, true }
+	};
+
+	return table.create(3, desc);
+}
+
+static bool memdb_test_insert(TERIMBER::memtable& table, size_t rows)
+{
+	terimber_db_value_vector* row = table.allocate_db_values(3);
+	char name[32];
+	bool res = true;
+	for (size_t index = 0; res && index < rows; ++index)
+	{
+		// inserts in descending order of ids
+		sb4_t id = (sb4_t)(rows - index - 1);
+		int len = sprintf(name, "name %d", (int)id);
+		row->set_value_as_long(0, id);
+		if (id % 10)
+			row->set_value_as_string(1, name, len);
+		else
+			row->set_value_as_null(1, db_string);
+		row->set_value_as_double(2, id * 0.5);
+		res = table.insert_row(row);
+	}
+
+	table.destroy_db_values(row);
+	return res;
+}
+
+static bool memdb_test_fill(TERIMBER::memtable& table, size_t rows)
+{
+	return memdb_test_create(table) && memdb_test_insert(table, rows);
+}
+
+// checks the current row of lookup against the values the fill put
+static bool memdb_test_row(terimber_memlookup* lookup, sb4_t id, double amount)
+{
+	char name[32];
+	sprintf(name, "name %d", (int)id);
+	return lookup->get_value_as_long(0) == id
+		&& lookup->get_value_as_double(2) == amount
+		&& (id % 10 ? !lookup->get_value_is_null(1) && !strcmp(lookup->get_value_as_string(1), name) : lookup->get_value_is_null(1));
+}
+
+// insert, update and delete in row and column layouts
+static int memdb_test_rows(bool columnar)
+{
+	const char* test = columnar ? "rows, columns" : "rows, rows";
+	TERIMBER::memtable table(0, columnar);
+	if (!memdb_test_fill(table, MEMDB_TEST_ROWS))
+		return memdb_test_error(test, table.get_last_error());
+
+	if (table.get_row_count() != MEMDB_TEST_ROWS)
+		return memdb_test_error(test, "wrong row count after insert");
+
+	terimber_memindex* all = table.add_index(0, 0);
+	if (!all)
+		return memdb_test_error(test, table.get_last_error());
+
+	// rows come in the insertion order
+	terimber_memlookup* scan = all->add_lookup(0);
+	size_t count = 0;
+	for (; scan->next(); ++count)
+		if (!memdb_test_row(scan, (sb4_t)(MEMDB_TEST_ROWS - count - 1), (MEMDB_TEST_ROWS - count - 1) * 0.5)
+			|| scan->get_row_status() != status_new)
+			return memdb_test_error(test, "wrong row values after insert");
+
+	if (count != MEMDB_TEST_ROWS)
+		return memdb_test_error(test, "wrong number of scanned rows");
+
+	// updates every odd id, null amount for ids divisible by 3, deletes ids divisible by 4
+	// lookup goes outside the row sequence after change, so rows are found by key
+	terimber_index_column_info info = { 0, true, false };
+	terimber_memindex* idx = table.add_index(1, &info);
+	if (!idx)
+		return memdb_test_error(test, table.get_last_error());
+
+	terimber_db_value_vector* key = table.allocate_db_values(1);
+	terimber_db_value_vector* values = table.allocate_db_values(3);
+	key->set_value_as_long(0, 0);
+	terimber_memlookup* lookup = idx->add_lookup(key);
+	for (sb4_t id = 0; id < (sb4_t)MEMDB_TEST_ROWS; ++id)
+	{
+		key->set_value_as_long(0, id);
+		if (!lookup->reset(key) || !lookup->next() || lookup->get_value_as_long(0) != id)
+			return memdb_test_error(test, "row is not found by key");
+
+		if (id % 4 == 0)
+		{
+			if (!lookup->delete_row())
+				return memdb_test_error(test, "can not delete row");
+		}
+		else if (id % 2)
+		{
+			values->set_value_as_long(0, id);
+			values->set_value_as_string(1, "updated", -1);
+			if (id % 3)
+				values->set_value_as_double(2, id * 2.0);
+			else
+				values->set_value_as_null(2, db_double);
+
+			if (!lookup->update_row(values))
+				return memdb_test_error(test, "can not update row");
+		}
+	}
+
+	// deleted row is not found by key any more
+	key->set_value_as_long(0, 8);
+	if (!lookup->reset(key) || lookup->next())
+		return memdb_test_error(test, "deleted row is found by key");
+
+	idx->remove_lookup(lookup);
+	table.remove_index(idx);
+	table.destroy_db_values(key);
+
+	size_t expected = MEMDB_TEST_ROWS - MEMDB_TEST_ROWS / 4;
+	if (table.get_row_count() != expected)
+		return memdb_test_error(test, "wrong row count after delete");
+
+	scan->reset(0);
+	size_t updated = 0;
+	for (count = 0; scan->next(); ++count)
+	{
+		sb4_t id = scan->get_value_as_long(0);
+		if (id % 4 == 0)
+			return memdb_test_error(test, "deleted row is seen");
+
+		if (id % 2)
+		{
+			++updated;
+			if (strcmp(scan->get_value_as_string(1), "updated")
+				|| (id % 3 ? scan->get_value_is_null(2) || scan->get_value_as_double(2) != id * 2.0 : !scan->get_value_is_null(2)))
+				return memdb_test_error(test, "wrong row values after update");
+		}
+		else if (!memdb_test_row(scan, id, id * 0.5))
+			return memdb_test_error(test, "row changed without update");
+	}
+
+	if (count != expected || updated != MEMDB_TEST_ROWS / 2)
+		return memdb_test_error(test, "wrong number of rows after update");
+
+	// inserted through lookup row is seen by the next scan
+	values->set_value_as_long(0, (sb4_t)MEMDB_TEST_ROWS);
+	values->set_value_as_null(1, db_string);
+	values->set_value_as_double(2, MEMDB_TEST_ROWS * 0.5);
+	if (!scan->insert_row(values) || table.get_row_count() != expected + 1)
+		return memdb_test_error(test, "can not insert row through lookup");
+
+	scan->reset(0);
+	bool found = false;
+	while (scan->next())
+		found = found || memdb_test_row(scan, (sb4_t)MEMDB_TEST_ROWS, MEMDB_TEST_ROWS * 0.5);
+
+	if (!found)
+		return memdb_test_error(test, "inserted row is not seen");
+
+	table.destroy_db_values(values);
+	all->remove_lookup(scan);
+	table.remove_index(all);
+	return 0;
+}
+
+// hash index finds every key once, duplicates all together, follows updates and deletes
+static int memdb_test_hash()
+{
+	const char* test = "hash index";
+	TERIMBER::memtable table(0, false);
+	if (!memdb_test_fill(table, MEMDB_TEST_ROWS))
+		return memdb_test_error(test, table.get_last_error());
+
+	terimber_index_column_info info = { 0, true, false };
+	terimber_memindex* idx = table.add_index(1, &info, index_hash);
+	if (!idx)
+		return memdb_test_error(test, table.get_last_error());
+
+	terimber_db_value_vector* key = table.allocate_db_values(1);
+	terimber_db_value_vector* values = table.allocate_db_values(3);
+	key->set_value_as_long(0, 0);
+	terimber_memlookup* lookup = idx->add_lookup(key);
+	for (sb4_t id = 0; id < (sb4_t)MEMDB_TEST_ROWS; ++id)
+	{
+		key->set_value_as_long(0, id);
+		if (!lookup->reset(key) || !lookup->next() || !memdb_test_row(lookup, id, id * 0.5))
+			return memdb_test_error(test, "row is not found by key");
+
+		if (lookup->next())
+			return memdb_test_error(test, "row is found twice");
+	}
+
+	key->set_value_as_long(0, -1);
+	if (!lookup->reset(key) || lookup->next())
+		return memdb_test_error(test, "missing key is found");
+
+	// inserted rows grow the table, every id gets the duplicate
+	for (sb4_t id = 0; id < (sb4_t)MEMDB_TEST_ROWS; ++id)
+	{
+		values->set_value_as_long(0, id);
+		values->set_value_as_null(1, db_string);
+		values->set_value_as_double(2, -id * 1.0);
+		if (!table.insert_row(values))
+			return memdb_test_error(test, table.get_last_error());
+	}
+
+	for (sb4_t id = 0; id < (sb4_t)MEMDB_TEST_ROWS; ++id)
+	{
+		key->set_value_as_long(0, id);
+		lookup->reset(key);
+		size_t found = 0, mask = 0;
+		for (; lookup->next(); ++found)
+			mask |= lookup->get_value_as_double(2) < 0 || !id ? 1 : 2;
+
+		if (found != 2 || (id && mask != 3))
+			return memdb_test_error(test, "duplicate is not found");
+	}
+
+	// updates move the row to the new version, deletes remove it
+	for (sb4_t id = 0; id < (sb4_t)MEMDB_TEST_ROWS; id += 2)
+	{
+		key->set_value_as_long(0, id);
+		if (!lookup->reset(key) || !lookup->next())
+			return memdb_test_error(test, "row is not found by key");
+
+		if (id % 4)
+		{
+			values->set_value_as_long(0, id);
+			values->set_value_as_string(1, "updated", -1);
+			values->set_value_as_double(2, lookup->get_value_as_double(2));
+			if (!lookup->update_row(values))
+				return memdb_test_error(test, "can not update row");
+		}
+		else if (!lookup->delete_row())
+			return memdb_test_error(test, "can not delete row");
+	}
+
+	for (sb4_t id = 0; id < (sb4_t)MEMDB_TEST_ROWS; ++id)
+	{
+		key->set_value_as_long(0, id);
+		lookup->reset(key);
+		size_t found = 0, updated = 0;
+		for (; lookup->next(); ++found)
+			if (!lookup->get_value_is_null(1) && !strcmp(lookup->get_value_as_string(1), "updated"))
+				++updated;
+
+		if (found != (id % 4 == 0 ? 1 : 2) || updated != (id % 4 == 2 ? 1 : 0))
+			return memdb_test_error(test, "wrong rows after update");
+	}
+
+	idx->remove_lookup(lookup);
+	table.destroy_db_values(values);
+	table.destroy_db_values(key);
+	table.remove_index(idx);
+	return 0;
+}
+
+// index built by sort over filled table keeps the same order as the one filled row by row
+static int memdb_test_order()
+{
+	const char* test = "index order";
+	// name ascending, nulls first, then id descending
+	terimber_index_column_info info[2] = { { 1, true, false }, { 0, false, false } };
+	TERIMBER::memtable built(0, false), grown(0, false);
+	terimber_memindex* grown_idx = 0;
+	if (!memdb_test_fill(built, MEMDB_TEST_ROWS)
+		|| !memdb_test_create(grown)
+		|| !(grown_idx = grown.add_index(2, info))
+		|| !memdb_test_insert(grown, MEMDB_TEST_ROWS))
+		return memdb_test_error(test, "can not fill tables");
+
+	terimber_memindex* built_idx = built.add_index(2, info);
+	if (!built_idx)
+		return memdb_test_error(test, built.get_last_error());
+
+	terimber_memlookup* built_scan = built_idx->add_lookup(0);
+	terimber_memlookup* grown_scan = grown_idx->add_lookup(0);
+	std::string prev_name;
+	sb4_t prev_id = 0;
+	size_t count = 0;
+	for (; built_scan->next(); ++count)
+	{
+		if (!grown_scan->next() || grown_scan->get_value_as_long(0) != built_scan->get_value_as_long(0))
+			return memdb_test_error(test, "indexes differ");
+
+		sb4_t id = built_scan->get_value_as_long(0);
+		std::string name = built_scan->get_value_is_null(1) ? "" : built_scan->get_value_as_string(1);
+		if (count && (name < prev_name || (name == prev_name && id >= prev_id)))
+			return memdb_test_error(test, "rows are out of order");
+
+		prev_name = name;
+		prev_id = id;
+	}
+
+	if (count != MEMDB_TEST_ROWS || grown_scan->next())
+		return memdb_test_error(test, "wrong number of indexed rows");
+
+	// null names come first, backward scan from the end goes through all rows
+	built_scan->reset(0);
+	if (!built_scan->next() || !built_scan->get_value_is_null(1) || built_scan->get_value_as_long(0) != (sb4_t)(MEMDB_TEST_ROWS - 10))
+		return memdb_test_error(test, "null is not the first");
+
+	built_scan->reset(0);
+	for (count = 0; built_scan->prev(); ++count)
+		;
+
+	if (count != MEMDB_TEST_ROWS)
+		return memdb_test_error(test, "wrong number of rows in backward scan");
+
+	// one row by the full key
+	terimber_db_value_vector* key = built.allocate_db_values(2);
+	key->set_value_as_string(0, "name 123", -1);
+	key->set_value_as_long(1, 123);
+	terimber_memlookup* lookup = built_idx->add_lookup(key);
+	if (!lookup || !lookup->next() || lookup->get_value_as_long(0) != 123 || lookup->next())
+		return memdb_test_error(test, "key is not found");
+
+	built_idx->remove_lookup(lookup);
+	built.destroy_db_values(key);
+	built_idx->remove_lookup(built_scan);
+	grown_idx->remove_lookup(grown_scan);
+	built.remove_index(built_idx);
+	grown.remove_index(grown_idx);
+	return 0;
+}
+
+// stub recordset with the same rows the fill makes, ids from first
+static void memdb_test_source(db_stub_server& server, size_t first, size_t rows)
+{
+	char id[32], name[32], amount[32];
+	const char* values[3] = { id, name, amount };
+	server.clear_rows();
+	for (size_t index = first; index < first + rows; ++index)
+	{
+		sprintf(id, "%d", (int)index);
+		sprintf(name, "name %d", (int)index);
+		sprintf(amount, "%.1f", index * 0.5);
+		values[1] = index % 10 ? name : 0;
+		server.add_row(values);
+	}
+}
+
+static const db_stub_column memdb_test_columns[3] =
+{
+	{ db_sb4, "id", 0, false },
+	{ db_string, "name", 32, true },
+	{ db_double, "amount", 0, true }
+};
+
+// rows of populated table, the first id and the row count
+static bool memdb_test_populated(terimber_memindex* idx, sb4_t first, size_t rows)
+{
+	terimber_memlookup* scan = idx->add_lookup(0);
+	size_t count = 0;
+	for (; scan->next(); ++count)
+		if (!memdb_test_row(scan, first + (sb4_t)count, (first + count) * 0.5)
+			|| scan->get_row_status() != status_original)
+			break;
+
+	bool res = count == rows;
+	idx->remove_lookup(scan);
+	return res;
+}
+
+// populate goes through the pipeline for more than one batch and keeps indexes
+static int memdb_test_populate(bool columnar)
+{
+	const char* test = columnar ? "populate, columns" : "populate, rows";
+	const size_t rows = 10000; // a few populate batches
+	db_stub_server server(3, memdb_test_columns, 100);
+	memdb_test_source(server, 0, rows);
+	TERIMBER::memtable table(0, columnar);
+	if (!server.connect(false, "stub") || !server.open_sql(false, "select"))
+		return memdb_test_error(test, server.get_error());
+
+	if (!table.populate(&server, 0, os_minus_one))
+		return memdb_test_error(test, table.get_last_error());
+
+	if (table.get_row_count() != rows)
+		return memdb_test_error(test, "wrong row count");
+
+	terimber_index_column_info order = { 0, true, false };
+	terimber_index_column_info hash = { 0, true, false };
+	terimber_memindex* idx = table.add_index(1, &order);
+	terimber_memindex* hash_idx = table.add_index(1, &hash, index_hash);
+	if (!idx || !hash_idx)
+		return memdb_test_error(test, table.get_last_error());
+
+	if (!memdb_test_populated(idx, 0, rows))
+		return memdb_test_error(test, "wrong populated rows");
+
+	// the same query again with other rows, indexes are kept and built again
+	server.close_sql();
+	memdb_test_source(server, rows, rows / 2);
+	if (!server.open_sql(false, "select") || !table.populate(&server, 0, os_minus_one))
+		return memdb_test_error(test, table.get_last_error());
+
+	if (table.get_row_count() != rows / 2 || table.get_index_count() != 2 || !memdb_test_populated(idx, (sb4_t)rows, rows / 2))
+		return memdb_test_error(test, "wrong rows after populate again");
+
+	terimber_db_value_vector* key = table.allocate_db_values(1);
+	key->set_value_as_long(0, (sb4_t)(rows + 123));
+	terimber_memlookup* lookup = hash_idx->add_lookup(key);
+	if (!lookup || !lookup->next() || !memdb_test_row(lookup, (sb4_t)(rows + 123), (rows + 123) * 0.5) || lookup->next())
+		return memdb_test_error(test, "row is not found by kept hash index");
+
+	key->set_value_as_long(0, 123);
+	if (!lookup->reset(key) || lookup->next())
+		return memdb_test_error(test, "row of previous population is found");
+
+	hash_idx->remove_lookup(lookup);
+	table.destroy_db_values(key);
+
+	// limited number of rows from the given one
+	server.close_sql();
+	if (!server.open_sql(false, "select") || !table.populate(&server, 1000, 5000))
+		return memdb_test_error(test, table.get_last_error());
+
+	if (!memdb_test_populated(idx, (sb4_t)(rows + 1000), rows / 2 - 1000))
+		return memdb_test_error(test, "wrong rows of limited populate");
+
+	server.close_sql();
+	table.remove_index(hash_idx);
+	table.remove_index(idx);
+	return 0;
+}
+
+// restored table has the same rows, statuses and indexes
+static int memdb_test_snapshot(bool columnar)
+{
+	const char* test = columnar ? "snapshot, columns" : "snapshot, rows";
+	const char* snapshot = "memdb_test.snapshot";
+	TERIMBER::memtable table(0, columnar);
+	if (!memdb_test_fill(table, MEMDB_TEST_ROWS))
+		return memdb_test_error(test, table.get_last_error());
+
+	// id descending and hash on name
+	terimber_index_column_info order = { 0, false, false };
+	terimber_index_column_info hash = { 1, true, false };
+	terimber_memindex* idx = table.add_index(1, &order);
+	if (!idx || !table.add_index(1, &hash, index_hash))
+		return memdb_test_error(test, table.get_last_error());
+
+	// original, updated and deleted rows
+	table.refresh();
+	terimber_db_value_vector* key = table.allocate_db_values(1);
+	terimber_db_value_vector* values = table.allocate_db_values(3);
+	key->set_value_as_long(0, 0);
+	terimber_memlookup* lookup = idx->add_lookup(key);
+	for (sb4_t id = 1; id < (sb4_t)MEMDB_TEST_ROWS; id += 3)
+	{
+		key->set_value_as_long(0, id);
+		if (!lookup->reset(key) || !lookup->next())
+			return memdb_test_error(test, "row is not found by key");
+
+		values->set_value_as_long(0, id);
+		values->set_value_as_string(1, "updated", -1);
+		values->set_value_as_double(2, id * 0.5);
+		if (id % 2 ? !lookup->update_row(values) : !lookup->delete_row())
+			return memdb_test_error(test, "can not change row");
+	}
+
+	idx->remove_lookup(lookup);
+	table.destroy_db_values(values);
+	table.destroy_db_values(key);
+
+	if (!table.save_snapshot(snapshot))
+		return memdb_test_error(test, table.get_last_error());
+
+	TERIMBER::memtable* restored = new TERIMBER::memtable(0, columnar);
+	if (!restored->restore_snapshot(snapshot))
+	{
+		memdb_test_error(test, restored->get_last_error());
+		delete restored;
+		remove(snapshot);
+		return -1;
+	}
+
+	int res = 0;
+	if (restored->get_row_count() != table.get_row_count() || restored->get_index_count() != 2)
+		res = memdb_test_error(test, "wrong row or index count");
+
+	// both ordered indexes go through the same rows
+	terimber_memindex* restored_idx = restored->get_index(0);
+	terimber_memlookup* scan = idx->add_lookup(0);
+	terimber_memlookup* restored_scan = restored_idx ? restored_idx->add_lookup(0) : 0;
+	size_t count = 0;
+	while (!res && restored_scan && scan->next())
+	{
+		if (!restored_scan->next()
+			|| restored_scan->get_value_as_long(0) != scan->get_value_as_long(0)
+			|| restored_scan->get_value_is_null(1) != scan->get_value_is_null(1)
+			|| (!scan->get_value_is_null(1) && strcmp(restored_scan->get_value_as_string(1), scan->get_value_as_string(1)))
+			|| restored_scan->get_value_as_double(2) != scan->get_value_as_double(2)
+			|| restored_scan->get_row_status() != scan->get_row_status())
+			res = memdb_test_error(test, "restored row differs");
+
+		++count;
+	}
+
+	// deleted original rows are counted, but not seen
+	if (!res && (!restored_scan || count != MEMDB_TEST_ROWS - (MEMDB_TEST_ROWS + 1) / 6))
+		res = memdb_test_error(test, "wrong number of restored rows");
+
+	// restored hash index finds all updated rows
+	terimber_memindex* restored_hash = restored->get_index(1);
+	terimber_db_value_vector* restored_key = restored->allocate_db_values(1);
+	restored_key->set_value_as_string(0, "updated", -1);
+	terimber_memlookup* restored_lookup = restored_hash ? restored_hash->add_lookup(restored_key) : 0;
+	for (count = 0; restored_lookup && restored_lookup->next(); ++count)
+		if (restored_lookup->get_value_as_long(0) % 6 != 1 || restored_lookup->get_row_status() != status_updated)
+			break;
+
+	if (!res && count != (MEMDB_TEST_ROWS + 4) / 6)
+		res = memdb_test_error(test, "wrong rows found by restored hash index");
+
+	if (restored_lookup)
+		restored_hash->remove_lookup(restored_lookup);
+	if (restored_scan)
+		restored_idx->remove_lookup(restored_scan);
+	idx->remove_lookup(scan);
+	restored->destroy_db_values(restored_key);
+	// unmaps snapshot file before removing
+	delete restored;
+	remove(snapshot);
+	return res;
+}
+
+// scan in progress sees rows as they were at its first row, the next scan sees changes
+static int memdb_test_versions(bool columnar)
+{
+	const char* test = columnar ? "versions, columns" : "versions, rows";
+	TERIMBER::memtable table(0, columnar);
+	if (!memdb_test_fill(table, MEMDB_TEST_ROWS))
+		return memdb_test_error(test, table.get_last_error());
+
+	table.refresh();
+	terimber_index_column_info order = { 0, true, false };
+	terimber_memindex* idx = table.add_index(1, &order);
+	if (!idx)
+		return memdb_test_error(test, table.get_last_error());
+
+	terimber_memlookup* scan = idx->add_lookup(0);
+	if (!scan->next() || scan->get_value_as_long(0) != 0)
+		return memdb_test_error(test, "wrong first row");
+
+	// writer changes rows behind the scan and ahead of it
+	terimber_db_value_vector* key = table.allocate_db_values(1);
+	terimber_db_value_vector* values = table.allocate_db_values(3);
+	key->set_value_as_long(0, 0);
+	terimber_memlookup* writer = idx->add_lookup(key);
+	for (sb4_t id = 0; id < (sb4_t)MEMDB_TEST_ROWS; id += 5)
+	{
+		key->set_value_as_long(0, id);
+		if (!writer->reset(key) || !writer->next())
+			return memdb_test_error(test, "row is not found by key");
+
+		values->set_value_as_long(0, id);
+		values->set_value_as_null(1, db_string);
+		values->set_value_as_double(2, -1.0);
+		if (id % 2 ? !writer->update_row(values) : !writer->delete_row())
+			return memdb_test_error(test, "can not change row");
+	}
+
+	values->set_value_as_long(0, (sb4_t)MEMDB_TEST_ROWS);
+	if (!table.insert_row(values))
+		return memdb_test_error(test, table.get_last_error());
+
+	size_t count = 1;
+	for (; scan->next(); ++count)
+	{
+		sb4_t id = scan->get_value_as_long(0);
+		if (id != (sb4_t)count || !memdb_test_row(scan, id, id * 0.5))
+			return memdb_test_error(test, "scan sees the change made after it started");
+	}
+
+	if (count != MEMDB_TEST_ROWS)
+		return memdb_test_error(test, "wrong number of rows in the started scan");
+
+	// the new scan takes the new snapshot
+	scan->reset(0);
+	sb4_t expected = 1;
+	for (count = 0; scan->next(); ++count, ++expected)
+	{
+		// deleted rows are gone, the inserted one comes last
+		if (expected % 10 == 0 && expected != (sb4_t)MEMDB_TEST_ROWS)
+			++expected;
+
+		sb4_t id = scan->get_value_as_long(0);
+		if (id != expected
+			|| (id % 5 ? !memdb_test_row(scan, id, id * 0.5) : !scan->get_value_is_null(1) || scan->get_value_as_double(2) != -1.0))
+			return memdb_test_error(test, "new scan does not see changes");
+	}
+
+	if (count != MEMDB_TEST_ROWS - MEMDB_TEST_ROWS / 10 + 1)
+		return memdb_test_error(test, "wrong number of rows in the new scan");
+
+	idx->remove_lookup(writer);
+	idx->remove_lookup(scan);
+	table.destroy_db_values(values);
+	table.destroy_db_values(key);
+	table.remove_index(idx);
+	return 0;
+}
+
+// rows the scan must select, checked row by row
+struct memdb_test_filter
+{
+	sb4_t		_low;
+	sb4_t		_high;
+	double		_amount;	// amount is greater, nulls are not selected
+};
+
+// scan results are the same as row by row evaluation through lookup
+static int memdb_test_scan_check(const char* test, TERIMBER::memtable& table, terimber_memindex* all, const memdb_test_filter& filter)
+{
+	terimber_memscan* scan = table.add_scan();
+	terimber_db_value_vector* bounds = table.allocate_db_values(2);
+	terimber_db_value_vector* amount = table.allocate_db_values(1);
+	bounds->set_value_as_long(0, filter._low);
+	bounds->set_value_as_long(1, filter._high);
+	amount->set_value_as_double(0, filter._amount);
+	bool res = scan->add_predicate(0, scan_between, bounds)
+		&& scan->add_predicate(2, scan_greater, amount)
+		&& scan->add_aggregate(os_minus_one, scan_count)
+		&& scan->add_aggregate(1, scan_count)
+		&& scan->add_aggregate(2, scan_sum)
+		&& scan->add_aggregate(0, scan_min)
+		&& scan->add_aggregate(0, scan_max)
+		&& scan->execute();
+
+	table.destroy_db_values(amount);
+	table.destroy_db_values(bounds);
+	if (!res)
+	{
+		memdb_test_error(test, scan->get_last_error());
+		table.remove_scan(scan);
+		return -1;
+	}
+
+	size_t count = 0, names = 0;
+	double sum = 0;
+	sb4_t min_id = 0, max_id = 0;
+	terimber_memlookup* lookup = all->add_lookup(0);
+	while (lookup->next())
+	{
+		sb4_t id = lookup->get_value_as_long(0);
+		if (id < filter._low || id > filter._high || lookup->get_value_is_null(2) || lookup->get_value_as_double(2) <= filter._amount)
+			continue;
+
+		if (!count || id < min_id)
+			min_id = id;
+		if (!count || id > max_id)
+			max_id = id;
+
+		++count;
+		names += !lookup->get_value_is_null(1);
+		sum += lookup->get_value_as_double(2);
+	}
+
+	all->remove_lookup(lookup);
+
+	// selection gives the same rows
+	double selected_sum = 0;
+	for (size_t row = 0; row < scan->get_selected_count(); ++row)
+		selected_sum += scan->get_value_as_double(row, 2);
+
+	res = scan->get_selected_count() == count
+		&& scan->get_group_count() == 1
+		&& scan->get_aggregate_as_long64(0, 0) == (sb8_t)count
+		&& scan->get_aggregate_as_long64(0, 1) == (sb8_t)names
+		&& scan->get_aggregate_as_double(0, 2) == sum
+		&& selected_sum == sum
+		&& (count ? !scan->get_aggregate_is_null(0, 3)
+			&& scan->get_aggregate_as_long64(0, 3) == min_id
+			&& scan->get_aggregate_as_long64(0, 4) == max_id
+			: scan->get_aggregate_is_null(0, 3));
+
+	table.remove_scan(scan);
+	return res ? 0 : memdb_test_error(test, "scan results differ from rows");
+}
+
+// predicates and aggregates on blocks of rows with tails, nulls and replaced versions
+static int memdb_test_scan(bool columnar)
+{
+	const char* test = columnar ? "scan, columns" : "scan, rows";
+	TERIMBER::memtable table(0, columnar);
+	// not a multiple of vector width
+	if (!memdb_test_fill(table, MEMDB_TEST_ROWS + 3))
+		return memdb_test_error(test, table.get_last_error());
+
+	table.refresh();
+	terimber_index_column_info order = { 0, true, false };
+	terimber_memindex* idx = table.add_index(1, &order);
+	terimber_memindex* all = table.add_index(0, 0);
+	if (!idx || !all)
+		return memdb_test_error(test, table.get_last_error());
+
+	// null amounts, new versions and deleted rows
+	terimber_db_value_vector* key = table.allocate_db_values(1);
+	terimber_db_value_vector* values = table.allocate_db_values(3);
+	key->set_value_as_long(0, 0);
+	terimber_memlookup* writer = idx->add_lookup(key);
+	for (sb4_t id = 0; id < (sb4_t)MEMDB_TEST_ROWS; id += 7)
+	{
+		key->set_value_as_long(0, id);
+		if (!writer->reset(key) || !writer->next())
+			return memdb_test_error(test, "row is not found by key");
+
+		values->set_value_as_long(0, id);
+		values->set_value_as_string(1, "updated", -1);
+		if (id % 3 == 0)
+			values->set_value_as_null(2, db_double);
+		else
+			values->set_value_as_double(2, id * 3.0);
+
+		if (id % 2 ? !writer->update_row(values) : !writer->delete_row())
+			return memdb_test_error(test, "can not change row");
+	}
+
+	idx->remove_lookup(writer);
+	table.destroy_db_values(values);
+	table.destroy_db_values(key);
+
+	static const memdb_test_filter filters[] =
+	{
+		{ 0, (sb4_t)MEMDB_TEST_ROWS + 3, -1.0 },	// all rows with amounts
+		{ 1, 1, -1.0 },								// one row
+		{ 17, 977, 100.0 },							// bounds inside blocks
+		{ 500, 400, -1.0 },							// empty range
+		{ 0, (sb4_t)MEMDB_TEST_ROWS + 3, 1e9 }		// nothing passes the second predicate
+	};
+
+	int res = 0;
+	for (size_t index = 0; !res && index < sizeof(filters) / sizeof(filters[0]); ++index)
+		res = memdb_test_scan_check(test, table, all, filters[index]);
+
+	// groups by name split the same rows
+	terimber_memscan* scan = table.add_scan();
+	if (!res && (!scan->add_group(1) || !scan->add_aggregate(os_minus_one, scan_count) || !scan->execute()))
+		res = memdb_test_error(test, scan->get_last_error());
+
+	sb8_t grouped = 0, updated = -1;
+	for (size_t group = 0; !res && group < scan->get_group_count(); ++group)
+	{
+		grouped += scan->get_aggregate_as_long64(group, 0);
+		if (!scan->get_group_value_is_null(group, 0) && !strcmp(scan->get_group_value_as_string(group, 0), "updated"))
+			updated = scan->get_aggregate_as_long64(group, 0);
+	}
+
+	// odd ids of 0, 7, 14, ... are updated, even ones deleted
+	size_t changed = (MEMDB_TEST_ROWS + 6) / 7;
+	if (!res && (grouped != (sb8_t)(MEMDB_TEST_ROWS + 3 - (changed + 1) / 2) || updated != (sb8_t)(changed / 2)))
+		res = memdb_test_error(test, "wrong groups");
+
+	table.remove_scan(scan);
+	table.remove_index(all);
+	table.remove_index(idx);
+	return res;
+}
+
+// dictionary strings and fixed width decimals give back what was put
+static int memdb_test_dictionary(bool columnar)
+{
+	const char* test = columnar ? "dictionary, columns" : "dictionary, rows";
+	static const char* countries[] = { "Brazil", "Canada", "", "France" };
+	static const char* prices[] = { "0", "8.08", "-12.5", "9999999999999999.99", "-0.01", "123.4" };
+	const size_t rows = 600;
+
+	TERIMBER::memtable table(0, columnar);
+	terimber_table_column_desc desc[3] =
+	{
+		{ db_sb4, "id", 0, 0, 0, false },
+		{ db_string, "country", 0, 0, 32, true },
+		{ db_numeric, "price", 18, 2, 0, true }
+	};
+
+	if (!table.create(3, desc) || !table.set_column_dictionary(1, true))
+		return memdb_test_error(test, table.get_last_error());
+
+	// dictionary is for strings only
+	if (table.set_column_dictionary(2, true))
+		return memdb_test_error(test, "dictionary is set for numeric column");
+
+	terimber_db_value_vector* row = table.allocate_db_values(3);
+	for (size_t index = 0; index < rows; ++index)
+	{
+		row->set_value_as_long(0, (sb4_t)index);
+		if (index % 5 == 4)
+			row->set_value_as_null(1, db_string);
+		else
+			row->set_value_as_string(1, countries[index % 5], -1);
+
+		if (index % 7 == 6)
+			row->set_value_as_null(2, db_numeric);
+		else
+			row->set_value_as_numeric(2, prices[index % 6], '.');
+
+		if (!table.insert_row(row))
+			return memdb_test_error(test, table.get_last_error());
+	}
+
+	terimber_index_column_info order = { 0, true, false };
+	terimber_memindex* idx = table.add_index(1, &order);
+	if (!idx)
+		return memdb_test_error(test, table.get_last_error());
+
+	// a new string after the dictionary is built, a new price in exponent form
+	terimber_db_value_vector* key = table.allocate_db_values(1);
+	key->set_value_as_long(0, 3);
+	terimber_memlookup* lookup = idx->add_lookup(key);
+	row->set_value_as_long(0, 3);
+	row->set_value_as_string(1, "Zimbabwe", -1);
+	row->set_value_as_numeric(2, "-725E-2", '.');
+	if (!lookup || !lookup->next() || !lookup->update_row(row))
+		return memdb_test_error(test, "can not update row");
+
+	idx->remove_lookup(lookup);
+	table.destroy_db_values(key);
+	table.destroy_db_values(row);
+
+	terimber_memlookup* scan = idx->add_lookup(0);
+	size_t count = 0;
+	for (; scan->next(); ++count)
+	{
+		const char* country = count == 3 ? "Zimbabwe" : (count % 5 == 4 ? 0 : countries[count % 5]);
+		const char* price = count == 3 ? "-7.25" : (count % 7 == 6 ? 0 : prices[count % 6]);
+		if (scan->get_value_as_long(0) != (sb4_t)count
+			|| scan->get_value_is_null(1) != !country
+			|| (country && strcmp(scan->get_value_as_string(1), country))
+			|| scan->get_value_is_null(2) != !price
+			|| (price && strcmp(scan->get_value_as_numeric(2, '.'), price)))
+		{
+			printf("memdb test (%s): row %d country %s price %s\n", test, (int)count,
+				scan->get_value_is_null(1) ? "null" : scan->get_value_as_string(1),
+				scan->get_value_is_null(2) ? "null" : scan->get_value_as_numeric(2, '.'));
+			return memdb_test_error(test, "wrong value");
+		}
+	}
+
+	if (count != rows)
+		return memdb_test_error(test, "wrong number of rows");
+
+	// mantissa over 64 bits goes through, over 127 bits is rejected
+	row = table.allocate_db_values(3);
+	row->set_value_as_long(0, (sb4_t)rows);
+	row->set_value_as_null(1, db_string);
+	bool wide = row->set_value_as_numeric(2, "-123456789012345678901234567.5", '.') && table.insert_row(row);
+	row->set_value_as_long(0, (sb4_t)rows + 1);
+	bool huge = row->set_value_as_numeric(2, "123456789012345678901234567890123456789012345", '.') && table.insert_row(row);
+	table.destroy_db_values(row);
+	if (!wide || huge)
+		return memdb_test_error(test, "wrong wide decimals");
+
+	idx->remove_lookup(scan);
+	key = table.allocate_db_values(1);
+	key->set_value_as_long(0, (sb4_t)rows);
+	lookup = idx->add_lookup(key);
+	table.destroy_db_values(key);
+	if (!lookup || !lookup->next() || strcmp(lookup->get_value_as_numeric(2, '.'), "-123456789012345678901234567.5"))
+		return memdb_test_error(test, "wrong wide decimal value");
+
+	idx->remove_lookup(lookup);
+	table.remove_index(idx);
+	return 0;
+}
+
+static const db_stub_column memdb_test_delta_columns[4] =
+{
+	{ db_sb4, "id", 0, false },
+	{ db_string, "name", 32, true },
+	{ db_double, "amount", 0, true },
+	{ db_bool, "deleted", 0, true }
+};
+
+// change-tracking rows: ids below first are updated every third, deleted the next one
+// and sent without changes the last one, then inserted rows and deletions of unknown rows
+static void memdb_test_delta_source(db_stub_server& server, size_t first, size_t inserted, size_t unknown)
+{
+	char id[32], name[32], amount[32];
+	const char* values[4] = { id, name, amount, 0 };
+	server.clear_rows();
+	for (size_t index = 0; index < first + inserted + unknown; ++index)
+	{
+		sprintf(id, "%d", (int)index);
+		sprintf(name, "name %d", (int)index);
+		sprintf(amount, "%.1f", index * 0.5 + (index < first && index % 3 == 0 ? 1 : 0));
+		values[1] = index % 10 ? name : 0;
+		values[3] = index < first ? (index % 3 == 1 ? "1" : "0") : (index < first + inserted ? 0 : "1");
+		server.add_row(values);
+	}
+}
+
+// delta is applied by key, more rows than one fetch batch
+static int memdb_test_delta(bool columnar)
+{
+	const char* test = columnar ? "delta, columns" : "delta, rows";
+	const size_t rows = 1000, inserted = 5000, unknown = 100;
+	db_stub_server server(3, memdb_test_columns, 100);
+	memdb_test_source(server, 0, rows);
+	TERIMBER::memtable table(0, columnar);
+	if (!server.connect(false, "stub") || !server.open_sql(false, "select") || !table.populate(&server, 0, os_minus_one))
+		return memdb_test_error(test, table.get_last_error());
+
+	server.close_sql();
+	db_stub_server delta(4, memdb_test_delta_columns, 100);
+	memdb_test_delta_source(delta, rows, inserted, unknown);
+	size_t keys[1] = { 0 };
+
+	// delete flag must follow the table columns
+	if (!delta.connect(false, "stub") || !delta.open_sql(false, "select") || table.populate_delta(&delta, 1, keys, 1))
+		return memdb_test_error(test, "wrong delete flag column is accepted");
+
+	delta.close_sql();
+	if (!delta.open_sql(false, "select") || !table.populate_delta(&delta, 1, keys, 3))
+		return memdb_test_error(test, table.get_last_error());
+
+	delta.close_sql();
+	if (table.get_index_count() != 1)
+		return memdb_test_error(test, "hash index on key is not created");
+
+	terimber_index_column_info order = { 0, true, false };
+	terimber_memindex* idx = table.add_index(1, &order);
+	if (!idx)
+		return memdb_test_error(test, table.get_last_error());
+
+	terimber_memlookup* scan = idx->add_lookup(0);
+	size_t count = 0, id = 0;
+	for (; scan->next(); ++count, ++id)
+	{
+		if (id < rows && id % 3 == 1)
+			++id;
+
+		if (!memdb_test_row(scan, (sb4_t)id, id * 0.5 + (id < rows && id % 3 == 0 ? 1 : 0))
+			|| scan->get_row_status() != (id < rows ? status_updated : status_new))
+		{
+			printf("memdb test (%s): row %d\n", test, (int)id);
+			idx->remove_lookup(scan);
+			return memdb_test_error(test, "wrong delta row");
+		}
+	}
+
+	idx->remove_lookup(scan);
+	if (count != rows - rows / 3 + inserted)
+		return memdb_test_error(test, "wrong number of rows after delta");
+
+	// the next delta uses the kept hash index and sees the changes made before
+	table.refresh();
+	db_stub_server again(3, memdb_test_columns, 100);
+	const char* values[3] = { "1", "name 1", "-1.0" };
+	again.add_row(values);
+	if (!again.connect(false, "stub") || !again.open_sql(false, "select") || !table.populate_delta(&again, 1, keys, os_minus_one))
+		return memdb_test_error(test, table.get_last_error());
+
+	again.close_sql();
+	terimber_db_value_vector* key = table.allocate_db_values(1);
+	key->set_value_as_long(0, 1);
+	terimber_memlookup* lookup = idx->add_lookup(key);
+	table.destroy_db_values(key);
+	bool res = lookup && lookup->next() && memdb_test_row(lookup, 1, -1.0) && lookup->get_row_status() == status_new;
+	if (lookup)
+		idx->remove_lookup(lookup);
+
+	if (!res || table.get_index_count() != 2)
+		return memdb_test_error(test, "wrong second delta");
+
+	table.remove_index(idx);
+	return 0;
+}
+
+int memdb_unittest(size_t wait, terimber_log* log)
+{
+	int res = memdb_test_rows(false);
+	if (!res)
+		res = memdb_test_rows(true);
+	if (!res)
+		res = memdb_test_hash();
+	if (!res)
+		res = memdb_test_order();
+	if (!res)
+		res = memdb_test_populate(false);
+	if (!res)
+		res = memdb_test_populate(true);
+	if (!res)
+		res = memdb_test_snapshot(false);
+	if (!res)
+		res = memdb_test_snapshot(true);
+	if (!res)
+		res = memdb_test_versions(false);
+	if (!res)
+		res = memdb_test_versions(true);
+	if (!res)
+		res = memdb_test_scan(false);
+	if (!res)
+		res = memdb_test_scan(true);
+	if (!res)
+		res = memdb_test_dictionary(false);
+	if (!res)
+		res = memdb_test_dictionary(true);
+	if (!res)
+		res = memdb_test_delta(false);
+	if (!res)
+		res = memdb_test_delta(true);
+
+	return res;
+}
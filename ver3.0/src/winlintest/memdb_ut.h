@@ -0,0 +1,7 @@
+#ifndef _terimber_memdb_ut_h_
+#define _terimber_memdb_ut_h_
+
+int memdb_unittest(size_t wait, terimber_log* log);
+int memdb_benchmark(size_t wait, terimber_log* log);
+
+#endif
@@ -8,6 +8,10 @@
 
 #include "allinc.h"
 #include "aiosock/aiosockfactory.h"
+#if OS_TYPE != OS_WIN32
+#include "aiocomport/aiocomport.h"
+#include <sys/resource.h>
+#endif
 #include "base/list.hpp"
 #include "base/memory.hpp"
 #include "base/common.hpp"
@@ -273,3 +277,255 @@ int socketport_unittest(size_t wait, terimber_log* log)
 
 	return 0;
 }
+
+//////////////////////////////////////////////////////////////////
+// echo benchmark - many connections ping-pong small messages
+const size_t echo_buf_size = 64;
+
+class ter_echo_peer : public terimber_aiosock_callback
+{
+public:
+	ter_echo_peer(terimber_aiosock* sp, bool server, size_t connections) : 
+		_round_trips(0), _errors(0), _connected(0), _sp(sp), _server(server), _stop(false), _next(0), _connections(connections)
+	{
+		_buffers = new char[_connections * echo_buf_size];
+		memset(_buffers, 'e', _connections * echo_buf_size);
+	}
+
+	~ter_echo_peer()
+	{
+		delete [] _buffers;
+	}
+
+	void stop()
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		_stop = true;
+	}
+
+	void clear()
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		for (TERIMBER::list< size_t >::const_iterator iter = _handles.begin(); iter != _handles.end(); ++iter)
+			_sp->close(*iter);
+
+		_handles.clear();
+	}
+
+	// assigns next connection buffer
+	char* next_buffer()
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		return _next < _connections ? _buffers + echo_buf_size * _next++ : 0;
+	}
+
+	void add_handle(size_t handle)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		_handles.push_back(handle);
+	}
+
+	virtual void v_on_error(size_t handle, int err, aiosock_type mask, void* userdata)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		++_errors;
+	}
+
+	virtual void v_on_connect(size_t handle, const sockaddr_in& peeraddr, void* userdata)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		if (_stop)
+			return;
+
+		++_connected;
+		keeper.unlock();
+		_sp->send(handle, userdata, echo_buf_size, INFINITE, 0, userdata);
+	}
+
+	virtual void v_on_send(size_t handle, void* buf, size_t requested, size_t processed, const sockaddr_in& peeraddr, void* userdata)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		if (_stop || !processed)
+			return;
+
+		keeper.unlock();
+
+		if (processed < requested)
+			_sp->send(handle, (char*)buf + processed, requested - processed, INFINITE, 0, userdata);
+		else
+			_sp->receive(handle, userdata, echo_buf_size, INFINITE, 0, userdata);
+	}
+
+	virtual void v_on_receive(size_t handle, void* buf, size_t requested, size_t processed, const sockaddr_in& peeraddr, void* userdata)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		if (_stop || !processed)
+			return;
+
+		if (_server)
+		{
+			keeper.unlock();
+			// echoes back what has been received
+			_sp->send(handle, buf, processed, INFINITE, 0, userdata);
+		}
+		else if (processed < requested)
+		{
+			keeper.unlock();
+			_sp->receive(handle, (char*)buf + processed, requested - processed, INFINITE, 0, userdata);
+		}
+		else
+		{
+			++_round_trips;
+			keeper.unlock();
+			_sp->send(handle, userdata, echo_buf_size, INFINITE, 0, userdata);
+		}
+	}
+
+	virtual void v_on_accept(size_t handle, size_t handle_accepted, terimber_aiosock_callback*& callback, const sockaddr_in& peeraddr, void* userdata)
+	{
+		char* buf = next_buffer();
+		add_handle(handle_accepted);
+
+		TERIMBER::mutexKeeper keeper(_mtx);
+		if (_stop || !buf)
+			return;
+
+		++_connected;
+		keeper.unlock();
+		_sp->receive(handle_accepted, buf, echo_buf_size, INFINITE, 0, buf);
+	}
+
+public:
+	size_t						_round_trips;
+	size_t						_errors;
+	size_t						_connected;
+	TERIMBER::mutex				_mtx;
+
+private:
+	terimber_aiosock*			_sp;
+	bool						_server;
+	bool						_stop;
+	size_t						_next;
+	size_t						_connections;
+	char*						_buffers;
+	TERIMBER::list< size_t >	_handles;
+};
+
+static const unsigned short echo_port = 8334;
+
+// one run over the backend selected, threads come from thread pool or executor
+static int socketecho_run(size_t wait, size_t connections, size_t shards, terimber_log* log, const char* backend, bool work_stealing)
+{
+#if OS_TYPE != OS_WIN32
+	// each connection takes two descriptors in this process
+	rlimit rl;
+	if (!getrlimit(RLIMIT_NOFILE, &rl) && rl.rlim_cur < 2 * connections + 64)
+	{
+		rl.rlim_cur = __min((rlim_t)(2 * connections + 64), rl.rlim_max);
+		setrlimit(RLIMIT_NOFILE, &rl);
+		if (rl.rlim_cur < 2 * connections + 64)
+		{
+			connections = (rl.rlim_cur - 64) / 2;
+			printf("descriptor limit reduces connections to %d\n", (int)connections);
+		}
+	}
+#endif
+
+	terimber_aiosock_factory acc;
+	terimber_aiosock* server_port = acc.get_aiosock(log, 3, 60000, shards, work_stealing);
+	terimber_aiosock* client_port = acc.get_aiosock(log, 3, 60000, shards, work_stealing);
+
+	ter_echo_peer server(server_port, true, connections);
+	ter_echo_peer client(client_port, false, connections);
+
+	size_t listener = server_port->create(&server, true);
+	if (!listener || server_port->listen(listener, echo_port, SOMAXCONN, 0, 64, 0))
+	{
+		printf("can not start echo listener\n");
+		delete server_port;
+		delete client_port;
+		return -1;
+	}
+
+	TERIMBER::date start;
+
+	for (size_t i = 0; i < connections; ++i)
+	{
+		size_t handle = client_port->create(&client, true);
+		if (!handle)
+		{
+			printf("can not create client socket %d\n", (int)i);
+			break;
+		}
+
+		client.add_handle(handle);
+		client_port->connect(handle, server_address, echo_port, 60000, client.next_buffer());
+	}
+
+	printf("echo benchmark (%s, %s, %d shards): %d connections initiated in %d msec\n", backend, work_stealing ? "executor" : "thread pool", (int)shards, (int)connections, (int)TERIMBER::date::get_difference(start));
+
+	TERIMBER::event ev;
+	size_t loops = wait, last = 0;
+	while (loops--)
+	{
+		ev.wait(1000);
+
+		TERIMBER::mutexKeeper keeper(client._mtx);
+		size_t round_trips = client._round_trips, connected = client._connected;
+		keeper.unlock();
+
+		printf("connected %d, round trips %d/sec\n", (int)connected, (int)(round_trips - last));
+		last = round_trips;
+	}
+
+	sb8_t elapsed = TERIMBER::date::get_difference(start);
+
+	server.stop();
+	client.stop();
+
+	server_port->close(listener);
+	client.clear();
+	server.clear();
+
+	printf("echo benchmark (%s, %s, %d shards): connections %d, accepted %d, round trips %d, errors %d, %d round trips/sec\r\n", 
+		backend, work_stealing ? "executor" : "thread pool", (int)shards, (int)client._connected, (int)server._connected, (int)client._round_trips, (int)(client._errors + server._errors),
+		elapsed > 0 ? (int)((sb8_t)client._round_trips * 1000 / elapsed) : 0);
+
+	delete server_port;
+	delete client_port;
+
+	return 0;
+}
+
+int socketecho_benchmark(size_t wait, size_t connections, size_t shards, terimber_log* log)
+{
+	const char* backend =
+#if OS_TYPE == OS_WIN32
+		"iocp";
+#elif defined(USE_EPOLL)
+		"epoll";
+#elif !defined(NO_NPTL)
+		"rt signals";
+#else
+		"select";
+#endif
+
+#ifdef USE_EPOLL
+	if (!TERIMBER::SetEpoll(true))
+		return -1;
+#endif
+
+	// default backend over thread pool and executor
+	int res = socketecho_run(wait, connections, shards, log, backend, false);
+	if (!res)
+		res = socketecho_run(wait, connections, shards, log, backend, true);
+
+#ifdef USE_EPOLL
+	// the same load over rt signals, epoll stays on after that
+	if (!res)
+		res = TERIMBER::SetEpoll(false) ? socketecho_run(wait, connections, shards, log, "rt signals", false) : -1;
+
+	TERIMBER::SetEpoll(true);
+#endif
+	return res;
+}
@@ -2,6 +2,8 @@
 #define _terimber_socketport_ut_h_
 
 int socketport_unittest(size_t wait, terimber_log* log);
+// echo ping-pong over many connections, reports round trips per second
+int socketecho_benchmark(size_t wait, size_t connections, size_t shards, terimber_log* log);
 
 #endif
 
@@ -8,9 +8,11 @@
 
 #include "allinc.h"
 #include "aiosock/aiosockfactory.h"
+#include "aiogate/aiogatefactory.h"
 #include "base/list.hpp"
 #include "base/memory.hpp"
 #include "base/common.hpp"
+#include "base/date.h"
 
 const size_t buf_size_max = 128;//1024;
 
@@ -249,3 +251,131 @@ int socketudp_unittest(size_t wait, terimber_log* log)
 
 	return 0;
 }
+
+//////////////////////////////////////////////////////
+// datagrams per second through aiogate UDP pins, one by one vs batched
+static const size_t UDP_BENCH_DATAGRAMS = 200000;
+static const size_t UDP_BENCH_SIZE = 64;
+static const unsigned short udp_bench_port = 8334;
+
+static sb8_t udp_bench_msec()
+{
+	TERIMBER::date now;
+	return (sb8_t)now;
+}
+
+class udp_bench_pin : public terimber_aiogate_pin
+{
+public:
+	udp_bench_pin(size_t batch) : _batch(batch), _ident(0), _gate(0), _received(0), _bad(0), _last(0) {}
+
+	virtual void on_accept(const sockaddr_in& local, const sockaddr_in& remote, size_t ident, terimber_aiogate* callback) { assert(false); }
+	virtual void on_connect(const sockaddr_in& local, const sockaddr_in& remote, size_t ident, terimber_aiogate* callback) { assert(false); }
+
+	virtual void on_bind(const sockaddr_in& local, size_t ident, terimber_aiogate* callback)
+	{
+		_ident = ident;
+		_gate = callback;
+		_local = local;
+		_gate->set_udp_batch(_ident, _batch);
+		_ready.set();
+	}
+
+	virtual bool on_recv(const void* buf, size_t len, const sockaddr_in& peeraddr, bool& expected_more)
+	{
+		if (len != UDP_BENCH_SIZE)
+			++_bad;
+		++_received;
+		_last = udp_bench_msec();
+		expected_more = true;
+		return true;
+	}
+
+	virtual void on_send(const sockaddr_in& peeraddr) {}
+	virtual void on_close(ub4_t mask) {}
+
+	size_t				_batch;
+	size_t				_ident;
+	terimber_aiogate*	_gate;
+	sockaddr_in			_local;
+	volatile size_t		_received;
+	volatile size_t		_bad;
+	volatile sb8_t		_last;
+	TERIMBER::event		_ready;
+};
+
+class udp_bench_factory : public terimber_aiogate_pin_factory
+{
+public:
+	udp_bench_factory(size_t batch) : _pin(batch) {}
+
+	virtual terimber_aiogate_pin* create(void* arg) { return &_pin; }
+	virtual void destroy(terimber_aiogate_pin* pin) {}
+
+	udp_bench_pin		_pin;
+};
+
+static int socketudp_benchmark_run(size_t batch, terimber_log* log)
+{
+	udp_bench_factory receiver_factory(batch), sender_factory(batch);
+	terimber_aiogate_factory factory;
+	terimber_aiogate* rgate = factory.get_terimber_aiogate(log, 1);
+	terimber_aiogate* sgate = factory.get_terimber_aiogate(log, 1);
+	udp_bench_pin& receiver = receiver_factory._pin;
+	udp_bench_pin& sender = sender_factory._pin;
+
+	int res = -1;
+	if (!rgate->bind(server_address, udp_bench_port, &receiver_factory, 0)
+		|| !sgate->bind(server_address, udp_bench_port + 1, &sender_factory, 0)
+		|| WAIT_OBJECT_0 != receiver._ready.wait(5000)
+		|| WAIT_OBJECT_0 != sender._ready.wait(5000))
+		printf("udp benchmark: can not bind to address: %s, port: %d\n", server_address, udp_bench_port);
+	else if (!rgate->recv(receiver._ident, true, &receiver._local))
+		printf("udp benchmark: can not start receive\n");
+	else
+	{
+		ub1_t payload[UDP_BENCH_SIZE];
+		memset(payload, 0x5a, sizeof(payload));
+
+		// queues all datagrams, aiogate flushes them as fast as socket takes them
+		sb8_t start = udp_bench_msec();
+		res = 0;
+		for (size_t index = 0; index < UDP_BENCH_DATAGRAMS && !res; ++index)
+		{
+			memcpy(payload, &index, sizeof(index));
+			if (!sgate->send(sender._ident, payload, sizeof(payload), &receiver._local))
+				res = -1;
+		}
+
+		// waits until datagrams stop coming
+		TERIMBER::event ev;
+		size_t received = 0;
+		do
+		{
+			received = receiver._received;
+			ev.wait(1000);
+		}
+		while (received != receiver._received && receiver._received < UDP_BENCH_DATAGRAMS);
+
+		sb8_t msec = __max(receiver._last - start, (sb8_t)1);
+		printf("udp benchmark (batch %2d) datagrams %d: received %d, lost %d, bad %d, %d datagrams/sec\n",
+			(int)__max(batch, (size_t)1), (int)UDP_BENCH_DATAGRAMS, (int)receiver._received, 
+			(int)(UDP_BENCH_DATAGRAMS - receiver._received), (int)receiver._bad, 
+			(int)((double)receiver._received * 1000 / msec));
+
+		if (receiver._bad)
+			res = -1;
+	}
+
+	delete sgate;
+	delete rgate;
+	return res;
+}
+
+int socketudp_benchmark(size_t wait, terimber_log* log)
+{
+	int res = socketudp_benchmark_run(1, log);
+	if (!res)
+		res = socketudp_benchmark_run(16, log);
+	return res;
+}
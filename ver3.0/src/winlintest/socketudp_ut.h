@@ -2,6 +2,7 @@
 #define _terimber_socketudp_ut_h_
 
 int socketudp_unittest(size_t wait, terimber_log* log);
+int socketudp_benchmark(size_t wait, terimber_log* log);
 
 #endif
 
@@ -2,6 +2,7 @@
 #include "base/memory.hpp"
 #include "base/string.hpp"
 #include "base/list.hpp"
+#include "base/date.h"
 #include "aiogate/aiogatefactory.h"
 #include <stdlib.h>
 #include <time.h>
@@ -494,3 +495,184 @@ int stargate_unittest(size_t wait, terimber_log* log)
 
 	return 0;
 }
+
+//////////////////////////////////////////////////////
+// send throughput, copied vs referenced buffers
+static const size_t BENCH_TOTAL_BYTES = 64 * 1024 * 1024;
+static const size_t BENCH_MAX_PAYLOAD = 1024 * 1024;
+static const unsigned short bench_port = 7555;
+
+static sb8_t stargate_bench_msec()
+{
+	TERIMBER::date now;
+	return (sb8_t)now;
+}
+
+// payload is owned by benchmark, aiogate takes references
+// add_ref and release are invoked under the aiogate lock, so the plain counter is enough
+class bench_ref_buffer : public terimber_aiogate_ref_buffer
+{
+public:
+	bench_ref_buffer(const ub1_t* data) : _data(data), _size(0), _refs(0) {}
+
+	virtual const void* data() const { return _data; }
+	virtual size_t size() const { return _size; }
+	virtual void add_ref() { ++_refs; }
+	virtual void release() { --_refs; }
+
+	const ub1_t*		_data;
+	size_t				_size;
+	volatile size_t		_refs;
+};
+
+class bench_pin_impl : public terimber_aiogate_pin
+{
+public:
+	bench_pin_impl(bool receiver, const ub1_t* payload) : 
+		_receiver(receiver), _payload(payload), _size(1), _base(0), _received(0), _errors(0), _ident(0), _gate(0) 
+	{
+	}
+
+	virtual void on_accept(const sockaddr_in& local, const sockaddr_in& remote, size_t ident, terimber_aiogate* callback)
+	{
+		_ident = ident;
+		_gate = callback;
+		if (_receiver)
+			_gate->recv(_ident, true, 0);
+		_ready.set();
+	}
+
+	virtual void on_connect(const sockaddr_in& local, const sockaddr_in& remote, size_t ident, terimber_aiogate* callback)
+	{
+		on_accept(local, remote, ident, callback);
+	}
+
+	// verifies the stream is the payload repeated
+	virtual bool on_recv(const void* buf, size_t len, const sockaddr_in& peeraddr, bool& expected_more)
+	{
+		const ub1_t* ptr = (const ub1_t*)buf;
+		while (len)
+		{
+			size_t pos = (_received - _base) % _size;
+			size_t clen = __min(len, _size - pos);
+			if (memcmp(ptr, _payload + pos, clen))
+				++_errors;
+			ptr += clen;
+			len -= clen;
+			_received += clen;
+		}
+
+		expected_more = true;
+		return true;
+	}
+
+	virtual void on_bind(const sockaddr_in& local, size_t ident, terimber_aiogate* callback) { assert(false); }
+	virtual void on_send(const sockaddr_in& peeraddr) {}
+	virtual void on_close(ub4_t mask) {}
+
+	bool				_receiver;
+	const ub1_t*		_payload;
+	size_t				_size;
+	size_t				_base;
+	volatile size_t		_received;
+	volatile size_t		_errors;
+	size_t				_ident;
+	terimber_aiogate*	_gate;
+	TERIMBER::event		_ready;
+};
+
+class bench_factory_impl : public terimber_aiogate_pin_factory
+{
+public:
+	bench_factory_impl(bool receiver, const ub1_t* payload) : _pin(receiver, payload) {}
+
+	virtual terimber_aiogate_pin* create(void* arg) { return &_pin; }
+	virtual void destroy(terimber_aiogate_pin* pin) {}
+
+	bench_pin_impl		_pin;
+};
+
+static int stargate_benchmark_run(terimber_aiogate* gate, bench_pin_impl& sender, bench_pin_impl& receiver, bench_ref_buffer& ref, size_t size, bool zero_copy, size_t wait)
+{
+	size_t count = __max(BENCH_TOTAL_BYTES / size, (size_t)1);
+	size_t total = count * size;
+	size_t received = receiver._received;
+	// receiver is idle, the stream starts over with the new payload
+	receiver._size = size;
+	receiver._base = received;
+	sb8_t start = stargate_bench_msec();
+
+	ref._size = size;
+	terimber_aiogate_ref_buffer* bufs[1] = { &ref };
+	for (size_t index = 0; index < count; ++index)
+	{
+		if (zero_copy ? !gate->send_ref(sender._ident, bufs, 1) : !gate->send(sender._ident, sender._payload, size, 0))
+		{
+			printf("stargate benchmark: can not send %d bytes\n", (int)size);
+			return -1;
+		}
+	}
+
+	// waits until the receiver gets all bytes and references are given back
+	sb8_t deadline = start + __max(wait, (size_t)30) * 1000;
+	TERIMBER::event ev;
+	while (receiver._received - received < total || ref._refs)
+	{
+		if (stargate_bench_msec() > deadline)
+		{
+			printf("stargate benchmark: timeout, received %d of %d bytes\n", (int)(receiver._received - received), (int)total);
+			return -1;
+		}
+
+		ev.wait(1);
+	}
+
+	sb8_t msec = __max(stargate_bench_msec() - start, (sb8_t)1);
+	printf("stargate benchmark (%s) payload %7d: %6d sends, %5d MB/sec, errors %d\n", 
+		zero_copy ? "zero-copy" : "copy     ", (int)size, (int)count, 
+		(int)((double)total * 1000 / msec / (1024 * 1024)), (int)receiver._errors);
+
+	return receiver._errors ? -1 : 0;
+}
+
+int stargate_benchmark(size_t wait, terimber_log* log)
+{
+	ub1_t* payload = new ub1_t[BENCH_MAX_PAYLOAD];
+	for (size_t index = 0; index < BENCH_MAX_PAYLOAD; ++index)
+		payload[index] = (ub1_t)(index * 7 + (index >> 8));
+
+	bench_factory_impl receiver_factory(true, payload);
+	bench_factory_impl sender_factory(false, payload);
+	bench_ref_buffer ref(payload);
+
+	terimber_aiogate_factory factory;
+	terimber_aiogate* rgate = factory.get_terimber_aiogate(log, 1);
+	terimber_aiogate* sgate = factory.get_terimber_aiogate(log, 1);
+
+	int res = -1;
+	size_t id = rgate->listen(west_address, bench_port, 1, 1, &receiver_factory, 0);
+	if (!id)
+		printf("can not start listener on addess: %s, port: %d\n", west_address, bench_port);
+	else if (!sgate->connect(west_address, bench_port, 0, 0, 5000, &sender_factory, 0)
+		|| WAIT_OBJECT_0 != sender_factory._pin._ready.wait(5000)
+		|| WAIT_OBJECT_0 != receiver_factory._pin._ready.wait(5000))
+		printf("can not connect to addess: %s, port: %d\n", west_address, bench_port);
+	else
+	{
+		res = 0;
+		for (size_t size = 64; size <= BENCH_MAX_PAYLOAD && !res; size *= 4)
+		{
+			for (int zero_copy = 0; zero_copy < 2 && !res; ++zero_copy)
+			{
+				res = stargate_benchmark_run(sgate, sender_factory._pin, receiver_factory._pin, ref, size, zero_copy != 0, wait);
+			}
+		}
+
+		rgate->deaf(id);
+	}
+
+	delete sgate;
+	delete rgate;
+	delete [] payload;
+	return res;
+}
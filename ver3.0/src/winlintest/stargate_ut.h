@@ -2,6 +2,7 @@
 #define _terimber_stargate_ut_h_
 
 int stargate_unittest(size_t wait, terimber_log* log);
+int stargate_benchmark(size_t wait, terimber_log* log);
 
 #endif
 
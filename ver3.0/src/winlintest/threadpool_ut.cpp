@@ -1,5 +1,10 @@
 #include "base/primitives.h"
 #include "threadpool/threadpoolfactory.h"
+#include "threadpool/thread.h"
+#include "base/date.h"
+#include "base/list.hpp"
+#include "base/memory.hpp"
+#include "base/common.hpp"
 
 class processing_task
 {
@@ -107,3 +112,421 @@ int threadpool_unittest(size_t wait, terimber_log* log)
 
 	return 0;
 }
+
+const size_t BENCH_WORKERS = 4;
+const size_t BENCH_DEPTH = 18; // binary tree of tasks
+const size_t BENCH_TASKS = (1 << BENCH_DEPTH) - 1;
+const size_t BENCH_WORK = 256; // iterations per task
+
+// milliseconds
+static sb8_t bench_msec()
+{
+	TERIMBER::date now;
+	return (sb8_t)now;
+}
+
+// task is a node of implicit binary tree, children are 2n + 1 and 2n + 2
+class bench_scheduler
+{
+public:
+	bench_scheduler() : _done(new bool[BENCH_TASKS]), _cursor(0), _sink(0) {}
+	virtual ~bench_scheduler() { delete [] _done; }
+
+	virtual void submit(size_t node) = 0;
+	virtual const char* name() const = 0;
+
+	void execute(size_t node, bool fork)
+	{
+		size_t x = node;
+		for (size_t i = 0; i < BENCH_WORK; ++i)
+			x = x * 1103515245 + 12345;
+		_sink += x & 1;
+
+		if (fork)
+		{
+			if (2 * node + 1 < BENCH_TASKS)
+				submit(2 * node + 1);
+			if (2 * node + 2 < BENCH_TASKS)
+				submit(2 * node + 2);
+		}
+
+		_done[node] = true;
+	}
+
+	void run(size_t wait, bool fork)
+	{
+		_fork = fork;
+		memset((void*)_done, 0, BENCH_TASKS * sizeof(bool));
+		_cursor = 0;
+
+		sb8_t start = bench_msec();
+		if (fork)
+			submit(0);
+		else
+			for (size_t node = 0; node < BENCH_TASKS; ++node)
+				submit(node);
+
+		TERIMBER::event ev;
+		sb8_t deadline = start + wait * 1000;
+		while (!done() && bench_msec() < deadline)
+			ev.wait(1);
+
+		sb8_t elapsed = __max(bench_msec() - start, (sb8_t)1);
+		printf("threadpool benchmark (%s) %s: tasks %d of %d, %d msec, %d tasks/sec\n", 
+			name(), fork ? "fork-join" : "external submit", (int)_cursor, (int)BENCH_TASKS, (int)elapsed, (int)((sb8_t)_cursor * 1000 / elapsed));
+	}
+
+protected:
+	bool done()
+	{
+		while (_cursor < BENCH_TASKS && _done[_cursor])
+			++_cursor;
+		return _cursor == BENCH_TASKS;
+	}
+
+	volatile bool*	_done;
+	size_t			_cursor;
+	size_t			_sink;
+	bool			_fork;
+};
+
+// current pool, the client keeps the queue and asks for threads like aiosock does
+class pool_scheduler : public bench_scheduler, public terimber_thread_employer
+{
+public:
+	pool_scheduler(terimber_log* log)
+	{
+		terimber_threadpool_factory factory;
+		_pool = factory.get_thread_pool(log, BENCH_WORKERS, 10000);
+	}
+
+	~pool_scheduler()
+	{
+		_pool->revoke_client(this);
+		delete _pool;
+	}
+
+	virtual void submit(size_t node)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		_queue.push_back(node);
+		keeper.unlock();
+
+		if (!_pool->borrow_from_range(0, BENCH_WORKERS - 1, 0, this, 100))
+			_pool->borrow_thread(0, 0, this, 100);
+	}
+
+	virtual const char* name() const { return "borrow_thread"; }
+
+	virtual bool v_has_job(size_t ident, void* data)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		return !_queue.empty();
+	}
+
+	virtual void v_do_job(size_t ident, void* data)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		if (_queue.empty())
+			return;
+		size_t node = _queue.front();
+		_queue.pop_front();
+		keeper.unlock();
+
+		execute(node, _fork);
+	}
+
+private:
+	terimber_threadpool*		_pool;
+	TERIMBER::mutex				_mtx;
+	TERIMBER::list< size_t >	_queue;
+};
+
+class executor_scheduler;
+
+class bench_task : public terimber_task
+{
+public:
+	bench_task() : _owner(0), _node(0) {}
+	virtual void v_execute();
+
+	executor_scheduler*	_owner;
+	size_t				_node;
+};
+
+class executor_scheduler : public bench_scheduler
+{
+public:
+	executor_scheduler(terimber_log* log) : _tasks(new bench_task[BENCH_TASKS])
+	{
+		terimber_threadpool_factory factory;
+		_executor = factory.get_executor(log, BENCH_WORKERS);
+		for (size_t node = 0; node < BENCH_TASKS; ++node)
+			_tasks[node]._owner = this, _tasks[node]._node = node;
+	}
+
+	~executor_scheduler()
+	{
+		_executor->doxray();
+		delete _executor;
+		delete [] _tasks;
+	}
+
+	virtual void submit(size_t node)
+	{
+		_executor->submit(&_tasks[node]);
+	}
+
+	virtual const char* name() const { return "executor"; }
+
+	void execute_task(size_t node) { execute(node, _fork); }
+
+private:
+	terimber_executor*	_executor;
+	bench_task*			_tasks;
+};
+
+void bench_task::v_execute()
+{
+	_owner->execute_task(_node);
+}
+
+// checks employer adapter, counts jobs on executor
+class executor_client : public terimber_thread_employer
+{
+public:
+	executor_client() : _jobs(0), _done(0) {}
+
+	virtual bool v_has_job(size_t ident, void* data)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		return _jobs > 0;
+	}
+
+	virtual void v_do_job(size_t ident, void* data)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		if (_jobs)
+			--_jobs, ++_done;
+	}
+
+	void add(size_t jobs)
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		_jobs += jobs;
+	}
+
+	size_t done()
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		return _done;
+	}
+
+private:
+	size_t			_jobs;
+	size_t			_done;
+	TERIMBER::mutex	_mtx;
+};
+
+int threadpool_benchmark(size_t wait, terimber_log* log)
+{
+	{
+		pool_scheduler pool(log);
+		pool.run(wait, false);
+		pool.run(wait, true);
+	}
+
+	{
+		executor_scheduler exec(log);
+		exec.run(wait, false);
+		exec.run(wait, true);
+	}
+
+	// existing employer on executor
+	terimber_threadpool_factory factory;
+	terimber_executor* exec = factory.get_executor(log, BENCH_WORKERS);
+	executor_client client;
+	TERIMBER::event ev;
+	for (size_t loop = 0; loop < 100; ++loop)
+	{
+		client.add(1000);
+		if (!exec->borrow_from_range(0, BENCH_WORKERS - 1, 0, &client, 100))
+			exec->borrow_thread(0, 0, &client, 100);
+	}
+
+	sb8_t deadline = bench_msec() + wait * 1000;
+	while (client.done() < 100000 && bench_msec() < deadline)
+		ev.wait(1);
+
+	printf("threadpool benchmark (executor) employer adapter: jobs %d of %d\n", (int)client.done(), 100000);
+	exec->revoke_client(&client);
+	delete exec;
+	return 0;
+}
+
+const size_t ALLOC_BENCH_OPS = 1000000; // per thread
+const size_t ALLOC_BENCH_BATCH = 32; // objects in flight per thread
+const size_t ALLOC_BENCH_MAX_THREADS = 8;
+
+struct alloc_bench_node
+{
+	size_t	_key;
+	void*	_left;
+	void*	_right;
+};
+
+// single threaded allocators are shared under mutex like in aiosock and threadpool
+class locked_node_policy
+{
+public:
+	void* allocate(size_t) { TERIMBER::mutexKeeper keeper(_mtx); return _allocator.allocate(); }
+	void deallocate(void* p) { TERIMBER::mutexKeeper keeper(_mtx); _allocator.deallocate(p); }
+	static const char* name() { return "node_allocator + mutex"; }
+private:
+	TERIMBER::mutex										_mtx;
+	TERIMBER::node_allocator< alloc_bench_node >		_allocator;
+};
+
+class concurrent_node_policy
+{
+public:
+	void* allocate(size_t) { return _allocator.allocate(); }
+	void deallocate(void* p) { _allocator.deallocate(p); }
+	static const char* name() { return "concurrent_node_allocator"; }
+private:
+	TERIMBER::concurrent_node_allocator< alloc_bench_node >	_allocator;
+};
+
+class locked_array_policy
+{
+public:
+	void* allocate(size_t n) { TERIMBER::mutexKeeper keeper(_mtx); return _allocator.allocate(n); }
+	void deallocate(void* p) { TERIMBER::mutexKeeper keeper(_mtx); _allocator.deallocate(p); }
+	static const char* name() { return "array_allocator + mutex"; }
+private:
+	TERIMBER::mutex										_mtx;
+	TERIMBER::array_allocator< size_t >					_allocator;
+};
+
+class concurrent_array_policy
+{
+public:
+	void* allocate(size_t n) { return _allocator.allocate(n); }
+	void deallocate(void* p) { _allocator.deallocate(p); }
+	static const char* name() { return "concurrent_array_allocator"; }
+private:
+	TERIMBER::concurrent_array_allocator< size_t >		_allocator;
+};
+
+// each thread allocates a batch of objects and frees it back
+template < class P >
+class alloc_bench_client : public terimber_thread_employer
+{
+public:
+	alloc_bench_client(size_t threads, bool arrays) : _threads(threads), _arrays(arrays), _errors(0)
+	{
+		for (size_t index = 0; index < threads; ++index)
+			_done[index] = false;
+	}
+
+	virtual bool v_has_job(size_t ident, void* data)
+	{
+		return !_done[ident];
+	}
+
+	virtual void v_do_job(size_t ident, void* data)
+	{
+		void* batch[ALLOC_BENCH_BATCH];
+		size_t seed = ident + 1, errors = 0;
+
+		for (size_t op = 0; op < ALLOC_BENCH_OPS; op += ALLOC_BENCH_BATCH)
+		{
+			for (size_t index = 0; index < ALLOC_BENCH_BATCH; ++index)
+			{
+				seed = seed * 1103515245 + 12345;
+				size_t n = _arrays ? (seed >> 16) % 32 + 1 : 1;
+				if (!(batch[index] = _policy.allocate(n)))
+					++errors;
+				else
+					*(size_t*)batch[index] = ident;
+			}
+
+			for (size_t index = 0; index < ALLOC_BENCH_BATCH; ++index)
+			{
+				if (batch[index] && *(size_t*)batch[index] != ident)
+					++errors;
+				_policy.deallocate(batch[index]);
+			}
+		}
+
+		TERIMBER::mutexKeeper keeper(_mtx);
+		_errors += errors;
+		_done[ident] = true;
+	}
+
+	bool done()
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		for (size_t index = 0; index < _threads; ++index)
+			if (!_done[index])
+				return false;
+		return true;
+	}
+
+	size_t errors()
+	{
+		TERIMBER::mutexKeeper keeper(_mtx);
+		return _errors;
+	}
+
+private:
+	P					_policy;
+	size_t				_threads;
+	bool				_arrays;
+	size_t				_errors;
+	volatile bool		_done[ALLOC_BENCH_MAX_THREADS];
+	TERIMBER::mutex		_mtx;
+};
+
+template < class P >
+static void allocator_benchmark_run(size_t wait, size_t threads, bool arrays)
+{
+	alloc_bench_client< P > client(threads, arrays);
+	TERIMBER::thread workers[ALLOC_BENCH_MAX_THREADS];
+
+	sb8_t start = bench_msec();
+	for (size_t index = 0; index < threads; ++index)
+	{
+		TERIMBER::job_task task(&client, index, INFINITE, 0);
+		workers[index].start();
+		workers[index].assign_job(task);
+	}
+
+	TERIMBER::event ev;
+	sb8_t deadline = start + wait * 1000;
+	while (!client.done() && bench_msec() < deadline)
+		ev.wait(1);
+
+	sb8_t elapsed = __max(bench_msec() - start, (sb8_t)1);
+	printf("allocator benchmark (%s) threads %d: %d ops/msec, errors %d\n", 
+		P::name(), (int)threads, (int)((sb8_t)threads * ALLOC_BENCH_OPS * 2 / elapsed), (int)client.errors());
+
+	for (size_t index = 0; index < threads; ++index)
+	{
+		workers[index].cancel_job();
+		workers[index].stop();
+	}
+}
+
+int allocator_benchmark(size_t wait, terimber_log* log)
+{
+	for (size_t threads = 1; threads <= ALLOC_BENCH_MAX_THREADS; threads *= 2)
+	{
+		allocator_benchmark_run< locked_node_policy >(wait, threads, false);
+		allocator_benchmark_run< concurrent_node_policy >(wait, threads, false);
+		allocator_benchmark_run< locked_array_policy >(wait, threads, true);
+		allocator_benchmark_run< concurrent_array_policy >(wait, threads, true);
+	}
+
+	return 0;
+}
@@ -2,6 +2,7 @@
 #define _terimber_threadpool_ut_h_
 
 int threadpool_unittest(size_t wait, terimber_log* log);
+int threadpool_benchmark(size_t wait, terimber_log* log);
+int allocator_benchmark(size_t wait, terimber_log* log);
 
 #endif
-
@@ -0,0 +1,220 @@
+#include "allinc.h"
+#include "log.h"
+#include "xml/xmlaccss.h"
+#include <string>
+
+// records stream events as one string
+class xml_test_handler : public xml_stream_handler
+{
+public:
+	virtual bool start_element(const char* name, const char* const* attributes)
+	{
+		_events += "<";
+		_events += name;
+		for (; *attributes; attributes += 2)
+		{
+			_events += " ";
+			_events += attributes[0];
+			_events += "=[";
+			_events += attributes[1];
+			_events += "]";
+		}
+		_events += ">";
+		return true;
+	}
+
+	virtual bool characters(const char* value, bool cdata)
+	{
+		_events += cdata ? "{C:" : "{T:";
+		_events += value;
+		_events += "}";
+		return true;
+	}
+
+	virtual bool end_element(const char* name)
+	{
+		_events += "</";
+		_events += name;
+		_events += ">";
+		return true;
+	}
+
+	std::string _events;
+};
+
+static int xml_test_stream(xml_designer* designer, const std::string& xml, const std::string& expected)
+{
+	xml_test_handler handler;
+	if (!designer->parse(xml.c_str(), xml.size(), 0, handler, false))
+	{
+		printf("xml stream error: %s\n", designer->error());
+		return -1;
+	}
+
+	if (handler._events != expected)
+	{
+		printf("xml stream mismatch:\n  xml: %s\n  got: %s\n  expected: %s\n", xml.c_str(), handler._events.c_str(), expected.c_str());
+		return -1;
+	}
+
+	return 0;
+}
+
+static int xml_test_error(xml_designer* designer, const char* xml, const char* expected)
+{
+	xml_test_handler handler;
+	if (designer->parse(xml, strlen(xml), 0, handler, false))
+	{
+		printf("xml error expected: %s\n", xml);
+		return -1;
+	}
+
+	if (!strstr(designer->error(), expected))
+	{
+		printf("xml error mismatch:\n  xml: %s\n  got: %s\n  expected: %s\n", xml, designer->error(), expected);
+		return -1;
+	}
+
+	return 0;
+}
+
+// pulls events by cursor in the same format as xml_test_handler
+static int xml_test_cursor(xml_designer* designer, const std::string& xml, const std::string& expected)
+{
+	xml_stream_cursor* cursor = designer->open_cursor(xml.c_str(), xml.size(), 0, false);
+	if (!cursor)
+	{
+		printf("xml cursor error: %s\n", designer->error());
+		return -1;
+	}
+
+	std::string events;
+	while (cursor->next())
+	{
+		switch (cursor->get_event())
+		{
+			case START_ELEMENT_EVENT:
+				{
+					events += "<";
+					events += cursor->get_name();
+					for (const char* const* attributes = cursor->get_attributes(); *attributes; attributes += 2)
+					{
+						events += " ";
+						events += attributes[0];
+						events += "=[";
+						events += attributes[1];
+						events += "]";
+					}
+					events += ">";
+				}
+				break;
+			case CHARACTERS_EVENT:
+				events += cursor->is_cdata() ? "{C:" : "{T:";
+				events += cursor->get_value();
+				events += "}";
+				break;
+			case END_ELEMENT_EVENT:
+				events += "</";
+				events += cursor->get_name();
+				events += ">";
+				break;
+		}
+	}
+
+	int res = 0;
+	if (cursor->error() && cursor->error()[0])
+	{
+		printf("xml cursor error: %s\n", cursor->error());
+		res = -1;
+	}
+	else if (events != expected)
+	{
+		printf("xml cursor mismatch:\n  xml: %s\n  got: %s\n  expected: %s\n", xml.c_str(), events.c_str(), expected.c_str());
+		res = -1;
+	}
+	else if (cursor->next() || cursor->get_name())
+	{
+		printf("xml cursor moves after the end: %s\n", xml.c_str());
+		res = -1;
+	}
+
+	delete cursor;
+	return res;
+}
+
+// cursor gives out events preceding the error
+static int xml_test_cursor_error(xml_designer* designer, const char* xml, size_t events, const char* expected)
+{
+	xml_stream_cursor* cursor = designer->open_cursor(xml, strlen(xml), 0, false);
+	if (!cursor)
+	{
+		printf("xml cursor error: %s\n", designer->error());
+		return -1;
+	}
+
+	size_t count = 0;
+	while (cursor->next())
+		++count;
+
+	int res = 0;
+	if (count != events || !cursor->error() || !strstr(cursor->error(), expected))
+	{
+		printf("xml cursor error mismatch:\n  xml: %s\n  got: %d %s\n  expected: %d %s\n", xml, (int)count, cursor->error(), (int)events, expected);
+		res = -1;
+	}
+
+	delete cursor;
+	return res;
+}
+
+// push parser and cursor give the same events
+static int xml_test_both(xml_designer* designer, const std::string& xml, const std::string& expected)
+{
+	return xml_test_stream(designer, xml, expected) | xml_test_cursor(designer, xml, expected);
+}
+
+int xml_unittest(size_t wait, terimber_log* log)
+{
+	xml_factory factory;
+	xml_designer* designer = factory.get_xml_designer();
+	int res = 0;
+
+	// text after CDATA section
+	res |= xml_test_both(designer, "<a><![CDATA[q]]>yy<b/>zz</a>", "<a>{C:q}{T:yy}<b></b>{T:zz}</a>");
+	res |= xml_test_both(designer, "<a><![CDATA[x]] ]]]>\n  tail  <![CDATA[]]></a>", "<a>{C:x]] ]}{T:tail}{C:}</a>");
+
+	// entities, trailing white space and attribute normalization
+	res |= xml_test_both(designer, "<a x='  1 \t 2 ' y=\"&lt;&amp;\">one &amp; two\n  <b>three</b>\n</a>",
+		"<a x=[ 1 2] y=[<&]>{T:one & two}<b>{T:three}</b></a>");
+
+	// long runs across several input buffers
+	std::string text, value;
+	for (size_t index = 0; index < 2000; ++index)
+	{
+		text += "word ";
+		value += "v";
+	}
+
+	text += "end";
+	res |= xml_test_both(designer, "<a v='" + value + "'>" + text + "</a>", "<a v=[" + value + "]>{T:" + text + "}</a>");
+
+	// errors keep line and position
+	res |= xml_test_error(designer, "<a>\n  text ]]> here</a>", "Illegal char sequence ]]> in CharData");
+	res |= xml_test_error(designer, "<a>\n\n  <b x='a<b'/></a>", "Error on line: 3");
+	res |= xml_test_cursor_error(designer, "<a>one<b>two</b>\n  text ]]> here</a>", 5, "Illegal char sequence ]]> in CharData");
+	res |= xml_test_cursor_error(designer, "<a><b></a>", 2, "Error on line: 1");
+
+	// prolog errors are reported by open_cursor
+	if (designer->open_cursor("<?xml version='2.0'?><a/>", 25, 0, false))
+	{
+		printf("xml cursor error expected on prolog\n");
+		res = -1;
+	}
+
+	// nested elements, misc after root
+	res |= xml_test_both(designer, "<?xml version='1.0'?><!-- c --><r><a k='1'><b/></a><c>x</c></r><?pi?>",
+		"<r><a k=[1]><b></b></a><c>{T:x}</c></r>");
+
+	delete designer;
+	return res;
+}
@@ -0,0 +1,6 @@
+#ifndef _terimber_xml_ut_h_
+#define _terimber_xml_ut_h_
+
+int xml_unittest(size_t wait, terimber_log* log);
+
+#endif
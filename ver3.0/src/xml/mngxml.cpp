@@ -229,6 +229,9 @@ byte_manager::parseQuotedValue(bool resolve_entities, bool normalize, bool (*fn)
 	bool white_space_met = false;
 	// gets the first simbol
 	ub1_t symbol = pick();
+	// plain run
+	const ub1_t* run = 0;
+	size_t run_len = 0;
 
 	// looking until exists byte stream or close quote found
 	while (symbol && symbol != quote_symbol)
@@ -289,10 +292,28 @@ byte_manager::parseQuotedValue(bool resolve_entities, bool normalize, bool (*fn)
 					white_space_met = false;
 				}
 
-				// pushes symbol to store
-				_tmp_store3 << symbol;
-				// gets next symbol
-				symbol = pop();
+				// copies the run of plain bytes at once
+				if ((run_len = pick_attribute_value(run, quote_symbol)) != 0)
+				{
+					// the run has no '<' and '&', so attribute chars need no checking
+					if (check && fn != is_attribute_char)
+					{
+						for (size_t index = 1; index < run_len; ++index)
+							if (!fn(run[index]))
+								throw_exception(message);
+					}
+
+					_tmp_store3.append(run, run_len);
+					skip_run(run_len);
+					symbol = pick();
+				}
+				else // markup or control byte
+				{
+					// pushes symbol to store
+					_tmp_store3 << symbol;
+					// gets next symbol
+					symbol = pop();
+				}
 		} // switch
 	}
 
@@ -88,6 +88,27 @@ protected:
 	push(			const ub1_t* x,							//!< pointer to array						
 					size_t len								//!< array length
 					);
+	//! \brief returns the run of character data up to '<', '&' or ']'
+	xml_forceinline 
+	size_t 
+	pick_char_data(	const ub1_t*& x							//!< [out] run
+					);
+	//! \brief returns the run of CDATA content up to ']'
+	xml_forceinline 
+	size_t 
+	pick_cdata(		const ub1_t*& x							//!< [out] run
+					);
+	//! \brief returns the run of attribute value up to quote, markup or white space
+	xml_forceinline 
+	size_t 
+	pick_attribute_value(const ub1_t*& x,					//!< [out] run
+					ub1_t quote								//!< quote symbol
+					);
+	//! \brief skips the picked run
+	xml_forceinline 
+	void 
+	skip_run(		size_t count							//!< bytes to skip
+					);
 	//! \brief throws exception, adding line and char position info	
 	xml_forceinline 
 	void 
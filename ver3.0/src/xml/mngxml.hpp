@@ -83,6 +83,34 @@ byte_manager::push(const ub1_t* x, size_t len)
 	_stream.push(x, len); 
 }
 
+xml_forceinline 
+size_t 
+byte_manager::pick_char_data(const ub1_t*& x) 
+{ 
+	return _stream.pick_char_data(x); 
+}
+
+xml_forceinline 
+size_t 
+byte_manager::pick_cdata(const ub1_t*& x) 
+{ 
+	return _stream.pick_cdata(x); 
+}
+
+xml_forceinline 
+size_t 
+byte_manager::pick_attribute_value(const ub1_t*& x, ub1_t quote) 
+{ 
+	return _stream.pick_attribute_value(x, quote); 
+}
+
+xml_forceinline 
+void 
+byte_manager::skip_run(size_t count) 
+{ 
+	_stream.skip_run(count); 
+}
+
 xml_forceinline 
 void 
 byte_manager::throw_exception(const char* msg_text) 
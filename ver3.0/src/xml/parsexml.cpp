@@ -53,16 +53,21 @@ xml_processor::xml_processor(byte_source& stream,
 							 mem_pool_t& small_pool,
 							 mem_pool_t& big_pool,
 							 size_t xml_size,
-							 bool validate) :
+							 bool validate,
+							 xml_stream_handler* handler) :
 	byte_manager(stream, doc, small_pool, big_pool, xml_size),
 	_doc(doc),
-	_validate(validate)
+	_validate(validate),
+	_handler(handler)
 {
 	_white_space_allocator = _small_pool.loan_object();
 }
 
 xml_processor::~xml_processor()
 {
+	if (_handler)
+		stream_reset();
+
 	_small_pool.return_object(_white_space_allocator);
 }
 
@@ -78,16 +83,8 @@ xml_processor::parse()
 {
 	try
 	{
-		// puts document to the stack
-		_doc.container_reset();
-		_white_space_stack.clear();
-		_white_space_allocator->reset();
-
-		_entity_map.clear();
-		_entity_allocator->reset();
-		_preserve_white_space = false;
-    
-		_doc.add_escaped_symbols();
+		reset_document();
+
 		// we suppose that the byte_source is a UTF-8 sequence of chars
 		// also byte_source internally try to define the current charset automatically
 		// or we can set the encoding schema explicitly
@@ -96,13 +93,29 @@ xml_processor::parse()
 		// [1]    document    ::=    prolog element Misc* 
 		parseDocument();
 
-		// skips tailing white chars
-		skip_white_space();
+		complete_document();
+	}
+	catch (exception& x)
+	{
+		_error = x.what();
+		return false;
+	}
+	catch (...)
+	{
+		_error = "Unexpected exception has been thrown";
+		return false;
+	}
 
-		if (pick() != 0) // something unrecognized after document
-			throw_exception("Unrecognized chars after document");
+	return true;
+}
 
-		resolve_references();
+bool
+xml_processor::start()
+{
+	try
+	{
+		reset_document();
+		parseDocumentStart();
 	}
 	catch (exception& x)
 	{
@@ -118,17 +131,94 @@ xml_processor::parse()
 	return true;
 }
 
+bool
+xml_processor::step()
+{
+	try
+	{
+		if (parseElementStep())
+			return true;
+
+		parseDocumentEnd();
+		complete_document();
+	}
+	catch (exception& x)
+	{
+		_error = x.what();
+	}
+	catch (...)
+	{
+		_error = "Unexpected exception has been thrown";
+	}
+
+	return false;
+}
+
+void  
+xml_processor::reset_document()
+{
+	// puts document to the stack
+	_doc.container_reset();
+	_white_space_stack.clear();
+	_white_space_allocator->reset();
+
+	_entity_map.clear();
+	_entity_allocator->reset();
+	_preserve_white_space = false;
+
+	_doc.add_escaped_symbols();
+
+	if (_handler)
+	{
+		// the document level keeps nodes beneath the document, the root element included
+		stream_reset();
+		_level_stack.push(_level_allocator, xml_stream_level(0, _small_pool.loan_object()));
+		_doc.set_node_allocator(_level_stack.top()._nodes);
+	}
+}
+
+void  
+xml_processor::complete_document()
+{
+	// skips tailing white chars
+	skip_white_space();
+
+	if (pick() != 0) // something unrecognized after document
+		throw_exception("Unrecognized chars after document");
+
+	resolve_references();
+}
+
 void  
 xml_processor::parseDocument()
 {
 	// [1]    document    ::=    prolog element Misc* 
+	parseDocumentStart();
+
+	// [39]    element    ::=    EmptyElemTag | STag content ETag 
+	while (parseElementStep())
+		;
+
+	parseDocumentEnd();
+}
+
+void  
+xml_processor::parseDocumentStart()
+{
 	parseProlog();
 
 	// sets standalone in advance
 	if (_doc._standalone != os_minus_one)
 		_doc._standalone = get_standalone();
-	
-	parseElement();
+
+	skip_white_space();
+	if (pick() == ch_ampersand)
+		parseGeneralReference(true);
+}
+
+void  
+xml_processor::parseDocumentEnd()
+{
 	// checks completion
 	if (_doc.container_peak())
 		throw_exception("Invalid Root element syntax");
@@ -277,42 +367,38 @@ xml_processor::parseMisc()
 	} // while
 }
 
-void  
-xml_processor::parseElement()
+bool  
+xml_processor::parseElementStep()
 {
-	skip_white_space();
-	if (pick() == ch_ampersand)
-		parseGeneralReference(true);
+	if (pick() != ch_open_angle)
+		return false;
 
-	// [39]    element    ::=    EmptyElemTag | STag content ETag 
-	while (pick() == ch_open_angle)
+	switch (pop())
 	{
-		switch (pop())
-		{
-			case ch_forward_slash: // '</'
-				pop(); // skips slash
-				parseEndTag();
-				// checks element stack
-				if (!_doc.container_peak())
-					return;
-
-				parseContent();
-				break;
-			default:
-				// EmptyElemTag | STag
-				parseStartTag();
-				// check element stack
-				if (!_doc.container_peak())
-					return;
-
-				// [43]    content    ::=    CharData? ((element | Reference | CDSect | PI | Comment) CharData?)* 
-				parseContent();
-				break;
-		} // switch
-
-		reset_all_tmp(true);
-		_doc.get_tmp_allocator().reset();
-	} // while
+		case ch_forward_slash: // '</'
+			pop(); // skips slash
+			parseEndTag();
+			// checks element stack
+			if (!_doc.container_peak())
+				return false;
+
+			parseContent();
+			break;
+		default:
+			// EmptyElemTag | STag
+			parseStartTag();
+			// check element stack
+			if (!_doc.container_peak())
+				return false;
+
+			// [43]    content    ::=    CharData? ((element | Reference | CDSect | PI | Comment) CharData?)* 
+			parseContent();
+			break;
+	} // switch
+
+	reset_all_tmp(true);
+	_doc.get_tmp_allocator().reset();
+	return true;
 }
 
 void 
@@ -397,6 +483,8 @@ xml_processor::parseCDATA()
 	size_t square_counter = 0;
 	_tmp_store1.reset();
 	ub1_t symbol = pick();
+	const ub1_t* run = 0;
+	size_t len = 0;
 	while (symbol)
 	{
 		switch (symbol)
@@ -411,15 +499,29 @@ xml_processor::parseCDATA()
 					while (square_counter-- > 2)
 						_tmp_store1 << ch_close_square;
 
-					_doc.add_cdata(_tmp_store1.persist());
+					if (_handler)
+						stream_text(_tmp_store1.persist(), true);
+					else
+						_doc.add_cdata(_tmp_store1.persist());
+
+					// text after section must not see CDATA bytes
+					_tmp_store1.reset();
 					return;
 				}
 			default:
 				while (square_counter--)
 					_tmp_store1 << ch_close_square;
 
-				_tmp_store1 << symbol;
 				square_counter = 0;
+				// copies the run up to the next ']' at once
+				// pop below skips the last byte of run
+				if ((len = pick_cdata(run)) != 0)
+				{
+					_tmp_store1.append(run, len);
+					skip_run(len - 1);
+				}
+				else
+					_tmp_store1 << symbol;
 		} // switch
 
 		symbol = pop();
@@ -436,6 +538,8 @@ xml_processor::_parseCharData()
 	// [14]    CharData    ::=  ,//  [^<&]* - ([^<&]* ']]>' [^<&]*) 
 	ub1_t symbol = pick();
 	size_t illegal = 0;
+	const ub1_t* run = 0;
+	size_t run_len = 0, tail = 0;
 
 	while (symbol && symbol != ch_open_angle)
 	{
@@ -456,7 +560,12 @@ xml_processor::_parseCharData()
 					const ub1_t* bptr = _tmp_store2.persist(len);
 					push(bptr, len);
  					if (_tmp_store3.size())
-						_doc.add_text(_tmp_store3.persist());
+					{
+						if (_handler)
+							stream_text(_tmp_store3.persist(), false);
+						else
+							_doc.add_text(_tmp_store3.persist());
+					}
 
 					reset_all_tmp();
 					return;
@@ -497,9 +606,14 @@ xml_processor::_parseCharData()
 				symbol = pop();
 				break;
 			default:
-				if (is_white_space(symbol))
-					_tmp_store1 << symbol;
-				else
+				// copies the run up to the next '<', '&' or ']' at once
+				// the trailing white spaces are kept aside as for single bytes
+				run_len = pick_char_data(run);
+				tail = run_len;
+				while (tail && is_white_space(run[tail - 1]))
+					--tail;
+
+				if (tail)
 				{
 					if (_tmp_store1.size())
 					{
@@ -507,11 +621,14 @@ xml_processor::_parseCharData()
 						_tmp_store1.reset();
 					}
 
-					_tmp_store3 << symbol;
+					_tmp_store3.append(run, tail);
 				}
 
+				_tmp_store1.append(run + tail, run_len - tail);
+
 				illegal = 0;
-				symbol = pop();
+				skip_run(run_len);
+				symbol = pick();
 				break;
 		} // switch
 	} // while
@@ -519,7 +636,12 @@ xml_processor::_parseCharData()
 	if (_tmp_store1.size() && _preserve_white_space)
 		_tmp_store3 << _tmp_store1.persist();
 	if (_tmp_store3.size())
-		_doc.add_text(_tmp_store3.persist());
+	{
+		if (_handler)
+			stream_text(_tmp_store3.persist(), false);
+		else
+			_doc.add_text(_tmp_store3.persist());
+	}
 
 	reset_all_tmp();
 }
@@ -595,6 +717,107 @@ xml_processor::parseGeneralReference(bool skip_after)
 
 }
 
+void 
+xml_processor::stream_start(xml_element& el)
+{
+	xml_stream_level& parent = _level_stack.top();
+	// the parent keeps only the validation state instead of the children list
+	if (_validate && parent._el)
+		parent._state = _doc.validate_child(*parent._el, parent._state, el);
+
+	parent._has_children = true;
+
+	// attributes as name/value pairs
+	size_t count = 0;
+	for (const xml_tree_node* attr = el._first_attr; attr; attr = attr->_right)
+		++count;
+
+	const char** attributes = (const char**)check_pointer(_tmp_allocator->allocate((count * 2 + 1) * sizeof(const char*)));
+	const char** pair = attributes;
+	for (const xml_tree_node* attr = el._first_attr; attr; attr = attr->_right)
+	{
+		*pair++ = attr->_decl->_name;
+		*pair++ = xml_value_node::cast_to_node_value(attr)->persist(*_tmp_allocator);
+	}
+
+	*pair = 0;
+
+	if (!_handler->start_element(el._decl->_name, attributes))
+		throw_exception("Parsing is stopped by handler");
+}
+
+void 
+xml_processor::stream_push(xml_element* el)
+{
+	_level_stack.push(_level_allocator, xml_stream_level(el, _small_pool.loan_object()));
+	_doc.set_node_allocator(_level_stack.top()._nodes);
+}
+
+void 
+xml_processor::stream_close(xml_element& el)
+{
+	size_t state = 0;
+	bool has_children = false;
+
+	// empty element tag has no level
+	if (_level_stack.top()._el == &el)
+	{
+		state = _level_stack.top()._state;
+		has_children = _level_stack.top()._has_children;
+		_small_pool.return_object(_level_stack.top()._nodes);
+		_level_stack.pop(_level_allocator);
+		_doc.set_node_allocator(_level_stack.top()._nodes);
+	}
+
+	if (_validate)
+		_doc.validate_final(el, state, has_children);
+
+	if (!_handler->end_element(el._decl->_name))
+		throw_exception("Parsing is stopped by handler");
+
+	// the root element is the member of document
+	if (&el != &_doc.get_root_element())
+	{
+		// the closed element was the only node alive on the parent level
+		xml_container::cast_to_container(el._parent)->remove_node(&el);
+		_level_stack.top()._nodes->reset();
+	}
+}
+
+void 
+xml_processor::stream_text(const char* value, bool cdata)
+{
+	_level_stack.top()._has_children = true;
+
+	if (!_handler->characters(value, cdata))
+		throw_exception("Parsing is stopped by handler");
+}
+
+void 
+xml_processor::stream_misc()
+{
+	xml_stream_level& level = _level_stack.top();
+	level._has_children = true;
+
+	// comments and processing instructions are not reported
+	while (level._el->_last_child)
+		level._el->remove_node(level._el->_last_child);
+
+	level._nodes->reset();
+}
+
+void 
+xml_processor::stream_reset()
+{
+	while (!_level_stack.empty())
+	{
+		_small_pool.return_object(_level_stack.top()._nodes);
+		_level_stack.pop(_level_allocator);
+	}
+
+	_doc.set_node_allocator(0);
+}
+
 #pragma pack()
 END_TERIMBER_NAMESPACE
 
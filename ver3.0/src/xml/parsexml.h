@@ -56,33 +56,86 @@ public:
 //! \brief stack of white spaces informations
 typedef _stack< xml_white_space_handler >	xml_white_space_stack_t;
 
+//////////////////////////////////////////////////////////
+//! \class xml_stream_level
+//! \brief open element info for the streaming mode
+class xml_stream_level
+{
+public:
+	//! \brief constructor
+	xml_stream_level(xml_element* el,						//!< open element, null for the document
+					byte_allocator* nodes					//!< allocator for the children nodes
+					) :
+		_el(el),
+		_nodes(nodes),
+		_state(0),
+		_has_children(false)
+	{
+	}
+
+	xml_element*			_el;							//!< open element, null for the document
+	byte_allocator*			_nodes;							//!< allocator for the children nodes
+	size_t					_state;							//!< validation state of children
+	bool					_has_children;					//!< flag if any child node has been found
+};
+
+//! \typedef xml_stream_level_allocator_t
+//! \brief node allocator for stack of open elements
+typedef node_allocator< base_stack< xml_stream_level >::_node >		xml_stream_level_allocator_t;
+//! \typedef xml_stream_level_stack_t
+//! \brief stack of open elements
+typedef _stack< xml_stream_level, xml_stream_level_allocator_t >	xml_stream_level_stack_t;
+
 //! \class xml_processor
 //! \brief xml processor main class
 class xml_processor : public byte_manager
 {
 public:
 	//! \brief consrtuctor
+	//! if the handler is specified, the processor reports elements and text to the handler 
+	//! and releases each element as soon as it is closed, the document keeps only open elements
 	xml_processor(	byte_source& stream,					//!< byte stream
 					xml_document& doc,						//!< xml document
 					mem_pool_t& small_pool,					//!< small memory pool
 					mem_pool_t& big_pool,					//!< big memory pool
 					size_t xml_size,						//!< xml size - just a tip
-					bool validate							//!< validation flag
+					bool validate,							//!< validation flag
+					xml_stream_handler* handler = 0			//!< optional streaming handler
 					);
 	//! \brief destructor
 	~xml_processor();
 	//! \brief parser document
 	bool 
 	parse();
+	//! \brief starts parsing step by step, parses prolog
+	//! the handler is required, see step function
+	bool 
+	start();
+	//! \brief parses the next tag and the content following it, reports them to the handler
+	//! returns false when the document is parsed completely or on error, the error is not empty then
+	bool 
+	step();
 	//! \brief returns the last error
 	const char* 
 	get_error() const;
 
 private:
+	//! \brief resets document and stacks before parsing
+	void 
+	reset_document();
+	//! \brief checks the rest of stream and resolves references after parsing
+	void 
+	complete_document();
 	//! \brief parses document
 	//! [1]    document    ::=    prolog element Misc* 
 	void 
 	parseDocument();
+	//! \brief parses prolog and moves to the root element
+	void 
+	parseDocumentStart();
+	//! \brief checks the root element and parses Misc after it
+	void 
+	parseDocumentEnd();
 
 	//! \brief parses prolog
 	//! [22]    prolog    ::=    XMLDecl? Misc* (doctypedecl Misc*)? 
@@ -93,10 +146,11 @@ private:
 	//! [28] doctypedecl    ::=    '<!DOCTYPE' S Name (S ExternalID)? S? ('[' (markupdecl | DeclSep)* ']' S?)? '>' 
 	void 
 	parseDocTypeDecl();
-	//! \brief parses xml element
+	//! \brief parses one tag of xml element and the content following it
+	//! returns false if there is no tag or the root element is closed
 	//! [39]    element    ::=    EmptyElemTag | STag content ETag 
-	void 
-	parseElement();
+	bool 
+	parseElementStep();
 	//! \brief parses xml element open tag
 	//! [44] EmptyElemTag    ::=    '<' Name (S Attribute)* S? '/>' 
 	//! [40] STag    ::=    '<' Name (S Attribute)* S? '>' 
@@ -155,6 +209,31 @@ private:
 	void 
 	resolve_references();
 
+	//! streaming mode
+	//! \brief validates the new element against its parent and reports it to the handler
+	void 
+	stream_start(	xml_element& el							//!< new element with attributes
+					);
+	//! \brief opens the new level for the element children
+	void 
+	stream_push(	xml_element* el							//!< open element
+					);
+	//! \brief validates and reports the closed element, then releases it
+	void 
+	stream_close(	xml_element& el							//!< closed element
+					);
+	//! \brief reports text or CDATA
+	void 
+	stream_text(	const char* value,						//!< text
+					bool cdata								//!< CDATA flag
+					);
+	//! \brief releases comments and processing instructions of the open element
+	void 
+	stream_misc();
+	//! \brief returns all levels allocators to the pool
+	void 
+	stream_reset();
+
 private:
 	xml_document&				_doc;						//!< xml document
 	bool						_preserve_white_space;		//!< flag to preserve white spaces
@@ -162,6 +241,9 @@ private:
 	xml_white_space_stack_t		_white_space_stack;			//!< white space stack
 	string_t					_error;						//!< last error
 	bool						_validate;					//!< flag to do validation
+	xml_stream_handler*			_handler;					//!< streaming handler
+	xml_stream_level_allocator_t _level_allocator;			//!< open elements stack allocator
+	xml_stream_level_stack_t	_level_stack;				//!< open elements stack
 };
 
 #pragma pack()
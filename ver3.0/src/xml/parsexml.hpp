@@ -52,6 +52,9 @@ xml_processor::parseStartTag()
 	// parses attribute
 	parseAttributes(*el);
 
+	if (_handler)
+		stream_start(*el);
+
 	// checks the close tag
 	switch (pick())
 	{
@@ -61,12 +64,16 @@ xml_processor::parseStartTag()
 			// next closeTag is expected
 			// sets current element
 			_doc.container_push(el);
+			if (_handler)
+				stream_push(el);
 			break;
 		case ch_forward_slash:
 			pop();
 			skip_sign(ch_close_angle, false, false, "Expected close tag");
 			// validate element before leaving
-			if (_validate)
+			if (_handler)
+				stream_close(*el);
+			else if (_validate)
 				_doc.validate(*el);
 
 			if (!_white_space_stack.empty() && _white_space_stack.top()._el == el)
@@ -108,7 +115,8 @@ xml_processor::parseEndTag()
 	}
 
 	// validates element before leaving
-	if (_validate) _doc.validate(*el);
+	if (_handler) stream_close(*el);
+	else if (_validate) _doc.validate(*el);
 
 	skip_sign(ch_close_angle, true, false, "Expected close tag");
 }
@@ -137,6 +145,8 @@ xml_processor::parseContent()
 				{
 					case ch_question:
 						parsePI();
+						if (_handler)
+							stream_misc();
 						break;
 					case ch_bang:
 						// CDStart OR Comment
@@ -144,6 +154,8 @@ xml_processor::parseContent()
 						{
 							case ch_dash:
 								parseComment();
+								if (_handler)
+									stream_misc();
 								break;
 							case ch_open_square:
 								pop();
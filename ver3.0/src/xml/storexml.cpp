@@ -38,10 +38,304 @@
 #include "base/vector.hpp"
 #include "base/common.hpp"
 
+// SSE2 is the baseline of x64 and can be enabled for x86, AVX2 must be enabled by the compiler
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XML_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(XML_SCAN_SSE2) && defined(__AVX2__)
+#define XML_SCAN_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(XML_SCAN_SSE2)
+#include <intrin.h>
+#endif
+
 BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
 const size_t xml_decl_max_len = 4096;
+
+//////////////////////////////////////////////////////////////
+// byte scanners
+// each matcher returns the mask of bytes that stop the scanning
+
+#ifdef XML_SCAN_SSE2
+//! \brief returns the index of the lowest bit set, bits must not be zero
+static
+inline
+size_t
+xml_scan_first_bit(ub4_t bits)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, bits);
+	return index;
+#elif defined(__GNUC__)
+	return __builtin_ctz(bits);
+#else
+	size_t index = 0;
+	while (!(bits & 1))
+	{
+		bits >>= 1;
+		++index;
+	}
+
+	return index;
+#endif
+}
+#endif // XML_SCAN_SSE2
+
+//! \brief returns the position of the first byte matched, or len if none
+template < class M >
+static
+inline
+size_t
+xml_scan(const ub1_t* x, size_t len, const M& match)
+{
+	size_t pos = 0;
+#ifdef XML_SCAN_AVX2
+	for (; pos + 32 <= len; pos += 32)
+	{
+		ub4_t bits = match.avx2(_mm256_loadu_si256((const __m256i*)(x + pos)));
+		if (bits)
+			return pos + xml_scan_first_bit(bits);
+	}
+#endif
+#ifdef XML_SCAN_SSE2
+	for (; pos + 16 <= len; pos += 16)
+	{
+		ub4_t bits = match.sse2(_mm_loadu_si128((const __m128i*)(x + pos)));
+		if (bits)
+			return pos + xml_scan_first_bit(bits);
+	}
+#endif
+	for (; pos < len; ++pos)
+		if (match.scalar(x[pos]))
+			return pos;
+
+	return len;
+}
+
+//! \class xml_scan_char_data
+//! \brief stops on '<', '&', ']' and zero byte
+class xml_scan_char_data
+{
+public:
+	inline 
+	bool 
+	scalar(ub1_t x) const
+	{
+		return x == ch_open_angle || x == ch_ampersand || x == ch_close_square || !x;
+	}
+#ifdef XML_SCAN_SSE2
+	inline 
+	ub4_t 
+	sse2(__m128i x) const
+	{
+		__m128i out = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch_open_angle)), _mm_cmpeq_epi8(x, _mm_set1_epi8(ch_ampersand))),
+								_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch_close_square)), _mm_cmpeq_epi8(x, _mm_setzero_si128())));
+		return (ub4_t)_mm_movemask_epi8(out);
+	}
+#endif
+#ifdef XML_SCAN_AVX2
+	inline 
+	ub4_t 
+	avx2(__m256i x) const
+	{
+		__m256i out = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_open_angle)), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_ampersand))),
+								_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_close_square)), _mm256_cmpeq_epi8(x, _mm256_setzero_si256())));
+		return (ub4_t)_mm256_movemask_epi8(out);
+	}
+#endif
+};
+
+//! \class xml_scan_cdata
+//! \brief stops on ']' and zero byte
+class xml_scan_cdata
+{
+public:
+	inline 
+	bool 
+	scalar(ub1_t x) const
+	{
+		return x == ch_close_square || !x;
+	}
+#ifdef XML_SCAN_SSE2
+	inline 
+	ub4_t 
+	sse2(__m128i x) const
+	{
+		__m128i out = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch_close_square)), _mm_cmpeq_epi8(x, _mm_setzero_si128()));
+		return (ub4_t)_mm_movemask_epi8(out);
+	}
+#endif
+#ifdef XML_SCAN_AVX2
+	inline 
+	ub4_t 
+	avx2(__m256i x) const
+	{
+		__m256i out = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_close_square)), _mm256_cmpeq_epi8(x, _mm256_setzero_si256()));
+		return (ub4_t)_mm256_movemask_epi8(out);
+	}
+#endif
+};
+
+//! \class xml_scan_attribute_value
+//! \brief stops on quote, '<', '&' and bytes up to space
+class xml_scan_attribute_value
+{
+public:
+	xml_scan_attribute_value(ub1_t quote) : 
+		_quote(quote) 
+	{
+	}
+
+	inline 
+	bool 
+	scalar(ub1_t x) const
+	{
+		return x == _quote || x == ch_open_angle || x == ch_ampersand || x <= ch_space;
+	}
+#ifdef XML_SCAN_SSE2
+	inline 
+	ub4_t 
+	sse2(__m128i x) const
+	{
+		// unsigned x <= space when min(x, space) == x
+		__m128i space = _mm_set1_epi8(ch_space);
+		__m128i out = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8((char)_quote)), _mm_cmpeq_epi8(x, _mm_set1_epi8(ch_open_angle))),
+								_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch_ampersand)), _mm_cmpeq_epi8(_mm_min_epu8(x, space), x)));
+		return (ub4_t)_mm_movemask_epi8(out);
+	}
+#endif
+#ifdef XML_SCAN_AVX2
+	inline 
+	ub4_t 
+	avx2(__m256i x) const
+	{
+		__m256i space = _mm256_set1_epi8(ch_space);
+		__m256i out = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8((char)_quote)), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_open_angle))),
+								_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_ampersand)), _mm256_cmpeq_epi8(_mm256_min_epu8(x, space), x)));
+		return (ub4_t)_mm256_movemask_epi8(out);
+	}
+#endif
+private:
+	ub1_t	_quote;											//!< quote symbol
+};
+
+//! \class xml_scan_white_space
+//! \brief stops on any byte except white space
+class xml_scan_white_space
+{
+public:
+	inline 
+	bool 
+	scalar(ub1_t x) const
+	{
+		return x != ch_space && x != ch_lf && x != ch_cr && x != ch_hor_tab;
+	}
+#ifdef XML_SCAN_SSE2
+	inline 
+	ub4_t 
+	sse2(__m128i x) const
+	{
+		__m128i out = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch_space)), _mm_cmpeq_epi8(x, _mm_set1_epi8(ch_lf))),
+								_mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch_cr)), _mm_cmpeq_epi8(x, _mm_set1_epi8(ch_hor_tab))));
+		return ~(ub4_t)_mm_movemask_epi8(out) & 0xffff;
+	}
+#endif
+#ifdef XML_SCAN_AVX2
+	inline 
+	ub4_t 
+	avx2(__m256i x) const
+	{
+		__m256i out = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_space)), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_lf))),
+								_mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_cr)), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_hor_tab))));
+		return ~(ub4_t)_mm256_movemask_epi8(out);
+	}
+#endif
+};
+
+//! \class xml_scan_ascii
+//! \brief stops on non ASCII bytes and control bytes except white spaces
+class xml_scan_ascii
+{
+public:
+	inline 
+	bool 
+	scalar(ub1_t x) const
+	{
+		return x > 0x7F || (x < ch_space && x != ch_lf && x != ch_cr && x != ch_hor_tab);
+	}
+#ifdef XML_SCAN_SSE2
+	inline 
+	ub4_t 
+	sse2(__m128i x) const
+	{
+		// signed x < space for both non ASCII and control bytes
+		__m128i low = _mm_cmplt_epi8(x, _mm_set1_epi8(ch_space));
+		__m128i white = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch_lf)), _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch_cr)), _mm_cmpeq_epi8(x, _mm_set1_epi8(ch_hor_tab))));
+		return (ub4_t)_mm_movemask_epi8(_mm_andnot_si128(white, low));
+	}
+#endif
+#ifdef XML_SCAN_AVX2
+	inline 
+	ub4_t 
+	avx2(__m256i x) const
+	{
+		__m256i low = _mm256_cmpgt_epi8(_mm256_set1_epi8(ch_space), x);
+		__m256i white = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_lf)), _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_cr)), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_hor_tab))));
+		return (ub4_t)_mm256_movemask_epi8(_mm256_andnot_si256(white, low));
+	}
+#endif
+};
+
+//! \class xml_scan_line_break
+//! \brief stops on line feed and carriage return
+class xml_scan_line_break
+{
+public:
+	inline 
+	bool 
+	scalar(ub1_t x) const
+	{
+		return x == ch_lf || x == ch_cr;
+	}
+#ifdef XML_SCAN_SSE2
+	inline 
+	ub4_t 
+	sse2(__m128i x) const
+	{
+		__m128i out = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch_lf)), _mm_cmpeq_epi8(x, _mm_set1_epi8(ch_cr)));
+		return (ub4_t)_mm_movemask_epi8(out);
+	}
+#endif
+#ifdef XML_SCAN_AVX2
+	inline 
+	ub4_t 
+	avx2(__m256i x) const
+	{
+		__m256i out = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_lf)), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch_cr)));
+		return (ub4_t)_mm256_movemask_epi8(out);
+	}
+#endif
+};
+
+//! \brief checks utf-8 bytes skipping plain ASCII run at once
+static
+inline
+bool
+xml_check_utf8(const ub1_t* in, size_t count, size_t& processed, size_t& more)
+{
+	size_t plain = xml_scan(in, count, xml_scan_ascii());
+	bool res = utf8_to_utf8(in + plain, count - plain, processed, more);
+	processed += plain;
+	return res;
+}
+
 /////////////////////////////////
 byte_source::byte_source(mem_pool_t& small_pool, mem_pool_t& big_pool, size_t xml_size, const char* url, bool subset) : 
 	_small_pool(small_pool),
@@ -198,6 +492,76 @@ byte_source::pull(ub1_t* x, size_t len)
 	return len;
 }
 
+size_t 
+byte_source::pick_char_data(const ub1_t*& x)
+{
+	size_t len = pick_run(x);
+	return len ? xml_scan(x, len, xml_scan_char_data()) : 0;
+}
+
+size_t 
+byte_source::pick_cdata(const ub1_t*& x)
+{
+	size_t len = pick_run(x);
+	return len ? xml_scan(x, len, xml_scan_cdata()) : 0;
+}
+
+size_t 
+byte_source::pick_attribute_value(const ub1_t*& x, ub1_t quote)
+{
+	size_t len = pick_run(x);
+	return len ? xml_scan(x, len, xml_scan_attribute_value(quote)) : 0;
+}
+
+void 
+byte_source::skip_run(size_t count)
+{
+	if (!count)
+		return;
+
+	// moves inside buffer to the last byte of run
+	// the bytes passed by are counted like pop does for the new current byte
+	size_t len = count - 1;
+	if (len)
+	{
+		const ub1_t* x = _buffer + _buffer_pos + 1;
+		size_t pos = 0, next;
+
+		_pos_counter += len;
+		_char_counter += len;
+
+		while ((next = pos + xml_scan(x + pos, len - pos, xml_scan_line_break())) < len)
+		{
+			if (x[next] == ch_lf)
+				++_line_counter;
+
+			_char_counter = len - next - 1;
+			pos = next + 1;
+		}
+
+		_buffer_pos += len;
+	}
+
+	// the last byte can move us to the next buffer
+	pop();
+}
+
+void 
+byte_source::skip_white_space_run()
+{
+	const ub1_t* x = 0;
+	size_t len, count;
+
+	while ((len = pick_run(x)) != 0)
+	{
+		count = xml_scan(x, len, xml_scan_white_space());
+		skip_run(count);
+		
+		if (count < len)
+			break;
+	}
+}
+
 ub1_t
 byte_source::go_shopping()
 { 
@@ -614,7 +978,7 @@ byte_source::convert_chars(size_t count)
 				if (!data_request(_buffer + _buffer_pos, len))
 					return false;
 				// checks UTF-8 compatibility
-				if (!utf8_to_utf8(_buffer + _buffer_pos, len, processed, more))
+				if (!xml_check_utf8(_buffer + _buffer_pos, len, processed, more))
 				{
 					_symbol = 0;
 					string_t err = "Invalid utf8 char token: ";
@@ -635,7 +999,7 @@ byte_source::convert_chars(size_t count)
 					if (!data_request(_buffer + _buffer_pos + len, more_))
 						return false;
 
-					if (!utf8_to_utf8(_buffer + _buffer_pos + processed, len - processed + more, processed_, more_))
+					if (!xml_check_utf8(_buffer + _buffer_pos + processed, len - processed + more, processed_, more_))
 					{
 						_symbol = 0;
 						string_t err = "Invalid utf8 char token: ";
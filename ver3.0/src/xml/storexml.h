@@ -75,6 +75,27 @@ public:
 	skip_white_space(bool mustPresent = false,				//!< flag of white space presence
 					const char* message = 0					//!< error message
 					);
+	//! \brief returns the run of character data starting from the current byte
+	//! the run stops before '<', '&', ']' or zero byte and never crosses the buffer end
+	size_t 
+	pick_char_data(	const ub1_t*& x							//!< [out] run
+					);
+	//! \brief returns the run of CDATA content starting from the current byte
+	//! the run stops before ']' or zero byte
+	size_t 
+	pick_cdata(		const ub1_t*& x							//!< [out] run
+					);
+	//! \brief returns the run of attribute value starting from the current byte
+	//! the run stops before the quote, '<', '&', white space or control byte
+	size_t 
+	pick_attribute_value(const ub1_t*& x,					//!< [out] run
+					ub1_t quote								//!< quote symbol
+					);
+	//! \brief skips the bytes of the picked run
+	//! counts lines as pop does
+	void 
+	skip_run(		size_t count							//!< bytes to skip
+					);
 	//! \brief throws exception adding line and char postion information
 	void 
 	throw_exception(const char* msg_text					//!< message text
@@ -155,6 +176,14 @@ protected:
 	parseTextDecl();
 
 private:
+	//! \brief returns bytes available in the buffer starting from the current byte
+	xml_forceinline 
+	size_t 
+	pick_run(		const ub1_t*& x							//!< [out] current byte
+					);
+	//! \brief skips white spaces starting from the current byte
+	void 
+	skip_white_space_run();
 	//! \brief converts count bytes from stream to internal buffer
 	bool 
 	convert_chars(size_t count);
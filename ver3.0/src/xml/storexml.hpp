@@ -102,26 +102,31 @@ xml_forceinline
 void 
 byte_source::skip_white_space(bool mustPresent, const char* message)
 { 
-	ub1_t fsymbol = pick();
-	ub1_t symbol = fsymbol;
-
-	while (symbol)
+	switch (pick())
 	{
-		switch (symbol)
-		{
-			case ch_lf:
-			case ch_cr:
-			case ch_hor_tab:
-			case ch_space:
-				break;
-			default:
-				if (mustPresent && fsymbol == symbol)
-					throw_exception(message);
-				return;
-		} // switch
-		
-		symbol = pop(); 
-	}
+		case 0:
+			break;
+		case ch_lf:
+		case ch_cr:
+		case ch_hor_tab:
+		case ch_space:
+			skip_white_space_run();
+			break;
+		default:
+			if (mustPresent)
+				throw_exception(message);
+	} // switch
+}
+
+xml_forceinline 
+size_t 
+byte_source::pick_run(const ub1_t*& x)
+{ 
+	if (!pick())
+		return 0;
+
+	x = _buffer + _buffer_pos;
+	return _xml_size - _buffer_pos;
 }
 
 xml_forceinline 
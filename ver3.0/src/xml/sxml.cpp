@@ -141,7 +141,8 @@ xml_document::xml_document(	mem_pool_t& small_manager, mem_pool_t& big_manager,
 	_model_allocator(1024*64),
 	_on_fly(grammar_ == 0),
 	_root(0, this),
-	_doc_type(&_doctype_decl, this)
+	_doc_type(&_doctype_decl, this),
+	_node_allocator(&_data_allocator)
 {
 	if (grammar_)
 	{
@@ -320,30 +321,68 @@ xml_document::validate_children(xml_element& el)
 		case CONTENT_ANY: // can be anything
 			break;
 		case CONTENT_MIXED: // (#PCDATA|a|b)* | (#PCDATA)
-			{
-				// tries to find model
-				content_interface* model = find_model(el.cast_decl());
-				if (!model) // adds model
-				{
-					model = new (check_pointer(_model_allocator.allocate(sizeof(content_mixed)))) content_mixed(el.cast_decl()->_token, _model_allocator);
-					add_model(el.cast_decl(), model);
-				}
+		case CONTENT_CHILDREN:
+			load_model(el.cast_decl())->validate(el);
+			break;
+		default:
+			assert(false);
+			break;
+	}
+}
 
-				model->validate(el);
-			}
+size_t 
+xml_document::validate_child(xml_element& el, size_t state, const xml_element& child)
+{
+	switch (el.cast_decl()->_content)
+	{
+		case contentSpec_MIN:
+		case contentSpec_MAX:
+			xml_exception_throw("no rule, for element: ",
+					(const char*)el._decl->_name,
+					0);
 			break;
+		case CONTENT_EMPTY:
+			xml_exception_throw("EMPTY rule doesn't allow children, for element: ",
+				(const char*)el._decl->_name,
+				0);
+			break;
+		case CONTENT_ANY: // can be anything
+			break;
+		case CONTENT_MIXED: // (#PCDATA|a|b)* | (#PCDATA)
 		case CONTENT_CHILDREN:
-			{
-				// tries to find model
-				content_interface* model = find_model(el.cast_decl());
-				if (!model) // adds model
-				{
-					model = new (check_pointer(_model_allocator.allocate(sizeof(content_children)))) content_children(el.cast_decl()->_token, _model_allocator);
-					add_model(el.cast_decl(), model);
-				}
+			return load_model(el.cast_decl())->next_state(el, state, child.cast_decl());
+		default:
+			assert(false);
+			break;
+	}
 
-				model->validate(el);
-			}
+	return state;
+}
+
+void 
+xml_document::validate_final(xml_element& el, size_t state, bool has_children)
+{
+	validate_attributes(el);
+
+	switch (el.cast_decl()->_content)
+	{
+		case contentSpec_MIN:
+		case contentSpec_MAX:
+			xml_exception_throw("no rule, for element: ",
+					(const char*)el._decl->_name,
+					0);
+			break;
+		case CONTENT_EMPTY:
+			if (has_children)
+				xml_exception_throw("EMPTY rule doesn't allow children, for element: ",
+					(const char*)el._decl->_name,
+					0);
+			break;
+		case CONTENT_ANY: // can be anything
+			break;
+		case CONTENT_MIXED: // (#PCDATA|a|b)* | (#PCDATA)
+		case CONTENT_CHILDREN:
+			load_model(el.cast_decl())->check_state(el, state, has_children);
 			break;
 		default:
 			assert(false);
@@ -351,6 +390,30 @@ xml_document::validate_children(xml_element& el)
 	}
 }
 
+content_interface* 
+xml_document::load_model(const elementDecl* decl)
+{
+	// tries to find model
+	content_interface* model = find_model(decl);
+	if (!model) // adds model
+	{
+		if (decl->_content == CONTENT_MIXED)
+			model = new (check_pointer(_model_allocator.allocate(sizeof(content_mixed)))) content_mixed(decl->_token, _model_allocator);
+		else
+			model = new (check_pointer(_model_allocator.allocate(sizeof(content_children)))) content_children(decl->_token, _model_allocator);
+
+		add_model(decl, model);
+	}
+
+	return model;
+}
+
+void 
+xml_document::set_node_allocator(byte_allocator* allocator)
+{
+	_node_allocator = allocator ? allocator : &_data_allocator;
+}
+
 //
 // adds node to the list of children
 //
@@ -383,7 +446,7 @@ xml_document::add_element(const char* name, xml_tree_node* sibling, bool after)
 		const elementDecl* pdecl = pel->cast_decl();
 		bool pany = pdecl->_content == CONTENT_ANY || pdecl->_content == CONTENT_CHILDREN && pdecl->_token->find_any_resursively();
 		// allocate new object
-		retVal = new(check_pointer(_data_allocator.allocate(sizeof(xml_element)))) xml_element(&add_element_decl(name, _on_fly, false, pany), parent);
+		retVal = new(check_pointer(_node_allocator->allocate(sizeof(xml_element)))) xml_element(&add_element_decl(name, _on_fly, false, pany), parent);
 		sibling ? (after ? parent->append_node(sibling, retVal) : parent->insert_node(sibling, retVal)) : parent->add_node(retVal);
 		// There is exactly one element, called the root, or document element, 
 		// no part of which appears in the content of any other element
@@ -411,7 +474,7 @@ xml_document::add_attribute(xml_element& el, const char* name, const char* value
 								0);
 
 
-	xml_value_node* retVal = new(check_pointer(_data_allocator.allocate(sizeof(xml_value_node)))) xml_value_node(&attr_decl, &el);
+	xml_value_node* retVal = new(check_pointer(_node_allocator->allocate(sizeof(xml_value_node)))) xml_value_node(&attr_decl, &el);
 	sibling ? (after ? el.append_attribute(sibling, retVal) :  el.insert_attribute(sibling, retVal)) : el.add_attribute(retVal);
 
 	assign_attribute_value(el, attr_decl, retVal, value_org);
@@ -492,7 +555,7 @@ xml_document::assign_attribute_value(xml_element& el, const attributeDecl& attr_
 
 
 				// assigns attribute value
-				retVal->_value.strVal = copy_string(value, _data_allocator, os_minus_one);
+				retVal->_value.strVal = copy_string(value, *_node_allocator, os_minus_one);
 
 				if (!is_name_first_char(*value))
 					xml_exception_throw("Illigal ID char: ",
@@ -524,7 +587,7 @@ xml_document::assign_attribute_value(xml_element& el, const attributeDecl& attr_
 
 
 				// assigns attribute value
-				retVal->_value.strVal = copy_string(value, _data_allocator, os_minus_one);
+				retVal->_value.strVal = copy_string(value, *_node_allocator, os_minus_one);
 			}
 			break;
 		case ATTR_TYPE_IDREFS:
@@ -548,7 +611,7 @@ xml_document::assign_attribute_value(xml_element& el, const attributeDecl& attr_
 				}
 
 				// assigns attribute value
-				retVal->_value.strVal = copy_string(value, _data_allocator,os_minus_one);
+				retVal->_value.strVal = copy_string(value, *_node_allocator,os_minus_one);
 			}
 			break;
 		case ATTR_TYPE_ENTITY:
@@ -571,7 +634,7 @@ xml_document::assign_attribute_value(xml_element& el, const attributeDecl& attr_
 
 
 				// assigns attribute value
-				retVal->_value.strVal = copy_string((const char*)decl->_value, _data_allocator, os_minus_one);
+				retVal->_value.strVal = copy_string((const char*)decl->_value, *_node_allocator, os_minus_one);
 			}
 			break;
 		case ATTR_TYPE_ENTITIES:
@@ -614,7 +677,7 @@ xml_document::assign_attribute_value(xml_element& el, const attributeDecl& attr_
 					strDummy += decl->_value;
 				}
 				
-				retVal->_value.strVal = copy_string((const char*)strDummy, _data_allocator, os_minus_one);
+				retVal->_value.strVal = copy_string((const char*)strDummy, *_node_allocator, os_minus_one);
 			}
 			break;
 		case ATTR_TYPE_NMTOKEN:
@@ -631,7 +694,7 @@ xml_document::assign_attribute_value(xml_element& el, const attributeDecl& attr_
 					else
 						++value_;
 
-				retVal->_value.strVal = copy_string(value, _data_allocator, os_minus_one);
+				retVal->_value.strVal = copy_string(value, *_node_allocator, os_minus_one);
 			}
 			break;
 		case ATTR_TYPE_NMTOKENS:
@@ -670,7 +733,7 @@ xml_document::assign_attribute_value(xml_element& el, const attributeDecl& attr_
 				}
 				
 				
-				retVal->_value.strVal = copy_string((const char*)strDummy, _data_allocator, os_minus_one);
+				retVal->_value.strVal = copy_string((const char*)strDummy, *_node_allocator, os_minus_one);
 			}
 			break;
 		case ATTR_TYPE_NOTATION:
@@ -707,7 +770,7 @@ xml_document::assign_attribute_value(xml_element& el, const attributeDecl& attr_
 			break;
 		default: // CDATA
 			// value needs to be converted there
-			retVal->_value = parse_value(retVal->cast_to_attribute()->_ctype, value, os_minus_one, &_data_allocator);
+			retVal->_value = parse_value(retVal->cast_to_attribute()->_ctype, value, os_minus_one, _node_allocator);
 			break;
 	} // switch
 }
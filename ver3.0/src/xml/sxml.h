@@ -376,6 +376,24 @@ public:
 	void 
 	validate(		xml_element& el							//!< element to validate
 					);
+	//! \brief validates the next child of the open element
+	//! returns the new validation state, the children list is not used
+	size_t 
+	validate_child(	xml_element& el,						//!< open element
+					size_t state,							//!< validation state, zero before the first child
+					const xml_element& child				//!< child element
+					);
+	//! \brief validates attributes and the validation state after the last child
+	void 
+	validate_final(	xml_element& el,						//!< element to validate
+					size_t state,							//!< validation state after the last child
+					bool has_children						//!< flag if element had any child nodes
+					);
+	//! \brief sets allocator for xml nodes and values
+	//! null restores the data allocator
+	void 
+	set_node_allocator(byte_allocator* allocator			//!< node allocator
+					);
 	//! \brief adds entity node declaration to the grammar
 	xml_forceinline
 	void 
@@ -467,6 +485,10 @@ private:
 	void 
 	validate_children(xml_element& el						//!< element
 					);
+	//! \brief finds or builds validation model for mixed or children content
+	content_interface* 
+	load_model(		const elementDecl* decl					//!< element declaration
+					);
 	//! \brief assigns attribute value
 	void 
 	assign_attribute_value(xml_element& el,					//!< element
@@ -485,6 +507,7 @@ private:
 	model_map_t							_model_map;			//!< model map
 	xml_element							_root;				//!< root element
 	xml_container						_doc_type;			//!< DTD container
+	byte_allocator*						_node_allocator;	//!< allocator for nodes and values
 };
 
 #pragma pack()
@@ -400,8 +400,8 @@ xml_value_node*
 xml_document::add_comment(const char* value, xml_tree_node* sibling, bool after)
 {
 	xml_container* parent = _container_stack.top();
-	string_t text(value, &_data_allocator);
-	xml_value_node* retVal = new(check_pointer(_data_allocator.allocate(sizeof(xml_value_node)))) xml_value_node(&_comment_decl, parent);
+	string_t text(value, _node_allocator);
+	xml_value_node* retVal = new(check_pointer(_node_allocator->allocate(sizeof(xml_value_node)))) xml_value_node(&_comment_decl, parent);
 	retVal->_value.strVal = text;
 	sibling ? (after ? parent->append_node(sibling, retVal) : parent->insert_node(sibling, retVal)) : parent->add_node(retVal);
 	return retVal;
@@ -415,8 +415,8 @@ xml_value_node*
 xml_document::add_cdata(const char* value, xml_tree_node* sibling, bool after)
 {
 	xml_container* parent = _container_stack.top();
-	string_t text(value, &_data_allocator);
-	xml_value_node* retVal = new(check_pointer(_data_allocator.allocate(sizeof(xml_value_node)))) xml_value_node(&_cdata_decl, parent);
+	string_t text(value, _node_allocator);
+	xml_value_node* retVal = new(check_pointer(_node_allocator->allocate(sizeof(xml_value_node)))) xml_value_node(&_cdata_decl, parent);
 	retVal->_value.strVal = text;
 	sibling ? (after ? parent->append_node(sibling, retVal) : parent->insert_node(sibling, retVal)) : parent->add_node(retVal);
 	return retVal;
@@ -437,8 +437,8 @@ xml_document::add_pi(const char* name, const char* value, xml_tree_node* sibling
 		exception::_throw("Invalid Processing instruction name");
 
 	xml_container* parent = _container_stack.top();
-	string_t text(value, &_data_allocator);
-	xml_value_node* retVal = new(check_pointer(_data_allocator.allocate(sizeof(xml_value_node)))) xml_value_node(&add_pi_decl(name), parent);
+	string_t text(value, _node_allocator);
+	xml_value_node* retVal = new(check_pointer(_node_allocator->allocate(sizeof(xml_value_node)))) xml_value_node(&add_pi_decl(name), parent);
 	retVal->_value.strVal = text;
 	sibling ? (after ? parent->append_node(sibling, retVal) : parent->insert_node(sibling, retVal)) : parent->add_node(retVal);
 	return retVal;
@@ -452,8 +452,8 @@ xml_value_node*
 xml_document::add_text(const char* value, xml_tree_node* sibling, bool after)
 {
 	xml_container* parent = _container_stack.top();
-	string_t text(value, &_data_allocator);
-	xml_value_node* retVal = new(check_pointer(_data_allocator.allocate(sizeof(xml_value_node)))) xml_value_node(&_text_decl, parent);
+	string_t text(value, _node_allocator);
+	xml_value_node* retVal = new(check_pointer(_node_allocator->allocate(sizeof(xml_value_node)))) xml_value_node(&_text_decl, parent);
 	retVal->_value.strVal = text;
 	sibling ? (after ? parent->append_node(sibling, retVal) : parent->insert_node(sibling, retVal)) : parent->add_node(retVal);
 	return retVal;
@@ -30,6 +30,83 @@
 
 #include "xmltypes.h"
 
+//! \class xml_stream_handler
+//! \brief receives events from the streaming parser
+//! names and values are valid only during the call
+//! handler can stop parsing returning false
+class xml_stream_handler
+{
+public:
+	//! \brief destructor
+	virtual 
+	~xml_stream_handler() 
+	{
+	}
+	//! \brief element is opened
+	virtual 
+	bool 
+	start_element(	const char* name,						//!< element name
+					const char* const* attributes			//!< attribute name and value pairs, terminated by null
+					) = 0;
+	//! \brief text or CDATA beneath the open element
+	//! long text can come in several parts
+	virtual 
+	bool 
+	characters(		const char* value,						//!< text
+					bool cdata								//!< CDATA section flag
+					) = 0;
+	//! \brief element is closed
+	virtual 
+	bool 
+	end_element(	const char* name						//!< element name
+					) = 0;
+};
+
+//! \class xml_stream_cursor
+//! \brief pulls events from the streaming parser one by one
+//! the parser goes ahead only when the next event is requested,
+//! memory is released as in parse function of xml_designer
+//! names, values and attributes are valid until the next call of next function
+class xml_stream_cursor
+{
+public:
+	//! \brief destructor
+	virtual 
+	~xml_stream_cursor() 
+	{
+	}
+	//! \brief moves to the next event
+	//! returns false at the end of document or on error, the error is not empty then
+	virtual 
+	bool 
+	next() = 0;
+	//! \brief returns the current event
+	virtual 
+	xmlStreamEvent 
+	get_event() const = 0;
+	//! \brief returns element name of start and end events
+	virtual 
+	const char* 
+	get_name() const = 0;
+	//! \brief returns attribute name and value pairs of start event, terminated by null
+	virtual 
+	const char* const* 
+	get_attributes() const = 0;
+	//! \brief returns text of characters event
+	//! long text can come in several events
+	virtual 
+	const char* 
+	get_value() const = 0;
+	//! \brief checks if text of characters event comes from CDATA section
+	virtual 
+	bool 
+	is_cdata() const = 0;
+	//! \brief returns the last error
+	virtual 
+	const char* 
+	error() const = 0;
+};
+
 //! \class xml_designer
 //! \brief class supports xml parsing, navigating, construction, and persistence
 class xml_designer
@@ -79,6 +156,43 @@ public:
 					const void* grammar,					//!< DTD memory buffer
 					size_t grammar_length					//!< DTD buffer length
 					) = 0;
+	//! \brief parses xml from file reporting elements and text to the handler
+	//! the document is not built, memory of each element is released as soon as the element is closed
+	//! the document is empty after parsing, the grammar is handled as in load function
+	virtual 
+	bool 
+	parse(			const char* name,						//!< xml file name
+					const char* grammar,					//!< external DTD file
+					xml_stream_handler& handler,			//!< event handler
+					bool validate							//!< validates elements according to the grammar
+					) = 0;
+	//! \brief parses xml from memory reporting elements and text to the handler
+	virtual 
+	bool 
+	parse(			const void* buffer,						//!< xml memory buffer
+					size_t length,							//!< xml buffer length
+					const char* grammar,					//!< external DTD file
+					xml_stream_handler& handler,			//!< event handler
+					bool validate							//!< validates elements according to the grammar
+					) = 0;
+	//! \brief opens xml file for pulling parser events one by one
+	//! the cursor has own document and does not change the designer document
+	//! caller is responsible for destroying the cursor before the designer, returns null on error
+	virtual 
+	xml_stream_cursor* 
+	open_cursor(	const char* name,						//!< xml file name
+					const char* grammar,					//!< external DTD file
+					bool validate							//!< validates elements according to the grammar
+					) = 0;
+	//! \brief opens xml memory buffer for pulling parser events one by one
+	//! buffer must be kept until the cursor is destroyed
+	virtual 
+	xml_stream_cursor* 
+	open_cursor(	const void* buffer,						//!< xml memory buffer
+					size_t length,							//!< xml buffer length
+					const char* grammar,					//!< external DTD file
+					bool validate							//!< validates elements according to the grammar
+					) = 0;
 	//! \brief returns the last error
 	virtual 
 	const char* 
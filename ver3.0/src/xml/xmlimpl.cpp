@@ -69,6 +69,36 @@ xml_factory::get_xml_designer(size_t xml_size)
 BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
+// loads external DTD into the cleared document
+static 
+bool 
+load_grammar(xml_document& doc, byte_source* grammar, mem_pool_t& small_pool, mem_pool_t& big_pool, string_t& error)
+{
+	doc.clear();
+	doc.add_escaped_symbols();
+
+	if (grammar)
+	{
+		// external
+		dtd_processor dtd(*grammar, doc, small_pool, big_pool, 0);
+		try
+		{
+			doc.container_start_doctype();
+			dtd.parse();
+			doc.container_stop_doctype();
+		}
+		catch (exception& x)
+		{
+			doc.clear();
+			doc.add_escaped_symbols();
+			error = x.what();
+			return false;
+		}
+	}
+
+	return true;
+}
+
 ///////////////////////////////////////////////////////
 xml_designer_impl::xml_designer_impl(size_t block_size) :
 _xml_size(block_size <= os_def_size ? os_def_size : big_xml_size), _doc(_small_manager, _big_manager, block_size <= os_def_size ? os_def_size : big_xml_size, 0)
@@ -191,6 +221,105 @@ xml_designer_impl::load(const void* name, size_t length, const void* grammar, si
 	return _load(in_xml, in_grammar);
 }
 
+bool 
+xml_designer_impl::parse(const char* name, const char* grammar, xml_stream_handler& handler, bool validate)
+{
+	if (!name || !name[0])
+	{
+		_error = "Xml file name is not specified";
+		return false;
+	}
+
+	stream_input_common stream_xml(_small_manager, _big_manager, _xml_size, false);
+	xml_stream_attribute attr(name, true);
+	if (!stream_xml.open(attr))
+	{
+		_error = "Can't open file ";
+		_error += name;
+		return false;
+	}
+
+	byte_source* in_grammar = 0;
+	stream_input_common stream_grammar(_small_manager, _big_manager, 0, false);
+	if (grammar && grammar[0])
+	{
+		xml_stream_attribute attr_grammar(grammar, true);
+		if (!stream_grammar.open(attr_grammar))
+		{
+			_error = "Can't open file ";
+			_error += grammar;
+			return false;
+		}
+
+		in_grammar = &stream_grammar;
+	}
+
+	return _parse(stream_xml, in_grammar, handler, validate);
+}
+
+bool 
+xml_designer_impl::parse(const void* buffer, size_t length, const char* grammar, xml_stream_handler& handler, bool validate)
+{
+	if (!buffer || !length)
+	{
+		_error = "Xml buffer is empty";
+		return false;
+	}
+
+	stream_input_memory stream_xml((const ub1_t*)buffer, length, _small_manager, _big_manager, _xml_size, false);	
+
+	byte_source* in_grammar = 0;
+	stream_input_common stream_grammar(_small_manager, _big_manager, 0, false);
+	if (grammar && grammar[0])
+	{
+		xml_stream_attribute attr(grammar, true);
+		if (!stream_grammar.open(attr))
+		{
+			_error = "Can't open file ";
+			_error += grammar;
+			return false;
+		}
+
+		in_grammar = &stream_grammar;
+	}
+
+	return _parse(stream_xml, in_grammar, handler, validate);
+}
+
+xml_stream_cursor* 
+xml_designer_impl::open_cursor(const char* name, const char* grammar, bool validate)
+{
+	if (!name || !name[0])
+	{
+		_error = "Xml file name is not specified";
+		return 0;
+	}
+
+	stream_input_common* stream_xml = new stream_input_common(_small_manager, _big_manager, _xml_size, false);
+	xml_stream_attribute attr(name, true);
+	if (!stream_xml->open(attr))
+	{
+		delete stream_xml;
+		_error = "Can't open file ";
+		_error += name;
+		return 0;
+	}
+
+	return _open_cursor(stream_xml, grammar, validate);
+}
+
+xml_stream_cursor* 
+xml_designer_impl::open_cursor(const void* buffer, size_t length, const char* grammar, bool validate)
+{
+	if (!buffer || !length)
+	{
+		_error = "Xml buffer is empty";
+		return 0;
+	}
+
+	return _open_cursor(new stream_input_memory((const ub1_t*)buffer, length, _small_manager, _big_manager, _xml_size, false), grammar, validate);
+}
+
 const char* 
 xml_designer_impl::error() const
 { 
@@ -882,44 +1011,235 @@ xml_designer_impl::_import_node(xmlNodeType type, const char* name, const char*
 bool 
 xml_designer_impl::_load(byte_source* stream, byte_source* grammar)
 {
-	_doc.clear();
-	_doc.add_escaped_symbols();
-	_cur_node = &_doc;
+	if (!_load_grammar(grammar))
+		return false;
 
-	if (grammar)
+	if (stream)
 	{
-		// external
-		dtd_processor dtd(*grammar, _doc, _small_manager, _big_manager, 0);
-		try
-		{
-			_doc.container_start_doctype();
-			dtd.parse();
-			_doc.container_stop_doctype();
-		}
-		catch (exception& x)
+		xml_processor pr(*stream, _doc, _small_manager, _big_manager, _xml_size, false);
+		if (!pr.parse())
 		{
 			_doc.clear();
 			_doc.add_escaped_symbols();
-			_error = x.what();
+			_error = pr.get_error();
 			return false;
 		}
 	}
 
-	if (stream)
+	return true;
+}
+
+bool 
+xml_designer_impl::_load_grammar(byte_source* grammar)
+{
+	_cur_node = &_doc;
+	return load_grammar(_doc, grammar, _small_manager, _big_manager, _error);
+}
+
+xml_stream_cursor* 
+xml_designer_impl::_open_cursor(byte_source* stream, const char* grammar, bool validate)
+{
+	byte_source* in_grammar = 0;
+	stream_input_common stream_grammar(_small_manager, _big_manager, 0, false);
+	if (grammar && grammar[0])
 	{
-		xml_processor pr(*stream, _doc, _small_manager, _big_manager, _xml_size, false);
-		if (!pr.parse())
+		xml_stream_attribute attr(grammar, true);
+		if (!stream_grammar.open(attr))
 		{
-			_doc.clear();
-			_doc.add_escaped_symbols();
-			_error = pr.get_error();
+			delete stream;
+			_error = "Can't open file ";
+			_error += grammar;
+			return 0;
+		}
+
+		in_grammar = &stream_grammar;
+	}
+
+	// the cursor takes the stream
+	xml_stream_cursor_impl* cursor = new xml_stream_cursor_impl(_small_manager, _big_manager, _xml_size);
+	if (!cursor->open(stream, in_grammar, validate))
+	{
+		_error = cursor->error();
+		delete cursor;
+		return 0;
+	}
+
+	return cursor;
+}
+
+bool 
+xml_designer_impl::_parse(byte_source& stream, byte_source* grammar, xml_stream_handler& handler, bool validate)
+{
+	if (!_load_grammar(grammar))
+		return false;
+
+	xml_processor pr(stream, _doc, _small_manager, _big_manager, _xml_size, validate, &handler);
+	bool ret = pr.parse();
+	if (!ret)
+		_error = pr.get_error();
+
+	// open elements are kept on the processor allocators
+	_doc.clear();
+	_doc.add_escaped_symbols();
+	return ret;
+}
+
+///////////////////////////////////////////////////////////
+xml_stream_cursor_impl::xml_stream_cursor_impl(mem_pool_t& small_pool, mem_pool_t& big_pool, size_t xml_size) :
+_small_pool(small_pool), _big_pool(big_pool), _xml_size(xml_size), _doc(small_pool, big_pool, xml_size, 0), 
+_stream(0), _processor(0), _done(false)
+{
+	_event_allocator = _small_pool.loan_object();
+}
+
+xml_stream_cursor_impl::~xml_stream_cursor_impl()
+{
+	// open elements are kept on the processor allocators
+	_doc.clear();
+
+	if (_processor)
+		delete _processor;
+
+	if (_stream)
+		delete _stream;
+
+	_events.clear();
+	_small_pool.return_object(_event_allocator);
+}
+
+bool 
+xml_stream_cursor_impl::open(byte_source* stream, byte_source* grammar, bool validate)
+{
+	_stream = stream;
+	if (!load_grammar(_doc, grammar, _small_pool, _big_pool, _error))
+		return false;
+
+	_processor = new xml_processor(*_stream, _doc, _small_pool, _big_pool, _xml_size, validate, this);
+	if (!_processor->start())
+	{
+		_error = _processor->get_error();
+		return false;
+	}
+
+	return true;
+}
+
+bool 
+xml_stream_cursor_impl::next()
+{
+	if (!_events.empty())
+		_events.pop_front();
+
+	// the events of the previous step are given out
+	while (_events.empty())
+	{
+		_events.clear();
+		_event_allocator->reset();
+
+		if (!_processor)
+			return false;
+
+		if (_done)
+		{
+			// the error is reported after the events preceding it
+			const char* err = _processor->get_error();
+			if (err && err[0])
+				_error = err;
+
 			return false;
 		}
+
+		if (!_processor->step())
+			_done = true;
 	}
 
 	return true;
 }
 
+xmlStreamEvent 
+xml_stream_cursor_impl::get_event() const
+{
+	return _events.empty() ? (xmlStreamEvent)0 : _events.front()._event;
+}
+
+const char* 
+xml_stream_cursor_impl::get_name() const
+{
+	return _events.empty() ? 0 : _events.front()._name;
+}
+
+const char* const* 
+xml_stream_cursor_impl::get_attributes() const
+{
+	return _events.empty() ? 0 : _events.front()._attributes;
+}
+
+const char* 
+xml_stream_cursor_impl::get_value() const
+{
+	return _events.empty() ? 0 : _events.front()._value;
+}
+
+bool 
+xml_stream_cursor_impl::is_cdata() const
+{
+	return _events.empty() ? false : _events.front()._cdata;
+}
+
+const char* 
+xml_stream_cursor_impl::error() const
+{
+	return _error;
+}
+
+bool 
+xml_stream_cursor_impl::start_element(const char* name, const char* const* attributes)
+{
+	_push(START_ELEMENT_EVENT, name, attributes, 0, false);
+	return true;
+}
+
+bool 
+xml_stream_cursor_impl::characters(const char* value, bool cdata)
+{
+	_push(CHARACTERS_EVENT, 0, 0, value, cdata);
+	return true;
+}
+
+bool 
+xml_stream_cursor_impl::end_element(const char* name)
+{
+	_push(END_ELEMENT_EVENT, name, 0, 0, false);
+	return true;
+}
+
+void 
+xml_stream_cursor_impl::_push(xmlStreamEvent event, const char* name, const char* const* attributes, const char* value, bool cdata)
+{
+	// handler gets names and values valid only during the call
+	xml_cursor_event ev;
+	ev._event = event;
+	ev._name = name ? copy_string(name, *_event_allocator) : 0;
+	ev._value = value ? copy_string(value, *_event_allocator) : 0;
+	ev._cdata = cdata;
+	ev._attributes = 0;
+
+	if (attributes)
+	{
+		size_t count = 0;
+		while (attributes[count])
+			++count;
+
+		const char** attrs = (const char**)check_pointer(_event_allocator->allocate((count + 1) * sizeof(const char*)));
+		for (size_t index = 0; index < count; ++index)
+			attrs[index] = copy_string(attributes[index], *_event_allocator);
+
+		attrs[count] = 0;
+		ev._attributes = attrs;
+	}
+
+	_events.push_back(*_event_allocator, ev);
+}
 
 ///////////////////////////////////////////////////////////
 xml_parser_creator::xml_parser_creator() 
@@ -38,6 +38,8 @@
 BEGIN_TERIMBER_NAMESPACE
 #pragma pack(4)
 
+class xml_processor;
+
 //! \class xml_designer_impl
 //! \brief implements abstract xml_designer interface
 class xml_designer_impl : public xml_designer
@@ -88,6 +90,38 @@ public:
 					const void* grammar,					//!< DTD memory buffer
 					size_t grammar_length					//!< DTD buffer length
 					);
+	//! \brief parses xml from file reporting elements and text to the handler
+	virtual 
+	bool 
+	parse(			const char* name,						//!< xml file name
+					const char* grammar,					//!< external DTD file
+					xml_stream_handler& handler,			//!< event handler
+					bool validate							//!< validation flag
+					);
+	//! \brief parses xml from memory reporting elements and text to the handler
+	virtual 
+	bool 
+	parse(			const void* buffer,						//!< xml memory buffer
+					size_t length,							//!< xml buffer length
+					const char* grammar,					//!< external DTD file
+					xml_stream_handler& handler,			//!< event handler
+					bool validate							//!< validation flag
+					);
+	//! \brief opens xml file for pulling parser events one by one
+	virtual 
+	xml_stream_cursor* 
+	open_cursor(	const char* name,						//!< xml file name
+					const char* grammar,					//!< external DTD file
+					bool validate							//!< validation flag
+					);
+	//! \brief opens xml memory buffer for pulling parser events one by one
+	virtual 
+	xml_stream_cursor* 
+	open_cursor(	const void* buffer,						//!< xml memory buffer
+					size_t length,							//!< xml buffer length
+					const char* grammar,					//!< external DTD file
+					bool validate							//!< validation flag
+					);
 	//! \brief returns the last error
 	virtual 
 	const char* 
@@ -280,6 +314,23 @@ private:
 	_load(			byte_source* stream,					//!< optional xml stream
 					byte_source* grammar					//!< optional DTD stream
 					);
+	//! \brief loads DTD from stream into the cleared document
+	bool 
+	_load_grammar(	byte_source* grammar					//!< optional DTD stream
+					);
+	//! \brief opens cursor over xml stream, destroys the stream on error
+	xml_stream_cursor* 
+	_open_cursor(	byte_source* stream,					//!< xml stream
+					const char* grammar,					//!< external DTD file
+					bool validate							//!< validation flag
+					);
+	//! \brief parses xml stream without building the document
+	bool 
+	_parse(			byte_source& stream,					//!< xml stream
+					byte_source* grammar,					//!< optional DTD stream
+					xml_stream_handler& handler,			//!< event handler
+					bool validate							//!< validation flag
+					);
 
 private:
 	size_t							_xml_size;				//!< xml size - just a tip
@@ -291,6 +342,115 @@ private:
 	mutable xml_tree_node*			_cur_node;				//!< selected node
 };
 
+//! \class xml_cursor_event
+//! \brief event queued by the streaming cursor
+class xml_cursor_event
+{
+public:
+	xmlStreamEvent			_event;							//!< event
+	const char*				_name;							//!< element name
+	const char* const*		_attributes;					//!< attribute name and value pairs
+	const char*				_value;							//!< text
+	bool					_cdata;							//!< CDATA flag
+};
+
+//! \typedef xml_cursor_event_list_t
+//! \brief list of queued events
+typedef _list< xml_cursor_event >	xml_cursor_event_list_t;
+
+//! \class xml_stream_cursor_impl
+//! \brief implements pull cursor over the streaming processor
+//! the processor parses one tag and the content following it by step,
+//! the events of the step are queued and given out one by one
+class xml_stream_cursor_impl : public xml_stream_cursor, 
+								public xml_stream_handler
+{
+public:
+	//! \brief constructor
+	xml_stream_cursor_impl(mem_pool_t& small_pool,			//!< small memory pool
+					mem_pool_t& big_pool,					//!< big memory pool
+					size_t xml_size							//!< xml size - just a tip
+					);
+	//! \brief destructor
+	virtual 
+	~xml_stream_cursor_impl();
+	//! \brief takes the xml stream, loads grammar and parses prolog
+	bool 
+	open(			byte_source* stream,					//!< xml stream, the cursor destroys it
+					byte_source* grammar,					//!< optional DTD stream
+					bool validate							//!< validation flag
+					);
+	//! \brief moves to the next event
+	virtual 
+	bool 
+	next();
+	//! \brief returns the current event
+	virtual 
+	xmlStreamEvent 
+	get_event() const;
+	//! \brief returns element name
+	virtual 
+	const char* 
+	get_name() const;
+	//! \brief returns attribute name and value pairs
+	virtual 
+	const char* const* 
+	get_attributes() const;
+	//! \brief returns text
+	virtual 
+	const char* 
+	get_value() const;
+	//! \brief checks CDATA flag
+	virtual 
+	bool 
+	is_cdata() const;
+	//! \brief returns the last error
+	virtual 
+	const char* 
+	error() const;
+
+protected:
+	//! \brief queues start element event
+	virtual 
+	bool 
+	start_element(	const char* name,						//!< element name
+					const char* const* attributes			//!< attribute name and value pairs
+					);
+	//! \brief queues characters event
+	virtual 
+	bool 
+	characters(		const char* value,						//!< text
+					bool cdata								//!< CDATA flag
+					);
+	//! \brief queues end element event
+	virtual 
+	bool 
+	end_element(	const char* name						//!< element name
+					);
+
+private:
+	//! \brief queues event
+	void 
+	_push(			xmlStreamEvent event,					//!< event
+					const char* name,						//!< element name
+					const char* const* attributes,			//!< attribute pairs
+					const char* value,						//!< text
+					bool cdata								//!< CDATA flag
+					);
+
+private:
+	mem_pool_t&					_small_pool;				//!< small memory pool
+	mem_pool_t&					_big_pool;					//!< big memory pool
+	size_t						_xml_size;					//!< xml size - just a tip
+	xml_document				_doc;						//!< document keeps grammar and open elements
+	byte_source*				_stream;					//!< xml stream
+	xml_processor*				_processor;					//!< streaming processor
+	byte_allocator*				_event_allocator;			//!< allocator for queued events
+	xml_cursor_event_list_t		_events;					//!< queued events, the current one is the first
+	bool						_done;						//!< document is parsed to the end
+	string_t					_error;						//!< last error
+};
+
 //! \class xml_parser_creator
 //! \brief class creator for xml designer
 class xml_parser_creator : public proto_creator< xml_parser_creator, xml_designer, size_t >
@@ -204,38 +204,42 @@ content_mixed::validate(const xml_element& el)
 		if (iterElement->_decl->get_type() != ELEMENT_NODE)
 			continue; // something which is not element
 
-		const elementDecl* decl = xml_element::cast_to_element(iterElement)->cast_decl();
-		bool find = false;
-		
-		for (_list< const dfa_token* >::const_iterator iterToken = _listToken.begin(); iterToken != _listToken.end(); ++iterToken)
-		{
-			if ((*iterToken)->_rule == DFA_LEAF)
-			{
-				if (!(*iterToken)->_decl) // PCDATA
-					continue;
+		next_state(el, 0, xml_element::cast_to_element(iterElement)->cast_decl());
+	} // for
+}
 
-				if ((*iterToken)->_decl == decl)
-				{
-					find = true;
-					break;
-				}
-			}
-			else
-			{
-				// DFA_ANY:
-				assert(false);
-			}
-		} // for
+size_t
+content_mixed::next_state(const xml_element& el, size_t state, const elementDecl* decl)
+{
+	for (_list< const dfa_token* >::const_iterator iterToken = _listToken.begin(); iterToken != _listToken.end(); ++iterToken)
+	{
+		if ((*iterToken)->_rule == DFA_LEAF)
+		{
+			if (!(*iterToken)->_decl) // PCDATA
+				continue;
 
-		if (!find)
+			if ((*iterToken)->_decl == decl)
+				return state;
+		}
+		else
 		{
-			string_t ex = "Unknown element found: ";
-			ex += decl->_name;
-			ex += " beneath parent element: ";
-			ex += el._decl->_name;
-			exception::_throw(ex);
+			// DFA_ANY:
+			assert(false);
 		}
 	} // for
+
+	string_t ex = "Unknown element found: ";
+	ex += decl->_name;
+	ex += " beneath parent element: ";
+	ex += el._decl->_name;
+	exception::_throw(ex);
+	return state;
+}
+
+void
+content_mixed::check_state(const xml_element&, size_t, bool)
+{
+	// mixed content has no order
 }
 
 /////////////////////////////////////////
@@ -711,79 +715,86 @@ content_children::build_dfa(const dfa_token* parent)
 void
 content_children::validate(const xml_element& el)
 {
-  //
-    //  If there are no children, then either we fail on the 0th element
-    //  or we return success. It depends upon whether this content model
-    //  accepts empty content, which we determined earlier.
-    //
-	if (!el.has_children())
-    {
-        // success os_minus_one
-        if (!_emptyOk)
-		{
-			string_t ex = "Parent element: ";
-			ex += el._decl->_name;
-			ex += " must contain child elements";
-			exception::_throw(ex);
-		}
-
-		return;
-    }
-
     //
     //  Lets loop through the children in the array and move our way
     //  through the states. Note that we use the _elemMap array to map
     //  an element index to a state index.
     //
     size_t curState = 0;
-    size_t nextState = 0;
 	// look for children
 	for (const xml_tree_node* iterElement = el._first_child; iterElement; iterElement = iterElement->_right)
 	{
 		if (iterElement->_decl->get_type() != ELEMENT_NODE)
 			continue; // something that is not element
 	
-		// Gets the current element index out
-		const elementDecl* curDecl = xml_element::cast_to_element(iterElement)->cast_decl();
+		curState = next_state(el, curState, xml_element::cast_to_element(iterElement)->cast_decl());
+	}
 
-		if (curDecl->_content == CONTENT_ANY)
-			continue;
-	
-		// Looks up this child in our element map
-		size_t elemIndex = 0;
-        for (; elemIndex < _elemMapSize; ++elemIndex)
-        {
-            const elementDecl* inElem  = _elemMap[elemIndex];
-			if (inElem == curDecl)
-			{
-				nextState = _transTable[curState][elemIndex];
-				if (nextState != os_minus_one)
-					break;
-            }
-        }//for elemIndex
-
-        // If "nextState" is os_minus_one, we have found a match, but the transition is invalid
-        if (nextState == os_minus_one)
+	check_state(el, curState, el.has_children());
+}
+
+size_t
+content_children::next_state(const xml_element& el, size_t state, const elementDecl* decl)
+{
+	if (decl->_content == CONTENT_ANY)
+		return state;
+
+	size_t nextState = 0;
+	// Looks up this child in our element map
+	size_t elemIndex = 0;
+	for (; elemIndex < _elemMapSize; ++elemIndex)
+	{
+		const elementDecl* inElem  = _elemMap[elemIndex];
+		if (inElem == decl)
 		{
-			string_t ex("Invalid child element order: ");
-			ex += curDecl->_name;
-			ex += " beneath parent element: ";
-			ex += el._decl->_name;
-			exception::_throw(ex);
+			nextState = _transTable[state][elemIndex];
+			if (nextState != os_minus_one)
+				break;
 		}
+	}//for elemIndex
+
+	// If "nextState" is os_minus_one, we have found a match, but the transition is invalid
+	if (nextState == os_minus_one)
+	{
+		string_t ex("Invalid child element order: ");
+		ex += decl->_name;
+		ex += " beneath parent element: ";
+		ex += el._decl->_name;
+		exception::_throw(ex);
+	}
 
-        // If we didn't find it, then obviously not valid
-		if (elemIndex == _elemMapSize)
+	// If we didn't find it, then obviously not valid
+	if (elemIndex == _elemMapSize)
+	{
+		string_t ex("Unexpected child element: ");
+		ex += decl->_name;
+		ex += " beneath parent element: ";
+		ex += el._decl->_name;
+		exception::_throw(ex);
+	}
+
+	return nextState;
+}
+
+void
+content_children::check_state(const xml_element& el, size_t state, bool has_children)
+{
+    //
+    //  If there are no children, then either we fail on the 0th element
+    //  or we return success. It depends upon whether this content model
+    //  accepts empty content, which we determined earlier.
+    //
+	if (!has_children)
+    {
+        if (!_emptyOk)
 		{
-			string_t ex("Unexpected child element: ");
-			ex += curDecl->_name;
-			ex += " beneath parent element: ";
+			string_t ex = "Parent element: ";
 			ex += el._decl->_name;
+			ex += " must contain child elements";
 			exception::_throw(ex);
 		}
 
-        curState = nextState;
-        nextState = 0;
+		return;
     }
 
     //
@@ -791,7 +802,7 @@ content_children::validate(const xml_element& el)
     //  does not mean that we ended in a final state. So check whether
     //  our ending state is a final state.
     //
-    if (!_finalStateFlags[curState])
+    if (!_finalStateFlags[state])
 	{
 		string_t ex("Expected more child elements beneath parent element: ");
 		ex += el._decl->_name;
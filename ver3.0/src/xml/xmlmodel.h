@@ -247,6 +247,21 @@ public:
 	void 
 	validate(		const xml_element& _el					//!< xml element
 					) = 0;
+	//! \brief moves the validation state by one child element
+	//! the streaming parser validates children as they come
+	virtual 
+	size_t 
+	next_state(		const xml_element& el,					//!< parent element
+					size_t state,							//!< current state, zero before the first child
+					const elementDecl* decl					//!< child element declaration
+					) = 0;
+	//! \brief checks the validation state after the last child
+	virtual 
+	void 
+	check_state(	const xml_element& el,					//!< parent element
+					size_t state,							//!< state after the last child
+					bool has_children						//!< flag if the parent has any child nodes
+					) = 0;
 };
 
 //! \class content_mixed
@@ -263,6 +278,20 @@ public:
 	void 
 	validate(		const xml_element& _el					//!< xml element
 					);
+	//! \brief checks the child element is allowed
+	virtual 
+	size_t 
+	next_state(		const xml_element& el,					//!< parent element
+					size_t state,							//!< current state
+					const elementDecl* decl					//!< child element declaration
+					);
+	//! \brief nothing to check, mixed content has no order
+	virtual 
+	void 
+	check_state(	const xml_element& el,					//!< parent element
+					size_t state,							//!< state after the last child
+					bool has_children						//!< flag if the parent has any child nodes
+					);
 private:
 	//! \brief builds mixed list
 	void 
@@ -299,6 +328,20 @@ public:
 	void 
 	validate(		const xml_element& el					//!< xml element
 					);
+	//! \brief moves DFA to the next state by the child element
+	virtual 
+	size_t 
+	next_state(		const xml_element& el,					//!< parent element
+					size_t state,							//!< current DFA state
+					const elementDecl* decl					//!< child element declaration
+					);
+	//! \brief checks if DFA ended in the final state
+	virtual 
+	void 
+	check_state(	const xml_element& el,					//!< parent element
+					size_t state,							//!< DFA state after the last child
+					bool has_children						//!< flag if the parent has any child nodes
+					);
 
 private:
 	//! \brief builds children tree
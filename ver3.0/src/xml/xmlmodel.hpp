@@ -143,7 +143,7 @@ content_children::make_def_state_list(_vector< size_t >& x) const
 {
 	x.resize(_tmp_allocator, _elemMapSize);
 	for (size_t index = 0; index < _elemMapSize; ++index)
-		x[index] = 0xffffffff;
+		x[index] = os_minus_one;
 }
 
 #pragma pack()
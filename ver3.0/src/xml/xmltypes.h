@@ -44,6 +44,15 @@ enum xmlNodeType
 	NOTATION_NODE = 12										//!< hidden, notation
 };
 
+//! \enum xmlStreamEvent
+//! \brief events of streaming parser
+enum xmlStreamEvent
+{
+	START_ELEMENT_EVENT = 1,								//!< element is opened
+	CHARACTERS_EVENT = 2,									//!< text or CDATA
+	END_ELEMENT_EVENT = 3									//!< element is closed
+};
+
 #endif // _terimber_xmltypes_h_ 
 
 
@@ -107,6 +107,14 @@ SOURCE=..\..\src\db\dbaccess.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\db\dbpool.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\db\dbpool.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\db\dbtypes.h
 # End Source File
 # End Group
@@ -99,6 +99,14 @@ SOURCE=..\..\src\memdb\memlookup.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\memdb\memscan.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\tools\mapfile.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\memdb\memtable.cpp
 # End Source File
 # End Group
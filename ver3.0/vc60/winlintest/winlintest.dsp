@@ -51,7 +51,7 @@ BSC32=bscmake.exe
 # ADD BSC32 /nologo /o"..\..\obj_vc6\release/winlintest.bsc"
 LINK32=link.exe
 # ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:console /machine:I386
-# ADD LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib ws2_32.lib base.lib aiosock.lib aiocomport.lib aiogate.lib threadpool.lib aiofile.lib mysqlclient.lib oci.lib rpcrt4.lib /nologo /subsystem:console /pdb:none /machine:I386 /libpath:"..\..\output_vc6\release" /libpath:"../../lib/orcllib" /libpath:"../../lib/mysqllib" /libpath:"../../lib/pcre"
+# ADD LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib ws2_32.lib base.lib aiosock.lib aiocomport.lib aiogate.lib threadpool.lib aiofile.lib memdb.lib mysqlclient.lib oci.lib rpcrt4.lib /nologo /subsystem:console /pdb:none /machine:I386 /libpath:"..\..\output_vc6\release" /libpath:"../../lib/orcllib" /libpath:"../../lib/mysqllib" /libpath:"../../lib/pcre"
 # SUBTRACT LINK32 /map /debug
 
 !ELSEIF  "$(CFG)" == "winlintest - Win32 Debug"
@@ -77,7 +77,7 @@ BSC32=bscmake.exe
 # ADD BSC32 /nologo /o"..\..\obj_vc6\debug/winlintest.bsc"
 LINK32=link.exe
 # ADD BASE LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib /nologo /subsystem:console /debug /machine:I386 /pdbtype:sept
-# ADD LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib ws2_32.lib base.lib aiosock.lib aiocomport.lib aiogate.lib threadpool.lib aiofile.lib mysqlclient.lib oci.lib rpcrt4.lib /nologo /subsystem:console /incremental:no /pdb:"..\..\obj_vc6\debug/winlintest.pdb" /map /debug /machine:I386 /libpath:"..\..\output_vc6\debug" /libpath:"../../lib/orcllib" /libpath:"../../lib/mysqllib" /libpath:"../../lib/pcre"
+# ADD LINK32 kernel32.lib user32.lib gdi32.lib winspool.lib comdlg32.lib advapi32.lib shell32.lib ole32.lib oleaut32.lib uuid.lib odbc32.lib odbccp32.lib ws2_32.lib base.lib aiosock.lib aiocomport.lib aiogate.lib threadpool.lib aiofile.lib memdb.lib mysqlclient.lib oci.lib rpcrt4.lib /nologo /subsystem:console /incremental:no /pdb:"..\..\obj_vc6\debug/winlintest.pdb" /map /debug /machine:I386 /libpath:"..\..\output_vc6\debug" /libpath:"../../lib/orcllib" /libpath:"../../lib/mysqllib" /libpath:"../../lib/pcre"
 # SUBTRACT LINK32 /profile /pdb:none
 
 !ENDIF 
@@ -137,6 +137,18 @@ SOURCE=..\..\src\winlintest\stargate_ut.cpp
 
 SOURCE=..\..\src\winlintest\threadpool_ut.cpp
 # End Source File
+# Begin Source File
+
+SOURCE=..\..\src\winlintest\memdb_ut.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\winlintest\db_ut.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\winlintest\xml_ut.cpp
+# End Source File
 # End Group
 # Begin Group "Header Files"
 
@@ -147,6 +159,10 @@ SOURCE=..\..\src\winlintest\crypt_ut.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\winlintest\dbstub_ut.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\winlintest\keymaker_ut.h
 # End Source File
 # Begin Source File
@@ -165,6 +181,18 @@ SOURCE=..\..\src\winlintest\stargate_ut.h
 
 SOURCE=..\..\src\winlintest\threadpool_ut.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\..\src\winlintest\memdb_ut.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\winlintest\db_ut.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\..\src\winlintest\xml_ut.h
+# End Source File
 # End Group
 # Begin Group "Resource Files"
 